@@ -0,0 +1,89 @@
+#include "AllocationCounter.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace {
+	// These are deliberately relaxed; we only need the totals, not an ordering between threads
+	std::atomic<uint64_t> gAllocations{ 0 };
+	std::atomic<uint64_t> gBytes{ 0 };
+
+	inline void recordAllocation(size_t size) {
+		gAllocations.fetch_add(1, std::memory_order_relaxed);
+		gBytes.fetch_add(size, std::memory_order_relaxed);
+	}
+}
+
+AllocationSnapshot allocationSnapshot() {
+	return AllocationSnapshot{
+		gAllocations.load(std::memory_order_relaxed),
+		gBytes.load(std::memory_order_relaxed)
+	};
+}
+
+
+#if defined(__GLIBC__)
+
+// Interpose the C allocation functions; operator new calls malloc so it is also counted here
+extern "C" {
+	void* __libc_malloc(size_t size);
+	void* __libc_calloc(size_t count, size_t size);
+	void* __libc_realloc(void* ptr, size_t size);
+
+	void* malloc(size_t size) noexcept {
+		recordAllocation(size);
+		return __libc_malloc(size);
+	}
+
+	void* calloc(size_t count, size_t size) noexcept {
+		recordAllocation(count * size);
+		return __libc_calloc(count, size);
+	}
+
+	void* realloc(void* ptr, size_t size) noexcept {
+		recordAllocation(size);
+		return __libc_realloc(ptr, size);
+	}
+}
+
+bool countsMallocAllocations() {
+	return true;
+}
+
+#else
+
+void* operator new(size_t size) {
+	recordAllocation(size);
+	if (void* ptr = std::malloc(size ? size : 1)) {
+		return ptr;
+	}
+	throw std::bad_alloc{};
+}
+
+void* operator new[](size_t size) {
+	return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept {
+	std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+	std::free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+	std::free(ptr);
+}
+
+bool countsMallocAllocations() {
+	return false;
+}
+
+#endif
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+* Process-wide counters of heap allocations, used to report the bytes allocated per scenario
+*
+* On glibc every call to malloc/calloc/realloc is counted (this includes Eigen's allocations)
+* On other platforms only allocations made through operator new are counted
+*/
+struct AllocationSnapshot {
+	uint64_t allocations;
+	uint64_t bytes;
+};
+
+AllocationSnapshot allocationSnapshot();
+
+// Whether the counters see allocations made with malloc (and therefore by Eigen)
+bool countsMallocAllocations();
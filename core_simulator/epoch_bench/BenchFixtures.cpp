@@ -0,0 +1,275 @@
+#include "BenchFixtures.hpp"
+
+#include <map>
+#include <stdexcept>
+
+#include <Eigen/Core>
+#include <nlohmann/json.hpp>
+
+#include "../epoch_lib/io/FileHandling.hpp"
+#include "../epoch_lib/io/SiteDataJson.hpp"
+
+namespace {
+
+	// The number of timesteps in each resolution over the (one year) Mount Hotel site
+	Eigen::Index timestepsFor(SiteResolution resolution) {
+		switch (resolution) {
+		case SiteResolution::Hourly:
+			return 8760;
+		case SiteResolution::HalfHourly:
+			return 17520;
+		case SiteResolution::FiveMinute:
+			return 105120;
+		}
+		throw std::invalid_argument("Unknown SiteResolution");
+	}
+
+	/**
+	* Resample a timeseries to n timesteps (n must be a whole multiple or divisor of the current length)
+	*
+	* extensive quantities (kWh per timestep) are summed or divided between timesteps
+	* intensive quantities (prices, temperatures, intensities) are averaged or repeated
+	*/
+	year_TS resample(year_TS_view source, Eigen::Index n, bool extensive) {
+		year_TS result(n);
+
+		if (n <= source.size()) {
+			Eigen::Index ratio = source.size() / n;
+			for (Eigen::Index t = 0; t < n; t++) {
+				auto segment = source.segment(t * ratio, ratio);
+				result[t] = extensive ? segment.sum() : segment.mean();
+			}
+		}
+		else {
+			Eigen::Index ratio = n / source.size();
+			float scale = extensive ? 1.0f / static_cast<float>(ratio) : 1.0f;
+			for (Eigen::Index t = 0; t < n; t++) {
+				result[t] = source[t / ratio] * scale;
+			}
+		}
+		return result;
+	}
+
+	SiteData resampleSiteData(const SiteData& source, Eigen::Index n) {
+		std::vector<SiteSeries> solarYields;
+		for (const auto& yield : source.solar_yields) {
+			solarYields.push_back(resample(yield, n, true));
+		}
+
+		std::vector<SiteSeries> importTariffs;
+		for (const auto& tariff : source.import_tariffs) {
+			importTariffs.push_back(resample(tariff, n, false));
+		}
+
+		std::vector<FabricIntervention> fabricInterventions = source.fabric_interventions;
+		for (auto& fi : fabricInterventions) {
+			fi.reduced_hload = resample(fi.reduced_hload, n, true);
+		}
+
+		return SiteData(
+			source.start_ts,
+			source.end_ts,
+			source.baseline,
+			resample(source.building_eload, n, true),
+			resample(source.building_hload, n, true),
+			source.peak_hload,
+			resample(source.ev_eload, n, true),
+			resample(source.dhw_demand, n, true),
+			resample(source.air_temperature, n, false),
+			resample(source.grid_co2, n, false),
+			std::move(solarYields),
+			std::move(importTariffs),
+			std::move(fabricInterventions),
+			source.ashp_input_table,
+			source.ashp_output_table
+		);
+	}
+
+	/**
+	* Stretch (or shrink) a timeseries to any length n, taking the nearest earlier timestep for each new timestep
+	* extensive quantities are scaled by the change in the length of a timestep
+	*/
+	year_TS stretch(year_TS_view source, Eigen::Index n, bool extensive) {
+		year_TS result(n);
+		const float scale = extensive ? static_cast<float>(source.size()) / static_cast<float>(n) : 1.0f;
+		for (Eigen::Index t = 0; t < n; t++) {
+			result[t] = source[t * source.size() / n] * scale;
+		}
+		return result;
+	}
+
+	std::vector<ScenarioMix> makeScenarioMixes() {
+		const std::filesystem::path dir = benchDataDir();
+		const TaskData empty = readTaskData(dir / "taskData_empty.json");
+		const TaskData common = readTaskData(dir / "taskData_common.json");
+		const TaskData full = readTaskData(dir / "taskData_full.json");
+
+		std::vector<ScenarioMix> mixes;
+		mixes.push_back({ "empty", empty });
+
+		// common contains a Building, Grid, Solar, ESS (in CONSUME mode) and DHW + ambient ASHP
+		mixes.push_back({ "ess_consume", common });
+
+		TaskData consumePlus = common;
+		consumePlus.energy_storage_system->battery_mode = BatteryMode::CONSUME_PLUS;
+		mixes.push_back({ "ess_consume_plus", consumePlus });
+
+		TaskData dhwASHP = common;
+		dhwASHP.energy_storage_system.reset();
+		mixes.push_back({ "dhw_ashp", dhwASHP });
+
+		TaskData evBalancing = common;
+		evBalancing.electric_vehicles = ElectricVehicles{};
+		evBalancing.electric_vehicles->flexible_load_ratio = 0.5f;
+		mixes.push_back({ "ev_balancing", evBalancing });
+
+		TaskData hotroom = full;
+		hotroom.heat_pump->heat_source = HeatSource::HOTROOM;
+		mixes.push_back({ "hotroom_data_centre", hotroom });
+
+		mixes.push_back({ "full", full });
+
+		return mixes;
+	}
+}
+
+
+SiteData makeSyntheticSiteData(const SyntheticSite& shape) {
+	if (shape.timesteps < 1 || shape.solarArrays < 1 || shape.tariffs < 1) {
+		throw std::invalid_argument("A synthetic site needs at least one timestep, solar array and tariff");
+	}
+
+	const SiteData& source = *getSiteData(SiteResolution::HalfHourly);
+	const Eigen::Index n = shape.timesteps;
+	auto demand = [&](const SiteSeries& series) -> SiteSeries {
+		return stretch(series, n, true) * shape.demandScale;
+	};
+
+	// each copy differs a little from the last, so none of them are stored (or cached) as the same column
+	std::vector<SiteSeries> solarYields;
+	for (size_t i = 0; i < shape.solarArrays; i++) {
+		const float scale = 1.0f - 0.01f * static_cast<float>(i % 50);
+		solarYields.push_back(stretch(source.solar_yields[i % source.solar_yields.size()], n, true) * scale);
+	}
+
+	std::vector<SiteSeries> importTariffs;
+	for (size_t i = 0; i < shape.tariffs; i++) {
+		const float scale = 1.0f + 0.05f * static_cast<float>(i);
+		importTariffs.push_back(stretch(source.import_tariffs[i % source.import_tariffs.size()], n, false) * scale);
+	}
+
+	std::vector<FabricIntervention> fabricInterventions;
+	for (size_t i = 0; i < shape.fabricInterventions; i++) {
+		// deeper (and more expensive) retrofits reduce the heating demand further
+		const float reduction = 1.0f - 0.5f * static_cast<float>(i + 1) / static_cast<float>(shape.fabricInterventions + 1);
+		fabricInterventions.push_back(FabricIntervention{
+			.cost = 5000.0f * static_cast<float>(i + 1),
+			.cost_breakdown = {},
+			.peak_hload = source.peak_hload * reduction,
+			.reduced_hload = demand(source.building_hload) * reduction,
+			.hload_delta = std::nullopt
+		});
+	}
+
+	return SiteData(
+		source.start_ts,
+		source.end_ts,
+		source.baseline,
+		demand(source.building_eload),
+		demand(source.building_hload),
+		source.peak_hload * shape.demandScale,
+		demand(source.ev_eload),
+		demand(source.dhw_demand),
+		stretch(source.air_temperature, n, false),
+		stretch(source.grid_co2, n, false),
+		std::move(solarYields),
+		std::move(importTariffs),
+		std::move(fabricInterventions),
+		source.ashp_input_table,
+		source.ashp_output_table
+	);
+}
+
+std::filesystem::path benchDataDir() {
+	return std::filesystem::path{ EPOCH_BENCH_DATA_DIR };
+}
+
+const std::vector<SiteResolution>& allResolutions() {
+	static const std::vector<SiteResolution> resolutions{
+		SiteResolution::Hourly, SiteResolution::HalfHourly, SiteResolution::FiveMinute
+	};
+	return resolutions;
+}
+
+std::string resolutionName(SiteResolution resolution) {
+	switch (resolution) {
+	case SiteResolution::Hourly:
+		return "hourly";
+	case SiteResolution::HalfHourly:
+		return "half_hourly";
+	case SiteResolution::FiveMinute:
+		return "five_minute";
+	}
+	throw std::invalid_argument("Unknown SiteResolution");
+}
+
+std::shared_ptr<const SiteData> getSiteData(SiteResolution resolution) {
+	// benchmarks are registered and run from a single thread, so these caches do not need a lock
+	static std::map<SiteResolution, std::shared_ptr<const SiteData>> cache;
+
+	auto it = cache.find(resolution);
+	if (it != cache.end()) {
+		return it->second;
+	}
+
+	std::shared_ptr<const SiteData> siteData;
+	if (resolution == SiteResolution::HalfHourly) {
+		siteData = std::make_shared<const SiteData>(readSiteData(benchDataDir() / "siteData_MountHotel.json"));
+	}
+	else {
+		auto halfHourly = getSiteData(SiteResolution::HalfHourly);
+		siteData = std::make_shared<const SiteData>(resampleSiteData(*halfHourly, timestepsFor(resolution)));
+	}
+
+	cache.emplace(resolution, siteData);
+	return siteData;
+}
+
+const Simulator& getSimulator(SiteResolution resolution) {
+	static std::map<SiteResolution, std::unique_ptr<Simulator>> cache;
+
+	auto& simulator = cache[resolution];
+	if (!simulator) {
+		simulator = std::make_unique<Simulator>(getSiteData(resolution), TaskConfig{});
+	}
+	return *simulator;
+}
+
+std::filesystem::path getSiteDataFile(SiteResolution resolution) {
+	if (resolution == SiteResolution::HalfHourly) {
+		return benchDataDir() / "siteData_MountHotel.json";
+	}
+
+	// (re)write the file once per run so that it always matches the current resampling and serialisation
+	static std::map<SiteResolution, std::filesystem::path> written;
+
+	auto it = written.find(resolution);
+	if (it != written.end()) {
+		return it->second;
+	}
+
+	std::filesystem::path dir = std::filesystem::temp_directory_path() / "epoch_bench";
+	std::filesystem::create_directories(dir);
+	std::filesystem::path file = dir / ("siteData_" + resolutionName(resolution) + ".json");
+
+	nlohmann::json j = *getSiteData(resolution);
+	writeJsonToFile(j, file);
+
+	written.emplace(resolution, file);
+	return file;
+}
+
+const std::vector<ScenarioMix>& allScenarioMixes() {
+	static const std::vector<ScenarioMix> mixes = makeScenarioMixes();
+	return mixes;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../epoch_lib/Simulation/Simulate.hpp"
+#include "../epoch_lib/Simulation/SiteData.hpp"
+#include "../epoch_lib/Simulation/TaskData.hpp"
+
+/**
+* The SiteData shapes we benchmark against
+* These are all derived from the (half-hourly) Mount Hotel test site
+*/
+enum class SiteResolution { Hourly, HalfHourly, FiveMinute };
+
+const std::vector<SiteResolution>& allResolutions();
+std::string resolutionName(SiteResolution resolution);
+
+/**
+* Get the SiteData for the given resolution
+* These are built once and then shared by every benchmark
+*/
+std::shared_ptr<const SiteData> getSiteData(SiteResolution resolution);
+
+/**
+* Get a Simulator (with a default TaskConfig) for the given resolution
+*/
+const Simulator& getSimulator(SiteResolution resolution);
+
+/**
+* Get the path to a SiteData json file for the given resolution
+* The hourly and 5-minute sites are written to a temporary directory the first time they are requested
+*/
+std::filesystem::path getSiteDataFile(SiteResolution resolution);
+
+
+/**
+* The shape of a synthetic site, for the scaling benchmarks
+*/
+struct SyntheticSite {
+	// the timesteps over the (one year) site, which need not divide the year into whole hours
+	Eigen::Index timesteps = 17520;
+	size_t solarArrays = 1;
+	size_t tariffs = 1;
+	size_t fabricInterventions = 0;
+	// scales the demands, so that the sites of a portfolio differ
+	float demandScale = 1.0f;
+};
+
+/**
+* Build a SiteData of any shape from the Mount Hotel site
+*
+* Each series is stretched to the requested length, and the solar yields, tariffs and fabric interventions
+* are varied copies of the site's own, so the result is always valid for SiteData::validate_site_data
+*/
+SiteData makeSyntheticSiteData(const SyntheticSite& shape);
+
+
+// A named TaskData representing a typical mix of components
+struct ScenarioMix {
+	std::string name;
+	TaskData taskData;
+};
+
+/**
+* The component mixes we benchmark, covering each of the balancing loop variants
+*/
+const std::vector<ScenarioMix>& allScenarioMixes();
+
+// The directory containing the test SiteData and TaskData files
+std::filesystem::path benchDataDir();
@@ -0,0 +1,8 @@
+#pragma once
+
+// Each benchmark file registers its benchmarks for every SiteResolution and ScenarioMix
+
+void registerScalingBenchmarks();
+void registerSimulateBenchmarks();
+void registerSiteDataBenchmarks();
+void registerTimeSeriesBenchmarks();
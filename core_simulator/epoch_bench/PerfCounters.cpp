@@ -0,0 +1,109 @@
+#include "PerfCounters.hpp"
+
+#if defined(EPOCH_BENCH_PERF_COUNTERS)
+
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <format>
+
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+	struct Counter {
+		uint32_t type;
+		uint64_t config;
+		const char* name;
+	};
+
+	// in the order of the fields of PerfCounterSnapshot
+	constexpr std::array<Counter, 4> COUNTERS = { {
+		{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, "instructions" },
+		{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, "cycles" },
+		{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES, "branch-misses" },
+		{ PERF_TYPE_HW_CACHE,
+			PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16), "LLC-misses" },
+	} };
+
+	std::array<int, COUNTERS.size()> gFds = { -1, -1, -1, -1 };
+	std::string gStatus = "not started";
+
+	int openCounter(const Counter& counter) {
+		perf_event_attr attr{};
+		attr.size = sizeof(attr);
+		attr.type = counter.type;
+		attr.config = counter.config;
+		// the threads that are started later (such as the thread pool's workers) are counted too
+		attr.inherit = 1;
+		// user space only, which is permitted at the default perf_event_paranoid level
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		// the counters may be multiplexed onto fewer hardware counters, so read how long each actually ran
+		attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+		return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+	}
+
+	void closeCounters() {
+		for (int& fd : gFds) {
+			if (fd >= 0) {
+				close(fd);
+				fd = -1;
+			}
+		}
+	}
+
+	bool readCounter(int fd, uint64_t& value) {
+		// value, time enabled, time running
+		uint64_t data[3] = {};
+		if (read(fd, data, sizeof(data)) != static_cast<ssize_t>(sizeof(data))) {
+			return false;
+		}
+		value = data[2] > 0 && data[2] < data[1]
+			? static_cast<uint64_t>(static_cast<double>(data[0]) * static_cast<double>(data[1]) / static_cast<double>(data[2]))
+			: data[0];
+		return true;
+	}
+}
+
+void startPerfCounters() {
+	closeCounters();
+	for (size_t i = 0; i < COUNTERS.size(); i++) {
+		gFds[i] = openCounter(COUNTERS[i]);
+		if (gFds[i] < 0) {
+			gStatus = std::format("unavailable ({}: {})", COUNTERS[i].name, std::strerror(errno));
+			closeCounters();
+			return;
+		}
+	}
+	gStatus = "enabled";
+}
+
+std::optional<PerfCounterSnapshot> perfCounterSnapshot() {
+	std::array<uint64_t, COUNTERS.size()> values{};
+	for (size_t i = 0; i < COUNTERS.size(); i++) {
+		if (gFds[i] < 0 || !readCounter(gFds[i], values[i])) {
+			return std::nullopt;
+		}
+	}
+	return PerfCounterSnapshot{ values[0], values[1], values[2], values[3] };
+}
+
+std::string perfCounterStatus() {
+	return gStatus;
+}
+
+#else
+
+void startPerfCounters() {}
+
+std::optional<PerfCounterSnapshot> perfCounterSnapshot() {
+	return std::nullopt;
+}
+
+std::string perfCounterStatus() {
+	return "unavailable (not built with EPOCH_BENCH_PERF_COUNTERS)";
+}
+
+#endif
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+
+/**
+* Process-wide hardware performance counters, used to report IPC and misses per timestep
+*
+* These are read through perf_event on Linux; elsewhere (or when perf_event is not permitted) there are no counters.
+* Like the AllocationCounter these count the whole process, so a benchmark's counts are the difference between two snapshots.
+*/
+struct PerfCounterSnapshot {
+	uint64_t instructions;
+	uint64_t cycles;
+	uint64_t branch_misses;
+	// last-level cache misses
+	uint64_t llc_misses;
+};
+
+/**
+* Open the counters for this process
+* This must be called before any other thread is started, as only the threads created afterwards are counted
+*/
+void startPerfCounters();
+
+// nullopt when the counters are unavailable
+std::optional<PerfCounterSnapshot> perfCounterSnapshot();
+
+// "enabled", or why the counters are unavailable
+std::string perfCounterStatus();
@@ -0,0 +1,157 @@
+#include "ScalingReport.hpp"
+
+#include <algorithm>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <utility>
+
+#include <nlohmann/json.hpp>
+
+namespace {
+	std::ofstream openForWriting(const std::filesystem::path& path) {
+		std::ofstream out(path, std::ios::trunc);
+		if (!out.is_open()) {
+			throw std::runtime_error(std::format("Could not write the scaling curves to {}", path.string()));
+		}
+		return out;
+	}
+}
+
+std::vector<ScalingPoint> buildScalingCurves(const std::vector<ScalingPoint>& points) {
+	std::vector<std::string> axes;
+	// each point with the sum of the rates of its repetitions, and how many there were
+	std::map<std::pair<std::string, double>, std::pair<ScalingPoint, int>> merged;
+
+	for (const ScalingPoint& point : points) {
+		if (std::find(axes.begin(), axes.end(), point.axis) == axes.end()) {
+			axes.push_back(point.axis);
+		}
+		auto [it, inserted] = merged.try_emplace({ point.axis, point.x }, point, 1);
+		if (!inserted) {
+			it->second.first.rate += point.rate;
+			it->second.second++;
+		}
+	}
+
+	std::vector<ScalingPoint> curves;
+	for (const std::string& axis : axes) {
+		const size_t first = curves.size();
+		// the map is ordered by (axis, x), so each curve is already sorted by x
+		for (auto& [key, entry] : merged) {
+			if (key.first != axis) {
+				continue;
+			}
+			ScalingPoint point = entry.first;
+			point.rate /= static_cast<double>(entry.second);
+			curves.push_back(point);
+		}
+
+		const ScalingPoint base = curves[first];
+		for (size_t i = first; i < curves.size(); i++) {
+			ScalingPoint& point = curves[i];
+			point.relative = base.rate > 0.0 ? point.rate / base.rate : 0.0;
+			if (point.ideal_speedup > 0.0 && base.ideal_speedup > 0.0) {
+				point.efficiency = point.relative / (point.ideal_speedup / base.ideal_speedup);
+			}
+		}
+	}
+	return curves;
+}
+
+void writeScalingCSV(const std::vector<ScalingPoint>& curves, const std::filesystem::path& path) {
+	std::ofstream out = openForWriting(path);
+	out << "axis,x,rate,relative,ideal_speedup,efficiency\n";
+	for (const ScalingPoint& point : curves) {
+		out << std::format("{},{},{},{},{},", point.axis, point.x, point.rate, point.relative, point.ideal_speedup);
+		if (point.efficiency) {
+			out << *point.efficiency;
+		}
+		out << '\n';
+	}
+}
+
+void writeScalingJson(const std::vector<ScalingPoint>& curves, const std::filesystem::path& path) {
+	nlohmann::json j = nlohmann::json::object();
+	for (const ScalingPoint& point : curves) {
+		nlohmann::json p = {
+			{"x", point.x}, {"rate", point.rate}, {"relative", point.relative}
+		};
+		if (point.efficiency) {
+			p["ideal_speedup"] = point.ideal_speedup;
+			p["efficiency"] = *point.efficiency;
+		}
+		j[point.axis].push_back(std::move(p));
+	}
+	openForWriting(path) << j.dump(2) << '\n';
+}
+
+void printScalingSummary(const std::vector<ScalingPoint>& curves, std::ostream& out) {
+	std::string axis;
+	for (const ScalingPoint& point : curves) {
+		if (point.axis != axis) {
+			axis = point.axis;
+			out << std::format("\nScaling along {}\n{:>12} {:>16} {:>10} {:>12}\n", axis, "x", "rate", "relative", "efficiency");
+		}
+		out << std::format("{:>12} {:>16.1f} {:>10.3f} {:>12}\n", point.x, point.rate, point.relative,
+			point.efficiency ? std::format("{:.1f}%", *point.efficiency * 100.0) : std::string("-"));
+	}
+}
+
+ScalingReporter::ScalingReporter(std::unique_ptr<benchmark::BenchmarkReporter> inner, std::filesystem::path outputPrefix) :
+	mInner(std::move(inner)), mOutputPrefix(std::move(outputPrefix)) {}
+
+bool ScalingReporter::ReportContext(const Context& context) {
+	return mInner->ReportContext(context);
+}
+
+void ScalingReporter::ReportRuns(const std::vector<Run>& reports) {
+	for (const Run& run : reports) {
+		const std::string name = run.benchmark_name();
+		const auto x = run.counters.find("scaling_x");
+		const auto rate = run.counters.find("scaling_rate");
+		// a run that failed has none of its counters
+		if (run.run_type != Run::RT_Iteration || !name.starts_with("scaling/") || x == run.counters.end() || rate == run.counters.end()) {
+			continue;
+		}
+
+		ScalingPoint point;
+		point.axis = name.substr(8, name.find('/', 8) - 8);
+		point.x = x->second.value;
+		point.rate = rate->second.value;
+		if (const auto ideal = run.counters.find("ideal_speedup"); ideal != run.counters.end()) {
+			point.ideal_speedup = ideal->second.value;
+		}
+		mPoints.push_back(std::move(point));
+	}
+	mInner->ReportRuns(reports);
+}
+
+void ScalingReporter::Finalize() {
+	mInner->Finalize();
+	if (mPoints.empty()) {
+		return;
+	}
+
+	const auto curves = buildScalingCurves(mPoints);
+	std::filesystem::path csv = mOutputPrefix;
+	std::filesystem::path json = mOutputPrefix;
+	writeScalingCSV(curves, csv += ".csv");
+	writeScalingJson(curves, json += ".json");
+	printScalingSummary(curves, std::cerr);
+}
+
+std::unique_ptr<benchmark::BenchmarkReporter> makeDisplayReporter(const std::string& format) {
+	if (format == "json") {
+		return std::make_unique<benchmark::JSONReporter>();
+	}
+	if (format == "csv") {
+		// (as Google Benchmark does itself, until it drops the format)
+		BENCHMARK_DISABLE_DEPRECATED_WARNING
+		return std::make_unique<benchmark::CSVReporter>();
+		BENCHMARK_RESTORE_DEPRECATED_WARNING
+	}
+	return std::make_unique<benchmark::ConsoleReporter>();
+}
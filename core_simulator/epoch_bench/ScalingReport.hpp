@@ -0,0 +1,63 @@
+#pragma once
+
+#include <filesystem>
+#include <iosfwd>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+/**
+* A point on one of the scaling curves (see bench_scaling.cpp)
+*/
+struct ScalingPoint {
+	// timesteps, solar_arrays, tariffs, fabric_interventions, threads or sites
+	std::string axis;
+	double x = 0.0;
+	// the throughput at x (timesteps, tariffs or scenarios per second, depending on the axis)
+	double rate = 0.0;
+	// the speedup that perfect scaling would reach at x (0 where that isn't meaningful)
+	double ideal_speedup = 0.0;
+
+	// the rate relative to the first point of the curve
+	double relative = 1.0;
+	// the speedup over the first point compared with the ideal speedup (only for the threads and sites)
+	std::optional<double> efficiency;
+};
+
+/**
+* Group the points by axis (in the order each axis was first seen) and sort each by x,
+* averaging the rates of any repetitions, then fill in relative and efficiency against the first point of each curve
+*/
+std::vector<ScalingPoint> buildScalingCurves(const std::vector<ScalingPoint>& points);
+
+void writeScalingCSV(const std::vector<ScalingPoint>& curves, const std::filesystem::path& path);
+void writeScalingJson(const std::vector<ScalingPoint>& curves, const std::filesystem::path& path);
+void printScalingSummary(const std::vector<ScalingPoint>& curves, std::ostream& out);
+
+/**
+* Passes every run on to another reporter, collecting the scaling benchmarks as it does
+*
+* Once the benchmarks have finished, this writes the scaling curves to <outputPrefix>.csv and <outputPrefix>.json
+* and prints them with the parallel efficiency to stderr (so they never mix with json or csv written to stdout).
+*/
+class ScalingReporter : public benchmark::BenchmarkReporter {
+public:
+	ScalingReporter(std::unique_ptr<benchmark::BenchmarkReporter> inner, std::filesystem::path outputPrefix);
+
+	bool ReportContext(const Context& context) override;
+	void ReportRuns(const std::vector<Run>& reports) override;
+	void Finalize() override;
+
+private:
+	std::unique_ptr<benchmark::BenchmarkReporter> mInner;
+	std::filesystem::path mOutputPrefix;
+	std::vector<ScalingPoint> mPoints;
+};
+
+/**
+* The display reporter that Google Benchmark would have made for --benchmark_format (console, json or csv)
+*/
+std::unique_ptr<benchmark::BenchmarkReporter> makeDisplayReporter(const std::string& format);
@@ -0,0 +1,60 @@
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include <benchmark/benchmark.h>
+
+#include <spdlog/spdlog.h>
+
+#include "AllocationCounter.hpp"
+#include "Benchmarks.hpp"
+#include "PerfCounters.hpp"
+#include "ScalingReport.hpp"
+
+int main(int argc, char** argv) {
+	// invalid scenarios and the like are expected; we don't want logging in the timings
+	spdlog::set_level(spdlog::level::err);
+
+	// before the thread pool is started, so that its workers are counted
+	startPerfCounters();
+
+	// --scaling_out is our own flag, so it is taken out before Google Benchmark sees the arguments
+	std::optional<std::string> scalingOut;
+	std::string format = "console";
+	int kept = 1;
+	for (int i = 1; i < argc; i++) {
+		const std::string_view arg = argv[i];
+		if (arg.starts_with("--scaling_out=")) {
+			scalingOut = std::string(arg.substr(std::string_view("--scaling_out=").size()));
+			continue;
+		}
+		if (arg.starts_with("--benchmark_format=")) {
+			format = std::string(arg.substr(std::string_view("--benchmark_format=").size()));
+		}
+		argv[kept++] = argv[i];
+	}
+	argc = kept;
+
+	benchmark::Initialize(&argc, argv);
+	if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+		return 1;
+	}
+
+	benchmark::AddCustomContext("allocations_include_malloc", countsMallocAllocations() ? "true" : "false");
+	benchmark::AddCustomContext("perf_counters", perfCounterStatus());
+
+	registerSiteDataBenchmarks();
+	registerTimeSeriesBenchmarks();
+	registerSimulateBenchmarks();
+	registerScalingBenchmarks();
+
+	if (scalingOut) {
+		ScalingReporter reporter(makeDisplayReporter(format), *scalingOut);
+		benchmark::RunSpecifiedBenchmarks(&reporter);
+	}
+	else {
+		benchmark::RunSpecifiedBenchmarks();
+	}
+	benchmark::Shutdown();
+	return 0;
+}
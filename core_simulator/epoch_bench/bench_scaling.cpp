@@ -0,0 +1,252 @@
+#include "Benchmarks.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "BenchFixtures.hpp"
+#include "../epoch_lib/Portfolio/PortfolioSimulator.hpp"
+#include "../epoch_lib/Simulation/ThreadPool.hpp"
+
+namespace {
+
+	// the shape of the Mount Hotel site itself, which each sweep varies along one axis
+	SyntheticSite siteShape() {
+		const SiteData& source = *getSiteData(SiteResolution::HalfHourly);
+		SyntheticSite shape;
+		shape.timesteps = static_cast<Eigen::Index>(source.timesteps);
+		shape.solarArrays = static_cast<size_t>(source.solar_yields.size());
+		shape.tariffs = source.import_tariffs.size();
+		shape.fabricInterventions = source.fabric_interventions.size();
+		return shape;
+	}
+
+	const TaskData& fullMix() {
+		return allScenarioMixes().back().taskData;
+	}
+
+	/**
+	* Report a point on a scaling curve (read by the ScalingReporter)
+	*
+	* rate is the throughput being scaled, and idealSpeedup (when given) is the speedup that perfect scaling would reach,
+	* from which the parallel efficiency is found
+	*/
+	void setScalingCounters(benchmark::State& state, double x, double rate, double idealSpeedup = 0.0) {
+		state.counters["scaling_x"] = x;
+		state.counters["scaling_rate"] = benchmark::Counter(rate, benchmark::Counter::kIsRate);
+		if (idealSpeedup > 0.0) {
+			state.counters["ideal_speedup"] = idealSpeedup;
+		}
+	}
+
+	// A single scenario as the timeseries get longer; the rate is timesteps per second, which would be flat if the cost were linear
+	void scaleTimesteps(benchmark::State& state, Eigen::Index timesteps) {
+		SyntheticSite shape = siteShape();
+		shape.timesteps = timesteps;
+		Simulator simulator(makeSyntheticSiteData(shape), TaskConfig{});
+
+		for (auto _ : state) {
+			auto result = simulator.simulateScenario(fullMix());
+			benchmark::DoNotOptimize(result);
+		}
+
+		const double simulated = static_cast<double>(state.iterations()) * static_cast<double>(timesteps);
+		state.counters["timesteps"] = static_cast<double>(timesteps);
+		state.counters["timesteps_per_second"] = benchmark::Counter(simulated, benchmark::Counter::kIsRate);
+		setScalingCounters(state, static_cast<double>(timesteps), simulated);
+	}
+
+	// A single scenario with its generation split between more and more solar arrays
+	void scaleSolarArrays(benchmark::State& state, size_t arrays) {
+		SyntheticSite shape = siteShape();
+		shape.solarArrays = arrays;
+		Simulator simulator(makeSyntheticSiteData(shape), TaskConfig{});
+
+		TaskData taskData = fullMix();
+		float totalScalar = 0.0f;
+		for (const auto& panel : taskData.solar_panels) {
+			totalScalar += panel.yield_scalar;
+		}
+		taskData.solar_panels.clear();
+		for (size_t i = 0; i < arrays; i++) {
+			SolarData panel;
+			panel.yield_index = static_cast<int>(i);
+			panel.yield_scalar = totalScalar / static_cast<float>(arrays);
+			taskData.solar_panels.push_back(panel);
+		}
+
+		for (auto _ : state) {
+			auto result = simulator.simulateScenario(taskData);
+			benchmark::DoNotOptimize(result);
+		}
+
+		const double scenarios = static_cast<double>(state.iterations());
+		state.counters["solar_arrays"] = static_cast<double>(arrays);
+		state.counters["scenarios_per_second"] = benchmark::Counter(scenarios, benchmark::Counter::kIsRate);
+		setScalingCounters(state, static_cast<double>(arrays), scenarios);
+	}
+
+	// Simulating a scenario under every tariff of a site; the rate is tariffs per second
+	void scaleTariffs(benchmark::State& state, size_t tariffs) {
+		SyntheticSite shape = siteShape();
+		shape.tariffs = tariffs;
+		Simulator simulator(makeSyntheticSiteData(shape), TaskConfig{});
+
+		for (auto _ : state) {
+			auto results = simulator.simulateAllTariffs(fullMix());
+			benchmark::DoNotOptimize(results);
+		}
+
+		const double simulated = static_cast<double>(state.iterations()) * static_cast<double>(tariffs);
+		state.counters["tariffs"] = static_cast<double>(tariffs);
+		state.counters["tariffs_per_second"] = benchmark::Counter(simulated, benchmark::Counter::kIsRate);
+		setScalingCounters(state, static_cast<double>(tariffs), simulated);
+	}
+
+	// Simulating a scenario with each of a site's fabric interventions (and with none)
+	void scaleFabricInterventions(benchmark::State& state, size_t interventions) {
+		SyntheticSite shape = siteShape();
+		shape.fabricInterventions = interventions;
+		Simulator simulator(makeSyntheticSiteData(shape), TaskConfig{});
+
+		std::vector<TaskData> options;
+		for (size_t i = 0; i <= interventions; i++) {
+			TaskData taskData = fullMix();
+			taskData.building->fabric_intervention_index = i;
+			options.push_back(taskData);
+		}
+
+		for (auto _ : state) {
+			for (const TaskData& taskData : options) {
+				auto result = simulator.simulateScenario(taskData);
+				benchmark::DoNotOptimize(result);
+			}
+		}
+
+		const double scenarios = static_cast<double>(state.iterations()) * static_cast<double>(options.size());
+		state.counters["fabric_interventions"] = static_cast<double>(interventions);
+		state.counters["scenarios_per_second"] = benchmark::Counter(scenarios, benchmark::Counter::kIsRate);
+		setScalingCounters(state, static_cast<double>(interventions), scenarios);
+	}
+
+	// A batch of scenarios on a pool of the given number of threads
+	void scaleThreads(benchmark::State& state, size_t threads) {
+		const Simulator& simulator = getSimulator(SiteResolution::HalfHourly);
+
+		std::vector<TaskData> batch;
+		for (int i = 0; i < 16; i++) {
+			for (const auto& mix : allScenarioMixes()) {
+				batch.push_back(mix.taskData);
+			}
+		}
+
+		// the calling thread helps to run the batch, so the pool has one fewer worker than the threads being measured
+		std::unique_ptr<ThreadPool> pool = threads > 1 ? std::make_unique<ThreadPool>(threads - 1) : nullptr;
+
+		for (auto _ : state) {
+			if (pool) {
+				auto results = simulator.simulateBatch(batch, SimulationType::ResultOnly, *pool);
+				benchmark::DoNotOptimize(results);
+			}
+			else {
+				for (const TaskData& taskData : batch) {
+					auto result = simulator.simulateScenario(taskData);
+					benchmark::DoNotOptimize(result);
+				}
+			}
+		}
+
+		const double scenarios = static_cast<double>(state.iterations()) * static_cast<double>(batch.size());
+		state.counters["threads"] = static_cast<double>(threads);
+		state.counters["scenarios_per_second"] = benchmark::Counter(scenarios, benchmark::Counter::kIsRate);
+		setScalingCounters(state, static_cast<double>(threads), scenarios, static_cast<double>(threads));
+	}
+
+	// A portfolio of more and more sites on the shared pool; the rate is site scenarios per second
+	void scaleSites(benchmark::State& state, size_t sites) {
+		std::map<std::string, std::shared_ptr<const Simulator>> simulators;
+		PortfolioTaskData portfolio;
+		for (size_t i = 0; i < sites; i++) {
+			SyntheticSite shape = siteShape();
+			// every site has its own demand, so no two are the same
+			shape.demandScale = 0.5f + static_cast<float>(i) / static_cast<float>(sites);
+			const std::string name = "site_" + std::to_string(i);
+			simulators.emplace(name, std::make_shared<const Simulator>(makeSyntheticSiteData(shape), TaskConfig{}));
+			portfolio.emplace(name, fullMix());
+		}
+		PortfolioSimulator portfolioSimulator(std::move(simulators));
+		ThreadPool& pool = ThreadPool::shared();
+
+		for (auto _ : state) {
+			auto result = portfolioSimulator.simulatePortfolio(portfolio, SimulationType::ResultOnly, pool);
+			benchmark::DoNotOptimize(result);
+		}
+
+		// the sites can't run any faster than there are threads to run them
+		// (the calling thread helps, so there is one more than the pool's workers)
+		const double idealSpeedup = static_cast<double>(std::min(sites, pool.size() + 1));
+
+		const double simulated = static_cast<double>(state.iterations()) * static_cast<double>(sites);
+		state.counters["sites"] = static_cast<double>(sites);
+		state.counters["site_scenarios_per_second"] = benchmark::Counter(simulated, benchmark::Counter::kIsRate);
+		setScalingCounters(state, static_cast<double>(sites), simulated, idealSpeedup);
+	}
+
+	// 1, 2, 4, ... up to (and including) the hardware threads
+	std::vector<size_t> threadCounts() {
+		const size_t hardware = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+		std::vector<size_t> counts;
+		for (size_t n = 1; n < hardware; n *= 2) {
+			counts.push_back(n);
+		}
+		counts.push_back(hardware);
+		return counts;
+	}
+}
+
+
+void registerScalingBenchmarks() {
+	// hourly through to 5-minute (1x to 12x the hourly timesteps)
+	for (Eigen::Index timesteps : { 8760, 17520, 35040, 52560, 105120 }) {
+		benchmark::RegisterBenchmark(
+			("scaling/timesteps/" + std::to_string(timesteps)).c_str(),
+			[timesteps](benchmark::State& state) { scaleTimesteps(state, timesteps); })->Unit(benchmark::kMillisecond);
+	}
+
+	for (size_t arrays : { 1, 2, 4, 8, 16, 32 }) {
+		benchmark::RegisterBenchmark(
+			("scaling/solar_arrays/" + std::to_string(arrays)).c_str(),
+			[arrays](benchmark::State& state) { scaleSolarArrays(state, arrays); })->Unit(benchmark::kMillisecond);
+	}
+
+	for (size_t tariffs : { 1, 2, 4, 8, 16 }) {
+		benchmark::RegisterBenchmark(
+			("scaling/tariffs/" + std::to_string(tariffs)).c_str(),
+			[tariffs](benchmark::State& state) { scaleTariffs(state, tariffs); })->Unit(benchmark::kMillisecond);
+	}
+
+	for (size_t interventions : { 0, 1, 2, 4, 8, 16 }) {
+		benchmark::RegisterBenchmark(
+			("scaling/fabric_interventions/" + std::to_string(interventions)).c_str(),
+			[interventions](benchmark::State& state) { scaleFabricInterventions(state, interventions); })->Unit(benchmark::kMillisecond);
+	}
+
+	for (size_t threads : threadCounts()) {
+		benchmark::RegisterBenchmark(
+			("scaling/threads/" + std::to_string(threads)).c_str(),
+			[threads](benchmark::State& state) { scaleThreads(state, threads); })->Unit(benchmark::kMillisecond)->UseRealTime();
+	}
+
+	for (size_t sites : { 1, 2, 4, 8, 16 }) {
+		benchmark::RegisterBenchmark(
+			("scaling/sites/" + std::to_string(sites)).c_str(),
+			[sites](benchmark::State& state) { scaleSites(state, sites); })->Unit(benchmark::kMillisecond)->UseRealTime();
+	}
+}
@@ -0,0 +1,154 @@
+#include "Benchmarks.hpp"
+
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "AllocationCounter.hpp"
+#include "BenchFixtures.hpp"
+#include "PerfCounters.hpp"
+
+namespace {
+
+	// Report the allocations made in the timed loop as a per-scenario average
+	void setAllocationCounters(benchmark::State& state, const AllocationSnapshot& before, int64_t scenarios) {
+		AllocationSnapshot after = allocationSnapshot();
+		double perScenario = scenarios > 0 ? 1.0 / static_cast<double>(scenarios) : 0.0;
+
+		state.counters["bytes_per_scenario"] = static_cast<double>(after.bytes - before.bytes) * perScenario;
+		state.counters["allocs_per_scenario"] = static_cast<double>(after.allocations - before.allocations) * perScenario;
+	}
+
+	// Report the hardware counters of the timed loop as IPC and per-timestep rates (when the counters are available)
+	void setPerfCounters(benchmark::State& state, const std::optional<PerfCounterSnapshot>& before, int64_t scenarios, size_t timesteps) {
+		const auto after = perfCounterSnapshot();
+		if (!before || !after || scenarios <= 0) {
+			return;
+		}
+
+		const double instructions = static_cast<double>(after->instructions - before->instructions);
+		const double cycles = static_cast<double>(after->cycles - before->cycles);
+		const double perTimestep = 1.0 / (static_cast<double>(scenarios) * static_cast<double>(timesteps));
+
+		state.counters["ipc"] = cycles > 0.0 ? instructions / cycles : 0.0;
+		state.counters["instructions_per_timestep"] = instructions * perTimestep;
+		state.counters["branch_misses_per_timestep"] = static_cast<double>(after->branch_misses - before->branch_misses) * perTimestep;
+		state.counters["llc_misses_per_timestep"] = static_cast<double>(after->llc_misses - before->llc_misses) * perTimestep;
+	}
+
+	void simulateScenario(benchmark::State& state, SiteResolution resolution, const TaskData& taskData, SimulationType simulationType) {
+		const Simulator& simulator = getSimulator(resolution);
+
+		AllocationSnapshot before = allocationSnapshot();
+		const auto perfBefore = perfCounterSnapshot();
+		for (auto _ : state) {
+			auto result = simulator.simulateScenario(taskData, simulationType);
+			benchmark::DoNotOptimize(result);
+		}
+		setPerfCounters(state, perfBefore, state.iterations(), getSiteData(resolution)->timesteps);
+
+		// a single thread, so this is also the rate per core
+		state.counters["scenarios_per_second"] = benchmark::Counter(
+			static_cast<double>(state.iterations()), benchmark::Counter::kIsRate);
+		state.counters["timesteps"] = static_cast<double>(getSiteData(resolution)->timesteps);
+		setAllocationCounters(state, before, state.iterations());
+	}
+
+	void simulateBatch(benchmark::State& state, SiteResolution resolution) {
+		const Simulator& simulator = getSimulator(resolution);
+		ThreadPool& pool = ThreadPool::shared();
+
+		// a batch containing each of the mixes several times over
+		std::vector<TaskData> batch;
+		for (int i = 0; i < 8; i++) {
+			for (const auto& mix : allScenarioMixes()) {
+				batch.push_back(mix.taskData);
+			}
+		}
+
+		AllocationSnapshot before = allocationSnapshot();
+		const auto perfBefore = perfCounterSnapshot();
+		for (auto _ : state) {
+			auto results = simulator.simulateBatch(batch, SimulationType::ResultOnly, pool);
+			benchmark::DoNotOptimize(results);
+		}
+
+		int64_t scenarios = state.iterations() * static_cast<int64_t>(batch.size());
+		setPerfCounters(state, perfBefore, scenarios, getSiteData(resolution)->timesteps);
+		state.SetItemsProcessed(scenarios);
+		state.counters["scenarios_per_second"] = benchmark::Counter(
+			static_cast<double>(scenarios), benchmark::Counter::kIsRate);
+		state.counters["scenarios_per_second_per_core"] = benchmark::Counter(
+			static_cast<double>(scenarios) / static_cast<double>(pool.size()), benchmark::Counter::kIsRate);
+		state.counters["threads"] = static_cast<double>(pool.size());
+		setAllocationCounters(state, before, scenarios);
+	}
+
+	// Size the ESS across a range of capacities, as an optimiser sweeping a single component would
+	void simulateESSSweep(benchmark::State& state, SiteResolution resolution, const TaskData& base, bool preBalancingCache) {
+		std::vector<TaskData> sweep;
+		for (int i = 1; i <= 16; i++) {
+			TaskData td = base;
+			td.energy_storage_system->capacity = 100.0f * static_cast<float>(i);
+			sweep.push_back(td);
+		}
+
+		Simulator simulator(getSiteData(resolution), TaskConfig{});
+
+		const auto perfBefore = perfCounterSnapshot();
+		for (auto _ : state) {
+			if (preBalancingCache) {
+				// start each sweep cold so that the first scenario pays for the snapshot
+				simulator.enablePreBalancingCache(size_t{ 256 } << 20);
+			}
+			for (const TaskData& td : sweep) {
+				auto result = simulator.simulateScenario(td);
+				benchmark::DoNotOptimize(result);
+			}
+		}
+
+		int64_t scenarios = state.iterations() * static_cast<int64_t>(sweep.size());
+		setPerfCounters(state, perfBefore, scenarios, getSiteData(resolution)->timesteps);
+		state.counters["scenarios_per_second"] = benchmark::Counter(
+			static_cast<double>(scenarios), benchmark::Counter::kIsRate);
+	}
+}
+
+
+void registerSimulateBenchmarks() {
+	for (SiteResolution resolution : allResolutions()) {
+		const std::string site = resolutionName(resolution);
+
+		for (const auto& mix : allScenarioMixes()) {
+			benchmark::RegisterBenchmark(
+				("simulateScenario/" + site + "/" + mix.name).c_str(),
+				[resolution, &mix](benchmark::State& state) {
+					simulateScenario(state, resolution, mix.taskData, SimulationType::ResultOnly);
+				})->Unit(benchmark::kMillisecond);
+		}
+
+		// FullReporting is only used for a handful of scenarios, so a single mix is enough to track it
+		const auto& full = allScenarioMixes().back();
+		benchmark::RegisterBenchmark(
+			("simulateScenario_fullReporting/" + site + "/" + full.name).c_str(),
+			[resolution, &full](benchmark::State& state) {
+				simulateScenario(state, resolution, full.taskData, SimulationType::FullReporting);
+			})->Unit(benchmark::kMillisecond);
+
+		benchmark::RegisterBenchmark(
+			("simulateBatch/" + site).c_str(),
+			[resolution](benchmark::State& state) {
+				simulateBatch(state, resolution);
+			})->Unit(benchmark::kMillisecond)->UseRealTime();
+
+		for (bool cached : { false, true }) {
+			benchmark::RegisterBenchmark(
+				("simulateESSSweep/" + site + (cached ? "/pre_balancing_cache" : "/uncached")).c_str(),
+				[resolution, &full, cached](benchmark::State& state) {
+					simulateESSSweep(state, resolution, full.taskData, cached);
+				})->Unit(benchmark::kMillisecond);
+		}
+	}
+}
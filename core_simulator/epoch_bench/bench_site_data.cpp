@@ -0,0 +1,88 @@
+#include "Benchmarks.hpp"
+
+#include <filesystem>
+#include <string>
+#include <utility>
+
+#include <benchmark/benchmark.h>
+
+#include "AllocationCounter.hpp"
+#include "BenchFixtures.hpp"
+#include "../epoch_lib/io/FileHandling.hpp"
+#include "../epoch_lib/io/SiteDataBinary.hpp"
+
+namespace {
+
+	void readSiteDataFile(benchmark::State& state, SiteResolution resolution) {
+		const std::filesystem::path file = getSiteDataFile(resolution);
+		const auto fileSize = std::filesystem::file_size(file);
+
+		AllocationSnapshot before = allocationSnapshot();
+		for (auto _ : state) {
+			auto siteData = readSiteData(file);
+			benchmark::DoNotOptimize(std::as_const(siteData));
+		}
+		AllocationSnapshot after = allocationSnapshot();
+
+		state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(fileSize));
+		state.counters["bytes_allocated_per_read"] = benchmark::Counter(
+			static_cast<double>(after.bytes - before.bytes), benchmark::Counter::kAvgIterations);
+	}
+
+	void readSiteDataBinaryFile(benchmark::State& state, SiteResolution resolution) {
+		// convert alongside the json file, outside of the timed loop
+		const std::filesystem::path file = std::filesystem::temp_directory_path() / ("epoch_bench_" + resolutionName(resolution) + ".bin");
+		writeSiteDataBinary(*getSiteData(resolution), file);
+		const auto fileSize = std::filesystem::file_size(file);
+
+		AllocationSnapshot before = allocationSnapshot();
+		for (auto _ : state) {
+			auto siteData = readSiteData(file);
+			benchmark::DoNotOptimize(std::as_const(siteData));
+		}
+		AllocationSnapshot after = allocationSnapshot();
+
+		state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(fileSize));
+		state.counters["bytes_allocated_per_read"] = benchmark::Counter(
+			static_cast<double>(after.bytes - before.bytes), benchmark::Counter::kAvgIterations);
+		std::filesystem::remove(file);
+	}
+
+	void constructSimulator(benchmark::State& state, SiteResolution resolution) {
+		// this includes simulating the baseline and precomputing the tariff statistics
+		auto siteData = getSiteData(resolution);
+
+		AllocationSnapshot before = allocationSnapshot();
+		for (auto _ : state) {
+			Simulator simulator{ siteData, TaskConfig{} };
+			// the baseline is otherwise only simulated for the first scenario
+			benchmark::DoNotOptimize(simulator.getBaseline());
+		}
+		AllocationSnapshot after = allocationSnapshot();
+
+		state.counters["bytes_allocated_per_simulator"] = benchmark::Counter(
+			static_cast<double>(after.bytes - before.bytes), benchmark::Counter::kAvgIterations);
+	}
+}
+
+
+void registerSiteDataBenchmarks() {
+	for (SiteResolution resolution : allResolutions()) {
+		const std::string site = resolutionName(resolution);
+
+		benchmark::RegisterBenchmark(
+			("readSiteData/" + site).c_str(),
+			[resolution](benchmark::State& state) { readSiteDataFile(state, resolution); }
+		)->Unit(benchmark::kMillisecond);
+
+		benchmark::RegisterBenchmark(
+			("readSiteDataBinary/" + site).c_str(),
+			[resolution](benchmark::State& state) { readSiteDataBinaryFile(state, resolution); }
+		)->Unit(benchmark::kMillisecond);
+
+		benchmark::RegisterBenchmark(
+			("constructSimulator/" + site).c_str(),
+			[resolution](benchmark::State& state) { constructSimulator(state, resolution); }
+		)->Unit(benchmark::kMillisecond);
+	}
+}
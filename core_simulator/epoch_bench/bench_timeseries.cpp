@@ -0,0 +1,43 @@
+#include "Benchmarks.hpp"
+
+#include <filesystem>
+#include <string>
+
+#include <benchmark/benchmark.h>
+
+#include "AllocationCounter.hpp"
+#include "BenchFixtures.hpp"
+#include "../epoch_lib/io/TimeSeriesWriter.hpp"
+
+namespace {
+
+	void writeTimeSeriesCSV(benchmark::State& state, SiteResolution resolution, const TaskData& taskData) {
+		// simulate once, outside of the timed loop
+		auto result = getSimulator(resolution).simulateScenario(taskData, SimulationType::FullReporting);
+		const std::filesystem::path file = std::filesystem::temp_directory_path() / ("epoch_bench_" + resolutionName(resolution) + ".csv");
+
+		AllocationSnapshot before = allocationSnapshot();
+		for (auto _ : state) {
+			writeTimeSeriesToCSV(file, *result.report_data);
+		}
+		AllocationSnapshot after = allocationSnapshot();
+
+		state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(std::filesystem::file_size(file)));
+		state.counters["allocs_per_write"] = benchmark::Counter(
+			static_cast<double>(after.allocations - before.allocations), benchmark::Counter::kAvgIterations);
+		std::filesystem::remove(file);
+	}
+}
+
+
+void registerTimeSeriesBenchmarks() {
+	for (SiteResolution resolution : allResolutions()) {
+		const std::string site = resolutionName(resolution);
+
+		const auto& full = allScenarioMixes().back();
+		benchmark::RegisterBenchmark(
+			("writeTimeSeriesCSV/" + site).c_str(),
+			[resolution, &full](benchmark::State& state) { writeTimeSeriesCSV(state, resolution, full.taskData); }
+		)->Unit(benchmark::kMillisecond);
+	}
+}
@@ -0,0 +1,293 @@
+/**
+* epoch_perf_check: a performance regression gate
+*
+* This runs a fixed set of the benchmark scenarios several times and compares each against a committed baseline:
+* - the median time per run must be within the tolerance of the baseline
+* - the allocations per run must not grow by more than the allocation tolerance
+* - the checksum of the results must be identical, so that an optimisation can't silently change them
+*
+* It exits with 1 if anything regressed (and 2 if it could not run), so it can gate a build.
+* Both the times and the results depend on the machine and compiler; run with --update on the reference machine
+* to rewrite the baseline.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+
+#include "AllocationCounter.hpp"
+#include "BenchFixtures.hpp"
+#include "../epoch_lib/io/BinaryArchive.hpp"
+
+namespace {
+
+	struct Options {
+		std::filesystem::path baseline{ EPOCH_PERF_BASELINE };
+		// the fraction by which the median time may exceed the baseline
+		double tolerance = 0.15;
+		// the fraction by which the allocations per run may exceed the baseline
+		double allocTolerance = 0.05;
+		int repeats = 7;
+		bool update = false;
+	};
+
+	struct PerfCase {
+		std::string name;
+		// the number of runs timed together in each repeat, so that each sample is long enough to time reliably
+		int runsPerSample;
+		std::function<std::vector<SimulationResult>()> run;
+	};
+
+	struct Measurement {
+		double median_ms = 0.0;
+		double allocs_per_run = 0.0;
+		std::string checksum;
+	};
+
+	/**
+	* FNV-1a over the metrics, comparison and capex of each result (and its timeseries, when it has them)
+	* The runtime and timings are left out, as they differ from run to run
+	*/
+	std::string checksum(const std::vector<SimulationResult>& results) {
+		std::ostringstream bytes;
+		binary::Writer writer(bytes);
+		for (const SimulationResult& result : results) {
+			writer(result.metrics, result.baseline_metrics, result.comparison, result.scenario_capex_breakdown,
+				result.violates_constraints);
+			if (result.report_data) {
+				for (ReportColumn column : result.report_data->populatedColumns()) {
+					const auto values = result.report_data->get(column);
+					writer(static_cast<uint32_t>(column));
+					writer.writeFloats(values.data(), static_cast<size_t>(values.size()));
+				}
+			}
+		}
+
+		uint64_t hash = 14695981039346656037ull;
+		for (char c : std::move(bytes).str()) {
+			hash ^= static_cast<unsigned char>(c);
+			hash *= 1099511628211ull;
+		}
+		return std::format("{:016x}", hash);
+	}
+
+	const ScenarioMix& findMix(std::string_view name) {
+		for (const auto& mix : allScenarioMixes()) {
+			if (mix.name == name) {
+				return mix;
+			}
+		}
+		throw std::invalid_argument(std::format("Unknown scenario mix {}", name));
+	}
+
+	std::vector<PerfCase> perfCases() {
+		const SiteResolution resolution = SiteResolution::HalfHourly;
+		const Simulator& simulator = getSimulator(resolution);
+		std::vector<PerfCase> cases;
+
+		for (std::string_view mixName : { "empty", "ess_consume", "ess_consume_plus", "ev_balancing", "hotroom_data_centre", "full" }) {
+			const TaskData& taskData = findMix(mixName).taskData;
+			cases.push_back({ std::format("simulateScenario/half_hourly/{}", mixName), 20, [&simulator, &taskData] {
+				return std::vector<SimulationResult>{ simulator.simulateScenario(taskData) };
+			} });
+		}
+
+		const TaskData& full = findMix("full").taskData;
+		cases.push_back({ "simulateScenario_fullReporting/half_hourly/full", 5, [&simulator, &full] {
+			return std::vector<SimulationResult>{ simulator.simulateScenario(full, SimulationType::FullReporting) };
+		} });
+
+		cases.push_back({ "simulateBatch/half_hourly", 2, [&simulator] {
+			std::vector<TaskData> batch;
+			for (int i = 0; i < 4; i++) {
+				for (const auto& mix : allScenarioMixes()) {
+					batch.push_back(mix.taskData);
+				}
+			}
+			return simulator.simulateBatch(batch, SimulationType::ResultOnly);
+		} });
+
+		// this is mostly simulating the baseline, whose metrics are in every result
+		const TaskData& empty = findMix("empty").taskData;
+		cases.push_back({ "constructSimulator/half_hourly", 2, [resolution, &empty] {
+			Simulator constructed(getSiteData(resolution), TaskConfig{});
+			return std::vector<SimulationResult>{ constructed.simulateScenario(empty) };
+		} });
+
+		return cases;
+	}
+
+	Measurement measure(const PerfCase& perfCase, int repeats) {
+		Measurement measurement;
+		// a warm-up run, which also gives the results to check
+		measurement.checksum = checksum(perfCase.run());
+
+		std::vector<double> samples;
+		for (int r = 0; r < repeats; r++) {
+			const AllocationSnapshot before = allocationSnapshot();
+			const auto start = std::chrono::steady_clock::now();
+			for (int i = 0; i < perfCase.runsPerSample; i++) {
+				auto results = perfCase.run();
+				if (results.empty()) {
+					throw std::runtime_error(std::format("{} produced no results", perfCase.name));
+				}
+			}
+			const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+			samples.push_back(elapsed.count() / perfCase.runsPerSample);
+
+			if (r == 0) {
+				const AllocationSnapshot after = allocationSnapshot();
+				measurement.allocs_per_run = static_cast<double>(after.allocations - before.allocations) / perfCase.runsPerSample;
+			}
+		}
+
+		std::sort(samples.begin(), samples.end());
+		measurement.median_ms = samples.size() % 2 == 1
+			? samples[samples.size() / 2]
+			: 0.5 * (samples[samples.size() / 2 - 1] + samples[samples.size() / 2]);
+		return measurement;
+	}
+
+	Options parseOptions(int argc, char** argv) {
+		Options options;
+		for (int i = 1; i < argc; i++) {
+			const std::string_view arg = argv[i];
+			auto value = [&]() -> std::string {
+				if (i + 1 >= argc) {
+					throw std::invalid_argument(std::format("{} needs a value", arg));
+				}
+				return argv[++i];
+			};
+
+			if (arg == "--baseline") {
+				options.baseline = value();
+			}
+			else if (arg == "--tolerance") {
+				options.tolerance = std::stod(value());
+			}
+			else if (arg == "--alloc-tolerance") {
+				options.allocTolerance = std::stod(value());
+			}
+			else if (arg == "--repeats") {
+				options.repeats = std::max(std::stoi(value()), 1);
+			}
+			else if (arg == "--update") {
+				options.update = true;
+			}
+			else {
+				throw std::invalid_argument(std::format(
+					"Unknown argument {}\nUsage: epoch_perf_check [--baseline PATH] [--tolerance 0.15] [--alloc-tolerance 0.05] [--repeats 7] [--update]",
+					arg));
+			}
+		}
+		return options;
+	}
+
+	nlohmann::json readBaseline(const std::filesystem::path& path) {
+		std::ifstream in(path);
+		if (!in.is_open()) {
+			throw std::runtime_error(std::format("Could not read the baseline {} (run with --update to create it)", path.string()));
+		}
+		return nlohmann::json::parse(in).at("cases");
+	}
+
+	void writeBaseline(const std::filesystem::path& path, const std::vector<std::pair<std::string, Measurement>>& measurements) {
+		nlohmann::json cases = nlohmann::json::object();
+		for (const auto& [name, m] : measurements) {
+			cases[name] = { {"median_ms", m.median_ms}, {"allocs_per_run", m.allocs_per_run}, {"checksum", m.checksum} };
+		}
+		std::ofstream out(path, std::ios::trunc);
+		if (!out.is_open()) {
+			throw std::runtime_error(std::format("Could not write the baseline {}", path.string()));
+		}
+		out << nlohmann::json{ {"cases", cases} }.dump(2) << '\n';
+	}
+}
+
+int main(int argc, char** argv) {
+	// invalid scenarios and the like are expected; we don't want logging in the timings
+	spdlog::set_level(spdlog::level::err);
+
+	try {
+		const Options options = parseOptions(argc, argv);
+		const nlohmann::json baseline = options.update ? nlohmann::json::object() : readBaseline(options.baseline);
+
+		std::vector<std::pair<std::string, Measurement>> measurements;
+		int regressions = 0;
+
+		std::cout << std::format("{:<50} {:>10} {:>10} {:>8} {:>10} {:>10}  {}\n",
+			"case", "median ms", "baseline", "change", "allocs", "baseline", "result");
+
+		for (const PerfCase& perfCase : perfCases()) {
+			const Measurement m = measure(perfCase, options.repeats);
+			measurements.emplace_back(perfCase.name, m);
+
+			if (options.update) {
+				std::cout << std::format("{:<50} {:>10.3f} {:>10} {:>8} {:>10.1f} {:>10}  {}\n",
+					perfCase.name, m.median_ms, "-", "-", m.allocs_per_run, "-", m.checksum);
+				continue;
+			}
+			if (!baseline.contains(perfCase.name)) {
+				std::cout << std::format("{:<50} {:>10.3f}  (not in the baseline)\n", perfCase.name, m.median_ms);
+				continue;
+			}
+
+			const auto& base = baseline.at(perfCase.name);
+			const double baseMs = base.at("median_ms").get<double>();
+			const double baseAllocs = base.at("allocs_per_run").get<double>();
+
+			std::vector<std::string> problems;
+			if (m.median_ms > baseMs * (1.0 + options.tolerance)) {
+				problems.push_back("slower");
+			}
+			// (half an allocation of slack, as a pool's allocations can vary with how its work was shared out)
+			if (m.allocs_per_run > baseAllocs * (1.0 + options.allocTolerance) + 0.5) {
+				problems.push_back("more allocations");
+			}
+			if (m.checksum != base.at("checksum").get<std::string>()) {
+				problems.push_back("results changed");
+			}
+
+			std::string verdict = "ok";
+			if (!problems.empty()) {
+				regressions++;
+				verdict = "REGRESSED:";
+				for (const auto& problem : problems) {
+					verdict += " " + problem;
+				}
+			}
+			std::cout << std::format("{:<50} {:>10.3f} {:>10.3f} {:>+7.1f}% {:>10.1f} {:>10.1f}  {}\n",
+				perfCase.name, m.median_ms, baseMs, 100.0 * (m.median_ms / baseMs - 1.0), m.allocs_per_run, baseAllocs, verdict);
+		}
+
+		if (options.update) {
+			writeBaseline(options.baseline, measurements);
+			std::cout << std::format("Wrote the baseline to {}\n", options.baseline.string());
+			return 0;
+		}
+
+		if (regressions > 0) {
+			std::cout << std::format("{} of {} cases regressed\n", regressions, measurements.size());
+			return 1;
+		}
+		std::cout << "No regressions\n";
+		return 0;
+	}
+	catch (const std::exception& e) {
+		std::cerr << e.what() << '\n';
+		return 2;
+	}
+}
@@ -1,9 +1,19 @@
 #pragma once
 
+#include <array>
+#include <bit>
+#include <cstdint>
 #include <Eigen/Core>
+#include <format>
 #include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
 #include <optional>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <vector>
 
 #include "Simulation/Fabric.hpp"
 #include "Simulation/TaskData.hpp"
@@ -13,78 +23,386 @@
 const std::string EPOCH_VERSION = "3.11.0";
 
 using year_TS = Eigen::VectorXf;
+// A read-only view into a year_TS (or any contiguous float data) that does not copy it
+// Components use these to refer to the SiteData, which outlives every scenario
+using year_TS_view = Eigen::Ref<const year_TS>;
 
-struct ReportData {
-
+// The timeseries that may be reported by a FullReporting simulation
+enum class ReportColumn : uint8_t {
 	// TempSum
-	year_TS Actual_import_shortfall;
-	year_TS Actual_curtailed_export;
-	year_TS Heat_shortfall;
-	year_TS CH_shortfall;
-	year_TS DHW_Shortfall;
-	year_TS Heat_surplus;
+	Actual_import_shortfall,
+	Actual_curtailed_export,
+	Heat_shortfall,
+	CH_shortfall,
+	DHW_Shortfall,
+	Heat_surplus,
 
 	// Hotel
-	year_TS Hotel_load;
-	year_TS Heatload;
-	year_TS CH_demand;
-	year_TS DHW_demand;
+	Hotel_load,
+	Heatload,
+	CH_demand,
+	DHW_demand,
 
 	// PV
-	year_TS PVdcGen;
-	year_TS PVacGen;
+	PVdcGen,
+	PVacGen,
 
 	// EV
-	year_TS EV_targetload;
-	year_TS EV_actualload;
+	EV_targetload,
+	EV_actualload,
 
 	// ESS
-	year_TS ESS_charge;
-	year_TS ESS_discharge;
-	year_TS ESS_resulting_SoC;
-	year_TS ESS_AuxLoad;
-	year_TS ESS_RTL;
+	ESS_charge,
+	ESS_discharge,
+	ESS_resulting_SoC,
+	ESS_AuxLoad,
+	ESS_RTL,
 
 	// DataCentre
-	year_TS Data_centre_target_load;
-	year_TS Data_centre_actual_load;
-	year_TS Data_centre_target_heat;
-	year_TS Data_centre_available_hot_heat;
+	Data_centre_target_load,
+	Data_centre_actual_load,
+	Data_centre_target_heat,
+	Data_centre_available_hot_heat,
 
 	// Grid
-	year_TS Grid_Import;
-	year_TS Grid_Export;
+	Grid_Import,
+	Grid_Export,
 
 	// MOP
-	year_TS MOP_load;
+	MOP_load,
 
 	// GasCombustionHeater
-	year_TS GasCH_load;
-	
+	GasCH_load,
+
 	// DHW
-	year_TS DHW_load;
-	year_TS DHW_charging;
-	year_TS DHW_SoC;
-	year_TS DHW_Standby_loss;
-	year_TS DHW_ave_temperature;
-	year_TS DHW_immersion_top_up;
-	year_TS	DHW_diverter_load;
+	DHW_load,
+	DHW_charging,
+	DHW_SoC,
+	DHW_Standby_loss,
+	DHW_ave_temperature,
+	DHW_immersion_top_up,
+	DHW_diverter_load,
 
-	year_TS DHW_resistive_load;
+	DHW_resistive_load,
 
 	// ASHP
-	year_TS ASHP_elec_load;
-	year_TS ASHP_DHW_output;
-	year_TS ASHP_CH_output;
-	year_TS ASHP_free_heat;
-	year_TS ASHP_used_hotroom_heat;
+	ASHP_elec_load,
+	ASHP_DHW_output,
+	ASHP_CH_output,
+	ASHP_free_heat,
+	ASHP_used_hotroom_heat,
 
 	// TempSum intermediary calculations
-	year_TS _TempSum_elec_e;
-	year_TS _TempSum_heat_h;
-	year_TS _TempSum_DHW_load_h;
+	_TempSum_elec_e,
+	_TempSum_heat_h,
+	_TempSum_DHW_load_h,
+
+	COUNT
+};
+
+inline constexpr size_t NUM_REPORT_COLUMNS = static_cast<size_t>(ReportColumn::COUNT);
+
+// The name of each ReportColumn, in the same order as the enum
+inline constexpr std::array<const char*, NUM_REPORT_COLUMNS> REPORT_COLUMN_NAMES = {
+	"Actual_import_shortfall",
+	"Actual_curtailed_export",
+	"Heat_shortfall",
+	"CH_shortfall",
+	"DHW_Shortfall",
+	"Heat_surplus",
+	"Hotel_load",
+	"Heatload",
+	"CH_demand",
+	"DHW_demand",
+	"PVdcGen",
+	"PVacGen",
+	"EV_targetload",
+	"EV_actualload",
+	"ESS_charge",
+	"ESS_discharge",
+	"ESS_resulting_SoC",
+	"ESS_AuxLoad",
+	"ESS_RTL",
+	"Data_centre_target_load",
+	"Data_centre_actual_load",
+	"Data_centre_target_heat",
+	"Data_centre_available_hot_heat",
+	"Grid_Import",
+	"Grid_Export",
+	"MOP_load",
+	"GasCH_load",
+	"DHW_load",
+	"DHW_charging",
+	"DHW_SoC",
+	"DHW_Standby_loss",
+	"DHW_ave_temperature",
+	"DHW_immersion_top_up",
+	"DHW_diverter_load",
+	"DHW_resistive_load",
+	"ASHP_elec_load",
+	"ASHP_DHW_output",
+	"ASHP_CH_output",
+	"ASHP_free_heat",
+	"ASHP_used_hotroom_heat",
+	"_TempSum_elec_e",
+	"_TempSum_heat_h",
+	"_TempSum_DHW_load_h",
+};
+
+static_assert(NUM_REPORT_COLUMNS <= 64, "A ReportColumnMask holds at most 64 columns");
+
+/**
+* A set of ReportColumns, such as the columns that a FullReporting caller needs
+*/
+class ReportColumnMask {
+public:
+	// no columns
+	constexpr ReportColumnMask() = default;
+
+	constexpr ReportColumnMask(std::initializer_list<ReportColumn> columns) {
+		for (ReportColumn column : columns) {
+			set(column);
+		}
+	}
+
+	static constexpr ReportColumnMask all() {
+		ReportColumnMask mask;
+		mask.mBits = NUM_REPORT_COLUMNS == 64 ? ~uint64_t{ 0 } : (uint64_t{ 1 } << NUM_REPORT_COLUMNS) - 1;
+		return mask;
+	}
+
+	// the columns with each of the REPORT_COLUMN_NAMES, throwing for any other name
+	static ReportColumnMask fromNames(const std::vector<std::string>& names) {
+		ReportColumnMask mask;
+		for (const std::string& name : names) {
+			bool found = false;
+			for (size_t i = 0; i < NUM_REPORT_COLUMNS && !found; i++) {
+				if (std::string_view{ REPORT_COLUMN_NAMES[i] } == name) {
+					mask.set(static_cast<ReportColumn>(i));
+					found = true;
+				}
+			}
+			if (!found) {
+				throw std::runtime_error(std::format("{} is not a ReportData column", name));
+			}
+		}
+		return mask;
+	}
+
+	constexpr void set(ReportColumn column) { mBits |= bit(column); }
+	constexpr bool has(ReportColumn column) const { return (mBits & bit(column)) != 0; }
+	// whether this shares any column with other
+	constexpr bool hasAny(ReportColumnMask other) const { return (mBits & other.mBits) != 0; }
+	constexpr size_t count() const { return static_cast<size_t>(std::popcount(mBits)); }
+	// bit i is set if ReportColumn i is in the mask
+	constexpr uint64_t bits() const { return mBits; }
+
+	constexpr bool operator==(const ReportColumnMask& other) const = default;
+
+private:
+	static constexpr uint64_t bit(ReportColumn column) { return uint64_t{ 1 } << static_cast<size_t>(column); }
+
+	uint64_t mBits = 0;
 };
 
+/**
+* The full timeseries of a simulation, stored column by column in one allocation
+*
+* Only the columns that have been written are populated (see has()).
+* A ReportData can be restricted to the columns a caller has requested; writes to any other column are ignored
+* and no space is reserved for them.
+* The rows are padded up to a multiple of 16 floats, so each column starts a whole number of 64-byte lines
+* after the first and is as aligned as the allocation itself.
+* Copying a ReportData is therefore a single allocation and memcpy.
+*/
+class ReportData {
+public:
+	using ColumnView = Eigen::Map<Eigen::VectorXf, Eigen::AlignedMax>;
+	using ConstColumnView = Eigen::Map<const Eigen::VectorXf, Eigen::AlignedMax>;
+	// the populated columns, (timesteps x numPopulated()) without the padding
+	using ConstMatrixView = Eigen::Map<const Eigen::MatrixXf, Eigen::AlignedMax, Eigen::OuterStride<>>;
+
+	ReportData() = default;
+
+	explicit ReportData(ReportColumnMask requested) : mRequested(requested) {}
+
+	/**
+	* Write a whole column, allocating the ReportData on the first write
+	* Every column must have the same number of timesteps
+	* This does nothing (and does not evaluate values) if the column was not requested
+	*/
+	template<typename Derived>
+	void set(ReportColumn col, const Eigen::MatrixBase<Derived>& values) {
+		if (!wants(col)) {
+			return;
+		}
+		if (mTimesteps == 0) {
+			allocate(values.size());
+		}
+		else if (values.size() != mTimesteps) {
+			throw std::runtime_error(std::format(
+				"Cannot report {} timesteps for {} in a ReportData of {} timesteps",
+				values.size(), REPORT_COLUMN_NAMES[index(col)], mTimesteps
+			));
+		}
+		column(col) = values;
+	}
+
+	/**
+	* Allocate the ReportData for this many timesteps, unless it has already been allocated
+	*/
+	void reserve(Eigen::Index timesteps) {
+		if (mTimesteps == 0) {
+			allocate(timesteps);
+		}
+	}
+
+	/**
+	* A writable view of a column, which is marked as populated
+	* The ReportData must have been allocated by an earlier set() or reserve(), and the column requested
+	*/
+	ColumnView column(ReportColumn col) {
+		if (mTimesteps == 0) {
+			throw std::runtime_error("Cannot write to a column of an empty ReportData");
+		}
+		if (!wants(col)) {
+			throw std::runtime_error(std::format("Cannot write to {}, which was not requested", REPORT_COLUMN_NAMES[index(col)]));
+		}
+		int16_t& slot = mSlots[index(col)];
+		if (slot < 0) {
+			// (only the thread that writes col ever sets its slot, so it can be tested before locking)
+			std::unique_lock<std::mutex> lock;
+			if (mSharedWrites) {
+				lock = std::unique_lock<std::mutex>(*mSharedWrites);
+			}
+			slot = mNumPopulated++;
+			mPresentMask |= bit(col);
+			if (mData.size() < mNumPopulated * mStride) {
+				// this ReportData has already been shrunk
+				const Eigen::Index previousSize = mData.size();
+				mData.conservativeResize(mNumPopulated * mStride);
+				mData.tail(mData.size() - previousSize).setZero();
+			}
+		}
+		return ColumnView(mData.data() + slot * mStride, mTimesteps);
+	}
+
+	/**
+	* While a SharedWrites is alive, different columns of the ReportData may be written from different threads
+	*
+	* Each column must still be written by only one thread, and the ReportData must already be allocated (see reserve()).
+	* The columns are populated in whichever order the threads first write them, so the order of populated()
+	* is only repeatable once the ReportData has been shrunk (see shrinkToPopulated()).
+	*/
+	class SharedWrites {
+	public:
+		explicit SharedWrites(ReportData& reportData) : mReportData(reportData) {
+			if (mReportData.mTimesteps == 0) {
+				throw std::runtime_error("Cannot share the writes of an empty ReportData");
+			}
+			mReportData.mSharedWrites = &mMutex;
+		}
+		~SharedWrites() { mReportData.mSharedWrites = nullptr; }
+
+		SharedWrites(const SharedWrites&) = delete;
+		SharedWrites& operator=(const SharedWrites&) = delete;
+
+	private:
+		ReportData& mReportData;
+		std::mutex mMutex;
+	};
+
+	/**
+	* A read-only view of a column, which is empty if it has not been populated
+	*/
+	ConstColumnView get(ReportColumn col) const {
+		int16_t slot = mSlots[index(col)];
+		if (slot < 0) {
+			return ConstColumnView(nullptr, 0);
+		}
+		return ConstColumnView(mData.data() + slot * mStride, mTimesteps);
+	}
+
+	bool has(ReportColumn col) const { return (mPresentMask & bit(col)) != 0; }
+	// whether col should be written (components need not record the history of the columns that aren't)
+	bool wants(ReportColumn col) const { return mRequested.has(col); }
+	ReportColumnMask requested() const { return mRequested; }
+	// bit i is set if ReportColumn i is populated
+	uint64_t presentMask() const { return mPresentMask; }
+
+	Eigen::Index timesteps() const { return mTimesteps; }
+	Eigen::Index numPopulated() const { return mNumPopulated; }
+
+	/**
+	* The populated columns in the order they were first written, together with their column identifiers
+	*/
+	ConstMatrixView populated() const {
+		return ConstMatrixView(mData.data(), mTimesteps, mNumPopulated, Eigen::OuterStride<>(mStride));
+	}
+	std::vector<ReportColumn> populatedColumns() const {
+		std::vector<ReportColumn> columns(static_cast<size_t>(mNumPopulated));
+		for (size_t i = 0; i < NUM_REPORT_COLUMNS; i++) {
+			if (mSlots[i] >= 0) {
+				columns[static_cast<size_t>(mSlots[i])] = static_cast<ReportColumn>(i);
+			}
+		}
+		return columns;
+	}
+
+	// the heap memory in bytes held by the columns (including the padding of each column and any not yet shrunk away)
+	size_t ownedBytes() const {
+		return sizeof(float) * static_cast<size_t>(mData.size());
+	}
+
+	/**
+	* Release the space reserved for columns that were never populated
+	* and reorder the populated columns to match the ReportColumn order
+	*/
+	void shrinkToPopulated() {
+		Eigen::VectorXf packed(mStride * mNumPopulated);
+		int16_t next = 0;
+		for (size_t i = 0; i < NUM_REPORT_COLUMNS; i++) {
+			if (mSlots[i] >= 0) {
+				packed.segment(next * mStride, mStride) = mData.segment(mSlots[i] * mStride, mStride);
+				mSlots[i] = next++;
+			}
+		}
+		mData = std::move(packed);
+	}
+
+private:
+	static constexpr Eigen::Index ROW_ALIGNMENT = 16;
+
+	static size_t index(ReportColumn col) { return static_cast<size_t>(col); }
+	static uint64_t bit(ReportColumn col) { return uint64_t{ 1 } << index(col); }
+
+	void allocate(Eigen::Index timesteps) {
+		mTimesteps = timesteps;
+		mStride = (timesteps + ROW_ALIGNMENT - 1) / ROW_ALIGNMENT * ROW_ALIGNMENT;
+		// space for every requested column; shrinkToPopulated releases the columns that are not needed
+		mData = Eigen::VectorXf::Zero(mStride * static_cast<Eigen::Index>(mRequested.count()));
+	}
+
+	// every column, one after another, each padded to mStride floats
+	Eigen::VectorXf mData;
+	Eigen::Index mTimesteps = 0;
+	Eigen::Index mStride = 0;
+	int16_t mNumPopulated = 0;
+	// the position of each column within mData, or -1 if it is not populated
+	std::array<int16_t, NUM_REPORT_COLUMNS> mSlots = makeEmptySlots();
+	uint64_t mPresentMask = 0;
+	ReportColumnMask mRequested = ReportColumnMask::all();
+	// serialises the first write of each column while there is a SharedWrites
+	std::mutex* mSharedWrites = nullptr;
+
+	static constexpr std::array<int16_t, NUM_REPORT_COLUMNS> makeEmptySlots() {
+		std::array<int16_t, NUM_REPORT_COLUMNS> slots{};
+		slots.fill(-1);
+		return slots;
+	}
+};
+
+
 
 struct ScenarioComparison {
 	float meter_balance;
@@ -178,8 +496,55 @@ struct CapexBreakdown {
 };
 
 
+// The time in seconds spent in each phase of a scenario
+// These are only recorded when EPOCH is built with EPOCH_PHASE_TIMING
+struct PhaseTimings {
+	float validation = 0.0f;
+
+	// components before the balancing loop
+	float hotel = 0.0f;
+	float pv = 0.0f;
+	float ev = 0.0f;
+	float hot_water_cylinder = 0.0f;
+	float instant_water_heater = 0.0f;
+	float heat_pump = 0.0f;				// the AmbientHeatPumpController
+	float data_centre = 0.0f;			// constructing the DataCentre (it is stepped in the balancing loop)
+	float ess = 0.0f;					// constructing the ESS (it is stepped in the balancing loop)
+
+	float balancing_loop = 0.0f;
+
+	// components after the balancing loop
+	float gas_ch = 0.0f;
+	float post_balancing = 0.0f;		// the single pass of the Mop, Grid and a deferred instant water heater
+	float totals = 0.0f;				// the remaining reports from TempSum and the totals and reports of the ESS and DataCentre
+
+	// cost stages
+	float usage = 0.0f;					// also includes calculating the opex for the usage
+	float metrics = 0.0f;				// includes the npv
+	float npv = 0.0f;
+	float comparison = 0.0f;
+	float capex = 0.0f;					// evaluating the capex model once for the usage, npv and result
+};
+
+/**
+* Bounds on a scenario's results that can be checked before it is simulated
+* The capex only depends on the TaskData, so a scenario outside these bounds need not be simulated
+*/
+struct ScenarioConstraints {
+	std::optional<float> min_capex = std::nullopt;
+	std::optional<float> max_capex = std::nullopt;
+	// the most import or heat shortfall (in kWh over the timeseries) that a scenario may have
+	std::optional<float> max_electrical_shortfall = std::nullopt;
+	std::optional<float> max_heat_shortfall = std::nullopt;
+
+	bool empty() const { return !min_capex && !max_capex && !limitsShortfall(); }
+	bool limitsShortfall() const { return max_electrical_shortfall || max_heat_shortfall; }
+};
+
 struct SimulationResult {
 	float runtime;
+	// a breakdown of the runtime, if phase timing is enabled
+	std::optional<PhaseTimings> timings;
 
 	ScenarioComparison comparison;
 	SimulationMetrics metrics;
@@ -187,23 +552,56 @@ struct SimulationResult {
 	CapexBreakdown scenario_capex_breakdown;
 
 	std::optional<ReportData> report_data;
-	std::optional<ReportData> baseline_report_data;
+	// the baseline is the same for every scenario, so every result shares the Simulator's copy
+	std::shared_ptr<const ReportData> baseline_report_data;
+
+	// true if the scenario was not (fully) simulated because it is outside the ScenarioConstraints
+	bool violates_constraints = false;
+	// true if the scenario was not simulated because its batch was cancelled or passed its deadline (see BatchControl)
+	bool cancelled = false;
+	// true if the scenario was stopped before the end of the timeseries because it exceeds a shortfall constraint
+	// (it also violates_constraints, and its shortfall metrics are a lower bound on the shortfall of the whole timeseries)
+	bool terminated_early = false;
+
+	/**
+	* An estimate of the memory in bytes held by this result, optionally without its report data
+	* The baseline report data is not counted, as it belongs to the Simulator
+	*/
+	size_t memoryFootprint(bool includeReportData = true) const {
+		size_t bytes = sizeof(SimulationResult);
+		if (includeReportData && report_data) {
+			bytes += report_data->ownedBytes();
+		}
+		return bytes;
+	}
 };
 
-// A struct containing all of the necessary vectors for cost calculations
-// bridging from V7 to V8
-struct CostVectors {
-	year_TS actual_ev_load_e;
-	year_TS actual_data_centre_load_e;
-	year_TS building_load_e;
+// The totals over every timestep that are needed to calculate the metrics and usage for a scenario
+// Each component adds its own totals, so a ResultOnly simulation never has to build a ReportData
+struct SimulationTotals {
+	float gas_import_h = 0.0f;
+
+	float grid_import_e = 0.0f;
+	float grid_import_cost = 0.0f;		// grid import dot the import tariff
+	float grid_import_co2_g = 0.0f;		// grid import dot the grid carbon intensity
+	float grid_export_e = 0.0f;
+	float grid_export_revenue = 0.0f;	// grid export dot the export price
+	float grid_export_co2_g = 0.0f;		// grid export dot the grid carbon intensity
+
+	float pv_generation_e = 0.0f;
+
+	float import_shortfall_e = 0.0f;
+	float curtailed_export_e = 0.0f;
+	float heat_shortfall_h = 0.0f;
+	float ch_shortfall_h = 0.0f;
+	float dhw_shortfall_h = 0.0f;
 
-	year_TS heatload_h;
-	year_TS gas_import_h;
+	float ch_demand_h = 0.0f;
+	float dhw_demand_h = 0.0f;
 
-	year_TS grid_import_e;
-	year_TS grid_export_e;
-	year_TS actual_low_priority_load_e;
-	year_TS grid_export_prices;
+	float ev_load_e = 0.0f;
+	float data_centre_load_e = 0.0f;
+	float low_priority_load_e = 0.0f;
 };
 
 
@@ -231,6 +629,26 @@ inline ObjectiveResult toObjectiveResult(const SimulationResult& simResult, cons
 	};
 }
 
+/**
+* Optimistic bounds on the objectives of a scenario, found without running its balancing loop (see Simulator::boundObjectives)
+* No simulation of the scenario does better: its costs are at least, and its balances at most, these values.
+*/
+struct ObjectiveBounds {
+	// these are exact, as they don't depend on the timesteps
+	float total_capex;
+	float total_annualised_cost;
+
+	float cost_balance;
+	float operating_balance;
+	float combined_carbon_balance;
+	// the soonest the scenario could pay back, or infinity if its operating balance can't be positive
+	// (objectiveCostBound also allows for the negative payback horizons of scenarios that never pay back)
+	float payback_horizon_years;
+
+	// the scenario is invalid, so each bound is the objective of an invalid result
+	bool invalid = false;
+};
+
 
 struct OutputValues {
 	float maxVal;
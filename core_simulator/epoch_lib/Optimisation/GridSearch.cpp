@@ -0,0 +1,282 @@
+#include "GridSearch.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <format>
+#include <limits>
+#include <map>
+#include <set>
+#include <stdexcept>
+
+#include "../Simulation/Costs/Capex.hpp"
+#include "../io/FileHandling.hpp"
+
+namespace {
+	// a component with more combinations than this isn't enumerated, so doesn't bound the capex
+	constexpr uint64_t MAX_COMPONENT_COMBINATIONS = 1 << 16;
+
+	// the bounds and the exact capex use differently compiled cost models, so the bounds are given a little slack
+	bool exceeds(double bound, float limit) {
+		return bound > limit + 1e-4 * std::max(1.0, std::abs(static_cast<double>(limit)));
+	}
+
+	std::string componentOf(const std::string& geneName) {
+		return geneName.substr(0, geneName.find('.'));
+	}
+
+	struct Ranked {
+		double cost;
+		uint64_t index;
+		ObjectiveResult result;
+	};
+
+	// the heap's front is its worst member, with ties broken by the position in the grid
+	bool betterThan(const Ranked& a, const Ranked& b) {
+		return a.cost < b.cost || (a.cost == b.cost && a.index < b.index);
+	}
+}
+
+GridSearch::GridSearch(const Simulator& simulator, const std::string& siteRangeJson) :
+	mSimulator(simulator),
+	mCodec(siteRangeJson),
+	mGeneSizes(mCodec.geneSizes()),
+	mStrides(mGeneSizes.size()),
+	mNumScenarios(1)
+{
+	for (size_t g = mGeneSizes.size(); g-- > 0;) {
+		mStrides[g] = mNumScenarios;
+		if (mNumScenarios > std::numeric_limits<uint64_t>::max() / mGeneSizes[g]) {
+			throw std::runtime_error("The site range has too many scenarios to search");
+		}
+		mNumScenarios *= mGeneSizes[g];
+	}
+
+	// the codec adds the genes of each component together
+	const auto names = mCodec.geneNames();
+	for (size_t g = 0; g < names.size(); g++) {
+		if (g == 0 || componentOf(names[g]) != componentOf(names[g - 1])) {
+			mBlocks.push_back({ g, g + 1, 0, 0.0 });
+		}
+		else {
+			mBlocks.back().endGene = g + 1;
+		}
+	}
+
+	// every other delta is measured from the scenario with the first value of every gene
+	const TaskData base = mCodec.decode(std::vector<double>(mGeneSizes.size(), 0.0));
+	const auto baseCapex = rawCapex(base);
+	mBaseCapex = baseCapex.value_or(0.0);
+
+	for (auto& block : mBlocks) {
+		block.blockSize = mStrides[block.endGene - 1];
+
+		uint64_t combinations = 1;
+		for (size_t g = block.firstGene; g < block.endGene && combinations <= MAX_COMPONENT_COMBINATIONS; g++) {
+			combinations *= mGeneSizes[g];
+		}
+
+		block.minDelta = -std::numeric_limits<double>::infinity();
+		if (!baseCapex || combinations > MAX_COMPONENT_COMBINATIONS) {
+			continue;
+		}
+
+		// vary only this component's genes; the combinations that aren't valid for the site are never simulated
+		double minDelta = std::numeric_limits<double>::infinity();
+		std::vector<double> genes(mGeneSizes.size(), 0.0);
+		for (uint64_t c = 0; c < combinations; c++) {
+			uint64_t rest = c;
+			for (size_t g = block.endGene; g-- > block.firstGene;) {
+				genes[g] = static_cast<double>(rest % mGeneSizes[g]);
+				rest /= mGeneSizes[g];
+			}
+			if (auto capex = rawCapex(mCodec.decode(genes))) {
+				minDelta = std::min(minDelta, *capex - mBaseCapex);
+			}
+		}
+		if (std::isfinite(minDelta)) {
+			block.minDelta = minDelta;
+		}
+	}
+
+	mTrailingMinDelta.assign(mBlocks.size() + 1, 0.0);
+	for (size_t b = mBlocks.size(); b-- > 0;) {
+		mTrailingMinDelta[b] = mTrailingMinDelta[b + 1] + mBlocks[b].minDelta;
+	}
+}
+
+std::vector<double> GridSearch::chromosome(uint64_t index) const {
+	if (index >= mNumScenarios) {
+		throw std::runtime_error(std::format("Scenario {} is outside a grid of {} scenarios", index, mNumScenarios));
+	}
+	std::vector<double> genes(mGeneSizes.size());
+	for (size_t g = 0; g < mGeneSizes.size(); g++) {
+		genes[g] = static_cast<double>((index / mStrides[g]) % mGeneSizes[g]);
+	}
+	return genes;
+}
+
+TaskData GridSearch::scenario(uint64_t index) const {
+	return mCodec.decode(chromosome(index));
+}
+
+std::optional<double> GridSearch::rawCapex(const TaskData& taskData) const {
+	try {
+		mSimulator.validateScenario(taskData);
+	}
+	catch (const std::exception&) {
+		return std::nullopt;
+	}
+	return calculate_capex(*mSimulator.getSiteData(), taskData, mSimulator.getConfig().capex_model).total_capex;
+}
+
+double GridSearch::capexLowerBound(uint64_t index, size_t block) const {
+	std::vector<double> genes = chromosome(index);
+	std::fill(genes.begin() + static_cast<std::ptrdiff_t>(mBlocks[block].endGene), genes.end(), 0.0);
+
+	const auto leading = rawCapex(mCodec.decode(genes));
+	if (!leading) {
+		return -std::numeric_limits<double>::infinity();
+	}
+	double bound = *leading + mTrailingMinDelta[block + 1];
+
+	// the funding can only reduce the capex by so much
+	const TaskConfig& config = mSimulator.getConfig();
+	if (config.use_boiler_upgrade_scheme) {
+		bound -= config.capex_model.max_boiler_upgrade_scheme_funding;
+	}
+	if (config.general_grant_funding > 0) {
+		bound = std::max(0.0, bound - config.general_grant_funding);
+	}
+	return bound;
+}
+
+GridSearchResult GridSearch::run(const GridSearchOptions& options, ThreadPool& pool) const {
+	if (options.batch_size == 0) {
+		throw std::runtime_error("The batch size of a grid search must be positive");
+	}
+	const auto start = std::chrono::high_resolution_clock::now();
+
+	GridSearchResult result;
+	result.num_scenarios = mNumScenarios;
+
+	std::vector<std::vector<Ranked>> best(ALL_OBJECTIVES.size());
+	ParetoArchive archive(ALL_OBJECTIVES.size());
+	std::map<uint64_t, ObjectiveResult> paretoMembers;
+
+	if (options.results_csv) {
+		// just the header
+		writeResultsToCSV(*options.results_csv, {});
+	}
+
+	std::vector<TaskData> batch;
+	std::vector<uint64_t> indices;
+	batch.reserve(options.batch_size);
+	indices.reserve(options.batch_size);
+
+	auto simulateBatch = [&]() {
+		const auto results = mSimulator.simulateBatch(batch, SimulationType::ResultOnly, pool);
+		std::vector<ObjectiveResult> rows;
+		std::vector<double> costs(ALL_OBJECTIVES.size());
+
+		for (size_t i = 0; i < results.size(); i++) {
+			ObjectiveResult objectives = toObjectiveResult(results[i], batch[i]);
+			for (size_t j = 0; j < ALL_OBJECTIVES.size(); j++) {
+				costs[j] = objectiveCost(results[i], ALL_OBJECTIVES[j]);
+
+				auto& heap = best[j];
+				Ranked candidate{ costs[j], indices[i], objectives };
+				if (heap.size() < options.top_k) {
+					heap.push_back(std::move(candidate));
+					std::push_heap(heap.begin(), heap.end(), betterThan);
+				}
+				else if (!heap.empty() && betterThan(candidate, heap.front())) {
+					std::pop_heap(heap.begin(), heap.end(), betterThan);
+					heap.back() = std::move(candidate);
+					std::push_heap(heap.begin(), heap.end(), betterThan);
+				}
+			}
+
+			if (archive.insert(costs, static_cast<size_t>(indices[i]))) {
+				paretoMembers.emplace(indices[i], objectives);
+			}
+			if (options.results_csv) {
+				rows.push_back(std::move(objectives));
+			}
+		}
+
+		// drop the members that this batch has dominated
+		const std::set<size_t> ids(archive.ids().begin(), archive.ids().end());
+		std::erase_if(paretoMembers, [&ids](const auto& member) { return !ids.contains(static_cast<size_t>(member.first)); });
+
+		if (options.results_csv) {
+			appendResultToCSV(*options.results_csv, rows);
+		}
+		result.simulated += batch.size();
+		batch.clear();
+		indices.clear();
+	};
+
+	// the last block whose bound was checked and found to be within the limit, for each component
+	std::vector<uint64_t> checkedBlock(mBlocks.size(), std::numeric_limits<uint64_t>::max());
+
+	uint64_t index = 0;
+	while (index < mNumScenarios) {
+		if (options.max_capex) {
+			// the last component's block is a single scenario, which is checked exactly below
+			bool pruned = false;
+			for (size_t b = 0; b + 1 < mBlocks.size() && !pruned; b++) {
+				const uint64_t blockSize = mBlocks[b].blockSize;
+				const uint64_t block = index / blockSize;
+				if (checkedBlock[b] == block) {
+					continue;
+				}
+				if (exceeds(capexLowerBound(index, b), *options.max_capex)) {
+					const uint64_t next = (block + 1) * blockSize;
+					result.pruned += next - index;
+					index = next;
+					pruned = true;
+				}
+				else {
+					checkedBlock[b] = block;
+				}
+			}
+			if (pruned) {
+				continue;
+			}
+		}
+
+		TaskData taskData = scenario(index);
+		if (options.max_capex && rawCapex(taskData)
+			&& mSimulator.calculateCapexWithDiscounts(taskData).total_capex > *options.max_capex) {
+			result.pruned++;
+			index++;
+			continue;
+		}
+
+		batch.push_back(std::move(taskData));
+		indices.push_back(index);
+		index++;
+		if (batch.size() == options.batch_size) {
+			simulateBatch();
+		}
+	}
+	if (!batch.empty()) {
+		simulateBatch();
+	}
+
+	for (auto& heap : best) {
+		std::sort_heap(heap.begin(), heap.end(), betterThan);
+		auto& entries = result.best.emplace_back();
+		for (auto& ranked : heap) {
+			entries.push_back({ ranked.index, std::move(ranked.result) });
+		}
+	}
+	for (auto& [scenarioIndex, objectives] : paretoMembers) {
+		result.pareto.push_back({ scenarioIndex, std::move(objectives) });
+	}
+
+	std::chrono::duration<float> elapsed = std::chrono::high_resolution_clock::now() - start;
+	result.time_taken = elapsed.count();
+	return result;
+}
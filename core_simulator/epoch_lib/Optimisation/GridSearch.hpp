@@ -0,0 +1,103 @@
+#pragma once
+// exhaustive search of every scenario in a site range
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "../Definitions.hpp"
+#include "../Simulation/Simulate.hpp"
+#include "../Simulation/ThreadPool.hpp"
+#include "../io/ScenarioCodec.hpp"
+#include "Pareto.hpp"
+
+struct GridSearchOptions {
+	// the number of best scenarios to keep for each objective
+	size_t top_k = 10;
+	// skip every scenario whose capex (after funding) is above this
+	std::optional<float> max_capex;
+	// the number of scenarios decoded and simulated together
+	size_t batch_size = 4096;
+	// when set, every simulated scenario is appended to this CSV as its batch completes
+	std::optional<std::filesystem::path> results_csv;
+};
+
+struct GridSearchEntry {
+	// the scenario's position in the grid (see GridSearch::scenario)
+	uint64_t scenario_index;
+	ObjectiveResult result;
+};
+
+struct GridSearchResult {
+	// the size of the grid
+	uint64_t num_scenarios = 0;
+	uint64_t simulated = 0;
+	// the scenarios that were skipped because their capex is (or is bounded to be) above max_capex
+	uint64_t pruned = 0;
+
+	// the best top_k scenarios for each of ALL_OBJECTIVES, best first
+	std::vector<std::vector<GridSearchEntry>> best;
+	// the simulated scenarios that are not dominated in ALL_OBJECTIVES, in grid order
+	// (of the scenarios with identical objectives, only the first is kept)
+	std::vector<GridSearchEntry> pareto;
+
+	float time_taken = 0.0f;
+};
+
+/**
+* Simulate every combination of the values in a site range (see ScenarioCodec)
+*
+* The grid is the Cartesian product of the codec's genes, with the first gene varying slowest.
+* Scenarios are decoded lazily a batch at a time and simulated with simulateBatch,
+* so only the top_k for each objective and the Pareto set are held in memory.
+*
+* With a max_capex, whole blocks of the grid are pruned without being decoded.
+* The capex before funding is a sum over the components, so once the genes of the leading components are chosen
+* the cheapest completion of the trailing components bounds the capex of every scenario in the block.
+*/
+class GridSearch {
+public:
+	GridSearch(const Simulator& simulator, const std::string& siteRangeJson);
+
+	uint64_t numScenarios() const { return mNumScenarios; }
+
+	const ScenarioCodec& getCodec() const { return mCodec; }
+
+	// the scenario at an index of the grid
+	TaskData scenario(uint64_t index) const;
+
+	GridSearchResult run(const GridSearchOptions& options, ThreadPool& pool = ThreadPool::shared()) const;
+
+private:
+	// the genes of a component, which end a block of the grid
+	struct ComponentBlock {
+		size_t firstGene;
+		size_t endGene;
+		// the number of scenarios in the grid with the genes up to endGene fixed
+		uint64_t blockSize;
+		// the lowest change in capex that this component's genes can make from its first values (-inf if unbounded)
+		double minDelta;
+	};
+
+	std::vector<double> chromosome(uint64_t index) const;
+
+	// the capex before funding, or nullopt if the scenario is not valid for the site
+	std::optional<double> rawCapex(const TaskData& taskData) const;
+
+	// a lower bound of the capex after funding of every scenario in the block of the grid containing index
+	double capexLowerBound(uint64_t index, size_t block) const;
+
+	const Simulator& mSimulator;
+	ScenarioCodec mCodec;
+	std::vector<size_t> mGeneSizes;
+	// the number of scenarios spanned by one step of each gene
+	std::vector<uint64_t> mStrides;
+	uint64_t mNumScenarios;
+
+	std::vector<ComponentBlock> mBlocks;
+	// the sum of minDelta over the blocks from each block to the last
+	std::vector<double> mTrailingMinDelta;
+	double mBaseCapex;
+};
@@ -0,0 +1,409 @@
+#include "NSGA2.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <format>
+#include <numeric>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <string>
+
+namespace {
+	using Rng = std::mt19937_64;
+
+	// as in pymoo, the number of rounds of mating (or sampling) to try to find enough chromosomes that aren't duplicates
+	constexpr size_t MAX_MATING_ROUNDS = 100;
+
+	const std::string PRESENCE_SUFFIX = ".COMPONENT_IS_MANDATORY";
+
+	double objectiveValue(const SimulationResult& result, Objective objective) {
+		// objectiveCost negates the objectives that are maximised
+		const double cost = objectiveCost(result, objective);
+		return objective == Objective::CostBalance || objective == Objective::CarbonBalance ? -cost : cost;
+	}
+
+	std::vector<double> rowOf(const Chromosomes& chromosomes, Eigen::Index row) {
+		return { chromosomes.row(row).data(), chromosomes.row(row).data() + chromosomes.cols() };
+	}
+
+	Chromosomes fromRows(const std::vector<std::vector<double>>& rows, Eigen::Index numGenes) {
+		Chromosomes chromosomes(static_cast<Eigen::Index>(rows.size()), numGenes);
+		for (size_t i = 0; i < rows.size(); i++) {
+			std::copy(rows[i].begin(), rows[i].end(), chromosomes.row(static_cast<Eigen::Index>(i)).data());
+		}
+		return chromosomes;
+	}
+
+	NSGA2Population select(const NSGA2Population& population, const std::vector<size_t>& rows) {
+		const auto n = static_cast<Eigen::Index>(rows.size());
+		NSGA2Population selected{
+			Chromosomes(n, population.chromosomes.cols()),
+			ObjectiveCosts(n, population.costs.cols()),
+			Eigen::VectorXd(n),
+			{}
+		};
+		selected.results.reserve(rows.size());
+		for (Eigen::Index i = 0; i < n; i++) {
+			const auto row = static_cast<Eigen::Index>(rows[static_cast<size_t>(i)]);
+			selected.chromosomes.row(i) = population.chromosomes.row(row);
+			selected.costs.row(i) = population.costs.row(row);
+			selected.violation[i] = population.violation[row];
+			selected.results.push_back(population.results[static_cast<size_t>(row)]);
+		}
+		return selected;
+	}
+
+	NSGA2Population concat(const NSGA2Population& a, const NSGA2Population& b) {
+		const Eigen::Index n = a.chromosomes.rows() + b.chromosomes.rows();
+		NSGA2Population merged{
+			Chromosomes(n, a.chromosomes.cols()),
+			ObjectiveCosts(n, a.costs.cols()),
+			Eigen::VectorXd(n),
+			a.results
+		};
+		merged.chromosomes << a.chromosomes, b.chromosomes;
+		merged.costs << a.costs, b.costs;
+		merged.violation << a.violation, b.violation;
+		merged.results.insert(merged.results.end(), b.results.begin(), b.results.end());
+		return merged;
+	}
+
+	std::vector<size_t> feasibleRows(const NSGA2Population& population) {
+		std::vector<size_t> feasible;
+		for (Eigen::Index i = 0; i < population.violation.size(); i++) {
+			if (population.violation[i] <= 0.0) {
+				feasible.push_back(static_cast<size_t>(i));
+			}
+		}
+		return feasible;
+	}
+
+	ObjectiveCosts costsOf(const NSGA2Population& population, const std::vector<size_t>& rows) {
+		ObjectiveCosts costs(static_cast<Eigen::Index>(rows.size()), population.costs.cols());
+		for (size_t i = 0; i < rows.size(); i++) {
+			costs.row(static_cast<Eigen::Index>(i)) = population.costs.row(static_cast<Eigen::Index>(rows[i]));
+		}
+		return costs;
+	}
+
+	// the feasible, non-dominated members of a population, in order
+	std::vector<size_t> firstFront(const NSGA2Population& population) {
+		const std::vector<size_t> feasible = feasibleRows(population);
+		if (feasible.empty()) {
+			return {};
+		}
+		std::vector<size_t> front = nonDominatedSort(costsOf(population, feasible)).front();
+		for (size_t& i : front) {
+			i = feasible[i];
+		}
+		std::sort(front.begin(), front.end());
+		return front;
+	}
+
+	// the measures the tournaments compare, for each member of the population
+	struct Ranking {
+		std::vector<double> crowding;
+	};
+
+	/**
+	* Choose the n survivors of a population: the feasible members front by front (breaking the last front by crowding distance),
+	* then the infeasible members in order of their constraint violation
+	*/
+	std::vector<size_t> survive(const NSGA2Population& population, size_t n, Ranking& ranking) {
+		std::vector<size_t> survivors;
+		ranking.crowding.clear();
+
+		const std::vector<size_t> feasible = feasibleRows(population);
+		if (!feasible.empty()) {
+			const ObjectiveCosts costs = costsOf(population, feasible);
+			for (const auto& front : nonDominatedSort(costs)) {
+				if (survivors.size() >= n) {
+					break;
+				}
+				const std::vector<double> distance = crowdingDistance(costs, front);
+
+				std::vector<size_t> order(front.size());
+				std::iota(order.begin(), order.end(), size_t{ 0 });
+				if (survivors.size() + front.size() > n) {
+					std::stable_sort(order.begin(), order.end(), [&distance](size_t a, size_t b) { return distance[a] > distance[b]; });
+					order.resize(n - survivors.size());
+				}
+				for (size_t i : order) {
+					survivors.push_back(feasible[front[i]]);
+					ranking.crowding.push_back(distance[i]);
+				}
+			}
+		}
+
+		if (survivors.size() < n) {
+			std::vector<size_t> infeasible;
+			for (Eigen::Index i = 0; i < population.violation.size(); i++) {
+				if (population.violation[i] > 0.0) {
+					infeasible.push_back(static_cast<size_t>(i));
+				}
+			}
+			std::stable_sort(infeasible.begin(), infeasible.end(), [&population](size_t a, size_t b) {
+				return population.violation[static_cast<Eigen::Index>(a)] < population.violation[static_cast<Eigen::Index>(b)];
+			});
+			for (size_t i = 0; i < infeasible.size() && survivors.size() < n; i++) {
+				survivors.push_back(infeasible[i]);
+				ranking.crowding.push_back(0.0);
+			}
+		}
+		return survivors;
+	}
+
+	// the less violating, then the dominating, then the less crowded of two members of the population
+	size_t tournament(const NSGA2Population& population, const Ranking& ranking, Rng& rng) {
+		std::uniform_int_distribution<size_t> pick(0, static_cast<size_t>(population.chromosomes.rows()) - 1);
+		const size_t a = pick(rng);
+		const size_t b = pick(rng);
+		const auto rowA = static_cast<Eigen::Index>(a);
+		const auto rowB = static_cast<Eigen::Index>(b);
+		const bool coin = std::bernoulli_distribution(0.5)(rng);
+
+		const double violationA = population.violation[rowA];
+		const double violationB = population.violation[rowB];
+		if (violationA > 0.0 || violationB > 0.0) {
+			if (violationA != violationB) {
+				return violationA < violationB ? a : b;
+			}
+			return coin ? a : b;
+		}
+
+		const auto costs = [&population](Eigen::Index row) {
+			return std::span<const double>(population.costs.row(row).data(), static_cast<size_t>(population.costs.cols()));
+		};
+		if (dominates(costs(rowA), costs(rowB))) {
+			return a;
+		}
+		if (dominates(costs(rowB), costs(rowA))) {
+			return b;
+		}
+		if (ranking.crowding[a] != ranking.crowding[b]) {
+			return ranking.crowding[a] > ranking.crowding[b] ? a : b;
+		}
+		return coin ? a : b;
+	}
+}
+
+NSGA2::NSGA2(const Simulator& simulator, const ScenarioCodec& codec, std::vector<Objective> objectives,
+	std::vector<MetricConstraint> constraints) :
+	mSimulator(simulator),
+	mCodec(codec),
+	mObjectives(std::move(objectives)),
+	mConstraints(std::move(constraints)),
+	mUpper(static_cast<Eigen::Index>(codec.numGenes()))
+{
+	if (mObjectives.empty()) {
+		throw std::runtime_error("NSGA-II needs at least one objective");
+	}
+
+	for (const auto& constraint : mConstraints) {
+		if (constraint.objective != Objective::CAPEX) {
+			continue;
+		}
+		if (constraint.min) {
+			mCapexConstraints.min_capex = static_cast<float>(mCapexConstraints.min_capex
+				? std::max(static_cast<double>(*mCapexConstraints.min_capex), *constraint.min) : *constraint.min);
+		}
+		if (constraint.max) {
+			mCapexConstraints.max_capex = static_cast<float>(mCapexConstraints.max_capex
+				? std::min(static_cast<double>(*mCapexConstraints.max_capex), *constraint.max) : *constraint.max);
+		}
+	}
+
+	const auto sizes = codec.geneSizes();
+	for (size_t g = 0; g < sizes.size(); g++) {
+		mUpper[static_cast<Eigen::Index>(g)] = static_cast<double>(sizes[g] - 1);
+	}
+
+	// a component's presence gene comes before its attributes
+	const auto names = codec.geneNames();
+	for (size_t g = 0; g < names.size(); g++) {
+		const std::string& name = names[g];
+		if (name.size() <= PRESENCE_SUFFIX.size() || !name.ends_with(PRESENCE_SUFFIX)) {
+			continue;
+		}
+		const std::string prefix = name.substr(0, name.size() - PRESENCE_SUFFIX.size()) + ".";
+		std::vector<size_t> attributes;
+		for (size_t a = g + 1; a < names.size() && names[a].starts_with(prefix); a++) {
+			attributes.push_back(a);
+		}
+		mPresenceGenes.emplace_back(g, std::move(attributes));
+	}
+}
+
+void NSGA2::repair(Eigen::Ref<Chromosomes> chromosomes) const {
+	if (chromosomes.cols() != mUpper.size()) {
+		throw std::runtime_error(std::format("Expected chromosomes of {} genes but got {}", mUpper.size(), chromosomes.cols()));
+	}
+	for (Eigen::Index row = 0; row < chromosomes.rows(); row++) {
+		auto genes = chromosomes.row(row);
+		genes = genes.array().round().max(0.0).min(mUpper.array());
+		for (const auto& [presence, attributes] : mPresenceGenes) {
+			if (genes[static_cast<Eigen::Index>(presence)] == 0.0) {
+				for (size_t a : attributes) {
+					genes[static_cast<Eigen::Index>(a)] = 0.0;
+				}
+			}
+		}
+	}
+}
+
+NSGA2Population NSGA2::evaluate(const Chromosomes& chromosomes, ThreadPool& pool) const {
+	NSGA2Population population;
+	population.chromosomes = chromosomes;
+	population.results = mSimulator.simulateBatch(mCodec.decode(chromosomes), SimulationType::ResultOnly, mCapexConstraints, pool);
+	population.costs = objectiveCosts(population.results, mObjectives);
+
+	population.violation = Eigen::VectorXd::Zero(chromosomes.rows());
+	for (size_t i = 0; i < population.results.size(); i++) {
+		double violation = 0.0;
+		for (const auto& constraint : mConstraints) {
+			const double value = objectiveValue(population.results[i], constraint.objective);
+			if (constraint.min) {
+				violation += std::max(0.0, *constraint.min - value);
+			}
+			if (constraint.max) {
+				violation += std::max(0.0, value - *constraint.max);
+			}
+		}
+		population.violation[static_cast<Eigen::Index>(i)] = violation;
+	}
+	return population;
+}
+
+NSGA2Result NSGA2::run(const NSGA2Options& options, const Chromosomes& seeds, const GenerationCallback& callback, ThreadPool& pool) const {
+	if (options.pop_size == 0 || options.n_offsprings == 0) {
+		throw std::runtime_error("NSGA-II needs a positive population size and number of offspring");
+	}
+	if (seeds.rows() > 0 && seeds.cols() != mUpper.size()) {
+		throw std::runtime_error(std::format("Expected seeds of {} genes but got {}", mUpper.size(), seeds.cols()));
+	}
+
+	Rng rng(options.seed ? *options.seed : std::random_device{}());
+	std::uniform_real_distribution<double> uniform(0.0, 1.0);
+	const Eigen::Index numGenes = mUpper.size();
+
+	// every chromosome that has been in the population, so that none is simulated twice
+	std::set<std::vector<double>> seen;
+
+	// the seeds, then uniformly sampled chromosomes
+	std::vector<std::vector<double>> initial;
+	Chromosomes repaired = seeds;
+	if (repaired.rows() > 0) {
+		repair(repaired);
+	}
+	for (Eigen::Index row = 0; row < repaired.rows(); row++) {
+		auto genes = rowOf(repaired, row);
+		if (seen.insert(genes).second) {
+			initial.push_back(std::move(genes));
+		}
+	}
+	if (initial.size() > options.pop_size) {
+		std::shuffle(initial.begin(), initial.end(), rng);
+		initial.resize(options.pop_size);
+	}
+
+	Chromosomes sample(1, numGenes);
+	for (size_t attempt = 0; initial.size() < options.pop_size && attempt < MAX_MATING_ROUNDS * options.pop_size; attempt++) {
+		for (Eigen::Index g = 0; g < numGenes; g++) {
+			sample(0, g) = static_cast<double>(std::uniform_int_distribution<size_t>(0, static_cast<size_t>(mUpper[g]))(rng));
+		}
+		repair(sample);
+		auto genes = rowOf(sample, 0);
+		if (seen.insert(genes).second) {
+			initial.push_back(std::move(genes));
+		}
+	}
+
+	NSGA2Result result;
+	NSGA2Population population = evaluate(fromRows(initial, numGenes), pool);
+	result.n_evals = static_cast<uint64_t>(population.chromosomes.rows());
+
+	Ranking ranking;
+	population = select(population, survive(population, static_cast<size_t>(population.chromosomes.rows()), ranking));
+	result.generations = 1;
+
+	bool keepGoing = !callback || callback(NSGA2Generation{ result.generations, result.n_evals, population, firstFront(population) });
+
+	const double mutateGene = numGenes > 0 ? std::min(0.5, 1.0 / static_cast<double>(numGenes)) : 0.0;
+	auto mutate = [&](std::vector<double>& genes) {
+		if (uniform(rng) >= options.prob_mutation) {
+			return;
+		}
+		for (Eigen::Index g = 0; g < numGenes; g++) {
+			if (mUpper[g] > 0.0 && uniform(rng) < mutateGene) {
+				std::normal_distribution<double> step(0.0, options.std_scaler * mUpper[g]);
+				genes[static_cast<size_t>(g)] = std::clamp(genes[static_cast<size_t>(g)] + step(rng), 0.0, mUpper[g]);
+			}
+		}
+	};
+
+	auto crossover = [&](std::vector<double>& a, std::vector<double>& b) {
+		if (numGenes < 2 || options.n_crossover == 0 || uniform(rng) >= options.prob_crossover) {
+			return;
+		}
+		// swap every other segment between distinct cut points
+		std::vector<size_t> cuts(static_cast<size_t>(numGenes) - 1);
+		std::iota(cuts.begin(), cuts.end(), size_t{ 1 });
+		std::shuffle(cuts.begin(), cuts.end(), rng);
+		cuts.resize(std::min(options.n_crossover, cuts.size()));
+		std::sort(cuts.begin(), cuts.end());
+		cuts.push_back(static_cast<size_t>(numGenes));
+
+		for (size_t c = 0; c + 1 < cuts.size(); c += 2) {
+			for (size_t g = cuts[c]; g < cuts[c + 1]; g++) {
+				std::swap(a[g], b[g]);
+			}
+		}
+	};
+
+	while (keepGoing && result.generations < options.n_max_gen && result.n_evals < options.n_max_evals) {
+		const size_t wanted = static_cast<size_t>(std::min<uint64_t>(options.n_offsprings, options.n_max_evals - result.n_evals));
+
+		std::vector<std::vector<double>> offspring;
+		Chromosomes child(1, numGenes);
+		for (size_t round = 0; offspring.size() < wanted && round < MAX_MATING_ROUNDS; round++) {
+			for (size_t made = 0; made < wanted && offspring.size() < wanted; made += 2) {
+				auto a = rowOf(population.chromosomes, static_cast<Eigen::Index>(tournament(population, ranking, rng)));
+				auto b = rowOf(population.chromosomes, static_cast<Eigen::Index>(tournament(population, ranking, rng)));
+				crossover(a, b);
+
+				for (auto* genes : { &a, &b }) {
+					mutate(*genes);
+					std::copy(genes->begin(), genes->end(), child.row(0).data());
+					repair(child);
+					auto repairedChild = rowOf(child, 0);
+					if (offspring.size() < wanted && seen.insert(repairedChild).second) {
+						offspring.push_back(std::move(repairedChild));
+					}
+				}
+			}
+		}
+		if (offspring.empty()) {
+			// every chromosome the operators can reach has already been simulated
+			break;
+		}
+
+		NSGA2Population children = evaluate(fromRows(offspring, numGenes), pool);
+		result.n_evals += static_cast<uint64_t>(children.chromosomes.rows());
+
+		NSGA2Population merged = concat(population, children);
+		population = select(merged, survive(merged, options.pop_size, ranking));
+		result.generations++;
+
+		keepGoing = !callback || callback(NSGA2Generation{ result.generations, result.n_evals, population, firstFront(population) });
+	}
+
+	std::vector<size_t> optimal = firstFront(population);
+	if (optimal.empty() && options.return_least_infeasible && population.violation.size() > 0) {
+		Eigen::Index least = 0;
+		population.violation.minCoeff(&least);
+		optimal.push_back(static_cast<size_t>(least));
+	}
+	result.optimal = select(population, optimal);
+	return result;
+}
@@ -0,0 +1,116 @@
+#pragma once
+// the NSGA-II genetic algorithm, evaluating each generation with simulateBatch
+
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <vector>
+
+#include <Eigen/Core>
+
+#include "../Definitions.hpp"
+#include "../Simulation/Simulate.hpp"
+#include "../Simulation/ThreadPool.hpp"
+#include "../io/ScenarioCodec.hpp"
+#include "Pareto.hpp"
+
+/**
+* A bound on the value of an objective, in its own units (so the cost and carbon balances are not negated)
+*/
+struct MetricConstraint {
+	Objective objective;
+	std::optional<double> min;
+	std::optional<double> max;
+};
+
+/**
+* The hyperparameters, with the defaults of the optimisation service's NSGA2
+*/
+struct NSGA2Options {
+	size_t pop_size = 256;
+	size_t n_offsprings = 128;
+	// the probability of crossing over a pair of parents, and the number of points to cross over at
+	double prob_crossover = 0.2;
+	size_t n_crossover = 2;
+	// the probability of mutating each child, and the standard deviation of a mutation as a fraction of each gene's range
+	double prob_mutation = 0.8;
+	double std_scaler = 1.0;
+	size_t n_max_gen = 1000;
+	uint64_t n_max_evals = std::numeric_limits<uint64_t>::max();
+	// return the least infeasible individual when none is feasible
+	bool return_least_infeasible = true;
+	// seed the random number generator, for a reproducible run
+	std::optional<uint64_t> seed;
+};
+
+/**
+* A population of chromosomes with their objective costs (to minimise, see objectiveCost) and constraint violations
+*/
+struct NSGA2Population {
+	Chromosomes chromosomes;
+	ObjectiveCosts costs;
+	// the sum of the amounts by which each constraint is exceeded (0 if feasible)
+	Eigen::VectorXd violation;
+	std::vector<SimulationResult> results;
+};
+
+struct NSGA2Generation {
+	// the first generation is the initial population
+	size_t generation;
+	uint64_t n_evals;
+	const NSGA2Population& population;
+	// the feasible, non-dominated members of the population
+	std::vector<size_t> front;
+};
+
+// called after each generation; return false to stop
+using GenerationCallback = std::function<bool(const NSGA2Generation&)>;
+
+struct NSGA2Result {
+	// the feasible, non-dominated individuals of the final population (or the least infeasible)
+	NSGA2Population optimal;
+	size_t generations = 0;
+	uint64_t n_evals = 0;
+};
+
+/**
+* NSGA-II on the genes of a ScenarioCodec, following the optimisation service's pymoo configuration:
+* binary tournaments on constraint violation, dominance and crowding distance, n-point crossover,
+* Gaussian mutation and the rounding and degenerate repair, with duplicates eliminated.
+*
+* Each generation's offspring are decoded and simulated together with simulateBatch.
+* A capex constraint is passed on as ScenarioConstraints, so scenarios that violate it are not simulated.
+*/
+class NSGA2 {
+public:
+	NSGA2(const Simulator& simulator, const ScenarioCodec& codec, std::vector<Objective> objectives,
+		std::vector<MetricConstraint> constraints = {});
+
+	/**
+	* Run the algorithm until n_max_gen or n_max_evals is reached, or the callback asks it to stop
+	* The initial population is the seeds (such as those from the heuristics), filled up with uniformly sampled chromosomes
+	*/
+	NSGA2Result run(const NSGA2Options& options, const Chromosomes& seeds = Chromosomes{},
+		const GenerationCallback& callback = {}, ThreadPool& pool = ThreadPool::shared()) const;
+
+	/**
+	* Round each gene to the nearest of its values and set every attribute of an absent component to its first value
+	* (an absent component is the same scenario whatever its attributes)
+	*/
+	void repair(Eigen::Ref<Chromosomes> chromosomes) const;
+
+	NSGA2Population evaluate(const Chromosomes& chromosomes, ThreadPool& pool = ThreadPool::shared()) const;
+
+private:
+	const Simulator& mSimulator;
+	const ScenarioCodec& mCodec;
+	std::vector<Objective> mObjectives;
+	std::vector<MetricConstraint> mConstraints;
+	ScenarioConstraints mCapexConstraints;
+
+	// the largest index of each gene
+	Eigen::RowVectorXd mUpper;
+	// the attribute genes that each presence gene makes degenerate
+	std::vector<std::pair<size_t, std::vector<size_t>>> mPresenceGenes;
+};
@@ -0,0 +1,235 @@
+#include "Pareto.hpp"
+
+#include <algorithm>
+#include <format>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+namespace {
+	std::span<const double> rowOf(const Eigen::Ref<const ObjectiveCosts>& costs, Eigen::Index row) {
+		return { costs.row(row).data(), static_cast<size_t>(costs.cols()) };
+	}
+}
+
+double objectiveCost(const SimulationResult& result, Objective objective) {
+	switch (objective) {
+	case Objective::CAPEX:
+		return result.metrics.total_capex;
+	case Objective::AnnualisedCost:
+		return result.metrics.total_annualised_cost;
+	case Objective::PaybackHorizon:
+		return result.comparison.payback_horizon_years;
+	case Objective::CostBalance:
+		return -static_cast<double>(result.comparison.cost_balance);
+	case Objective::CarbonBalance:
+		return -static_cast<double>(result.comparison.combined_carbon_balance);
+	default:
+		throw std::runtime_error("Unknown objective");
+	}
+}
+
+double objectiveCostBound(const ObjectiveBounds& bounds, Objective objective) {
+	switch (objective) {
+	case Objective::CAPEX:
+		return bounds.total_capex;
+	case Objective::AnnualisedCost:
+		return bounds.total_annualised_cost;
+	case Objective::PaybackHorizon:
+		if (bounds.invalid || bounds.total_capex <= 0.0f) {
+			// (which is exact)
+			return bounds.payback_horizon_years;
+		}
+		if (bounds.operating_balance < 0.0f) {
+			// the operating balance is at most this, so the horizon is at least the capex over it (as calculate_payback_horizon)
+			return bounds.total_capex / bounds.operating_balance;
+		}
+		return -std::numeric_limits<double>::infinity();
+	case Objective::CostBalance:
+		return -static_cast<double>(bounds.cost_balance);
+	case Objective::CarbonBalance:
+		return -static_cast<double>(bounds.combined_carbon_balance);
+	default:
+		throw std::runtime_error("Unknown objective");
+	}
+}
+
+ObjectiveCosts objectiveCosts(std::span<const SimulationResult> results, std::span<const Objective> objectives) {
+	ObjectiveCosts costs(static_cast<Eigen::Index>(results.size()), static_cast<Eigen::Index>(objectives.size()));
+	for (size_t i = 0; i < results.size(); i++) {
+		for (size_t j = 0; j < objectives.size(); j++) {
+			costs(static_cast<Eigen::Index>(i), static_cast<Eigen::Index>(j)) = objectiveCost(results[i], objectives[j]);
+		}
+	}
+	return costs;
+}
+
+bool dominates(std::span<const double> a, std::span<const double> b) {
+	bool better = false;
+	for (size_t j = 0; j < a.size(); j++) {
+		if (a[j] > b[j]) {
+			return false;
+		}
+		better = better || a[j] < b[j];
+	}
+	return better;
+}
+
+std::vector<std::vector<size_t>> nonDominatedSort(const Eigen::Ref<const ObjectiveCosts>& costs) {
+	const auto n = static_cast<size_t>(costs.rows());
+
+	std::vector<size_t> order(n);
+	std::iota(order.begin(), order.end(), size_t{ 0 });
+	std::sort(order.begin(), order.end(), [&costs](size_t a, size_t b) {
+		auto rowA = rowOf(costs, static_cast<Eigen::Index>(a));
+		auto rowB = rowOf(costs, static_cast<Eigen::Index>(b));
+		return std::lexicographical_compare(rowA.begin(), rowA.end(), rowB.begin(), rowB.end());
+	});
+
+	std::vector<std::vector<size_t>> fronts;
+
+	auto dominatedBy = [&costs](const std::vector<size_t>& front, size_t candidate) {
+		auto row = rowOf(costs, static_cast<Eigen::Index>(candidate));
+		// the most recently added members are the most similar to the candidate
+		return std::any_of(front.rbegin(), front.rend(), [&](size_t member) {
+			return dominates(rowOf(costs, static_cast<Eigen::Index>(member)), row);
+		});
+	};
+
+	for (size_t candidate : order) {
+		// if a member of front k dominates the candidate then so does a member of every earlier front
+		size_t low = 0;
+		size_t high = fronts.size();
+		while (low < high) {
+			size_t mid = low + (high - low) / 2;
+			if (dominatedBy(fronts[mid], candidate)) {
+				low = mid + 1;
+			}
+			else {
+				high = mid;
+			}
+		}
+
+		if (low == fronts.size()) {
+			fronts.emplace_back();
+		}
+		fronts[low].push_back(candidate);
+	}
+
+	for (auto& front : fronts) {
+		std::sort(front.begin(), front.end());
+	}
+	return fronts;
+}
+
+std::vector<double> crowdingDistance(const Eigen::Ref<const ObjectiveCosts>& costs, std::span<const size_t> front) {
+	const size_t n = front.size();
+	std::vector<double> distance(n, 0.0);
+	if (n <= 2) {
+		std::fill(distance.begin(), distance.end(), std::numeric_limits<double>::infinity());
+		return distance;
+	}
+
+	std::vector<size_t> order(n);
+	for (Eigen::Index j = 0; j < costs.cols(); j++) {
+		std::iota(order.begin(), order.end(), size_t{ 0 });
+		std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+			return costs(static_cast<Eigen::Index>(front[a]), j) < costs(static_cast<Eigen::Index>(front[b]), j);
+		});
+
+		auto value = [&](size_t i) { return costs(static_cast<Eigen::Index>(front[order[i]]), j); };
+
+		distance[order.front()] = std::numeric_limits<double>::infinity();
+		distance[order.back()] = std::numeric_limits<double>::infinity();
+
+		double range = value(n - 1) - value(0);
+		if (range <= 0.0) {
+			continue;
+		}
+		for (size_t i = 1; i + 1 < n; i++) {
+			distance[order[i]] += (value(i + 1) - value(i - 1)) / range;
+		}
+	}
+	return distance;
+}
+
+ParetoArchive::ParetoArchive(size_t numObjectives, bool distinct) :
+	mNumObjectives(numObjectives),
+	mDistinct(distinct)
+{
+	if (numObjectives == 0) {
+		throw std::runtime_error("A ParetoArchive needs at least one objective");
+	}
+}
+
+std::span<const double> ParetoArchive::member(size_t i) const {
+	return { mCosts.data() + i * mNumObjectives, mNumObjectives };
+}
+
+bool ParetoArchive::insert(std::span<const double> costs, size_t id) {
+	if (costs.size() != mNumObjectives) {
+		throw std::runtime_error(std::format("Expected {} objectives but got {}", mNumObjectives, costs.size()));
+	}
+
+	for (size_t i = 0; i < mIds.size(); i++) {
+		auto existing = member(i);
+		if (dominates(existing, costs) || (mDistinct && std::equal(existing.begin(), existing.end(), costs.begin()))) {
+			return false;
+		}
+	}
+
+	// remove the dominated members, compacting the remainder in place
+	size_t kept = 0;
+	for (size_t i = 0; i < mIds.size(); i++) {
+		if (dominates(costs, member(i))) {
+			continue;
+		}
+		if (kept != i) {
+			mIds[kept] = mIds[i];
+			std::copy_n(mCosts.begin() + static_cast<std::ptrdiff_t>(i * mNumObjectives), mNumObjectives,
+				mCosts.begin() + static_cast<std::ptrdiff_t>(kept * mNumObjectives));
+		}
+		kept++;
+	}
+	mIds.resize(kept);
+	mCosts.resize(kept * mNumObjectives);
+
+	mIds.push_back(id);
+	mCosts.insert(mCosts.end(), costs.begin(), costs.end());
+	return true;
+}
+
+bool ParetoArchive::excludes(std::span<const double> bound) const {
+	if (bound.size() != mNumObjectives) {
+		throw std::runtime_error(std::format("Expected {} objectives but got {}", mNumObjectives, bound.size()));
+	}
+	// a member that dominates the bound dominates every such candidate, and an identical member
+	// dominates them other than those identical to it, which are rejected when distinct
+	for (size_t i = 0; i < mIds.size(); i++) {
+		auto existing = member(i);
+		if (dominates(existing, bound) || (mDistinct && std::equal(existing.begin(), existing.end(), bound.begin()))) {
+			return true;
+		}
+	}
+	return false;
+}
+
+std::vector<bool> ParetoArchive::insert(const Eigen::Ref<const ObjectiveCosts>& costs, size_t firstId) {
+	std::vector<bool> added;
+	added.reserve(static_cast<size_t>(costs.rows()));
+	for (Eigen::Index row = 0; row < costs.rows(); row++) {
+		added.push_back(insert(rowOf(costs, row), firstId + static_cast<size_t>(row)));
+	}
+	return added;
+}
+
+ObjectiveCosts ParetoArchive::costs() const {
+	ObjectiveCosts costs(static_cast<Eigen::Index>(mIds.size()), static_cast<Eigen::Index>(mNumObjectives));
+	std::copy(mCosts.begin(), mCosts.end(), costs.data());
+	return costs;
+}
+
+void ParetoArchive::clear() {
+	mIds.clear();
+	mCosts.clear();
+}
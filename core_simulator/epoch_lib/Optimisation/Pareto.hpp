@@ -0,0 +1,92 @@
+#pragma once
+// non-dominated sorting and maintenance of a Pareto front
+
+#include <Eigen/Core>
+#include <array>
+#include <span>
+#include <vector>
+
+#include "../Definitions.hpp"
+
+// objective values to minimise, one row per candidate and one column per objective
+using ObjectiveCosts = Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+
+constexpr std::array<Objective, 5> ALL_OBJECTIVES = {
+	Objective::CAPEX, Objective::AnnualisedCost, Objective::PaybackHorizon, Objective::CostBalance, Objective::CarbonBalance
+};
+
+/**
+* The value of an objective, negated if it is to be maximised
+* (the cost and carbon balances are maximised and the rest are minimised)
+*/
+double objectiveCost(const SimulationResult& result, Objective objective);
+
+/**
+* A lower bound on objectiveCost for any simulation of the scenario with these bounds (see Simulator::boundObjectives)
+* A scenario that never pays back has a negative payback horizon, which objectiveCost ranks first,
+* so the bound on the payback horizon is -infinity unless the scenario's operating balance is certainly negative.
+*/
+double objectiveCostBound(const ObjectiveBounds& bounds, Objective objective);
+
+// one row per result with a column for each of the objectives
+ObjectiveCosts objectiveCosts(std::span<const SimulationResult> results, std::span<const Objective> objectives = ALL_OBJECTIVES);
+
+// true if a is no worse than b in every objective and better in at least one
+bool dominates(std::span<const double> a, std::span<const double> b);
+
+/**
+* Sort the candidates into fronts: the first front is the non-dominated candidates,
+* the second is those only dominated by the first front, and so on
+*
+* This is the efficient non-dominated sort with binary search (ENS-BS);
+* after a lexicographic sort each candidate can only be dominated by those before it.
+* Identical candidates are in the same front.
+*/
+std::vector<std::vector<size_t>> nonDominatedSort(const Eigen::Ref<const ObjectiveCosts>& costs);
+
+/**
+* The NSGA-II crowding distance of each candidate in a front
+* The candidates at either end of each objective have an infinite distance
+*/
+std::vector<double> crowdingDistance(const Eigen::Ref<const ObjectiveCosts>& costs, std::span<const size_t> front);
+
+/**
+* An incrementally updated set of mutually non-dominated candidates
+*
+* Each candidate is given an id by the caller (such as its index in a list of solutions).
+* A candidate is rejected if a member dominates it (or is identical to it, when distinct);
+* otherwise it is added and every member that it dominates is removed.
+*/
+class ParetoArchive {
+public:
+	explicit ParetoArchive(size_t numObjectives, bool distinct = true);
+
+	// returns true if the candidate was added to the archive
+	bool insert(std::span<const double> costs, size_t id);
+
+	/**
+	* Whether insert would reject every candidate whose costs are no better than bound in any objective
+	* (such as one whose objectiveCostBound are bound), so such a candidate needn't be simulated
+	*/
+	bool excludes(std::span<const double> bound) const;
+
+	// insert each row in turn, with the ids firstId, firstId + 1, ...
+	std::vector<bool> insert(const Eigen::Ref<const ObjectiveCosts>& costs, size_t firstId);
+
+	size_t size() const { return mIds.size(); }
+	size_t numObjectives() const { return mNumObjectives; }
+
+	const std::vector<size_t>& ids() const { return mIds; }
+	ObjectiveCosts costs() const;
+
+	void clear();
+
+private:
+	std::span<const double> member(size_t i) const;
+
+	size_t mNumObjectives;
+	bool mDistinct;
+	std::vector<size_t> mIds;
+	// the costs of each member, stored contiguously in the same order as mIds
+	std::vector<double> mCosts;
+};
@@ -1,6 +1,11 @@
 #include "Portfolio.hpp"
 
+#include <algorithm>
+#include <format>
+#include <stdexcept>
+
 #include "../Simulation/Costs/Compare.hpp"
+#include "../Simulation/Trace.hpp"
 
 void addMetrics(const SimulationMetrics& from, SimulationMetrics& to) {
 	to.total_gas_used += from.total_gas_used;
@@ -36,9 +41,20 @@ void addMetrics(const SimulationMetrics& from, SimulationMetrics& to) {
 }
 
 SimulationResult aggregateSiteResults(const std::vector<SimulationResult>& siteResults) {
+	std::vector<const SimulationResult*> sites;
+	sites.reserve(siteResults.size());
+	for (const auto& site : siteResults) {
+		sites.push_back(&site);
+	}
+	return aggregateSiteResults(sites);
+}
+
+SimulationResult aggregateSiteResults(std::span<const SimulationResult* const> siteResults) {
+	TraceScope trace{ "aggregateSiteResults", "portfolio" };
 	SimulationResult portfolioResult = {};
 
-	for (const auto& site : siteResults) {
+	for (const SimulationResult* sitePtr : siteResults) {
+		const SimulationResult& site = *sitePtr;
 		addMetrics(site.baseline_metrics, portfolioResult.baseline_metrics);
 		addMetrics(site.metrics, portfolioResult.metrics);
 
@@ -73,3 +89,45 @@ SimulationResult aggregateSiteResults(const std::vector<SimulationResult>& siteR
 	return portfolioResult;
 }
 
+
+std::vector<SimulationResult> aggregatePortfolios(const std::vector<std::vector<const SimulationResult*>>& candidates,
+	std::span<const int64_t> combinations, ThreadPool& pool) {
+	const size_t numSites = candidates.size();
+	if (numSites == 0) {
+		if (!combinations.empty()) {
+			throw std::out_of_range("Cannot choose from the candidates of no sites");
+		}
+		return {};
+	}
+	if (combinations.size() % numSites != 0) {
+		throw std::out_of_range(std::format("{} indices are not a whole number of portfolios of {} sites", combinations.size(), numSites));
+	}
+
+	// check every index up front, so that the parallel loop cannot fail
+	const size_t numPortfolios = combinations.size() / numSites;
+	for (size_t p = 0; p < numPortfolios; p++) {
+		for (size_t s = 0; s < numSites; s++) {
+			const int64_t index = combinations[p * numSites + s];
+			if (index < 0 || static_cast<size_t>(index) >= candidates[s].size()) {
+				throw std::out_of_range(std::format("Portfolio {} chooses result {} of site {}, which has {} results",
+					p, index, s, candidates[s].size()));
+			}
+		}
+	}
+
+	TraceScope trace{ "aggregatePortfolios", "portfolio" };
+	std::vector<SimulationResult> portfolios(numPortfolios);
+	// each task aggregates a block of portfolios, as a single aggregation is far too small to be worth a task
+	constexpr size_t BLOCK = 256;
+	pool.parallelFor((numPortfolios + BLOCK - 1) / BLOCK, [&](size_t block) {
+		std::vector<const SimulationResult*> sites(numSites);
+		const size_t end = std::min(numPortfolios, (block + 1) * BLOCK);
+		for (size_t p = block * BLOCK; p < end; p++) {
+			for (size_t s = 0; s < numSites; s++) {
+				sites[s] = candidates[s][static_cast<size_t>(combinations[p * numSites + s])];
+			}
+			portfolios[p] = aggregateSiteResults(sites);
+		}
+	});
+	return portfolios;
+}
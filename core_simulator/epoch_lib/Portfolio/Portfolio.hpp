@@ -1,6 +1,26 @@
 #pragma once
 
+#include <cstdint>
+#include <span>
 #include <vector>
 #include "../Definitions.hpp"
+#include "../Simulation/ThreadPool.hpp"
 
 SimulationResult aggregateSiteResults(const std::vector<SimulationResult>& siteResults);
+
+/**
+* Aggregate the results of a portfolio's sites, given by pointer so that they (and their report data) aren't copied
+* The aggregate never has report data.
+*/
+SimulationResult aggregateSiteResults(std::span<const SimulationResult* const> siteResults);
+
+/**
+* Aggregate many portfolios that each choose one result for every site
+*
+* candidates holds the results for each site (such as those of a batch) and combinations is a row-major
+* (portfolios x candidates.size()) array, in which each portfolio's row holds the index into each site's candidates.
+* The portfolios are aggregated in parallel on the pool, and returned in the order of the rows.
+* Throws std::out_of_range if an index is beyond its site's candidates.
+*/
+std::vector<SimulationResult> aggregatePortfolios(const std::vector<std::vector<const SimulationResult*>>& candidates,
+	std::span<const int64_t> combinations, ThreadPool& pool = ThreadPool::shared());
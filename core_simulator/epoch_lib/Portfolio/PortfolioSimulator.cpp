@@ -0,0 +1,273 @@
+#include "PortfolioSimulator.hpp"
+
+#include <chrono>
+#include <format>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+
+#include "Portfolio.hpp"
+#include "../Simulation/SeriesStore.hpp"
+#include "../Simulation/Trace.hpp"
+#include "../io/FileHandling.hpp"
+#include "../io/OnDemandJson.hpp"
+#include "../io/SiteDataJson.hpp"
+
+namespace {
+	// a single site scenario within one of the candidate portfolios
+	struct SiteJob {
+		size_t portfolio;
+		const std::string* siteName;
+		const TaskData* taskData;
+		const Simulator* simulator;
+	};
+
+	SiteData loadSiteData(const SiteSource& source) {
+		if (const auto* path = std::get_if<std::filesystem::path>(&source.siteData)) {
+			return readSiteData(*path);
+		}
+		return parseSiteDataJson(std::get<std::string>(source.siteData));
+	}
+
+	float secondsSince(std::chrono::steady_clock::time_point start) {
+		std::chrono::duration<float> elapsed = std::chrono::steady_clock::now() - start;
+		return elapsed.count();
+	}
+
+	// a zeroed ReportData of the columns for each portfolio, checking that every site has the same timesteps
+	std::vector<ReportData> makeColumnSums(const std::vector<SiteJob>& jobs, size_t numPortfolios, ReportColumnMask columns) {
+		const size_t timesteps = jobs.empty() ? 0 : jobs.front().simulator->getSiteData()->timesteps;
+		for (const SiteJob& job : jobs) {
+			if (job.simulator->getSiteData()->timesteps != timesteps) {
+				throw std::runtime_error(std::format("Cannot sum the columns of site {} ({} timesteps) with sites of {} timesteps",
+					*job.siteName, job.simulator->getSiteData()->timesteps, timesteps));
+			}
+		}
+
+		std::vector<ReportData> sums(numPortfolios, ReportData(columns));
+		for (ReportData& sum : sums) {
+			sum.reserve(static_cast<Eigen::Index>(timesteps));
+			for (size_t c = 0; c < NUM_REPORT_COLUMNS; c++) {
+				if (columns.has(static_cast<ReportColumn>(c))) {
+					sum.column(static_cast<ReportColumn>(c)).setZero();
+				}
+			}
+		}
+		return sums;
+	}
+
+	// sum += each of the columns that the site reported
+	void addColumns(const ReportData& site, ReportColumnMask columns, ReportData& sum) {
+		for (size_t c = 0; c < NUM_REPORT_COLUMNS; c++) {
+			const auto col = static_cast<ReportColumn>(c);
+			if (columns.has(col) && site.has(col)) {
+				sum.column(col) += site.get(col);
+			}
+		}
+	}
+}
+
+PortfolioSimulator::PortfolioSimulator(std::map<std::string, std::shared_ptr<const Simulator>> simulators) :
+	mSimulators(std::move(simulators))
+{
+	for (const auto& [name, simulator] : mSimulators) {
+		if (!simulator) {
+			throw std::runtime_error(std::format("No Simulator provided for site {}", name));
+		}
+	}
+}
+
+PortfolioSimulator PortfolioSimulator::build(std::span<const SiteSource> sites, ThreadPool& pool) {
+	// check the names before doing any of the (expensive) building
+	std::set<std::string> names;
+	for (const auto& site : sites) {
+		if (!names.insert(site.name).second) {
+			throw std::runtime_error(std::format("Site {} appears more than once in the portfolio", site.name));
+		}
+	}
+
+	std::vector<std::shared_ptr<const Simulator>> simulators(sites.size());
+	std::vector<SiteBuildTiming> timings(sites.size());
+	// sites often share columns (such as the weather and tariffs of one region), which are then held once
+	// and so is everything the Simulators derive from them
+	SeriesStore store;
+
+	// each site writes to its own slot so no further synchronisation is needed
+	pool.parallelFor(sites.size(), [&](size_t i) {
+		try {
+			auto start = std::chrono::steady_clock::now();
+			std::shared_ptr<const SiteData> siteData;
+			{
+				TraceScope trace{ "load SiteData", "portfolio", sites[i].name };
+				siteData = std::make_shared<const SiteData>(store.intern(loadSiteData(sites[i])));
+			}
+			timings[i].load = secondsSince(start);
+
+			start = std::chrono::steady_clock::now();
+			{
+				TraceScope trace{ "construct Simulator", "portfolio", sites[i].name };
+				auto simulator = std::make_shared<const Simulator>(std::move(siteData), sites[i].config);
+				// the baseline would otherwise be simulated by the first portfolio, so simulate it here with the other sites'
+				simulator->getBaseline();
+				simulators[i] = std::move(simulator);
+			}
+			timings[i].construct = secondsSince(start);
+		}
+		catch (const std::exception& e) {
+			throw std::runtime_error(std::format("Failed to build the Simulator for site {}: {}", sites[i].name, e.what()));
+		}
+	});
+
+	std::map<std::string, std::shared_ptr<const Simulator>> byName;
+	std::map<std::string, SiteBuildTiming> timingsByName;
+	for (size_t i = 0; i < sites.size(); i++) {
+		byName.emplace(sites[i].name, std::move(simulators[i]));
+		timingsByName.emplace(sites[i].name, timings[i]);
+	}
+
+	PortfolioSimulator portfolioSimulator(std::move(byName));
+	portfolioSimulator.mBuildTimings = std::move(timingsByName);
+	return portfolioSimulator;
+}
+
+PortfolioResult PortfolioSimulator::simulatePortfolio(const PortfolioTaskData& portfolio, SimulationType simulationType) const {
+	return simulatePortfolio(portfolio, simulationType, ThreadPool::shared());
+}
+
+PortfolioResult PortfolioSimulator::simulatePortfolio(const PortfolioTaskData& portfolio, SimulationType simulationType, ThreadPool& pool) const {
+	auto results = simulatePortfolios(std::span<const PortfolioTaskData>(&portfolio, 1), simulationType, pool);
+	return std::move(results.front());
+}
+
+std::vector<PortfolioResult> PortfolioSimulator::simulatePortfolios(std::span<const PortfolioTaskData> portfolios, SimulationType simulationType) const {
+	return simulatePortfolios(portfolios, simulationType, ThreadPool::shared());
+}
+
+std::vector<PortfolioResult> PortfolioSimulator::simulatePortfolios(std::span<const PortfolioTaskData> portfolios,
+	SimulationType simulationType, ThreadPool& pool) const {
+	return runPortfolios(portfolios, simulationType, {}, nullptr, pool);
+}
+
+std::vector<PortfolioResult> PortfolioSimulator::simulatePortfolios(std::span<const PortfolioTaskData> portfolios,
+	SimulationType simulationType, BatchControl& control, ThreadPool& pool) const {
+	return runPortfolios(portfolios, simulationType, {}, &control, pool);
+}
+
+PortfolioResult PortfolioSimulator::simulatePortfolio(const PortfolioTaskData& portfolio, ReportColumnMask columns, ThreadPool& pool) const {
+	auto results = simulatePortfolios(std::span<const PortfolioTaskData>(&portfolio, 1), columns, pool);
+	return std::move(results.front());
+}
+
+std::vector<PortfolioResult> PortfolioSimulator::simulatePortfolios(std::span<const PortfolioTaskData> portfolios,
+	ReportColumnMask columns, ThreadPool& pool) const {
+	return runPortfolios(portfolios, SimulationType::FullReporting, columns, nullptr, pool);
+}
+
+std::vector<PortfolioResult> PortfolioSimulator::simulatePortfolios(std::span<const PortfolioTaskData> portfolios,
+	ReportColumnMask columns, BatchControl& control, ThreadPool& pool) const {
+	return runPortfolios(portfolios, SimulationType::FullReporting, columns, &control, pool);
+}
+
+std::vector<PortfolioResult> PortfolioSimulator::runPortfolios(std::span<const PortfolioTaskData> portfolios,
+	SimulationType simulationType, ReportColumnMask columns, BatchControl* control, ThreadPool& pool) const {
+
+	// flatten the candidates into one list of site scenarios
+	// resolving the Simulators first means an unknown site is reported before anything is simulated
+	std::vector<SiteJob> jobs;
+	for (size_t i = 0; i < portfolios.size(); i++) {
+		for (const auto& [name, taskData] : portfolios[i]) {
+			jobs.push_back(SiteJob{ i, &name, &taskData, &getSimulator(name) });
+		}
+	}
+
+	std::vector<SimulationResult> siteResults(jobs.size());
+
+	// the sum of each portfolio's columns, which its sites are added to as they finish
+	const bool sumColumns = columns.count() > 0;
+	std::vector<ReportData> columnSums;
+	std::vector<std::mutex> columnSumMutexes(sumColumns ? portfolios.size() : 0);
+	if (sumColumns) {
+		columnSums = makeColumnSums(jobs, portfolios.size(), columns);
+	}
+
+	if (control) {
+		control->addTotal(jobs.size());
+	}
+
+	// the sites differ in cost by an order of magnitude, so start the longest first,
+	// keeping the scenarios of a site together so that its SiteData stays in the same core's cache
+	std::vector<float> costs(jobs.size());
+	std::vector<size_t> affinity(jobs.size());
+	for (size_t j = 0; j < jobs.size(); j++) {
+		costs[j] = jobs[j].simulator->estimateRuntime(*jobs[j].taskData);
+		affinity[j] = reinterpret_cast<size_t>(jobs[j].simulator);
+	}
+
+	// each site scenario writes to its own slot so no further synchronisation is needed
+	pool.parallelForByCost(costs, affinity, [&](size_t j) {
+		if (control && control->stopRequested()) {
+			siteResults[j] = jobs[j].simulator->makeCancelledResult(*jobs[j].taskData);
+			control->addSkipped();
+			return;
+		}
+		TraceScope trace{ "site scenario", "portfolio", *jobs[j].siteName };
+		if (sumColumns) {
+			siteResults[j] = jobs[j].simulator->simulateScenario(*jobs[j].taskData, columns);
+			if (siteResults[j].report_data) {
+				std::lock_guard<std::mutex> lock(columnSumMutexes[jobs[j].portfolio]);
+				addColumns(*siteResults[j].report_data, columns, columnSums[jobs[j].portfolio]);
+			}
+			// release the site's columns now, rather than holding every site's until the end
+			siteResults[j].report_data.reset();
+			siteResults[j].baseline_report_data.reset();
+		}
+		else {
+			siteResults[j] = jobs[j].simulator->simulateScenario(*jobs[j].taskData, simulationType);
+		}
+		if (simulationType == SimulationType::ResultOnly) {
+			jobs[j].simulator->observeRuntime(*jobs[j].taskData, siteResults[j]);
+		}
+		if (control) {
+			control->addCompleted();
+		}
+	});
+
+	// the jobs are in portfolio order, so each portfolio's sites are contiguous
+	std::vector<PortfolioResult> results(portfolios.size());
+	size_t j = 0;
+	for (size_t i = 0; i < portfolios.size(); i++) {
+		// the sites are aggregated where they are stored, rather than copied with their report data
+		std::vector<const SimulationResult*> sites;
+		sites.reserve(portfolios[i].size());
+		bool cancelled = false;
+		for (; j < jobs.size() && jobs[j].portfolio == i; j++) {
+			cancelled = cancelled || siteResults[j].cancelled;
+			auto [site, inserted] = results[i].sites.emplace(*jobs[j].siteName, std::move(siteResults[j]));
+			sites.push_back(&site->second);
+		}
+		results[i].portfolio = aggregateSiteResults(sites);
+		results[i].portfolio.cancelled = cancelled;
+		if (sumColumns) {
+			results[i].portfolio.report_data = std::move(columnSums[i]);
+		}
+	}
+
+	return results;
+}
+
+const Simulator& PortfolioSimulator::getSimulator(const std::string& siteName) const {
+	auto it = mSimulators.find(siteName);
+	if (it == mSimulators.end()) {
+		throw std::runtime_error(std::format("No Simulator for site {} in the portfolio", siteName));
+	}
+	return *it->second;
+}
+
+std::vector<std::string> PortfolioSimulator::siteNames() const {
+	std::vector<std::string> names;
+	names.reserve(mSimulators.size());
+	for (const auto& [name, simulator] : mSimulators) {
+		names.push_back(name);
+	}
+	return names;
+}
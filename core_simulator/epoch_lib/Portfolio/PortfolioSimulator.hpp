@@ -0,0 +1,144 @@
+#pragma once
+
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <span>
+#include <string>
+#include <variant>
+#include <vector>
+
+#include "../Definitions.hpp"
+#include "../Simulation/BatchControl.hpp"
+#include "../Simulation/Simulate.hpp"
+#include "../Simulation/TaskData.hpp"
+#include "../Simulation/ThreadPool.hpp"
+
+// a scenario for each site in a portfolio, keyed by the site's name
+using PortfolioTaskData = std::map<std::string, TaskData>;
+
+/**
+* Where to load a site's SiteData from when building the Simulators for a portfolio
+*/
+struct SiteSource {
+	std::string name;
+	// either the path to a SiteData file (json or binary) or the SiteData as a json string
+	std::variant<std::filesystem::path, std::string> siteData;
+	TaskConfig config;
+};
+
+/**
+* The time in seconds spent building the Simulator for a site
+*/
+struct SiteBuildTiming {
+	// reading, parsing and validating the SiteData
+	float load = 0.0f;
+	// constructing the Simulator (mostly simulating the baseline)
+	float construct = 0.0f;
+};
+
+struct PortfolioResult {
+	// the aggregate of every site's result
+	// (with the sum of the sites' columns as its report_data, when the portfolio is simulated with a ReportColumnMask)
+	SimulationResult portfolio;
+	std::map<std::string, SimulationResult> sites;
+};
+
+/**
+* Simulate portfolios of sites, each with its own Simulator
+*
+* The sites of a portfolio are simulated concurrently and then aggregated with aggregateSiteResults.
+* This does not modify the Simulators, so it is safe to call concurrently from multiple threads.
+*/
+class PortfolioSimulator {
+public:
+	/**
+	* Construct a PortfolioSimulator from a Simulator per site
+	* The Simulators may be shared with other PortfolioSimulators
+	*/
+	explicit PortfolioSimulator(std::map<std::string, std::shared_ptr<const Simulator>> simulators);
+
+	/**
+	* Build the Simulators for every site concurrently, from loading the SiteData through to simulating the baseline
+	* If any site fails to build, the first failure is rethrown (naming the site) once every site has finished
+	* Columns with the same values in several sites are stored once (see SeriesStore)
+	*/
+	static PortfolioSimulator build(std::span<const SiteSource> sites, ThreadPool& pool = ThreadPool::shared());
+
+	/**
+	* Simulate a portfolio
+	* The portfolio may contain any subset of the sites; every site in the portfolio must have a Simulator
+	*/
+	PortfolioResult simulatePortfolio(const PortfolioTaskData& portfolio, SimulationType simulationType = SimulationType::ResultOnly) const;
+
+	/**
+	* Overload of simulatePortfolio to run on a specific thread pool
+	*/
+	PortfolioResult simulatePortfolio(const PortfolioTaskData& portfolio, SimulationType simulationType, ThreadPool& pool) const;
+
+	/**
+	* Simulate many candidate portfolios at once
+	* Every (candidate, site) pair is simulated in parallel, so the pool stays busy even when candidates have few sites.
+	* The results are returned in the same order as the candidates
+	*/
+	std::vector<PortfolioResult> simulatePortfolios(std::span<const PortfolioTaskData> portfolios,
+		SimulationType simulationType = SimulationType::ResultOnly) const;
+
+	/**
+	* Overload of simulatePortfolios to run on a specific thread pool
+	*/
+	std::vector<PortfolioResult> simulatePortfolios(std::span<const PortfolioTaskData> portfolios,
+		SimulationType simulationType, ThreadPool& pool) const;
+
+	/**
+	* Overload of simulatePortfolios that reports the progress of every site scenario to control,
+	* and skips the remaining site scenarios once it is stopped
+	* A portfolio with a skipped site has cancelled set on its aggregate result
+	*/
+	std::vector<PortfolioResult> simulatePortfolios(std::span<const PortfolioTaskData> portfolios,
+		SimulationType simulationType, BatchControl& control, ThreadPool& pool = ThreadPool::shared()) const;
+
+	/**
+	* Simulate a portfolio, summing the given ReportData columns of its sites into the portfolio's report_data
+	* (see the ReportColumnMask overload of simulatePortfolios)
+	*/
+	PortfolioResult simulatePortfolio(const PortfolioTaskData& portfolio, ReportColumnMask columns, ThreadPool& pool = ThreadPool::shared()) const;
+
+	/**
+	* Simulate many candidate portfolios, summing the given ReportData columns of each one's sites into its report_data
+	*
+	* Each site reports only those columns, which are added to its portfolio's preallocated sums as soon as the site finishes
+	* and then released, so a portfolio holds one set of columns however many sites it has.
+	* The sites are added in the order they finish, so the sums may differ in the last bits between runs.
+	* The sites' own results have no report data, and every site must have the same number of timesteps.
+	*/
+	std::vector<PortfolioResult> simulatePortfolios(std::span<const PortfolioTaskData> portfolios,
+		ReportColumnMask columns, ThreadPool& pool = ThreadPool::shared()) const;
+
+	/**
+	* Overload of the ReportColumnMask simulatePortfolios that reports progress to control (as the SimulationType overload does)
+	*/
+	std::vector<PortfolioResult> simulatePortfolios(std::span<const PortfolioTaskData> portfolios,
+		ReportColumnMask columns, BatchControl& control, ThreadPool& pool = ThreadPool::shared()) const;
+
+	/**
+	* Get the Simulator for a site, raising an exception if there is no such site
+	*/
+	const Simulator& getSimulator(const std::string& siteName) const;
+
+	std::vector<std::string> siteNames() const;
+
+	/**
+	* The time spent building each site's Simulator
+	* This is empty unless the PortfolioSimulator was created with build
+	*/
+	const std::map<std::string, SiteBuildTiming>& getBuildTimings() const { return mBuildTimings; }
+
+private:
+	// simulatePortfolios, reporting to control if it is set and summing the columns if there are any
+	std::vector<PortfolioResult> runPortfolios(std::span<const PortfolioTaskData> portfolios,
+		SimulationType simulationType, ReportColumnMask columns, BatchControl* control, ThreadPool& pool) const;
+
+	const std::map<std::string, std::shared_ptr<const Simulator>> mSimulators;
+	std::map<std::string, SiteBuildTiming> mBuildTimings;
+};
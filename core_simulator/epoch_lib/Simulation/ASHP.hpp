@@ -3,6 +3,8 @@
 #include <Eigen/Core>
 #include <Eigen/Dense>
 #include <algorithm>
+#include <memory>
+#include <utility>
 
 #include "SiteData.hpp"
 #include "TaskComponents.hpp"
@@ -15,7 +17,8 @@
 class HotRoomHeatPump {
 
 public:
-	HotRoomHeatPump(const SiteData& siteData, const HeatPumpData& hp, const DataCentreData& dc) :
+	// The DHW and CH both use the FIXED_SEND_TEMP_VAL, so share one profile for this heatpump's size and hotroom temperature
+	HotRoomHeatPump(const SiteData& siteData, std::shared_ptr<const HotRoomProfile> profile) :
 		// Initialise results data vectors with all values to zero
 		mDHWload_e(Eigen::VectorXf::Zero(siteData.timesteps)),	// ASHP electrical load
 		mDHWout_h(Eigen::VectorXf::Zero(siteData.timesteps)),	// ASHP heat output
@@ -25,43 +28,38 @@ public:
 		mUsedHotHeat_h(Eigen::VectorXf::Zero(siteData.timesteps)),	// ASHP heat from Hotroom
 		// Initialise Persistent Values
 		DHW_OUT_TEMP(60),	// FUTURE: removed when taskData.ASHP_DHWtemp available
-		mASHPperfDHW(siteData, hp, FIXED_SEND_TEMP_VAL),	// lookup object for DHW performance
-		mASHPperfCH(siteData, hp, FIXED_SEND_TEMP_VAL),	// lookup object for CH performance
+		mProfile(std::move(profile)),	// performance at the ambient and hotroom temperatures
+		mAmbient(mProfile->ambient),
 		mTimesteps(siteData.timesteps),
-		mPowerScalar(siteData.timestep_hours),
-		mHotTemp(dc.hotroom_temp),
+		mHotRoomDHW(mProfile->hotRoom),
+		mHotRoomCH(mProfile->hotRoom),
 		mHeatpumpSuppliesDHW(true),	// FUTURE: read value from (new) taskData value or use ASHP_DHWtemp not zero
 		mHeatpumpSuppliesCentralHeating(true),		// FUTURE: read value from (new) taskData value or use ASHP_RadTemp not zero
 		mHeatPumpMax_h(1.0f),
 		mHeatPumpMax_e(1.0f),
-		mAvailHotHeatTemp_h(0.0f),
-		mMaxElec_e(0.0f),
-		mAmbientTemperature(siteData.air_temperature),	// Ambient Temperature
-		FreeHeatTemp_h(Eigen::VectorXf::Zero(siteData.timesteps))	// ASHP heat: temp value for calcs
+		mAvailHotHeatTemp_h(0.0f)
 	{
-		mResidualCapacity = Eigen::VectorXf::Constant(siteData.timesteps, 1.0f);// Remaining heatpump capacity
 	}
 
-	float MaxElec(size_t timestep) {
+	float MaxElec(size_t timestep) const {
 		// Peak kWh per timestep of ASHP
-
-		float dhwMaxLoad = mASHPperfDHW.Lookup(mAmbientTemperature[timestep]).Load_e;
-		float chMaxLoad = mASHPperfCH.Lookup(mAmbientTemperature[timestep]).Load_e;
-
-		mMaxElec_e = std::max(dhwMaxLoad, chMaxLoad);
-		return mMaxElec_e;
+		// the DHW and CH share a send temperature, so this is the load at the ambient temperature
+		return mAmbient.load_e[timestep];
 	}
 
 	void AllCalcs(TempSum& tempSum, const year_TS& AvailHotHeat_h) {
 		// Applies fixed precedence: hot water is served before central heating
 
-		HeatpumpValues hotRoomDHW = mASHPperfDHW.Lookup(mHotTemp);
-		HeatpumpValues hotRoomCH = mASHPperfCH.Lookup(mHotTemp);
+		const HeatpumpValues hotRoomDHW = mHotRoomDHW;
+		const HeatpumpValues hotRoomCH = mHotRoomCH;
 
 		for (size_t t = 0; t < mTimesteps; t++) {
+			// Remaining heatpump capacity
+			float residualCapacity = 1.0f;
+
 			if (mHeatpumpSuppliesDHW) {
 				// Lookup performances for DHW (hot water) output temperature
-				HeatpumpValues ambientDHW = mASHPperfDHW.Lookup(mAmbientTemperature[t]);
+				HeatpumpValues ambientDHW = ambientAt(t);
 
 				// Output = lower of Hotroom lookup value & Ambient + hotroom energy value (Conservation of Energy)
 				if ((ambientDHW.Heat_h + AvailHotHeat_h[t]) >= hotRoomDHW.Heat_h) {
@@ -76,15 +74,15 @@ public:
 				if (mHeatPumpMax_h <= 0) {	// If no HeatPump capacity, set values to zero
 					mDHWout_h[t] = 0;
 					mDHWload_e[t] = 0;
-					mResidualCapacity[t] = 0;
+					residualCapacity = 0;
 				} else if (tempSum.DHW_load_h[t] <= mHeatPumpMax_h) {	// Adjust values to load
 					mDHWout_h[t] = tempSum.DHW_load_h[t];
 					mDHWload_e[t] = mHeatPumpMax_e * mDHWout_h[t] / mHeatPumpMax_h;
-					mResidualCapacity[t] = 1 - mDHWout_h[t] / mHeatPumpMax_h;
+					residualCapacity = 1 - mDHWout_h[t] / mHeatPumpMax_h;
 				} else {	// ASHP cannot meet heating target, so will do maximum capacity
 					mDHWout_h[t] = mHeatPumpMax_h;
 					mDHWload_e[t] = mHeatPumpMax_e;
-					mResidualCapacity[t] = 0;
+					residualCapacity = 0;
 				}
 			}
 			mFreeHeat_h[t] = std::max(mDHWout_h[t] - mDHWload_e[t] - AvailHotHeat_h[t], 0.0f);	// How much heat from ambient
@@ -92,37 +90,37 @@ public:
 
 			if (mHeatpumpSuppliesCentralHeating) {
 				// Lookup performances for CH (central heating) output temperature
-				HeatpumpValues ambientCH = mASHPperfCH.Lookup(mAmbientTemperature[t]);
+				HeatpumpValues ambientCH = ambientAt(t);
 
 				mAvailHotHeatTemp_h = AvailHotHeat_h[t] - mUsedHotHeat_h[t];
 				// Use lower of Hotroom temperature values & Ambient + hotroom energy values (Conservation of Energy)
 				if ((ambientCH.Heat_h + AvailHotHeat_h[t]) >= hotRoomCH.Heat_h) {
-					mHeatPumpMax_h = hotRoomCH.Heat_h * mResidualCapacity[t];
-					mHeatPumpMax_e = hotRoomCH.Load_e * mResidualCapacity[t];
+					mHeatPumpMax_h = hotRoomCH.Heat_h * residualCapacity;
+					mHeatPumpMax_e = hotRoomCH.Load_e * residualCapacity;
 				}
 				else {
-					mHeatPumpMax_h = (ambientCH.Heat_h + AvailHotHeat_h[t]) * mResidualCapacity[t];
-					mHeatPumpMax_e = ambientCH.Load_e * mResidualCapacity[t];
+					mHeatPumpMax_h = (ambientCH.Heat_h + AvailHotHeat_h[t]) * residualCapacity;
+					mHeatPumpMax_e = ambientCH.Load_e * residualCapacity;
 				}
 				// Adjust output and load to meet heating demand
 				if (mHeatPumpMax_h <= 0) {	// If no HeatPump capacity, set values to zero
 					mCHout_h[t] = 0;
 					mCHload_e[t] = 0;
-					mResidualCapacity[t] = 0;
+					residualCapacity = 0;
 				}
 				else if (tempSum.Heat_h[t] <= mHeatPumpMax_h) {	// Adjust values to load
 					mCHout_h[t] = tempSum.Heat_h[t];
 					mCHload_e[t] = mHeatPumpMax_e * mCHout_h[t] / mHeatPumpMax_h;
-					mResidualCapacity[t] = mResidualCapacity[t] * (1 - mCHout_h[t] / mHeatPumpMax_h);
+					residualCapacity = residualCapacity * (1 - mCHout_h[t] / mHeatPumpMax_h);
 				}
 				else {	// ASHP cannot meet heating target, so will do maximum capacity
 					mCHout_h[t] = mHeatPumpMax_h;
 					mCHload_e[t] = mHeatPumpMax_e;
-					mResidualCapacity[t] = 0;
+					residualCapacity = 0;
 				}
-				FreeHeatTemp_h[t] = std::max(mCHout_h[t] - mCHload_e[t] - AvailHotHeat_h[t], 0.0f);	// How much heat from ambient
-				mFreeHeat_h[t] += FreeHeatTemp_h[t];
-				mUsedHotHeat_h[t] = mUsedHotHeat_h[t] + mCHout_h[t] - mCHload_e[t] - FreeHeatTemp_h[t];
+				float freeHeatTemp_h = std::max(mCHout_h[t] - mCHload_e[t] - AvailHotHeat_h[t], 0.0f);	// How much heat from ambient
+				mFreeHeat_h[t] += freeHeatTemp_h;
+				mUsedHotHeat_h[t] = mUsedHotHeat_h[t] + mCHout_h[t] - mCHload_e[t] - freeHeatTemp_h;
 			}
 		}
 		tempSum.Elec_e = tempSum.Elec_e + mDHWload_e + mCHload_e;
@@ -131,20 +129,23 @@ public:
 	}
 
 	void StepCalc(TempSum& tempSum, const float AvailHotHeat_h, const float ElecBudget_e, size_t t) {
+		// Remaining heatpump capacity
+		float residualCapacity = 1.0f;
+
 		if(ElecBudget_e <= 0) {
 			// No electricty available for the ASHP (balancing object)
 			mDHWout_h[t] = 0.0f;
 			mDHWload_e[t] = 0.0f;
 			mCHout_h[t] = 0.0f;
 			mCHload_e[t] = 0.0f;
-			mResidualCapacity[t] = 0.0f;
+			residualCapacity = 0.0f;
 			mElecResidual_e = 0.0f;
 		}
 		else {
 			if (mHeatpumpSuppliesDHW) {
 				// Lookup performances for DHW (hot water) output temperature
-				HeatpumpValues ambientDHW = mASHPperfDHW.Lookup(mAmbientTemperature[t]);
-				HeatpumpValues hotRoomDHW = mASHPperfDHW.Lookup(mHotTemp);
+				HeatpumpValues ambientDHW = ambientAt(t);
+				HeatpumpValues hotRoomDHW = mHotRoomDHW;
 
 				// Max values = lower of Hotroom lookup value & Ambient + hotroom energy value (Conservation of Energy)
 				if ((ambientDHW.Heat_h + AvailHotHeat_h) >= hotRoomDHW.Heat_h) {
@@ -160,24 +161,24 @@ public:
 				if (mHeatPumpMax_h <= 0) {	// If no HeatPump capacity, set values to zero
 					mDHWout_h[t] = 0;
 					mDHWload_e[t] = 0;
-					mResidualCapacity[t] = 0;
+					residualCapacity = 0;
 				}
 				else if (tempSum.DHW_load_h[t] <= mHeatPumpMax_h) {	// Adjust values to load
 					mDHWout_h[t] = tempSum.DHW_load_h[t];
 					mDHWload_e[t] = mHeatPumpMax_e * mDHWout_h[t] / mHeatPumpMax_h;
-					mResidualCapacity[t] = 1 - mDHWout_h[t] / mHeatPumpMax_h;
+					residualCapacity = 1 - mDHWout_h[t] / mHeatPumpMax_h;
 				}
 				else {	// ASHP cannot meet heating target, so will do maximum capacity
 					mDHWout_h[t] = mHeatPumpMax_h;
 					mDHWload_e[t] = mHeatPumpMax_e;
-					mResidualCapacity[t] = 0;
+					residualCapacity = 0;
 				}
 				// Adjust output and load to meet available electricity
 				if (mDHWload_e[t] > ElecBudget_e) {
 					// Check whether the ASHP load exceeds the electricity budget, if so, reduce proportionally
 					mDHWout_h[t] = mDHWout_h[t] * ElecBudget_e / mDHWload_e[t];
 					mDHWload_e[t] = ElecBudget_e;
-					mResidualCapacity[t] = (1 - mDHWout_h[t] / mHeatPumpMax_h) * ElecBudget_e / mDHWload_e[t];
+					residualCapacity = (1 - mDHWout_h[t] / mHeatPumpMax_h) * ElecBudget_e / mDHWload_e[t];
 				}
 				mFreeHeat_h[t] = mDHWout_h[t] - mDHWload_e[t] - AvailHotHeat_h;	// How much heat from ambient		
 				if (mFreeHeat_h[t] < 0) { mFreeHeat_h[t] = 0; }	// Prevent -ve values (not all AvailHotHeat_h required)
@@ -189,12 +190,12 @@ public:
 			// No electricty remains for the ASHP CH
 			mCHout_h[t] = 0;
 			mCHload_e[t] = 0;
-			mResidualCapacity[t] = 0;
+			residualCapacity = 0;
 		} else {
 			if (mHeatpumpSuppliesCentralHeating) {
 				// Lookup performances for CH (central heating) output temperature
-				HeatpumpValues ambientCH = mASHPperfCH.Lookup(mAmbientTemperature[t]);
-				HeatpumpValues hotRoomCH = mASHPperfCH.Lookup(mHotTemp);
+				HeatpumpValues ambientCH = ambientAt(t);
+				HeatpumpValues hotRoomCH = mHotRoomCH;
 				
 				mAvailHotHeatTemp_h = AvailHotHeat_h - mUsedHotHeat_h[t];
 				// Max values = lower of Hotroom lookup value & Ambient + hotroom energy value (Conservation of Energy)
@@ -211,28 +212,28 @@ public:
 				if (mHeatPumpMax_h <= 0) {	// If no HeatPump capacity, set values to zero
 					mCHout_h[t] = 0;
 					mCHload_e[t] = 0;
-					mResidualCapacity[t] = 0;
+					residualCapacity = 0;
 				}
 				else if (tempSum.Heat_h[t] <= mHeatPumpMax_h) {	// Adjust values to load
 					mCHout_h[t] = tempSum.Heat_h[t];
 					mCHload_e[t] = mHeatPumpMax_e * mCHout_h[t] / mHeatPumpMax_h;
-					mResidualCapacity[t] = mResidualCapacity[t] * (1 - mCHout_h[t] / mHeatPumpMax_h);
+					residualCapacity = residualCapacity * (1 - mCHout_h[t] / mHeatPumpMax_h);
 				}
 				else {	// ASHP cannot meet heating target, so do maximum capacity
 					mCHout_h[t] = mHeatPumpMax_h;
 					mCHload_e[t] = mHeatPumpMax_e;
-					mResidualCapacity[t] = 0;
+					residualCapacity = 0;
 				}
 				// Adjust output and load to meet available electricity
 				if (mCHload_e[t] > mElecResidual_e) {
 					// Check whether the ASHP load exceeds the electricity budget, if so, reduce proportionally
 					mCHout_h[t] = mCHout_h[t] * ElecBudget_e / mCHload_e[t];
 					mCHload_e[t] = ElecBudget_e;
-					mResidualCapacity[t] = (1 - mCHout_h[t] / mHeatPumpMax_h) * ElecBudget_e / mCHload_e[t];
+					residualCapacity = (1 - mCHout_h[t] / mHeatPumpMax_h) * ElecBudget_e / mCHload_e[t];
 				}
-				FreeHeatTemp_h[t] = mCHout_h[t] - mCHload_e[t] - mAvailHotHeatTemp_h;	// How much heat from ambient		
-				if (FreeHeatTemp_h[t] < 0) { FreeHeatTemp_h[t] = 0; }	// Prevent -ve values (not all AvailHotHeat_h required)
-				mUsedHotHeat_h[t] = mUsedHotHeat_h[t] + mDHWout_h[t] - mDHWload_e[t] - FreeHeatTemp_h[t];
+				float freeHeatTemp_h = mCHout_h[t] - mCHload_e[t] - mAvailHotHeatTemp_h;	// How much heat from ambient		
+				if (freeHeatTemp_h < 0) { freeHeatTemp_h = 0; }	// Prevent -ve values (not all AvailHotHeat_h required)
+				mUsedHotHeat_h[t] = mUsedHotHeat_h[t] + mDHWout_h[t] - mDHWload_e[t] - freeHeatTemp_h;
 				mElecResidual_e = mElecResidual_e - mCHload_e[t];
 			}
 		}
@@ -242,31 +243,31 @@ public:
 	}
 
 	// Public output data, create private ASHP object in parent
-	year_TS mDHWload_e;
-	year_TS mDHWout_h;
-	year_TS mCHload_e;
-	year_TS mCHout_h;
-	year_TS mFreeHeat_h;
-	year_TS mUsedHotHeat_h;
+	PooledTS mDHWload_e;
+	PooledTS mDHWout_h;
+	PooledTS mCHload_e;
+	PooledTS mCHout_h;
+	PooledTS mFreeHeat_h;
+	PooledTS mUsedHotHeat_h;
 
 private:
+	HeatpumpValues ambientAt(size_t t) const {
+		return { mAmbient.heat_h[t], mAmbient.load_e[t] };
+	}
+
 	const int DHW_OUT_TEMP;
-	
-	ASHPLookup mASHPperfDHW;
-	ASHPLookup mASHPperfCH;
+
+	// shared with every scenario that has the same size of heatpump and hotroom temperature
+	std::shared_ptr<const HotRoomProfile> mProfile;
+	const HeatPumpProfile& mAmbient;
 
 	const size_t mTimesteps;
-	const float mPowerScalar;
-	const float mHotTemp;
+	const HeatpumpValues mHotRoomDHW;
+	const HeatpumpValues mHotRoomCH;
 	const bool mHeatpumpSuppliesDHW;
 	const bool mHeatpumpSuppliesCentralHeating;
 	float mHeatPumpMax_h;
 	float mHeatPumpMax_e;
 	float mElecResidual_e;
 	float mAvailHotHeatTemp_h;
-	float mMaxElec_e;
-
-	const year_TS mAmbientTemperature;
-	year_TS mResidualCapacity;
-	year_TS FreeHeatTemp_h;
 };
\ No newline at end of file
@@ -1,14 +1,21 @@
 #include "ASHPLookup.hpp"
 
-ASHPLookup::ASHPLookup(const SiteData& siteData, const HeatPumpData& hp, float sendTemperature)
+ASHPLookup::ASHPLookup(const SiteData& siteData, const HeatPumpData& hp, float sendTemperature) :
+    // The reference table is assumed to be for a 1KW heatpump
+    // We scale the values by the modelled ASHP Power per timestep
+    ASHPLookup(siteData, hp.heat_power * siteData.timestep_hours, sendTemperature)
+{
+}
+
+ASHPLookup::ASHPLookup(const SiteData& siteData, float powerScalar, float sendTemperature)
 {
-    precomputeLookupTable(siteData, hp, sendTemperature);
+    precomputeLookupTable(siteData, powerScalar, sendTemperature);
 }
 
 
 // Lookup the CoP values for the given temperature
 // This could either be the ambient air temperature or a hotroom air temperature
-HeatpumpValues ASHPLookup::Lookup(float supplyTemp) {
+HeatpumpValues ASHPLookup::Lookup(float supplyTemp) const {
 
     // much faster than std::round
     int supplyTempDeg = static_cast<int>(supplyTemp + (supplyTemp >= 0 ? 0.5f : -0.5f));;
@@ -26,46 +33,27 @@ HeatpumpValues ASHPLookup::Lookup(float supplyTemp) {
     return HeatpumpValues{ mOutputByDegree[supplyTempDeg + mOffset], mInputByDegree[supplyTempDeg + mOffset] };
 }
 
-void ASHPLookup::precomputeLookupTable(const SiteData& siteData, const HeatPumpData& hp, float sendTemp) {
+void ASHPLookup::precomputeLookupTable(const SiteData& siteData, float powerScalar, float sendTemp) {
     mMinAirTemp = static_cast<int>(std::floor(siteData.ashp_input_table(1, 0)));
     mMaxAirTemp = static_cast<int>(std::ceil(siteData.ashp_input_table(siteData.ashp_input_table.rows() - 1, 0)));
 
     mOffset = -1 * mMinAirTemp;
 
-    // The reference table is assumed to be for a 1KW heatpump
-    // We scale the values by the modelled ASHP Power per timestep
-    float powerScalar = hp.heat_power * siteData.timestep_hours;
+    // the send temperature is the same for every degree, so only find its column once
+    const int col = sendTempToColIndex(siteData, sendTemp);
 
-    for (int airTempByDegree = mMinAirTemp; airTempByDegree <= mMaxAirTemp; airTempByDegree++) {
-        float airTemp = static_cast<float>(airTempByDegree);
+    const size_t degrees = static_cast<size_t>(mMaxAirTemp - mMinAirTemp + 1);
+    mInputByDegree.reserve(degrees);
+    mOutputByDegree.reserve(degrees);
 
-        float scaledInput = computeInput(siteData, sendTemp, airTemp) * powerScalar;
-        mInputByDegree.emplace_back(scaledInput);
+    for (int airTempByDegree = mMinAirTemp; airTempByDegree <= mMaxAirTemp; airTempByDegree++) {
+        int row = airTempToRowIndex(siteData, static_cast<float>(airTempByDegree));
 
-        float scaledOutput = computeOutput(siteData, sendTemp, airTemp) * powerScalar;
-        mOutputByDegree.emplace_back(scaledOutput);
+        mInputByDegree.emplace_back(siteData.ashp_input_table(row, col) * powerScalar);
+        mOutputByDegree.emplace_back(siteData.ashp_output_table(row, col) * powerScalar);
     }
 }
 
-
-float ASHPLookup::computeInput(const SiteData& siteData, float sendTemp, float airTemp) const
-{
-    int col = sendTempToColIndex(siteData, sendTemp);
-    int row = airTempToRowIndex(siteData, airTemp);
-
-    float input = siteData.ashp_input_table(row, col);
-    return input;
-}
-
-float ASHPLookup::computeOutput(const SiteData& siteData, float sendTemp, float airTemp) const
-{
-    int col = sendTempToColIndex(siteData, sendTemp);
-    int row = airTempToRowIndex(siteData, airTemp);
-
-    float output = siteData.ashp_output_table(row, col);
-    return output;
-}
-
 // Determine the Row index of the table to use for lookups, given a air temp
 // This 'snaps back' to the closest value lower than it in the table
 // i.e. the last row that does not exceed the given air temp
@@ -115,3 +103,58 @@ int ASHPLookup::sendTempToColIndex(const SiteData& siteData, float sendTemp) con
     // use the highest (last) temperature we can
     return num_cols - 1;
 }
+
+HeatPumpProfile makeAmbientHeatPumpProfile(const SiteData& siteData, const ASHPLookup& reference) {
+    HeatPumpProfile profile{ year_TS(siteData.timesteps), year_TS(siteData.timesteps) };
+    for (Eigen::Index t = 0; t < static_cast<Eigen::Index>(siteData.timesteps); t++) {
+        HeatpumpValues values = reference.Lookup(siteData.air_temperature[t]);
+        profile.heat_h[t] = values.Heat_h;
+        profile.load_e[t] = values.Load_e;
+    }
+    return profile;
+}
+
+HotRoomProfile makeHotRoomProfile(const ASHPLookup& reference, const HeatPumpProfile& ambientProfile,
+    float powerScalar, float hotroomTemp) {
+    return {
+        HeatPumpProfile{ ambientProfile.heat_h * powerScalar, ambientProfile.load_e * powerScalar },
+        reference.Lookup(hotroomTemp, powerScalar)
+    };
+}
+
+std::shared_ptr<const HotRoomProfile> HotRoomProfileCache::get(const ASHPLookup& reference,
+    const HeatPumpProfile& ambientProfile, float powerScalar, float hotroomTemp) {
+    const std::pair<float, float> key{ powerScalar, hotroomTemp };
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto it = mProfiles.find(key);
+        if (it != mProfiles.end()) {
+            return it->second;
+        }
+    }
+
+    // calculated outside the lock, so another thread may add the same profile first
+    auto profile = std::make_shared<const HotRoomProfile>(
+        makeHotRoomProfile(reference, ambientProfile, powerScalar, hotroomTemp));
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mProfiles.size() >= MAX_ENTRIES) {
+        // the scenarios that hold a profile keep it alive
+        mProfiles.clear();
+    }
+    return mProfiles.emplace(key, std::move(profile)).first->second;
+}
+
+size_t HotRoomProfileCache::size() const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mProfiles.size();
+}
+
+size_t HotRoomProfileCache::ownedBytes() const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    size_t bytes = 0;
+    for (const auto& [key, profile] : mProfiles) {
+        bytes += sizeof(HotRoomProfile) + sizeof(float) * static_cast<size_t>(profile->ambient.heat_h.size() + profile->ambient.load_e.size());
+    }
+    return bytes;
+}
@@ -1,5 +1,10 @@
 #pragma once
 
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+
 #include "SiteData.hpp"
 #include "TaskComponents.hpp"
 #include "../Definitions.hpp"
@@ -19,14 +24,29 @@ class ASHPLookup
 public:
     ASHPLookup(const SiteData& siteData, const HeatPumpData& hp, float sendTemperature);
 
-    HeatpumpValues Lookup(float airTemp);
+    /**
+    * Construct a lookup with the reference (1kW) table values multiplied by powerScalar
+    */
+    ASHPLookup(const SiteData& siteData, float powerScalar, float sendTemperature);
 
-private:
+    HeatpumpValues Lookup(float airTemp) const;
+
+    /**
+    * Lookup the values scaled by powerScalar
+    * This allows a single reference (1kW) table to be shared by heatpumps of any size
+    */
+    HeatpumpValues Lookup(float airTemp, float powerScalar) const {
+        HeatpumpValues values = Lookup(airTemp);
+        return { values.Heat_h * powerScalar, values.Load_e * powerScalar };
+    }
 
-    void precomputeLookupTable(const SiteData& siteData, const HeatPumpData& hp, float sendTemp);
+    size_t ownedBytes() const {
+        return sizeof(float) * (mInputByDegree.capacity() + mOutputByDegree.capacity());
+    }
+
+private:
 
-    float computeInput(const SiteData& siteData, float sendTemp, float airTemp) const;
-    float computeOutput(const SiteData& siteData, float sendTemp, float airTemp) const;
+    void precomputeLookupTable(const SiteData& siteData, float powerScalar, float sendTemp);
 
     int airTempToRowIndex(const SiteData& siteData, float airTemp) const;
     int sendTempToColIndex(const SiteData& siteData, float sendTemp) const;
@@ -43,3 +63,55 @@ private:
     int mOffset;
 
 };
+
+/**
+* The performance of a heatpump at the air temperature of every timestep, for a single send temperature
+*
+* The values are for the reference (1kW) heatpump; multiply by heat_power * timestep_hours for a specific heatpump.
+* These depend only on the SiteData, so can be shared by every scenario.
+*/
+struct HeatPumpProfile {
+    year_TS heat_h;
+    year_TS load_e;
+};
+
+HeatPumpProfile makeAmbientHeatPumpProfile(const SiteData& siteData, const ASHPLookup& reference);
+
+/**
+* The performance of a hotroom heatpump of a specific size at every timestep
+*
+* ambient is the reference profile scaled by the heatpump's power per timestep,
+* which is also the most electricity the heatpump can draw in each timestep.
+* hotRoom is its performance at the (fixed) hotroom temperature.
+*/
+struct HotRoomProfile {
+    HeatPumpProfile ambient;
+    HeatpumpValues hotRoom;
+};
+
+HotRoomProfile makeHotRoomProfile(const ASHPLookup& reference, const HeatPumpProfile& ambientProfile,
+    float powerScalar, float hotroomTemp);
+
+/**
+* The HotRoomProfile of each (power per timestep, hotroom temperature) a Simulator's scenarios have used
+*
+* The scenarios of an optimisation draw their heatpumps from a handful of sizes,
+* so each profile is calculated once and shared by every scenario that uses it.
+* It is cleared once it holds MAX_ENTRIES, which bounds its memory. This is internally synchronised.
+*/
+class HotRoomProfileCache {
+public:
+    static constexpr size_t MAX_ENTRIES = 64;
+
+    std::shared_ptr<const HotRoomProfile> get(const ASHPLookup& reference, const HeatPumpProfile& ambientProfile,
+        float powerScalar, float hotroomTemp);
+
+    size_t size() const;
+
+    // the heap memory in bytes held by the cached profiles
+    size_t ownedBytes() const;
+
+private:
+    mutable std::mutex mMutex;
+    std::map<std::pair<float, float>, std::shared_ptr<const HotRoomProfile>> mProfiles;
+};
@@ -14,7 +14,8 @@
 class AmbientHeatPump {
 
 public:
-	AmbientHeatPump(const SiteData& siteData, const HeatPumpData& hp, bool suppliesDHW) :
+	AmbientHeatPump(const SiteData& siteData, const HeatPumpData& hp, bool suppliesDHW,
+		const HeatPumpProfile& dhwProfile, const HeatPumpProfile& chProfile) :
 		// Initialise results data vectors with all values to zero
 		mDHWload_e(Eigen::VectorXf::Zero(siteData.timesteps)),	// ASHP electrical load
 		mDHWout_h(Eigen::VectorXf::Zero(siteData.timesteps)),	// ASHP heat output
@@ -23,73 +24,55 @@ public:
 		mFreeHeat_h(Eigen::VectorXf::Zero(siteData.timesteps)),	// ASHP heat from ambient
 		// Initialise Persistent Values
 		DHW_OUT_TEMP(60),	// FUTURE: removed when taskData.ASHP_DHWtemp available
-		mASHPperfDHW(siteData, hp, FIXED_SEND_TEMP_VAL),	// lookup object for DHW performance
-		mASHPperfCH(siteData, hp, FIXED_SEND_TEMP_VAL),	// lookup object for CH performance
+		mDHWProfile(dhwProfile),	// reference performance at the DHW send temperature
+		mCHProfile(chProfile),	// reference performance at the CH send temperature
+		// The profiles are for a 1KW heatpump, so we scale them by the modelled ASHP Power per timestep
+		mPowerScalar(hp.heat_power * siteData.timestep_hours),
 		mTimesteps(siteData.timesteps),
 		mHeatpumpSuppliesDHW(suppliesDHW),
 		mHeatpumpSuppliesCentralHeating(true),		// FUTURE: read value from (new) taskData value or use ASHP_RadTemp not zero
 		mHeatPumpMax_h(0),
 		mHeatPumpMax_e(0),
-		mMaxElec_e(0.0f),
-		mAmbientTemperature(siteData.air_temperature)	// Ambient Temperature
+		mMaxElec_e(0.0f)
 	{
 		mResidualCapacity = Eigen::VectorXf::Constant(siteData.timesteps, 1.0f);// Remaining heatpump capacity
 	}
 
 	void AllCalcs(TempSum& tempSum) {
 		// Applies fixed precedence: hot water is served before central heating
-
-		for (size_t t = 0; t < mTimesteps; t++) {
-
-			if (mHeatpumpSuppliesDHW) {
-				// Lookup performances for DHW (hot water) output temperature
-				HeatpumpValues ambientDHW = mASHPperfDHW.Lookup(mAmbientTemperature[t]);
-
-				// Adjust output and load to meet heating demand
-				if (ambientDHW.Heat_h <= 0) {	// If no HeatPump capacity, set values to zero
-					mDHWout_h[t] = 0;
-					mDHWload_e[t] = 0;
-					mResidualCapacity[t] = 0;
-				}
-				else if (tempSum.DHW_load_h[t] <= ambientDHW.Heat_h) {	// Adjust values to load
-					mDHWout_h[t] = tempSum.DHW_load_h[t];
-					mDHWload_e[t] = ambientDHW.Load_e * mDHWout_h[t] / ambientDHW.Heat_h;
-					mResidualCapacity[t] = 1 - mDHWout_h[t] / ambientDHW.Heat_h;
-				}
-				else {	// ASHP cannot meet heating target, so will do maximum capacity
-					mDHWout_h[t] = ambientDHW.Heat_h;
-					mDHWload_e[t] = ambientDHW.Load_e;
-					mResidualCapacity[t] = 0;
-				}
-			}
-			mFreeHeat_h[t] = mDHWout_h[t] - mDHWload_e[t];	// How much heat from ambient
-
-			if (mHeatpumpSuppliesCentralHeating) {
-				// Lookup performances for CH (central heating) output temperature
-				HeatpumpValues ambientCH = mASHPperfCH.Lookup(mAmbientTemperature[t]);
-
-				mHeatPumpMax_h = ambientCH.Heat_h * mResidualCapacity[t];
-				mHeatPumpMax_e = ambientCH.Load_e * mResidualCapacity[t];
-				
-				// Adjust output and load to meet heating demand
-				if (mHeatPumpMax_h <= 0) {	// If no HeatPump capacity, set values to zero
-					mCHout_h[t] = 0;
-					mCHload_e[t] = 0;
-					mResidualCapacity[t] = 0;
-				}
-				else if (tempSum.Heat_h[t] <= mHeatPumpMax_h) {	// Adjust values to load
-					mCHout_h[t] = tempSum.Heat_h[t];
-					mCHload_e[t] = mHeatPumpMax_e * mCHout_h[t] / mHeatPumpMax_h;
-					mResidualCapacity[t] = mResidualCapacity[t] * (1 - mCHout_h[t] / mHeatPumpMax_h);
-				}
-				else {	// ASHP cannot meet heating target, so will do maximum capacity
-					mCHout_h[t] = mHeatPumpMax_h;
-					mCHload_e[t] = mHeatPumpMax_e;
-					mResidualCapacity[t] = 0;
-				}
-			}
-			mFreeHeat_h[t] = mFreeHeat_h[t] + mCHout_h[t] - mCHload_e[t];
+		// The performance at each timestep is already known, so every timestep is calculated at once
+
+		if (mHeatpumpSuppliesDHW) {
+			const auto maxHeat_h = mDHWProfile.heat_h.array() * mPowerScalar;
+			const auto maxLoad_e = mDHWProfile.load_e.array() * mPowerScalar;
+			const auto hasCapacity = maxHeat_h > 0.0f;
+			const auto meetsDemand = tempSum.DHW_load_h.array() <= maxHeat_h;
+
+			// If no HeatPump capacity, set values to zero
+			// otherwise adjust values to the load, or do maximum capacity if the heating target can't be met
+			mDHWout_h = hasCapacity.select(meetsDemand.select(tempSum.DHW_load_h.array(), maxHeat_h), 0.0f).matrix();
+			mDHWload_e = hasCapacity.select(
+				meetsDemand.select(maxLoad_e * mDHWout_h.array() / maxHeat_h, maxLoad_e), 0.0f).matrix();
+			mResidualCapacity = hasCapacity.select(
+				meetsDemand.select(1.0f - mDHWout_h.array() / maxHeat_h, 0.0f), 0.0f).matrix();
+		}
+		mFreeHeat_h = mDHWout_h - mDHWload_e;	// How much heat from ambient
+
+		if (mHeatpumpSuppliesCentralHeating) {
+			const auto maxHeat_h = mCHProfile.heat_h.array() * mPowerScalar * mResidualCapacity.array();
+			const auto maxLoad_e = mCHProfile.load_e.array() * mPowerScalar * mResidualCapacity.array();
+			const auto hasCapacity = maxHeat_h > 0.0f;
+			const auto meetsDemand = tempSum.Heat_h.array() <= maxHeat_h;
+
+			mCHout_h = hasCapacity.select(meetsDemand.select(tempSum.Heat_h.array(), maxHeat_h), 0.0f).matrix();
+			mCHload_e = hasCapacity.select(
+				meetsDemand.select(maxLoad_e * mCHout_h.array() / maxHeat_h, maxLoad_e), 0.0f).matrix();
+			// each coefficient only depends on the same timestep, so the residual capacity can be updated in place
+			mResidualCapacity = hasCapacity.select(
+				meetsDemand.select(mResidualCapacity.array() * (1.0f - mCHout_h.array() / maxHeat_h), 0.0f), 0.0f).matrix();
 		}
+		mFreeHeat_h = mFreeHeat_h + mCHout_h - mCHload_e;
+
 		tempSum.Elec_e = tempSum.Elec_e + mDHWload_e + mCHload_e;
 		tempSum.DHW_load_h = tempSum.DHW_load_h - mDHWout_h;
 		tempSum.Heat_h = tempSum.Heat_h - mCHout_h;
@@ -108,7 +91,7 @@ public:
 		else {
 			if (mHeatpumpSuppliesDHW) {
 				// Lookup performances for DHW (hot water) output temperature
-				HeatpumpValues ambientDHW = mASHPperfDHW.Lookup(mAmbientTemperature[t]);
+				HeatpumpValues ambientDHW = performanceAt(mDHWProfile, t);
 
 				// Adjust output and load to meet heating demand
 				if (ambientDHW.Heat_h <= 0) {	// If no HeatPump capacity, set values to zero
@@ -146,7 +129,7 @@ public:
 		else {
 			if (mHeatpumpSuppliesCentralHeating) {
 				// Lookup performances for CH (central heating) output temperature
-				HeatpumpValues ambientCH = mASHPperfCH.Lookup(mAmbientTemperature[t]);
+				HeatpumpValues ambientCH = performanceAt(mCHProfile, t);
 				
 				mHeatPumpMax_h = ambientCH.Heat_h * mResidualCapacity[t];
 				mHeatPumpMax_e = ambientCH.Load_e * mResidualCapacity[t];
@@ -183,17 +166,22 @@ public:
 	}
 
 	// Public output data, create private ASHP object in parent
-	year_TS mDHWload_e;
-	year_TS mDHWout_h;
-	year_TS mCHload_e;
-	year_TS mCHout_h;
-	year_TS mFreeHeat_h;
+	PooledTS mDHWload_e;
+	PooledTS mDHWout_h;
+	PooledTS mCHload_e;
+	PooledTS mCHout_h;
+	PooledTS mFreeHeat_h;
 
 private:
+	HeatpumpValues performanceAt(const HeatPumpProfile& profile, int t) const {
+		return { profile.heat_h[t] * mPowerScalar, profile.load_e[t] * mPowerScalar };
+	}
+
 	const int DHW_OUT_TEMP;
 
-	ASHPLookup mASHPperfDHW;
-	ASHPLookup mASHPperfCH;
+	const HeatPumpProfile& mDHWProfile;
+	const HeatPumpProfile& mCHProfile;
+	const float mPowerScalar;
 
 	const size_t mTimesteps;
 	bool mHeatpumpSuppliesDHW;
@@ -203,6 +191,5 @@ private:
 	float mElecResidual_e;
 	float mMaxElec_e;
 
-	const year_TS mAmbientTemperature;
-	year_TS mResidualCapacity;
+	PooledTS mResidualCapacity;
 };
\ No newline at end of file
@@ -0,0 +1,185 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <type_traits>
+
+#include "TempSum.hpp"
+#include "EV.hpp"
+#include "Components/DataCentre.hpp"
+#include "Components/ESS/ESS.hpp"
+
+/**
+* The balancing loop steps the components that react to the per-timestep energy balance.
+*
+* Which components are present (and the BatteryMode of the ESS) is fixed for a scenario,
+* so the loop is instantiated for each combination and selected once per scenario.
+* This lets the compiler inline the component steps and keeps the branches out of the loop.
+*
+* The loop runs over the timesteps [begin, end). The components carry their state from one call to the next,
+* so the timeseries can be balanced a range at a time (in order) with the same result as all at once.
+*/
+
+// Which of the ESS StepCalc variants the loop should use
+enum class ESSKernel { NONE, CONSUME, CONSUME_PLUS, PRICE_LOOKAHEAD, CARBON_LOOKAHEAD };
+
+// The DataCentre template parameter when there is no DataCentre in the balancing loop
+struct NoBalancingDataCentre {};
+
+template <ESSKernel essKernel, bool evBalancing, typename DataCentreT>
+void balancingLoopKernel(
+	TempSum& tempSum, size_t begin, size_t end, float availableGridImport,
+	BasicESS* ess, BasicElectricVehicle* ev, DataCentreT* dataCentre)
+{
+	constexpr bool dcBalancing = !std::is_same_v<DataCentreT, NoBalancingDataCentre>;
+
+	auto availDisch = [&]() {
+		if constexpr (essKernel == ESSKernel::NONE) {
+			return 0.0f;
+		}
+		else {
+			return ess->AvailDisch();
+		}
+	};
+
+	// Without an ESS nothing carries from one timestep to the next: the EV only reads its own timestep of the balance
+	// and a BasicDataCentre only the grid import, so each is calculated over the whole timeseries at once
+	// (the DataCentreWithASHP steps its heatpump, so is left to the loop, as is a range of the timeseries)
+	if constexpr (essKernel == ESSKernel::NONE && !std::is_same_v<DataCentreT, DataCentreWithASHP>) {
+		if (begin == 0 && end == static_cast<size_t>(tempSum.Elec_e.size())) {
+			if constexpr (evBalancing && dcBalancing) {
+				ev->StepCalcAll(tempSum, availableGridImport - dataCentre->getTargetLoads().array());
+			}
+			else if constexpr (evBalancing) {
+				ev->StepCalcAll(tempSum, Eigen::ArrayXf::Constant(static_cast<Eigen::Index>(end), availableGridImport));
+			}
+			if constexpr (dcBalancing) {
+				dataCentre->StepCalcAll(tempSum, availableGridImport);
+			}
+			return;
+		}
+	}
+
+	for (size_t t = begin; t < end; t++) {
+		float futureEnergy = 0.0f;
+
+		if constexpr (evBalancing) {
+			// This represents the logic in M-VEST v0-7:
+			// EV is curtailed before the Data Centre
+			futureEnergy = availableGridImport + availDisch();
+			if constexpr (dcBalancing) {
+				futureEnergy -= dataCentre->getTargetLoad(t);
+			}
+			ev->StepCalc(tempSum, futureEnergy, t);
+		}
+
+		if constexpr (dcBalancing) {
+			futureEnergy = availableGridImport + availDisch();
+			dataCentre->StepCalc(tempSum, futureEnergy, t);
+		}
+
+		if constexpr (essKernel == ESSKernel::CONSUME) {
+			ess->template StepCalcMode<BatteryMode::CONSUME>(tempSum, availableGridImport, t);
+		}
+		else if constexpr (essKernel == ESSKernel::CONSUME_PLUS) {
+			ess->template StepCalcMode<BatteryMode::CONSUME_PLUS>(tempSum, availableGridImport, t);
+		}
+		else if constexpr (essKernel == ESSKernel::PRICE_LOOKAHEAD) {
+			ess->template StepCalcMode<BatteryMode::PRICE_LOOKAHEAD>(tempSum, availableGridImport, t);
+		}
+		else if constexpr (essKernel == ESSKernel::CARBON_LOOKAHEAD) {
+			ess->template StepCalcMode<BatteryMode::CARBON_LOOKAHEAD>(tempSum, availableGridImport, t);
+		}
+	}
+}
+
+// Which kind of DataCentre balances, if any
+enum class BalancingDataCentre { NONE, BASIC, WITH_ASHP };
+
+// A balancing loop kernel, taking the components as their base classes (null if they don't balance)
+using BalancingLoopFn = void (*)(TempSum& tempSum, size_t begin, size_t end, float availableGridImport,
+	BasicESS* ess, BasicElectricVehicle* ev, DataCentre* dataCentre);
+
+template <ESSKernel essKernel, bool evBalancing, typename DataCentreT>
+void balancingLoopEntry(
+	TempSum& tempSum, size_t begin, size_t end, float availableGridImport,
+	BasicESS* ess, BasicElectricVehicle* ev, DataCentre* dataCentre)
+{
+	if constexpr (std::is_same_v<DataCentreT, NoBalancingDataCentre>) {
+		balancingLoopKernel<essKernel, evBalancing, NoBalancingDataCentre>(tempSum, begin, end, availableGridImport, ess, ev, nullptr);
+	}
+	else {
+		balancingLoopKernel<essKernel, evBalancing>(tempSum, begin, end, availableGridImport, ess, ev, static_cast<DataCentreT*>(dataCentre));
+	}
+}
+
+template <ESSKernel essKernel, bool evBalancing>
+BalancingLoopFn selectDataCentre(BalancingDataCentre dataCentre)
+{
+	switch (dataCentre) {
+	case BalancingDataCentre::BASIC:
+		return &balancingLoopEntry<essKernel, evBalancing, BasicDataCentre>;
+	case BalancingDataCentre::WITH_ASHP:
+		return &balancingLoopEntry<essKernel, evBalancing, DataCentreWithASHP>;
+	default:
+		return &balancingLoopEntry<essKernel, evBalancing, NoBalancingDataCentre>;
+	}
+}
+
+template <ESSKernel essKernel>
+BalancingLoopFn selectEV(bool evBalancing, BalancingDataCentre dataCentre)
+{
+	return evBalancing
+		? selectDataCentre<essKernel, true>(dataCentre)
+		: selectDataCentre<essKernel, false>(dataCentre);
+}
+
+/**
+* The balancing loop kernel for the components that balance, given the mode of the ESS if there is one
+* This is null when there is nothing to balance
+*/
+inline BalancingLoopFn selectBalancingLoop(std::optional<BatteryMode> essMode, bool evBalancing, BalancingDataCentre dataCentre)
+{
+	if (!essMode) {
+		if (!evBalancing && dataCentre == BalancingDataCentre::NONE) {
+			return nullptr;
+		}
+		return selectEV<ESSKernel::NONE>(evBalancing, dataCentre);
+	}
+
+	switch (*essMode) {
+	case BatteryMode::CONSUME_PLUS:
+		return selectEV<ESSKernel::CONSUME_PLUS>(evBalancing, dataCentre);
+	case BatteryMode::PRICE_LOOKAHEAD:
+		return selectEV<ESSKernel::PRICE_LOOKAHEAD>(evBalancing, dataCentre);
+	case BatteryMode::CARBON_LOOKAHEAD:
+		return selectEV<ESSKernel::CARBON_LOOKAHEAD>(evBalancing, dataCentre);
+	default:
+		return selectEV<ESSKernel::CONSUME>(evBalancing, dataCentre);
+	}
+}
+
+/**
+* Run the balancing loop for a scenario
+*
+* ev and dataCentre should only be provided if they are balancing; ess may be null if there is no ESS
+* When none of them are present there is nothing to balance, so the loop is skipped entirely
+* (simulateTimesteps selects the kernel once per shape of scenario in its ExecutionPlan instead)
+*/
+inline void runBalancingLoop(
+	TempSum& tempSum, size_t timesteps, float availableGridImport,
+	BasicESS* ess, BasicElectricVehicle* ev, DataCentre* dataCentre)
+{
+	BalancingDataCentre dataCentreKind = BalancingDataCentre::NONE;
+	if (dynamic_cast<DataCentreWithASHP*>(dataCentre)) {
+		dataCentreKind = BalancingDataCentre::WITH_ASHP;
+	}
+	else if (dataCentre) {
+		dataCentreKind = BalancingDataCentre::BASIC;
+	}
+
+	const std::optional<BatteryMode> essMode = ess ? std::optional<BatteryMode>(ess->getMode()) : std::nullopt;
+	if (BalancingLoopFn loop = selectBalancingLoop(essMode, ev != nullptr, dataCentreKind)) {
+		loop(tempSum, 0, timesteps, availableGridImport, ess, ev, dataCentre);
+	}
+}
@@ -0,0 +1,136 @@
+#include "BatchBackend.hpp"
+
+#include <algorithm>
+#include <format>
+#include <stdexcept>
+#include <vector>
+
+#ifdef EPOCH_CUDA
+#include "CudaBalancing.hpp"
+#endif
+
+namespace {
+	class CpuBatchBackend final : public BatchBackend {
+	public:
+		explicit CpuBatchBackend(size_t maxLanes) :
+			mMaxLanes(maxLanes)
+		{}
+
+		std::string name() const override { return "cpu"; }
+
+		size_t maxLanes() const override { return mMaxLanes; }
+
+		void balance(std::span<const LockstepLane> lanes, size_t timesteps, ThreadPool& pool) override {
+			const size_t groups = (lanes.size() + LOCKSTEP_LANES - 1) / LOCKSTEP_LANES;
+			pool.parallelFor(groups, [&](size_t g) {
+				const size_t first = g * LOCKSTEP_LANES;
+				runLockstepBalancingLoop(lanes.subspan(first, std::min(LOCKSTEP_LANES, lanes.size() - first)), timesteps);
+			});
+		}
+
+	private:
+		const size_t mMaxLanes;
+	};
+
+#ifdef EPOCH_CUDA
+	class CudaBatchBackend final : public BatchBackend {
+	public:
+		CudaBatchBackend(int device, size_t maxLanes) :
+			mBalancer(device),
+			mMaxLanes(maxLanes)
+		{}
+
+		std::string name() const override { return std::format("cuda ({})", mBalancer.deviceName()); }
+
+		size_t maxLanes() const override { return mMaxLanes; }
+
+		void balance(std::span<const LockstepLane> lanes, size_t timesteps, ThreadPool& pool) override {
+			if (lanes.empty()) {
+				return;
+			}
+			checkLockstepLanes(lanes);
+			const bool withESS = lanes.front().ess != nullptr;
+			const bool withEV = lanes.front().ev != nullptr;
+
+			// interleave the lanes (one row per timestep) as lockstepKernel does, but for the whole year
+			const size_t count = lanes.size();
+			std::vector<float> elec(count * timesteps);
+			std::vector<float> evTarget(withEV ? count * timesteps : 0);
+			std::vector<CudaLaneParameters> parameters(count);
+
+			pool.parallelFor(count, [&](size_t l) {
+				const LockstepLane& lane = lanes[l];
+				CudaLaneParameters& p = parameters[l];
+				p = CudaLaneParameters{ lane.availableGridImport, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+				if (lane.ess) {
+					const Battery& battery = lane.ess->getBattery();
+					p.soc = battery.GetSoC();
+					p.capacity = battery.GetCapacity_e();
+					p.chargeMax = battery.getChargeMax_e();
+					p.dischargeMax = battery.getDischargeMax_e();
+					p.rtlRate = battery.getRTLrate();
+				}
+				if (lane.ev) {
+					p.flexRatio = lane.ev->getFlexRatio();
+				}
+
+				const Eigen::VectorXf& laneElec = lane.tempSum->Elec_e;
+				for (size_t t = 0; t < timesteps; t++) {
+					elec[t * count + l] = laneElec[static_cast<Eigen::Index>(t)];
+				}
+				if (withEV) {
+					const auto& target = lane.ev->getTargetLoad();
+					for (size_t t = 0; t < timesteps; t++) {
+						evTarget[t * count + l] = target[static_cast<Eigen::Index>(t)];
+					}
+				}
+			});
+
+			mBalancer.balance(withESS, withEV, elec.data(), evTarget.data(), parameters.data(), count, timesteps);
+
+			pool.parallelFor(count, [&](size_t l) {
+				Eigen::VectorXf& laneElec = lanes[l].tempSum->Elec_e;
+				for (size_t t = 0; t < timesteps; t++) {
+					laneElec[static_cast<Eigen::Index>(t)] = elec[t * count + l];
+				}
+			});
+		}
+
+	private:
+		CudaBalancer mBalancer;
+		const size_t mMaxLanes;
+	};
+#endif
+}
+
+std::shared_ptr<BatchBackend> makeCpuBatchBackend(size_t maxLanes) {
+	if (maxLanes == 0) {
+		throw std::invalid_argument("A batch backend needs at least one lane");
+	}
+	return std::make_shared<CpuBatchBackend>(maxLanes);
+}
+
+#ifdef EPOCH_CUDA
+
+std::shared_ptr<BatchBackend> makeCudaBatchBackend(int device, size_t maxLanes) {
+	if (maxLanes == 0) {
+		throw std::invalid_argument("A batch backend needs at least one lane");
+	}
+	return std::make_shared<CudaBatchBackend>(device, maxLanes);
+}
+
+bool cudaSupported() {
+	return true;
+}
+
+#else
+
+std::shared_ptr<BatchBackend> makeCudaBatchBackend(int, size_t) {
+	throw std::runtime_error("Epoch was built without CUDA support (configure with -DEPOCH_CUDA=ON)");
+}
+
+bool cudaSupported() {
+	return false;
+}
+
+#endif
@@ -0,0 +1,57 @@
+/*
+logic for offloading the lock-step balancing of a batch to a backend (see Simulator::enableBatchBackend)
+*/
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <string>
+
+#include "LockstepBalancing.hpp"
+#include "ThreadPool.hpp"
+
+/**
+* Something that runs the lock-step balancing loop for many scenarios at once
+*
+* With a backend, simulateBatch prepares the lock-step scenarios of a batch a wave at a time,
+* balances all of the lanes of the wave with the backend, and then finishes them.
+* The components before and after the balancing loop (and the metrics) are always run on the CPU,
+* so a backend only needs to run the recurrence of runLockstepBalancingLoop.
+*
+* A backend must give the same energy balances as runLockstepBalancingLoop and may be called by several batches at once.
+*/
+class BatchBackend {
+public:
+	virtual ~BatchBackend() = default;
+
+	virtual std::string name() const = 0;
+
+	/**
+	* The most lanes to prepare before balancing them
+	* Every lane holds a scenario's timeseries until it is finished, so this bounds the memory of a wave
+	*/
+	virtual size_t maxLanes() const = 0;
+
+	/**
+	* Run the balancing loop for (up to maxLanes) scenarios
+	* Every lane must have the same components, with any ESS in CONSUME mode (as for runLockstepBalancingLoop)
+	* pool is the batch's pool, which the backend may use while the batch waits for it
+	*/
+	virtual void balance(std::span<const LockstepLane> lanes, size_t timesteps, ThreadPool& pool) = 0;
+};
+
+/**
+* The reference backend, which balances LOCKSTEP_LANES lanes at a time across the batch's pool
+*/
+std::shared_ptr<BatchBackend> makeCpuBatchBackend(size_t maxLanes = 32 * LOCKSTEP_LANES);
+
+/**
+* A backend that balances one lane per thread on a CUDA device
+* A device only has enough threads to hide its latency with thousands of lanes, so its waves are larger
+* Raise a runtime_error if Epoch was built without CUDA support or there is no such device
+*/
+std::shared_ptr<BatchBackend> makeCudaBatchBackend(int device = 0, size_t maxLanes = 4096);
+
+// whether Epoch was built with CUDA support (configure with -DEPOCH_CUDA=ON)
+bool cudaSupported();
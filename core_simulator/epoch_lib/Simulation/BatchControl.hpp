@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <limits>
+
+/**
+* Cooperative cancellation, a deadline and progress counters for a long-running batch
+*
+* A batch checks stopRequested before each scenario (and a ChunkedSimulator before each window),
+* so work that has started always finishes and the cost of checking is amortised over a whole simulation.
+* Work that hasn't started when the batch stops is skipped, and its result has cancelled set.
+*
+* Every member is a lock-free atomic, so any thread may cancel or poll the progress at any time without blocking the workers.
+* The counters accumulate, so one BatchControl may follow several batches.
+*/
+class BatchControl {
+public:
+	using Clock = std::chrono::steady_clock;
+
+	BatchControl() = default;
+	BatchControl(const BatchControl&) = delete;
+	BatchControl& operator=(const BatchControl&) = delete;
+
+	// stop as soon as the work that has started is finished
+	void cancel() noexcept { mCancelled.store(true, std::memory_order_relaxed); }
+
+	// stop once the deadline has passed
+	void setDeadline(Clock::time_point deadline) noexcept {
+		mDeadline.store(deadline.time_since_epoch().count(), std::memory_order_relaxed);
+	}
+
+	void setTimeout(Clock::duration timeout) noexcept { setDeadline(Clock::now() + timeout); }
+
+	bool cancelled() const noexcept { return mCancelled.load(std::memory_order_relaxed); }
+
+	bool deadlinePassed() const noexcept {
+		return Clock::now().time_since_epoch().count() > mDeadline.load(std::memory_order_relaxed);
+	}
+
+	// whether the remaining work should be skipped
+	bool stopRequested() const noexcept { return cancelled() || deadlinePassed(); }
+
+	// the units of work (scenarios, members or windows) that have been queued, completed and skipped
+	size_t total() const noexcept { return mTotal.load(std::memory_order_relaxed); }
+	size_t completed() const noexcept { return mCompleted.load(std::memory_order_relaxed); }
+	size_t skipped() const noexcept { return mSkipped.load(std::memory_order_relaxed); }
+
+	// called by the batch as it queues and finishes its work
+	void addTotal(size_t count) noexcept { mTotal.fetch_add(count, std::memory_order_relaxed); }
+	void addCompleted(size_t count = 1) noexcept { mCompleted.fetch_add(count, std::memory_order_relaxed); }
+	void addSkipped(size_t count = 1) noexcept { mSkipped.fetch_add(count, std::memory_order_relaxed); }
+
+private:
+	std::atomic<bool> mCancelled{ false };
+	std::atomic<Clock::rep> mDeadline{ std::numeric_limits<Clock::rep>::max() };
+	std::atomic<size_t> mTotal{ 0 };
+	std::atomic<size_t> mCompleted{ 0 };
+	std::atomic<size_t> mSkipped{ 0 };
+};
@@ -0,0 +1,93 @@
+#include "BatchPlan.hpp"
+
+#include <algorithm>
+#include <array>
+#include <numeric>
+
+#include "Flags.hpp"
+#include "LockstepBalancing.hpp"
+#include "PreBalancingCache.hpp"
+
+size_t BatchLocality::siteColumns() const {
+	size_t h = 0;
+	hash_combine(h, heat_load, solar_yields, tariff_index, heat_source, heat_power, send_temp);
+	return h;
+}
+
+BatchLocality batchLocality(const TaskData& taskData) {
+	BatchLocality locality;
+	if (taskData.building) {
+		locality.heat_load = taskData.building->fabric_intervention_index + 1;
+	}
+	for (const SolarData& panel : taskData.solar_panels) {
+		locality.solar_yields |= uint64_t{ 1 } << (static_cast<unsigned>(panel.yield_index) % 64);
+	}
+	if (taskData.grid) {
+		locality.tariff_index = taskData.grid->tariff_index;
+	}
+	if (taskData.heat_pump) {
+		locality.heat_source = static_cast<uint32_t>(taskData.heat_pump->heat_source) + 1;
+		locality.heat_power = taskData.heat_pump->heat_power;
+		locality.send_temp = taskData.heat_pump->send_temp;
+	}
+	locality.pre_balancing = preBalancingHash(taskData);
+	return locality;
+}
+
+std::optional<size_t> lockstepGroup(const TaskData& taskData) {
+	const Flags flags(taskData);
+	if (flags.getDataCentreFlag() == DataCentreFlag::BALANCING) {
+		return std::nullopt;
+	}
+	if (taskData.energy_storage_system && taskData.energy_storage_system->battery_mode != BatteryMode::CONSUME) {
+		return std::nullopt;
+	}
+
+	const bool withESS = taskData.energy_storage_system.has_value();
+	const bool withEV = flags.getEVFlag() == EVFlag::BALANCING;
+	if (withESS && withEV) {
+		return 2;
+	}
+	if (withESS || withEV) {
+		return withEV ? 1 : 0;
+	}
+	return std::nullopt;
+}
+
+BatchPlan planBatch(std::span<const TaskData> taskData, bool lockstep) {
+	std::vector<BatchLocality> localities;
+	localities.reserve(taskData.size());
+	for (const TaskData& scenario : taskData) {
+		localities.push_back(batchLocality(scenario));
+	}
+
+	// (stable, so that scenarios with the same locality keep the order they were given in)
+	std::vector<size_t> order(taskData.size());
+	std::iota(order.begin(), order.end(), size_t{ 0 });
+	std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return localities[a] < localities[b]; });
+
+	BatchPlan plan;
+	std::array<std::vector<size_t>, 3> groups;
+	for (size_t i : order) {
+		const auto group = lockstep ? lockstepGroup(taskData[i]) : std::nullopt;
+		if (group) {
+			groups[*group].push_back(i);
+		}
+		else {
+			plan.jobs.push_back({ i });
+		}
+	}
+
+	for (const auto& group : groups) {
+		for (size_t first = 0; first < group.size(); first += LOCKSTEP_LANES) {
+			const size_t last = std::min(first + LOCKSTEP_LANES, group.size());
+			plan.jobs.emplace_back(group.begin() + static_cast<std::ptrdiff_t>(first), group.begin() + static_cast<std::ptrdiff_t>(last));
+		}
+	}
+
+	plan.affinity.reserve(plan.jobs.size());
+	for (const auto& job : plan.jobs) {
+		plan.affinity.push_back(localities[job.front()].siteColumns());
+	}
+	return plan;
+}
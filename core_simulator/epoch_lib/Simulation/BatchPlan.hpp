@@ -0,0 +1,61 @@
+#pragma once
+
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "TaskData.hpp"
+
+/**
+* The parts of a scenario that select the state it shares with other scenarios
+*
+* These are the columns of the SiteData that it reads and the heatpump that scales the COP tables (its site columns),
+* and its state before the balancing loop (see PreBalancingKey).
+* Scenarios with the same site columns that run one after another on a thread find those columns in its cache,
+* and those that also share a pre-balancing state reuse the one snapshot from the PreBalancingCache.
+*/
+struct BatchLocality {
+	// 0 without a building, and otherwise its fabric_intervention_index + 1
+	size_t heat_load = 0;
+	// a bit for each solar yield column (modulo 64)
+	uint64_t solar_yields = 0;
+	size_t tariff_index = 0;
+	// 0 without a heatpump, and otherwise its HeatSource + 1
+	uint32_t heat_source = 0;
+	float heat_power = 0.0f;
+	float send_temp = 0.0f;
+	// the hash of the scenario's PreBalancingKey
+	size_t pre_balancing = 0;
+
+	// a hash of the site columns alone
+	size_t siteColumns() const;
+
+	auto operator<=>(const BatchLocality&) const = default;
+};
+
+BatchLocality batchLocality(const TaskData& taskData);
+
+/**
+* The group of scenarios that a scenario can be balanced in lock-step with, if any
+* (0 = ESS only, 1 = EV only, 2 = both)
+*/
+std::optional<size_t> lockstepGroup(const TaskData& taskData);
+
+/**
+* How a batch of scenarios is split into jobs for ThreadPool::parallelForByCost
+*
+* The scenarios are ordered by their BatchLocality, so that neighbouring jobs share as much state as they can.
+* With lockstep, the scenarios that can be balanced in lock-step are grouped (in that order) LOCKSTEP_LANES at a time,
+* so the lanes of a group mostly read the same columns; every other scenario is a job of its own.
+* The affinity of a job is the site columns of its first scenario, which keeps the jobs that read the same columns
+* in the same lane (and one after another) while the lanes stay balanced.
+*/
+struct BatchPlan {
+	std::vector<std::vector<size_t>> jobs;
+	std::vector<size_t> affinity;
+};
+
+BatchPlan planBatch(std::span<const TaskData> taskData, bool lockstep);
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// The counters and memory use of one of the Simulator's caches
+struct CacheStats {
+	uint64_t hits = 0;
+	uint64_t misses = 0;
+	uint64_t evictions = 0;
+	size_t entries = 0;
+	// the (estimated) memory in bytes held by the cache and the maximum it may hold
+	size_t bytes = 0;
+	size_t byte_budget = 0;
+};
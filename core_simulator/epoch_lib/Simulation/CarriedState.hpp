@@ -0,0 +1,17 @@
+#pragma once
+
+#include <optional>
+
+/**
+* The state of a scenario's components that carries over from one window of timesteps to the next
+*
+* Each value is unset until a window with that component has been simulated,
+* so the first window starts from the TaskData just as a full simulation does.
+* The other components (including the EV and data centre) decide each timestep afresh, so have nothing to carry.
+*/
+struct CarriedState {
+	// the charge of the ESS in kWh
+	std::optional<float> ess_charge;
+	// the heat stored in the hot water cylinder in kWh
+	std::optional<float> cylinder_energy;
+};
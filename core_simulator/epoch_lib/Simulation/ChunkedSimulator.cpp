@@ -0,0 +1,116 @@
+#include "ChunkedSimulator.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <format>
+#include <stdexcept>
+
+#include "RepresentativeDays.hpp"
+
+ChunkedSimulator::ChunkedSimulator(std::shared_ptr<const SiteData> siteData, TaskConfig config, size_t windowDays) :
+	ChunkedSimulator(std::move(siteData), std::move(config), windowDays, SimulationCheckpoint{})
+{
+}
+
+ChunkedSimulator::ChunkedSimulator(std::shared_ptr<const SiteData> siteData, TaskConfig config, size_t windowDays,
+	const SimulationCheckpoint& baseline) :
+	mSiteData(siteData ? std::move(siteData) : throw std::runtime_error("ChunkedSimulator requires a SiteData")),
+	mConfig(config),
+	mTimestepsPerDay(0),
+	mWindowTimesteps(0),
+	mBaselineCheckpoint(baseline)
+{
+	constexpr std::chrono::seconds DAY{ 24 * 60 * 60 };
+	if (windowDays == 0) {
+		throw std::runtime_error("A ChunkedSimulator needs windows of at least one day");
+	}
+	if (DAY % mSiteData->timestep_interval_s != std::chrono::seconds{ 0 }) {
+		throw std::runtime_error(std::format("A day is not a whole number of {}s timesteps", mSiteData->timestep_interval_s.count()));
+	}
+	// the windows start on whole days, so that each day's tariff statistics are the same as in the whole SiteData
+	mTimestepsPerDay = static_cast<size_t>(DAY / mSiteData->timestep_interval_s);
+	mWindowTimesteps = windowDays * mTimestepsPerDay;
+
+	mSummary = std::unique_ptr<Simulator>(new Simulator(mSiteData, mConfig, nullptr, Simulator::Part::Summary));
+	simulateWindows(mSiteData->baseline, mBaselineCheckpoint, {}, nullptr);
+	mSummary->setBaseline(mBaselineCheckpoint.totals);
+}
+
+size_t ChunkedSimulator::numWindows() const {
+	return (mSiteData->timesteps + mWindowTimesteps - 1) / mWindowTimesteps;
+}
+
+SimulationResult ChunkedSimulator::simulateScenario(const TaskData& taskData, const WindowReporter& reporter) const {
+	SimulationCheckpoint checkpoint;
+	return resumeScenario(taskData, checkpoint, reporter);
+}
+
+SimulationResult ChunkedSimulator::resumeScenario(const TaskData& taskData, SimulationCheckpoint& checkpoint, const WindowReporter& reporter,
+	BatchControl* control) const {
+	auto start = std::chrono::high_resolution_clock::now();
+
+	if (const ScenarioError errors = mSummary->checkScenario(taskData); errors != ScenarioError::None) {
+		mSummary->warnInvalidScenario("Invalid scenario", taskData, errors);
+		return mSummary->makeInvalidResult(taskData);
+	}
+
+	if (!simulateWindows(taskData, checkpoint, reporter, control)) {
+		return mSummary->makeCancelledResult(taskData);
+	}
+
+	SimulationResult result{};
+	mSummary->completeResult(result, taskData, checkpoint.totals, nullptr);
+
+	std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+	result.runtime = static_cast<float>(elapsed.count());
+	return result;
+}
+
+bool ChunkedSimulator::simulateWindows(const TaskData& taskData, SimulationCheckpoint& checkpoint, const WindowReporter& reporter,
+	BatchControl* control) const {
+	if (checkpoint.timesteps > mSiteData->timesteps) {
+		throw std::runtime_error(std::format("Cannot resume after timestep {} of a SiteData with {} timesteps",
+			checkpoint.timesteps, mSiteData->timesteps));
+	}
+	if (checkpoint.timesteps % mTimestepsPerDay != 0 && checkpoint.timesteps != mSiteData->timesteps) {
+		throw std::runtime_error(std::format("Cannot resume after timestep {}, which is not the end of a day of {} timesteps",
+			checkpoint.timesteps, mTimestepsPerDay));
+	}
+
+	const size_t remaining = (mSiteData->timesteps - checkpoint.timesteps + mWindowTimesteps - 1) / mWindowTimesteps;
+	if (control) {
+		control->addTotal(remaining);
+	}
+
+	// the checkpoint is updated after each window, so it is always at the end of a window that has been simulated
+	SimulationTotals totals = checkpoint.totals;
+	CarriedState carried = checkpoint.carried;
+
+	for (size_t w = 0, first = checkpoint.timesteps; first < mSiteData->timesteps; w++, first += mWindowTimesteps) {
+		if (control && control->stopRequested()) {
+			control->addSkipped(remaining - w);
+			return false;
+		}
+
+		const size_t count = std::min(mWindowTimesteps, mSiteData->timesteps - first);
+		// each window is released before the next is taken
+		const Simulator window(std::make_shared<const SiteData>(sliceSiteData(*mSiteData, first, count)),
+			mConfig, mSummary->mCostEngine, Simulator::Part::Window);
+
+		if (reporter) {
+			ReportData reportData;
+			addWeightedTotals(totals, window.simulateWindow(taskData, &reportData, carried), 1.0f);
+			reportData.shrinkToPopulated();
+			reporter(first, reportData);
+		}
+		else {
+			addWeightedTotals(totals, window.simulateWindow(taskData, nullptr, carried), 1.0f);
+		}
+
+		checkpoint = SimulationCheckpoint{ first + count, carried, totals };
+		if (control) {
+			control->addCompleted();
+		}
+	}
+	return true;
+}
@@ -0,0 +1,101 @@
+#pragma once
+// simulation of a long SiteData one window of days at a time
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+
+#include "../Definitions.hpp"
+#include "BatchControl.hpp"
+#include "SiteData.hpp"
+#include "TaskConfig.hpp"
+#include "TaskData.hpp"
+#include "Simulate.hpp"
+
+/**
+* The state of a scenario after its first timesteps have been simulated, from which a later run can resume
+* (such as a daily re-run against the same SiteData with the latest days appended)
+*/
+struct SimulationCheckpoint {
+	// the number of timesteps simulated, from the start of the SiteData
+	size_t timesteps = 0;
+	// the state of the components after the last of those timesteps
+	CarriedState carried;
+	// the sum of the totals of those timesteps
+	SimulationTotals totals;
+};
+
+/**
+* Simulates scenarios against a long SiteData (such as several years mapped from the binary format) one window of whole days at a time
+*
+* Only the current window is copied out of the SiteData and simulated, so the memory used by a scenario
+* is bounded by the length of a window rather than that of the SiteData.
+* The charge of the ESS and the hot water cylinder carries over from each window to the next (see CarriedState),
+* and the totals of the windows are summed before the metrics are calculated once for the whole SiteData.
+* The results match those of a Simulator of the whole SiteData to within the rounding of the sums.
+*
+* A run can also resume from a SimulationCheckpoint of an earlier run against the start of the same SiteData,
+* so that only the timesteps after it are simulated.
+*/
+class ChunkedSimulator {
+public:
+	// called with the first timestep and the timeseries of each window, in order, as soon as it is simulated
+	using WindowReporter = std::function<void(size_t start, const ReportData& reportData)>;
+
+	/**
+	* Simulate the baseline window by window
+	* Raise an exception if windowDays is zero or a day is not a whole number of timesteps
+	*/
+	explicit ChunkedSimulator(std::shared_ptr<const SiteData> siteData, TaskConfig config, size_t windowDays);
+
+	/**
+	* Simulate the baseline window by window, resuming from a checkpoint of the baseline (see getBaselineCheckpoint)
+	*/
+	explicit ChunkedSimulator(std::shared_ptr<const SiteData> siteData, TaskConfig config, size_t windowDays,
+		const SimulationCheckpoint& baseline);
+
+	/**
+	* Simulate a scenario window by window, passing the timeseries of each window to reporter if it is set
+	* (the result itself has no timeseries)
+	*
+	* An invalid scenario returns the worst value for every objective, as in Simulator::simulateScenario
+	*/
+	SimulationResult simulateScenario(const TaskData& taskData, const WindowReporter& reporter = {}) const;
+
+	/**
+	* Simulate the timesteps of a scenario after the checkpoint, updating it to the end of the SiteData
+	* The result is that of the whole SiteData, though only the new windows are passed to reporter
+	*
+	* If control is set, the windows count towards its progress and control is checked before each window.
+	* Once it stops, the cancelled result is returned and the checkpoint is left after the last window that was simulated,
+	* so the scenario can be resumed from there.
+	*
+	* Raise an exception if the checkpoint is not at the start of a day within the SiteData.
+	* An invalid scenario returns the worst value for every objective and leaves the checkpoint unchanged
+	*/
+	SimulationResult resumeScenario(const TaskData& taskData, SimulationCheckpoint& checkpoint, const WindowReporter& reporter = {},
+		BatchControl* control = nullptr) const;
+
+	size_t windowTimesteps() const { return mWindowTimesteps; }
+
+	size_t numWindows() const;
+
+	const SimulationMetrics& getBaselineMetrics() const { return mSummary->baseline().metrics; }
+
+	// the checkpoint at the end of the baseline, from which a ChunkedSimulator of a longer SiteData can resume
+	const SimulationCheckpoint& getBaselineCheckpoint() const { return mBaselineCheckpoint; }
+
+private:
+	// simulate each window of a scenario after the checkpoint in turn, adding their totals to it
+	// returns false if control stopped it before the last window
+	bool simulateWindows(const TaskData& taskData, SimulationCheckpoint& checkpoint, const WindowReporter& reporter,
+		BatchControl* control) const;
+
+	const std::shared_ptr<const SiteData> mSiteData;
+	const TaskConfig mConfig;
+	size_t mTimestepsPerDay;
+	size_t mWindowTimesteps;
+	SimulationCheckpoint mBaselineCheckpoint;
+	// calculates the results of the whole SiteData, and shares its costs with the Simulator of each window
+	std::unique_ptr<Simulator> mSummary;
+};
@@ -46,12 +46,26 @@ void BasicDataCentre::StepCalc(TempSum& tempSum, const float futureEnergy_e, con
 	tempSum.Elec_e[t] += mActualLoad_e[t];
 }
 
+void BasicDataCentre::StepCalcAll(TempSum& tempSum, const float futureEnergy_e) {
+	if (futureEnergy_e <= 0) {
+		mActualLoad_e.setZero();
+	}
+	else {
+		// the largest load up to the target without breaching FutureEnergy
+		mActualLoad_e = (mTargetLoad_e.array() < futureEnergy_e).select(mTargetLoad_e.array(), futureEnergy_e).matrix();
+	}
+	tempSum.Elec_e += mActualLoad_e;
+}
 
 float BasicDataCentre::getTargetLoad(size_t timestep) {
 	return mTargetLoad_e[timestep];
 }
 
 void BasicDataCentre::Report(ReportData& reportData) const {
-	reportData.Data_centre_target_load = mTargetLoad_e;
-	reportData.Data_centre_actual_load = mActualLoad_e;
+	reportData.set(ReportColumn::Data_centre_target_load, mTargetLoad_e);
+	reportData.set(ReportColumn::Data_centre_actual_load, mActualLoad_e);
+}
+
+void BasicDataCentre::ReportTotals(SimulationTotals& totals) const {
+	totals.data_centre_load_e = seriesTotal(mActualLoad_e);
 }
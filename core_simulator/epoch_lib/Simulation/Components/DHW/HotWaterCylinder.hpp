@@ -3,6 +3,7 @@
 #include "../../TaskComponents.hpp"
 #include "../../SiteData.hpp"
 #include "../../TempSum.hpp"
+#include "../../DayBlocks.hpp"
 #include "../../DayTariffStats.hpp"
 
 class HotWaterCylinder {
@@ -10,25 +11,38 @@ class HotWaterCylinder {
 public:
 	// Constructor
 
-	HotWaterCylinder(const SiteData& siteData, const DomesticHotWater& dhw, const HeatPumpData& heatPumpData, size_t tariff_index, const DayTariffStats& tariff_stats) :
+	// The tariff_stats decide when the cylinder is charged from the grid at a low price
+	// The charging, standby loss, SoC and temperature histories are only recorded when their columns are in history
+	HotWaterCylinder(const SiteData& siteData, const DomesticHotWater& dhw, const HeatPumpData& heatPumpData, const DayTariffStats& tariff_stats, ReportColumnMask history) :
 		mCylinderVolume(dhw.cylinder_volume), // cylinder volume n litres
 		mTimesteps(siteData.timesteps),
-		mTimestep_seconds(std::chrono::duration<float>(siteData.timestep_interval_s).count()),// set up timestep seconds in constructor
 		mTimestep_hours(siteData.timestep_hours),
 		mCapacity_h(calculate_Capacity_h()), // calculate tank energy capacity in constructor
 		mCylinderStartSoC_h(0.0), // set start SoC to empty; this will cause an initial charge but not give us free energy
 		mHeat_pump_power_h(heatPumpData.heat_power), // will need to calculate energy per timestep
-		mDHW_charging(Eigen::VectorXf::Zero(siteData.timesteps)),
+		mRecordCharging(history.has(ReportColumn::DHW_charging)),
+		mRecordStandbyLoss(history.has(ReportColumn::DHW_Standby_loss)),
+		mRecordSoC(history.has(ReportColumn::DHW_SoC)),
+		mRecordTemperature(history.has(ReportColumn::DHW_ave_temperature)),
 		mDHW_discharging(siteData.dhw_demand),
-		mDHW_standby_losses(Eigen::VectorXf::Zero(siteData.timesteps)),
 		mDHW_local_shortfall(Eigen::VectorXf::Zero(siteData.timesteps)),
-		mDHW_SoC_history(Eigen::VectorXf::Zero(siteData.timesteps)),
-		mDHW_ave_temperature(Eigen::VectorXf::Zero(siteData.timesteps)),
 		mDHW_heat_pump_load_h(Eigen::VectorXf::Zero(siteData.timesteps)),
 		mDHW_diverter_load_e(Eigen::VectorXf::Zero(siteData.timesteps)),
-		mImport_tariff(siteData.import_tariffs[tariff_index]),
 		mTariffStats(tariff_stats)
-	{}
+	{
+		if (mRecordCharging) {
+			mDHW_charging = Eigen::VectorXf::Zero(siteData.timesteps);
+		}
+		if (mRecordStandbyLoss) {
+			mDHW_standby_losses = Eigen::VectorXf::Zero(siteData.timesteps);
+		}
+		if (mRecordSoC) {
+			mDHW_SoC_history = Eigen::VectorXf::Zero(siteData.timesteps);
+		}
+		if (mRecordTemperature) {
+			mDHW_ave_temperature = Eigen::VectorXf::Zero(siteData.timesteps);
+		}
+	}
 
 	// Calculate cylinder energy capacity based on T_setpoint, convert to kWh
 	float calculate_Capacity_h() {
@@ -42,6 +56,16 @@ public:
 		return;
 	}
 
+	// Start from the heat stored at the end of the timesteps before these, rather than from empty
+	// The first timestep is then charged like any other
+	void continueFrom(float energy_h) {
+		mCylinderStartSoC_h = energy_h;
+		mContinuing = true;
+	}
+
+	// the heat stored after the last timestep, in kWh
+	float getEnergy() const { return mCylEnergy_h; }
+
 	void calculate_U() // Just in terms of volume for now, based on reference value of 1.7 W/C - 250 litre Valiant Unistor 1.42 kWh standing loss in 24 hours 
 	{
 		mU = 1.70f * pow((mCylinderVolume / 250), (2.0f / 3.0f));
@@ -49,39 +73,50 @@ public:
 	}
 
 
+	/**
+	* Fold the physical constants into per-timestep coefficients, working in kWh throughout
+	*
+	* The average temperature is affine in the stored energy, and the standby loss is affine in the temperature,
+	* so the standby loss over a timestep is mLossPerKWh * E + mLossOffset_h for a stored energy E.
+	* This is the same model as the kJ formulation (T_ave = E * 3600 / (rho * V * c_w) + T_cold,
+	* loss = U * (T_ave - T_ambient) * dt_s / 1000 kJ), but the floating point rounding differs:
+	* the SoC and the loads agree with it to within 1e-4 kWh over a year of half-hourly timesteps
+	*/
+	void fold_constants() {
+		mDegreesPerKWh = 3600.0f / (rho * mCylinderVolume * c_w);
+		const float lossPerDegree_h = mU * mTimestep_hours / 1000.0f;	// W/°C to kWh/°C per timestep
+		mLossPerKWh = lossPerDegree_h * mDegreesPerKWh;
+		mLossOffset_h = lossPerDegree_h * (T_cold - T_ambient);
+		mMaxHeatPumpCharge_h = mHeat_pump_power_h * mTimestep_hours;
+	}
+
 	// Update the model for one time step
 	void update_SoC_basic(float E_charge_kWh, float V_draw_kWh, size_t timestep) {
 
-		// Convert input charging energy from kWh to kJ
-		float Charging_kjoules = E_charge_kWh * 3600.0f; // kWh to kJ
-
-		// Calculate energy lost due to draw-off
-		float Discharging_kjoules = V_draw_kWh * 3600.0f; // kWh to kJ
-
-		// Update average temperature
-		mT_ave = mCylEnergy_h * 3600.0f / (rho * mCylinderVolume * c_w) + T_cold;
-
-		// Calculate standby energy losses (convert W to kW, then to kJ)
 		// standby loss can be negative in rare circumstances (when the cylinder temperature is less than the ambient temperature)
-		float Standby_loss_kjoules = mU * (mT_ave - T_ambient) * (mTimestep_seconds) / 1000.0f; // in kJ
+		const float standby_loss_h = mLossPerKWh * mCylEnergy_h + mLossOffset_h;
 
-		// Update stored energy
-		mCylEnergy_h += (Charging_kjoules - Discharging_kjoules - Standby_loss_kjoules) / 3600.0f; // convert back to kWh
+		// record tank standby loss and the average temperature (before this timestep's flows) for reporting
+		if (mRecordStandbyLoss) {
+			mDHW_standby_losses[timestep] = standby_loss_h;
+		}
+		if (mRecordTemperature) {
+			mDHW_ave_temperature[timestep] = mCylEnergy_h * mDegreesPerKWh + T_cold;
+		}
 
-		// record tank standby loss for reporting
-		mDHW_standby_losses[timestep] = Standby_loss_kjoules / 3600.0f;
-		mDHW_ave_temperature[timestep] = mT_ave;
+		// Update stored energy
+		mCylEnergy_h += E_charge_kWh - V_draw_kWh - standby_loss_h;
 
 		if (mCylEnergy_h < 0)
 		{
 			// record shortfall in absolute terms
-		    mDHW_local_shortfall[timestep] = -mCylEnergy_h;
-		    mCylEnergy_h = 0;
+			mDHW_local_shortfall[timestep] = -mCylEnergy_h;
+			mCylEnergy_h = 0;
 		}
 
-		mDHW_SoC_history[timestep] = mCylEnergy_h;
-
-		return;
+		if (mRecordSoC) {
+			mDHW_SoC_history[timestep] = mCylEnergy_h;
+		}
 	}
 
 	void update_SoC_detailed([[maybe_unused]] float E_charge_kWh, [[maybe_unused]] float V_draw_kWh)
@@ -90,51 +125,25 @@ public:
 		return;
 	}
 
-	void AllCalcs(TempSum& tempSum) {
+	/**
+	* Charge and discharge the cylinder over every timestep
+	* dayBlock selects the kernel (see DayBlocks.hpp); each kernel has the same result
+	*/
+	void AllCalcs(TempSum& tempSum, size_t dayBlock = 0) {
 
 		intialise_SoC();
 		calculate_U();
-		
-		// initialise cylinder at timestep zero
-		update_SoC_basic(0, mDHW_discharging[0], 0);
-
-		// We start at t=1 here because we need to look at the previous timestep
-		for (size_t timestep = 1; timestep < mTimesteps; timestep++) {
-
-			float timestep_charge = 0;
-
-			float dayAverage = mTariffStats.getDayAverage(timestep);
-			float dayPercentile = mTariffStats.getDayPercentile(timestep);
-			
-			// determine charge
-			float max_charge_energy = mCapacity_h - mCylEnergy_h;
-			float max_heat_pump_charge_energy = std::min(max_charge_energy, (mHeat_pump_power_h * mTimestep_hours));
-
-
-			float timestep_renewable_charge = 0; // this is by resitive immersion heating assume 1kWe = 1kWh
-			float timestep_lowtariff_charge = 0; // to charge from tariff schedule, this can be achieved by heat pump
-
-			if (tempSum.Elec_e[timestep] < 0) // if there is a surplus of renewables, permit DHW charging by immersion and/or charge if there is a requirement for boost// must be after first timestep // can add tariff considertion later 
-			{
-				timestep_renewable_charge = std::min(-tempSum.Elec_e[timestep], max_charge_energy); // use renewable surplus as candidate amount to top up to tank capacit 
-			}
-
-			// here we use <= dayAverage to ensure that we top up the DHW cylinder in scenarios with a fixed price tariffs
-			if (mImport_tariff[timestep] <= dayAverage && mImport_tariff[timestep] <= dayPercentile) {
-				timestep_lowtariff_charge = max_heat_pump_charge_energy - timestep_renewable_charge;
-			}
-
-			timestep_charge = timestep_renewable_charge + timestep_lowtariff_charge;
+		fold_constants();
 
-			update_SoC_basic(timestep_charge, mDHW_discharging[timestep], timestep);
+		// initialise cylinder at timestep zero, unless it continues from earlier timesteps
+		size_t first = 0;
+		if (!mContinuing) {
+			update_SoC_basic(0, mDHW_discharging[0], 0);
+			first = 1;
+		}
 
-			// total heat transfered to cylinder
-			mDHW_charging[timestep] = timestep_charge;
-			// assume renewable energy divert is simple AC heater
-			mDHW_diverter_load_e[timestep] = timestep_renewable_charge;
-			// assume the low tariff charge is done by heat pump
-			mDHW_heat_pump_load_h[timestep] = timestep_lowtariff_charge;
-		};
+		// A fresh cylinder starts at t=1 here because we need to look at the previous timestep
+		withDayBlock(dayBlock, [&](auto block) { chargeTimesteps<decltype(block)::value>(tempSum, first); });
 
 		// update tempSum to apply the electrical loads
 		// 
@@ -151,21 +160,78 @@ public:
 	}
 
 	void Report(ReportData& reportData) {
-		reportData.DHW_load = mDHW_discharging;
-		reportData.DHW_charging = mDHW_charging;
-		reportData.DHW_SoC = mDHW_SoC_history;
-		reportData.DHW_Standby_loss = mDHW_standby_losses;
-		reportData.DHW_ave_temperature = mDHW_ave_temperature;
-		reportData.DHW_immersion_top_up = mDHW_local_shortfall;
-		reportData.DHW_diverter_load = mDHW_diverter_load_e;
+		reportData.set(ReportColumn::DHW_load, mDHW_discharging);
+		reportData.set(ReportColumn::DHW_charging, mDHW_charging);
+		reportData.set(ReportColumn::DHW_SoC, mDHW_SoC_history);
+		reportData.set(ReportColumn::DHW_Standby_loss, mDHW_standby_losses);
+		reportData.set(ReportColumn::DHW_ave_temperature, mDHW_ave_temperature);
+		reportData.set(ReportColumn::DHW_immersion_top_up, mDHW_local_shortfall);
+		reportData.set(ReportColumn::DHW_diverter_load, mDHW_diverter_load_e);
 	}
 
 
 private:
 
+	// charge the timesteps [first, mTimesteps), with whole days as blocks of TimestepsPerDay (or one at a time if it is 0)
+	template <size_t TimestepsPerDay>
+	void chargeTimesteps(TempSum& tempSum, size_t first) {
+		size_t timestep = first;
+		if constexpr (TimestepsPerDay > 0) {
+			// the rest of the day that first is in (the days start at timestep zero, as do those of the DayTariffStats)
+			const size_t firstWholeDay = std::min((first + TimestepsPerDay - 1) / TimestepsPerDay * TimestepsPerDay, mTimesteps);
+			for (; timestep < firstWholeDay; timestep++) {
+				chargeTimestep(tempSum, timestep, mTariffStats.isLowPrice(timestep));
+			}
+			for (; timestep + TimestepsPerDay <= mTimesteps; timestep += TimestepsPerDay) {
+				const uint8_t* lowPrice = mTariffStats.lowPriceFrom(timestep);
+				for (size_t i = 0; i < TimestepsPerDay; i++) {
+					chargeTimestep(tempSum, timestep + i, lowPrice[i]);
+				}
+			}
+		}
+		// any partial final day (or every timestep, for the generic kernel)
+		for (; timestep < mTimesteps; timestep++) {
+			chargeTimestep(tempSum, timestep, mTariffStats.isLowPrice(timestep));
+		}
+	}
+
+	void chargeTimestep(TempSum& tempSum, size_t timestep, bool lowPrice) {
+		float timestep_charge = 0;
+
+		// determine charge
+		float max_charge_energy = mCapacity_h - mCylEnergy_h;
+		float max_heat_pump_charge_energy = std::min(max_charge_energy, mMaxHeatPumpCharge_h);
+
+
+		float timestep_renewable_charge = 0; // this is by resitive immersion heating assume 1kWe = 1kWh
+		float timestep_lowtariff_charge = 0; // to charge from tariff schedule, this can be achieved by heat pump
+
+		if (tempSum.Elec_e[timestep] < 0) // if there is a surplus of renewables, permit DHW charging by immersion and/or charge if there is a requirement for boost// must be after first timestep // can add tariff considertion later 
+		{
+			timestep_renewable_charge = std::min(-tempSum.Elec_e[timestep], max_charge_energy); // use renewable surplus as candidate amount to top up to tank capacit 
+		}
+
+		// the low price mask uses <= dayAverage to ensure that we top up the DHW cylinder in scenarios with a fixed price tariffs
+		if (lowPrice) {
+			timestep_lowtariff_charge = max_heat_pump_charge_energy - timestep_renewable_charge;
+		}
+
+		timestep_charge = timestep_renewable_charge + timestep_lowtariff_charge;
+
+		update_SoC_basic(timestep_charge, mDHW_discharging[timestep], timestep);
+
+		if (mRecordCharging) {
+			// total heat transfered to cylinder
+			mDHW_charging[timestep] = timestep_charge;
+		}
+		// assume renewable energy divert is simple AC heater
+		mDHW_diverter_load_e[timestep] = timestep_renewable_charge;
+		// assume the low tariff charge is done by heat pump
+		mDHW_heat_pump_load_h[timestep] = timestep_lowtariff_charge;
+	}
+
 	float mCylinderVolume;
 	const size_t mTimesteps;
-	float mTimestep_seconds;
 	float mTimestep_hours;
 
 	const float c_w = 4.18f;            // Specific heat capacity of water in kJ/kg·°C
@@ -178,20 +244,29 @@ private:
 	float mU;                           // Heat loss coefficient in W/°C
 	float mCapacity_h;                  // heat capacity of tank in kWh
 	float mCylEnergy_h;                 // Stored heat energy in kWh
-	float mT_ave;                       // average water temperature in °C
 	float mCylinderStartSoC_h;          // starting state of charge in kWh
+	bool mContinuing = false;           // whether the start SoC was carried over from earlier timesteps
 
-	float mHeat_pump_power_h;           // max heat pump power
+	// Folded constants (see fold_constants)
+	float mDegreesPerKWh;               // °C rise per kWh stored
+	float mLossPerKWh;                  // standby loss per timestep per kWh stored
+	float mLossOffset_h;                // standby loss per timestep of an empty cylinder in kWh
+	float mMaxHeatPumpCharge_h;         // most the heat pump can charge in one timestep in kWh
 
-	year_TS mDHW_charging;              // member timeseries for calculated charging
-	year_TS mDHW_discharging;           // member timeseries for discharging from historical data
-	year_TS mDHW_standby_losses;
-	year_TS mDHW_local_shortfall;
-	year_TS mDHW_SoC_history;
-	year_TS mDHW_ave_temperature;
-	year_TS mDHW_heat_pump_load_h;
-	year_TS mDHW_diverter_load_e;
-	year_TS mImport_tariff;
+	float mHeat_pump_power_h;           // max heat pump power
+	const bool mRecordCharging;
+	const bool mRecordStandbyLoss;
+	const bool mRecordSoC;
+	const bool mRecordTemperature;
+
+	PooledTS mDHW_charging;              // member timeseries for calculated charging
+	const year_TS_view mDHW_discharging;	// view of the historical hot water demand
+	PooledTS mDHW_standby_losses;
+	PooledTS mDHW_local_shortfall;
+	PooledTS mDHW_SoC_history;
+	PooledTS mDHW_ave_temperature;
+	PooledTS mDHW_heat_pump_load_h;
+	PooledTS mDHW_diverter_load_e;
 
 	const DayTariffStats& mTariffStats;
 
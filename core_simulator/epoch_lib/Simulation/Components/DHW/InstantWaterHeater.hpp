@@ -10,20 +10,28 @@
 class InstantWaterHeater
 {
 public: 
-	InstantWaterHeater(const SiteData& siteData) :
-		mDHW_resistive(Eigen::VectorXf::Zero(siteData.timesteps))
-	{}
+	// The resistive load is only kept for reporting when its column is in history
+	InstantWaterHeater(const SiteData& siteData, ReportColumnMask history) :
+		mRecordHistory(history.has(ReportColumn::DHW_resistive_load))
+	{
+		if (mRecordHistory) {
+			mDHW_resistive = Eigen::VectorXf::Zero(siteData.timesteps);
+		}
+	}
 
 	void AllCalcs(TempSum& tempSum) {
-		mDHW_resistive = tempSum.DHW_load_h;
-		tempSum.DHW_load_h.setZero();
+		if (mRecordHistory) {
+			mDHW_resistive = tempSum.DHW_load_h;
+		}
 
-		tempSum.Elec_e += mDHW_resistive;
+		tempSum.Elec_e += tempSum.DHW_load_h;
+		tempSum.DHW_load_h.setZero();
 	}
 
 	void Report(ReportData& reportData) {
-		reportData.DHW_resistive_load = mDHW_resistive;
+		reportData.set(ReportColumn::DHW_resistive_load, mDHW_resistive);
 	}
 private:
-	year_TS mDHW_resistive;
+	const bool mRecordHistory;
+	PooledTS mDHW_resistive;
 };
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include <Eigen/Dense>
 
 #include "../ASHP.hpp"
+#include "../Reductions.hpp"
 #include "../TempSum.hpp"
 #include "../SiteData.hpp"
 #include "../TaskComponents.hpp"
@@ -22,10 +23,11 @@ public:
     virtual void StepCalc(TempSum& tempSum, const float futureEnergy_e, const size_t t) = 0;
     virtual float getTargetLoad(size_t timestep) = 0;
     virtual void Report(ReportData& reportData) const = 0;
+    virtual void ReportTotals(SimulationTotals& totals) const = 0;
 };
 
 
-class BasicDataCentre : public DataCentre {
+class BasicDataCentre final : public DataCentre {
 public:
     BasicDataCentre(const SiteData& siteData, const DataCentreData& dc);
 
@@ -33,25 +35,33 @@ public:
     void StepCalc(TempSum& tempSum, const float futureEnergy_e, const size_t t);
     float getTargetLoad(size_t timestep);
     void Report(ReportData& reportData) const;
+    void ReportTotals(SimulationTotals& totals) const;
+
+    // StepCalc for every timestep at once, as no timestep depends on another when futureEnergy_e is fixed
+    void StepCalcAll(TempSum& tempSum, const float futureEnergy_e);
+
+    const year_TS& getTargetLoads() const { return mTargetLoad_e; }
 
 private:
     const size_t mTimesteps;
     const int mOptimisationMode;
     const float mDataCentreMaxLoad_e;
 
-    year_TS mTargetLoad_e;
-    year_TS mActualLoad_e;
+    PooledTS mTargetLoad_e;
+    PooledTS mActualLoad_e;
 };
 
 
-class DataCentreWithASHP : public DataCentre {
+class DataCentreWithASHP final : public DataCentre {
 public:
-    DataCentreWithASHP(const SiteData& siteData, const DataCentreData& dc, const HeatPumpData& hp);
+    // heatPumpProfile is the performance of the heatpump at the data centre's hotroom temperature
+    DataCentreWithASHP(const SiteData& siteData, const DataCentreData& dc, std::shared_ptr<const HotRoomProfile> heatPumpProfile);
 
     void AllCalcs(TempSum& tempSum);
     void StepCalc(TempSum& tempSum, const float futureEnergy_e, const size_t t);
     float getTargetLoad(size_t timestep);
     void Report(ReportData& reportData) const;
+    void ReportTotals(SimulationTotals& totals) const;
 
 private:
     HotRoomHeatPump mHeatPump;
@@ -61,10 +71,10 @@ private:
     const float mDataCentreMaxLoad_e;
     const float mHeatScalar;
 
-    year_TS mTargetLoad_e;
-    year_TS mActualLoad_e;
-    year_TS mAvailableHotHeat_h;
-    year_TS mTargetHeat_h;
+    PooledTS mTargetLoad_e;
+    PooledTS mActualLoad_e;
+    PooledTS mAvailableHotHeat_h;
+    PooledTS mTargetHeat_h;
 };
 
 
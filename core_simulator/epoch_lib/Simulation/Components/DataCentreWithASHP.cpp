@@ -1,8 +1,9 @@
 #include "DataCentre.hpp"
 
-DataCentreWithASHP::DataCentreWithASHP(const SiteData& siteData, const DataCentreData& dc, const HeatPumpData& hp):
+DataCentreWithASHP::DataCentreWithASHP(const SiteData& siteData, const DataCentreData& dc,
+	std::shared_ptr<const HotRoomProfile> heatPumpProfile):
 	DataCentre(siteData),
-	mHeatPump(siteData, hp, dc),
+	mHeatPump(siteData, std::move(heatPumpProfile)),
 	mTimesteps(siteData.timesteps),
 	mOptimisationMode(DataCentreOptimisationMode::Target),
 	// Max kWh per TS
@@ -78,16 +79,20 @@ float DataCentreWithASHP::getTargetLoad(size_t timestep) {
 }
 
 void DataCentreWithASHP::Report(ReportData& reportData) const {
-	reportData.Data_centre_target_load = mTargetLoad_e;
-	reportData.Data_centre_actual_load = mActualLoad_e;
-	reportData.Data_centre_target_heat = mTargetHeat_h;
-	reportData.Data_centre_available_hot_heat = mAvailableHotHeat_h;
-
-	reportData.ASHP_elec_load = mHeatPump.mDHWload_e + mHeatPump.mCHload_e;
-	reportData.ASHP_DHW_output = mHeatPump.mDHWout_h;
-	reportData.ASHP_CH_output = mHeatPump.mCHout_h;
-	reportData.ASHP_free_heat = mHeatPump.mFreeHeat_h;
-	reportData.ASHP_used_hotroom_heat = mHeatPump.mUsedHotHeat_h;
+	reportData.set(ReportColumn::Data_centre_target_load, mTargetLoad_e);
+	reportData.set(ReportColumn::Data_centre_actual_load, mActualLoad_e);
+	reportData.set(ReportColumn::Data_centre_target_heat, mTargetHeat_h);
+	reportData.set(ReportColumn::Data_centre_available_hot_heat, mAvailableHotHeat_h);
+
+	reportData.set(ReportColumn::ASHP_elec_load, mHeatPump.mDHWload_e + mHeatPump.mCHload_e);
+	reportData.set(ReportColumn::ASHP_DHW_output, mHeatPump.mDHWout_h);
+	reportData.set(ReportColumn::ASHP_CH_output, mHeatPump.mCHout_h);
+	reportData.set(ReportColumn::ASHP_free_heat, mHeatPump.mFreeHeat_h);
+	reportData.set(ReportColumn::ASHP_used_hotroom_heat, mHeatPump.mUsedHotHeat_h);
+}
+
+void DataCentreWithASHP::ReportTotals(SimulationTotals& totals) const {
+	totals.data_centre_load_e = seriesTotal(mActualLoad_e);
 }
 
 
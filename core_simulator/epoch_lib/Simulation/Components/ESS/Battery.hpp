@@ -12,13 +12,11 @@
 class Battery {
 
 public:
-	Battery(const SiteData& siteData, const EnergyStorageSystem& essData) :
-		// Initilaise results data vectors with all values to zero
-		mHistSoC_e(Eigen::VectorXf::Zero(siteData.timesteps)),      // Resulting State of Charge per timestep
-		mHistCharg_e(Eigen::VectorXf::Zero(siteData.timesteps)),   // Charge kWh per timestep
-		mHistDisch_e(Eigen::VectorXf::Zero(siteData.timesteps)),   // Discharge kWh per timestep
-		mHistRTL_e(Eigen::VectorXf::Zero(siteData.timesteps)),     // Round trip loss kWh per timestep
-	
+	// A history vector is only populated when its column is in history
+	// (they are not needed to calculate the result of a scenario)
+	Battery(const SiteData& siteData, const EnergyStorageSystem& essData, ReportColumnMask history) :
+		mRecordHistory(history.hasAny(HISTORY_COLUMNS)),
+		mHistory(history),
 		mCapacity_e(essData.capacity),
 		// timestep_hours can be considered a power scalar per timestep
 		mChargMax_e(essData.charge_power * siteData.timestep_hours), // kWh per timestep
@@ -27,7 +25,22 @@ public:
 		mAuxLoad_e(essData.capacity / 1200 * siteData.timestep_hours), // kWh per timestep
 		mPreSoC_e(essData.initial_charge) // Init State of Charge in kWhs
 	{
-		mHistAux_e = Eigen::VectorXf::Constant(siteData.timesteps, mAuxLoad_e);
+		// Initilaise results data vectors with all values to zero
+		if (mHistory.has(ReportColumn::ESS_resulting_SoC)) {
+			mHistSoC_e = Eigen::VectorXf::Zero(siteData.timesteps);      // Resulting State of Charge per timestep
+		}
+		if (mHistory.has(ReportColumn::ESS_charge)) {
+			mHistCharg_e = Eigen::VectorXf::Zero(siteData.timesteps);   // Charge kWh per timestep
+		}
+		if (mHistory.has(ReportColumn::ESS_discharge)) {
+			mHistDisch_e = Eigen::VectorXf::Zero(siteData.timesteps);   // Discharge kWh per timestep
+		}
+		if (mHistory.has(ReportColumn::ESS_RTL)) {
+			mHistRTL_e = Eigen::VectorXf::Zero(siteData.timesteps);     // Round trip loss kWh per timestep
+		}
+		if (mHistory.has(ReportColumn::ESS_AuxLoad)) {
+			mHistAux_e = Eigen::VectorXf::Constant(siteData.timesteps, mAuxLoad_e);
+		}
 	}
 
 	float getAvailableCharge() const {
@@ -38,23 +51,67 @@ public:
 		return std::min(mDischMax_e, mPreSoC_e);
 	}
 
-	float GetSoC() { return mPreSoC_e; }
+	float GetSoC() const { return mPreSoC_e; }
+
+	float GetCapacity_e() const { return mCapacity_e; }
+
+	float getChargeMax_e() const { return mChargMax_e; }
 
-	float GetCapacity_e() { return mCapacity_e; }
+	float getDischargeMax_e() const { return mDischMax_e; }
+
+	float getRTLrate() const { return mRTLrate; }
 
 	void doCharge(float Charge_e, size_t t) {
-		mHistCharg_e[t] = Charge_e;
-		mHistRTL_e[t] = Charge_e * mRTLrate;
-		mHistSoC_e[t] = mPreSoC_e + Charge_e - mHistRTL_e[t];
-		mPreSoC_e = mHistSoC_e[t];			//for next timestep
+		float roundTripLoss_e = Charge_e * mRTLrate;
+		mPreSoC_e = mPreSoC_e + Charge_e - roundTripLoss_e;			//for next timestep
+
+		if (mRecordHistory) {
+			record(ReportColumn::ESS_charge, mHistCharg_e, t, Charge_e);
+			record(ReportColumn::ESS_RTL, mHistRTL_e, t, roundTripLoss_e);
+			record(ReportColumn::ESS_resulting_SoC, mHistSoC_e, t, mPreSoC_e);
+		}
 	}
 
 	void doDischarge(float DisCharge_e, size_t t) {
-		mHistDisch_e[t] = DisCharge_e;
-		mHistSoC_e[t] = mPreSoC_e - DisCharge_e;
-		mPreSoC_e = mHistSoC_e[t];			//for next timestep
+		mPreSoC_e = mPreSoC_e - DisCharge_e;			//for next timestep
+
+		if (mRecordHistory) {
+			record(ReportColumn::ESS_discharge, mHistDisch_e, t, DisCharge_e);
+			record(ReportColumn::ESS_resulting_SoC, mHistSoC_e, t, mPreSoC_e);
+		}
+	}
+
+	/**
+	* Charge and discharge in the same step, where at most one of them is non-zero
+	* This gives the same state as doCharge or doDischarge, without branching on which of them applies
+	*/
+	void doStep(float Charge_e, float DisCharge_e, size_t t) {
+		float roundTripLoss_e = Charge_e * mRTLrate;
+		mPreSoC_e = mPreSoC_e - DisCharge_e + Charge_e - roundTripLoss_e;			//for next timestep
+
+		if (mRecordHistory) {
+			record(ReportColumn::ESS_charge, mHistCharg_e, t, Charge_e);
+			record(ReportColumn::ESS_discharge, mHistDisch_e, t, DisCharge_e);
+			record(ReportColumn::ESS_RTL, mHistRTL_e, t, roundTripLoss_e);
+			record(ReportColumn::ESS_resulting_SoC, mHistSoC_e, t, mPreSoC_e);
+		}
+	}
+
+	/**
+	* Record a step that was calculated from the state of charge outside of the battery (see runConsumeScan)
+	* Different timesteps may be recorded concurrently, so this leaves the state of charge to setSoC
+	*/
+	void recordStep(float Charge_e, float DisCharge_e, float roundTripLoss_e, float resultingSoC_e, size_t t) {
+		if (mRecordHistory) {
+			record(ReportColumn::ESS_charge, mHistCharg_e, t, Charge_e);
+			record(ReportColumn::ESS_discharge, mHistDisch_e, t, DisCharge_e);
+			record(ReportColumn::ESS_RTL, mHistRTL_e, t, roundTripLoss_e);
+			record(ReportColumn::ESS_resulting_SoC, mHistSoC_e, t, resultingSoC_e);
+		}
 	}
 
+	void setSoC(float SoC_e) { mPreSoC_e = SoC_e; }
+
 	// Public output data, create private Battery object in parent
 	year_TS mHistSoC_e;
 	year_TS mHistCharg_e;
@@ -63,6 +120,19 @@ public:
 	year_TS mHistRTL_e;
 
 private:
+	static constexpr ReportColumnMask HISTORY_COLUMNS = {
+		ReportColumn::ESS_charge, ReportColumn::ESS_discharge, ReportColumn::ESS_resulting_SoC, ReportColumn::ESS_RTL
+	};
+
+	void record(ReportColumn column, year_TS& history, size_t t, float value) {
+		if (mHistory.has(column)) {
+			history[t] = value;
+		}
+	}
+
+	// whether any of the per-timestep histories are recorded
+	const bool mRecordHistory;
+	const ReportColumnMask mHistory;
 	const float mCapacity_e;
 	const float mChargMax_e;
 	const float mDischMax_e;
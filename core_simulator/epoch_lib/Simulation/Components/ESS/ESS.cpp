@@ -1,14 +1,13 @@
 #include "ESS.hpp"
 
 
-BasicESS::BasicESS(const SiteData& siteData, const EnergyStorageSystem& essData, size_t tariff_index, const DayTariffStats& tariff_stats) :
+BasicESS::BasicESS(const SiteData& siteData, const EnergyStorageSystem& essData, [[maybe_unused]] size_t tariff_index, const DayTariffStats& tariff_stats, ReportColumnMask history) :
     ESS(siteData),
-    mBattery(siteData, essData),
+    mBattery(siteData, essData, history),
     mESS_mode(essData.battery_mode),
     mTimesteps(siteData.timesteps),
     mThresholdSoC(essData.capacity * 0.5f),
     mEnergyCalc(0.0f),
-    mImport_tariff(siteData.import_tariffs[tariff_index]),
     mTariffStats(tariff_stats)
 {
 }
@@ -17,44 +16,17 @@ void BasicESS::StepCalc(TempSum& tempSum, const float futureEnergy_e, const size
 {
     // mESS_mode Consume = 1, Resilient = 2, Threshold = 3, Price = 4, Carbon = 5
     switch (mESS_mode) {
-    case BatteryMode::CONSUME: // Consume mode
-        if (tempSum.Elec_e[t] >= 0) {  // Surplus Demand, discharge ESS
-            mEnergyCalc = std::min(tempSum.Elec_e[t], mBattery.getAvailableDischarge());
-            mBattery.doDischarge(mEnergyCalc, t);
-            tempSum.Elec_e[t] = tempSum.Elec_e[t] - mEnergyCalc;
-        }
-        else {        // Surplus Generation, charge ESS
-            mEnergyCalc = std::min(-tempSum.Elec_e[t], mBattery.getAvailableCharge());
-            mBattery.doCharge(mEnergyCalc, t);
-            tempSum.Elec_e[t] = tempSum.Elec_e[t] + mEnergyCalc;
-        }
+    case BatteryMode::CONSUME:
+        StepCalcMode<BatteryMode::CONSUME>(tempSum, futureEnergy_e, t);
         break;
     case BatteryMode::CONSUME_PLUS:
-        float averageTariff = mTariffStats.getDayAverage(t);
-        float percentileTariff = mTariffStats.getDayPercentile(t);
-        
-        // if we satisfy top-up conditions in this timestep, only do this charge. 75% is the threshold SoC level
-        if(mImport_tariff[t] < averageTariff && 
-            mImport_tariff[t] <= percentileTariff && 
-            mBattery.GetSoC()/mBattery.GetCapacity_e() < 0.75f) {
-
-            // calculate how much energy we want to put into the battery
-            mEnergyCalc = std::min((mBattery.GetCapacity_e()*0.75f), mBattery.getAvailableCharge());
-            // cap by the amount of energy available to us
-            mEnergyCalc = std::min(mEnergyCalc, futureEnergy_e - tempSum.Elec_e[t]);
-            mBattery.doCharge(mEnergyCalc, t);
-            tempSum.Elec_e[t] = tempSum.Elec_e[t] + mEnergyCalc;
-        }
-        else if (tempSum.Elec_e[t] >= 0) {  // Surplus Demand, discharge ESS
-            mEnergyCalc = std::min(tempSum.Elec_e[t], mBattery.getAvailableDischarge());
-            mBattery.doDischarge(mEnergyCalc, t);
-            tempSum.Elec_e[t] = tempSum.Elec_e[t] - mEnergyCalc;
-        }
-        else {        // Surplus Generation, charge ESS
-            mEnergyCalc = std::min(-tempSum.Elec_e[t], mBattery.getAvailableCharge());
-            mBattery.doCharge(mEnergyCalc, t);
-            tempSum.Elec_e[t] = tempSum.Elec_e[t] + mEnergyCalc;
-        }
+        StepCalcMode<BatteryMode::CONSUME_PLUS>(tempSum, futureEnergy_e, t);
+        break;
+    case BatteryMode::PRICE_LOOKAHEAD:
+        StepCalcMode<BatteryMode::PRICE_LOOKAHEAD>(tempSum, futureEnergy_e, t);
+        break;
+    case BatteryMode::CARBON_LOOKAHEAD:
+        StepCalcMode<BatteryMode::CARBON_LOOKAHEAD>(tempSum, futureEnergy_e, t);
         break;
     }
     // FIXME JW - reintroduce the other modes incrementally
@@ -110,39 +82,13 @@ void BasicESS::StepCalc(TempSum& tempSum, const float futureEnergy_e, const size
 
 }
 
-float BasicESS::AvailDisch()
-{
-	return mBattery.getAvailableDischarge();
-}
-
 void BasicESS::Report(ReportData& reportData) const
 {
-    reportData.ESS_charge = mBattery.mHistCharg_e;
-    reportData.ESS_discharge = mBattery.mHistDisch_e;
-    reportData.ESS_resulting_SoC = mBattery.mHistSoC_e;
-
-    reportData.ESS_AuxLoad = mBattery.mHistAux_e;
-    reportData.ESS_RTL = mBattery.mHistRTL_e;
-}
-
-
-NullESS::NullESS(const SiteData& siteData) 
-    : ESS(siteData)
-{
-}
+    reportData.set(ReportColumn::ESS_charge, mBattery.mHistCharg_e);
+    reportData.set(ReportColumn::ESS_discharge, mBattery.mHistDisch_e);
+    reportData.set(ReportColumn::ESS_resulting_SoC, mBattery.mHistSoC_e);
 
-void NullESS::StepCalc([[maybe_unused]] TempSum& tempSum, [[maybe_unused]] const float futureEnergy_e, [[maybe_unused]] const size_t t)
-{
-    // Do nothing
+    reportData.set(ReportColumn::ESS_AuxLoad, mBattery.mHistAux_e);
+    reportData.set(ReportColumn::ESS_RTL, mBattery.mHistRTL_e);
 }
 
-float NullESS::AvailDisch()
-{
-    // Null ESS returns 0 available charge
-    return 0.0f;
-}
-
-void NullESS::Report([[maybe_unused]] ReportData& reportData) const
-{
-    // Do nothing
-}
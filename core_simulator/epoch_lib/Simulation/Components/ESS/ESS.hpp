@@ -22,15 +22,30 @@ public:
 };
 
 
-class BasicESS : public ESS {
+class BasicESS final : public ESS {
 public:
-    BasicESS(const SiteData& siteData, const EnergyStorageSystem& essData, size_t tariff_index, const DayTariffStats& tariff_stats);
+    BasicESS(const SiteData& siteData, const EnergyStorageSystem& essData, size_t tariff_index, const DayTariffStats& tariff_stats, ReportColumnMask history);
 
     void StepCalc(TempSum& tempSum, const float futureEnergy_e, const size_t t);
-    float AvailDisch();
+    float AvailDisch() { return mBattery.getAvailableDischarge(); }
     void Report(ReportData& reportData) const;
 
+    /**
+    * StepCalc for a BatteryMode that is known at compile time
+    * The balancing loop is instantiated per mode so that this can be inlined without a branch on the mode
+    */
+    template <BatteryMode mode>
+    void StepCalcMode(TempSum& tempSum, const float futureEnergy_e, const size_t t);
+
+    BatteryMode getMode() const { return mESS_mode; }
+
+    const Battery& getBattery() const { return mBattery; }
+    Battery& getBattery() { return mBattery; }
+
 private:
+    // Charge from surplus generation or discharge to meet surplus demand
+    void consume(TempSum& tempSum, const size_t t);
+
     Battery mBattery;
     const BatteryMode mESS_mode;
     const size_t mTimesteps;
@@ -38,19 +53,75 @@ private:
 
     float mEnergyCalc;
 
-    year_TS mImport_tariff;
+    // the top-up eligibility of each timestep is precalculated for the tariff
     const DayTariffStats& mTariffStats;
 };
 
 
-// This is a crude workaround for the fact that the current balancing loop always assumes there is a battery
-// The methods do nothing and return 0 so it appears to the code as if there is an unusable battery present
-class NullESS : public ESS {
-public:
-    NullESS(const SiteData& siteData);
+inline void BasicESS::consume(TempSum& tempSum, const size_t t)
+{
+    if (tempSum.Elec_e[t] >= 0) {  // Surplus Demand, discharge ESS
+        mEnergyCalc = std::min(tempSum.Elec_e[t], mBattery.getAvailableDischarge());
+        mBattery.doDischarge(mEnergyCalc, t);
+        tempSum.Elec_e[t] = tempSum.Elec_e[t] - mEnergyCalc;
+    }
+    else {        // Surplus Generation, charge ESS
+        mEnergyCalc = std::min(-tempSum.Elec_e[t], mBattery.getAvailableCharge());
+        mBattery.doCharge(mEnergyCalc, t);
+        tempSum.Elec_e[t] = tempSum.Elec_e[t] + mEnergyCalc;
+    }
+}
 
-    void StepCalc(TempSum& tempSum, const float futureEnergy_e, const size_t t);
-    float AvailDisch();
-    void Report(ReportData& reportData) const;
-};
+template <BatteryMode mode>
+inline void BasicESS::StepCalcMode(TempSum& tempSum, [[maybe_unused]] const float futureEnergy_e, const size_t t)
+{
+    if constexpr (mode == BatteryMode::CONSUME) {
+        consume(tempSum, t);
+    }
+    else if constexpr (mode == BatteryMode::CONSUME_PLUS) {
+        // Both the top-up and the consume step are calculated and one is selected, so the step has no branches
+        // (the selects can compile to conditional moves, keeping the mispredictions of a mixed tariff out of the loop)
+        const float elec = tempSum.Elec_e[t];
+        const float availableCharge = mBattery.getAvailableCharge();
+
+        // if we satisfy top-up conditions in this timestep, only do this charge. 75% is the threshold SoC level
+        const bool topUp = mTariffStats.isTopUpEligible(t) && mBattery.GetSoC() / mBattery.GetCapacity_e() < 0.75f;
+        // calculate how much energy we want to put into the battery, capped by the amount of energy available to us
+        const float topUpCharge = std::min(std::min(mBattery.GetCapacity_e() * 0.75f, availableCharge), futureEnergy_e - elec);
+
+        // otherwise discharge to meet surplus demand or charge from surplus generation, as consume
+        const bool surplusDemand = elec >= 0;
+        const float consumeDischarge = surplusDemand ? std::min(elec, mBattery.getAvailableDischarge()) : 0.0f;
+        const float consumeCharge = surplusDemand ? 0.0f : std::min(-elec, availableCharge);
+
+        const float charge = topUp ? topUpCharge : consumeCharge;
+        const float discharge = topUp ? 0.0f : consumeDischarge;
+        mBattery.doStep(charge, discharge, t);
+        tempSum.Elec_e[t] = elec - discharge + charge;
+    }
+    else if constexpr (mode == BatteryMode::PRICE_LOOKAHEAD || mode == BatteryMode::CARBON_LOOKAHEAD) {
+        // The lowest timesteps of the window ahead are precalculated, so the step only reads a bit of the mask
+        const bool lowest = mode == BatteryMode::PRICE_LOOKAHEAD
+            ? mTariffStats.isLookaheadCheapest(t)
+            : mTariffStats.isLookaheadLowCarbon(t);
+        const float elec = tempSum.Elec_e[t];
+        const float availableCharge = mBattery.getAvailableCharge();
+        const float availableDischarge = mBattery.getAvailableDischarge();
+
+        // at the lowest timestep, charge with all of the grid import not needed by the demand
+        // and only discharge to meet the demand that the grid can't
+        const float headroom = futureEnergy_e - elec;
+        const float gridCharge = std::min(availableCharge, std::max(headroom, 0.0f));
+        const float shortfallDischarge = std::min(std::max(-headroom, 0.0f), availableDischarge);
+
+        // otherwise behave as consume
+        const bool surplusDemand = elec >= 0;
+        const float consumeDischarge = surplusDemand ? std::min(elec, availableDischarge) : 0.0f;
+        const float consumeCharge = surplusDemand ? 0.0f : std::min(-elec, availableCharge);
 
+        const float charge = lowest ? gridCharge : consumeCharge;
+        const float discharge = lowest ? shortfallDischarge : consumeDischarge;
+        mBattery.doStep(charge, discharge, t);
+        tempSum.Elec_e[t] = elec - discharge + charge;
+    }
+}
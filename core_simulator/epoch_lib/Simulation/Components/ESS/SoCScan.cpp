@@ -0,0 +1,75 @@
+#include "SoCScan.hpp"
+
+#include <vector>
+
+#include "../../TimeseriesPool.hpp"
+
+void runConsumeScan(BasicESS& ess, TempSum& tempSum, size_t timesteps, ThreadPool& pool, size_t minBlock)
+{
+	// a few blocks per worker, so that a worker that is held up doesn't hold up the rest
+	const size_t numBlocks = std::min(pool.size() * 4, timesteps / std::max<size_t>(minBlock, 1));
+	if (numBlocks < 2) {
+		for (size_t t = 0; t < timesteps; t++) {
+			ess.StepCalcMode<BatteryMode::CONSUME>(tempSum, 0.0f, t);
+		}
+		return;
+	}
+
+	Battery& battery = ess.getBattery();
+	const ConsumeParams params{ battery };
+	const float initialSoC = battery.GetSoC();
+	auto& elec = tempSum.Elec_e;
+	auto blockBegin = [&](size_t block) { return block * timesteps / numBlocks; };
+
+	// compose the maps of each block, then apply them in turn for the state of charge that each block starts from
+	std::vector<SoCMap> maps(numBlocks);
+	pool.parallelFor(numBlocks, [&](size_t block) {
+		SoCMap map{};
+		for (size_t t = blockBegin(block); t < blockBegin(block + 1); t++) {
+			map = map.then(params.map(elec[t]));
+		}
+		maps[block] = map;
+	});
+
+	std::vector<float> starts(numBlocks);
+	starts[0] = initialSoC;
+	for (size_t block = 1; block < numBlocks; block++) {
+		starts[block] = maps[block - 1](starts[block - 1]);
+	}
+
+	// the state of charge at the end of each timestep
+	PooledTS soc(static_cast<Eigen::Index>(timesteps));
+	pool.parallelFor(numBlocks, [&](size_t block) {
+		float s = starts[block];
+		for (size_t t = blockBegin(block); t < blockBegin(block + 1); t++) {
+			s = params.step(elec[t], s).soc;
+			soc[t] = s;
+		}
+	});
+
+	// step again from the exact end of the block before, until the state of charge is the same as the first pass
+	for (size_t block = 1; block < numBlocks; block++) {
+		float s = soc[blockBegin(block) - 1];
+		if (s == starts[block]) {
+			continue;
+		}
+		for (size_t t = blockBegin(block); t < blockBegin(block + 1); t++) {
+			s = params.step(elec[t], s).soc;
+			if (s == soc[t]) {
+				break;
+			}
+			soc[t] = s;
+		}
+	}
+
+	// with the state of charge known, each step is independent of the others
+	pool.parallelFor(numBlocks, [&](size_t block) {
+		for (size_t t = blockBegin(block); t < blockBegin(block + 1); t++) {
+			const ConsumeStep step = params.step(elec[t], t == 0 ? initialSoC : soc[t - 1]);
+			battery.recordStep(step.charge, step.discharge, step.charge * params.rtlRate, step.soc, t);
+			elec[t] = elec[t] - step.discharge + step.charge;
+		}
+	});
+
+	battery.setSoC(soc[timesteps - 1]);
+}
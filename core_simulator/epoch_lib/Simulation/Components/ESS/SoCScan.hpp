@@ -0,0 +1,91 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+
+#include "ESS.hpp"
+#include "../../TempSum.hpp"
+#include "../../ThreadPool.hpp"
+
+/**
+* A CONSUME step of the ESS as a map of the state of charge: min(max(soc + shift, lo), hi)
+*
+* Discharging to meet a surplus demand subtracts the demand (up to the discharge power) and is clamped at empty,
+* while charging from a surplus generation adds the charge less its round trip loss and is clamped at the capacity.
+* The composition of two of these maps is another, so the maps of a block of timesteps can be composed ahead of
+* knowing the state of charge the block starts from.
+*/
+struct SoCMap {
+	float shift = 0.0f;
+	float lo = -std::numeric_limits<float>::infinity();
+	float hi = std::numeric_limits<float>::infinity();
+
+	float operator()(float soc) const {
+		return std::min(std::max(soc + shift, lo), hi);
+	}
+
+	// the map of this step followed by next
+	SoCMap then(const SoCMap& next) const {
+		return {
+			shift + next.shift,
+			std::clamp(lo + next.shift, next.lo, next.hi),
+			std::clamp(hi + next.shift, next.lo, next.hi)
+		};
+	}
+};
+
+/**
+* The result of a CONSUME step from a state of charge, calculated exactly as BasicESS::consume would
+*/
+struct ConsumeStep {
+	float charge;
+	float discharge;
+	float soc;
+};
+
+/**
+* The constants of a Battery that a CONSUME step depends on
+*/
+struct ConsumeParams {
+	float capacity;
+	float chargeMax;
+	float dischargeMax;
+	float rtlRate;
+
+	explicit ConsumeParams(const Battery& battery) :
+		capacity(battery.GetCapacity_e()),
+		chargeMax(battery.getChargeMax_e()),
+		dischargeMax(battery.getDischargeMax_e()),
+		rtlRate(battery.getRTLrate())
+	{}
+
+	ConsumeStep step(float elec, float soc) const {
+		if (elec >= 0) {
+			const float discharge = std::min(elec, std::min(dischargeMax, soc));
+			return { 0.0f, discharge, soc - discharge };
+		}
+		const float charge = std::min(-elec, std::min(chargeMax, (capacity - soc) / (1 - rtlRate)));
+		return { charge, 0.0f, soc + charge - charge * rtlRate };
+	}
+
+	SoCMap map(float elec) const {
+		if (elec >= 0) {
+			return { -std::min(elec, dischargeMax), 0.0f, std::numeric_limits<float>::infinity() };
+		}
+		return { std::min(-elec, chargeMax) * (1 - rtlRate), -std::numeric_limits<float>::infinity(), capacity };
+	}
+};
+
+/**
+* Run a CONSUME ESS over the timesteps of tempSum, as the balancing loop would with no balancing EV or DataCentre
+*
+* The timesteps are split into blocks whose maps are composed in parallel, which gives the state of charge that
+* each block starts from without stepping through the blocks before it. Each block is then stepped in parallel.
+* The composed maps round differently to the steps, so the start of each block is then checked against the end of
+* the block before it, and stepped again from there until it rejoins the first pass (which it does once the battery
+* empties, as that state doesn't depend on rounding). The result is the same as the sequential loop's.
+*
+* Sites with fewer than minBlock timesteps per worker are simply stepped through.
+*/
+void runConsumeScan(BasicESS& ess, TempSum& tempSum, size_t timesteps, ThreadPool& pool, size_t minBlock = 1024);
@@ -3,10 +3,15 @@
 
 CapexBreakdown calculate_capex_with_discounts(const SiteData& siteData, const TaskConfig& config, const TaskData& scenario) {
 
-	const auto& capex_model = config.capex_model;
-
 	// first calculate the unadjusted capex of the scenario
-	auto capex_breakdown = calculate_capex(siteData, scenario, capex_model);
+	auto capex_breakdown = calculate_capex(siteData, scenario, config.capex_model);
+	apply_capex_funding(siteData, config, scenario, capex_breakdown);
+
+	return capex_breakdown;
+}
+
+void apply_capex_funding(const SiteData& siteData, const TaskConfig& config, const TaskData& scenario, CapexBreakdown& capex_breakdown) {
+	const auto& capex_model = config.capex_model;
 
 	if (config.use_boiler_upgrade_scheme) {
 		if (is_elegible_for_boiler_upgrade_scheme(siteData.baseline, scenario)) {
@@ -21,16 +26,53 @@ CapexBreakdown calculate_capex_with_discounts(const SiteData& siteData, const Ta
 		capex_breakdown.general_grant_funding = std::min(capex_breakdown.total_capex, config.general_grant_funding);;
 		capex_breakdown.total_capex -= capex_breakdown.general_grant_funding;
 	}
-
-	return capex_breakdown;
 }
 
 
 CapexBreakdown calculate_capex(const SiteData& siteData, const TaskData& taskData, const CapexModel& capexModel) {
+	return calculate_capex(siteData, taskData, calculate_component_costs(siteData, taskData, capexModel));
+}
+
+
+ComponentCosts calculate_component_costs(const SiteData& siteData, const TaskData& taskData, const CapexModel& capexModel) {
+	ComponentCosts costs{};
+
+	if (taskData.building) {
+		costs.fabric = calculate_fabric_cost(siteData, taskData.building.value());
+	}
+	if (taskData.domestic_hot_water) {
+		costs.dhw = calculate_dhw_cost(taskData.domestic_hot_water.value(), capexModel);
+	}
+	if (taskData.electric_vehicles) {
+		costs.ev = calculate_ev_cost(taskData.electric_vehicles.value(), capexModel);
+	}
+	if (taskData.energy_storage_system) {
+		costs.ess = calculate_ess_cost(taskData.energy_storage_system.value(), capexModel);
+	}
+	if (taskData.gas_heater) {
+		costs.gas_heater = calculate_gas_heater_cost(taskData.gas_heater.value(), capexModel);
+	}
+	if (taskData.grid) {
+		costs.grid = calculate_grid_cost(taskData.grid.value(), capexModel);
+	}
+	if (taskData.heat_pump) {
+		costs.heatpump = calculate_heatpump_cost(taskData.heat_pump.value(), capexModel);
+	}
+
+	costs.solar.reserve(taskData.solar_panels.size());
+	for (const auto& panel : taskData.solar_panels) {
+		costs.solar.push_back(calculate_solar_cost(panel, capexModel));
+	}
+
+	return costs;
+}
+
+
+CapexBreakdown calculate_capex(const SiteData& siteData, const TaskData& taskData, const ComponentCosts& costs) {
 	CapexBreakdown capex_breakdown{};
 
 	if (taskData.building && !taskData.building->incumbent) {
-		capex_breakdown.building_fabric_capex = calculate_fabric_cost(siteData, taskData.building.value());
+		capex_breakdown.building_fabric_capex = costs.fabric;
 
 		size_t fabric_index = taskData.building->fabric_intervention_index;
 		if (fabric_index == 0) {
@@ -43,44 +85,41 @@ CapexBreakdown calculate_capex(const SiteData& siteData, const TaskData& taskDat
 	}
 
 	if (taskData.domestic_hot_water && !taskData.domestic_hot_water->incumbent) {
-		capex_breakdown.dhw_capex = calculate_dhw_cost(taskData.domestic_hot_water.value(), capexModel);
+		capex_breakdown.dhw_capex = costs.dhw;
 	}
 
 	if (taskData.electric_vehicles && !taskData.electric_vehicles->incumbent) {
-		EVCapex ev_capex = calculate_ev_cost(taskData.electric_vehicles.value(), capexModel);
-		capex_breakdown.ev_charger_cost = ev_capex.charger_cost;
-		capex_breakdown.ev_charger_install = ev_capex.charger_install;
+		capex_breakdown.ev_charger_cost = costs.ev.charger_cost;
+		capex_breakdown.ev_charger_install = costs.ev.charger_install;
 	}
 
 	if (taskData.energy_storage_system && !taskData.energy_storage_system->incumbent) {
-		ESSCapex ess_capex = calculate_ess_cost(taskData.energy_storage_system.value(), capexModel);
-		capex_breakdown.ess_enclosure_capex = ess_capex.enclosure_capex;
-		capex_breakdown.ess_enclosure_disposal = ess_capex.enclosure_disposal;
-		capex_breakdown.ess_pcs_capex = ess_capex.pcs_capex;
+		capex_breakdown.ess_enclosure_capex = costs.ess.enclosure_capex;
+		capex_breakdown.ess_enclosure_disposal = costs.ess.enclosure_disposal;
+		capex_breakdown.ess_pcs_capex = costs.ess.pcs_capex;
 	}
 
 	if (taskData.gas_heater && !taskData.gas_heater->incumbent) {
-		capex_breakdown.gas_heater_capex = calculate_gas_heater_cost(taskData.gas_heater.value(), capexModel);
+		capex_breakdown.gas_heater_capex = costs.gas_heater;
 	}
 
 	if (taskData.grid && !taskData.grid->incumbent) {
-		capex_breakdown.grid_capex = calculate_grid_cost(taskData.grid.value(), capexModel);
+		capex_breakdown.grid_capex = costs.grid;
 	}
 
 	if (taskData.heat_pump && !taskData.heat_pump->incumbent) {
-		capex_breakdown.heatpump_capex = calculate_heatpump_cost(taskData.heat_pump.value(), capexModel);
+		capex_breakdown.heatpump_capex = costs.heatpump;
 	}
 
-	for (const auto& panel : taskData.solar_panels) {
-		if (!panel.incumbent) {
-			SolarCapex solar_capex = calculate_solar_cost(panel, capexModel);
+	for (size_t i = 0; i < taskData.solar_panels.size(); i++) {
+		if (!taskData.solar_panels[i].incumbent) {
+			const SolarCapex& solar_capex = costs.solar[i];
 			capex_breakdown.pv_panel_capex += solar_capex.panel_capex;
 			capex_breakdown.pv_ground_capex += solar_capex.ground_capex;
 			capex_breakdown.pv_roof_capex += solar_capex.roof_capex;
 			capex_breakdown.pv_BoP_capex += solar_capex.BoP_capex;
 		}
 	}
-
 	capex_breakdown.total_capex = (
 		capex_breakdown.building_fabric_capex 
 
@@ -118,72 +157,139 @@ float calculate_fabric_cost(const SiteData& siteData, const Building& building)
 	}
 }
 
-float calculate_dhw_cost(const DomesticHotWater& dhw, const CapexModel& model) {
-	return calculate_piecewise_costs(model.dhw_prices, dhw.cylinder_volume);
+namespace {
+	// each cost is the same for a CapexModel and the CompiledCapexModel made from it
+
+	template <typename Model>
+	float dhw_cost(const DomesticHotWater& dhw, const Model& model) {
+		return calculate_piecewise_costs(model.dhw_prices, dhw.cylinder_volume);
+	}
+
+	template <typename Model>
+	EVCapex ev_cost(const ElectricVehicles& ev, const Model& model) {
+		EVCapex ev_capex{};
+
+		ev_capex.charger_cost = (
+			ev.small_chargers * model.ev_prices.small_cost
+			+ ev.fast_chargers * model.ev_prices.fast_cost
+			+ ev.rapid_chargers * model.ev_prices.rapid_cost
+			+ ev.ultra_chargers * model.ev_prices.ultra_cost
+		);
+
+		ev_capex.charger_install = (
+			ev.small_chargers * model.ev_prices.small_install
+			+ ev.fast_chargers * model.ev_prices.fast_install
+			+ ev.rapid_chargers * model.ev_prices.rapid_install
+			+ ev.ultra_chargers * model.ev_prices.ultra_install
+		);
+
+		return ev_capex;
+	}
+
+	template <typename Model>
+	ESSCapex ess_cost(const EnergyStorageSystem& ess, const Model& model) {
+		ESSCapex ess_capex{};
+		float ess_power = std::max(ess.charge_power, ess.discharge_power);
+
+		ess_capex.pcs_capex = calculate_piecewise_costs(model.ess_pcs_prices, ess_power);
+		ess_capex.enclosure_capex = calculate_piecewise_costs(model.ess_enclosure_prices, ess.capacity);
+		ess_capex.enclosure_disposal = calculate_piecewise_costs(model.ess_enclosure_disposal_prices, ess.capacity);
+		return ess_capex;
+	}
+
+	template <typename Model>
+	float gas_heater_cost(const GasCHData& gas, const Model& model) {
+		return calculate_piecewise_costs(model.gas_heater_prices, gas.maximum_output);
+	}
+
+	template <typename Model>
+	float grid_cost([[maybe_unused]] const GridData& grid, const Model& model) {
+
+		// set Grid upgrade to zero for the moment
+		const float grid_upgrade_kw = 0.0f;
+		return calculate_piecewise_costs(model.grid_prices, grid_upgrade_kw);
+	}
+
+	template <typename Model>
+	float heatpump_cost(const HeatPumpData& hp, const Model& model) {
+		return calculate_piecewise_costs(model.heatpump_prices, hp.heat_power);
+	}
+
+	template <typename Model>
+	SolarCapex solar_cost(const SolarData& panel, const Model& model) {
+		SolarCapex solar_capex{};
+
+		// For now, it is assumed that all ALCHEMAI solar is roof mounted
+		bool is_roof_mounted = true;
+
+		if (is_roof_mounted) {
+			solar_capex.roof_capex = calculate_piecewise_costs(model.pv_roof_prices, panel.yield_scalar);
+		}
+		else {
+			solar_capex.ground_capex = calculate_piecewise_costs(model.pv_ground_prices, panel.yield_scalar);
+		}
+
+		solar_capex.panel_capex = calculate_piecewise_costs(model.pv_panel_prices, panel.yield_scalar);
+		solar_capex.BoP_capex = calculate_piecewise_costs(model.pv_BoP_prices, panel.yield_scalar);
+
+		return solar_capex;
+	}
 }
 
-EVCapex calculate_ev_cost(const ElectricVehicles& ev, const CapexModel& model) {
-	EVCapex ev_capex{};
+float calculate_dhw_cost(const DomesticHotWater& dhw, const CapexModel& model) {
+	return dhw_cost(dhw, model);
+}
 
-	ev_capex.charger_cost = (
-		ev.small_chargers * model.ev_prices.small_cost
-		+ ev.fast_chargers * model.ev_prices.fast_cost
-		+ ev.rapid_chargers * model.ev_prices.rapid_cost
-		+ ev.ultra_chargers * model.ev_prices.ultra_cost
-	);
+float calculate_dhw_cost(const DomesticHotWater& dhw, const CompiledCapexModel& model) {
+	return dhw_cost(dhw, model);
+}
 
-	ev_capex.charger_install = (
-		ev.small_chargers * model.ev_prices.small_install
-		+ ev.fast_chargers * model.ev_prices.fast_install
-		+ ev.rapid_chargers * model.ev_prices.rapid_install
-		+ ev.ultra_chargers * model.ev_prices.ultra_install
-	);
+EVCapex calculate_ev_cost(const ElectricVehicles& ev, const CapexModel& model) {
+	return ev_cost(ev, model);
+}
 
-	return ev_capex;
+EVCapex calculate_ev_cost(const ElectricVehicles& ev, const CompiledCapexModel& model) {
+	return ev_cost(ev, model);
 }
 
 ESSCapex calculate_ess_cost(const EnergyStorageSystem& ess, const CapexModel& model) {
-	ESSCapex ess_capex{};
-	float ess_power = std::max(ess.charge_power, ess.discharge_power);
+	return ess_cost(ess, model);
+}
 
-	ess_capex.pcs_capex = calculate_piecewise_costs(model.ess_pcs_prices, ess_power);
-	ess_capex.enclosure_capex = calculate_piecewise_costs(model.ess_enclosure_prices, ess.capacity);
-	ess_capex.enclosure_disposal = calculate_piecewise_costs(model.ess_enclosure_disposal_prices, ess.capacity);
-	return ess_capex;
+ESSCapex calculate_ess_cost(const EnergyStorageSystem& ess, const CompiledCapexModel& model) {
+	return ess_cost(ess, model);
 }
 
 float calculate_gas_heater_cost(const GasCHData& gas, const CapexModel& model) {
-	return calculate_piecewise_costs(model.gas_heater_prices, gas.maximum_output);
+	return gas_heater_cost(gas, model);
 }
 
-float calculate_grid_cost([[maybe_unused]] const GridData& grid, const CapexModel& model) {
-
-	// set Grid upgrade to zero for the moment
-	const float grid_upgrade_kw = 0.0f;
-	return calculate_piecewise_costs(model.grid_prices, grid_upgrade_kw);
+float calculate_gas_heater_cost(const GasCHData& gas, const CompiledCapexModel& model) {
+	return gas_heater_cost(gas, model);
 }
 
-float calculate_heatpump_cost(const HeatPumpData& hp, const CapexModel& model) {
-	return calculate_piecewise_costs(model.heatpump_prices, hp.heat_power);
+float calculate_grid_cost(const GridData& grid, const CapexModel& model) {
+	return grid_cost(grid, model);
 }
 
-SolarCapex calculate_solar_cost(const SolarData& panel, const CapexModel& model) {
-	SolarCapex solar_capex{};
+float calculate_grid_cost(const GridData& grid, const CompiledCapexModel& model) {
+	return grid_cost(grid, model);
+}
 
-	// For now, it is assumed that all ALCHEMAI solar is roof mounted
-	bool is_roof_mounted = true;
+float calculate_heatpump_cost(const HeatPumpData& hp, const CapexModel& model) {
+	return heatpump_cost(hp, model);
+}
 
-	if (is_roof_mounted) {
-		solar_capex.roof_capex = calculate_piecewise_costs(model.pv_roof_prices, panel.yield_scalar);
-	}
-	else {
-		solar_capex.ground_capex = calculate_piecewise_costs(model.pv_ground_prices, panel.yield_scalar);
-	}
+float calculate_heatpump_cost(const HeatPumpData& hp, const CompiledCapexModel& model) {
+	return heatpump_cost(hp, model);
+}
 
-	solar_capex.panel_capex = calculate_piecewise_costs(model.pv_panel_prices, panel.yield_scalar);
-	solar_capex.BoP_capex = calculate_piecewise_costs(model.pv_BoP_prices, panel.yield_scalar);
+SolarCapex calculate_solar_cost(const SolarData& panel, const CapexModel& model) {
+	return solar_cost(panel, model);
+}
 
-	return solar_capex;
+SolarCapex calculate_solar_cost(const SolarData& panel, const CompiledCapexModel& model) {
+	return solar_cost(panel, model);
 }
 
 
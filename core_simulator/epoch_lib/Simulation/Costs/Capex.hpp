@@ -1,15 +1,41 @@
 #pragma once
 
+#include <vector>
+
 #include "CostData.hpp"
 #include "../SiteData.hpp"
 #include "../TaskData.hpp"
 #include "../TaskComponents.hpp"
 #include "../TaskConfig.hpp"
 
+/**
+* The unadjusted cost of each component of a scenario, whether or not it is incumbent
+* (the capex only counts the new components, but the NPV must still replace the incumbents)
+*/
+struct ComponentCosts {
+	float fabric = 0.0f;
+	float dhw = 0.0f;
+	EVCapex ev{};
+	ESSCapex ess{};
+	float gas_heater = 0.0f;
+	float grid = 0.0f;
+	float heatpump = 0.0f;
+	// one for each of the scenario's solar panels
+	std::vector<SolarCapex> solar;
+};
+
 CapexBreakdown calculate_capex_with_discounts(const SiteData& siteData, const TaskConfig& config, const TaskData& scenario);
 
 CapexBreakdown calculate_capex(const SiteData& siteData, const TaskData& taskData, const CapexModel& model);
 
+// the capex of the new components, from their already calculated costs
+CapexBreakdown calculate_capex(const SiteData& siteData, const TaskData& taskData, const ComponentCosts& costs);
+
+// reduce the capex by any funding that the scenario is eligible for
+void apply_capex_funding(const SiteData& siteData, const TaskConfig& config, const TaskData& scenario, CapexBreakdown& capex_breakdown);
+
+ComponentCosts calculate_component_costs(const SiteData& siteData, const TaskData& taskData, const CapexModel& model);
+
 // note: these functions are named calculate_X_cost
 // this is to denote that they are not responsible for checking whether the component is incumbent
 // this check is made in calculate_capex
@@ -17,17 +43,24 @@ CapexBreakdown calculate_capex(const SiteData& siteData, const TaskData& taskDat
 float calculate_fabric_cost(const SiteData& siteData, const Building& building);
 
 float calculate_dhw_cost(const DomesticHotWater& dhw, const CapexModel& model);
+float calculate_dhw_cost(const DomesticHotWater& dhw, const CompiledCapexModel& model);
 
 EVCapex calculate_ev_cost(const ElectricVehicles& ev, const CapexModel& model);
+EVCapex calculate_ev_cost(const ElectricVehicles& ev, const CompiledCapexModel& model);
 
 ESSCapex calculate_ess_cost(const EnergyStorageSystem& ess, const CapexModel& model);
+ESSCapex calculate_ess_cost(const EnergyStorageSystem& ess, const CompiledCapexModel& model);
 
 float calculate_gas_heater_cost(const GasCHData& gas, const CapexModel& model);
+float calculate_gas_heater_cost(const GasCHData& gas, const CompiledCapexModel& model);
 
 float calculate_grid_cost(const GridData& grid, const CapexModel& model);
+float calculate_grid_cost(const GridData& grid, const CompiledCapexModel& model);
 
 float calculate_heatpump_cost(const HeatPumpData& hp, const CapexModel& model);
+float calculate_heatpump_cost(const HeatPumpData& hp, const CompiledCapexModel& model);
 
 SolarCapex calculate_solar_cost(const SolarData& panel, const CapexModel& model);
+SolarCapex calculate_solar_cost(const SolarData& panel, const CompiledCapexModel& model);
 
 bool is_elegible_for_boiler_upgrade_scheme(const TaskData& baseline, const TaskData& scenario);
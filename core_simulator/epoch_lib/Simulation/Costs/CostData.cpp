@@ -1,5 +1,9 @@
 #include "CostData.hpp"
 
+#include <algorithm>
+#include <format>
+#include <stdexcept>
+
 
 float calculate_piecewise_costs(const PiecewiseCostModel& costModel, float num_units) {
 	/**
@@ -37,6 +41,77 @@ float calculate_piecewise_costs(const PiecewiseCostModel& costModel, float num_u
 }
 
 
+PiecewiseCostTable::PiecewiseCostTable(const PiecewiseCostModel& model) {
+	mUpper.reserve(model.segments.size());
+	mLower.reserve(model.segments.size() + 1);
+	mCumulative.reserve(model.segments.size() + 1);
+	mRate.reserve(model.segments.size() + 1);
+
+	// accumulate in the same order as calculate_piecewise_costs, so that the costs are identical
+	float total_cost = model.fixed_cost;
+	float prev_upper = 0.0f;
+	mCumulative.front() = total_cost;
+
+	for (const auto& segment : model.segments) {
+		if (!mUpper.empty() && segment.upper < mUpper.back()) {
+			throw std::runtime_error(std::format(
+				"The segments of a piecewise cost model must increase, but {} follows {}", segment.upper, mUpper.back()));
+		}
+		mUpper.push_back(segment.upper);
+		mRate.back() = segment.rate;
+
+		total_cost += (segment.upper - prev_upper) * segment.rate;
+		prev_upper = segment.upper;
+
+		mLower.push_back(prev_upper);
+		mCumulative.push_back(total_cost);
+		mRate.push_back(0.0f);
+	}
+	mRate.back() = model.final_rate;
+}
+
+float PiecewiseCostTable::cost(float numUnits) const {
+	// the first segment whose upper bound is at least numUnits (or the final rate beyond them all)
+	const size_t k = static_cast<size_t>(std::lower_bound(mUpper.begin(), mUpper.end(), numUnits) - mUpper.begin());
+
+	if (k == mUpper.size() && !(numUnits > mLower[k])) {
+		// only reachable without any segments: the final rate applies above 0
+		return mCumulative[k];
+	}
+	return mCumulative[k] + (numUnits - mLower[k]) * mRate[k];
+}
+
+Eigen::ArrayXf PiecewiseCostTable::costs(const Eigen::Ref<const Eigen::ArrayXf>& numUnits) const {
+	const size_t segments = mUpper.size();
+
+	// the first segment applies to anything below its upper bound,
+	// then each later segment (and the final rate) to anything above its start
+	Eigen::ArrayXf result = segments > 0
+		? Eigen::ArrayXf(mCumulative[0] + (numUnits - mLower[0]) * mRate[0])
+		: Eigen::ArrayXf::Constant(numUnits.size(), mCumulative[0]);
+
+	for (size_t k = segments > 0 ? 1 : 0; k <= segments; k++) {
+		result = (numUnits > mLower[k]).select(mCumulative[k] + (numUnits - mLower[k]) * mRate[k], result);
+	}
+	return result;
+}
+
+CompiledCapexModel::CompiledCapexModel(const CapexModel& model) :
+	dhw_prices(model.dhw_prices),
+	ev_prices(model.ev_prices),
+	gas_heater_prices(model.gas_heater_prices),
+	grid_prices(model.grid_prices),
+	heatpump_prices(model.heatpump_prices),
+	ess_pcs_prices(model.ess_pcs_prices),
+	ess_enclosure_prices(model.ess_enclosure_prices),
+	ess_enclosure_disposal_prices(model.ess_enclosure_disposal_prices),
+	pv_panel_prices(model.pv_panel_prices),
+	pv_roof_prices(model.pv_roof_prices),
+	pv_ground_prices(model.pv_ground_prices),
+	pv_BoP_prices(model.pv_BoP_prices)
+{
+}
+
 CapexModel make_default_capex_prices() {
 	CapexModel model;
 
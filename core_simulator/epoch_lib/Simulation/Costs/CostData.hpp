@@ -2,6 +2,8 @@
 
 #include <vector>
 
+#include <Eigen/Core>
+
 struct EVChargerCosts {
 	float small_cost = 1200.0f;
 	float fast_cost = 2500.0f;
@@ -12,12 +14,16 @@ struct EVChargerCosts {
 	float fast_install = 1000.0f;
 	float rapid_install = 3000.0f;
 	float ultra_install = 10000.0f;
+
+	bool operator==(const EVChargerCosts&) const = default;
 };
 
 
 struct Segment {
 	float upper;
 	float rate;
+
+	bool operator==(const Segment&) const = default;
 };
 
 struct PiecewiseCostModel {
@@ -28,6 +34,35 @@ struct PiecewiseCostModel {
 	bool operator==(const PiecewiseCostModel&) const = default;
 };
 
+/**
+* A PiecewiseCostModel compiled to flat arrays, for repeated evaluation
+*
+* Segment k starts at breakpoint k, where the cumulative cost of every earlier segment is stored,
+* so the cost of a size is found by a binary search and a single multiply-add.
+* The costs are identical to those of calculate_piecewise_costs.
+*/
+class PiecewiseCostTable {
+public:
+	PiecewiseCostTable() = default;
+	// throws a runtime_error if the upper bounds of the segments decrease
+	explicit PiecewiseCostTable(const PiecewiseCostModel& model);
+
+	float cost(float numUnits) const;
+
+	// the cost of every size in a column at once (e.g. every candidate ESS capacity in a population)
+	Eigen::ArrayXf costs(const Eigen::Ref<const Eigen::ArrayXf>& numUnits) const;
+
+private:
+	// the upper bound of each segment
+	std::vector<float> mUpper;
+	// the start of each segment and of the final rate (the first starts at 0)
+	std::vector<float> mLower{ 0.0f };
+	// the fixed cost plus the cost of every segment before each start
+	std::vector<float> mCumulative{ 0.0f };
+	// the rate of each segment and then the final rate
+	std::vector<float> mRate{ 0.0f };
+};
+
 
 struct CapexModel {
 	// dhw costs are in £ / litre
@@ -61,12 +96,38 @@ struct CapexModel {
 };
 
 
+/**
+* A CapexModel with each of its piecewise models compiled once to a PiecewiseCostTable
+*/
+struct CompiledCapexModel {
+	explicit CompiledCapexModel(const CapexModel& model);
+
+	PiecewiseCostTable dhw_prices;
+	EVChargerCosts ev_prices;
+
+	PiecewiseCostTable gas_heater_prices;
+	PiecewiseCostTable grid_prices;
+	PiecewiseCostTable heatpump_prices;
+
+	PiecewiseCostTable ess_pcs_prices;
+	PiecewiseCostTable ess_enclosure_prices;
+	PiecewiseCostTable ess_enclosure_disposal_prices;
+
+	PiecewiseCostTable pv_panel_prices;
+	PiecewiseCostTable pv_roof_prices;
+	PiecewiseCostTable pv_ground_prices;
+	PiecewiseCostTable pv_BoP_prices;
+};
+
+
 struct OpexModel {
 	PiecewiseCostModel ess_pcs_prices;
 	PiecewiseCostModel ess_enclosure_prices;
 	PiecewiseCostModel gas_heater_prices;
 	PiecewiseCostModel heatpump_prices;
 	PiecewiseCostModel pv_prices;
+
+	bool operator==(const OpexModel&) const = default;
 };
 
 
@@ -106,3 +167,7 @@ struct OpexBreakdown {
 
 
 float calculate_piecewise_costs(const PiecewiseCostModel& costModel, float numUnits);
+
+inline float calculate_piecewise_costs(const PiecewiseCostTable& costTable, float numUnits) {
+	return costTable.cost(numUnits);
+}
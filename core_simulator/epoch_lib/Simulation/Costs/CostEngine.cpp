@@ -0,0 +1,86 @@
+#include "CostEngine.hpp"
+
+#include <algorithm>
+
+CostEngine::CostEngine(const SiteData& siteData, TaskConfig config) :
+	mSiteData(siteData),
+	mConfig(std::move(config)),
+	mCapexModel(mConfig.capex_model),
+	mDiscounts(mConfig)
+{
+}
+
+ScenarioCosts CostEngine::evaluate(const TaskData& scenario) const {
+	ScenarioCosts scenarioCosts{};
+	evaluate(scenario, scenarioCosts);
+	return scenarioCosts;
+}
+
+void CostEngine::evaluate(const TaskData& scenario, ScenarioCosts& scenarioCosts) const {
+	// the component costs are only needed while evaluating, so each thread keeps one to reuse
+	thread_local ComponentCosts costs;
+	componentCosts(scenario, costs);
+
+	scenarioCosts.capex = calculate_capex(mSiteData, scenario, costs);
+	apply_capex_funding(mSiteData, mConfig, scenario, scenarioCosts.capex);
+	make_component_views(scenario, costs, scenarioCosts.components);
+}
+
+ComponentCosts CostEngine::componentCosts(const TaskData& scenario) const {
+	ComponentCosts costs{};
+	componentCosts(scenario, costs);
+	return costs;
+}
+
+void CostEngine::componentCosts(const TaskData& scenario, ComponentCosts& costs) const {
+	const CompiledCapexModel& model = mCapexModel;
+	// keep the capacity of the solar costs
+	std::vector<SolarCapex> solar = std::move(costs.solar);
+	solar.clear();
+	costs = ComponentCosts{};
+	costs.solar = std::move(solar);
+
+	// the fabric cost is a lookup and the EV chargers and grid are linear, so these aren't memoised
+	if (scenario.building) {
+		costs.fabric = calculate_fabric_cost(mSiteData, scenario.building.value());
+	}
+	if (scenario.electric_vehicles) {
+		costs.ev = calculate_ev_cost(scenario.electric_vehicles.value(), model);
+	}
+	if (scenario.grid) {
+		costs.grid = calculate_grid_cost(scenario.grid.value(), model);
+	}
+
+	if (scenario.domestic_hot_water) {
+		const auto& dhw = scenario.domestic_hot_water.value();
+		costs.dhw = mDHWCosts.get({ dhw.cylinder_volume }, [&] { return calculate_dhw_cost(dhw, model); });
+	}
+	if (scenario.energy_storage_system) {
+		const auto& ess = scenario.energy_storage_system.value();
+		const float power = std::max(ess.charge_power, ess.discharge_power);
+		costs.ess = mESSCosts.get({ power, ess.capacity }, [&] { return calculate_ess_cost(ess, model); });
+	}
+	if (scenario.gas_heater) {
+		const auto& gas = scenario.gas_heater.value();
+		costs.gas_heater = mGasHeaterCosts.get({ gas.maximum_output }, [&] { return calculate_gas_heater_cost(gas, model); });
+	}
+	if (scenario.heat_pump) {
+		const auto& hp = scenario.heat_pump.value();
+		costs.heatpump = mHeatPumpCosts.get({ hp.heat_power }, [&] { return calculate_heatpump_cost(hp, model); });
+	}
+
+	costs.solar.reserve(scenario.solar_panels.size());
+	for (const auto& panel : scenario.solar_panels) {
+		costs.solar.push_back(mSolarCosts.get({ panel.yield_scalar }, [&] { return calculate_solar_cost(panel, model); }));
+	}
+}
+
+CacheStats CostEngine::memoStats() const {
+	CacheStats stats{};
+	mDHWCosts.addStats(stats);
+	mESSCosts.addStats(stats);
+	mGasHeaterCosts.addStats(stats);
+	mHeatPumpCosts.addStats(stats);
+	mSolarCosts.addStats(stats);
+	return stats;
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "../../Definitions.hpp"
+#include "../CacheStats.hpp"
+#include "../SiteData.hpp"
+#include "../TaskConfig.hpp"
+#include "../TaskData.hpp"
+#include "Capex.hpp"
+#include "NetPresentValue.hpp"
+
+/**
+* The costs of a scenario, evaluated once and shared by its usage, NPV and result
+*/
+struct ScenarioCosts {
+	// the capex of the new components, after any funding
+	CapexBreakdown capex;
+	// every component with its unadjusted capex, for the NPV
+	std::vector<ComponentView> components;
+};
+
+/**
+* Evaluates the CapexModel of one site and config for each scenario
+*
+* The piecewise cost of each sized component is memoised on the parameters it depends on,
+* as a GA population repeats the same ESS, heatpump and solar sizes many times over.
+* This is internally synchronised, so it may be shared by concurrent scenarios.
+*/
+class CostEngine {
+public:
+	// the SiteData must outlive the CostEngine
+	CostEngine(const SiteData& siteData, TaskConfig config);
+
+	ScenarioCosts evaluate(const TaskData& scenario) const;
+	// evaluate into costs, reusing the capacity of its vectors (so a reused ScenarioCosts doesn't allocate)
+	void evaluate(const TaskData& scenario, ScenarioCosts& costs) const;
+
+	ComponentCosts componentCosts(const TaskData& scenario) const;
+	void componentCosts(const TaskData& scenario, ComponentCosts& costs) const;
+
+	// the config's NPV discount factors
+	const DiscountTable& discounts() const { return mDiscounts; }
+
+	// the combined counters of the memoised component costs (the bytes are not tracked)
+	CacheStats memoStats() const;
+
+private:
+	/**
+	* A map from the parameters of a component to its cost
+	* It is cleared once it holds MAX_ENTRIES, which bounds the memory of a long-running optimisation
+	*/
+	template <size_t N, typename Cost>
+	class Memo {
+	public:
+		using Key = std::array<float, N>;
+
+		template <typename Calculate>
+		Cost get(const Key& key, Calculate&& calculate) {
+			{
+				std::lock_guard<std::mutex> lock(mMutex);
+				auto it = mCosts.find(key);
+				if (it != mCosts.end()) {
+					mHits++;
+					return it->second;
+				}
+				mMisses++;
+			}
+
+			// the costs are cheap compared with the lock, so are calculated outside it
+			Cost cost = calculate();
+
+			std::lock_guard<std::mutex> lock(mMutex);
+			if (mCosts.size() >= MAX_ENTRIES) {
+				mEvictions += mCosts.size();
+				mCosts.clear();
+			}
+			mCosts.emplace(key, cost);
+			return cost;
+		}
+
+		void addStats(CacheStats& stats) const {
+			std::lock_guard<std::mutex> lock(mMutex);
+			stats.hits += mHits;
+			stats.misses += mMisses;
+			stats.evictions += mEvictions;
+			stats.entries += mCosts.size();
+			// each entry is a node of the map (with its next pointer and hash) and a bucket
+			stats.bytes += mCosts.size() * (sizeof(typename decltype(mCosts)::value_type) + 3 * sizeof(void*));
+		}
+
+	private:
+		static constexpr size_t MAX_ENTRIES = 1 << 16;
+
+		struct KeyHash {
+			size_t operator()(const Key& key) const {
+				size_t hash = 0;
+				for (float value : key) {
+					hash = hash * 31 + std::hash<float>{}(value);
+				}
+				return hash;
+			}
+		};
+
+		mutable std::mutex mMutex;
+		std::unordered_map<Key, Cost, KeyHash> mCosts;
+		uint64_t mHits = 0;
+		uint64_t mMisses = 0;
+		uint64_t mEvictions = 0;
+	};
+
+	const SiteData& mSiteData;
+	const TaskConfig mConfig;
+	// the config's CapexModel, compiled once for every scenario
+	const CompiledCapexModel mCapexModel;
+	const DiscountTable mDiscounts;
+
+	// keyed on the cylinder volume
+	mutable Memo<1, float> mDHWCosts;
+	// keyed on the (larger of the charge and discharge) power and the capacity
+	mutable Memo<2, ESSCapex> mESSCosts;
+	// keyed on the maximum output
+	mutable Memo<1, float> mGasHeaterCosts;
+	// keyed on the heat power
+	mutable Memo<1, float> mHeatPumpCosts;
+	// keyed on the yield scalar
+	mutable Memo<1, SolarCapex> mSolarCosts;
+};
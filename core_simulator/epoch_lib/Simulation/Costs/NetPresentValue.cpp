@@ -1,20 +1,28 @@
 #include "NetPresentValue.hpp"
 
+#include <algorithm>
 #include <cmath>
+#include <format>
+#include <stdexcept>
 
 ValueMetrics calculate_npv(const SiteData& siteData, const TaskConfig& config, const TaskData& scenario, const UsageData& usage) {
-	ValueMetrics valueMetrics{};
-
-	int horizon = config.npv_time_horizon;
-	float discount_factor = config.npv_discount_factor;
-	const auto& capex_model = config.capex_model;
-	//const auto& opex_model = config.opex_model;
+	auto components = make_component_views(scenario, calculate_component_costs(siteData, scenario, config.capex_model));
+	return calculate_npv(config, components, usage);
+}
 
+std::vector<ComponentView> make_component_views(const TaskData& scenario, const ComponentCosts& costs) {
 	std::vector<ComponentView> components{};
+	make_component_views(scenario, costs, components);
+	return components;
+}
+
+void make_component_views(const TaskData& scenario, const ComponentCosts& costs, std::vector<ComponentView>& components) {
+	components.clear();
+	// at most one of each optional component, and a view for each solar array
+	components.reserve(9 + scenario.solar_panels.size());
 
 	if (scenario.building) {
-		float fabric_cost = calculate_fabric_cost(siteData, scenario.building.value());
-		components.emplace_back(make_component(scenario.building.value(), fabric_cost));
+		components.emplace_back(make_component(scenario.building.value(), costs.fabric));
 	}
 
 	if (scenario.data_centre) {
@@ -22,52 +30,53 @@ ValueMetrics calculate_npv(const SiteData& siteData, const TaskConfig& config, c
 	}
 
 	if (scenario.domestic_hot_water) {
-		float dhw_cost = calculate_dhw_cost(scenario.domestic_hot_water.value(), capex_model);
-		components.emplace_back(make_component(scenario.domestic_hot_water.value(), dhw_cost));
+		components.emplace_back(make_component(scenario.domestic_hot_water.value(), costs.dhw));
 	}
 
 	if (scenario.electric_vehicles) {
-		EVCapex ev_capex = calculate_ev_cost(scenario.electric_vehicles.value(), capex_model);
 		components.emplace_back(make_component(scenario.electric_vehicles.value(), 
-			ev_capex.charger_cost + ev_capex.charger_install));
+			costs.ev.charger_cost + costs.ev.charger_install));
 	}
 
 	if (scenario.energy_storage_system) {
-		ESSCapex ess_capex = calculate_ess_cost(scenario.energy_storage_system.value(), capex_model);
-
 		components.emplace_back(make_component(scenario.energy_storage_system.value(),
-			ess_capex.enclosure_capex + ess_capex.enclosure_disposal + ess_capex.pcs_capex));
+			costs.ess.enclosure_capex + costs.ess.enclosure_disposal + costs.ess.pcs_capex));
 	}
 
 	if (scenario.gas_heater) {
-		float heater_cost = calculate_gas_heater_cost(scenario.gas_heater.value(), capex_model);
-		components.emplace_back(make_component(scenario.gas_heater.value(), heater_cost));
+		components.emplace_back(make_component(scenario.gas_heater.value(), costs.gas_heater));
 	}
 
 	if (scenario.grid) {
-		float grid_cost = calculate_grid_cost(scenario.grid.value(), capex_model);
-		components.emplace_back(make_component(scenario.grid.value(), grid_cost));
+		components.emplace_back(make_component(scenario.grid.value(), costs.grid));
 	}
 
 	if (scenario.heat_pump) {
-		float hp_cost = calculate_heatpump_cost(scenario.heat_pump.value(), capex_model);
-		components.emplace_back(make_component(scenario.heat_pump.value(), hp_cost));
+		components.emplace_back(make_component(scenario.heat_pump.value(), costs.heatpump));
 	}
 
 	if (scenario.mop) {
 		components.emplace_back(make_component(scenario.mop.value(), 0.0f));
 	}
 
-	for (const auto& panel : scenario.solar_panels) {
+	for (size_t i = 0; i < scenario.solar_panels.size(); i++) {
+		const auto& panel = scenario.solar_panels[i];
 		ComponentView cv{};
 		cv.age = panel.age;
 		cv.lifetime = panel.lifetime;
 		cv.incumbent = panel.incumbent;
-		auto solar_capex = calculate_solar_cost(panel, capex_model);
+		const auto& solar_capex = costs.solar[i];
 		cv.capex = solar_capex.panel_capex + solar_capex.roof_capex + solar_capex.ground_capex + solar_capex.BoP_capex;
 		components.emplace_back(cv);
 	}
+}
 
+ValueMetrics calculate_npv(const TaskConfig& config, std::span<const ComponentView> components, const UsageData& usage) {
+	return calculate_npv(DiscountTable(config), components, usage);
+}
+
+ValueMetrics calculate_npv(const DiscountTable& discounts, std::span<const ComponentView> components, const UsageData& usage) {
+	ValueMetrics valueMetrics{};
 
 	float out = usage.elec_cost + usage.fuel_cost;
 	float in = usage.export_revenue + usage.electric_vehicle_revenue +
@@ -81,45 +90,102 @@ ValueMetrics calculate_npv(const SiteData& siteData, const TaskConfig& config, c
 
 	valueMetrics.annualised_cost += total_opex;
 
-	std::vector<float> costs(horizon, meter_balance + total_opex);
+	// the meter balance and opex are the same in every year
+	double cost = (meter_balance + total_opex) * discounts.annuity();
 
-	float total_funding = usage.capex_breakdown.general_grant_funding + usage.capex_breakdown.boiler_upgrade_scheme_funding;
 	// subtract the total_funding from year 0
-	costs[0] -= total_funding;
-
+	float total_funding = usage.capex_breakdown.general_grant_funding + usage.capex_breakdown.boiler_upgrade_scheme_funding;
+	cost -= total_funding;
 
 	for (const auto& comp : components) {
 		if (!comp.incumbent) {
-			costs[0] += comp.capex;
 			valueMetrics.annualised_cost += (comp.capex / comp.lifetime);
 		}
+		cost += discounts.componentCost(comp);
+	}
 
-		// If a user has provided an age greater than the lifetime of this component,
-		// then presume we replace it in year zero.
-		float next_replacement = std::max(comp.lifetime - comp.age, 0.0f);
-		//int next_replacement = std::ceil(comp.lifetime - comp.age);
+	// we subtract as we have framed everything as a cost rather than a value
+	valueMetrics.net_present_value = static_cast<float>(-cost);
 
-		while (next_replacement < horizon) {
-			// next_replacement should always be >=0 so truncate / round down with static_cast
-			costs[static_cast<int>(next_replacement)] += comp.capex;
-			next_replacement += comp.lifetime;
-		}
+	return valueMetrics;
+}
 
-		// finally subtract any residual value
-		float residual_years = next_replacement - horizon;
-		float residual_capex = comp.capex * (residual_years / comp.lifetime);
+void calculate_npv(const DiscountTable& discounts, std::span<const std::vector<ComponentView>> components,
+	std::span<const UsageData> usage, std::span<ValueMetrics> results) {
+	if (components.size() != usage.size() || results.size() != usage.size()) {
+		throw std::runtime_error(std::format("Cannot calculate the NPV of {} scenarios from {} component lists into {} results",
+			usage.size(), components.size(), results.size()));
+	}
+	for (size_t i = 0; i < usage.size(); i++) {
+		results[i] = calculate_npv(discounts, components[i], usage[i]);
+	}
+}
+
+
+DiscountTable::DiscountTable(const TaskConfig& config) :
+	DiscountTable(config.npv_time_horizon, config.npv_discount_factor)
+{
+}
+
+DiscountTable::DiscountTable(int horizon, float discount_factor) :
+	mHorizon(horizon),
+	mGrowth(1.0f + discount_factor),
+	mPresentValue(),
+	mAnnuity(0.0)
+{
+	if (horizon < 1) {
+		throw std::runtime_error(std::format("The NPV time horizon must be at least 1 year, not {}", horizon));
+	}
 
-		costs.back() -= residual_capex;
+	mPresentValue.reserve(static_cast<size_t>(horizon) + 1);
+	for (int year = 0; year <= horizon; year++) {
+		mPresentValue.push_back(1.0 / std::pow(mGrowth, year));
+	}
+	for (int year = 0; year < horizon; year++) {
+		mAnnuity += mPresentValue[static_cast<size_t>(year)];
 	}
+}
 
-	double npv = 0;
-	for (int year = 0; year < horizon; ++year) {
-		double df = std::pow(1.0f + discount_factor, year);
-		// we subtract as we have framed everything as a cost rather than a value
-		npv -= costs[year] / df;
+double DiscountTable::componentCost(const ComponentView& comp) const {
+	if (!(comp.lifetime > 0.0f)) {
+		throw std::runtime_error(std::format("A component must have a positive lifetime, not {}", comp.lifetime));
 	}
 
-	valueMetrics.net_present_value = static_cast<float>(npv);
+	const double horizon = mHorizon;
+	const double lifetime = comp.lifetime;
 
-	return valueMetrics;
-}
\ No newline at end of file
+	// a new component is installed in year zero
+	double cost = comp.incumbent ? 0.0 : comp.capex;
+
+	// If a user has provided an age greater than the lifetime of this component,
+	// then presume we replace it in year zero.
+	const double first = std::max(comp.lifetime - comp.age, 0.0f);
+
+	// the number of replacements before the horizon
+	const double replacements = first < horizon ? std::ceil((horizon - first) / lifetime) : 0.0;
+
+	if (replacements > 0) {
+		if (first == std::floor(first) && lifetime == std::floor(lifetime)) {
+			// each replacement is in a whole year, so their present values are a geometric series
+			const double head = presentValue(static_cast<int>(first));
+			const double ratio = 1.0 / std::pow(mGrowth, lifetime);
+			const double series = ratio == 1.0
+				? replacements
+				: (1.0 - std::pow(ratio, replacements)) / (1.0 - ratio);
+			cost += comp.capex * head * series;
+		}
+		else {
+			// the replacements fall part way through years, which round down
+			for (double i = 0; i < replacements; i++) {
+				cost += comp.capex * presentValue(static_cast<int>(first + i * lifetime));
+			}
+		}
+	}
+
+	// finally subtract any residual value in the final year
+	const double residual_years = first + replacements * lifetime - horizon;
+	const double residual_capex = comp.capex * (residual_years / lifetime);
+	cost -= residual_capex * presentValue(mHorizon - 1);
+
+	return cost;
+}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <span>
 #include <vector>
 
 #include "../TaskData.hpp"
@@ -28,4 +29,47 @@ struct ValueMetrics {
 };
 
 
-ValueMetrics calculate_npv(const SiteData& siteData, const TaskConfig& config, const TaskData& scenario, const UsageData& usage);
\ No newline at end of file
+/**
+* The present value of a cost in each year of the NPV time horizon, computed once per TaskConfig
+*
+* Each component is installed (if new) in year 0, replaced every lifetime and then credited with
+* its residual value in the final year. With whole-year lifetimes the replacements are a geometric
+* series, so a component is costed in constant time.
+*/
+class DiscountTable {
+public:
+	DiscountTable(int horizon, float discount_factor);
+	explicit DiscountTable(const TaskConfig& config);
+
+	int horizon() const { return mHorizon; }
+
+	// the present value of a cost of 1 in the year (0 <= year <= horizon)
+	double presentValue(int year) const { return mPresentValue[static_cast<size_t>(year)]; }
+
+	// the present value of a cost of 1 in every year of the horizon
+	double annuity() const { return mAnnuity; }
+
+	// the present value of the capex of a component over the horizon (including any residual value)
+	double componentCost(const ComponentView& comp) const;
+
+private:
+	int mHorizon;
+	double mGrowth;
+	std::vector<double> mPresentValue;
+	double mAnnuity;
+};
+
+
+ValueMetrics calculate_npv(const SiteData& siteData, const TaskConfig& config, const TaskData& scenario, const UsageData& usage);
+
+// the NPV of a scenario whose components have already been costed by make_component_views
+ValueMetrics calculate_npv(const TaskConfig& config, std::span<const ComponentView> components, const UsageData& usage);
+ValueMetrics calculate_npv(const DiscountTable& discounts, std::span<const ComponentView> components, const UsageData& usage);
+
+// the NPV of many scenarios against the same table, writing each to results[i]
+void calculate_npv(const DiscountTable& discounts, std::span<const std::vector<ComponentView>> components,
+	std::span<const UsageData> usage, std::span<ValueMetrics> results);
+
+std::vector<ComponentView> make_component_views(const TaskData& scenario, const ComponentCosts& costs);
+// replace the views in components, reusing its capacity
+void make_component_views(const TaskData& scenario, const ComponentCosts& costs, std::vector<ComponentView>& components);
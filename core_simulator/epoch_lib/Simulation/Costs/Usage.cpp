@@ -3,7 +3,7 @@
 /**
 * internal method to sum up the usage data for both baseline and scenario data
 */
-UsageData sumUsage(const SiteData& siteData, const TaskData& taskData, const CostVectors& costVectors) {
+UsageData sumUsage(const TaskData& taskData, const SimulationTotals& totals) {
 	UsageData usage{};
 
 	const float LPG_cost_price = 0.122f; // £/kWh
@@ -28,35 +28,34 @@ UsageData sumUsage(const SiteData& siteData, const TaskData& taskData, const Cos
 		// our reporting metrics are in kg/kWh so we need to convert
 		constexpr float g_to_kg = 0.001f;
 
-		auto& tariff = siteData.import_tariffs[taskData.grid->tariff_index];
-		usage.elec_cost = costVectors.grid_import_e.dot(tariff);
+		usage.elec_cost = totals.grid_import_cost;
 
-		usage.elec_kg_CO2e = costVectors.grid_import_e.dot(siteData.grid_co2) * g_to_kg;
-		usage.export_revenue = costVectors.grid_export_e.dot(costVectors.grid_export_prices);
-		usage.export_kg_CO2e = -(costVectors.grid_export_e.dot(siteData.grid_co2)) * g_to_kg;
+		usage.elec_kg_CO2e = totals.grid_import_co2_g * g_to_kg;
+		usage.export_revenue = totals.grid_export_revenue;
+		usage.export_kg_CO2e = -(totals.grid_export_co2_g) * g_to_kg;
 	}
 
 	if (taskData.gas_heater) {
 		float gas_price = taskData.gas_heater->fixed_gas_price;
 		float CO2e = taskData.gas_heater->gas_type == GasType::NATURAL_GAS ? mains_gas_kg_C02e : LPG_kg_C02e;
 
-		usage.fuel_cost = costVectors.gas_import_h.sum() * gas_price;
-		usage.fuel_kg_CO2e = costVectors.gas_import_h.sum() * CO2e;
+		usage.fuel_cost = totals.gas_import_h * gas_price;
+		usage.fuel_kg_CO2e = totals.gas_import_h * CO2e;
 	}
 
 	if (taskData.mop) {
 		// assume the counterfactual of LP heat is gas based heat emissions
-		usage.low_priority_kg_CO2e_avoided = costVectors.actual_low_priority_load_e.sum() * mains_gas_kg_C02e;
-		usage.low_priority_revenue = costVectors.actual_low_priority_load_e.sum() * low_priority_price / boiler_efficiency;
+		usage.low_priority_kg_CO2e_avoided = totals.low_priority_load_e * mains_gas_kg_C02e;
+		usage.low_priority_revenue = totals.low_priority_load_e * low_priority_price / boiler_efficiency;
 	}
 
 	if (taskData.data_centre) {
-		usage.high_priority_revenue = costVectors.actual_data_centre_load_e.sum() * high_priority_price;
+		usage.high_priority_revenue = totals.data_centre_load_e * high_priority_price;
 	}
 
 	if (taskData.electric_vehicles) {
 		// will need to separate out EV charge tariffs later, assume all destination charging for now
-		usage.electric_vehicle_revenue = costVectors.actual_ev_load_e.sum() * EV_low_price;
+		usage.electric_vehicle_revenue = totals.ev_load_e * EV_low_price;
 	}
 
 	usage.carbon_scope_1_kg_CO2e = usage.fuel_kg_CO2e - usage.low_priority_kg_CO2e_avoided;
@@ -75,8 +74,8 @@ float calculate_meter_cost(const UsageData& usage) {
 }
 
 
-UsageData calculateBaselineUsage(const SiteData& siteData, const TaskConfig& config, const CostVectors& costVectors) {
-	auto usage = sumUsage(siteData, siteData.baseline, costVectors);
+UsageData calculateBaselineUsage(const SiteData& siteData, const TaskConfig& config, const SimulationTotals& totals) {
+	auto usage = sumUsage(siteData.baseline, totals);
 	usage.capex_breakdown = calculate_capex(siteData, siteData.baseline, config.capex_model);
 	usage.opex_breakdown = calculate_opex(siteData.baseline, config.opex_model);
 	usage.total_meter_cost = calculate_meter_cost(usage);
@@ -85,9 +84,9 @@ UsageData calculateBaselineUsage(const SiteData& siteData, const TaskConfig& con
 }
 
 
-UsageData calculateScenarioUsage(const SiteData& siteData, const TaskConfig& config, const TaskData& scenario, const CostVectors& costVectors) {
-	auto usage = sumUsage(siteData, scenario, costVectors);
-	usage.capex_breakdown = calculate_capex_with_discounts(siteData, config, scenario);
+UsageData calculateScenarioUsage(const TaskConfig& config, const TaskData& scenario, const SimulationTotals& totals, const CapexBreakdown& capex) {
+	auto usage = sumUsage(scenario, totals);
+	usage.capex_breakdown = capex;
 	usage.opex_breakdown = calculate_opex(scenario, config.opex_model);
 	usage.total_meter_cost = calculate_meter_cost(usage);
 	usage.total_operating_cost = usage.total_meter_cost + usage.opex_breakdown.sum();
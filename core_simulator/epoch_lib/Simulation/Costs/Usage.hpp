@@ -32,6 +32,7 @@ struct UsageData {
 
 };
 
-UsageData calculateBaselineUsage(const SiteData& siteData, const TaskConfig& config, const CostVectors& costVectors);
-UsageData calculateScenarioUsage(const SiteData& siteData, const TaskConfig& config, const TaskData& scenario, const CostVectors& costVectors);
+UsageData calculateBaselineUsage(const SiteData& siteData, const TaskConfig& config, const SimulationTotals& totals);
+// capex is the scenario's capex after any funding (see CostEngine)
+UsageData calculateScenarioUsage(const TaskConfig& config, const TaskData& scenario, const SimulationTotals& totals, const CapexBreakdown& capex);
 
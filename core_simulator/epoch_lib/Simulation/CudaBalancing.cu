@@ -0,0 +1,157 @@
+#include "CudaBalancing.hpp"
+
+#include <stdexcept>
+
+#include <cuda_runtime.h>
+
+namespace {
+	void check(cudaError_t status, const char* context) {
+		if (status != cudaSuccess) {
+			throw std::runtime_error(std::string(context) + ": " + cudaGetErrorString(status));
+		}
+	}
+
+	// std::min (and so Eigen's pmin), which differs from fminf for a NaN
+	__device__ inline float minOf(float a, float b) {
+		return b < a ? b : a;
+	}
+
+	/**
+	* The steps of lockstepKernel, with a thread for each lane
+	* The values are interleaved, so the threads of a warp read one row of a timestep together.
+	* This is built without contracting into fused multiply-adds (-fmad=false) and with IEEE division,
+	* so the balances are identical to the CPU's
+	*/
+	template <bool withESS, bool withEV>
+	__global__ void balanceLanes(float* elec, const float* evTarget, const CudaLaneParameters* lanes,
+		size_t laneCount, size_t timesteps) {
+		const size_t l = static_cast<size_t>(blockIdx.x) * blockDim.x + threadIdx.x;
+		if (l >= laneCount) {
+			return;
+		}
+
+		const CudaLaneParameters lane = lanes[l];
+		float soc = lane.soc;
+
+		for (size_t t = 0; t < timesteps; t++) {
+			float e = elec[t * laneCount + l];
+
+			float availDisch = 0.0f;
+			if constexpr (withESS) {
+				availDisch = minOf(lane.dischargeMax, soc);
+			}
+
+			if constexpr (withEV) {
+				// as BasicElectricVehicle::StepCalc
+				const float target = evTarget[t * laneCount + l];
+				const float available = (lane.gridImport + availDisch) - e;
+				const float flexLoad = target * lane.flexRatio;
+
+				float actual = target <= available ? target : available;
+				actual = available <= flexLoad ? flexLoad : actual;
+				actual = target <= 0.0f ? 0.0f : actual;
+				e = e + actual;
+			}
+
+			if constexpr (withESS) {
+				// as BasicESS::consume
+				const float availCharge = minOf(lane.chargeMax, (lane.capacity - soc) / (1.0f - lane.rtlRate));
+				const float discharge = minOf(e, availDisch);
+				const float charge = minOf(-e, availCharge);
+
+				if (0.0f <= e) {
+					soc = soc - discharge;
+					e = e - discharge;
+				}
+				else {
+					soc = (soc + charge) - charge * lane.rtlRate;
+					e = e + charge;
+				}
+			}
+
+			elec[t * laneCount + l] = e;
+		}
+	}
+
+	constexpr unsigned int THREADS_PER_BLOCK = 128;
+}
+
+int cudaDeviceCount() {
+	int count = 0;
+	if (cudaGetDeviceCount(&count) != cudaSuccess) {
+		return 0;
+	}
+	return count;
+}
+
+CudaBalancer::CudaBalancer(int device):
+	mDevice(device)
+{
+	if (device < 0 || device >= cudaDeviceCount()) {
+		throw std::runtime_error("There is no CUDA device " + std::to_string(device));
+	}
+	cudaDeviceProp properties{};
+	check(cudaGetDeviceProperties(&properties, device), "Failed to query the CUDA device");
+	mDeviceName = properties.name;
+}
+
+CudaBalancer::~CudaBalancer() {
+	cudaSetDevice(mDevice);
+	cudaFree(mElec);
+	cudaFree(mEvTarget);
+	cudaFree(mLanes);
+}
+
+void CudaBalancer::reserve(size_t values, size_t laneCount) {
+	if (values > mValueCapacity) {
+		cudaFree(mElec);
+		cudaFree(mEvTarget);
+		mElec = nullptr;
+		mEvTarget = nullptr;
+		mValueCapacity = 0;
+		check(cudaMalloc(&mElec, values * sizeof(float)), "Failed to allocate the CUDA balances");
+		check(cudaMalloc(&mEvTarget, values * sizeof(float)), "Failed to allocate the CUDA balances");
+		mValueCapacity = values;
+	}
+	if (laneCount > mLaneCapacity) {
+		cudaFree(mLanes);
+		mLanes = nullptr;
+		mLaneCapacity = 0;
+		check(cudaMalloc(&mLanes, laneCount * sizeof(CudaLaneParameters)), "Failed to allocate the CUDA lanes");
+		mLaneCapacity = laneCount;
+	}
+}
+
+void CudaBalancer::balance(bool withESS, bool withEV, float* elec, const float* evTarget,
+	const CudaLaneParameters* lanes, size_t laneCount, size_t timesteps) {
+	if (laneCount == 0 || timesteps == 0) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	check(cudaSetDevice(mDevice), "Failed to select the CUDA device");
+
+	const size_t values = laneCount * timesteps;
+	reserve(values, laneCount);
+
+	check(cudaMemcpy(mElec, elec, values * sizeof(float), cudaMemcpyHostToDevice), "Failed to copy the balances to the device");
+	if (withEV) {
+		check(cudaMemcpy(mEvTarget, evTarget, values * sizeof(float), cudaMemcpyHostToDevice), "Failed to copy the EV targets to the device");
+	}
+	check(cudaMemcpy(mLanes, lanes, laneCount * sizeof(CudaLaneParameters), cudaMemcpyHostToDevice), "Failed to copy the lanes to the device");
+
+	const auto blocks = static_cast<unsigned int>((laneCount + THREADS_PER_BLOCK - 1) / THREADS_PER_BLOCK);
+	if (withESS && withEV) {
+		balanceLanes<true, true><<<blocks, THREADS_PER_BLOCK>>>(mElec, mEvTarget, mLanes, laneCount, timesteps);
+	}
+	else if (withESS) {
+		balanceLanes<true, false><<<blocks, THREADS_PER_BLOCK>>>(mElec, mEvTarget, mLanes, laneCount, timesteps);
+	}
+	else if (withEV) {
+		balanceLanes<false, true><<<blocks, THREADS_PER_BLOCK>>>(mElec, mEvTarget, mLanes, laneCount, timesteps);
+	}
+	check(cudaGetLastError(), "Failed to run the CUDA balancing loop");
+
+	// (this waits for the kernel)
+	check(cudaMemcpy(elec, mElec, values * sizeof(float), cudaMemcpyDeviceToHost), "Failed to copy the balances from the device");
+}
@@ -0,0 +1,58 @@
+/*
+the host side of the CUDA balancing kernel (see CudaBalancing.cu), which is only built with -DEPOCH_CUDA=ON
+this is included by both the host compiler and nvcc, so only uses the standard library
+*/
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+#include <string>
+
+// the state of a lane's ESS and EV before the balancing loop, as lockstepKernel reads it
+struct CudaLaneParameters {
+	float gridImport;
+	float soc;
+	float capacity;
+	float chargeMax;
+	float dischargeMax;
+	float rtlRate;
+	float flexRatio;
+};
+
+/**
+* Balances lanes on one CUDA device, holding device buffers that grow to the largest wave
+* A device runs one wave at a time, so this is internally synchronised
+*/
+class CudaBalancer {
+public:
+	// Raise a runtime_error if there is no such device
+	explicit CudaBalancer(int device);
+	~CudaBalancer();
+
+	CudaBalancer(const CudaBalancer&) = delete;
+	CudaBalancer& operator=(const CudaBalancer&) = delete;
+
+	const std::string& deviceName() const { return mDeviceName; }
+
+	/**
+	* Run the balancing loop for laneCount lanes, updating elec in place
+	* elec and evTarget are interleaved (a row of laneCount values for each timestep), and evTarget is only read withEV
+	*/
+	void balance(bool withESS, bool withEV, float* elec, const float* evTarget,
+		const CudaLaneParameters* lanes, size_t laneCount, size_t timesteps);
+
+private:
+	void reserve(size_t values, size_t laneCount);
+
+	int mDevice;
+	std::string mDeviceName;
+	std::mutex mMutex;
+
+	float* mElec = nullptr;
+	float* mEvTarget = nullptr;
+	CudaLaneParameters* mLanes = nullptr;
+	size_t mValueCapacity = 0;
+	size_t mLaneCapacity = 0;
+};
+
+int cudaDeviceCount();
@@ -0,0 +1,40 @@
+#pragma once
+// the daily blocks that the per-timestep loops of the components are specialised for
+
+#include <cstddef>
+#include <type_traits>
+
+#include "SiteData.hpp"
+
+/**
+* Most sites are half-hourly or hourly, so the loops that carry state from one timestep to the next
+* have kernels for those numbers of timesteps in a day.
+* A kernel processes whole days as blocks whose size is known at compile time, which the compiler can unroll,
+* and reads the tariff statistics of each day once at the start of its block.
+* Block size 0 is the generic kernel, for any other resolution (and for a partial day at either end).
+* Every kernel computes the same timesteps in the same order, so they all have exactly the same result.
+*/
+inline constexpr size_t HALF_HOURLY_DAY_BLOCK = 48;
+inline constexpr size_t HOURLY_DAY_BLOCK = 24;
+
+// the block size of the kernels for a site: its number of timesteps in a day if that has kernels, otherwise 0
+inline size_t dayBlockSize(const SiteData& siteData) {
+	const auto perDay = siteData.timestepsPerDay();
+	if (perDay && (*perDay == HALF_HOURLY_DAY_BLOCK || *perDay == HOURLY_DAY_BLOCK)) {
+		return static_cast<size_t>(*perDay);
+	}
+	return 0;
+}
+
+// call kernel with the block size as a std::integral_constant, so that it can instantiate the matching kernel
+template <typename Kernel>
+decltype(auto) withDayBlock(size_t blockSize, Kernel&& kernel) {
+	switch (blockSize) {
+	case HALF_HOURLY_DAY_BLOCK:
+		return kernel(std::integral_constant<size_t, HALF_HOURLY_DAY_BLOCK>{});
+	case HOURLY_DAY_BLOCK:
+		return kernel(std::integral_constant<size_t, HOURLY_DAY_BLOCK>{});
+	default:
+		return kernel(std::integral_constant<size_t, 0>{});
+	}
+}
@@ -1,11 +1,19 @@
 #pragma once
 
 #include <chrono>
+#include <cstdint>
 #include <vector>
 #include <cmath>
 #include <algorithm>
+#include <numeric>
+#include <optional>
 #include "SiteData.hpp"
+#include "SlidingWindow.hpp"
 #include "TaskData.hpp"
+#include "TimestepMask.hpp"
+
+// How far ahead the lookahead ESS modes look for a cheaper (or lower carbon) timestep
+constexpr float LOOKAHEAD_HOURS = 24.0f;
 
 /**
 * This class computes a daily average and percentile for the given import tariff
@@ -17,36 +25,65 @@
 * The one deliberate omission at the moment is that we don't ensure days start a midnight
 * All of the days are groups of 24 hours starting at start_ts
 * (this means we don't have to worry about time zones)
+*
+* A tariff with a daily pattern (see SiteData::importTariffPattern) is the same every whole day,
+* so the statistics and masks of its first whole day are repeated rather than found again.
 */
 class DayTariffStats
 {
 public:
-    explicit DayTariffStats(const SiteData& siteData, size_t tariffIndex) {
-        mImportTariff = siteData.import_tariffs[tariffIndex];
+    explicit DayTariffStats(const SiteData& siteData, size_t tariffIndex) :
+        mTimestepHours(siteData.timestep_hours)
+    {
+        const SiteSeries& importTariff = siteData.import_tariffs[tariffIndex];
 
         // Determine the total number of days
         double totalHours = siteData.timesteps * siteData.timestep_hours;
-        int totalDays = static_cast<int>(std::ceil(totalHours / 24.0));
+        size_t totalDays = static_cast<size_t>(std::ceil(totalHours / 24.0));
 
-        // We store the tariffs for each day in their own std::vector
-        // then calculate the avg and percentile for each of these vectors
-        std::vector<std::vector<float>> dailyValues(totalDays);
+        mDailyAverages.resize(totalDays);
+        mDailyPercentiles.resize(totalDays);
 
-        mDayIndexForTimestep.resize(siteData.timesteps);
+        // the low price mask only depends on the tariff, so is shared by every component that uses these stats
+        mLowPrice.resize(siteData.timesteps);
+        // and so is the ESS top-up mask, which is packed as it is read in the balancing loop
+        mTopUpEligible = TimestepMask(siteData.timesteps);
 
-        for (size_t i = 0; i < siteData.timesteps; ++i) {
-            double hoursSinceStart = i * siteData.timestep_hours;
-            int dayIndex = static_cast<int>(std::floor(hoursSinceStart / 24.0));
-            dailyValues[dayIndex].push_back(mImportTariff[i]);
-            mDayIndexForTimestep[i] = dayIndex;
-        }
+        // with a daily pattern, every whole day has the same prices as the first, so only that day is examined
+        const std::optional<TariffPattern> pattern = siteData.importTariffPattern(tariffIndex);
+        const size_t period = pattern ? static_cast<size_t>(pattern->period()) : 0;
+        std::optional<size_t> patternDay;
+        size_t patternStart = 0;
 
-        mDailyAverages.resize(totalDays);
-        mDailyPercentiles.resize(totalDays);
+        // The timesteps for each day are contiguous, so we walk through the tariff one day at a time
+        // reusing a single buffer to calculate the avg and percentile
+        std::vector<float> dayValues;
+        size_t dayStart = 0;
 
-        for (int day = 0; day < totalDays; ++day) {
+        for (size_t day = 0; day < totalDays; ++day) {
 
-            auto& dayValues = dailyValues[day];
+            size_t dayEnd = dayStart;
+            while (dayEnd < siteData.timesteps && dayIndex(dayEnd) == day) {
+                ++dayEnd;
+            }
+
+            const bool wholePatternDay = pattern && dayEnd - dayStart == period && dayStart % period == 0;
+            if (wholePatternDay && patternDay) {
+                mDailyAverages[day] = mDailyAverages[*patternDay];
+                mDailyPercentiles[day] = mDailyPercentiles[*patternDay];
+                for (size_t t = dayStart; t < dayEnd; ++t) {
+                    mLowPrice[t] = mLowPrice[patternStart + t - dayStart];
+                    mTopUpEligible.set(t, mTopUpEligible.test(patternStart + t - dayStart));
+                }
+                dayStart = dayEnd;
+                continue;
+            }
+            if (wholePatternDay) {
+                patternDay = day;
+                patternStart = dayStart;
+            }
+
+            dayValues.assign(importTariff.data() + dayStart, importTariff.data() + dayEnd);
 
             // compute the average (with a double to mitigate some floating point errors)
             double sum = std::accumulate(dayValues.begin(), dayValues.end(), 0.0);
@@ -58,10 +95,24 @@ public:
             if (idx >= static_cast<int>(dayValues.size())) {
                 idx = static_cast<int>(dayValues.size()) - 1;
             }
-            // this re-orders the vector but we don't care because we no longer need it
+            // this re-orders the buffer but we don't care because we no longer need it
             std::nth_element(dayValues.begin(), dayValues.begin() + idx, dayValues.end());
             mDailyPercentiles[day] = dayValues[idx];
+
+            for (size_t t = dayStart; t < dayEnd; ++t) {
+                mLowPrice[t] = importTariff[t] <= mDailyAverages[day] && importTariff[t] <= mDailyPercentiles[day];
+                mTopUpEligible.set(t, importTariff[t] < mDailyAverages[day] && importTariff[t] <= mDailyPercentiles[day]);
+            }
+
+            dayStart = dayEnd;
         }
+
+        const size_t window = std::max<size_t>(1, static_cast<size_t>(std::lround(LOOKAHEAD_HOURS / siteData.timestep_hours)));
+        mLookaheadCheapest = lookaheadLows(importTariff, window);
+        // the grid carbon isn't a tariff, but is kept with the tariff signals so the ESS reads every mask from one place
+        mLookaheadLowCarbon = siteData.grid_co2.size() == static_cast<Eigen::Index>(siteData.timesteps)
+            ? lookaheadLows(siteData.grid_co2, window)
+            : TimestepMask(siteData.timesteps);
     }
 
     /**
@@ -69,8 +120,7 @@ public:
     */
     float getDayAverage(size_t timestep) const
     {
-        int dayIndex = mDayIndexForTimestep[timestep];
-        return mDailyAverages[dayIndex];
+        return mDailyAverages[dayIndex(timestep)];
     }
 
     /**
@@ -78,19 +128,92 @@ public:
     */
     float getDayPercentile(size_t timestep) const
     {
-        int dayIndex = mDayIndexForTimestep[timestep];
-        return mDailyPercentiles[dayIndex];
+        return mDailyPercentiles[dayIndex(timestep)];
+    }
+
+    /**
+    * Whether the tariff at the given timestep is no more than both the daily average and the daily percentile
+    * (using <= for the average means a fixed price tariff is low at every timestep)
+    */
+    bool isLowPrice(size_t timestep) const
+    {
+        return mLowPrice[timestep];
+    }
+
+    // the isLowPrice flags of the timesteps from timestep on, for a loop to read a whole day of them without a lookup each
+    const uint8_t* lowPriceFrom(size_t timestep) const
+    {
+        return mLowPrice.data() + timestep;
+    }
+
+    /**
+    * Whether a CONSUME_PLUS ESS may top up from the grid at the given timestep:
+    * the tariff is below the daily average and no more than the daily percentile
+    * (unlike isLowPrice, a fixed price tariff is never eligible)
+    */
+    bool isTopUpEligible(size_t timestep) const
+    {
+        return mTopUpEligible.test(timestep);
+    }
+
+    /**
+    * Whether the tariff at the given timestep is the lowest of the next LOOKAHEAD_HOURS, for a PRICE_LOOKAHEAD ESS
+    * (a tariff that is flat over those hours has no cheapest timestep)
+    */
+    bool isLookaheadCheapest(size_t timestep) const
+    {
+        return mLookaheadCheapest.test(timestep);
+    }
+
+    // as isLookaheadCheapest for the grid carbon intensity, for a CARBON_LOOKAHEAD ESS
+    bool isLookaheadLowCarbon(size_t timestep) const
+    {
+        return mLookaheadLowCarbon.test(timestep);
+    }
+
+    // the heap memory in bytes held by the daily statistics and masks
+    size_t ownedBytes() const
+    {
+        return sizeof(float) * (mDailyAverages.capacity() + mDailyPercentiles.capacity()) + mLowPrice.capacity()
+            + mTopUpEligible.ownedBytes() + mLookaheadCheapest.ownedBytes() + mLookaheadLowCarbon.ownedBytes();
+    }
+
+    // Maps a timestep to its corresponding day index
+    // (this is a stride calculation so we don't need to store an index per timestep)
+    size_t dayIndex(size_t timestep) const
+    {
+        double hoursSinceStart = timestep * mTimestepHours;
+        return static_cast<size_t>(std::floor(hoursSinceStart / 24.0));
+    }
+
+    // the number of days, including any partial final day
+    size_t numDays() const
+    {
+        return mDailyAverages.size();
     }
 
 private:
-    year_TS mImportTariff;
+    // the timesteps that are the minimum of the window ahead of them, where the window isn't flat
+    static TimestepMask lookaheadLows(year_TS_view series, size_t window)
+    {
+        const Eigen::VectorXf minimum = slidingWindowMin(series, window);
+        const Eigen::VectorXf maximum = slidingWindowMax(series, window);
+        TimestepMask lows(static_cast<size_t>(series.size()));
+        for (Eigen::Index t = 0; t < series.size(); ++t) {
+            lows.set(static_cast<size_t>(t), series[t] <= minimum[t] && minimum[t] < maximum[t]);
+        }
+        return lows;
+    }
 
-    // Maps each timestep to its corresponding day index
-    std::vector<int> mDayIndexForTimestep;
+    float mTimestepHours;
 
     // Computed daily statistics
     std::vector<float> mDailyAverages;
     std::vector<float> mDailyPercentiles;
+    std::vector<uint8_t> mLowPrice;
+    TimestepMask mTopUpEligible;
+    TimestepMask mLookaheadCheapest;
+    TimestepMask mLookaheadLowCarbon;
 
     // Percentile to track when prices are low (default 0.25)
     const float mPercentile = 0.25f;
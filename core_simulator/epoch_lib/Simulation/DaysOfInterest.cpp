@@ -0,0 +1,74 @@
+#include "DaysOfInterest.hpp"
+
+#include <format>
+#include <stdexcept>
+
+DaysOfInterest findDaysOfInterest(const ReportData& reportData, const DayTariffStats& days, year_TS_view importTariff) {
+	const Eigen::Index timesteps = importTariff.size();
+	if (reportData.timesteps() != 0 && reportData.timesteps() != timesteps) {
+		throw std::runtime_error(std::format("Cannot find the days of interest of {} timesteps with a tariff of {} timesteps",
+			reportData.timesteps(), timesteps));
+	}
+
+	DaysOfInterest result;
+	const size_t numDays = days.numDays();
+	result.day_starts.reserve(numDays + 1);
+	for (size_t t = 0; t < static_cast<size_t>(timesteps); t++) {
+		if (t == 0 || days.dayIndex(t) != days.dayIndex(t - 1)) {
+			result.day_starts.push_back(t);
+		}
+	}
+	result.day_starts.push_back(static_cast<size_t>(timesteps));
+
+	result.daily = Eigen::MatrixXf::Zero(static_cast<Eigen::Index>(NUM_DAYS_OF_INTEREST),
+		static_cast<Eigen::Index>(result.day_starts.size() - 1));
+
+	// the timesteps of day d of a column
+	auto day = [&](const auto& values, Eigen::Index d) {
+		const auto start = static_cast<Eigen::Index>(result.day_starts[static_cast<size_t>(d)]);
+		const auto end = static_cast<Eigen::Index>(result.day_starts[static_cast<size_t>(d) + 1]);
+		return values.segment(start, end - start);
+	};
+
+	// the daily totals of a column (which stay zero if it isn't populated)
+	auto addDaily = [&](DayOfInterest category, ReportColumn col) {
+		if (!reportData.has(col)) {
+			return;
+		}
+		const auto values = reportData.get(col);
+		auto row = result.daily.row(static_cast<Eigen::Index>(category));
+		for (Eigen::Index d = 0; d < row.size(); d++) {
+			row[d] += day(values, d).sum();
+		}
+	};
+
+	addDaily(DayOfInterest::MaxHeatShortfall, ReportColumn::Heat_shortfall);
+	addDaily(DayOfInterest::MaxSolarGeneration, ReportColumn::PVacGen);
+	addDaily(DayOfInterest::MaxHeatLoad, ReportColumn::Heatload);
+	addDaily(DayOfInterest::MaxESSThroughput, ReportColumn::ESS_charge);
+	addDaily(DayOfInterest::MaxESSThroughput, ReportColumn::ESS_discharge);
+	addDaily(DayOfInterest::MaxElectricalLoad, ReportColumn::Hotel_load);
+	addDaily(DayOfInterest::MaxElectricalShortfall, ReportColumn::Actual_import_shortfall);
+	addDaily(DayOfInterest::MaxDHWDemand, ReportColumn::DHW_demand);
+
+	if (reportData.has(ReportColumn::Grid_Import)) {
+		const auto gridImport = reportData.get(ReportColumn::Grid_Import);
+		auto row = result.daily.row(static_cast<Eigen::Index>(DayOfInterest::MaxImportCost));
+		for (Eigen::Index d = 0; d < row.size(); d++) {
+			row[d] = day(gridImport, d).dot(day(importTariff, d));
+		}
+	}
+
+	for (size_t c = 0; c < NUM_DAYS_OF_INTEREST; c++) {
+		const auto row = result.daily.row(static_cast<Eigen::Index>(c));
+		if (row.size() == 0) {
+			continue;
+		}
+		Eigen::Index best;
+		// (maxCoeff returns the first of any equal maxima)
+		if (row.maxCoeff(&best) > 0.0f) {
+			result.days[c] = static_cast<size_t>(best);
+		}
+	}
+	return result;
+}
@@ -0,0 +1,79 @@
+#pragma once
+// the days of a simulation most worth looking at, such as the day with the most heat shortfall
+
+#include <array>
+#include <cstddef>
+#include <optional>
+#include <vector>
+
+#include <Eigen/Core>
+
+#include "../Definitions.hpp"
+#include "DayTariffStats.hpp"
+
+// Each category is the day with the largest daily total of one timeseries
+enum class DayOfInterest {
+	// Heat_shortfall
+	MaxHeatShortfall,
+	// PVacGen
+	MaxSolarGeneration,
+	// Heatload
+	MaxHeatLoad,
+	// ESS_charge + ESS_discharge
+	MaxESSThroughput,
+	// Grid_Import priced at the scenario's import tariff
+	MaxImportCost,
+	// Hotel_load
+	MaxElectricalLoad,
+	// Actual_import_shortfall
+	MaxElectricalShortfall,
+	// DHW_demand
+	MaxDHWDemand,
+	COUNT
+};
+
+inline constexpr size_t NUM_DAYS_OF_INTEREST = static_cast<size_t>(DayOfInterest::COUNT);
+
+// The name of each DayOfInterest, in the same order as the enum
+inline constexpr std::array<const char*, NUM_DAYS_OF_INTEREST> DAY_OF_INTEREST_NAMES = {
+	"max_heat_shortfall",
+	"max_solar_generation",
+	"max_heat_load",
+	"max_ess_throughput",
+	"max_import_cost",
+	"max_electrical_load",
+	"max_electrical_shortfall",
+	"max_dhw_demand"
+};
+
+// the columns that the days of interest are found from
+inline constexpr ReportColumnMask DAYS_OF_INTEREST_COLUMNS = {
+	ReportColumn::Heat_shortfall,
+	ReportColumn::PVacGen,
+	ReportColumn::Heatload,
+	ReportColumn::ESS_charge,
+	ReportColumn::ESS_discharge,
+	ReportColumn::Grid_Import,
+	ReportColumn::Hotel_load,
+	ReportColumn::Actual_import_shortfall,
+	ReportColumn::DHW_demand
+};
+
+struct DaysOfInterest {
+	// the first timestep of each day and then the number of timesteps, so day d is [day_starts[d], day_starts[d + 1])
+	std::vector<size_t> day_starts;
+	// the total of each category (a row, in DayOfInterest order) on each day (a column)
+	Eigen::MatrixXf daily;
+	// the (first) day with the largest total of each category, or nullopt if no day's total is more than zero
+	// (such as the ESS throughput of a scenario without an ESS)
+	std::array<std::optional<size_t>, NUM_DAYS_OF_INTEREST> days;
+};
+
+/**
+* Find the days of interest from the timeseries of a simulation, as a single pass over each column
+*
+* Days are the groups of 24 hours of DayTariffStats, so a partial final day is a day of its own.
+* A column that isn't populated (because the scenario doesn't have the component) is taken to be zero.
+* importTariff is the tariff the scenario imports at, which must have a value for every timestep
+*/
+DaysOfInterest findDaysOfInterest(const ReportData& reportData, const DayTariffStats& days, year_TS_view importTariff);
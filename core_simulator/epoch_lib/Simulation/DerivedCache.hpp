@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <Eigen/Core>
+
+#include "SiteSeries.hpp"
+
+/**
+* The identity of a SiteSeries: the storage it views, rather than its values
+*
+* Copies of a series (and the columns that a SeriesStore interns) have the same identity.
+* The owner is held weakly, so an identity never keeps a series alive,
+* but it does keep the owner's control block, so storage that is freed and reused is never mistaken for the original.
+*/
+class SeriesIdentity {
+public:
+	explicit SeriesIdentity(const SiteSeries& series) :
+		mOwner(series.owner()), mData(series.data()), mSize(series.size()) {}
+
+	bool operator==(const SeriesIdentity& other) const {
+		return mData == other.mData && mSize == other.mSize
+			&& !mOwner.owner_before(other.mOwner) && !other.mOwner.owner_before(mOwner);
+	}
+
+	// whether the series has been freed (an empty series never is)
+	bool expired() const { return mSize > 0 && mOwner.expired(); }
+
+private:
+	std::weak_ptr<const void> mOwner;
+	const float* mData;
+	Eigen::Index mSize;
+};
+
+/**
+* Values derived from SiteData columns, shared by every Simulator whose columns have the same identity
+*
+* Key must be equality comparable and provide expired(), which is true once any of its columns has been freed.
+* The values are held weakly, so a value lives only as long as a Simulator uses it.
+* This is internally synchronised; values are made outside the lock, so a value may be made twice by a race,
+* but only the first is kept and shared.
+*/
+template <typename Key, typename Value>
+class DerivedCache {
+public:
+	template <typename Make>
+	std::shared_ptr<const Value> get(const Key& key, Make&& make) {
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			if (auto value = find(key)) {
+				return value;
+			}
+		}
+
+		auto made = std::make_shared<const Value>(make());
+
+		std::lock_guard<std::mutex> lock(mMutex);
+		if (auto value = find(key)) {
+			return value;
+		}
+		std::erase_if(mEntries, [](const Entry& entry) { return entry.key.expired() || entry.value.expired(); });
+		mEntries.push_back(Entry{ key, made });
+		return made;
+	}
+
+	// the number of values held (including any that have not yet been found to have expired)
+	size_t size() const {
+		std::lock_guard<std::mutex> lock(mMutex);
+		return mEntries.size();
+	}
+
+private:
+	struct Entry {
+		Key key;
+		std::weak_ptr<const Value> value;
+	};
+
+	std::shared_ptr<const Value> find(const Key& key) const {
+		for (const Entry& entry : mEntries) {
+			if (entry.key == key) {
+				return entry.value.lock();
+			}
+		}
+		return nullptr;
+	}
+
+	mutable std::mutex mMutex;
+	std::vector<Entry> mEntries;
+};
@@ -0,0 +1,24 @@
+#pragma once
+// a scenario simulated with many sizes of its ESS, sharing everything else
+
+#include <vector>
+
+#include "TaskData.hpp"
+
+/**
+* The size of an ESS in a sweep (see Simulator::sweepESS)
+*/
+struct ESSSize {
+	float capacity;
+	float charge_power;
+	float discharge_power;
+};
+
+// a copy of the scenario with its ESS resized (the scenario must have an ESS)
+inline TaskData withESSSize(const TaskData& base, const ESSSize& size) {
+	TaskData resized = base;
+	resized.energy_storage_system->capacity = size.capacity;
+	resized.energy_storage_system->charge_power = size.charge_power;
+	resized.energy_storage_system->discharge_power = size.discharge_power;
+	return resized;
+}
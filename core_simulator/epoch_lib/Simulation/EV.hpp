@@ -3,8 +3,10 @@
 #include <Eigen/Core>
 #include <Eigen/Dense>
 
+#include "Reductions.hpp"
 #include "TaskComponents.hpp"
 #include "SiteData.hpp"
+#include "TimeseriesPool.hpp"
 #include "../Definitions.hpp"
 
 class BasicElectricVehicle
@@ -45,10 +47,33 @@ public:
         tempSum.Elec_e[t] = tempSum.Elec_e[t] + mActualLoad_e[t];
     }
 
+    /**
+    * StepCalc for every timestep at once, when nothing carries from one timestep to the next
+    * (each timestep only reads its own energy balance, so this gives the same result as stepping through)
+    */
+    template <typename Derived>
+    void StepCalcAll(TempSum& tempSum, const Eigen::ArrayBase<Derived>& futureEnergy_e) {
+        const auto target = mTargetLoad_e.array();
+        const auto flexFloor = target * mFlexRatio;
+        const auto availableEnergy = futureEnergy_e - tempSum.Elec_e.array();
+        mActualLoad_e = (target <= 0).select(0.0f,
+            (availableEnergy <= flexFloor).select(flexFloor,
+                (availableEnergy >= target).select(target, availableEnergy))).matrix();
+        tempSum.Elec_e += mActualLoad_e;
+    }
+
     void Report(ReportData& reportData) {
         // report target load to allow calculation of revenue missed
-        reportData.EV_targetload = mTargetLoad_e;
-        reportData.EV_actualload = mActualLoad_e;
+        reportData.set(ReportColumn::EV_targetload, mTargetLoad_e);
+        reportData.set(ReportColumn::EV_actualload, mActualLoad_e);
+    }
+
+    const year_TS& getTargetLoad() const { return mTargetLoad_e; }
+
+    float getFlexRatio() const { return mFlexRatio; }
+
+    void ReportTotals(SimulationTotals& totals) const {
+        totals.ev_load_e = seriesTotal(mActualLoad_e);
     }
 
 private:
@@ -56,6 +81,6 @@ private:
     const float mFlexRatio;
     float mAvailableEnergy_e;
 
-    year_TS mTargetLoad_e;
-    year_TS mActualLoad_e;
+    PooledTS mTargetLoad_e;
+    PooledTS mActualLoad_e;
 };
\ No newline at end of file
@@ -0,0 +1,35 @@
+#include "Ensemble.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+EnsembleStatistics summariseEnsemble(std::span<const float> values) {
+	if (values.empty()) {
+		throw std::runtime_error("Cannot summarise an empty ensemble");
+	}
+	std::vector<float> sorted(values.begin(), values.end());
+	std::sort(sorted.begin(), sorted.end());
+
+	// the same (linear) interpolation as numpy's default percentile
+	auto percentile = [&sorted](double p) {
+		const double position = p * static_cast<double>(sorted.size() - 1);
+		const size_t lower = static_cast<size_t>(std::floor(position));
+		const size_t upper = std::min(lower + 1, sorted.size() - 1);
+		const double fraction = position - static_cast<double>(lower);
+		return static_cast<float>(sorted[lower] + fraction * (static_cast<double>(sorted[upper]) - sorted[lower]));
+	};
+
+	// (with a double to mitigate some floating point errors)
+	const double sum = std::accumulate(sorted.begin(), sorted.end(), 0.0);
+	return EnsembleStatistics{
+		static_cast<float>(sum / static_cast<double>(sorted.size())),
+		sorted.front(),
+		sorted.back(),
+		percentile(0.1),
+		percentile(0.5),
+		percentile(0.9)
+	};
+}
@@ -0,0 +1,36 @@
+#pragma once
+// the distribution of a scenario's objectives over the members of a SiteEnsemble
+
+#include <array>
+#include <span>
+
+#include <Eigen/Core>
+
+#include "Sensitivity.hpp"
+
+// The spread of one objective over the members of an ensemble
+struct EnsembleStatistics {
+	float mean;
+	float min;
+	float max;
+	// percentiles, linearly interpolated between the members
+	float p10;
+	float p50;
+	float p90;
+};
+
+struct EnsembleResult {
+	// the objectives of every member, with a row per objective (in OBJECTIVE_FIELD_NAMES order) and a column per member
+	Eigen::MatrixXf objectives;
+	// the spread of each objective (in OBJECTIVE_FIELD_NAMES order)
+	std::array<EnsembleStatistics, NUM_OBJECTIVE_FIELDS> statistics;
+	// the number of members simulated, which is fewer than the columns if the ensemble was stopped by a BatchControl
+	// the objectives of the other members are NaN, and the statistics are those of the simulated members (or NaN if there are none)
+	size_t simulated_members = 0;
+};
+
+/**
+* Summarise the values of one objective over the members of an ensemble
+* There must be at least one value
+*/
+EnsembleStatistics summariseEnsemble(std::span<const float> values);
@@ -0,0 +1,77 @@
+#include "ExecutionPlan.hpp"
+
+#include "Flags.hpp"
+
+uint32_t ExecutionPlan::shapeKey(const TaskData& taskData) {
+	const Flags flags(taskData);
+	uint32_t key = 0;
+	key |= static_cast<uint32_t>(taskData.building.has_value()) << 0;
+	key |= static_cast<uint32_t>(!taskData.solar_panels.empty()) << 1;
+	key |= static_cast<uint32_t>(flags.getEVFlag()) << 2;
+	key |= static_cast<uint32_t>(flags.getDataCentreFlag()) << 4;
+	key |= static_cast<uint32_t>(taskData.domestic_hot_water.has_value()) << 6;
+	key |= static_cast<uint32_t>(taskData.gas_heater.has_value()) << 7;
+	if (taskData.heat_pump) {
+		key |= (1u + static_cast<uint32_t>(taskData.heat_pump->heat_source)) << 8;
+	}
+	if (taskData.energy_storage_system) {
+		key |= (1u + static_cast<uint32_t>(taskData.energy_storage_system->battery_mode)) << 10;
+	}
+	return key;
+}
+
+ExecutionPlan ExecutionPlan::build(const TaskData& taskData) {
+	const Flags flags(taskData);
+	ExecutionPlan plan{};
+
+	// the hot water cylinder is heated by the heatpump, so the instant water heater can be deferred
+	const bool heatPumpCanSupplyDHW = taskData.domestic_hot_water && taskData.heat_pump;
+
+	plan.hotel = taskData.building.has_value();
+	plan.pv = !taskData.solar_panels.empty();
+	plan.fixedEV = flags.getEVFlag() == EVFlag::NON_BALANCING;
+	plan.hotWaterCylinder = heatPumpCanSupplyDHW;
+	// If there's no gas heater, we assume a resistive heating component to meet DHW
+	// We can only run this before the balancing loop if there's no heatpump, otherwise it is deferred
+	plan.instantWaterHeater = !taskData.gas_heater && !heatPumpCanSupplyDHW;
+
+	plan.ess = taskData.energy_storage_system.has_value();
+	plan.ev = taskData.electric_vehicles.has_value();
+
+	// a data centre with a hotroom heatpump, or a basic data centre beside (or without) an ambient heatpump
+	const bool hotroom = taskData.heat_pump && taskData.heat_pump->heat_source == HeatSource::HOTROOM;
+	if (taskData.data_centre) {
+		plan.dataCentre = hotroom ? DataCentreKind::WITH_ASHP : DataCentreKind::BASIC;
+	}
+	plan.ambientHeatPump = taskData.heat_pump && !(taskData.data_centre && hotroom);
+	plan.fixedDataCentre = flags.getDataCentreFlag() == DataCentreFlag::NON_BALANCING;
+
+	const bool evBalancing = flags.getEVFlag() == EVFlag::BALANCING;
+	BalancingDataCentre balancingDataCentre = BalancingDataCentre::NONE;
+	if (flags.getDataCentreFlag() == DataCentreFlag::BALANCING) {
+		balancingDataCentre = plan.dataCentre == DataCentreKind::WITH_ASHP ? BalancingDataCentre::WITH_ASHP : BalancingDataCentre::BASIC;
+	}
+	const std::optional<BatteryMode> essMode = taskData.energy_storage_system
+		? std::optional<BatteryMode>(taskData.energy_storage_system->battery_mode) : std::nullopt;
+	plan.balancingLoop = selectBalancingLoop(essMode, evBalancing, balancingDataCentre);
+	plan.consumeOnly = essMode == BatteryMode::CONSUME && !evBalancing && balancingDataCentre == BalancingDataCentre::NONE;
+
+	plan.gasHeater = taskData.gas_heater.has_value();
+	plan.deferredWaterHeater = !taskData.gas_heater && heatPumpCanSupplyDHW;
+	return plan;
+}
+
+const ExecutionPlan& ExecutionPlanCache::get(const TaskData& taskData) {
+	const uint32_t key = ExecutionPlan::shapeKey(taskData);
+	std::lock_guard<std::mutex> lock(mMutex);
+	auto& plan = mPlans[key];
+	if (!plan) {
+		plan = std::make_unique<const ExecutionPlan>(ExecutionPlan::build(taskData));
+	}
+	return *plan;
+}
+
+size_t ExecutionPlanCache::size() const {
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mPlans.size();
+}
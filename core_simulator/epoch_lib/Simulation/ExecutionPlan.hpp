@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "BalancingLoop.hpp"
+#include "TaskData.hpp"
+
+/**
+* What simulateTimesteps runs for one shape of scenario, in the order that it runs them
+*
+* The shape is which components are present, the ESS mode, whether the EV and data centre balance,
+* and the source of the heatpump. Scenarios of the same shape (such as the points of a sweep over component sizes)
+* run the same components in the same order through the same balancing loop kernel,
+* so the plan is built once per shape (see ExecutionPlanCache) rather than re-derived for each scenario.
+*/
+struct ExecutionPlan {
+	enum class DataCentreKind : uint8_t { NONE, BASIC, WITH_ASHP };
+
+	// Before the balancing loop (skipped when the state before the loop is known), in this order
+	bool hotel = false;
+	bool pv = false;
+	bool fixedEV = false;
+	bool hotWaterCylinder = false;
+	// the instant water heater runs here unless it is deferred until after the balancing loop
+	bool instantWaterHeater = false;
+
+	// The components that may be in the balancing loop
+	bool ess = false;
+	bool ev = false;
+	DataCentreKind dataCentre = DataCentreKind::NONE;
+	// the ambient heatpump runs after the components are constructed, still before the balancing loop
+	bool ambientHeatPump = false;
+	// a data centre that doesn't balance runs at its target load once the state before the loop is known
+	bool fixedDataCentre = false;
+
+	// The kernel of the balancing loop for the components that balance, or null if nothing balances
+	BalancingLoopFn balancingLoop = nullptr;
+	// the balancing loop only steps a CONSUME ESS, so can be stepped in parallel (see runConsumeScan)
+	bool consumeOnly = false;
+
+	// After the balancing loop
+	bool gasHeater = false;
+	// the instant water heater, when the heatpump could supply the hot water
+	bool deferredWaterHeater = false;
+
+	// the key that scenarios of the same shape share
+	static uint32_t shapeKey(const TaskData& taskData);
+
+	static ExecutionPlan build(const TaskData& taskData);
+};
+
+/**
+* The ExecutionPlan of each shape of scenario simulated so far
+* This is internally synchronised; a plan is never freed or moved once built, so references to it stay valid
+*/
+class ExecutionPlanCache {
+public:
+	const ExecutionPlan& get(const TaskData& taskData);
+
+	// the number of plans built
+	size_t size() const;
+
+private:
+	mutable std::mutex mMutex;
+	std::unordered_map<uint32_t, std::unique_ptr<const ExecutionPlan>> mPlans;
+};
@@ -0,0 +1,92 @@
+#include "Fabric.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+Eigen::VectorXf FabricHeatDelta::expand() const {
+	Eigen::VectorXf demand = base * scale;
+	for (size_t i = 0; i < index.size(); i++) {
+		demand[index[i]] = value[i];
+	}
+	return demand;
+}
+
+void FabricHeatDelta::accumulate(Eigen::VectorXf& target, float scalar) const {
+	// the scaled base is multiplied by the scalar in the same order as a dense demand would be, so the sums match it exactly
+	auto addRun = [&](Eigen::Index start, Eigen::Index n) {
+		if (n <= 0) {
+			return;
+		}
+		if (scalar == 1.0f) {
+			target.segment(start, n) += base.segment(start, n) * scale;
+		}
+		else {
+			target.segment(start, n) += base.segment(start, n) * scale * scalar;
+		}
+	};
+
+	Eigen::Index start = 0;
+	for (size_t i = 0; i < index.size(); i++) {
+		const Eigen::Index t = index[i];
+		addRun(start, t - start);
+		target[t] += scalar == 1.0f ? value[i] : value[i] * scalar;
+		start = t + 1;
+	}
+	addRun(start, base.size() - start);
+}
+
+std::optional<FabricHeatDelta> FabricHeatDelta::fit(const SiteSeries& base, const Eigen::Ref<const Eigen::VectorXf>& reduced, size_t maxOverrides) {
+	if (base.size() != reduced.size()) {
+		return std::nullopt;
+	}
+
+	// the typical ratio of the demands is the scale, give or take the rounding of each ratio
+	std::vector<float> ratios;
+	ratios.reserve(static_cast<size_t>(reduced.size()));
+	for (Eigen::Index t = 0; t < reduced.size(); t++) {
+		if (base[t] != 0.0f) {
+			ratios.push_back(reduced[t] / base[t]);
+		}
+	}
+	float median = 1.0f;
+	if (!ratios.empty()) {
+		auto mid = ratios.begin() + static_cast<std::ptrdiff_t>(ratios.size() / 2);
+		std::nth_element(ratios.begin(), mid, ratios.end());
+		median = *mid;
+	}
+
+	auto overrides = [&](float scale) {
+		size_t count = 0;
+		for (Eigen::Index t = 0; t < reduced.size(); t++) {
+			count += base[t] * scale != reduced[t];
+		}
+		return count;
+	};
+
+	// so also try the floats either side of the median
+	float best = median;
+	size_t fewest = overrides(median);
+	for (float candidate : { std::nextafter(median, -INFINITY), std::nextafter(median, INFINITY) }) {
+		const size_t count = overrides(candidate);
+		if (count < fewest) {
+			best = candidate;
+			fewest = count;
+		}
+	}
+	if (fewest > maxOverrides) {
+		return std::nullopt;
+	}
+
+	FabricHeatDelta delta;
+	delta.base = base;
+	delta.scale = best;
+	delta.index.reserve(fewest);
+	delta.value.reserve(fewest);
+	for (Eigen::Index t = 0; t < reduced.size(); t++) {
+		if (base[t] * best != reduced[t]) {
+			delta.index.push_back(static_cast<uint32_t>(t));
+			delta.value.push_back(reduced[t]);
+		}
+	}
+	return delta;
+}
@@ -1,16 +1,52 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <optional>
 #include <vector>
 
 #include <Eigen/Core>
 
+#include "SiteSeries.hpp"
+
 struct FabricCostBreakdown {
 	std::string name;
 	std::optional<float> area;
 	float cost;
 };
 
+/**
+* A heating demand held as a scaled copy of a base demand, with the timesteps that differ from it stored sparsely
+*
+* Every timestep t that isn't overridden has the demand scale * base[t] (a single precision product),
+* so a delta fitted to a dense demand reproduces it exactly.
+*/
+struct FabricHeatDelta {
+	// the demand this is relative to (the SiteData's building_hload, bound when the SiteData is constructed)
+	SiteSeries base;
+	float scale = 1.0f;
+	// the timesteps (in ascending order) whose demand isn't scale * base, and their demand
+	std::vector<uint32_t> index;
+	std::vector<float> value;
+
+	// the demand as a dense timeseries
+	Eigen::VectorXf expand() const;
+
+	// target += demand * scalar, a run of the scaled base at a time between the overrides
+	void accumulate(Eigen::VectorXf& target, float scalar) const;
+
+	// the heap memory in bytes held by the overrides (the base is shared with the SiteData)
+	size_t ownedBytes() const {
+		return sizeof(uint32_t) * index.capacity() + sizeof(float) * value.capacity();
+	}
+
+	/**
+	* The delta that reproduces reduced exactly with no more than maxOverrides overrides
+	* Returns nullopt if reduced is too far from a scaled copy of base.
+	*/
+	static std::optional<FabricHeatDelta> fit(const SiteSeries& base, const Eigen::Ref<const Eigen::VectorXf>& reduced, size_t maxOverrides);
+};
+
 struct FabricIntervention {
 	// the cost in pounds of this fabric intervention
 	float cost;
@@ -23,5 +59,14 @@ struct FabricIntervention {
 	float peak_hload;
 
 	// The (reduced) heating demand in kWh/timestep
-	Eigen::VectorXf reduced_hload;
+	// (empty when the demand is held as hload_delta instead)
+	SiteSeries reduced_hload;
+
+	// The (reduced) heating demand as a delta against building_hload, in place of reduced_hload
+	std::optional<FabricHeatDelta> hload_delta;
+
+	// the heating demand as a dense timeseries (reconstructed when it is held as a delta)
+	SiteSeries heatLoad() const {
+		return hload_delta ? SiteSeries(hload_delta->expand()) : reduced_hload;
+	}
 };
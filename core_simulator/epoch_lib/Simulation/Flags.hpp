@@ -33,19 +33,19 @@ public:
 		}
 	}
 
-	EVFlag getEVFlag() {
+	EVFlag getEVFlag() const {
 		return mEVConfiguration;
 	}
 
-	DataCentreFlag getDataCentreFlag() {
+	DataCentreFlag getDataCentreFlag() const {
 		return mDataCentreConfiguration;
 	}
 
-	bool dataCentrePresent() {
+	bool dataCentrePresent() const {
 		return mDataCentreConfiguration == DataCentreFlag::BALANCING || mDataCentreConfiguration == DataCentreFlag::NON_BALANCING;
 	}
 
-	bool EVPresent() {
+	bool EVPresent() const {
 		return mEVConfiguration == EVFlag::BALANCING || mEVConfiguration == EVFlag::NON_BALANCING;
 	}
 
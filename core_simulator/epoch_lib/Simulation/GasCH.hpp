@@ -4,7 +4,9 @@
 #include <Eigen/Dense>
 
 #include "../Definitions.hpp"
+#include "Reductions.hpp"
 #include "SiteData.hpp"
+#include "TimeseriesPool.hpp"
 
 class GasCombustionHeater
 {
@@ -18,22 +20,22 @@ public:
 
 	void AllCalcs(TempSum& tempSum) {
 
-		year_TS heaterCapacity = Eigen::VectorXf::Constant(mTimesteps, mMaxOutput);
+		PooledTS heaterCapacity(static_cast<Eigen::Index>(mTimesteps), mMaxOutput);
 
 		// First try to meet the remaining DHW heating demand
-		year_TS gasForDHW_h = tempSum.DHW_load_h.cwiseMax(0.0f).cwiseMin(heaterCapacity);
+		PooledTS gasForDHW_h = tempSum.DHW_load_h.cwiseMax(0.0f).cwiseMin(heaterCapacity);
 		heaterCapacity -= gasForDHW_h;
 		tempSum.DHW_load_h -= gasForDHW_h;
 		mGasCH_h = gasForDHW_h;
 
 		// Then try to meet the remaining building heating demand
-		year_TS gasForBuilding_h = tempSum.Heat_h.cwiseMax(0.0f).cwiseMin(heaterCapacity);
+		PooledTS gasForBuilding_h = tempSum.Heat_h.cwiseMax(0.0f).cwiseMin(heaterCapacity);
 		heaterCapacity -= gasForBuilding_h;
 		tempSum.Heat_h -= gasForBuilding_h;
 		mGasCH_h += gasForBuilding_h;
 
 		// Finally try to meet the remaing pool heat
-		year_TS gasForPool_h = tempSum.Pool_h.cwiseMax(0.0f).cwiseMin(heaterCapacity);
+		PooledTS gasForPool_h = tempSum.Pool_h.cwiseMax(0.0f).cwiseMin(heaterCapacity);
 		heaterCapacity -= gasForPool_h;
 		tempSum.Pool_h -= gasForPool_h;
 		mGasCH_h += gasForPool_h;
@@ -42,13 +44,28 @@ public:
 		mGasCH_h /= mEfficiency;
 	}
 
+	/**
+	* The gas that AllCalcs would burn for the heat balances of tempSum, without changing them
+	*/
+	static double gasBurnt(const SiteData& siteData, const GasCHData& gasData, const TempSum& tempSum) {
+		const float maxOutput = gasData.maximum_output * siteData.timestep_hours;
+		const auto forDHW = tempSum.DHW_load_h.array().max(0.0f).min(maxOutput);
+		const auto forBuilding = tempSum.Heat_h.array().max(0.0f).min(maxOutput - forDHW);
+		const auto forPool = tempSum.Pool_h.array().max(0.0f).min(maxOutput - forDHW - forBuilding);
+		return (forDHW + forBuilding + forPool).cast<double>().sum() / gasData.boiler_efficiency;
+	}
+
 	void Report(ReportData& reportData) {
-		reportData.GasCH_load = mGasCH_h;
+		reportData.set(ReportColumn::GasCH_load, mGasCH_h);
+	}
+
+	void ReportTotals(SimulationTotals& totals) const {
+		totals.gas_import_h = seriesTotal(mGasCH_h);
 	}
 
 private:
 	const size_t mTimesteps;
 	float mMaxOutput;
 	float mEfficiency;
-	year_TS mGasCH_h;
+	PooledTS mGasCH_h;
 };
\ No newline at end of file
@@ -13,9 +13,10 @@
 class AmbientHeatPumpController
 {
 public:
-    AmbientHeatPumpController(const SiteData& siteData, const HeatPumpData& hp, bool suppliesDHW) :
+    // The DHW and CH both use the FIXED_SEND_TEMP_VAL, so share one profile
+    AmbientHeatPumpController(const SiteData& siteData, const HeatPumpData& hp, bool suppliesDHW, const HeatPumpProfile& profile) :
         // Initialise Persistent Values
-        mHeatPump(siteData, hp, suppliesDHW)
+        mHeatPump(siteData, hp, suppliesDHW, profile, profile)
     {}
 
     void AllCalcs(TempSum& tempSum) {
@@ -34,10 +35,10 @@ public:
     }
 
     void Report(ReportData& reportData) const {
-        reportData.ASHP_elec_load = mHeatPump.mDHWload_e + mHeatPump.mCHload_e;
-        reportData.ASHP_DHW_output = mHeatPump.mDHWout_h;
-        reportData.ASHP_CH_output = mHeatPump.mCHout_h;
-        reportData.ASHP_free_heat = mHeatPump.mFreeHeat_h;
+        reportData.set(ReportColumn::ASHP_elec_load, mHeatPump.mDHWload_e + mHeatPump.mCHload_e);
+        reportData.set(ReportColumn::ASHP_DHW_output, mHeatPump.mDHWout_h);
+        reportData.set(ReportColumn::ASHP_CH_output, mHeatPump.mCHout_h);
+        reportData.set(ReportColumn::ASHP_free_heat, mHeatPump.mFreeHeat_h);
     }
 
 private:
@@ -3,54 +3,139 @@
 #include <Eigen/Core>
 #include <Eigen/Dense>
 
+#include "Reductions.hpp"
 #include "TaskComponents.hpp"
 #include "SiteData.hpp"
 #include "../Definitions.hpp"
 
+/**
+* The building's electrical, heat and hot water demands
+*
+* The demands are views of the SiteData columns, scaled lazily as they are applied,
+* so a Hotel never allocates timeseries of its own (but to report a heating demand held as a FabricHeatDelta).
+*/
 class Hotel {
 
 public:
     Hotel(const SiteData& siteData, const Building& buildingData) :
         mTimesteps(siteData.timesteps),	// Used in init & functions
-        // Initilaise data vectors with all values to zero
-        mTargetLoad_e(siteData.building_eload * buildingData.scalar_electrical_load),
+        mTargetLoad_e(siteData.building_eload),
+        mScalarLoad_e(buildingData.scalar_electrical_load),
+        mTargetHeat_h(heatLoadFor(siteData, buildingData)),
+        mHeatDelta(heatDeltaFor(siteData, buildingData)),
+        mScalarHeat_h(buildingData.scalar_heat_load),
+        // the DHW demand is not scaled so we can refer to the SiteData directly
         mTargetDHW_h(siteData.dhw_demand)
 
         //TargetPool_h(Eigen::VectorXf::Zero(BattData.TS_max))
-    {
-        if (buildingData.fabric_intervention_index == 0) {
-            mTargetHeat_h = siteData.building_hload * buildingData.scalar_heat_load;
-        }
-        else {
-            // we subtract 1 as fabric_intervention_index effectively uses 1-based indexing
-            // because 0 corresponds to the default building_hload
-            auto& scenarioIntervention = siteData.fabric_interventions[buildingData.fabric_intervention_index - 1];
-            mTargetHeat_h = scenarioIntervention.reduced_hload * buildingData.scalar_heat_load;
-        }
-    }
+    {}
 
     void AllCalcs(TempSum& tempSum) {
         // Apply demands generated by the hotel to the tempSum values
-        tempSum.Heat_h += mTargetHeat_h;
+        if (mHeatDelta) {
+            mHeatDelta->accumulate(tempSum.Heat_h, mScalarHeat_h);
+        }
+        else {
+            accumulate(tempSum.Heat_h, mTargetHeat_h, mScalarHeat_h);
+        }
         tempSum.DHW_load_h += mTargetDHW_h;
 
-        tempSum.Elec_e += mTargetLoad_e;
+        accumulate(tempSum.Elec_e, mTargetLoad_e, mScalarLoad_e);
     }
 
 
     void Report(ReportData& reportData) {
         // report target load to allow calculation of revenue missed
-        reportData.Hotel_load = mTargetLoad_e;
-        reportData.CH_demand = mTargetHeat_h;
-        reportData.DHW_demand = mTargetDHW_h;
-        reportData.Heatload = mTargetHeat_h + mTargetDHW_h;
+        // (each column is written straight from the SiteData, without an intermediate copy)
+        report(reportData, ReportColumn::Hotel_load, mTargetLoad_e, mScalarLoad_e);
+        if (mHeatDelta) {
+            reportHeat(reportData, mHeatDelta->expand());
+        }
+        else {
+            reportHeat(reportData, mTargetHeat_h);
+        }
+        reportData.set(ReportColumn::DHW_demand, mTargetDHW_h);
+    }
+
+    void ReportTotals(SimulationTotals& totals) const {
+        // summing the scaled expression (rather than scaling the sum) matches summing a scaled copy exactly
+        if (mHeatDelta) {
+            totals.ch_demand_h = deltaTotal();
+        }
+        else {
+            totals.ch_demand_h = mScalarHeat_h == 1.0f ? seriesTotal(mTargetHeat_h) : seriesTotal(mTargetHeat_h * mScalarHeat_h);
+        }
+        totals.dhw_demand_h = seriesTotal(mTargetDHW_h);
     }
 
 private:
+    static const SiteSeries& heatLoadFor(const SiteData& siteData, const Building& buildingData) {
+        if (buildingData.fabric_intervention_index == 0) {
+            return siteData.building_hload;
+        }
+        // we subtract 1 as fabric_intervention_index effectively uses 1-based indexing
+        // because 0 corresponds to the default building_hload
+        const FabricIntervention& intervention = siteData.fabric_interventions[buildingData.fabric_intervention_index - 1];
+        // a delta is applied as its scaled base
+        return intervention.hload_delta ? intervention.hload_delta->base : intervention.reduced_hload;
+    }
+
+    static const FabricHeatDelta* heatDeltaFor(const SiteData& siteData, const Building& buildingData) {
+        if (buildingData.fabric_intervention_index == 0) {
+            return nullptr;
+        }
+        const auto& delta = siteData.fabric_interventions[buildingData.fabric_intervention_index - 1].hload_delta;
+        return delta ? &*delta : nullptr;
+    }
+
+    void reportHeat(ReportData& reportData, const year_TS_view& heat) const {
+        report(reportData, ReportColumn::CH_demand, heat, mScalarHeat_h);
+        if (mScalarHeat_h == 1.0f) {
+            reportData.set(ReportColumn::Heatload, heat + mTargetDHW_h);
+        }
+        else {
+            reportData.set(ReportColumn::Heatload, heat * mScalarHeat_h + mTargetDHW_h);
+        }
+    }
+
+    // the total of the scaled base, corrected at each of the delta's overrides
+    float deltaTotal() const {
+        const FabricHeatDelta& delta = *mHeatDelta;
+        float total = seriesTotal(mTargetHeat_h * delta.scale * mScalarHeat_h);
+        for (size_t i = 0; i < delta.index.size(); i++) {
+            const float scaled = mTargetHeat_h[delta.index[i]] * delta.scale * mScalarHeat_h;
+            total += delta.value[i] * mScalarHeat_h - scaled;
+        }
+        return total;
+    }
+
+    // target += demand * scalar in a single pass, skipping the multiply for an unscaled demand
+    static void accumulate(year_TS& target, const year_TS_view& demand, float scalar) {
+        if (scalar == 1.0f) {
+            target += demand;
+        }
+        else {
+            target += demand * scalar;
+        }
+    }
+
+    static void report(ReportData& reportData, ReportColumn col, const year_TS_view& demand, float scalar) {
+        if (scalar == 1.0f) {
+            reportData.set(col, demand);
+        }
+        else {
+            reportData.set(col, demand * scalar);
+        }
+    }
+
     const size_t mTimesteps;
 
-    year_TS mTargetLoad_e;
-    year_TS mTargetDHW_h;
-    year_TS mTargetHeat_h;
+    const year_TS_view mTargetLoad_e;
+    const float mScalarLoad_e;
+    const year_TS_view mTargetHeat_h;
+    // the fabric intervention's demand as a delta against mTargetHeat_h (or nullptr if the demand is dense)
+    const FabricHeatDelta* mHeatDelta;
+    const float mScalarHeat_h;
+    const year_TS_view mTargetDHW_h;
     //year_TS TargetPool_h;
-};
\ No newline at end of file
+};
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+* A vector that holds up to N values inline, only allocating once it holds more than that
+*
+* The values are on the heap only while there are more than N of them, so a small InlineVector is constructed,
+* copied and compared without allocating. The values are contiguous either way (so it converts to a std::span),
+* and any operation that changes the size invalidates the iterators.
+*/
+template <typename T, size_t N>
+class InlineVector {
+	static_assert(std::is_trivially_copyable_v<T>, "The values of an InlineVector are copied as they move between the buffer and the heap");
+
+public:
+	using value_type = T;
+	using size_type = size_t;
+	using difference_type = std::ptrdiff_t;
+	using reference = T&;
+	using const_reference = const T&;
+	using pointer = T*;
+	using const_pointer = const T*;
+	using iterator = T*;
+	using const_iterator = const T*;
+
+	static constexpr size_t inline_capacity = N;
+
+	InlineVector() = default;
+
+	InlineVector(std::initializer_list<T> values) {
+		assign(values.begin(), values.end());
+	}
+
+	// (implicit, so that a list of values from json or python can be assigned directly)
+	InlineVector(const std::vector<T>& values) {
+		assign(values.begin(), values.end());
+	}
+
+	template <std::input_iterator It>
+	InlineVector(It first, It last) {
+		assign(first, last);
+	}
+
+	template <std::input_iterator It>
+	void assign(It first, It last) {
+		clear();
+		for (; first != last; ++first) {
+			push_back(*first);
+		}
+	}
+
+	T* data() { return onHeap() ? mHeap.data() : mInline.data(); }
+	const T* data() const { return onHeap() ? mHeap.data() : mInline.data(); }
+
+	size_t size() const { return mSize; }
+	bool empty() const { return mSize == 0; }
+	size_t capacity() const { return onHeap() ? mHeap.capacity() : N; }
+
+	// whether the values have spilled onto the heap
+	bool onHeap() const { return mSize > N; }
+	// the bytes held on the heap, for accounting the memory of a cache
+	size_t heapBytes() const { return mHeap.capacity() * sizeof(T); }
+
+	iterator begin() { return data(); }
+	iterator end() { return data() + mSize; }
+	const_iterator begin() const { return data(); }
+	const_iterator end() const { return data() + mSize; }
+
+	T& operator[](size_t i) { return data()[i]; }
+	const T& operator[](size_t i) const { return data()[i]; }
+	T& front() { return data()[0]; }
+	const T& front() const { return data()[0]; }
+	T& back() { return data()[mSize - 1]; }
+	const T& back() const { return data()[mSize - 1]; }
+
+	void reserve(size_t n) {
+		if (n > N) {
+			mHeap.reserve(n);
+		}
+	}
+
+	void resize(size_t n) {
+		resize(n, T{});
+	}
+
+	void resize(size_t n, const T& value) {
+		if (n <= N) {
+			if (onHeap()) {
+				std::copy_n(mHeap.begin(), n, mInline.begin());
+				mHeap.clear();
+			}
+			else if (n > mSize) {
+				std::fill(mInline.begin() + mSize, mInline.begin() + n, value);
+			}
+		}
+		else {
+			if (!onHeap()) {
+				mHeap.assign(mInline.begin(), mInline.begin() + mSize);
+			}
+			mHeap.resize(n, value);
+		}
+		mSize = n;
+	}
+
+	void push_back(const T& value) {
+		// (value may be one of our own, so copy it before the values move)
+		const T copy = value;
+		resize(mSize + 1);
+		back() = copy;
+	}
+
+	template <typename... Args>
+	T& emplace_back(Args&&... args) {
+		push_back(T{ std::forward<Args>(args)... });
+		return back();
+	}
+
+	void pop_back() {
+		resize(mSize - 1);
+	}
+
+	iterator erase(const_iterator first, const_iterator last) {
+		const auto index = first - begin();
+		const auto count = last - first;
+		std::copy(begin() + index + count, end(), begin() + index);
+		resize(mSize - static_cast<size_t>(count));
+		return begin() + index;
+	}
+
+	iterator erase(const_iterator position) {
+		return erase(position, position + 1);
+	}
+
+	void clear() {
+		mSize = 0;
+		mHeap.clear();
+	}
+
+	bool operator==(const InlineVector& other) const {
+		return std::equal(begin(), end(), other.begin(), other.end());
+	}
+
+private:
+	std::array<T, N> mInline{};
+	std::vector<T> mHeap;
+	size_t mSize = 0;
+};
@@ -0,0 +1,211 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <span>
+#include <stdexcept>
+
+#include <Eigen/Core>
+
+#include "TempSum.hpp"
+#include "EV.hpp"
+#include "Components/ESS/ESS.hpp"
+
+/**
+* The lock-step balancing loop steps several scenarios of the same site through each timestep together.
+*
+* Each scenario is a lane. The energy balances of the lanes are interleaved (one row per timestep)
+* and the state of each lane's ESS is held in SIMD registers, so every step is the same branch-free
+* (masked) arithmetic across all of the lanes.
+*
+* Only a CONSUME ESS and a balancing EV are supported. The energy balances are identical to those of
+* runBalancingLoop, but the components themselves are not updated (so they have no history to report).
+*/
+
+// More lanes hide more of the latency of each step, but every lane holds a scenario's timeseries
+// between preparing and finishing it, so too many push the shared SiteData out of the cache.
+// Wider SIMD (AVX-512) needs at least one whole packet
+constexpr size_t LOCKSTEP_LANES = std::max<size_t>(8, static_cast<size_t>(Eigen::internal::packet_traits<float>::size));
+
+struct LockstepLane {
+	TempSum* tempSum;
+	float availableGridImport;
+	// either may be null, but every lane in a call must have the same components
+	const BasicESS* ess;
+	const BasicElectricVehicle* ev;
+};
+
+namespace lockstep {
+	// Eigen's SIMD packet for the target architecture (a single float when vectorisation is disabled)
+	using Packet = Eigen::internal::packet_traits<float>::type;
+	constexpr size_t PACKET_SIZE = static_cast<size_t>(Eigen::internal::packet_traits<float>::size);
+	constexpr size_t PACKETS = LOCKSTEP_LANES / PACKET_SIZE;
+	static_assert(LOCKSTEP_LANES % PACKET_SIZE == 0, "The lanes must fill a whole number of packets");
+
+	// The timeseries are interleaved a block of timesteps at a time, so that the block stays in the L1 cache
+	constexpr Eigen::Index BLOCK = 128;
+	// one row per timestep, one column per lane
+	using LaneBlock = Eigen::Matrix<float, BLOCK, static_cast<Eigen::Index>(LOCKSTEP_LANES), Eigen::RowMajor>;
+	using LaneValues = std::array<float, LOCKSTEP_LANES>;
+
+	inline void load(const float* lanes, Packet (&packets)[PACKETS]) {
+		for (size_t p = 0; p < PACKETS; p++) {
+			packets[p] = Eigen::internal::ploadu<Packet>(lanes + p * PACKET_SIZE);
+		}
+	}
+
+	inline void store(float* lanes, const Packet (&packets)[PACKETS]) {
+		for (size_t p = 0; p < PACKETS; p++) {
+			Eigen::internal::pstoreu(lanes + p * PACKET_SIZE, packets[p]);
+		}
+	}
+}
+
+template <bool withESS, bool withEV>
+void lockstepKernel(std::span<const LockstepLane> lanes, size_t timesteps) {
+	using namespace Eigen::internal;
+	using lockstep::Packet;
+	using lockstep::PACKETS;
+	using lockstep::BLOCK;
+
+	// the unused lanes are left at zero, which keeps them at zero
+	lockstep::LaneBlock elec = lockstep::LaneBlock::Zero();
+	lockstep::LaneBlock evTarget = lockstep::LaneBlock::Zero();
+	lockstep::LaneValues gridImport{}, soc{}, capacity{}, chargeMax{}, dischargeMax{}, rtlRate{}, flexRatio{};
+
+	for (size_t l = 0; l < lanes.size(); l++) {
+		gridImport[l] = lanes[l].availableGridImport;
+
+		if constexpr (withESS) {
+			const Battery& battery = lanes[l].ess->getBattery();
+			soc[l] = battery.GetSoC();
+			capacity[l] = battery.GetCapacity_e();
+			chargeMax[l] = battery.getChargeMax_e();
+			dischargeMax[l] = battery.getDischargeMax_e();
+			rtlRate[l] = battery.getRTLrate();
+		}
+		if constexpr (withEV) {
+			flexRatio[l] = lanes[l].ev->getFlexRatio();
+		}
+	}
+
+	Packet gridImportP[PACKETS], socP[PACKETS], capacityP[PACKETS], chargeMaxP[PACKETS], dischargeMaxP[PACKETS],
+		rtlRateP[PACKETS], flexRatioP[PACKETS];
+	lockstep::load(gridImport.data(), gridImportP);
+	lockstep::load(soc.data(), socP);
+	lockstep::load(capacity.data(), capacityP);
+	lockstep::load(chargeMax.data(), chargeMaxP);
+	lockstep::load(dischargeMax.data(), dischargeMaxP);
+	lockstep::load(rtlRate.data(), rtlRateP);
+	lockstep::load(flexRatio.data(), flexRatioP);
+
+	const Packet zero = pset1<Packet>(0.0f);
+	const Packet one = pset1<Packet>(1.0f);
+
+	const auto rows = static_cast<Eigen::Index>(timesteps);
+	for (Eigen::Index start = 0; start < rows; start += BLOCK) {
+		const Eigen::Index count = std::min(BLOCK, rows - start);
+
+		for (size_t l = 0; l < lanes.size(); l++) {
+			const auto col = static_cast<Eigen::Index>(l);
+			elec.col(col).head(count) = lanes[l].tempSum->Elec_e.segment(start, count);
+			if constexpr (withEV) {
+				evTarget.col(col).head(count) = lanes[l].ev->getTargetLoad().segment(start, count);
+			}
+		}
+
+		// Each step evaluates both sides of every condition and selects the result per lane with a mask.
+		// Eigen's pmin has the same argument order as std::min, so the steps are identical to the scalar StepCalcs
+		for (Eigen::Index t = 0; t < count; t++) {
+			Packet e[PACKETS];
+			lockstep::load(elec.row(t).data(), e);
+			[[maybe_unused]] Packet target[PACKETS];
+			if constexpr (withEV) {
+				lockstep::load(evTarget.row(t).data(), target);
+			}
+
+			for (size_t p = 0; p < PACKETS; p++) {
+				Packet availDisch = zero;
+				if constexpr (withESS) {
+					availDisch = pmin(dischargeMaxP[p], socP[p]);
+				}
+
+				if constexpr (withEV) {
+					// as BasicElectricVehicle::StepCalc
+					const Packet available = psub(padd(gridImportP[p], availDisch), e[p]);
+					const Packet flexLoad = pmul(target[p], flexRatioP[p]);
+
+					Packet actual = pselect(pcmp_le(target[p], available), target[p], available);
+					actual = pselect(pcmp_le(available, flexLoad), flexLoad, actual);
+					actual = pselect(pcmp_le(target[p], zero), zero, actual);
+					e[p] = padd(e[p], actual);
+				}
+
+				if constexpr (withESS) {
+					// as BasicESS::consume
+					const Packet availCharge = pmin(chargeMaxP[p], pdiv(psub(capacityP[p], socP[p]), psub(one, rtlRateP[p])));
+					const Packet discharge = pmin(e[p], availDisch);
+					const Packet charge = pmin(pnegate(e[p]), availCharge);
+					const Packet demand = pcmp_le(zero, e[p]);
+
+					const Packet socCharged = psub(padd(socP[p], charge), pmul(charge, rtlRateP[p]));
+					socP[p] = pselect(demand, psub(socP[p], discharge), socCharged);
+					e[p] = pselect(demand, psub(e[p], discharge), padd(e[p], charge));
+				}
+			}
+
+			lockstep::store(elec.row(t).data(), e);
+		}
+
+		for (size_t l = 0; l < lanes.size(); l++) {
+			lanes[l].tempSum->Elec_e.segment(start, count) = elec.col(static_cast<Eigen::Index>(l)).head(count);
+		}
+	}
+}
+
+/**
+* Check that every lane has the same components, with any ESS in CONSUME mode
+* Raise a runtime_error if not
+*/
+inline void checkLockstepLanes(std::span<const LockstepLane> lanes) {
+	if (lanes.empty()) {
+		return;
+	}
+	const bool withESS = lanes.front().ess != nullptr;
+	const bool withEV = lanes.front().ev != nullptr;
+	for (const auto& lane : lanes) {
+		if ((lane.ess != nullptr) != withESS || (lane.ev != nullptr) != withEV) {
+			throw std::runtime_error("Every scenario in the lock-step balancing loop must have the same components");
+		}
+		if (lane.ess && lane.ess->getMode() != BatteryMode::CONSUME) {
+			throw std::runtime_error("The lock-step balancing loop only supports a CONSUME ESS");
+		}
+	}
+}
+
+/**
+* Run the balancing loop for up to LOCKSTEP_LANES scenarios at once
+* Every lane must have the same components, with any ESS in CONSUME mode
+*/
+inline void runLockstepBalancingLoop(std::span<const LockstepLane> lanes, size_t timesteps) {
+	if (lanes.empty()) {
+		return;
+	}
+	if (lanes.size() > LOCKSTEP_LANES) {
+		throw std::runtime_error("Too many scenarios for the lock-step balancing loop");
+	}
+	checkLockstepLanes(lanes);
+
+	const bool withESS = lanes.front().ess != nullptr;
+	const bool withEV = lanes.front().ev != nullptr;
+	if (withESS && withEV) {
+		lockstepKernel<true, true>(lanes, timesteps);
+	}
+	else if (withESS) {
+		lockstepKernel<true, false>(lanes, timesteps);
+	}
+	else if (withEV) {
+		lockstepKernel<false, true>(lanes, timesteps);
+	}
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+/**
+* An estimate of the heap memory held by an object, broken down into named parts
+*
+* These are estimates for sizing workers, not exact allocations: the containers' own overheads are approximated
+* and anything (such as a mapped SiteData file) that is shared between processes is not counted.
+*/
+struct MemoryFootprint {
+	struct Part {
+		std::string name;
+		size_t bytes;
+	};
+
+	std::vector<Part> parts;
+
+	void add(std::string name, size_t bytes) {
+		parts.push_back({ std::move(name), bytes });
+	}
+
+	// add each part of another footprint, with prefix in front of its name
+	void add(const std::string& prefix, const MemoryFootprint& other) {
+		for (const Part& part : other.parts) {
+			parts.push_back({ prefix + part.name, part.bytes });
+		}
+	}
+
+	size_t total() const {
+		size_t bytes = 0;
+		for (const Part& part : parts) {
+			bytes += part.bytes;
+		}
+		return bytes;
+	}
+};
+
+/**
+* The storage that has already been counted towards a footprint
+* Objects that are shared (between the members of an ensemble, or the Simulators of a site at different resolutions)
+* are then only counted once.
+*/
+class MemorySeen {
+public:
+	// true the first time that the storage at address is seen (null storage is never counted)
+	bool first(const void* address) {
+		return address != nullptr && mSeen.insert(address).second;
+	}
+
+private:
+	std::unordered_set<const void*> mSeen;
+};
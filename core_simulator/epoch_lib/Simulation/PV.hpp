@@ -1,8 +1,11 @@
 #pragma once
 
+#include <span>
+
 #include <Eigen/Core>
 #include <Eigen/Dense>
 
+#include "Reductions.hpp"
 #include "TaskComponents.hpp"
 #include "TempSum.hpp"
 #include "../Definitions.hpp"
@@ -10,39 +13,43 @@
 class BasicPV
 {
 public:
-    BasicPV(const SiteData& siteData, const std::vector<SolarData>& solar_panels) :
+    BasicPV(const SiteData& siteData, std::span<const SolarData> solar_panels) :
         mTimesteps(siteData.timesteps),
+        mPVdcGen_e(static_cast<Eigen::Index>(siteData.timesteps))
         // FUTURE Set PVrect export limit (for clipping)
-
-        mPVdcGen_e(Eigen::VectorXf::Zero(mTimesteps)),
-        mPVacGen_e(Eigen::VectorXf::Zero(mTimesteps))
     {
+        // the panels as a (mostly zero) scalar per solar yield, so the generation of every array is one matrix-vector product
+        PooledTS scalars(static_cast<Eigen::Index>(siteData.solar_yields.size()));
         for (const SolarData& solar : solar_panels) {
-            mPVdcGen_e += siteData.solar_yields[solar.yield_index] * solar.yield_scalar;
+            scalars[static_cast<Eigen::Index>(solar.yield_index)] += solar.yield_scalar;
         }
+        mPVdcGen_e.noalias() = siteData.solar_yields.matrix() * scalars;
     }
 
     void AllCalcs(TempSum& tempSum) {
         // FUTURE: Apply oversizing
-        mPVacGen_e = mPVdcGen_e;
+        // until then the AC generation is the DC generation
 
         // Subtract PV generation from the electrical demand
-        tempSum.Elec_e -= mPVacGen_e;
+        tempSum.Elec_e -= mPVdcGen_e;
     }
 
-    year_TS get_PV_AC_out() const {
-        return mPVacGen_e;
+    const year_TS& get_PV_AC_out() const {
+        return mPVdcGen_e;
     }
 
     void Report(ReportData& reportData) {
         // report target load to allow calculation of revenue missed
-        reportData.PVdcGen = mPVdcGen_e;
-        reportData.PVacGen = mPVacGen_e;
+        reportData.set(ReportColumn::PVdcGen, mPVdcGen_e);
+        reportData.set(ReportColumn::PVacGen, mPVdcGen_e);
+    }
+
+    void ReportTotals(SimulationTotals& totals) const {
+        totals.pv_generation_e = seriesTotal(mPVdcGen_e);
     }
 
 private:
     const size_t mTimesteps;
 
-    year_TS mPVdcGen_e;
-    year_TS mPVacGen_e;
-};
\ No newline at end of file
+    PooledTS mPVdcGen_e;
+};
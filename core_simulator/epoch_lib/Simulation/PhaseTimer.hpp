@@ -0,0 +1,45 @@
+#pragma once
+
+#include <chrono>
+
+#include "../Definitions.hpp"
+
+#ifdef EPOCH_PHASE_TIMING
+constexpr bool PHASE_TIMING_ENABLED = true;
+#else
+constexpr bool PHASE_TIMING_ENABLED = false;
+#endif
+
+/**
+* Adds the time between construction and destruction to one of the fields of a PhaseTimings
+*
+* This does nothing when no PhaseTimings is provided,
+* and compiles away entirely when EPOCH_PHASE_TIMING is not defined
+*/
+class ScopedPhaseTimer {
+public:
+	ScopedPhaseTimer(PhaseTimings* timings, float PhaseTimings::* phase) {
+		if constexpr (PHASE_TIMING_ENABLED) {
+			if (timings) {
+				mPhase = &(timings->*phase);
+				mStart = std::chrono::steady_clock::now();
+			}
+		}
+	}
+
+	~ScopedPhaseTimer() {
+		if constexpr (PHASE_TIMING_ENABLED) {
+			if (mPhase) {
+				std::chrono::duration<float> elapsed = std::chrono::steady_clock::now() - mStart;
+				*mPhase += elapsed.count();
+			}
+		}
+	}
+
+	ScopedPhaseTimer(const ScopedPhaseTimer&) = delete;
+	ScopedPhaseTimer& operator=(const ScopedPhaseTimer&) = delete;
+
+private:
+	float* mPhase = nullptr;
+	std::chrono::steady_clock::time_point mStart;
+};
@@ -0,0 +1,306 @@
+#pragma once
+
+#include <algorithm>
+
+#include <Eigen/Core>
+#include <Eigen/Dense>
+
+#include "Reductions.hpp"
+#include "SiteData.hpp"
+#include "TariffPricing.hpp"
+#include "TaskData.hpp"
+#include "TempSum.hpp"
+#include "../Definitions.hpp"
+
+/**
+* How far the balancing loop can move the balances before it, for the bounds taken from the state before the loop
+* The balancing components only add load, other than the ESS, which can discharge at most maxDischarge in a timestep,
+* and the heatpump of a data centre, which may meet any of the hot water
+*/
+struct LoopSlack {
+	float maxDischarge = 0.0f;
+	bool hotWaterMet = false;
+};
+
+/**
+* The components after the balancing loop that only act on the electricity balance
+* (the Mop, a deferred instant water heater and the Grid), together with the electricity and heat totals of TempSum
+*
+* These are made in a single pass over the timesteps: each block is carried through every stage while it is in L1 cache,
+* so the only timeseries written are the final balances (and the report columns, when reporting).
+* The gas combustion heater only acts on the heat balances, so it must run before this pass.
+*/
+class PostBalancing
+{
+public:
+	// deferredWaterHeater: the instant water heater was deferred until after the balancing loop
+	PostBalancing(const SiteData& siteData, const TaskData& taskData, bool deferredWaterHeater) :
+		mMop(taskData.mop.has_value()),
+		mDeferredWaterHeater(deferredWaterHeater),
+		mGrid(taskData.grid.has_value() && taskData.building.has_value()),
+		mGridCO2(siteData.grid_co2)
+	{
+		if (mMop) {
+			mMOPmax_e = taskData.mop->maximum_load * siteData.timestep_hours;
+		}
+		if (mGrid) {
+			const GridData& grid = taskData.grid.value();
+			// Calculate the Import and Export capacity (in kWh) per timestep
+			mImpMax_e = importCapacity(siteData, grid);
+			mExpMax_e = grid.grid_export * siteData.timestep_hours;
+			mExportPrice = grid.export_tariff;
+			mImportTariff = &siteData.import_tariffs[grid.tariff_index];
+		}
+	}
+
+	// The grid import capacity (in kWh) per timestep, which is reduced by the import_headroom
+	static float importCapacity(const SiteData& siteData, const GridData& grid) {
+		return grid.grid_import * (1.0f - grid.import_headroom) * siteData.timestep_hours;
+	}
+
+	/**
+	* Apply each stage to the electricity balance and accumulate the totals
+	* With reportData, the timeseries of each stage are also reported.
+	* With tariffCosts, the grid import is also priced against every tariff of the site (see TariffPricing).
+	* The totals are accumulated with the Accumulation policy A (the build's policy by default).
+	*/
+	template <Accumulation A = ACCUMULATION>
+	void AllCalcs(TempSum& tempSum, SimulationTotals& totals, ReportData* reportData,
+		const TariffPricing& tariffs, Eigen::VectorXf* tariffCosts) const {
+		const Eigen::Index timesteps = tempSum.Elec_e.size();
+
+		if (reportData) {
+			reportData->reserve(timesteps);
+		}
+		auto reports = [reportData](ReportColumn column) { return reportData && reportData->wants(column); };
+		const bool reportMop = reports(ReportColumn::MOP_load);
+		const bool reportResistive = reports(ReportColumn::DHW_resistive_load);
+		const bool reportImport = reports(ReportColumn::Grid_Import);
+		const bool reportExport = reports(ReportColumn::Grid_Export);
+		const bool reportShortfall = reports(ReportColumn::Actual_import_shortfall);
+		const bool reportCurtailed = reports(ReportColumn::Actual_curtailed_export);
+		TariffPricing::Sums tariffSums;
+		if (tariffCosts) {
+			tariffSums = tariffs.start();
+		}
+
+		Accumulator<A> mopLoad;
+		Accumulator<A> importE, importCost, importCO2, exportE, exportCO2;
+		Accumulator<A> importShortfall, curtailedExport, heatShortfall, dhwShortfall, chShortfall;
+
+		// the stages of a block are kept on the stack, rather than as timeseries
+		Block mop, imp, exp;
+
+		forEachBlock(timesteps, [&](Eigen::Index start, Eigen::Index n) {
+			auto elec = tempSum.Elec_e.segment(start, n);
+			auto dhw = tempSum.DHW_load_h.segment(start, n);
+			const auto ch = tempSum.Heat_h.segment(start, n);
+
+			if (mMop) {
+				// flip the Elec balance then clamp between 0 and MOPmax to capture surplus generation
+				mop.head(n) = (-1.0f * elec).cwiseMax(0.0f).cwiseMin(mMOPmax_e);
+				elec += mop.head(n);
+				mopLoad.add(mop.head(n));
+				if (reportMop) {
+					reportData->column(ReportColumn::MOP_load).segment(start, n) = mop.head(n);
+				}
+			}
+
+			if (mDeferredWaterHeater) {
+				// meet the remaining DHW with resistive heating
+				if (reportResistive) {
+					reportData->column(ReportColumn::DHW_resistive_load).segment(start, n) = dhw;
+				}
+				elec += dhw;
+				dhw.setZero();
+			}
+
+			if (mGrid) {
+				// clamp the grid import between 0 and Import Max at each timestep
+				imp.head(n) = elec.cwiseMax(0.0f).cwiseMin(mImpMax_e);
+				// flip the Elec balance then clamp between 0 and Export Max at each timestep
+				exp.head(n) = (-1.0f * elec).cwiseMax(0.0f).cwiseMin(mExpMax_e);
+				// Write the new electricity balance to tempSum: Load/Export is +ve & Gen/Import is -ve
+				elec = elec + exp.head(n) - imp.head(n);
+
+				const auto co2 = mGridCO2.segment(start, n);
+				importE.add(imp.head(n));
+				importCost.addDot(imp.head(n), mImportTariff->segment(start, n));
+				importCO2.addDot(imp.head(n), co2);
+				exportE.add(exp.head(n));
+				exportCO2.addDot(exp.head(n), co2);
+
+				if (tariffCosts) {
+					tariffs.add(tariffSums, start, imp.head(n));
+				}
+				if (reportImport) {
+					reportData->column(ReportColumn::Grid_Import).segment(start, n) = imp.head(n);
+				}
+				if (reportExport) {
+					reportData->column(ReportColumn::Grid_Export).segment(start, n) = exp.head(n);
+				}
+			}
+
+			// Any remaining imbalance is a grid import breach (capacity shortfall) or export breach (not curtailed)
+			importShortfall.add(elec.cwiseMax(0.0f));
+			curtailedExport.add(elec.cwiseMin(0.0f));
+			chShortfall.add(ch);
+			dhwShortfall.add(dhw);
+			heatShortfall.add(ch + dhw + tempSum.Pool_h.segment(start, n));
+
+			if (reportShortfall) {
+				reportData->column(ReportColumn::Actual_import_shortfall).segment(start, n) = elec.cwiseMax(0.0f);
+			}
+			if (reportCurtailed) {
+				reportData->column(ReportColumn::Actual_curtailed_export).segment(start, n) = (-1.0f * elec).cwiseMax(0.0f);
+			}
+		});
+
+		if (tariffCosts) {
+			tariffs.costs(tariffSums, *tariffCosts);
+		}
+
+		if (mMop) {
+			totals.low_priority_load_e = mopLoad.value();
+		}
+
+		if (mGrid) {
+			totals.grid_import_e = importE.value();
+			totals.grid_import_cost = importCost.value();
+			totals.grid_import_co2_g = importCO2.value();
+
+			totals.grid_export_e = exportE.value();
+			// the export price is fixed for every timestep
+			totals.grid_export_revenue = exportE.value() * mExportPrice;
+			totals.grid_export_co2_g = exportCO2.value();
+		}
+
+		totals.import_shortfall_e = importShortfall.value();
+		totals.curtailed_export_e = -curtailedExport.value();
+		totals.heat_shortfall_h = heatShortfall.value();
+		totals.dhw_shortfall_h = dhwShortfall.value();
+		totals.ch_shortfall_h = chShortfall.value();
+	}
+
+	/**
+	* The import shortfall of the timesteps [start, start + n) once they have been balanced, as AllCalcs accumulates it,
+	* without changing tempSum
+	* Every timestep's shortfall is non-negative, so this is a lower bound on the shortfall over every timestep.
+	*
+	* With a slack, this is instead a lower bound from the balances before the balancing loop
+	* (every stage here is monotonic, so applying them to the least balance gives the least shortfall)
+	*/
+	double importShortfall(const TempSum& tempSum, Eigen::Index start, Eigen::Index n, const LoopSlack& slack = {}) const {
+		double shortfall = 0.0;
+		forEachLeastBalance(tempSum, start, n, slack, [&](Eigen::Index, auto& e, const auto&) {
+			if (mGrid) {
+				// whatever is over the import capacity (exporting never leaves a shortfall)
+				e.array() -= mImpMax_e;
+			}
+			shortfall += static_cast<double>(e.cwiseMax(0.0f).sum());
+		});
+		return shortfall;
+	}
+
+	/**
+	* Optimistic totals of the Mop and the grid from the balances before the balancing loop (see Simulator::boundObjectives):
+	* the least grid import (and its cost and carbon) and the most export (with its revenue and carbon) and Mop load
+	* A timestep with a negative tariff or carbon intensity instead takes the most it could import (the import capacity)
+	* or the least it could export (nothing). The totals are accumulated in double, and the other totals are unchanged.
+	*/
+	void optimisticTotals(const TempSum& tempSum, const LoopSlack& slack, SimulationTotals& totals) const {
+		double mopLoad = 0.0;
+		double importE = 0.0, importCost = 0.0, importCO2 = 0.0, exportE = 0.0, exportCO2 = 0.0;
+		Block imp, exp;
+
+		forEachLeastBalance(tempSum, 0, tempSum.Elec_e.size(), slack, [&](Eigen::Index start, const auto& e, const auto& mop) {
+			const Eigen::Index n = e.size();
+			mopLoad += static_cast<double>(mop.sum());
+			if (mGrid) {
+				imp.head(n) = e.cwiseMax(0.0f).cwiseMin(mImpMax_e);
+				exp.head(n) = (-1.0f * e).cwiseMax(0.0f).cwiseMin(mExpMax_e);
+				const auto tariff = mImportTariff->segment(start, n).array();
+				const auto co2 = mGridCO2.segment(start, n).array();
+
+				importE += static_cast<double>(imp.head(n).sum());
+				importCost += static_cast<double>((tariff < 0.0f).select(tariff * mImpMax_e, tariff * imp.head(n).array()).sum());
+				importCO2 += static_cast<double>((co2 < 0.0f).select(co2 * mImpMax_e, co2 * imp.head(n).array()).sum());
+				exportE += static_cast<double>(exp.head(n).sum());
+				exportCO2 += static_cast<double>((co2.max(0.0f) * exp.head(n).array()).sum());
+			}
+		});
+
+		if (mMop) {
+			totals.low_priority_load_e = static_cast<float>(mopLoad);
+		}
+		if (mGrid) {
+			totals.grid_import_e = static_cast<float>(importE);
+			totals.grid_import_cost = static_cast<float>(importCost);
+			totals.grid_import_co2_g = static_cast<float>(importCO2);
+			totals.grid_export_e = static_cast<float>(exportE);
+			totals.grid_export_revenue = static_cast<float>(exportE * std::max(0.0f, mExportPrice));
+			totals.grid_export_co2_g = static_cast<float>(exportCO2);
+		}
+	}
+
+	/**
+	* The heat shortfall, as AllCalcs accumulates it, when nothing after the balancing loop other than
+	* the deferred water heater meets any heat (so there is no gas heater)
+	*/
+	double heatShortfall(const TempSum& tempSum) const {
+		double shortfall = static_cast<double>(tempSum.Heat_h.sum()) + static_cast<double>(tempSum.Pool_h.sum());
+		if (!mDeferredWaterHeater) {
+			shortfall += static_cast<double>(tempSum.DHW_load_h.sum());
+		}
+		return shortfall;
+	}
+
+private:
+	using Block = Eigen::Matrix<float, REDUCTION_BLOCK_SIZE, 1>;
+
+	/**
+	* Visit the least balance of each block of [start, start + n) on reaching the grid (after the Mop and a deferred water heater),
+	* along with the Mop load of the block, given the slack of the balancing loop
+	*/
+	template <typename Visit>
+	void forEachLeastBalance(const TempSum& tempSum, Eigen::Index start, Eigen::Index n, const LoopSlack& slack, Visit&& visit) const {
+		Block elec, mop;
+		for (Eigen::Index offset = 0; offset < n; offset += REDUCTION_BLOCK_SIZE) {
+			const Eigen::Index count = std::min<Eigen::Index>(REDUCTION_BLOCK_SIZE, n - offset);
+			auto e = elec.head(count);
+			auto m = mop.head(count);
+			e = (tempSum.Elec_e.segment(start + offset, count).array() - slack.maxDischarge).matrix();
+
+			if (mMop) {
+				m = (-1.0f * e).cwiseMax(0.0f).cwiseMin(mMOPmax_e);
+				e += m;
+			}
+			else {
+				m.setZero();
+			}
+			if (mDeferredWaterHeater) {
+				const auto dhw = tempSum.DHW_load_h.segment(start + offset, count);
+				if (slack.hotWaterMet) {
+					// the heatpump meets at most the hot water that is wanted
+					e += dhw.cwiseMin(0.0f);
+				}
+				else {
+					e += dhw;
+				}
+			}
+			visit(start + offset, e, m);
+		}
+	}
+
+	const bool mMop;
+	const bool mDeferredWaterHeater;
+	const bool mGrid;
+
+	float mMOPmax_e = 0.0f;
+
+	float mImpMax_e = 0.0f;
+	float mExpMax_e = 0.0f;
+	float mExportPrice = 0.0f;
+	const SiteSeries* mImportTariff = nullptr;
+	const year_TS_view mGridCO2;
+};
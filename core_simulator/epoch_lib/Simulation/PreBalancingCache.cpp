@@ -0,0 +1,114 @@
+#include "PreBalancingCache.hpp"
+
+#include <utility>
+
+PreBalancingKey::PreBalancingKey(const TaskData& taskData) :
+	building(taskData.building),
+	solar_panels(taskData.solar_panels),
+	electric_vehicles(
+		taskData.electric_vehicles && !(taskData.electric_vehicles->flexible_load_ratio > 0)
+			? taskData.electric_vehicles : std::nullopt),
+	domestic_hot_water(taskData.domestic_hot_water),
+	heat_pump(taskData.heat_pump),
+	tariff_index(taskData.domestic_hot_water && taskData.heat_pump && taskData.grid ? taskData.grid->tariff_index : 0),
+	gas_heater(taskData.gas_heater.has_value()),
+	data_centre(taskData.data_centre.has_value())
+{
+}
+
+std::size_t preBalancingHash(const TaskData& taskData) noexcept
+{
+	// (the same fields as the PreBalancingKey constructor, by reference)
+	static const std::optional<ElectricVehicles> noElectricVehicles;
+	const auto& electricVehicles = taskData.electric_vehicles && !(taskData.electric_vehicles->flexible_load_ratio > 0)
+		? taskData.electric_vehicles : noElectricVehicles;
+	const size_t tariffIndex = taskData.domestic_hot_water && taskData.heat_pump && taskData.grid ? taskData.grid->tariff_index : 0;
+	return hashPreBalancing(taskData.building, taskData.solar_panels, electricVehicles, taskData.domestic_hot_water,
+		taskData.heat_pump, tariffIndex, taskData.gas_heater.has_value(), taskData.data_centre.has_value());
+}
+
+PreBalancingCache::PreBalancingCache(size_t byteBudget) :
+	mByteBudget(byteBudget)
+{
+}
+
+std::shared_ptr<const PreBalancingSnapshot> PreBalancingCache::lookup(const PreBalancingKey& key)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	auto it = mEntries.find(key);
+	if (it == mEntries.end()) {
+		mMisses++;
+		return nullptr;
+	}
+
+	mHits++;
+	// move this entry to the front of the LRU list
+	mLru.splice(mLru.begin(), mLru, it->second.lruPosition);
+	return it->second.snapshot;
+}
+
+void PreBalancingCache::insert(const PreBalancingKey& key, std::shared_ptr<const PreBalancingSnapshot> snapshot)
+{
+	const size_t bytes = entryBytes(key, *snapshot);
+
+	if (bytes > mByteBudget) {
+		// this would evict everything else and still not fit
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	if (mEntries.contains(key)) {
+		// another thread simulated a scenario with the same key concurrently
+		return;
+	}
+
+	while (mBytes + bytes > mByteBudget && !mLru.empty()) {
+		auto evict = mEntries.find(*mLru.back());
+		mBytes -= evict->second.bytes;
+		mLru.pop_back();
+		mEntries.erase(evict);
+		mEvictions++;
+	}
+
+	auto [it, inserted] = mEntries.emplace(key, Entry{ std::move(snapshot), bytes, {} });
+	mLru.push_front(&it->first);
+	it->second.lruPosition = mLru.begin();
+	mBytes += bytes;
+}
+
+CacheStats PreBalancingCache::stats() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	CacheStats stats{};
+	stats.hits = mHits;
+	stats.misses = mMisses;
+	stats.evictions = mEvictions;
+	stats.entries = mEntries.size();
+	stats.bytes = mBytes;
+	stats.byte_budget = mByteBudget;
+	return stats;
+}
+
+void PreBalancingCache::clear()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	mLru.clear();
+	mEntries.clear();
+	mBytes = 0;
+}
+
+size_t PreBalancingCache::entryBytes(const PreBalancingKey& key, const PreBalancingSnapshot& snapshot)
+{
+	// the key and value, the map and list nodes (approximately) and the snapshot's control block
+	size_t bytes = sizeof(PreBalancingKey) + sizeof(Entry) + sizeof(PreBalancingSnapshot) + 8 * sizeof(void*);
+
+	bytes += key.solar_panels.heapBytes();
+
+	const TempSum& tempSum = snapshot.tempSum;
+	bytes += (tempSum.Elec_e.size() + tempSum.Heat_h.size() + tempSum.DHW_load_h.size()
+		+ tempSum.Pool_h.size() + tempSum.Waste_h.size()) * sizeof(float);
+	return bytes;
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "../Definitions.hpp"
+#include "CacheStats.hpp"
+#include "TaskComponents.hpp"
+#include "TaskData.hpp"
+#include "TempSum.hpp"
+
+/**
+* The parts of a TaskData that determine the energy balances before the balancing loop
+*
+* Two scenarios with the same key have identical TempSums up to the balancing loop,
+* regardless of their ESS, Grid, Mop, balancing EV or DataCentre
+*/
+struct PreBalancingKey {
+	explicit PreBalancingKey(const TaskData& taskData);
+
+	std::optional<Building> building;
+	SolarPanels solar_panels;
+	// only a non-balancing EV is run before the balancing loop
+	std::optional<ElectricVehicles> electric_vehicles;
+	std::optional<DomesticHotWater> domestic_hot_water;
+	std::optional<HeatPumpData> heat_pump;
+	// the hot water cylinder charges according to the tariff (this is 0 if there's no cylinder)
+	size_t tariff_index;
+	// these determine whether the instant water heater and ambient heatpump are run before the loop
+	bool gas_heater;
+	bool data_centre;
+
+	bool operator==(const PreBalancingKey&) const = default;
+};
+
+// the hash of a PreBalancingKey's fields
+inline std::size_t hashPreBalancing(const std::optional<Building>& building, std::span<const SolarData> solarPanels,
+	const std::optional<ElectricVehicles>& electricVehicles, const std::optional<DomesticHotWater>& domesticHotWater,
+	const std::optional<HeatPumpData>& heatPump, size_t tariffIndex, bool gasHeater, bool dataCentre) noexcept
+{
+	std::size_t h = 0;
+	hash_combine(h, building, electricVehicles, domesticHotWater, heatPump, tariffIndex, gasHeater, dataCentre,
+		vector_hasher<SolarData>{}(solarPanels));
+	return h;
+}
+
+template<>
+struct std::hash<PreBalancingKey>
+{
+	std::size_t operator()(const PreBalancingKey& key) const noexcept
+	{
+		return hashPreBalancing(key.building, key.solar_panels, key.electric_vehicles, key.domestic_hot_water,
+			key.heat_pump, key.tariff_index, key.gas_heater, key.data_centre);
+	}
+};
+
+/**
+* The hash of PreBalancingKey(taskData), without copying any of its components
+*/
+std::size_t preBalancingHash(const TaskData& taskData) noexcept;
+
+// The state of a scenario immediately before the balancing loop
+struct PreBalancingSnapshot {
+	TempSum tempSum;
+	// the totals reported by the components that have run so far
+	SimulationTotals totals;
+};
+
+/**
+* A thread-safe, memory-bounded (least-recently-used) cache of PreBalancingSnapshots
+*
+* Snapshots are shared and immutable, so a lookup only holds the lock long enough to find one
+*/
+class PreBalancingCache {
+public:
+	explicit PreBalancingCache(size_t byteBudget);
+
+	std::shared_ptr<const PreBalancingSnapshot> lookup(const PreBalancingKey& key);
+	void insert(const PreBalancingKey& key, std::shared_ptr<const PreBalancingSnapshot> snapshot);
+
+	CacheStats stats() const;
+	void clear();
+
+	size_t byteBudget() const { return mByteBudget; }
+
+private:
+	struct Entry {
+		std::shared_ptr<const PreBalancingSnapshot> snapshot;
+		size_t bytes;
+		// this entry's position in the LRU list
+		std::list<const PreBalancingKey*>::iterator lruPosition;
+	};
+
+	static size_t entryBytes(const PreBalancingKey& key, const PreBalancingSnapshot& snapshot);
+
+	const size_t mByteBudget;
+
+	mutable std::mutex mMutex;
+	// The keys of a node-based map are never moved, so the LRU list can point at them
+	std::unordered_map<PreBalancingKey, Entry> mEntries;
+	// most recently used at the front
+	std::list<const PreBalancingKey*> mLru;
+	size_t mBytes = 0;
+	uint64_t mHits = 0;
+	uint64_t mMisses = 0;
+	uint64_t mEvictions = 0;
+};
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+
+#include <Eigen/Core>
+
+/**
+* The number of timesteps reduced at a time by forEachBlock
+* A block of each of the (up to four) timeseries in a reduction fits comfortably in L1 cache
+*/
+inline constexpr Eigen::Index REDUCTION_BLOCK_SIZE = 1024;
+
+/**
+* Call fn(start, length) for consecutive blocks of [0, size)
+*
+* This lets several sums and dot products over the same timeseries be made in a single pass:
+* each block is reduced with Eigen's (vectorised) sum and dot while it is still in cache,
+* rather than streaming every timeseries from memory once per reduction.
+*/
+template <typename Fn>
+inline void forEachBlock(Eigen::Index size, Fn&& fn) {
+	for (Eigen::Index start = 0; start < size; start += REDUCTION_BLOCK_SIZE) {
+		fn(start, std::min(REDUCTION_BLOCK_SIZE, size - start));
+	}
+}
+
+/**
+* How the totals over every timestep of a scenario are accumulated
+*
+* - Single sums each block in float and adds the block sums in float
+* - Double widens each block to double before summing it, so no precision is lost to a long running total
+* - Compensated sums each block in float, then adds the block sums with Neumaier (improved Kahan) compensation
+*
+* The timeseries themselves are always float; this only changes the annual totals (and so the metrics).
+* The policy is chosen with the EPOCH_ACCUMULATION build option and defaults to Single.
+*/
+enum class Accumulation { Single, Double, Compensated };
+
+#if defined(EPOCH_ACCUMULATE_DOUBLE)
+inline constexpr Accumulation ACCUMULATION = Accumulation::Double;
+#elif defined(EPOCH_ACCUMULATE_COMPENSATED)
+inline constexpr Accumulation ACCUMULATION = Accumulation::Compensated;
+#else
+inline constexpr Accumulation ACCUMULATION = Accumulation::Single;
+#endif
+
+/**
+* A running total of block sums and dot products under an Accumulation policy
+*/
+template <Accumulation A = ACCUMULATION>
+class Accumulator {
+public:
+	template <typename Derived>
+	void add(const Eigen::MatrixBase<Derived>& block) {
+		if constexpr (A == Accumulation::Double) {
+			mTotal += block.template cast<double>().sum();
+		}
+		else {
+			addPartial(block.sum());
+		}
+	}
+
+	template <typename DerivedA, typename DerivedB>
+	void addDot(const Eigen::MatrixBase<DerivedA>& a, const Eigen::MatrixBase<DerivedB>& b) {
+		if constexpr (A == Accumulation::Double) {
+			mTotal += a.template cast<double>().dot(b.template cast<double>());
+		}
+		else {
+			addPartial(a.dot(b));
+		}
+	}
+
+	float value() const {
+		if constexpr (A == Accumulation::Compensated) {
+			return mTotal + mCompensation;
+		}
+		else {
+			return static_cast<float>(mTotal);
+		}
+	}
+
+private:
+	using Total = std::conditional_t<A == Accumulation::Double, double, float>;
+
+	void addPartial(float partial) {
+		if constexpr (A == Accumulation::Compensated) {
+			const float total = mTotal + partial;
+			// recover the low-order bits that were lost from whichever operand was smaller
+			if (std::abs(mTotal) >= std::abs(partial)) {
+				mCompensation += (mTotal - total) + partial;
+			}
+			else {
+				mCompensation += (partial - total) + mTotal;
+			}
+			mTotal = total;
+		}
+		else {
+			mTotal += partial;
+		}
+	}
+
+	Total mTotal = 0;
+	// only used by Compensated
+	float mCompensation = 0.0f;
+};
+
+/**
+* The sum of a timeseries, accumulated block by block in the same order as the reductions made with forEachBlock
+* (the totals of a simulation can then be compared exactly against its reported timeseries)
+*/
+template <Accumulation A = ACCUMULATION>
+inline float blockSum(const Eigen::Ref<const Eigen::VectorXf>& ts) {
+	Accumulator<A> total;
+	forEachBlock(ts.size(), [&](Eigen::Index start, Eigen::Index n) {
+		total.add(ts.segment(start, n));
+	});
+	return total.value();
+}
+
+/**
+* The total of a component's timeseries (or an expression of one) for its SimulationTotals
+* Single precision sums it in one vectorised pass; the other policies accumulate it block by block.
+*/
+template <Accumulation A = ACCUMULATION, typename Derived>
+inline float seriesTotal(const Eigen::MatrixBase<Derived>& ts) {
+	if constexpr (A == Accumulation::Single) {
+		return ts.sum();
+	}
+	else {
+		Accumulator<A> total;
+		forEachBlock(ts.size(), [&](Eigen::Index start, Eigen::Index n) {
+			total.add(ts.segment(start, n));
+		});
+		return total.value();
+	}
+}
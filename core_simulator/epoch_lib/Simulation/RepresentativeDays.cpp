@@ -0,0 +1,195 @@
+#include "RepresentativeDays.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <format>
+#include <limits>
+#include <stdexcept>
+
+#include <Eigen/Core>
+
+namespace {
+	// scale a timeseries so that its variation (rather than its magnitude) is compared
+	Eigen::VectorXf standardise(year_TS_view series) {
+		float mean = series.mean();
+		float stddev = std::sqrt((series.array() - mean).square().mean());
+		if (stddev <= 0.0f) {
+			return Eigen::VectorXf::Zero(series.size());
+		}
+		return (series.array() - mean) / stddev;
+	}
+
+	// one row per whole day, holding the standardised profile of every timeseries on that day
+	Eigen::MatrixXf dayFeatures(const SiteData& siteData, size_t timestepsPerDay, size_t wholeDays) {
+		std::vector<const SiteSeries*> series = {
+			&siteData.building_eload, &siteData.building_hload, &siteData.ev_eload,
+			&siteData.dhw_demand, &siteData.air_temperature, &siteData.import_tariffs.front()
+		};
+		if (!siteData.solar_yields.empty()) {
+			series.push_back(&siteData.solar_yields.front());
+		}
+
+		const auto stepsPerDay = static_cast<Eigen::Index>(timestepsPerDay);
+		Eigen::MatrixXf features(static_cast<Eigen::Index>(wholeDays), stepsPerDay * static_cast<Eigen::Index>(series.size()));
+		for (size_t s = 0; s < series.size(); s++) {
+			Eigen::VectorXf standardised = standardise(*series[s]);
+			for (Eigen::Index day = 0; day < features.rows(); day++) {
+				features.block(day, static_cast<Eigen::Index>(s) * stepsPerDay, 1, stepsPerDay) =
+					standardised.segment(day * stepsPerDay, stepsPerDay).transpose();
+			}
+		}
+		return features;
+	}
+
+	Eigen::Index nearestRow(const Eigen::MatrixXf& rows, const Eigen::RowVectorXf& point) {
+		Eigen::Index nearest = 0;
+		(rows.rowwise() - point).rowwise().squaredNorm().minCoeff(&nearest);
+		return nearest;
+	}
+}
+
+RepresentativeDays selectRepresentativeDays(const SiteData& siteData, size_t numDays) {
+	if (numDays == 0) {
+		throw std::runtime_error("There must be at least one representative day");
+	}
+
+	constexpr std::chrono::seconds DAY{ 24 * 60 * 60 };
+	if (DAY % siteData.timestep_interval_s != std::chrono::seconds{ 0 }) {
+		throw std::runtime_error(std::format("A day is not a whole number of {}s timesteps", siteData.timestep_interval_s.count()));
+	}
+	const auto timestepsPerDay = static_cast<size_t>(DAY / siteData.timestep_interval_s);
+	const size_t wholeDays = siteData.timesteps / timestepsPerDay;
+	if (wholeDays == 0) {
+		throw std::runtime_error("The SiteData must contain at least one whole day");
+	}
+
+	const Eigen::MatrixXf features = dayFeatures(siteData, timestepsPerDay, wholeDays);
+	const auto numClusters = static_cast<Eigen::Index>(std::min(numDays, wholeDays));
+
+	// seed the centres with the most typical day, then repeatedly with the day furthest from every centre
+	Eigen::MatrixXf centres(numClusters, features.cols());
+	centres.row(0) = features.row(nearestRow(features, features.colwise().mean()));
+	Eigen::VectorXf nearestDistance = (features.rowwise() - centres.row(0)).rowwise().squaredNorm();
+	for (Eigen::Index c = 1; c < numClusters; c++) {
+		Eigen::Index furthest = 0;
+		nearestDistance.maxCoeff(&furthest);
+		centres.row(c) = features.row(furthest);
+		nearestDistance = nearestDistance.cwiseMin((features.rowwise() - centres.row(c)).rowwise().squaredNorm());
+	}
+
+	// then refine them with Lloyd's algorithm
+	std::vector<Eigen::Index> cluster(wholeDays, 0);
+	for (int iteration = 0; iteration < 100; iteration++) {
+		bool changed = false;
+		for (Eigen::Index day = 0; day < features.rows(); day++) {
+			Eigen::Index nearest = nearestRow(centres, features.row(day));
+			changed = changed || nearest != cluster[static_cast<size_t>(day)];
+			cluster[static_cast<size_t>(day)] = nearest;
+		}
+		if (!changed && iteration > 0) {
+			break;
+		}
+
+		Eigen::MatrixXf sums = Eigen::MatrixXf::Zero(numClusters, features.cols());
+		Eigen::VectorXf counts = Eigen::VectorXf::Zero(numClusters);
+		for (Eigen::Index day = 0; day < features.rows(); day++) {
+			sums.row(cluster[static_cast<size_t>(day)]) += features.row(day);
+			counts[cluster[static_cast<size_t>(day)]] += 1.0f;
+		}
+		for (Eigen::Index c = 0; c < numClusters; c++) {
+			// an empty cluster keeps its centre
+			if (counts[c] > 0.0f) {
+				centres.row(c) = sums.row(c) / counts[c];
+			}
+		}
+	}
+
+	// represent each (non-empty) cluster by its member closest to the centre
+	// scaling the weights so that they cover any partial final day
+	const float partialDayScale = static_cast<float>(siteData.timesteps) / static_cast<float>(wholeDays * timestepsPerDay);
+
+	RepresentativeDays representative{ timestepsPerDay, {}, {} };
+	for (Eigen::Index c = 0; c < numClusters; c++) {
+		size_t best = wholeDays;
+		float bestDistance = std::numeric_limits<float>::max();
+		float members = 0.0f;
+		for (size_t day = 0; day < wholeDays; day++) {
+			if (cluster[day] != c) {
+				continue;
+			}
+			members += 1.0f;
+			float distance = (features.row(static_cast<Eigen::Index>(day)) - centres.row(c)).squaredNorm();
+			if (distance < bestDistance) {
+				bestDistance = distance;
+				best = day;
+			}
+		}
+		if (best < wholeDays) {
+			representative.days.push_back(best);
+			representative.weights.push_back(members * partialDayScale);
+		}
+	}
+	return representative;
+}
+
+SiteData sliceSiteData(const SiteData& siteData, size_t start, size_t count) {
+	if (count == 0 || start + count > siteData.timesteps) {
+		throw std::runtime_error(std::format("Cannot take {} timesteps from {} of a SiteData with {} timesteps",
+			count, start, siteData.timesteps));
+	}
+
+	const auto first = static_cast<Eigen::Index>(start);
+	const auto length = static_cast<Eigen::Index>(count);
+	auto slice = [&](const SiteSeries& series) -> year_TS { return series.segment(first, length); };
+
+	std::vector<SiteSeries> solarYields;
+	for (const auto& yield : siteData.solar_yields) {
+		solarYields.push_back(slice(yield));
+	}
+	std::vector<SiteSeries> importTariffs;
+	for (const auto& tariff : siteData.import_tariffs) {
+		importTariffs.push_back(slice(tariff));
+	}
+	std::vector<FabricIntervention> fabricInterventions = siteData.fabric_interventions;
+	for (auto& intervention : fabricInterventions) {
+		intervention.reduced_hload = slice(intervention.heatLoad());
+		intervention.hload_delta.reset();
+	}
+
+	auto startTs = siteData.start_ts + siteData.timestep_interval_s * static_cast<long long>(start);
+	auto endTs = startTs + siteData.timestep_interval_s * static_cast<long long>(count);
+
+	return SiteData(
+		startTs, endTs, siteData.baseline,
+		slice(siteData.building_eload), slice(siteData.building_hload), siteData.peak_hload,
+		slice(siteData.ev_eload), slice(siteData.dhw_demand), slice(siteData.air_temperature), slice(siteData.grid_co2),
+		std::move(solarYields), std::move(importTariffs), std::move(fabricInterventions),
+		siteData.ashp_input_table, siteData.ashp_output_table
+	);
+}
+
+void addWeightedTotals(SimulationTotals& into, const SimulationTotals& totals, float weight) {
+	into.gas_import_h += weight * totals.gas_import_h;
+
+	into.grid_import_e += weight * totals.grid_import_e;
+	into.grid_import_cost += weight * totals.grid_import_cost;
+	into.grid_import_co2_g += weight * totals.grid_import_co2_g;
+	into.grid_export_e += weight * totals.grid_export_e;
+	into.grid_export_revenue += weight * totals.grid_export_revenue;
+	into.grid_export_co2_g += weight * totals.grid_export_co2_g;
+
+	into.pv_generation_e += weight * totals.pv_generation_e;
+
+	into.import_shortfall_e += weight * totals.import_shortfall_e;
+	into.curtailed_export_e += weight * totals.curtailed_export_e;
+	into.heat_shortfall_h += weight * totals.heat_shortfall_h;
+	into.ch_shortfall_h += weight * totals.ch_shortfall_h;
+	into.dhw_shortfall_h += weight * totals.dhw_shortfall_h;
+
+	into.ch_demand_h += weight * totals.ch_demand_h;
+	into.dhw_demand_h += weight * totals.dhw_demand_h;
+
+	into.ev_load_e += weight * totals.ev_load_e;
+	into.data_centre_load_e += weight * totals.data_centre_load_e;
+	into.low_priority_load_e += weight * totals.low_priority_load_e;
+}
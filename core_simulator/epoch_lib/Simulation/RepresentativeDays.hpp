@@ -0,0 +1,48 @@
+#pragma once
+// reduction of a SiteData to a few weighted representative days for fast screening
+
+#include <string_view>
+#include <vector>
+
+#include "../Definitions.hpp"
+#include "SiteData.hpp"
+
+/**
+* A set of days that stand in for the whole timeseries
+*
+* Days are groups of 24 hours starting at start_ts, as in DayTariffStats.
+* The weights sum to the length of the timeseries in days, so a partial final day is
+* represented by scaling up every weight rather than by a day of its own.
+*/
+struct RepresentativeDays {
+	size_t timestepsPerDay;
+	// the index of each representative day, counting whole days from start_ts
+	std::vector<size_t> days;
+	// the number of days in the full timeseries that each one represents
+	std::vector<float> weights;
+};
+
+/**
+* Cluster the whole days of a SiteData into (at most) numDays groups and choose the day closest to the centre of each
+*
+* Each day is described by its profiles of every load, the air temperature, the first solar yield and the first tariff,
+* with every timeseries scaled by its standard deviation so that no one of them dominates.
+* This is deterministic: the same SiteData always gives the same days.
+*/
+RepresentativeDays selectRepresentativeDays(const SiteData& siteData, size_t numDays);
+
+/**
+* A SiteData holding count timesteps of siteData, starting at timestep start
+*/
+SiteData sliceSiteData(const SiteData& siteData, size_t start, size_t count);
+
+// add weight * totals to into
+void addWeightedTotals(SimulationTotals& into, const SimulationTotals& totals, float weight);
+
+// the largest error of the representative days simulation in one of the result columns
+struct RepresentativeDaysError {
+	std::string_view metric;
+	double max_absolute_error;
+	// relative to the magnitude of the full simulation's value
+	double max_relative_error;
+};
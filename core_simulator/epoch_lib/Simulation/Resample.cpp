@@ -0,0 +1,58 @@
+#include "Resample.hpp"
+
+#include <format>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <Eigen/Core>
+
+namespace {
+	// view a timeseries as a matrix with one column per combined timestep
+	Eigen::Map<const Eigen::MatrixXf> blocksOf(year_TS_view series, size_t factor) {
+		const auto rows = static_cast<Eigen::Index>(factor);
+		return { series.data(), rows, series.size() / rows };
+	}
+
+	Eigen::VectorXf sumBlocks(year_TS_view series, size_t factor) {
+		return blocksOf(series, factor).colwise().sum().transpose();
+	}
+
+	Eigen::VectorXf meanBlocks(year_TS_view series, size_t factor) {
+		return blocksOf(series, factor).colwise().mean().transpose();
+	}
+}
+
+SiteData resampleSiteData(const SiteData& siteData, size_t factor) {
+	if (factor == 0 || siteData.timesteps % factor != 0) {
+		throw std::runtime_error(std::format("Cannot combine {} timesteps in groups of {}", siteData.timesteps, factor));
+	}
+
+	std::vector<SiteSeries> solarYields;
+	solarYields.reserve(siteData.solar_yields.size());
+	for (const auto& yield : siteData.solar_yields) {
+		solarYields.push_back(sumBlocks(yield, factor));
+	}
+
+	std::vector<SiteSeries> importTariffs;
+	importTariffs.reserve(siteData.import_tariffs.size());
+	for (const auto& tariff : siteData.import_tariffs) {
+		importTariffs.push_back(meanBlocks(tariff, factor));
+	}
+
+	std::vector<FabricIntervention> fabricInterventions = siteData.fabric_interventions;
+	for (auto& intervention : fabricInterventions) {
+		// (a delta is summed as its dense demand, as the sums of an override's block aren't a scaled base)
+		intervention.reduced_hload = sumBlocks(intervention.heatLoad(), factor);
+		intervention.hload_delta.reset();
+	}
+
+	return SiteData(
+		siteData.start_ts, siteData.end_ts, siteData.baseline,
+		sumBlocks(siteData.building_eload, factor), sumBlocks(siteData.building_hload, factor), siteData.peak_hload,
+		sumBlocks(siteData.ev_eload, factor), sumBlocks(siteData.dhw_demand, factor),
+		meanBlocks(siteData.air_temperature, factor), meanBlocks(siteData.grid_co2, factor),
+		std::move(solarYields), std::move(importTariffs), std::move(fabricInterventions),
+		siteData.ashp_input_table, siteData.ashp_output_table
+	);
+}
@@ -0,0 +1,18 @@
+#pragma once
+// downsampling of a SiteData to a coarser timestep
+
+#include <cstddef>
+
+#include "SiteData.hpp"
+
+/**
+* A SiteData with every factor timesteps of siteData combined into one
+*
+* The timeseries in kWh/timestep (the loads, solar yields and fabric interventions) are summed,
+* so the energy over the whole timeseries is unchanged.
+* The others (the air temperature, grid carbon intensity and import tariffs) are averaged,
+* so a constant import costs (and emits) the same at either resolution.
+*
+* The number of timesteps must be a whole multiple of factor.
+*/
+SiteData resampleSiteData(const SiteData& siteData, size_t factor);
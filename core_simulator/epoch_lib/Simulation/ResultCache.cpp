@@ -0,0 +1,114 @@
+#include "ResultCache.hpp"
+
+#include <functional>
+#include <string>
+
+ResultCache::ResultCache(size_t byteBudget) :
+	mShardBudget(byteBudget / NUM_SHARDS)
+{
+}
+
+bool ResultCache::lookup(const TaskData& taskData, SimulationResult& result)
+{
+	const ScenarioKey key = scenarioKey(taskData);
+	Shard& shard = shardFor(key);
+	std::lock_guard<std::mutex> lock(shard.mutex);
+
+	auto it = shard.entries.find(key);
+	if (it == shard.entries.end() || !(it->second.taskData == taskData)) {
+		shard.misses++;
+		return false;
+	}
+
+	shard.hits++;
+	// move this entry to the front of the LRU list
+	shard.lru.splice(shard.lru.begin(), shard.lru, it->second.lruPosition);
+
+	const CachedResult& cached = it->second.result;
+	result.comparison = cached.comparison;
+	result.metrics = cached.metrics;
+	result.scenario_capex_breakdown = cached.capex_breakdown;
+	return true;
+}
+
+void ResultCache::insert(const TaskData& taskData, const SimulationResult& result)
+{
+	CachedResult cached{ result.comparison, result.metrics, result.scenario_capex_breakdown };
+	const size_t bytes = entryBytes(taskData, cached);
+
+	if (bytes > mShardBudget) {
+		// this would evict everything else and still not fit
+		return;
+	}
+
+	const ScenarioKey key = scenarioKey(taskData);
+	Shard& shard = shardFor(key);
+	std::lock_guard<std::mutex> lock(shard.mutex);
+
+	if (shard.entries.contains(key)) {
+		// another thread simulated the same scenario concurrently (or, far less likely, its key collides with another's)
+		return;
+	}
+
+	while (shard.bytes + bytes > mShardBudget && !shard.lru.empty()) {
+		auto evict = shard.entries.find(*shard.lru.back());
+		shard.bytes -= evict->second.bytes;
+		shard.lru.pop_back();
+		shard.entries.erase(evict);
+		shard.evictions++;
+	}
+
+	auto [it, inserted] = shard.entries.emplace(key, Entry{ taskData, std::move(cached), bytes, {} });
+	shard.lru.push_front(&it->first);
+	it->second.lruPosition = shard.lru.begin();
+	shard.bytes += bytes;
+}
+
+CacheStats ResultCache::stats() const
+{
+	CacheStats stats{};
+	stats.byte_budget = mShardBudget * NUM_SHARDS;
+
+	for (const Shard& shard : mShards) {
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		stats.hits += shard.hits;
+		stats.misses += shard.misses;
+		stats.evictions += shard.evictions;
+		stats.entries += shard.entries.size();
+		stats.bytes += shard.bytes;
+	}
+	return stats;
+}
+
+void ResultCache::clear()
+{
+	for (Shard& shard : mShards) {
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		shard.lru.clear();
+		shard.entries.clear();
+		shard.bytes = 0;
+	}
+}
+
+ResultCache::Shard& ResultCache::shardFor(const ScenarioKey& key)
+{
+	// the map buckets by the low half of the key, so take the shard from the high half
+	return mShards[key.high % NUM_SHARDS];
+}
+
+size_t ResultCache::entryBytes(const TaskData& taskData, const CachedResult& result)
+{
+	// the key and value, the map and list nodes (approximately) and anything they own on the heap
+	size_t bytes = sizeof(ScenarioKey) + sizeof(Entry) + 6 * sizeof(void*);
+
+	bytes += taskData.solar_panels.heapBytes();
+
+	bytes += result.capex_breakdown.fabric_cost_breakdown.capacity() * sizeof(FabricCostBreakdown);
+	for (const auto& breakdown : result.capex_breakdown.fabric_cost_breakdown) {
+		if (breakdown.name.capacity() > std::string{}.capacity()) {
+			// this string is too long for the small string optimisation
+			bytes += breakdown.name.capacity();
+		}
+	}
+	return bytes;
+}
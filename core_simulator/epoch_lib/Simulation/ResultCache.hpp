@@ -0,0 +1,77 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+
+#include "../Definitions.hpp"
+#include "CacheStats.hpp"
+#include "ScenarioKey.hpp"
+#include "TaskData.hpp"
+
+/**
+* A thread-safe, memory-bounded cache of scenario results
+*
+* Only the compact parts of a result are stored (the metrics, comparison and capex breakdown);
+* the baseline metrics are the same for every scenario so are provided by the Simulator.
+*
+* Entries are keyed on the ScenarioKey of the TaskData, which is found once per lookup or insert.
+* Each entry keeps its TaskData too, so that even a collision of the 128-bit keys can never return the wrong result.
+* The cache is split into shards (each with its own lock and least-recently-used eviction)
+* so that concurrent scenarios in a batch rarely contend.
+*/
+class ResultCache {
+public:
+	explicit ResultCache(size_t byteBudget);
+
+	/**
+	* Fill in the cached parts of the result for this TaskData, returning false if it is not in the cache
+	*/
+	bool lookup(const TaskData& taskData, SimulationResult& result);
+
+	void insert(const TaskData& taskData, const SimulationResult& result);
+
+	CacheStats stats() const;
+	void clear();
+
+	size_t byteBudget() const { return mShardBudget * NUM_SHARDS; }
+
+private:
+	struct CachedResult {
+		ScenarioComparison comparison;
+		SimulationMetrics metrics;
+		CapexBreakdown capex_breakdown;
+	};
+
+	struct Entry {
+		TaskData taskData;
+		CachedResult result;
+		size_t bytes;
+		// this entry's position in the shard's LRU list
+		std::list<const ScenarioKey*>::iterator lruPosition;
+	};
+
+	struct Shard {
+		mutable std::mutex mutex;
+		// The keys of a node-based map are never moved, so the LRU list can point at them
+		std::unordered_map<ScenarioKey, Entry> entries;
+		// most recently used at the front
+		std::list<const ScenarioKey*> lru;
+		size_t bytes = 0;
+		uint64_t hits = 0;
+		uint64_t misses = 0;
+		uint64_t evictions = 0;
+	};
+
+	static constexpr size_t NUM_SHARDS = 16;
+
+	Shard& shardFor(const ScenarioKey& key);
+	static size_t entryBytes(const TaskData& taskData, const CachedResult& result);
+
+	const size_t mShardBudget;
+	std::array<Shard, NUM_SHARDS> mShards;
+};
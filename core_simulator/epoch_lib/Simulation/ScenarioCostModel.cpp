@@ -0,0 +1,73 @@
+#include "ScenarioCostModel.hpp"
+
+#include <algorithm>
+
+#include "Flags.hpp"
+
+ScenarioCostModel::ScenarioCostModel(size_t timesteps) :
+	mTimesteps(static_cast<float>(std::max<size_t>(timesteps, 1)))
+{
+}
+
+float ScenarioCostModel::estimate(const TaskData& taskData) const {
+	const uint32_t key = mixKey(taskData);
+	std::lock_guard<std::mutex> lock(mMutex);
+	auto it = mRuntimes.find(key);
+	if (it != mRuntimes.end()) {
+		return it->second;
+	}
+	return mSecondsPerUnit * mTimesteps * weight(taskData);
+}
+
+void ScenarioCostModel::observe(const TaskData& taskData, float runtime) {
+	if (!(runtime > 0.0f)) {
+		return;
+	}
+	const uint32_t key = mixKey(taskData);
+	const float perUnit = runtime / (mTimesteps * weight(taskData));
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	auto [it, inserted] = mRuntimes.try_emplace(key, runtime);
+	if (!inserted) {
+		it->second += SMOOTHING * (runtime - it->second);
+	}
+	mSecondsPerUnit = mObserved ? mSecondsPerUnit + SMOOTHING * (perUnit - mSecondsPerUnit) : perUnit;
+	mObserved = true;
+}
+
+size_t ScenarioCostModel::mixes() const {
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mRuntimes.size();
+}
+
+uint32_t ScenarioCostModel::mixKey(const TaskData& taskData) {
+	const Flags flags(taskData);
+	uint32_t key = 0;
+	key |= static_cast<uint32_t>(taskData.building.has_value()) << 0;
+	key |= static_cast<uint32_t>(taskData.domestic_hot_water.has_value()) << 1;
+	key |= static_cast<uint32_t>(taskData.gas_heater.has_value()) << 2;
+	key |= static_cast<uint32_t>(taskData.grid.has_value()) << 3;
+	key |= static_cast<uint32_t>(taskData.heat_pump.has_value()) << 4;
+	key |= static_cast<uint32_t>(taskData.mop.has_value()) << 5;
+	key |= static_cast<uint32_t>(flags.getEVFlag()) << 6;
+	key |= static_cast<uint32_t>(flags.getDataCentreFlag()) << 8;
+	if (taskData.energy_storage_system) {
+		key |= (1u + static_cast<uint32_t>(taskData.energy_storage_system->battery_mode)) << 10;
+	}
+	key |= static_cast<uint32_t>(std::min<size_t>(taskData.solar_panels.size(), 255)) << 16;
+	return key;
+}
+
+float ScenarioCostModel::weight(const TaskData& taskData) {
+	// the Hotel and Grid are always simulated
+	float components = 2.0f;
+	components += taskData.data_centre ? 2.0f : 0.0f;
+	components += taskData.domestic_hot_water ? 2.0f : 0.0f;
+	components += taskData.electric_vehicles ? 1.0f : 0.0f;
+	components += taskData.energy_storage_system ? 2.0f : 0.0f;
+	components += taskData.gas_heater ? 1.0f : 0.0f;
+	components += taskData.heat_pump ? 2.0f : 0.0f;
+	components += taskData.mop ? 1.0f : 0.0f;
+	components += 0.5f * static_cast<float>(taskData.solar_panels.size());
+	return components;
+}
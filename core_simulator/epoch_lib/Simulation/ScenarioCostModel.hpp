@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+
+#include "TaskData.hpp"
+
+/**
+* Learned estimates of how long a Simulator takes to simulate a scenario, for scheduling batches longest first
+*
+* Scenarios are grouped by their component mix (which components are present, the ESS mode, the kind of EV and
+* data centre and the number of solar arrays), as that rather than the sizes of the components determines the cost.
+* Each mix's estimate is a moving average of the observed runtimes.
+* A mix that hasn't been observed yet is estimated from its number of components and the timesteps,
+* scaled by the average cost per component-timestep observed so far, so that estimates are comparable across Simulators.
+*
+* This is internally synchronised.
+*/
+class ScenarioCostModel {
+public:
+	explicit ScenarioCostModel(size_t timesteps);
+
+	// the estimated runtime in seconds
+	float estimate(const TaskData& taskData) const;
+
+	// learn from the runtime of a simulated scenario
+	void observe(const TaskData& taskData, float runtime);
+
+	// the number of component mixes that have been observed
+	size_t mixes() const;
+
+	// the key that scenarios with the same cost share
+	static uint32_t mixKey(const TaskData& taskData);
+
+private:
+	// the weight given to each new observation
+	static constexpr float SMOOTHING = 0.2f;
+	// the cost per component-timestep assumed until one has been observed (roughly that of a modern core)
+	static constexpr float DEFAULT_SECONDS_PER_UNIT = 2e-9f;
+
+	// the cost of a mix relative to the others, before any have been observed
+	static float weight(const TaskData& taskData);
+
+	const float mTimesteps;
+	mutable std::mutex mMutex;
+	std::unordered_map<uint32_t, float> mRuntimes;
+	float mSecondsPerUnit = DEFAULT_SECONDS_PER_UNIT;
+	bool mObserved = false;
+};
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+* The reasons a scenario cannot be simulated with a site's data, as a bitmask (None when it is valid)
+*/
+enum class ScenarioError : uint32_t {
+	None = 0,
+	// the building's fabric_intervention_index is beyond the site's fabric interventions
+	FabricInterventionIndex = 1u << 0,
+	// the grid's tariff_index is beyond the site's import tariffs
+	TariffIndex = 1u << 1,
+	// a solar panel's yield_index is not one of the site's solar yields
+	YieldIndex = 1u << 2,
+};
+
+constexpr ScenarioError operator|(ScenarioError a, ScenarioError b) {
+	return static_cast<ScenarioError>(static_cast<uint32_t>(a) | static_cast<uint32_t>(b));
+}
+
+constexpr ScenarioError& operator|=(ScenarioError& a, ScenarioError b) {
+	return a = a | b;
+}
+
+// whether any of the errors in b are in a
+constexpr bool hasError(ScenarioError a, ScenarioError b) {
+	return (static_cast<uint32_t>(a) & static_cast<uint32_t>(b)) != 0;
+}
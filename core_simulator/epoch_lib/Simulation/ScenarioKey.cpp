@@ -0,0 +1,264 @@
+#include "ScenarioKey.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <format>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+
+#include "TaskData.hpp"
+
+namespace {
+	// bump this whenever the encoding changes, so that keys from different encodings never match
+	constexpr uint8_t ENCODING_VERSION = 1;
+
+	constexpr uint64_t C1 = 0x87c37b91114253d5ULL;
+	constexpr uint64_t C2 = 0x4cf5af49c9dd64a3ULL;
+
+	uint64_t fmix64(uint64_t k) {
+		k ^= k >> 33;
+		k *= 0xff51afd7ed558ccdULL;
+		k ^= k >> 33;
+		k *= 0xc4ceb9fe1a85ec53ULL;
+		k ^= k >> 33;
+		return k;
+	}
+
+	uint64_t load64(const unsigned char* bytes) {
+		if constexpr (std::endian::native == std::endian::little) {
+			uint64_t value;
+			std::memcpy(&value, bytes, sizeof(value));
+			return value;
+		}
+		uint64_t value = 0;
+		for (size_t i = 0; i < 8; i++) {
+			value |= static_cast<uint64_t>(bytes[i]) << (8 * i);
+		}
+		return value;
+	}
+
+	uint64_t load64(const unsigned char* bytes, size_t count) {
+		uint64_t value = 0;
+		for (size_t i = 0; i < count; i++) {
+			value |= static_cast<uint64_t>(bytes[i]) << (8 * i);
+		}
+		return value;
+	}
+
+	/**
+	* Writes the canonical encoding to a Sink (which has put(const unsigned char*, size_t))
+	*/
+	template <typename Sink>
+	class Encoder {
+	public:
+		Encoder(Sink& sink, const KeyQuantisation& quantisation) : mSink(sink) {
+			if (quantisation.mantissaBits < 0 || quantisation.mantissaBits > 23) {
+				throw std::invalid_argument(std::format("Cannot quantise floats to {} mantissa bits (must be 0 to 23)", quantisation.mantissaBits));
+			}
+			mDropBits = 23 - quantisation.mantissaBits;
+		}
+
+		void put(float value) {
+			uint32_t bits;
+			if (std::isnan(value)) {
+				bits = 0x7fc00000u;
+			}
+			else if (value == 0.0f) {
+				// +0 and -0 are equal
+				bits = 0;
+			}
+			else {
+				bits = std::bit_cast<uint32_t>(value);
+				if (mDropBits > 0 && std::isfinite(value)) {
+					// round to the nearest (a carry into the exponent is the correct rounding up)
+					bits += 1u << (mDropBits - 1);
+					bits &= ~((1u << mDropBits) - 1);
+				}
+			}
+			putLittleEndian(bits, 4);
+		}
+
+		void put(uint64_t value) { putLittleEndian(value, 8); }
+		void put(uint8_t value) { putLittleEndian(value, 1); }
+		void put(bool value) { putLittleEndian(value ? 1 : 0, 1); }
+		void put(int value) { putLittleEndian(static_cast<uint32_t>(value), 4); }
+
+		template <typename E> requires std::is_enum_v<E>
+		void put(E value) { putLittleEndian(static_cast<uint32_t>(value), 4); }
+
+		template <typename... Ts>
+		void operator()(const Ts&... values) { (put(values), ...); }
+
+		template <typename T, typename Fields>
+		void component(const std::optional<T>& value, Fields&& fields) {
+			put(value.has_value());
+			if (value) {
+				fields(*value);
+			}
+		}
+
+	private:
+		void putLittleEndian(uint64_t value, size_t count) {
+			std::array<unsigned char, 8> bytes;
+			if constexpr (std::endian::native == std::endian::little) {
+				std::memcpy(bytes.data(), &value, sizeof(value));
+			}
+			else {
+				for (size_t i = 0; i < count; i++) {
+					bytes[i] = static_cast<unsigned char>(value >> (8 * i));
+				}
+			}
+			mSink.put(bytes.data(), count);
+		}
+
+		Sink& mSink;
+		int mDropBits;
+	};
+
+	template <typename Sink>
+	void encode(const TaskData& td, const KeyQuantisation& quantisation, Sink& sink) {
+		Encoder<Sink> e(sink, quantisation);
+		e(ENCODING_VERSION);
+
+		e.component(td.building, [&](const Building& b) {
+			e(b.scalar_heat_load, b.scalar_electrical_load, static_cast<uint64_t>(b.fabric_intervention_index), b.floor_area.has_value(),
+				b.floor_area.value_or(0.0f), b.incumbent, b.age, b.lifetime);
+		});
+		e.component(td.data_centre, [&](const DataCentreData& d) {
+			e(d.maximum_load, d.hotroom_temp, d.incumbent, d.age, d.lifetime);
+		});
+		e.component(td.domestic_hot_water, [&](const DomesticHotWater& d) {
+			e(d.cylinder_volume, d.incumbent, d.age, d.lifetime);
+		});
+		e.component(td.electric_vehicles, [&](const ElectricVehicles& ev) {
+			e(ev.flexible_load_ratio, static_cast<uint64_t>(ev.small_chargers), static_cast<uint64_t>(ev.fast_chargers),
+				static_cast<uint64_t>(ev.rapid_chargers), static_cast<uint64_t>(ev.ultra_chargers), ev.scalar_electrical_load,
+				ev.incumbent, ev.age, ev.lifetime);
+		});
+		e.component(td.energy_storage_system, [&](const EnergyStorageSystem& ess) {
+			e(ess.capacity, ess.charge_power, ess.discharge_power, ess.battery_mode, ess.initial_charge, ess.incumbent, ess.age, ess.lifetime);
+		});
+		e.component(td.gas_heater, [&](const GasCHData& gch) {
+			e(gch.maximum_output, gch.boiler_efficiency, gch.gas_type, gch.fixed_gas_price, gch.incumbent, gch.age, gch.lifetime);
+		});
+		e.component(td.grid, [&](const GridData& grid) {
+			e(grid.grid_export, grid.grid_import, grid.import_headroom, static_cast<uint64_t>(grid.tariff_index), grid.export_tariff,
+				grid.incumbent, grid.age, grid.lifetime);
+		});
+		e.component(td.heat_pump, [&](const HeatPumpData& hp) {
+			e(hp.heat_power, hp.heat_source, hp.send_temp, hp.incumbent, hp.age, hp.lifetime);
+		});
+		e.component(td.mop, [&](const MopData& m) {
+			e(m.maximum_load, m.incumbent, m.age, m.lifetime);
+		});
+
+		e(static_cast<uint64_t>(td.solar_panels.size()));
+		for (const SolarData& sd : td.solar_panels) {
+			e(sd.yield_scalar, sd.yield_index, sd.incumbent, sd.age, sd.lifetime);
+		}
+	}
+
+	struct ByteSink {
+		std::vector<std::byte>& bytes;
+		void put(const unsigned char* data, size_t size) {
+			const auto* begin = reinterpret_cast<const std::byte*>(data);
+			bytes.insert(bytes.end(), begin, begin + size);
+		}
+	};
+
+	/**
+	* Collects the encoding on the stack (or on the heap, for a TaskData with many solar panels) to be hashed in one pass
+	*/
+	class StackSink {
+	public:
+		explicit StackSink(size_t capacity) {
+			if (capacity > mInline.size()) {
+				mHeap.resize(capacity);
+				mData = mHeap.data();
+			}
+		}
+
+		void put(const unsigned char* data, size_t size) {
+			std::memcpy(mData + mSize, data, size);
+			mSize += size;
+		}
+
+		ScenarioKey hash() const {
+			return murmurHash128(mData, mSize);
+		}
+
+	private:
+		std::array<unsigned char, 512> mInline;
+		std::vector<unsigned char> mHeap;
+		unsigned char* mData = mInline.data();
+		size_t mSize = 0;
+	};
+
+	// at least the size of the canonical encoding of a TaskData with this many solar panels
+	size_t maxEncodedSize(size_t solarPanels) {
+		// with every component present the rest comes to 248 bytes (see the ScenarioKey tests), and each panel is 17
+		return 256 + 17 * solarPanels;
+	}
+}
+
+std::string ScenarioKey::toHex() const {
+	return std::format("{:016x}{:016x}", high, low);
+}
+
+std::vector<std::byte> canonicalEncoding(const TaskData& taskData, const KeyQuantisation& quantisation) {
+	std::vector<std::byte> bytes;
+	bytes.reserve(maxEncodedSize(taskData.solar_panels.size()));
+	ByteSink sink{ bytes };
+	encode(taskData, quantisation, sink);
+	return bytes;
+}
+
+ScenarioKey scenarioKey(const TaskData& taskData, const KeyQuantisation& quantisation) {
+	StackSink sink(maxEncodedSize(taskData.solar_panels.size()));
+	encode(taskData, quantisation, sink);
+	return sink.hash();
+}
+
+ScenarioKey murmurHash128(const void* data, size_t size, uint32_t seed) {
+	// (the bytes are read as little-endian, so the hash is the same on any platform)
+	const auto* bytes = static_cast<const unsigned char*>(data);
+	uint64_t h1 = seed;
+	uint64_t h2 = seed;
+
+	const size_t blocks = size / 16;
+	for (size_t i = 0; i < blocks; i++) {
+		uint64_t k1 = load64(bytes + 16 * i);
+		uint64_t k2 = load64(bytes + 16 * i + 8);
+
+		k1 *= C1; k1 = std::rotl(k1, 31); k1 *= C2; h1 ^= k1;
+		h1 = std::rotl(h1, 27); h1 += h2; h1 = h1 * 5 + 0x52dce729;
+
+		k2 *= C2; k2 = std::rotl(k2, 33); k2 *= C1; h2 ^= k2;
+		h2 = std::rotl(h2, 31); h2 += h1; h2 = h2 * 5 + 0x38495ab5;
+	}
+
+	const unsigned char* tail = bytes + 16 * blocks;
+	const size_t remaining = size % 16;
+	if (remaining > 8) {
+		uint64_t k2 = load64(tail + 8, remaining - 8);
+		k2 *= C2; k2 = std::rotl(k2, 33); k2 *= C1; h2 ^= k2;
+	}
+	if (remaining > 0) {
+		uint64_t k1 = load64(tail, std::min<size_t>(remaining, 8));
+		k1 *= C1; k1 = std::rotl(k1, 31); k1 *= C2; h1 ^= k1;
+	}
+
+	h1 ^= size;
+	h2 ^= size;
+	h1 += h2;
+	h2 += h1;
+	h1 = fmix64(h1);
+	h2 = fmix64(h2);
+	h1 += h2;
+	h2 += h1;
+	return ScenarioKey{ h1, h2 };
+}
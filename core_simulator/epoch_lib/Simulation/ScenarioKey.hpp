@@ -0,0 +1,64 @@
+#pragma once
+
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+struct TaskData;
+
+/**
+* How finely the floats of a TaskData are distinguished when it is keyed
+*
+* Each float is rounded to this many bits of mantissa, so scenarios whose values differ by less than about
+* one part in 2^mantissaBits share a key. 23 (the default) keeps every float exactly.
+*/
+struct KeyQuantisation {
+	int mantissaBits = 23;
+
+	bool operator==(const KeyQuantisation&) const = default;
+};
+
+/**
+* A 128-bit key of a scenario, the hash of its canonical encoding (see canonicalEncoding)
+*
+* The key is the same on every platform and in every process, so it can be shared between workers and nodes,
+* unlike std::hash. Any two distinct TaskData are vanishingly unlikely to share a key,
+* but a cache that must never return the wrong result should still compare the TaskData themselves.
+*/
+struct ScenarioKey {
+	uint64_t low = 0;
+	uint64_t high = 0;
+
+	auto operator<=>(const ScenarioKey&) const = default;
+
+	// the key as 32 hex digits (high then low)
+	std::string toHex() const;
+};
+
+template<>
+struct std::hash<ScenarioKey>
+{
+	std::size_t operator()(const ScenarioKey& key) const noexcept {
+		return static_cast<std::size_t>(key.low);
+	}
+};
+
+/**
+* Encode each field of a TaskData in a fixed order as little-endian bytes
+* The encoding starts with its version, and records whether each component is present and the number of solar panels.
+* An equal TaskData always gives the same bytes (+0 and -0, and every NaN, are each encoded as one value).
+*/
+std::vector<std::byte> canonicalEncoding(const TaskData& taskData, const KeyQuantisation& quantisation = {});
+
+/**
+* The MurmurHash3 (x64, 128-bit) of the canonical encoding, found without building it
+*/
+ScenarioKey scenarioKey(const TaskData& taskData, const KeyQuantisation& quantisation = {});
+
+/**
+* MurmurHash3 (x64, 128-bit) of some bytes, with seed 0
+*/
+ScenarioKey murmurHash128(const void* data, size_t size, uint32_t seed = 0);
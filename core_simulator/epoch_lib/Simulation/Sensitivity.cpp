@@ -0,0 +1,56 @@
+#include "Sensitivity.hpp"
+
+#include <format>
+#include <stdexcept>
+
+namespace {
+	// the parameter within a (const or mutable) TaskData
+	template <typename Task>
+	auto& parameterOf(Task& taskData, const Perturbation& perturbation) {
+		auto require = [](auto& component, const char* name) -> auto& {
+			if (!component) {
+				throw std::runtime_error(std::format("Cannot perturb the {} of a scenario without one", name));
+			}
+			return *component;
+		};
+
+		switch (perturbation.parameter) {
+		case SensitivityParameter::ESSCapacity:
+			return require(taskData.energy_storage_system, "energy_storage_system").capacity;
+		case SensitivityParameter::ESSChargePower:
+			return require(taskData.energy_storage_system, "energy_storage_system").charge_power;
+		case SensitivityParameter::ESSDischargePower:
+			return require(taskData.energy_storage_system, "energy_storage_system").discharge_power;
+		case SensitivityParameter::HeatPower:
+			return require(taskData.heat_pump, "heat_pump").heat_power;
+		case SensitivityParameter::GridImport:
+			return require(taskData.grid, "grid").grid_import;
+		case SensitivityParameter::YieldScalar:
+			if (perturbation.panel >= taskData.solar_panels.size()) {
+				throw std::runtime_error(std::format("Cannot perturb solar panel {} of a scenario with {} solar panels",
+					perturbation.panel, taskData.solar_panels.size()));
+			}
+			return taskData.solar_panels[perturbation.panel].yield_scalar;
+		}
+		throw std::runtime_error("Unknown SensitivityParameter");
+	}
+}
+
+float getParameter(const TaskData& taskData, const Perturbation& perturbation) {
+	return parameterOf(taskData, perturbation);
+}
+
+void setParameter(TaskData& taskData, const Perturbation& perturbation, float value) {
+	parameterOf(taskData, perturbation) = value;
+}
+
+Eigen::VectorXf objectiveFields(const ObjectiveResult& objectives) {
+	Eigen::VectorXf fields(static_cast<Eigen::Index>(NUM_OBJECTIVE_FIELDS));
+	fields << objectives.total_annualised_cost,
+		objectives.total_capex,
+		objectives.scenario_cost_balance,
+		objectives.payback_horizon_years,
+		objectives.scenario_carbon_balance_scope_1,
+		objectives.scenario_carbon_balance_scope_2;
+	return fields;
+}
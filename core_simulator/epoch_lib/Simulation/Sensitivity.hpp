@@ -0,0 +1,76 @@
+#pragma once
+// finite difference sensitivities of the objectives to the continuous parameters of a scenario
+
+#include <array>
+#include <cstddef>
+
+#include <Eigen/Core>
+
+#include "../Definitions.hpp"
+#include "TaskData.hpp"
+
+// The continuous parameters that a scenario can be perturbed in
+enum class SensitivityParameter {
+	ESSCapacity,
+	ESSChargePower,
+	ESSDischargePower,
+	HeatPower,
+	YieldScalar,
+	GridImport
+};
+
+enum class SensitivityScheme {
+	// (f(x + h) - f(x)) / h
+	Forward,
+	// (f(x + h) - f(x - h)) / 2h, or Forward where x - h would be negative
+	Central
+};
+
+/**
+* A step in one parameter of a scenario
+*/
+struct Perturbation {
+	SensitivityParameter parameter;
+	// the (positive) step, in the units of the parameter
+	float step;
+	// the solar panel to perturb (only used for YieldScalar)
+	size_t panel = 0;
+};
+
+// The number of fields of an ObjectiveResult (excluding its TaskData)
+inline constexpr size_t NUM_OBJECTIVE_FIELDS = 6;
+
+// The name of each objective, in the order of the rows of a SensitivityResult's jacobian
+inline constexpr std::array<const char*, NUM_OBJECTIVE_FIELDS> OBJECTIVE_FIELD_NAMES = {
+	"total_annualised_cost",
+	"total_capex",
+	"scenario_cost_balance",
+	"payback_horizon_years",
+	"scenario_carbon_balance_scope_1",
+	"scenario_carbon_balance_scope_2"
+};
+
+struct SensitivityResult {
+	ObjectiveResult base;
+	/**
+	* The derivative of each objective (row, in OBJECTIVE_FIELD_NAMES order) with respect to each perturbation (column)
+	* A column is NaN if a perturbed scenario is invalid
+	*/
+	Eigen::MatrixXf jacobian;
+	// the number of perturbed scenarios that were simulated from the base scenario's state before the balancing loop
+	size_t reused_pre_balancing = 0;
+};
+
+/**
+* Get the value of the perturbed parameter of a scenario
+* Raise an exception if the scenario does not have the component
+*/
+float getParameter(const TaskData& taskData, const Perturbation& perturbation);
+
+/**
+* Set the value of the perturbed parameter of a scenario
+*/
+void setParameter(TaskData& taskData, const Perturbation& perturbation, float value);
+
+// The ObjectiveResult fields as a vector, in OBJECTIVE_FIELD_NAMES order
+Eigen::VectorXf objectiveFields(const ObjectiveResult& objectives);
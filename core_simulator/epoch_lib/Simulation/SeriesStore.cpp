@@ -0,0 +1,79 @@
+#include "SeriesStore.hpp"
+
+#include <cstring>
+
+namespace {
+	// FNV-1a over the bits of each value
+	uint64_t hashValues(const SiteSeries& series) {
+		uint64_t hash = 0xcbf29ce484222325ull ^ static_cast<uint64_t>(series.size());
+		for (Eigen::Index t = 0; t < series.size(); t++) {
+			uint32_t bits;
+			std::memcpy(&bits, series.data() + t, sizeof(bits));
+			hash = (hash ^ bits) * 0x100000001b3ull;
+		}
+		return hash;
+	}
+
+	bool sameValues(const SiteSeries& a, const SiteSeries& b) {
+		return a.size() == b.size()
+			&& std::memcmp(a.data(), b.data(), sizeof(float) * static_cast<size_t>(a.size())) == 0;
+	}
+}
+
+SiteSeries SeriesStore::intern(const SiteSeries& series) {
+	if (series.size() == 0) {
+		return series;
+	}
+	const uint64_t hash = hashValues(series);
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	auto [first, last] = mSeries.equal_range(hash);
+	for (auto it = first; it != last; ++it) {
+		if (sameValues(it->second, series)) {
+			return it->second;
+		}
+	}
+	mSeries.emplace(hash, series);
+	return series;
+}
+
+SiteData SeriesStore::intern(SiteData siteData) {
+	for (SiteSeries* series : { &siteData.building_eload, &siteData.building_hload, &siteData.ev_eload,
+		&siteData.dhw_demand, &siteData.air_temperature, &siteData.grid_co2 }) {
+		*series = intern(*series);
+	}
+	for (SiteSeries& tariff : siteData.import_tariffs) {
+		tariff = intern(tariff);
+	}
+	for (FabricIntervention& intervention : siteData.fabric_interventions) {
+		if (intervention.hload_delta) {
+			intervention.hload_delta->base = intern(intervention.hload_delta->base);
+		}
+		else {
+			intervention.reduced_hload = intern(intervention.reduced_hload);
+		}
+	}
+	return siteData;
+}
+
+size_t SeriesStore::size() const {
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mSeries.size();
+}
+
+size_t SeriesStore::storedBytes() const {
+	std::lock_guard<std::mutex> lock(mMutex);
+	size_t bytes = 0;
+	for (const auto& [hash, series] : mSeries) {
+		if (!series.isView()) {
+			bytes += sizeof(float) * static_cast<size_t>(series.size());
+		}
+	}
+	return bytes;
+}
+
+size_t SeriesStore::prune() {
+	std::lock_guard<std::mutex> lock(mMutex);
+	// a column held only by the store has a single owner (a view is kept while anything else views the same storage)
+	return std::erase_if(mSeries, [](const auto& entry) { return entry.second.owner().use_count() == 1; });
+}
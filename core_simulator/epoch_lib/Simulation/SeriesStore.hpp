@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+
+#include "SiteData.hpp"
+#include "SiteSeries.hpp"
+
+/**
+* A content-addressed store of SiteData columns
+*
+* Interning a series returns the stored series with the same values (storing it if there is none),
+* so sites that share a column, such as the air temperature, grid carbon or tariffs of sites in one region,
+* hold a single copy of it. Interned columns also share their identity, so anything derived from them
+* (see DerivedCache) is shared by the Simulators of those sites as well.
+*
+* Columns are compared bit for bit, so a hash collision never merges different values.
+* The store is internally synchronised. It holds each column until it is pruned or destroyed,
+* but the SiteData interned through it keep their columns regardless.
+*/
+class SeriesStore {
+public:
+	// the stored series with the same values as series
+	SiteSeries intern(const SiteSeries& series);
+
+	/**
+	* siteData with each of its timeseries replaced by the stored series with the same values
+	* The solar yields are packed into one matrix per site (see SiteSeriesMatrix), so are left as they are.
+	*/
+	SiteData intern(SiteData siteData);
+
+	// the number of distinct columns held
+	size_t size() const;
+
+	// the bytes held by the distinct columns (those that view external storage are not counted)
+	size_t storedBytes() const;
+
+	// forget the columns that are no longer used outside the store, returning how many there were
+	size_t prune();
+
+private:
+	mutable std::mutex mMutex;
+	std::unordered_multimap<uint64_t, SiteSeries> mSeries;
+};
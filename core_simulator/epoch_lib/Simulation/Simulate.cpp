@@ -1,11 +1,24 @@
 #include "Simulate.hpp"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
 #include <chrono>
+#include <cstdint>
+#include <cmath>
 #include <format>
+#include <functional>
 #include <iostream>
 #include <limits> 
 #include <memory>
+#include <numeric>
+#include <optional>
 #include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
+#include <variant>
+#include <vector>
 
 #include <Eigen/Core>
 #include <spdlog/spdlog.h>
@@ -13,302 +26,2169 @@
 #include "TaskData.hpp"
 #include "../Definitions.hpp"
 
+#include "BalancingLoop.hpp"
+#include "BatchPlan.hpp"
+#include "LockstepBalancing.hpp"
 #include "Costs/Usage.hpp"
 #include "Costs/Compare.hpp"
 #include "Costs/NetPresentValue.hpp"
 #include "DayTariffStats.hpp"
+#include "DerivedCache.hpp"
+#include "ExecutionPlan.hpp"
 #include "Components/DHW/HotWaterCylinder.hpp"
 #include "Components/DHW/InstantWaterHeater.hpp"
 
 #include "Flags.hpp"
+#include "PhaseTimer.hpp"
 #include "TempSum.hpp"
+#include "Trace.hpp"
 
 #include "Hotel.hpp"
 #include "PV.hpp"
 #include "EV.hpp"
-#include "Grid.hpp"
-#include "Mop.hpp"
+#include "PostBalancing.hpp"
 #include "GasCH.hpp"
 #include "ASHP.hpp"
 #include "HeatPumpController.hpp"
 
 #include "Components/DataCentre.hpp"
 #include "Components/ESS/ESS.hpp"
+#include "Components/ESS/SoCScan.hpp"
 #include "Costs/SAP.hpp"
+#include "Resample.hpp"
+#include "Sensitivity.hpp"
+#include "../io/BaselineCache.hpp"
+#include "../io/ResultTable.hpp"
+
+namespace {
+	// the daily tariff statistics depend on the tariff and, for the carbon lookahead, the grid carbon
+	struct TariffStatsKey {
+		SeriesIdentity tariff;
+		SeriesIdentity gridCO2;
+		float timestepHours;
+
+		bool operator==(const TariffStatsKey& other) const = default;
+		bool expired() const { return tariff.expired() || gridCO2.expired(); }
+	};
+
+	struct ImportTariffsKey {
+		std::vector<SeriesIdentity> tariffs;
+
+		bool operator==(const ImportTariffsKey& other) const = default;
+		bool expired() const { return std::ranges::any_of(tariffs, &SeriesIdentity::expired); }
+	};
+
+	// the ambient profile depends on the air temperature and the (small) heatpump tables, which are compared by value
+	struct AmbientProfileKey {
+		SeriesIdentity airTemperature;
+		Eigen::MatrixXf inputTable;
+		Eigen::MatrixXf outputTable;
+
+		bool operator==(const AmbientProfileKey& other) const {
+			auto same = [](const Eigen::MatrixXf& a, const Eigen::MatrixXf& b) {
+				return a.rows() == b.rows() && a.cols() == b.cols() && a == b;
+			};
+			return airTemperature == other.airTemperature
+				&& same(inputTable, other.inputTable) && same(outputTable, other.outputTable);
+		}
+		bool expired() const { return airTemperature.expired(); }
+	};
+
+	DerivedCache<TariffStatsKey, DayTariffStats>& tariffStatsCache() {
+		static DerivedCache<TariffStatsKey, DayTariffStats> cache;
+		return cache;
+	}
+
+	DerivedCache<ImportTariffsKey, TariffPricing>& importTariffsCache() {
+		static DerivedCache<ImportTariffsKey, TariffPricing> cache;
+		return cache;
+	}
+
+	DerivedCache<AmbientProfileKey, HeatPumpProfile>& ambientProfileCache() {
+		static DerivedCache<AmbientProfileKey, HeatPumpProfile> cache;
+		return cache;
+	}
+
+	// the timesteps to balance between checks of the import shortfall against a constraint
+	constexpr size_t SHORTFALL_CHECK_TIMESTEPS = 2048;
+
+	// The shortfall bounds are accumulated in double while the metrics are accumulated in float,
+	// so a scenario is only stopped once its bound is clear of the limit by more than the rounding of the metric
+	constexpr double SHORTFALL_BOUND_MARGIN = 1e-4;
+
+	bool exceedsLimit(const std::optional<float>& limit, double shortfall) {
+		return limit && shortfall > static_cast<double>(*limit) * (1.0 + SHORTFALL_BOUND_MARGIN);
+	}
+
+	// Likewise, the optimistic totals of boundObjectives are moved in their optimistic direction by more than the rounding of the totals
+	float loosen(double bound, bool upper) {
+		const double margin = std::abs(bound) * SHORTFALL_BOUND_MARGIN;
+		return static_cast<float>(upper ? bound + margin : bound - margin);
+	}
+}
+
+/**
+* A scenario part way through simulateTimesteps: the components that run before the balancing loop have run
+* and those that may be in the balancing loop have been constructed
+*/
+struct Simulator::ScenarioState {
+	explicit ScenarioState(const TaskData& taskData, const ExecutionPlan& plan) :
+		flags(taskData),
+		plan(plan)
+	{}
+
+	Flags flags;
+	// the components to run and the balancing loop kernel, shared by every scenario of this shape
+	const ExecutionPlan& plan;
+	std::optional<TempSum> tempSum;
+	SimulationTotals totals{};
+
+	float availableGridImport = 0.0f;
+
+	// the components are held in place, so constructing them only takes the timeseries buffers from the thread's pool
+	std::optional<BasicESS> ess;
+	std::optional<BasicElectricVehicle> ev;
+	std::variant<std::monostate, BasicDataCentre, DataCentreWithASHP> dataCentre;
+	std::optional<AmbientHeatPumpController> ambientController;
+
+	// the state before the balancing loop to start from, if it is already known
+	std::shared_ptr<const PreBalancingSnapshot> snapshot;
+	// whether to set snapshot to this scenario's state before the balancing loop, if it isn't already set
+	bool keepSnapshot = false;
+
+	// the state to continue from, which is updated by the components that carry it
+	CarriedState* carried = nullptr;
+
+	// the components to pass to the balancing loop, which are null if they don't balance
+	BasicESS* balancingESS() { return ess ? &ess.value() : nullptr; }
+	BasicElectricVehicle* balancingEV() { return flags.getEVFlag() == EVFlag::BALANCING && ev ? &ev.value() : nullptr; }
+	DataCentre* balancingDataCentre() { return flags.getDataCentreFlag() == DataCentreFlag::BALANCING ? getDataCentre() : nullptr; }
+
+	// run the plan's balancing loop kernel over [begin, end), if anything balances
+	void balance(size_t begin, size_t end) {
+		if (plan.balancingLoop) {
+			plan.balancingLoop(*tempSum, begin, end, availableGridImport, balancingESS(), balancingEV(), balancingDataCentre());
+		}
+	}
+
+	// the data centre of either kind, or null if there isn't one
+	DataCentre* getDataCentre() {
+		return std::visit([](auto& dc) -> DataCentre* {
+			if constexpr (std::is_same_v<std::decay_t<decltype(dc)>, std::monostate>) {
+				return nullptr;
+			}
+			else {
+				return &dc;
+			}
+		}, dataCentre);
+	}
+};
+
+/**
+* The scenarios of a lock-step group that need to be balanced, alongside their state
+* (the lanes point into the states, which are held in place)
+*/
+struct Simulator::LockstepGroup {
+	std::chrono::high_resolution_clock::time_point start;
+	std::vector<size_t> simulated;
+	std::vector<std::unique_ptr<ScenarioState>> states;
+	std::vector<LockstepLane> lanes;
+};
+
+Simulator::Simulator(SiteData siteData, TaskConfig config):
+	Simulator(std::make_shared<const SiteData>(std::move(siteData)), config)
+{
+}
+
+Simulator::Simulator(std::shared_ptr<const SiteData> siteData, TaskConfig config):
+	Simulator(std::move(siteData), std::move(config), std::nullopt)
+{
+}
+
+Simulator::Simulator(std::shared_ptr<const SiteData> siteData, TaskConfig config, SimulatorBaseline baseline):
+	Simulator(std::move(siteData), std::move(config), std::optional<SimulatorBaseline>(std::move(baseline)))
+{
+}
+
+Simulator::Simulator(std::shared_ptr<const SiteData> siteData, TaskConfig config, std::optional<SimulatorBaseline> baseline):
+	mSiteDataPtr(siteData ? std::move(siteData) : throw std::runtime_error("Simulator requires a SiteData")),
+	mSiteData(*mSiteDataPtr),
+	mConfig(config),
+	mTariffStats(sharedTariffStats(mSiteData)),
+	mImportTariffs(sharedImportTariffs(mSiteData)),
+	mHeatPumpLookup(mSiteData, 1.0f, FIXED_SEND_TEMP_VAL),
+	mAmbientHeatPumpProfile(sharedAmbientHeatPumpProfile(mSiteData, mHeatPumpLookup)),
+	mHotRoomProfiles(std::make_shared<HotRoomProfileCache>()),
+	mCostEngine(std::make_shared<const CostEngine>(mSiteData, mConfig)),
+	mResolutions(std::make_shared<Resolutions>())
+{
+	buildEnsemble();
+
+	if (baseline) {
+		if (!baseline->reportData || baseline->reportData->timesteps() != static_cast<Eigen::Index>(mSiteData.timesteps)) {
+			throw std::runtime_error("The baseline's ReportData does not match the timesteps of the SiteData");
+		}
+		std::call_once(mBaseline->once, [&] {
+			mBaseline->baseline = std::move(*baseline);
+			mBaseline->ready.store(true, std::memory_order_release);
+		});
+	}
+}
+
+Simulator::Simulator(std::shared_ptr<const SiteData> siteData, TaskConfig config, std::shared_ptr<const CostEngine> costEngine, Part part):
+	mSiteDataPtr(siteData ? std::move(siteData) : throw std::runtime_error("Simulator requires a SiteData")),
+	mSiteData(*mSiteDataPtr),
+	mConfig(config),
+	// a Summary never simulates a timestep, so doesn't need anything that is as long as the timeseries
+	mTariffStats(part == Part::Window ? sharedTariffStats(mSiteData) : std::vector<std::shared_ptr<const DayTariffStats>>{}),
+	mImportTariffs(part == Part::Window ? sharedImportTariffs(mSiteData) : std::make_shared<const TariffPricing>()),
+	mHeatPumpLookup(mSiteData, 1.0f, FIXED_SEND_TEMP_VAL),
+	mAmbientHeatPumpProfile(part == Part::Window
+		? sharedAmbientHeatPumpProfile(mSiteData, mHeatPumpLookup) : std::make_shared<const HeatPumpProfile>()),
+	mHotRoomProfiles(std::make_shared<HotRoomProfileCache>()),
+	mCostEngine(costEngine ? std::move(costEngine) : std::make_shared<const CostEngine>(mSiteData, mConfig)),
+	mResolutions(std::make_shared<Resolutions>())
+{
+}
+
+Simulator::Simulator(const Simulator& nominal, size_t member):
+	mSiteDataPtr(std::make_shared<const SiteData>(nominal.mSiteData.ensembleMember(member))),
+	mSiteData(*mSiteDataPtr),
+	mConfig(nominal.mConfig),
+	// only the weather and demand differ, so everything that doesn't depend on them is shared
+	mTariffStats(nominal.mTariffStats),
+	mImportTariffs(nominal.mImportTariffs),
+	mHeatPumpLookup(nominal.mHeatPumpLookup),
+	mAmbientHeatPumpProfile(sharedAmbientHeatPumpProfile(mSiteData, mHeatPumpLookup)),
+	// the profiles depend on the air temperature, so each member has its own
+	mHotRoomProfiles(std::make_shared<HotRoomProfileCache>()),
+	mCostEngine(nominal.mCostEngine),
+	mTimestamps(nominal.mTimestamps),
+	mResolutions(std::make_shared<Resolutions>())
+{
+	// each member is compared against the baseline under its own weather and demand, when it is first needed
+}
+
+Simulator::Simulator(const Simulator& base, std::shared_ptr<const SiteData> siteData, const SiteUpdate& update):
+	mSiteDataPtr(std::move(siteData)),
+	mSiteData(*mSiteDataPtr),
+	mConfig(base.mConfig),
+	// the stats and profiles of unchanged columns are found in the DerivedCaches, as base holds them
+	mTariffStats(sharedTariffStats(mSiteData)),
+	mImportTariffs(sharedImportTariffs(mSiteData)),
+	mHeatPumpLookup(base.mHeatPumpLookup),
+	mAmbientHeatPumpProfile(sharedAmbientHeatPumpProfile(mSiteData, mHeatPumpLookup)),
+	mHotRoomProfiles(update.replaces(SiteColumn::AirTemperature) ? std::make_shared<HotRoomProfileCache>() : base.mHotRoomProfiles),
+	// the costs don't depend on any column, but the CostEngine refers to the SiteData it was made with
+	mCostEngine(std::make_shared<const CostEngine>(mSiteData, mConfig)),
+	mBaseline(update.affects(mSiteData.baseline) ? std::make_shared<LazyBaseline>() : base.mBaseline),
+	// start_ts and end_ts are never updated, so the times only change if the number of timesteps does
+	mTimestamps(mSiteData.timesteps == base.mSiteData.timesteps ? base.mTimestamps : std::make_shared<LazyTimestamps>()),
+	mBaselineCacheDirectory(base.mBaselineCacheDirectory),
+	mParallelESSPool(base.mParallelESSPool),
+	mLowLatencyPool(base.mLowLatencyPool),
+	mBatchBackend(base.mBatchBackend),
+	mResolutions(std::make_shared<Resolutions>()),
+	mCostModel(base.mCostModel),
+	mExecutionPlans(base.mExecutionPlans)
+{
+	buildEnsemble();
+
+	// the cached results and states depend on the columns, so start again with the same budgets
+	if (base.mResultCache) {
+		enableResultCache(base.mResultCache->byteBudget());
+	}
+	if (base.mPreBalancingCache) {
+		enablePreBalancingCache(base.mPreBalancingCache->byteBudget());
+	}
+	if (base.mRepresentativeDays) {
+		enableRepresentativeDays(base.mRepresentativeDays->days.size());
+	}
+}
+
+Simulator::Simulator(const Simulator& base, TaskConfig config, std::shared_ptr<const CostEngine> costEngine):
+	mSiteDataPtr(base.mSiteDataPtr),
+	mSiteData(*mSiteDataPtr),
+	mConfig(std::move(config)),
+	// only the costs differ, so everything that the timesteps depend on is shared
+	mTariffStats(base.mTariffStats),
+	mImportTariffs(base.mImportTariffs),
+	mHeatPumpLookup(base.mHeatPumpLookup),
+	mAmbientHeatPumpProfile(base.mAmbientHeatPumpProfile),
+	mHotRoomProfiles(base.mHotRoomProfiles),
+	mCostEngine(costEngine ? std::move(costEngine) : std::make_shared<const CostEngine>(mSiteData, mConfig)),
+	mTimestamps(base.mTimestamps),
+	mParallelESSPool(base.mParallelESSPool),
+	mLowLatencyPool(base.mLowLatencyPool),
+	mBatchBackend(base.mBatchBackend),
+	mResolutions(std::make_shared<Resolutions>()),
+	mCostModel(base.mCostModel),
+	mExecutionPlans(base.mExecutionPlans)
+{
+	// each member differs from base's only in its costs, so shares that member's SiteData and profiles
+	// (and this Simulator's CostEngine, just as the members of base share its CostEngine)
+	for (const auto& member : base.mEnsemble) {
+		mEnsemble.push_back(std::shared_ptr<const Simulator>(new Simulator(*member, mConfig, mCostEngine)));
+	}
+}
+
+void Simulator::buildEnsemble() {
+	if (!mSiteData.ensemble.empty()) {
+		mSiteData.ensemble.validate(static_cast<Eigen::Index>(mSiteData.timesteps), mSiteData.solar_yields.size());
+		for (size_t m = 0; m < mSiteData.ensemble.members(); m++) {
+			mEnsemble.push_back(std::shared_ptr<const Simulator>(new Simulator(*this, m)));
+		}
+	}
+}
+
+std::shared_ptr<Simulator> Simulator::withSiteUpdate(const SiteUpdate& update) const {
+	TraceScope trace{ "withSiteUpdate", "simulator" };
+	auto siteData = std::make_shared<const SiteData>(applySiteUpdate(mSiteData, update));
+	return std::shared_ptr<Simulator>(new Simulator(*this, std::move(siteData), update));
+}
+
+std::shared_ptr<const TimestampIndex> Simulator::getTimestamps() const {
+	std::call_once(mTimestamps->once, [this] {
+		mTimestamps->index = std::make_shared<const TimestampIndex>(makeTimestampIndex(mSiteData));
+	});
+	return mTimestamps->index;
+}
+
+const SimulatorBaseline& Simulator::baseline() const {
+	std::call_once(mBaseline->once, [this] {
+		std::optional<ScenarioKey> cacheKey;
+		std::optional<SimulatorBaseline> cached;
+		if (mBaselineCacheDirectory) {
+			cacheKey = baselineCacheKey(mSiteData, mConfig);
+			cached = loadCachedBaseline(*mBaselineCacheDirectory, *cacheKey, mSiteData.timesteps);
+		}
+
+		if (cached) {
+			mBaseline->baseline = std::move(*cached);
+		}
+		else {
+			mBaseline->baseline = simulateBaseline(mBaseline->totals.emplace());
+			if (cacheKey) {
+				storeCachedBaseline(*mBaselineCacheDirectory, *cacheKey, mBaseline->baseline);
+			}
+		}
+		mBaseline->ready.store(true, std::memory_order_release);
+	});
+	return mBaseline->baseline;
+}
+
+SimulatorBaseline Simulator::simulateBaseline(SimulationTotals& baselineTotals) const {
+	TraceScope trace{ "simulateBaseline", "simulator" };
+	auto baselineReportData = std::make_shared<ReportData>();
+	baselineTotals = simulateTimesteps(mSiteData.baseline, baselineReportData.get());
+	// this is shared by every FullReporting result, so only keep the columns the baseline uses
+	baselineReportData->shrinkToPopulated();
+
+	SimulatorBaseline baseline{};
+	baseline.reportData = std::move(baselineReportData);
+	calculateBaseline(baselineTotals, baseline);
+	return baseline;
+}
+
+void Simulator::calculateBaseline(const SimulationTotals& baselineTotals, SimulatorBaseline& baseline) const {
+	baseline.usage = calculateBaselineUsage(mSiteData, mConfig, baselineTotals);
+
+	// the baseline is costed without any funding
+	const auto baselineComponents = make_component_views(mSiteData.baseline, mCostEngine->componentCosts(mSiteData.baseline));
+	baseline.metrics = calculateMetrics(mSiteData.baseline, baselineTotals, baseline.usage, baselineComponents);
+}
+
+void Simulator::setBaseline(const SimulationTotals& baselineTotals, std::shared_ptr<const ReportData> reportData) {
+	std::call_once(mBaseline->once, [&] {
+		calculateBaseline(baselineTotals, mBaseline->baseline);
+		mBaseline->baseline.reportData = std::move(reportData);
+		mBaseline->totals = baselineTotals;
+		mBaseline->ready.store(true, std::memory_order_release);
+	});
+}
+
+void Simulator::enableBaselineCache(std::filesystem::path directory) {
+	mBaselineCacheDirectory = std::move(directory);
+}
+
+std::vector<std::shared_ptr<const DayTariffStats>> Simulator::sharedTariffStats(const SiteData& siteData) {
+	// these only depend on the SiteData, so are shared by every scenario (and every site with the same tariff)
+	std::vector<std::shared_ptr<const DayTariffStats>> tariffStats;
+	tariffStats.reserve(siteData.import_tariffs.size());
+	for (size_t i = 0; i < siteData.import_tariffs.size(); i++) {
+		const TariffStatsKey key{ SeriesIdentity(siteData.import_tariffs[i]), SeriesIdentity(siteData.grid_co2), siteData.timestep_hours };
+		tariffStats.push_back(tariffStatsCache().get(key, [&] { return DayTariffStats(siteData, i); }));
+	}
+	return tariffStats;
+}
+
+std::shared_ptr<const TariffPricing> Simulator::sharedImportTariffs(const SiteData& siteData) {
+	ImportTariffsKey key;
+	for (const SiteSeries& tariff : siteData.import_tariffs) {
+		key.tariffs.emplace_back(tariff);
+	}
+	return importTariffsCache().get(key, [&] { return TariffPricing(siteData); });
+}
+
+std::shared_ptr<const HeatPumpProfile> Simulator::sharedAmbientHeatPumpProfile(const SiteData& siteData, const ASHPLookup& reference) {
+	const AmbientProfileKey key{ SeriesIdentity(siteData.air_temperature), siteData.ashp_input_table, siteData.ashp_output_table };
+	return ambientProfileCache().get(key, [&] { return makeAmbientHeatPumpProfile(siteData, reference); });
+}
+
+
+SimulationResult Simulator::simulateScenario(const TaskData& taskData, SimulationType simulationType, const ScenarioConstraints& constraints) const {
+	return runScenario(taskData, simulationType, ReportColumnMask::all(), constraints);
+}
+
+SimulationResult Simulator::runScenario(const TaskData& taskData, SimulationType simulationType, ReportColumnMask columns,
+	const ScenarioConstraints& constraints) const {
+	if (constraints.empty()) {
+		return runScenario(taskData, simulationType, columns);
+	}
+
+	auto start = std::chrono::high_resolution_clock::now();
+	std::optional<SimulationResult> violation;
+	try {
+		violation = checkConstraints(taskData, constraints);
+	}
+	catch (const std::runtime_error& e) {
+		// leave the full simulation to report an invalid scenario
+		spdlog::debug("Could not check the constraints of a scenario: {}", e.what());
+	}
+
+	if (!violation) {
+		if (simulationType == SimulationType::ResultOnly && constraints.limitsShortfall()) {
+			return runWithShortfallLimits(taskData, constraints);
+		}
+		return runScenario(taskData, simulationType, columns);
+	}
+
+	std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+	violation->runtime = static_cast<float>(elapsed.count());
+	return *violation;
+}
+
+SimulationResult Simulator::runWithShortfallLimits(const TaskData& taskData, const ScenarioConstraints& constraints) const {
+	TraceScope trace{ "simulateScenario", "scenario" };
+	auto start = std::chrono::high_resolution_clock::now();
+	auto elapsed = [&start]() {
+		std::chrono::duration<double> duration = std::chrono::high_resolution_clock::now() - start;
+		return static_cast<float>(duration.count());
+	};
+
+	SimulationResult result{};
+	if (mResultCache && mResultCache->lookup(taskData, result)) {
+		// (a cached result is always of a whole simulation)
+		result.baseline_metrics = baseline().metrics;
+		result.runtime = elapsed();
+		return result;
+	}
+
+	PhaseTimings* timings = PHASE_TIMING_ENABLED ? &result.timings.emplace() : nullptr;
+
+	ScenarioError errors;
+	{
+		ScopedPhaseTimer timer{ timings, &PhaseTimings::validation };
+		errors = checkScenario(taskData);
+	}
+	if (errors != ScenarioError::None) {
+		warnInvalidScenario("Invalid scenario", taskData, errors);
+		return makeInvalidResult(taskData);
+	}
+
+	ScenarioState state(taskData, mExecutionPlans->get(taskData));
+	prepareBalancing(taskData, nullptr, timings, state);
+
+	const PostBalancing postBalancing(mSiteData, taskData, state.plan.deferredWaterHeater);
+	const TempSum& tempSum = *state.tempSum;
+	const auto timesteps = static_cast<Eigen::Index>(mSiteData.timesteps);
+
+	// Only the gas heater and a data centre's heatpump meet heat after this point, so without them the heat shortfall is known.
+	// The import shortfall is bounded by how much the ESS could discharge in each timestep (and the hot water a data centre's heatpump could meet)
+	double heatShortfall = 0.0;
+	if (constraints.max_heat_shortfall && !state.plan.gasHeater && state.plan.dataCentre != ExecutionPlan::DataCentreKind::WITH_ASHP) {
+		heatShortfall = postBalancing.heatShortfall(tempSum);
+	}
+	double importShortfall = 0.0;
+	if (constraints.max_electrical_shortfall) {
+		const LoopSlack slack{
+			state.ess ? state.ess->getBattery().getDischargeMax_e() : 0.0f,
+			state.plan.dataCentre == ExecutionPlan::DataCentreKind::WITH_ASHP
+		};
+		importShortfall = postBalancing.importShortfall(tempSum, 0, timesteps, slack);
+	}
+
+	bool exceeded = exceedsLimit(constraints.max_heat_shortfall, heatShortfall)
+		|| exceedsLimit(constraints.max_electrical_shortfall, importShortfall);
+
+	if (!exceeded) {
+		ScopedPhaseTimer timer{ timings, &PhaseTimings::balancing_loop };
+		TraceScope loopTrace{ "balancing_loop", "scenario" };
+		if (constraints.max_electrical_shortfall && state.ess) {
+			// The ESS carries its charge from one timestep to the next, so the loop can be run a range at a time,
+			// stopping once the shortfall of the timesteps balanced so far is over the limit
+			importShortfall = 0.0;
+			for (size_t begin = 0; begin < mSiteData.timesteps && !exceeded; begin += SHORTFALL_CHECK_TIMESTEPS) {
+				const size_t end = std::min(begin + SHORTFALL_CHECK_TIMESTEPS, mSiteData.timesteps);
+				state.balance(begin, end);
+				importShortfall += postBalancing.importShortfall(tempSum, static_cast<Eigen::Index>(begin), static_cast<Eigen::Index>(end - begin));
+				exceeded = exceedsLimit(constraints.max_electrical_shortfall, importShortfall);
+			}
+		}
+		else {
+			state.balance(0, mSiteData.timesteps);
+		}
+	}
+
+	if (exceeded) {
+		result = makeInvalidResult(taskData);
+		result.baseline_metrics = baseline().metrics;
+		CapexBreakdown capex = mCostEngine->evaluate(taskData).capex;
+		result.metrics.total_capex = capex.total_capex;
+		result.scenario_capex_breakdown = std::move(capex);
+		result.metrics.total_electrical_shortfall = static_cast<float>(importShortfall);
+		result.metrics.total_heat_shortfall = static_cast<float>(heatShortfall);
+		result.violates_constraints = true;
+		result.terminated_early = true;
+		result.runtime = elapsed();
+		return result;
+	}
+
+	const SimulationTotals totals = finishTimesteps(taskData, nullptr, timings, nullptr, state);
+	completeResult(result, taskData, totals, timings);
+	result.runtime = elapsed();
+
+	if (mResultCache) {
+		mResultCache->insert(taskData, result);
+	}
+	return result;
+}
+
+SimulationResult Simulator::simulateScenario(const TaskData& taskData, SimulationType simulationType) const {
+	return runScenario(taskData, simulationType, ReportColumnMask::all());
+}
+
+SimulationResult Simulator::simulateScenario(const TaskData& taskData, ReportColumnMask columns, const ScenarioConstraints& constraints) const {
+	return runScenario(taskData, SimulationType::FullReporting, columns, constraints);
+}
+
+std::shared_ptr<const ReportData> Simulator::baselineReportData(ReportColumnMask columns) const {
+	const std::shared_ptr<const ReportData>& baselineReport = baseline().reportData;
+	if (columns == ReportColumnMask::all()) {
+		return baselineReport;
+	}
+	auto reportData = std::make_shared<ReportData>(columns);
+	for (ReportColumn column : baselineReport->populatedColumns()) {
+		reportData->set(column, baselineReport->get(column));
+	}
+	reportData->shrinkToPopulated();
+	return reportData;
+}
+
+SimulationResult Simulator::runScenario(const TaskData& taskData, SimulationType simulationType, ReportColumnMask columns) const {
+	TraceScope trace{ "simulateScenario", "scenario" };
+
+	if (simulationType == SimulationType::RepresentativeDays) {
+		return simulateRepresentativeDays(taskData);
+	}
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	SimulationResult result{};
+
+	// FullReporting needs the timeseries, which are not cached
+	const bool useCache = mResultCache && simulationType == SimulationType::ResultOnly;
+	if (useCache && mResultCache->lookup(taskData, result)) {
+		result.baseline_metrics = baseline().metrics;
+		std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+		result.runtime = static_cast<float>(elapsed.count());
+		return result;
+	}
+
+	PhaseTimings* timings = PHASE_TIMING_ENABLED ? &result.timings.emplace() : nullptr;
+
+	ScenarioError errors;
+	{
+		ScopedPhaseTimer timer{ timings, &PhaseTimings::validation };
+		errors = checkScenario(taskData);
+	}
+	if (errors != ScenarioError::None) {
+		warnInvalidScenario("Invalid scenario", taskData, errors);
+		return makeInvalidResult(taskData);
+	}
+
+	SimulationTotals totals{};
+	if (simulationType == SimulationType::FullReporting) {
+		// We only build the full timeseries vectors in FullReporting mode
+		result.report_data = ReportData{ columns };
+		totals = simulateTimesteps(taskData, &result.report_data.value(), timings);
+		result.report_data->shrinkToPopulated();
+		result.baseline_report_data = baselineReportData(columns);
+	}
+	else {
+		totals = simulateTimesteps(taskData, nullptr, timings);
+	}
+
+	completeResult(result, taskData, totals, timings);
+	
+	// calculate elaspsed run time
+	auto end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> elapsed = end - start;
+	float runtime = static_cast<float>(elapsed.count());
+
+	result.runtime = runtime;
+
+	if (mResultCache) {
+		mResultCache->insert(taskData, result);
+	}
+
+	return result;
+}
+
+std::vector<SimulationResult> Simulator::simulateBatch(std::span<const TaskData> taskData, SimulationType simulationType) const {
+	return simulateBatch(taskData, simulationType, ThreadPool::shared());
+}
+
+std::vector<SimulationResult> Simulator::simulateBatch(std::span<const TaskData> taskData, SimulationType simulationType, ThreadPool& pool) const {
+	return runBatch(taskData, simulationType, ScenarioConstraints{}, nullptr, pool);
+}
+
+std::vector<SimulationResult> Simulator::runBatch(std::span<const TaskData> taskData, SimulationType simulationType,
+	const ScenarioConstraints& constraints, BatchControl* control, ThreadPool& pool) const {
+	TraceScope trace{ "simulateBatch", "batch" };
+	std::vector<SimulationResult> results(taskData.size());
+	if (control) {
+		control->addTotal(taskData.size());
+	}
+
+	// whether to skip the scenarios of a job, because the batch has been stopped
+	auto skip = [&](std::span<const size_t> job) {
+		if (!control || !control->stopRequested()) {
+			return false;
+		}
+		for (size_t i : job) {
+			results[i] = makeCancelledResult(taskData[i]);
+		}
+		control->addSkipped(job.size());
+		return true;
+	};
+
+	// the scenarios are grouped by the state they share (the order of a population is random),
+	// so that each thread runs scenarios that read the same columns one after another
+	const bool lockstep = simulationType == SimulationType::ResultOnly && constraints.empty();
+	const BatchPlan plan = planBatch(taskData, lockstep);
+
+	// the scenarios differ in cost by an order of magnitude, so start the longest first to avoid a long tail
+	std::vector<float> costs(plan.jobs.size(), 0.0f);
+	for (size_t j = 0; j < plan.jobs.size(); j++) {
+		for (size_t i : plan.jobs[j]) {
+			costs[j] += estimateRuntime(taskData[i]);
+		}
+	}
+
+	if (!lockstep) {
+		// each scenario writes to its own slot so no further synchronisation is needed
+		pool.parallelForByCost(costs, plan.affinity, [&](size_t j) {
+			const size_t i = plan.jobs[j].front();
+			if (skip(plan.jobs[j])) {
+				return;
+			}
+			results[i] = simulateScenario(taskData[i], simulationType, constraints);
+			if (simulationType == SimulationType::ResultOnly) {
+				observeRuntime(taskData[i], results[i]);
+			}
+			if (control) {
+				control->addCompleted();
+			}
+		});
+		return results;
+	}
+
+	if (mBatchBackend) {
+		// the groups are balanced by the backend, and the lone scenarios run as before
+		std::vector<std::vector<size_t>> groups;
+		std::vector<float> loneCosts;
+		std::vector<size_t> lone, loneAffinity;
+		for (size_t j = 0; j < plan.jobs.size(); j++) {
+			if (plan.jobs[j].size() > 1) {
+				groups.push_back(plan.jobs[j]);
+			}
+			else {
+				lone.push_back(plan.jobs[j].front());
+				loneCosts.push_back(costs[j]);
+				loneAffinity.push_back(plan.affinity[j]);
+			}
+		}
+
+		runBackendJobs(taskData, groups, results, control, pool);
+
+		pool.parallelForByCost(loneCosts, loneAffinity, [&](size_t j) {
+			const size_t i = lone[j];
+			if (skip(std::span<const size_t>(&lone[j], 1))) {
+				return;
+			}
+			results[i] = simulateScenario(taskData[i], simulationType);
+			observeRuntime(taskData[i], results[i]);
+			if (control) {
+				control->addCompleted();
+			}
+		});
+		return results;
+	}
+
+	// each job is either a single scenario or a group to balance in lock-step
+	pool.parallelForByCost(costs, plan.affinity, [&](size_t j) {
+		const auto& job = plan.jobs[j];
+		if (skip(job)) {
+			return;
+		}
+		if (job.size() == 1) {
+			// a lone scenario isn't worth the lock-step loop
+			results[job.front()] = simulateScenario(taskData[job.front()], simulationType);
+		}
+		else {
+			simulateLockstep(taskData, job, results);
+		}
+		for (size_t i : job) {
+			observeRuntime(taskData[i], results[i]);
+		}
+		if (control) {
+			control->addCompleted(job.size());
+		}
+	});
+
+	return results;
+}
+
+void Simulator::simulateLockstep(std::span<const TaskData> taskData, std::span<const size_t> indices, std::span<SimulationResult> results,
+	const std::shared_ptr<const PreBalancingSnapshot>& snapshot) const {
+	TraceScope trace{ "simulateLockstep", "scenario" };
+
+	LockstepGroup group;
+	prepareLockstep(taskData, indices, results, group, snapshot);
+	if (group.lanes.empty()) {
+		return;
+	}
+
+	auto loopStart = std::chrono::steady_clock::now();
+	runLockstepBalancingLoop(group.lanes, mSiteData.timesteps);
+	const auto loopEnd = std::chrono::steady_clock::now();
+	std::chrono::duration<float> loopElapsed = loopEnd - loopStart;
+	if (TRACING_ENABLED && Tracer::active()) {
+		Tracer::record("lockstep_balancing_loop", "scenario", loopStart, loopEnd);
+	}
+
+	finishLockstep(taskData, results, group, loopElapsed.count());
+}
+
+void Simulator::prepareLockstep(std::span<const TaskData> taskData, std::span<const size_t> indices, std::span<SimulationResult> results,
+	LockstepGroup& group, const std::shared_ptr<const PreBalancingSnapshot>& snapshot) const {
+	group.start = std::chrono::high_resolution_clock::now();
+
+	for (size_t index : indices) {
+		const TaskData& scenario = taskData[index];
+		SimulationResult& result = results[index];
+		result = SimulationResult{};
+
+		if (mResultCache && mResultCache->lookup(scenario, result)) {
+			result.baseline_metrics = baseline().metrics;
+			std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - group.start;
+			result.runtime = static_cast<float>(elapsed.count());
+			continue;
+		}
+
+		PhaseTimings* timings = PHASE_TIMING_ENABLED ? &result.timings.emplace() : nullptr;
+
+		ScenarioError errors;
+		{
+			ScopedPhaseTimer timer{ timings, &PhaseTimings::validation };
+			errors = checkScenario(scenario);
+		}
+		if (errors != ScenarioError::None) {
+			warnInvalidScenario("Invalid scenario", scenario, errors);
+			result = makeInvalidResult(scenario);
+			continue;
+		}
+
+		auto& state = group.states.emplace_back(std::make_unique<ScenarioState>(scenario, mExecutionPlans->get(scenario)));
+		state->snapshot = snapshot;
+		prepareBalancing(scenario, nullptr, timings, *state);
+		group.lanes.push_back({ &state->tempSum.value(), state->availableGridImport, state->balancingESS(), state->balancingEV() });
+		group.simulated.push_back(index);
+	}
+}
+
+void Simulator::finishLockstep(std::span<const TaskData> taskData, std::span<SimulationResult> results, LockstepGroup& group,
+	float share) const {
+	const float lanes_f = static_cast<float>(group.lanes.size());
+
+	for (size_t l = 0; l < group.lanes.size(); l++) {
+		const TaskData& scenario = taskData[group.simulated[l]];
+		SimulationResult& result = results[group.simulated[l]];
+		PhaseTimings* timings = result.timings ? &result.timings.value() : nullptr;
+		if (timings) {
+			// each scenario is attributed an equal share of the loop
+			timings->balancing_loop += share / lanes_f;
+		}
+
+		SimulationTotals totals = finishTimesteps(scenario, nullptr, timings, nullptr, *group.states[l]);
+		completeResult(result, scenario, totals, timings);
+	}
+
+	std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - group.start;
+	const float runtime = static_cast<float>(elapsed.count()) / lanes_f;
+	for (size_t index : group.simulated) {
+		results[index].runtime = runtime;
+		if (mResultCache) {
+			mResultCache->insert(taskData[index], results[index]);
+		}
+	}
+}
+
+void Simulator::runBackendJobs(std::span<const TaskData> taskData, std::span<const std::vector<size_t>> jobs,
+	std::span<SimulationResult> results, BatchControl* control, ThreadPool& pool,
+	const std::shared_ptr<const PreBalancingSnapshot>& snapshot) const {
+	const size_t maxLanes = mBatchBackend->maxLanes();
+
+	size_t first = 0;
+	while (first < jobs.size()) {
+		// a wave of whole groups, with at most maxLanes scenarios (unless one group has more)
+		size_t last = first;
+		size_t waveLanes = 0;
+		while (last < jobs.size() && (last == first || waveLanes + jobs[last].size() <= maxLanes)) {
+			waveLanes += jobs[last].size();
+			last++;
+		}
+		const auto wave = jobs.subspan(first, last - first);
+		first = last;
+
+		if (control && control->stopRequested()) {
+			for (const auto& job : wave) {
+				for (size_t i : job) {
+					results[i] = makeCancelledResult(taskData[i]);
+				}
+				control->addSkipped(job.size());
+			}
+			continue;
+		}
+
+		std::vector<LockstepGroup> groups(wave.size());
+		pool.parallelFor(wave.size(), [&](size_t g) {
+			prepareLockstep(taskData, wave[g], results, groups[g], snapshot);
+		});
+
+		// the backend balances every lane with the same components together
+		// (indexed by ESS + 2 * EV, where a lane with neither has nothing to balance)
+		std::array<std::vector<LockstepLane>, 4> byComponents;
+		for (const LockstepGroup& group : groups) {
+			for (const LockstepLane& lane : group.lanes) {
+				byComponents[(lane.ess ? 1 : 0) + (lane.ev ? 2 : 0)].push_back(lane);
+			}
+		}
+		byComponents[0].clear();
+
+		auto loopStart = std::chrono::steady_clock::now();
+		for (const auto& lanes : byComponents) {
+			for (size_t l = 0; l < lanes.size(); l += maxLanes) {
+				mBatchBackend->balance(std::span(lanes).subspan(l, std::min(maxLanes, lanes.size() - l)), mSiteData.timesteps, pool);
+			}
+		}
+		const auto loopEnd = std::chrono::steady_clock::now();
+		std::chrono::duration<float> loopElapsed = loopEnd - loopStart;
+		if (TRACING_ENABLED && Tracer::active()) {
+			Tracer::record("backend_balancing_loop", "batch", loopStart, loopEnd);
+		}
+
+		// each group is attributed its share of the wave's balancing
+		const float perLane = waveLanes > 0 ? loopElapsed.count() / static_cast<float>(waveLanes) : 0.0f;
+		pool.parallelFor(wave.size(), [&](size_t g) {
+			LockstepGroup& group = groups[g];
+			if (!group.lanes.empty()) {
+				finishLockstep(taskData, results, group, perLane * static_cast<float>(group.lanes.size()));
+			}
+			for (size_t i : wave[g]) {
+				observeRuntime(taskData[i], results[i]);
+			}
+			if (control) {
+				control->addCompleted(wave[g].size());
+			}
+		});
+	}
+}
+
+std::vector<SimulationResult> Simulator::simulateBatch(std::span<const TaskData> taskData, SimulationType simulationType,
+	const ScenarioConstraints& constraints, ThreadPool& pool) const {
+	return runBatch(taskData, simulationType, constraints, nullptr, pool);
+}
+
+std::vector<SimulationResult> Simulator::simulateBatch(std::span<const TaskData> taskData, SimulationType simulationType,
+	const ScenarioConstraints& constraints, BatchControl& control, ThreadPool& pool) const {
+	return runBatch(taskData, simulationType, constraints, &control, pool);
+}
+
+std::optional<SimulationResult> Simulator::checkConstraints(const TaskData& taskData, const ScenarioConstraints& constraints) const {
+	validateScenario(taskData);
+
+	CapexBreakdown capex = mCostEngine->evaluate(taskData).capex;
+	const bool tooLow = constraints.min_capex && capex.total_capex < *constraints.min_capex;
+	const bool tooHigh = constraints.max_capex && capex.total_capex > *constraints.max_capex;
+	if (!tooLow && !tooHigh) {
+		return std::nullopt;
+	}
+
+	SimulationResult result = makeInvalidResult(taskData);
+	result.baseline_metrics = baseline().metrics;
+	result.metrics.total_capex = capex.total_capex;
+	result.scenario_capex_breakdown = std::move(capex);
+	result.violates_constraints = true;
+	return result;
+}
+
+void Simulator::enableResultCache(size_t byteBudget) {
+	mResultCache = std::make_shared<ResultCache>(byteBudget);
+}
+
+std::optional<CacheStats> Simulator::getResultCacheStats() const {
+	if (!mResultCache) {
+		return std::nullopt;
+	}
+	return mResultCache->stats();
+}
+
+void Simulator::clearResultCache() {
+	if (mResultCache) {
+		mResultCache->clear();
+	}
+}
+
+CacheStats Simulator::getCostMemoStats() const {
+	return mCostEngine->memoStats();
+}
+
+float Simulator::estimateRuntime(const TaskData& taskData) const {
+	return mCostModel->estimate(taskData);
+}
+
+void Simulator::observeRuntime(const TaskData& taskData, const SimulationResult& result) const {
+	if (!result.violates_constraints && !result.cancelled) {
+		mCostModel->observe(taskData, result.runtime);
+	}
+}
+
+size_t Simulator::memoryFootprint() const {
+	return memoryBreakdown().total();
+}
+
+MemoryFootprint Simulator::memoryBreakdown() const {
+	MemorySeen seen;
+	return memoryBreakdown(seen);
+}
+
+MemoryFootprint Simulator::memoryBreakdown(MemorySeen& seen) const {
+	MemoryFootprint footprint;
+	if (seen.first(mSiteDataPtr.get())) {
+		footprint.add("site_data.", mSiteData.memoryBreakdown(&seen));
+	}
+
+	size_t tariffStatsBytes = 0;
+	for (const auto& stats : mTariffStats) {
+		if (seen.first(stats.get())) {
+			tariffStatsBytes += stats->ownedBytes();
+		}
+	}
+	footprint.add("tariff_stats", tariffStatsBytes);
+	footprint.add("import_tariff_pricing", seen.first(mImportTariffs.get()) ? mImportTariffs->ownedBytes() : 0);
+	footprint.add("heat_pump_lookup", mHeatPumpLookup.ownedBytes());
+	footprint.add("ambient_heat_pump_profile", seen.first(mAmbientHeatPumpProfile.get())
+		? sizeof(float) * static_cast<size_t>(mAmbientHeatPumpProfile->heat_h.size() + mAmbientHeatPumpProfile->load_e.size()) : 0);
+	footprint.add("hotroom_profiles", seen.first(mHotRoomProfiles.get()) ? mHotRoomProfiles->ownedBytes() : 0);
+	// (without simulating the baseline if it hasn't been yet)
+	const ReportData* baselineReport = hasBaseline() ? mBaseline->baseline.reportData.get() : nullptr;
+	footprint.add("baseline_report_data", baselineReport && seen.first(baselineReport) ? baselineReport->ownedBytes() : 0);
+
+	footprint.add("cost_memo", seen.first(mCostEngine.get()) ? mCostEngine->memoStats().bytes : 0);
+	footprint.add("result_cache", seen.first(mResultCache.get()) ? mResultCache->stats().bytes : 0);
+	footprint.add("pre_balancing_cache", seen.first(mPreBalancingCache.get()) ? mPreBalancingCache->stats().bytes : 0);
+
+	size_t representativeDayBytes = 0;
+	for (const auto& day : mRepresentativeDaySimulators) {
+		for (const auto& simulator : { day.simulator, day.warmUp }) {
+			if (seen.first(simulator.get())) {
+				representativeDayBytes += simulator->memoryBreakdown(seen).total();
+			}
+		}
+	}
+	footprint.add("representative_days", representativeDayBytes);
+
+	size_t ensembleBytes = 0;
+	for (const auto& member : mEnsemble) {
+		if (seen.first(member.get())) {
+			ensembleBytes += member->memoryBreakdown(seen).total();
+		}
+	}
+	footprint.add("ensemble", ensembleBytes);
+
+	size_t resolutionBytes = 0;
+	if (mResolutions) {
+		std::lock_guard<std::mutex> lock(mResolutions->mutex);
+		for (const auto& [interval, simulator] : mResolutions->simulators) {
+			if (seen.first(simulator.get())) {
+				resolutionBytes += simulator->memoryBreakdown(seen).total();
+			}
+		}
+	}
+	footprint.add("resolutions", resolutionBytes);
+
+	size_t configBytes = 0;
+	{
+		std::lock_guard<std::mutex> lock(mConfigs->mutex);
+		for (const auto& [config, simulator] : mConfigs->simulators) {
+			if (seen.first(simulator.get())) {
+				configBytes += simulator->memoryBreakdown(seen).total();
+			}
+		}
+	}
+	footprint.add("configs", configBytes);
+	return footprint;
+}
+
+void Simulator::enablePreBalancingCache(size_t byteBudget) {
+	mPreBalancingCache = std::make_shared<PreBalancingCache>(byteBudget);
+}
+
+std::optional<CacheStats> Simulator::getPreBalancingCacheStats() const {
+	if (!mPreBalancingCache) {
+		return std::nullopt;
+	}
+	return mPreBalancingCache->stats();
+}
+
+void Simulator::clearPreBalancingCache() {
+	if (mPreBalancingCache) {
+		mPreBalancingCache->clear();
+	}
+}
+
+void Simulator::enableBatchBackend(std::shared_ptr<BatchBackend> backend) {
+	if (!backend) {
+		throw std::invalid_argument("enableBatchBackend requires a backend (use disableBatchBackend to remove one)");
+	}
+	mBatchBackend = std::move(backend);
+}
 
-Simulator::Simulator(SiteData siteData, TaskConfig config):
-	mSiteData(siteData),
-	mConfig(config)
-{
+void Simulator::enableRepresentativeDays(size_t numDays) {
+	RepresentativeDays representative = selectRepresentativeDays(mSiteData, numDays);
+
+	std::vector<RepresentativeDay> simulators;
+	simulators.reserve(representative.days.size());
+	const size_t dayLength = representative.timestepsPerDay;
+	for (size_t i = 0; i < representative.days.size(); i++) {
+		const size_t day = representative.days[i];
+		if (day == 0) {
+			simulators.push_back({ std::make_shared<const Simulator>(sliceSiteData(mSiteData, 0, dayLength), mConfig),
+				nullptr, representative.weights[i] });
+		}
+		else {
+			const size_t warmUpStart = (day - 1) * dayLength;
+			simulators.push_back({
+				std::make_shared<const Simulator>(sliceSiteData(mSiteData, warmUpStart, 2 * dayLength), mConfig),
+				std::make_shared<const Simulator>(sliceSiteData(mSiteData, warmUpStart, dayLength), mConfig),
+				representative.weights[i] });
+		}
+	}
 
-	mBaselineReportData = simulateTimesteps(mSiteData.baseline);
-	CostVectors baselineCostVectors = extractCostVectors(mBaselineReportData, mSiteData.baseline);
-	mBaselineUsage = calculateBaselineUsage(mSiteData, mConfig, baselineCostVectors);
+	mRepresentativeDays = std::move(representative);
+	mRepresentativeDaySimulators = std::move(simulators);
+}
 
-	mBaselineMetrics = calculateMetrics(mSiteData.baseline, mBaselineReportData, mBaselineUsage);
+std::optional<RepresentativeDays> Simulator::getRepresentativeDays() const {
+	return mRepresentativeDays;
 }
 
-SimulationResult Simulator::simulateScenario(const TaskData& taskData, SimulationType simulationType) const {
+SimulationResult Simulator::simulateRepresentativeDays(const TaskData& taskData) const {
+	if (!mRepresentativeDays) {
+		throw std::runtime_error("Representative days must be enabled before simulating with them");
+	}
 
 	auto start = std::chrono::high_resolution_clock::now();
 
-	try {
-		validateScenario(taskData);
-	}
-	catch (const std::runtime_error& e) {
-		spdlog::warn("Invalid scenario: {}", e.what());
+	if (const ScenarioError errors = checkScenario(taskData); errors != ScenarioError::None) {
+		warnInvalidScenario("Invalid scenario", taskData, errors);
 		return makeInvalidResult(taskData);
 	}
 
+	SimulationTotals totals{};
+	for (const auto& day : mRepresentativeDaySimulators) {
+		addWeightedTotals(totals, day.simulator->simulateTimesteps(taskData, nullptr), day.weight);
+		if (day.warmUp) {
+			addWeightedTotals(totals, day.warmUp->simulateTimesteps(taskData, nullptr), -day.weight);
+		}
+	}
+
 	SimulationResult result{};
+	completeResult(result, taskData, totals, nullptr);
 
-	result.report_data = simulateTimesteps(taskData, simulationType);
+	std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+	result.runtime = static_cast<float>(elapsed.count());
+	return result;
+}
 
-	const CostVectors& costVectors = extractCostVectors(result.report_data.value(), taskData);
+std::vector<RepresentativeDaysError> Simulator::representativeDaysError(std::span<const TaskData> sample) const {
+	auto full = simulateBatch(sample, SimulationType::ResultOnly);
+	auto reduced = simulateBatch(sample, SimulationType::RepresentativeDays);
+	ResultTable fullTable = resultsToTable(full);
+	ResultTable reducedTable = resultsToTable(reduced);
+
+	const auto& columns = resultColumns();
+	std::vector<RepresentativeDaysError> errors;
+	errors.reserve(columns.size());
+	for (size_t c = 0; c < columns.size(); c++) {
+		RepresentativeDaysError error{ columns[c].name, 0.0, 0.0 };
+		for (Eigen::Index row = 0; row < fullTable.rows(); row++) {
+			double expected = fullTable(row, static_cast<Eigen::Index>(c));
+			double absolute = std::abs(reducedTable(row, static_cast<Eigen::Index>(c)) - expected);
+			// (a missing environmental_impact_score is NaN in both)
+			if (std::isnan(absolute)) {
+				continue;
+			}
+			error.max_absolute_error = std::max(error.max_absolute_error, absolute);
+			if (absolute > 0.0) {
+				double relative = expected != 0.0 ? absolute / std::abs(expected) : std::numeric_limits<double>::infinity();
+				error.max_relative_error = std::max(error.max_relative_error, relative);
+			}
+		}
+		errors.push_back(error);
+	}
+	return errors;
+}
 
-	auto scenarioUsage = calculateScenarioUsage(mSiteData, mConfig, taskData, costVectors);
+EnsembleResult Simulator::simulateEnsemble(const TaskData& taskData, ThreadPool& pool) const {
+	return runEnsemble(taskData, nullptr, pool);
+}
 
-	result.baseline_metrics = mBaselineMetrics;
-	result.metrics = calculateMetrics(taskData, result.report_data.value(), scenarioUsage);
-	result.comparison = compareScenarios(mSiteData, mBaselineUsage, result.baseline_metrics, scenarioUsage, result.metrics);
-	result.scenario_capex_breakdown = calculateCapexWithDiscounts(taskData);;
+EnsembleResult Simulator::simulateEnsemble(const TaskData& taskData, BatchControl& control, ThreadPool& pool) const {
+	return runEnsemble(taskData, &control, pool);
+}
 
+EnsembleResult Simulator::runEnsemble(const TaskData& taskData, BatchControl* control, ThreadPool& pool) const {
+	if (mEnsemble.empty()) {
+		throw std::runtime_error("Cannot simulate an ensemble with a SiteData that has no ensemble");
+	}
+	validateScenario(taskData);
 
-	if (simulationType != SimulationType::FullReporting) {
-		// We only return the full timeseries vectors in FullReporting mode
-		result.report_data = std::nullopt;
-		result.baseline_report_data = std::nullopt;
+	EnsembleResult ensemble{};
+	ensemble.objectives.resize(static_cast<Eigen::Index>(NUM_OBJECTIVE_FIELDS), static_cast<Eigen::Index>(mEnsemble.size()));
+	std::vector<uint8_t> simulated(mEnsemble.size(), 0);
+	if (control) {
+		control->addTotal(mEnsemble.size());
 	}
-	else {
-		// if FullReporting, also set the baseline report data
-		result.baseline_report_data = mBaselineReportData;
+
+	// each member writes to its own column so no further synchronisation is needed
+	pool.parallelFor(mEnsemble.size(), [&](size_t m) {
+		const auto column = static_cast<Eigen::Index>(m);
+		if (control && control->stopRequested()) {
+			ensemble.objectives.col(column).setConstant(std::numeric_limits<float>::quiet_NaN());
+			control->addSkipped();
+			return;
+		}
+		SimulationResult result = mEnsemble[m]->simulateScenario(taskData, SimulationType::ResultOnly);
+		ensemble.objectives.col(column) = objectiveFields(toObjectiveResult(result, taskData));
+		simulated[m] = 1;
+		if (control) {
+			control->addCompleted();
+		}
+	});
+
+	// the statistics are of the members that were simulated
+	std::vector<Eigen::Index> members;
+	for (size_t m = 0; m < simulated.size(); m++) {
+		if (simulated[m]) {
+			members.push_back(static_cast<Eigen::Index>(m));
+		}
 	}
-	
-	// calculate elaspsed run time
-	auto end = std::chrono::high_resolution_clock::now();
-	std::chrono::duration<double> elapsed = end - start;
-	float runtime = static_cast<float>(elapsed.count());
+	ensemble.simulated_members = members.size();
+
+	std::vector<float> values(members.size());
+	for (size_t i = 0; i < NUM_OBJECTIVE_FIELDS; i++) {
+		if (members.empty()) {
+			const float nan = std::numeric_limits<float>::quiet_NaN();
+			ensemble.statistics[i] = EnsembleStatistics{ nan, nan, nan, nan, nan, nan };
+			continue;
+		}
+		for (size_t k = 0; k < members.size(); k++) {
+			values[k] = ensemble.objectives(static_cast<Eigen::Index>(i), members[k]);
+		}
+		ensemble.statistics[i] = summariseEnsemble(values);
+	}
+	return ensemble;
+}
 
-	result.runtime = runtime;
+SensitivityResult Simulator::sensitivities(const TaskData& base, std::span<const Perturbation> perturbations,
+	SensitivityScheme scheme, ThreadPool& pool) const {
+	validateScenario(base);
+
+	// the perturbed scenarios, two per perturbation
+	// (the backward scenario of a Forward difference is the base, which isn't simulated again)
+	std::vector<TaskData> scenarios;
+	std::vector<uint8_t> isBase;
+	std::vector<float> steps;
+	scenarios.reserve(2 * perturbations.size());
+	for (const Perturbation& perturbation : perturbations) {
+		if (!(perturbation.step > 0.0f)) {
+			throw std::runtime_error(std::format("A perturbation step must be positive, not {}", perturbation.step));
+		}
+		const float value = getParameter(base, perturbation);
+		const bool central = scheme == SensitivityScheme::Central && value - perturbation.step >= 0.0f;
 
-	return result;
+		TaskData forward = base;
+		setParameter(forward, perturbation, value + perturbation.step);
+		scenarios.push_back(std::move(forward));
+		isBase.push_back(0);
+
+		TaskData backward = base;
+		if (central) {
+			setParameter(backward, perturbation, value - perturbation.step);
+		}
+		scenarios.push_back(std::move(backward));
+		isBase.push_back(central ? 0 : 1);
+		steps.push_back(central ? 2.0f * perturbation.step : perturbation.step);
+	}
+
+	// simulate the base first, keeping its state before the balancing loop for the perturbations that don't change it
+	std::shared_ptr<const PreBalancingSnapshot> baseSnapshot;
+	SimulationResult baseResult = simulateFromSnapshot(base, baseSnapshot);
+	const PreBalancingKey baseKey{ base };
+
+	std::vector<SimulationResult> results(scenarios.size());
+	std::vector<uint8_t> valid(scenarios.size(), 0);
+	std::vector<uint8_t> reused(scenarios.size(), 0);
+	pool.parallelFor(scenarios.size(), [&](size_t i) {
+		if (isBase[i]) {
+			results[i] = baseResult;
+			valid[i] = 1;
+			return;
+		}
+		if (const ScenarioError errors = checkScenario(scenarios[i]); errors != ScenarioError::None) {
+			warnInvalidScenario("Invalid perturbed scenario", scenarios[i], errors);
+			return;
+		}
+		std::shared_ptr<const PreBalancingSnapshot> snapshot;
+		if (PreBalancingKey{ scenarios[i] } == baseKey) {
+			snapshot = baseSnapshot;
+			reused[i] = 1;
+		}
+		results[i] = simulateFromSnapshot(scenarios[i], snapshot);
+		valid[i] = 1;
+	});
+
+	SensitivityResult sensitivity{ toObjectiveResult(baseResult, base), {}, 0 };
+	sensitivity.jacobian.resize(static_cast<Eigen::Index>(NUM_OBJECTIVE_FIELDS), static_cast<Eigen::Index>(perturbations.size()));
+	for (size_t p = 0; p < perturbations.size(); p++) {
+		const size_t forward = 2 * p;
+		const size_t backward = 2 * p + 1;
+		auto column = sensitivity.jacobian.col(static_cast<Eigen::Index>(p));
+		if (!valid[forward] || !valid[backward]) {
+			column.setConstant(std::numeric_limits<float>::quiet_NaN());
+			continue;
+		}
+		column = (objectiveFields(toObjectiveResult(results[forward], scenarios[forward]))
+			- objectiveFields(toObjectiveResult(results[backward], scenarios[backward]))) / steps[p];
+	}
+	for (uint8_t r : reused) {
+		sensitivity.reused_pre_balancing += r;
+	}
+	return sensitivity;
 }
 
-void Simulator::validateScenario(const TaskData& taskData) const {
-	// check fabric_intervention_index is in bounds
-	if (taskData.building) {
-		// building_hload is considered index 0 so we are effectively 1-based indexing
-		if (taskData.building->fabric_intervention_index >= mSiteData.fabric_interventions.size() + 1) {
-			throw std::runtime_error(std::format(
-				"Cannot use fabric_intervention_index of {} with {} fabric interventions",
-				taskData.building->fabric_intervention_index, mSiteData.fabric_interventions.size()
-			));
+std::vector<SimulationResult> Simulator::sweepESS(const TaskData& base, std::span<const ESSSize> sizes, ThreadPool& pool) const {
+	TraceScope trace{ "sweepESS", "batch" };
+	if (!base.energy_storage_system) {
+		throw std::runtime_error("Cannot sweep the sizes of the ESS of a scenario without one");
+	}
+	validateScenario(base);
+
+	std::vector<TaskData> scenarios;
+	scenarios.reserve(sizes.size());
+	for (const ESSSize& size : sizes) {
+		if (!(size.capacity >= 0.0f && size.charge_power >= 0.0f && size.discharge_power >= 0.0f)) {
+			throw std::runtime_error(std::format("An ESS size must not be negative, not ({}, {}, {})",
+				size.capacity, size.charge_power, size.discharge_power));
 		}
+		scenarios.push_back(withESSSize(base, size));
 	}
 
-	// check tariff_index is in bounds
-	if (taskData.grid) {
-		if (taskData.grid->tariff_index >= mSiteData.import_tariffs.size()) {
-			throw std::runtime_error(std::format(
-				"Cannot use tariff_index of {} with {} tariffs provided",
-				taskData.grid->tariff_index, mSiteData.import_tariffs.size()
-			));
+	// the ESS doesn't change the state before the balancing loop, so every size starts from the base's
+	std::shared_ptr<const PreBalancingSnapshot> snapshot;
+	{
+		ScenarioState state(base, mExecutionPlans->get(base));
+		state.keepSnapshot = true;
+		prepareBalancing(base, nullptr, nullptr, state);
+		snapshot = state.snapshot;
+	}
+
+	std::vector<SimulationResult> results(scenarios.size());
+	if (!lockstepGroup(base)) {
+		pool.parallelFor(scenarios.size(), [&](size_t i) {
+			std::shared_ptr<const PreBalancingSnapshot> shared = snapshot;
+			results[i] = simulateFromSnapshot(scenarios[i], shared);
+		});
+		return results;
+	}
+
+	std::vector<std::vector<size_t>> jobs;
+	for (size_t first = 0; first < scenarios.size(); first += LOCKSTEP_LANES) {
+		std::vector<size_t>& job = jobs.emplace_back(std::min(LOCKSTEP_LANES, scenarios.size() - first));
+		std::iota(job.begin(), job.end(), first);
+	}
+
+	if (mBatchBackend) {
+		runBackendJobs(scenarios, jobs, results, nullptr, pool, snapshot);
+		return results;
+	}
+	pool.parallelFor(jobs.size(), [&](size_t j) {
+		simulateLockstep(scenarios, jobs[j], results, snapshot);
+	});
+	return results;
+}
+
+UpgradeTreeResult Simulator::simulateUpgradeTree(const TaskData& base, std::span<const Upgrade> upgrades, ThreadPool& pool) const {
+	if (upgrades.size() > MAX_UPGRADES) {
+		throw std::runtime_error(std::format("An upgrade tree has at most {} upgrades, not {}", MAX_UPGRADES, upgrades.size()));
+	}
+	const size_t numUpgrades = upgrades.size();
+	const size_t numNodes = size_t{ 1 } << numUpgrades;
+
+	std::vector<TaskData> scenarios(numNodes, base);
+	std::vector<std::vector<size_t>> tiers(numUpgrades + 1);
+	for (size_t mask = 0; mask < numNodes; mask++) {
+		for (size_t i = 0; i < numUpgrades; i++) {
+			if (mask & (size_t{ 1 } << i)) {
+				upgrades[i].apply(scenarios[mask]);
+			}
 		}
+		tiers[static_cast<size_t>(std::popcount(mask))].push_back(mask);
 	}
 
-	// check the yield_index is in bounds for each solar panel
-	int num_yields = static_cast<int>(mSiteData.solar_yields.size());
-	for (const SolarData& solar : taskData.solar_panels) {
-		if (solar.yield_index >= num_yields) {
-			throw std::runtime_error(std::format(
-				"Cannot use yield_index of {} with {} yields provided",
-				solar.yield_index, mSiteData.solar_yields.size()
-			));
+	std::vector<SimulationResult> results(numNodes);
+	// the state before the balancing loop of each node of the last tier, to be shared with its children
+	std::vector<std::shared_ptr<const PreBalancingSnapshot>> snapshots(numNodes);
+	std::vector<std::optional<PreBalancingKey>> keys(numNodes);
+	std::vector<uint8_t> reused(numNodes, 0);
+
+	for (size_t tier = 0; tier <= numUpgrades; tier++) {
+		const std::vector<size_t>& nodes = tiers[tier];
+		pool.parallelFor(nodes.size(), [&](size_t n) {
+			const size_t mask = nodes[n];
+			const TaskData& taskData = scenarios[mask];
+			if (const ScenarioError errors = checkScenario(taskData); errors != ScenarioError::None) {
+				warnInvalidScenario(std::format("Invalid node {} of the upgrade tree", upgradeNodeName(mask, numUpgrades)), taskData, errors);
+				results[mask] = makeInvalidResult(taskData);
+				return;
+			}
+
+			PreBalancingKey key{ taskData };
+			std::shared_ptr<const PreBalancingSnapshot> snapshot;
+			for (size_t i = 0; i < numUpgrades && !snapshot; i++) {
+				const size_t parent = mask & ~(size_t{ 1 } << i);
+				if (parent != mask && snapshots[parent] && *keys[parent] == key) {
+					snapshot = snapshots[parent];
+					reused[mask] = 1;
+				}
+			}
+			results[mask] = simulateFromSnapshot(taskData, snapshot);
+			snapshots[mask] = std::move(snapshot);
+			keys[mask] = std::move(key);
+		});
+
+		// only the next tier can start from this tier's states
+		if (tier > 0) {
+			for (size_t mask : tiers[tier - 1]) {
+				snapshots[mask].reset();
+				keys[mask].reset();
+			}
 		}
 	}
+
+	UpgradeTreeResult tree;
+	for (const auto& upgrade : upgrades) {
+		tree.upgrades.push_back(upgrade.name);
+	}
+	for (size_t mask = 0; mask < numNodes; mask++) {
+		tree.nodes.emplace(upgradeNodeName(mask, numUpgrades), std::move(results[mask]));
+		tree.reused_pre_balancing += reused[mask];
+	}
+	return tree;
 }
 
-CapexBreakdown Simulator::calculateCapexWithDiscounts(const TaskData& taskData) const {
-	return calculate_capex_with_discounts(mSiteData, mConfig, taskData);
+SimulationResult Simulator::simulateFromSnapshot(const TaskData& taskData, std::shared_ptr<const PreBalancingSnapshot>& snapshot) const {
+	auto start = std::chrono::high_resolution_clock::now();
+	SimulationResult result{};
+
+	ScenarioState state(taskData, mExecutionPlans->get(taskData));
+	state.snapshot = snapshot;
+	state.keepSnapshot = !snapshot;
+	prepareBalancing(taskData, nullptr, nullptr, state);
+	state.balance(0, mSiteData.timesteps);
+	SimulationTotals totals = finishTimesteps(taskData, nullptr, nullptr, nullptr, state);
+	completeResult(result, taskData, totals, nullptr);
+	snapshot = state.snapshot;
+
+	std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+	result.runtime = static_cast<float>(elapsed.count());
+	return result;
+}
+
+ObjectiveBounds Simulator::boundObjectives(const TaskData& taskData) const {
+	std::shared_ptr<const PreBalancingSnapshot> snapshot;
+	return boundFromSnapshot(taskData, snapshot);
 }
 
-ReportData Simulator::simulateTimesteps(const TaskData& taskData, [[maybe_unused]] SimulationType simulationType) const {
-	/* INITIALISE classes that support energy sums and object precedence */
-	Flags flags(taskData);	// flags energy component presence in TaskData & balancing modes
-	TempSum tempSum(mSiteData);		// class of arrays for running totals (replace ESUM and Heat)
+std::vector<ObjectiveBounds> Simulator::boundObjectives(std::span<const TaskData> taskData, ThreadPool& pool) const {
+	TraceScope trace{ "boundObjectives", "batch" };
+	// group the candidates that share a state before the balancing loop, in the order they first appear
+	std::unordered_map<PreBalancingKey, size_t> groupOf;
+	std::vector<std::vector<size_t>> groups;
+	for (size_t i = 0; i < taskData.size(); i++) {
+		auto [it, added] = groupOf.try_emplace(PreBalancingKey(taskData[i]), groups.size());
+		if (added) {
+			groups.emplace_back();
+		}
+		groups[it->second].push_back(i);
+	}
 
-	ReportData reportData{};
+	std::vector<ObjectiveBounds> bounds(taskData.size());
+	pool.parallelFor(groups.size(), [&](size_t g) {
+		std::shared_ptr<const PreBalancingSnapshot> snapshot;
+		for (size_t i : groups[g]) {
+			bounds[i] = boundFromSnapshot(taskData[i], snapshot);
+		}
+	});
+	return bounds;
+}
 
-	// Do tariff precalculation
-	size_t tariff_index = taskData.grid ? taskData.grid->tariff_index : 0;
+ObjectiveBounds Simulator::boundFromSnapshot(const TaskData& taskData, std::shared_ptr<const PreBalancingSnapshot>& snapshot) const {
+	if (checkScenario(taskData) != ScenarioError::None) {
+		const SimulationResult invalid = makeInvalidResult(taskData);
+		ObjectiveBounds bounds{
+			invalid.metrics.total_capex, invalid.metrics.total_annualised_cost,
+			invalid.comparison.cost_balance, invalid.comparison.operating_balance, invalid.comparison.combined_carbon_balance,
+			invalid.comparison.payback_horizon_years
+		};
+		bounds.invalid = true;
+		return bounds;
+	}
+
+	ScenarioState state(taskData, mExecutionPlans->get(taskData));
+	state.snapshot = snapshot;
+	state.keepSnapshot = !snapshot;
+	prepareBalancing(taskData, nullptr, nullptr, state);
+	snapshot = state.snapshot;
+
+	const ExecutionPlan& plan = state.plan;
+	const TempSum& tempSum = *state.tempSum;
+	const bool hotroom = plan.dataCentre == ExecutionPlan::DataCentreKind::WITH_ASHP;
+
+	// the totals of the components before the balancing loop are already known
+	SimulationTotals totals = state.totals;
+	const LoopSlack slack{ state.ess ? state.ess->getBattery().getDischargeMax_e() : 0.0f, hotroom };
+	PostBalancing(mSiteData, taskData, plan.deferredWaterHeater).optimisticTotals(tempSum, slack, totals);
+
+	// a hotroom heatpump may meet any of the heat, and otherwise the heat balances are already final
+	double gas = 0.0;
+	if (plan.gasHeater && !hotroom) {
+		gas = GasCombustionHeater::gasBurnt(mSiteData, taskData.gas_heater.value(), tempSum);
+	}
+	totals.gas_import_h = loosen(gas, false);
 
-	DayTariffStats tariffStats{ mSiteData, tariff_index };
+	if (BasicElectricVehicle* ev = state.balancingEV()) {
+		// a balancing EV takes at most its target load (or its flexible share of it, if that is more)
+		const float flex = std::max(1.0f, ev->getFlexRatio());
+		totals.ev_load_e = loosen(static_cast<double>(ev->getTargetLoad().cwiseMax(0.0f).sum()) * flex, true);
+	}
+	if (taskData.data_centre) {
+		// a data centre takes at most its maximum load in every timestep
+		const double maxLoad = std::max(0.0f, taskData.data_centre->maximum_load * mSiteData.timestep_hours);
+		totals.data_centre_load_e = loosen(maxLoad * static_cast<double>(mSiteData.timesteps), true);
+	}
 
+	totals.low_priority_load_e = loosen(totals.low_priority_load_e, true);
+	totals.grid_import_e = loosen(totals.grid_import_e, false);
+	totals.grid_import_cost = loosen(totals.grid_import_cost, false);
+	totals.grid_import_co2_g = loosen(totals.grid_import_co2_g, false);
+	totals.grid_export_e = loosen(totals.grid_export_e, true);
+	totals.grid_export_revenue = loosen(totals.grid_export_revenue, true);
+	totals.grid_export_co2_g = loosen(totals.grid_export_co2_g, true);
 
-	// Run through the pre balancing loop components
+	// every objective is monotonic in the totals, so costing the optimistic totals bounds them
+	SimulationResult result{};
+	completeResult(result, taskData, totals, nullptr);
+
+	const float capex = result.metrics.total_capex;
+	const float operatingBalance = result.comparison.operating_balance;
+	return ObjectiveBounds{
+		capex,
+		result.metrics.total_annualised_cost,
+		result.comparison.cost_balance,
+		operatingBalance,
+		result.comparison.combined_carbon_balance,
+		capex > 0.0f && operatingBalance <= 0.0f ? std::numeric_limits<float>::infinity() : result.comparison.payback_horizon_years
+	};
+}
 
-	if (taskData.building) {
-		Hotel hotel(mSiteData, taskData.building.value());
-		hotel.AllCalcs(tempSum);
-		hotel.Report(reportData);
+std::shared_ptr<Simulator> Simulator::atResolution(std::chrono::seconds interval) const {
+	const auto native = mSiteData.timestep_interval_s;
+	if (interval < native || interval % native != std::chrono::seconds{ 0 }) {
+		throw std::runtime_error(std::format("A resolution of {}s is not a whole multiple of the {}s timestep",
+			interval.count(), native.count()));
 	}
 
-	if (taskData.solar_panels.size() > 0) {
-		BasicPV PV1(mSiteData, taskData.solar_panels);
-		PV1.AllCalcs(tempSum);
-		PV1.Report(reportData);
+	std::lock_guard<std::mutex> lock(mResolutions->mutex);
+	auto& simulator = mResolutions->simulators[interval];
+	if (!simulator) {
+		const auto factor = static_cast<size_t>(interval / native);
+		simulator = factor == 1
+			? std::make_shared<Simulator>(mSiteDataPtr, mConfig)
+			: std::make_shared<Simulator>(resampleSiteData(mSiteData, factor), mConfig);
 	}
+	return simulator;
+}
 
-	if (flags.getEVFlag() == EVFlag::NON_BALANCING) {
-		BasicElectricVehicle EV1(mSiteData, taskData.electric_vehicles.value());
-		EV1.AllCalcs(tempSum);
-		EV1.Report(reportData);
+void Simulator::completeResult(SimulationResult& result, const TaskData& taskData, const SimulationTotals& totals, PhaseTimings* timings) const {
+	TraceScope trace{ "costs", "scenario" };
+	// the capex model is evaluated once, for the usage, the NPV and the result
+	// (into each thread's own ScenarioCosts, whose vectors are reused by its next scenario)
+	thread_local ScenarioCosts costs;
+	{
+		ScopedPhaseTimer timer{ timings, &PhaseTimings::capex };
+		mCostEngine->evaluate(taskData, costs);
 	}
 
-	bool heatPumpCanSupplyDHW = false;
-	if (taskData.domestic_hot_water && taskData.heat_pump) {
-		HotWaterCylinder hotWaterCylinder{ mSiteData, taskData.domestic_hot_water.value(), taskData.heat_pump.value(), tariff_index, tariffStats };
-		hotWaterCylinder.AllCalcs(tempSum);
-		hotWaterCylinder.Report(reportData);
-		heatPumpCanSupplyDHW = true;
+	UsageData scenarioUsage;
+	{
+		ScopedPhaseTimer timer{ timings, &PhaseTimings::usage };
+		scenarioUsage = calculateScenarioUsage(mConfig, taskData, totals, costs.capex);
 	}
 
-	if (!taskData.gas_heater && !heatPumpCanSupplyDHW) {
-		// If there's no gas heater, we assume a resistive heating component to meet DHW
-		// We can only run this here if there's no heatpump in balancing loop, otherwise it is deferred
-		InstantWaterHeater iwh(mSiteData);
-		iwh.AllCalcs(tempSum);
-		iwh.Report(reportData);
+	result.baseline_metrics = baseline().metrics;
+	{
+		ScopedPhaseTimer timer{ timings, &PhaseTimings::metrics };
+		result.metrics = calculateMetrics(taskData, totals, scenarioUsage, costs.components, timings);
+	}
+	{
+		ScopedPhaseTimer timer{ timings, &PhaseTimings::comparison };
+		result.comparison = compareScenarios(mSiteData, baseline().usage, result.baseline_metrics, scenarioUsage, result.metrics);
 	}
+	result.scenario_capex_breakdown = costs.capex;
+}
 
-	// Construct components that may be in the balancing loop
+bool Simulator::isTariffIndependent(const TaskData& taskData) {
+	const bool tariffMode = taskData.energy_storage_system
+		&& (taskData.energy_storage_system->battery_mode == BatteryMode::CONSUME_PLUS
+			|| taskData.energy_storage_system->battery_mode == BatteryMode::PRICE_LOOKAHEAD);
+	const bool hotWaterCylinder = taskData.domestic_hot_water && taskData.heat_pump;
+	return !tariffMode && !hotWaterCylinder;
+}
 
-	std::unique_ptr<ESS> ESSmain;
-	if (taskData.energy_storage_system) {
-		ESSmain = std::make_unique<BasicESS>(mSiteData, taskData.energy_storage_system.value(), tariff_index, tariffStats);
+std::shared_ptr<const Simulator> Simulator::Configs::find(const TaskConfig& config) {
+	auto it = std::find_if(simulators.begin(), simulators.end(), [&](const auto& entry) { return entry.first == config; });
+	if (it == simulators.end()) {
+		return nullptr;
 	}
-	else {
-		ESSmain = std::make_unique<NullESS>(mSiteData);
+	std::rotate(it, it + 1, simulators.end());
+	return simulators.back().second;
+}
+
+std::shared_ptr<const Simulator> Simulator::withConfig(const TaskConfig& config) const {
+	std::call_once(mConfigs->baselineOnce, [this] {
+		// the baseline's timeseries don't depend on the config, so every config shares this Simulator's, if it has them
+		if (hasBaseline() && mBaseline->totals && mBaseline->baseline.reportData) {
+			mConfigs->baselineTotals = *mBaseline->totals;
+			mConfigs->baselineReportData = mBaseline->baseline.reportData;
+		}
+		else {
+			auto reportData = std::make_shared<ReportData>();
+			mConfigs->baselineTotals = simulateTimesteps(mSiteData.baseline, reportData.get());
+			reportData->shrinkToPopulated();
+			mConfigs->baselineReportData = std::move(reportData);
+		}
+	});
+
+	{
+		std::lock_guard<std::mutex> lock(mConfigs->mutex);
+		if (auto simulator = mConfigs->find(config)) {
+			return simulator;
+		}
 	}
 
-	std::unique_ptr<BasicElectricVehicle> EV1;
-	if (taskData.electric_vehicles) {
-		EV1 = std::make_unique<BasicElectricVehicle>(mSiteData, taskData.electric_vehicles.value());
+	// the baseline is costed outside the lock, so a config may be built twice by a race, but only the first is kept
+	auto simulator = std::shared_ptr<Simulator>(new Simulator(*this, config));
+	simulator->setBaseline(mConfigs->baselineTotals, mConfigs->baselineReportData);
+
+	std::lock_guard<std::mutex> lock(mConfigs->mutex);
+	if (auto existing = mConfigs->find(config)) {
+		return existing;
+	}
+	if (mConfigs->simulators.size() >= Configs::MAX_CONFIGS) {
+		mConfigs->simulators.erase(mConfigs->simulators.begin());
 	}
+	mConfigs->simulators.emplace_back(config, simulator);
+	return simulator;
+}
 
-	// TODO - as we can return an invalid result here, we should do this earlier
-	std::unique_ptr<DataCentre> dataCentre;
-	std::unique_ptr<AmbientHeatPumpController> ambientController;
+std::vector<SimulationResult> Simulator::simulateConfigs(const TaskData& taskData, std::span<const TaskConfig> configs) const {
+	TraceScope trace{ "simulateConfigs", "scenario" };
+	auto start = std::chrono::high_resolution_clock::now();
 
-	if (taskData.data_centre && taskData.heat_pump && taskData.heat_pump->heat_source == HeatSource::HOTROOM) {
-		// make a DataCentre with a hotroom heatpump
-		dataCentre = std::make_unique<DataCentreWithASHP>(mSiteData, taskData.data_centre.value(), taskData.heat_pump.value());
+	std::vector<std::shared_ptr<const Simulator>> simulators;
+	simulators.reserve(configs.size());
+	for (const TaskConfig& config : configs) {
+		simulators.push_back(withConfig(config));
+	}
 
+	std::vector<SimulationResult> results(configs.size());
+	if (const ScenarioError errors = checkScenario(taskData); errors != ScenarioError::None) {
+		warnInvalidScenario("Invalid scenario", taskData, errors);
+		for (size_t i = 0; i < configs.size(); i++) {
+			results[i] = simulators[i]->makeInvalidResult(taskData);
+		}
+		return results;
 	}
-	else if (taskData.data_centre && taskData.heat_pump && taskData.heat_pump->heat_source == HeatSource::AMBIENT_AIR) {
-		// make a basic data centre (without a heatpump)
-		dataCentre = std::make_unique<BasicDataCentre>(mSiteData, taskData.data_centre.value());
-		ambientController = std::make_unique<AmbientHeatPumpController>(mSiteData, taskData.heat_pump.value(), heatPumpCanSupplyDHW);
+
+	// the config doesn't change the dispatch, so only the costs differ
+	const SimulationTotals totals = simulateTimesteps(taskData, nullptr);
+	for (size_t i = 0; i < configs.size(); i++) {
+		simulators[i]->completeResult(results[i], taskData, totals, nullptr);
 	}
-	else if (taskData.heat_pump && !taskData.data_centre) {
-		ambientController = std::make_unique<AmbientHeatPumpController>(mSiteData, taskData.heat_pump.value(), heatPumpCanSupplyDHW);
+
+	std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+	for (SimulationResult& result : results) {
+		result.runtime = static_cast<float>(elapsed.count());
 	}
-	else if (taskData.data_centre && !taskData.heat_pump) {
-		dataCentre = std::make_unique<BasicDataCentre>(mSiteData, taskData.data_centre.value());
+	return results;
+}
+
+std::vector<SimulationResult> Simulator::simulateAllTariffs(const TaskData& taskData) const {
+	auto start = std::chrono::high_resolution_clock::now();
+
+	const size_t numTariffs = mSiteData.import_tariffs.size();
+
+	// the same scenario with each tariff in turn
+	std::vector<TaskData> perTariff(numTariffs, taskData);
+	if (taskData.grid) {
+		for (size_t i = 0; i < numTariffs; i++) {
+			perTariff[i].grid->tariff_index = i;
+		}
 	}
 
+	std::vector<SimulationResult> results;
+	results.reserve(numTariffs);
 
-	if (ambientController) {
-		ambientController->AllCalcs(tempSum);
+	if (!isTariffIndependent(taskData)) {
+		for (const TaskData& td : perTariff) {
+			results.push_back(simulateScenario(td));
+		}
+	}
+	else {
+		if (const ScenarioError errors = checkScenario(perTariff[0]); errors != ScenarioError::None) {
+			warnInvalidScenario("Invalid scenario", perTariff[0], errors);
+			return std::vector<SimulationResult>(numTariffs, makeInvalidResult(taskData));
+		}
+
+		// the dispatch is the same for every tariff, so only the cost of the grid import differs
+		std::optional<PhaseTimings> timings;
+		if (PHASE_TIMING_ENABLED) {
+			timings.emplace();
+		}
+		Eigen::VectorXf tariffCosts;
+		SimulationTotals totals = simulateTimesteps(perTariff[0], nullptr, timings ? &timings.value() : nullptr, &tariffCosts);
+
+		// (without a building, the grid isn't simulated and there is no cost to reprice)
+		const bool priced = tariffCosts.size() == static_cast<Eigen::Index>(numTariffs);
+		for (size_t i = 0; i < numTariffs; i++) {
+			if (priced) {
+				totals.grid_import_cost = tariffCosts[static_cast<Eigen::Index>(i)];
+			}
+			SimulationResult& result = results.emplace_back();
+			result.timings = timings;
+			completeResult(result, perTariff[i], totals, nullptr);
+		}
 	}
 
-	if (flags.getDataCentreFlag() == DataCentreFlag::NON_BALANCING) {
-		dataCentre->AllCalcs(tempSum);
+	std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+	for (size_t i = 0; i < numTariffs; i++) {
+		results[i].runtime = static_cast<float>(elapsed.count());
+		if (mResultCache) {
+			mResultCache->insert(perTariff[i], results[i]);
+		}
 	}
 
-	tempSum.ReportBeforeBalancingLoop(reportData);
-	// BALANCING LOOP
+	return results;
+}
+
+DaysOfInterest Simulator::daysOfInterest(const TaskData& taskData) const {
+	TraceScope trace{ "daysOfInterest", "scenario" };
+	validateScenario(taskData);
+
+	ReportData reportData(DAYS_OF_INTEREST_COLUMNS);
+	simulateTimesteps(taskData, &reportData);
 
-	float futureEnergy = 0.0f;
-	size_t timesteps = mSiteData.timesteps;
-	const float availableGridImport = getFixedAvailableImport(taskData);
+	const size_t tariffIndex = taskData.grid ? taskData.grid->tariff_index : 0;
+	return findDaysOfInterest(reportData, *mTariffStats[tariffIndex], mSiteData.import_tariffs[tariffIndex]);
+}
+
+void Simulator::validateScenario(const TaskData& taskData) const {
+	const ScenarioError errors = checkScenario(taskData);
+	if (errors != ScenarioError::None) {
+		throw std::runtime_error(describeScenarioError(taskData, errors));
+	}
+}
 
+ScenarioError Simulator::checkScenario(const TaskData& taskData) const noexcept {
+	ScenarioError errors = ScenarioError::None;
 
-	auto dcFlag = flags.getDataCentreFlag();
-	auto evFlag = flags.getEVFlag();
+	// building_hload is considered index 0 so we are effectively 1-based indexing
+	if (taskData.building && taskData.building->fabric_intervention_index >= mSiteData.fabric_interventions.size() + 1) {
+		errors |= ScenarioError::FabricInterventionIndex;
+	}
 
-	if (dcFlag == DataCentreFlag::BALANCING && evFlag == EVFlag::BALANCING) {
-		// This represents the logic in M-VEST v0-7:
-		// EV is curtailed before the Data Centre
+	if (taskData.grid && taskData.grid->tariff_index >= mSiteData.import_tariffs.size()) {
+		errors |= ScenarioError::TariffIndex;
+	}
 
-		for (size_t t = 0; t < timesteps; t++) {
-			futureEnergy = availableGridImport + ESSmain->AvailDisch() - dataCentre->getTargetLoad(t);
-			EV1->StepCalc(tempSum, futureEnergy, t);
-			futureEnergy = availableGridImport + ESSmain->AvailDisch();
-			dataCentre->StepCalc(tempSum, futureEnergy, t);
-			ESSmain->StepCalc(tempSum, availableGridImport, t);
+	const size_t numYields = mSiteData.solar_yields.size();
+	for (const SolarData& solar : taskData.solar_panels) {
+		if (solar.yield_index < 0 || static_cast<size_t>(solar.yield_index) >= numYields) {
+			errors |= ScenarioError::YieldIndex;
 		}
 	}
-	else if (dcFlag != DataCentreFlag::BALANCING && evFlag == EVFlag::BALANCING) {
-		for (size_t t = 0; t < timesteps; t++) {
-			futureEnergy = availableGridImport + ESSmain->AvailDisch();
-			EV1->StepCalc(tempSum, futureEnergy, t);
-			ESSmain->StepCalc(tempSum, availableGridImport, t);
+	return errors;
+}
+
+void Simulator::checkScenarios(std::span<const TaskData> taskData, std::span<ScenarioError> errors) const {
+	if (errors.size() != taskData.size()) {
+		throw std::invalid_argument(std::format("Cannot check {} scenarios into {} errors", taskData.size(), errors.size()));
+	}
+	for (size_t i = 0; i < taskData.size(); i++) {
+		errors[i] = checkScenario(taskData[i]);
+	}
+}
+
+std::string Simulator::describeScenarioError(const TaskData& taskData, ScenarioError errors) const {
+	std::vector<std::string> messages;
+	if (hasError(errors, ScenarioError::FabricInterventionIndex) && taskData.building) {
+		messages.push_back(std::format("Cannot use fabric_intervention_index of {} with {} fabric interventions",
+			taskData.building->fabric_intervention_index, mSiteData.fabric_interventions.size()));
+	}
+	if (hasError(errors, ScenarioError::TariffIndex) && taskData.grid) {
+		messages.push_back(std::format("Cannot use tariff_index of {} with {} tariffs provided",
+			taskData.grid->tariff_index, mSiteData.import_tariffs.size()));
+	}
+	if (hasError(errors, ScenarioError::YieldIndex)) {
+		for (const SolarData& solar : taskData.solar_panels) {
+			if (solar.yield_index < 0 || static_cast<size_t>(solar.yield_index) >= mSiteData.solar_yields.size()) {
+				messages.push_back(std::format("Cannot use yield_index of {} with {} yields provided",
+					solar.yield_index, mSiteData.solar_yields.size()));
+				break;
+			}
 		}
 	}
-	else if (dcFlag == DataCentreFlag::BALANCING && evFlag != EVFlag::BALANCING) {
-		for (size_t t = 0; t < timesteps; t++) {
-			futureEnergy = availableGridImport + ESSmain->AvailDisch();
-			dataCentre->StepCalc(tempSum, futureEnergy, t);
-			ESSmain->StepCalc(tempSum, availableGridImport, t);
+
+	std::string message;
+	for (const std::string& part : messages) {
+		message += message.empty() ? part : "; " + part;
+	}
+	return message;
+}
+
+namespace {
+	/**
+	* The independent stages of a scenario, which are run as they are added or, with a pool, together on the pool by wait()
+	*
+	* Stages that run together must not write the same state (though they may write different columns of a shared ReportData)
+	* and so must not time themselves into the same field of PhaseTimings
+	*/
+	class StageGroup {
+	public:
+		explicit StageGroup(ThreadPool* pool) : mPool(pool) {}
+
+		template <typename Stage>
+		void run(Stage&& stage) {
+			if (mPool) {
+				mStages.emplace_back(std::forward<Stage>(stage));
+			}
+			else {
+				stage();
+			}
 		}
+
+		void wait() {
+			if (mStages.size() == 1) {
+				mStages.front()();
+			}
+			else if (!mStages.empty()) {
+				mPool->parallelFor(mStages.size(), [this](size_t i) { mStages[i](); });
+			}
+			mStages.clear();
+		}
+
+	private:
+		ThreadPool* mPool;
+		std::vector<std::function<void()>> mStages;
+	};
+
+	// the number of invalid scenarios that were warned of in full, after which only every INVALID_WARNING_INTERVAL'th is
+	constexpr uint64_t INVALID_WARNINGS_IN_FULL = 10;
+	constexpr uint64_t INVALID_WARNING_INTERVAL = 1000;
+
+	std::atomic<uint64_t> gInvalidScenarios{ 0 };
+}
+
+void Simulator::warnInvalidScenario(std::string_view context, const TaskData& taskData, ScenarioError errors) const {
+	const uint64_t count = gInvalidScenarios.fetch_add(1, std::memory_order_relaxed) + 1;
+	if (!spdlog::should_log(spdlog::level::warn)) {
+		return;
 	}
-	else {
-		for (size_t t = 0; t < timesteps; t++) {
-			ESSmain->StepCalc(tempSum, availableGridImport, t);
+	if (count < INVALID_WARNINGS_IN_FULL) {
+		spdlog::warn("{}: {}", context, describeScenarioError(taskData, errors));
+	}
+	else if (count == INVALID_WARNINGS_IN_FULL) {
+		spdlog::warn("{}: {} (further invalid scenarios are only logged every {})",
+			context, describeScenarioError(taskData, errors), INVALID_WARNING_INTERVAL);
+	}
+	else if (count % INVALID_WARNING_INTERVAL == 0) {
+		spdlog::warn("{} invalid scenarios so far; the latest: {}: {}", count, context, describeScenarioError(taskData, errors));
+	}
+}
+
+CapexBreakdown Simulator::calculateCapexWithDiscounts(const TaskData& taskData) const {
+	return mCostEngine->evaluate(taskData).capex;
+}
+
+SimulationTotals Simulator::simulateTimesteps(const TaskData& taskData, ReportData* reportData, PhaseTimings* timings,
+	Eigen::VectorXf* tariffCosts) const {
+	ScenarioState state(taskData, mExecutionPlans->get(taskData));
+	prepareBalancing(taskData, reportData, timings, state);
+
+	// The loop is specialised for the components present, so it is skipped entirely if there is nothing to balance
+	{
+		ScopedPhaseTimer timer{ timings, &PhaseTimings::balancing_loop };
+		TraceScope trace{ "balancing_loop", "scenario" };
+		ThreadPool* essPool = mParallelESSPool ? mParallelESSPool : stagePool(reportData);
+		if (essPool && state.plan.consumeOnly) {
+			runConsumeScan(*state.ess, *state.tempSum, mSiteData.timesteps, *essPool);
+		}
+		else {
+			state.balance(0, mSiteData.timesteps);
 		}
 	}
 
-	// Run through the post balancing loop components
+	return finishTimesteps(taskData, reportData, timings, tariffCosts, state);
+}
+
+SimulationTotals Simulator::simulateWindow(const TaskData& taskData, ReportData* reportData, CarriedState& carried) const {
+	ScenarioState state(taskData, mExecutionPlans->get(taskData));
+	state.carried = &carried;
+	prepareBalancing(taskData, reportData, nullptr, state);
+
+	state.balance(0, mSiteData.timesteps);
+
+	if (state.ess) {
+		carried.ess_charge = state.ess->getBattery().GetSoC();
+	}
+	return finishTimesteps(taskData, reportData, nullptr, nullptr, state);
+}
+
+void Simulator::prepareBalancing(const TaskData& taskData, ReportData* reportData, PhaseTimings* timings, ScenarioState& state) const {
+	TraceScope trace{ "prepare_balancing", "scenario" };
+	// which components run, and in which order, is decided once per shape of scenario
+	const ExecutionPlan& plan = state.plan;
+
+	// The state before the balancing loop can be reused from an earlier scenario (but not when reporting the timeseries)
+	std::optional<PreBalancingKey> preBalancingKey;
+	std::shared_ptr<const PreBalancingSnapshot> snapshot = state.snapshot;
+	if (!snapshot && mPreBalancingCache && !reportData) {
+		preBalancingKey.emplace(taskData);
+		snapshot = mPreBalancingCache->lookup(*preBalancingKey);
+	}
+
+	// class of arrays for running totals (replace ESUM and Heat)
+	TempSum& tempSum = snapshot ? state.tempSum.emplace(snapshot->tempSum) : state.tempSum.emplace(mSiteData);
+
+	SimulationTotals& totals = state.totals;
+	if (snapshot) {
+		totals = snapshot->totals;
+	}
+	// components only need to keep a history of their internal state for the timeseries we are reporting
+	const ReportColumnMask history = reportData ? reportData->requested() : ReportColumnMask{};
+
+	// The tariff statistics are precalculated for every tariff when the Simulator is constructed
+	size_t tariff_index = taskData.grid ? taskData.grid->tariff_index : 0;
+
+	const DayTariffStats& tariffStats = *mTariffStats[tariff_index];
+
+
+	// the hot water cylinder is heated by the heatpump, so the instant water heater can be deferred
+	const bool heatPumpCanSupplyDHW = plan.hotWaterCylinder;
+
+	// Make the components that don't depend on the energy balances; in low-latency mode these are made together
+	// (the hotel is the first to apply its demands, so it does so straight away)
+	ThreadPool* pool = stagePool(reportData);
+	std::optional<ReportData::SharedWrites> sharedWrites;
+	if (pool) {
+		reportData->reserve(static_cast<Eigen::Index>(mSiteData.timesteps));
+		sharedWrites.emplace(*reportData);
+	}
+	StageGroup stages(pool);
+
+	std::optional<BasicPV> pv;
+	std::optional<BasicElectricVehicle> fixedEV;
+
+	if (!snapshot) {
+		if (plan.hotel) {
+			stages.run([&] {
+				ScopedPhaseTimer timer{ timings, &PhaseTimings::hotel };
+				Hotel hotel(mSiteData, taskData.building.value());
+				hotel.AllCalcs(tempSum);
+				hotel.ReportTotals(totals);
+				if (reportData) {
+					hotel.Report(*reportData);
+				}
+			});
+		}
+
+		if (plan.pv) {
+			stages.run([&] {
+				ScopedPhaseTimer timer{ timings, &PhaseTimings::pv };
+				pv.emplace(mSiteData, taskData.solar_panels);
+				pv->ReportTotals(totals);
+				if (reportData) {
+					pv->Report(*reportData);
+				}
+			});
+		}
+	}
 
-	if (taskData.mop) {
-		Mop mop(mSiteData, taskData.mop.value());
-		mop.AllCalcs(tempSum);
-		mop.Report(reportData);
+	// Construct components that may be in the balancing loop
+
+	if (plan.ess) {
+		stages.run([&] {
+			ScopedPhaseTimer timer{ timings, &PhaseTimings::ess };
+			if (state.carried && state.carried->ess_charge) {
+				// continue from the charge at the end of the timesteps before these
+				EnergyStorageSystem carriedESS = taskData.energy_storage_system.value();
+				carriedESS.initial_charge = *state.carried->ess_charge;
+				state.ess.emplace(mSiteData, carriedESS, tariff_index, tariffStats, history);
+			}
+			else {
+				state.ess.emplace(mSiteData, taskData.energy_storage_system.value(), tariff_index, tariffStats, history);
+			}
+		});
+	}
+
+	// both EVs are one stage, as they are timed in the same phase
+	const bool buildFixedEV = plan.fixedEV && !snapshot;
+	if (plan.ev || buildFixedEV) {
+		stages.run([&] {
+			ScopedPhaseTimer timer{ timings, &PhaseTimings::ev };
+			if (plan.ev) {
+				state.ev.emplace(mSiteData, taskData.electric_vehicles.value());
+			}
+			if (buildFixedEV) {
+				fixedEV.emplace(mSiteData, taskData.electric_vehicles.value());
+			}
+		});
+	}
+
+	// TODO - as we can return an invalid result here, we should do this earlier
+	auto& dataCentre = state.dataCentre;
+	auto& ambientController = state.ambientController;
+
+	if (plan.dataCentre == ExecutionPlan::DataCentreKind::WITH_ASHP) {
+		stages.run([&] {
+			ScopedPhaseTimer timer{ timings, &PhaseTimings::data_centre };
+			// make a DataCentre with a hotroom heatpump
+			// The reference table is for a 1KW heatpump, so we scale it by the modelled ASHP Power per timestep
+			const float powerScalar = taskData.heat_pump->heat_power * mSiteData.timestep_hours;
+			dataCentre.emplace<DataCentreWithASHP>(mSiteData, taskData.data_centre.value(),
+				mHotRoomProfiles->get(mHeatPumpLookup, *mAmbientHeatPumpProfile, powerScalar, taskData.data_centre->hotroom_temp));
+		});
+	}
+	else if (plan.dataCentre == ExecutionPlan::DataCentreKind::BASIC) {
+		// make a basic data centre (without a heatpump)
+		stages.run([&] {
+			ScopedPhaseTimer timer{ timings, &PhaseTimings::data_centre };
+			dataCentre.emplace<BasicDataCentre>(mSiteData, taskData.data_centre.value());
+		});
+	}
+
+	// the ambient heatpump only runs before the balancing loop, so isn't needed if that state is cached
+	if (plan.ambientHeatPump && !snapshot) {
+		stages.run([&] {
+			ScopedPhaseTimer timer{ timings, &PhaseTimings::heat_pump };
+			ambientController.emplace(mSiteData, taskData.heat_pump.value(), heatPumpCanSupplyDHW, *mAmbientHeatPumpProfile);
+		});
+	}
+
+	stages.wait();
+
+	// Run through the pre balancing loop components, in turn as each one acts on the balances left by the last
+
+	if (pv) {
+		ScopedPhaseTimer timer{ timings, &PhaseTimings::pv };
+		pv->AllCalcs(tempSum);
+	}
+
+	if (fixedEV) {
+		ScopedPhaseTimer timer{ timings, &PhaseTimings::ev };
+		fixedEV->AllCalcs(tempSum);
+		fixedEV->ReportTotals(totals);
+		if (reportData) {
+			fixedEV->Report(*reportData);
+		}
+	}
+
+	if (plan.hotWaterCylinder && !snapshot) {
+		ScopedPhaseTimer timer{ timings, &PhaseTimings::hot_water_cylinder };
+		HotWaterCylinder hotWaterCylinder{ mSiteData, taskData.domestic_hot_water.value(), taskData.heat_pump.value(), tariffStats, history };
+		if (state.carried && state.carried->cylinder_energy) {
+			hotWaterCylinder.continueFrom(*state.carried->cylinder_energy);
+		}
+		hotWaterCylinder.AllCalcs(tempSum, mDayBlock);
+		if (state.carried) {
+			state.carried->cylinder_energy = hotWaterCylinder.getEnergy();
+		}
+		if (reportData) {
+			hotWaterCylinder.Report(*reportData);
+		}
 	}
 
-	if (!taskData.gas_heater && heatPumpCanSupplyDHW) {
+	if (plan.instantWaterHeater && !snapshot) {
 		// If there's no gas heater, we assume a resistive heating component to meet DHW
-		// In this context, the water heater has been deferred until after the balancing loop
-		InstantWaterHeater iwh(mSiteData);
+		// We can only run this here if there's no heatpump in balancing loop, otherwise it is deferred
+		ScopedPhaseTimer timer{ timings, &PhaseTimings::instant_water_heater };
+		InstantWaterHeater iwh(mSiteData, history);
 		iwh.AllCalcs(tempSum);
-		iwh.Report(reportData);
+		if (reportData) {
+			iwh.Report(*reportData);
+		}
 	}
 
-	if (taskData.grid && taskData.building) {
-		Grid grid(mSiteData, taskData.grid.value(), taskData.building.value());
-		grid.AllCalcs(tempSum);
-		grid.Report(reportData);
+	if (ambientController) {
+		ScopedPhaseTimer timer{ timings, &PhaseTimings::heat_pump };
+		ambientController->AllCalcs(tempSum);
+		if (!reportData) {
+			// the controller is only kept to report its timeseries
+			ambientController.reset();
+		}
 	}
 
-	if (taskData.gas_heater) {
-		GasCombustionHeater GasCH(mSiteData, taskData.gas_heater.value());
-		GasCH.AllCalcs(tempSum);
-		GasCH.Report(reportData);
+	if (!snapshot && (preBalancingKey || state.keepSnapshot)) {
+		snapshot = std::make_shared<const PreBalancingSnapshot>(PreBalancingSnapshot{ tempSum, totals });
+		if (preBalancingKey) {
+			mPreBalancingCache->insert(*preBalancingKey, snapshot);
+		}
+	}
+	if (state.keepSnapshot) {
+		state.snapshot = snapshot;
 	}
 
-	tempSum.Report(reportData);
-	ESSmain->Report(reportData);
-	if (flags.dataCentrePresent()) {
-		dataCentre->Report(reportData);
+	if (plan.fixedDataCentre) {
+		ScopedPhaseTimer timer{ timings, &PhaseTimings::data_centre };
+		state.getDataCentre()->AllCalcs(tempSum);
 	}
 
-	if (ambientController) {
-		// There is a heatpump and no DataCentre
-		ambientController->Report(reportData);
+	if (reportData) {
+		tempSum.ReportBeforeBalancingLoop(*reportData);
 	}
 
-	return reportData;
+
+	state.availableGridImport = getFixedAvailableImport(taskData);
+}
+
+SimulationTotals Simulator::finishTimesteps(const TaskData& taskData, ReportData* reportData, PhaseTimings* timings,
+	Eigen::VectorXf* tariffCosts, ScenarioState& state) const {
+	TraceScope trace{ "finish_timesteps", "scenario" };
+	const ExecutionPlan& plan = state.plan;
+	TempSum& tempSum = *state.tempSum;
+	SimulationTotals& totals = state.totals;
+	DataCentre* dataCentre = state.getDataCentre();
+
+	// Run through the post balancing loop components
+
+	std::optional<GasCombustionHeater> gasCH;
+	if (plan.gasHeater) {
+		ScopedPhaseTimer timer{ timings, &PhaseTimings::gas_ch };
+		gasCH.emplace(mSiteData, taskData.gas_heater.value());
+		gasCH->AllCalcs(tempSum);
+	}
+
+	// Once the gas heater has met what heat it can, the grid is the only stage left to act on the balances,
+	// so the reports and totals of the other components can be made alongside it in low-latency mode
+	ThreadPool* pool = stagePool(reportData);
+	std::optional<ReportData::SharedWrites> sharedWrites;
+	if (pool) {
+		reportData->reserve(static_cast<Eigen::Index>(mSiteData.timesteps));
+		sharedWrites.emplace(*reportData);
+	}
+	StageGroup stages(pool);
+
+	if (gasCH) {
+		stages.run([&] {
+			ScopedPhaseTimer timer{ timings, &PhaseTimings::gas_ch };
+			gasCH->ReportTotals(totals);
+			if (reportData) {
+				gasCH->Report(*reportData);
+			}
+		});
+	}
+
+	stages.run([&] {
+		// The Mop, Grid and the deferred water heater only act on the electricity balance (and the gas heater only on the heat),
+		// so they are made in a single pass that also accumulates the totals of TempSum
+		// If there's no gas heater, we assume a resistive heating component to meet DHW
+		// In this context, the water heater has been deferred until after the balancing loop
+		ScopedPhaseTimer timer{ timings, &PhaseTimings::post_balancing };
+		PostBalancing postBalancing(mSiteData, taskData, plan.deferredWaterHeater);
+		postBalancing.AllCalcs(tempSum, totals, reportData, *mImportTariffs, tariffCosts);
+	});
+
+	stages.run([&] {
+		ScopedPhaseTimer timer{ timings, &PhaseTimings::totals };
+		if (dataCentre) {
+			dataCentre->ReportTotals(totals);
+		}
+
+		if (reportData) {
+			if (state.ess) {
+				state.ess->Report(*reportData);
+			}
+			if (dataCentre) {
+				dataCentre->Report(*reportData);
+			}
+
+			if (state.ambientController) {
+				// There is a heatpump and no DataCentre
+				state.ambientController->Report(*reportData);
+			}
+		}
+	});
+
+	stages.wait();
+
+	ScopedPhaseTimer timer{ timings, &PhaseTimings::totals };
+	if (reportData) {
+		// the heat balances are only final once the grid has met any deferred hot water
+		tempSum.Report(*reportData);
+	}
+
+	return totals;
+}
+
+SimulationResult Simulator::makeCancelledResult(const TaskData& taskData) const {
+	SimulationResult result = makeInvalidResult(taskData);
+	result.baseline_metrics = baseline().metrics;
+	result.cancelled = true;
+	return result;
 }
 
 SimulationResult Simulator::makeInvalidResult([[maybe_unused]] const TaskData& taskData) const {
@@ -340,44 +2220,25 @@ SimulationResult Simulator::makeInvalidResult([[maybe_unused]] const TaskData& t
 	return result;
 }
 
-CostVectors Simulator::extractCostVectors(const ReportData& reportData, const TaskData& taskData) const {
-	CostVectors costVectors;
-
-	// If the components that create these vectors are not present then the vectors in reportData may be empty
-	// we instead need them to be 0 valued but of timestep length
-	costVectors.actual_ev_load_e = reportData.EV_actualload.size() ? reportData.EV_actualload : Eigen::VectorXf::Zero(mSiteData.timesteps);
-	costVectors.actual_data_centre_load_e = reportData.Data_centre_actual_load.size() ? reportData.Data_centre_actual_load : Eigen::VectorXf::Zero(mSiteData.timesteps);
-	costVectors.building_load_e = reportData.Hotel_load.size() ? reportData.Hotel_load : Eigen::VectorXf::Zero(mSiteData.timesteps);
-	costVectors.heatload_h = reportData.Heatload.size() ? reportData.Heatload : Eigen::VectorXf::Zero(mSiteData.timesteps);
-	costVectors.gas_import_h = reportData.GasCH_load.size() ? reportData.GasCH_load : Eigen::VectorXf::Zero(mSiteData.timesteps);
-	costVectors.grid_import_e = reportData.Grid_Import.size() ? reportData.Grid_Import : Eigen::VectorXf::Zero(mSiteData.timesteps);
-	costVectors.grid_export_e = reportData.Grid_Export.size() ? reportData.Grid_Export : Eigen::VectorXf::Zero(mSiteData.timesteps);
-	costVectors.actual_low_priority_load_e = reportData.MOP_load.size() ? reportData.MOP_load : Eigen::VectorXf::Zero(mSiteData.timesteps);
-
-	float fixed_export_price = taskData.grid ? taskData.grid->export_tariff : 0.0f;
-	costVectors.grid_export_prices = Eigen::VectorXf::Constant(mSiteData.timesteps, fixed_export_price);
-
-	return costVectors;
-}
-
-SimulationMetrics Simulator::calculateMetrics(const TaskData& taskData, const ReportData& reportData, const UsageData& usage) const {
+SimulationMetrics Simulator::calculateMetrics(const TaskData& taskData, const SimulationTotals& totals, const UsageData& usage,
+	std::span<const ComponentView> components, PhaseTimings* timings) const {
 	SimulationMetrics metrics{};
 
 	// energy totals in kWh
-	metrics.total_gas_used = reportData.GasCH_load.sum();
-	metrics.total_electricity_imported = reportData.Grid_Import.sum();
-	metrics.total_electricity_generated = reportData.PVacGen.sum();
-	metrics.total_electricity_exported = reportData.Grid_Export.sum();
-	metrics.total_electricity_curtailed = reportData.Actual_curtailed_export.sum();
+	metrics.total_gas_used = totals.gas_import_h;
+	metrics.total_electricity_imported = totals.grid_import_e;
+	metrics.total_electricity_generated = totals.pv_generation_e;
+	metrics.total_electricity_exported = totals.grid_export_e;
+	metrics.total_electricity_curtailed = totals.curtailed_export_e;
 	metrics.total_electricity_used = 
 		(metrics.total_electricity_imported + metrics.total_electricity_generated) 
 		- (metrics.total_electricity_exported + metrics.total_electricity_curtailed);
 
-	metrics.total_electrical_shortfall = reportData.Actual_import_shortfall.sum();
+	metrics.total_electrical_shortfall = totals.import_shortfall_e;
 
-	metrics.total_heat_shortfall = reportData.Heat_shortfall.sum();
-	metrics.total_ch_shortfall = reportData.CH_shortfall.sum();
-	metrics.total_dhw_shortfall = reportData.DHW_Shortfall.sum();
+	metrics.total_heat_shortfall = totals.heat_shortfall_h;
+	metrics.total_ch_shortfall = totals.ch_shortfall_h;
+	metrics.total_dhw_shortfall = totals.dhw_shortfall_h;
 
 	// calculate the maximum heat our components can produce
 	float component_heat = 0.0f;
@@ -400,8 +2261,8 @@ SimulationMetrics Simulator::calculateMetrics(const TaskData& taskData, const Re
 	}
 	metrics.peak_hload_shortfall = std::max(required_peak_hload - component_heat, 0.0f);
 
-	metrics.total_ch_load = reportData.CH_demand.sum() - metrics.total_ch_shortfall;
-	metrics.total_dhw_load = reportData.DHW_demand.sum() - metrics.total_dhw_shortfall;
+	metrics.total_ch_load = totals.ch_demand_h - metrics.total_ch_shortfall;
+	metrics.total_dhw_load = totals.dhw_demand_h - metrics.total_dhw_shortfall;
 	metrics.total_heat_load = metrics.total_dhw_load + metrics.total_ch_load;
 
 	// financial totals in £
@@ -413,7 +2274,11 @@ SimulationMetrics Simulator::calculateMetrics(const TaskData& taskData, const Re
 	metrics.total_meter_cost = usage.total_meter_cost;
 	metrics.total_operating_cost = usage.total_operating_cost;
 
-	auto valueMetrics = calculate_npv(mSiteData, mConfig, taskData, usage);
+	ValueMetrics valueMetrics;
+	{
+		ScopedPhaseTimer timer{ timings, &PhaseTimings::npv };
+		valueMetrics = calculate_npv(mCostEngine->discounts(), components, usage);
+	}
 	metrics.total_annualised_cost = valueMetrics.annualised_cost;
 	metrics.total_net_present_value = valueMetrics.net_present_value;
 
@@ -439,15 +2304,14 @@ SimulationMetrics Simulator::calculateMetrics(const TaskData& taskData, const Re
 // to import from the Grid but there may not be a grid.
 // 
 // Because the available import is constant throughout all timesteps when there is a grid
-// we can just construct a grid and immediately throw it away to calculate the import available.
+// we can calculate the import available from the grid's capacity alone.
 // 
 // If there is no grid, we instead return 0
 //  
 float Simulator::getFixedAvailableImport(const TaskData& taskData) const
 {
 	if (taskData.grid && taskData.building) {
-		Grid grid(mSiteData, taskData.grid.value(), taskData.building.value());
-		return grid.AvailImport();
+		return PostBalancing::importCapacity(mSiteData, taskData.grid.value());
 	}
 	// else 0
 	return 0.0f;
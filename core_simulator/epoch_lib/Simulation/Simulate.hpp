@@ -1,55 +1,724 @@
 #pragma once
 
 #include <Eigen/Core>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
 #include <vector>
 #include <string>
+#include <string_view>
 
 #include "../Definitions.hpp"
 #include "TaskData.hpp"
 #include "SiteData.hpp"
 #include "TempSum.hpp"
 #include "Costs/Capex.hpp"
+#include "Costs/CostEngine.hpp"
 #include "Costs/Usage.hpp"
+#include "ASHPLookup.hpp"
+#include "BatchBackend.hpp"
+#include "BatchControl.hpp"
+#include "CarriedState.hpp"
+#include "DayBlocks.hpp"
+#include "DayTariffStats.hpp"
+#include "DaysOfInterest.hpp"
+#include "Ensemble.hpp"
+#include "ESSSweep.hpp"
+#include "ExecutionPlan.hpp"
+#include "MemoryFootprint.hpp"
+#include "PreBalancingCache.hpp"
+#include "RepresentativeDays.hpp"
+#include "ResultCache.hpp"
+#include "ScenarioCostModel.hpp"
+#include "ScenarioError.hpp"
+#include "Sensitivity.hpp"
+#include "SiteUpdate.hpp"
+#include "TariffPricing.hpp"
+#include "TimestampIndex.hpp"
+#include "ThreadPool.hpp"
+#include "UpgradeTree.hpp"
 
 
 enum class SimulationType {
 	FullReporting,
-	ResultOnly
+	ResultOnly,
+	// screen the scenario on the representative days (see enableRepresentativeDays)
+	RepresentativeDays
+};
+
+
+/**
+* The simulated baseline of a Simulator, which every scenario is compared against
+*/
+struct SimulatorBaseline {
+	UsageData usage;
+	SimulationMetrics metrics;
+	// the columns reported by the baseline, which are shared by every FullReporting result
+	std::shared_ptr<const ReportData> reportData;
 };
 
 
 class Simulator {
 public:
+	/**
+	* Construct a Simulator of a site
+	* The baseline is not simulated until it is first needed (see getBaseline),
+	* so a Simulator that only validates scenarios or calculates their capex never simulates it
+	*/
 	explicit Simulator(SiteData siteData, TaskConfig config);
 
+	/**
+	* Construct a Simulator that shares its (immutable) SiteData with other Simulators
+	* This avoids a deep copy of every timeseries when several configs are run against the same site
+	*/
+	explicit Simulator(std::shared_ptr<const SiteData> siteData, TaskConfig config);
+
+	/**
+	* Construct a Simulator with a baseline that has already been simulated (such as one restored from a snapshot)
+	* The baseline must be that of a Simulator with the same SiteData and config; it is not simulated again
+	*/
+	explicit Simulator(std::shared_ptr<const SiteData> siteData, TaskConfig config, SimulatorBaseline baseline);
+
+	/**
+	* Simulate a single scenario against this Simulator's SiteData
+	* 
+	* This does not modify the Simulator, so it is safe to call concurrently from multiple threads
+	*/
 	SimulationResult simulateScenario(const TaskData& taskData, SimulationType simulationType = SimulationType::ResultOnly) const;
 
+	/**
+	* Simulate a scenario, unless its capex is outside the constraints
+	* A scenario that violates the constraints returns immediately with its capex, the worst value
+	* for every other objective (as for an invalid scenario) and violates_constraints set
+	*
+	* A ResultOnly scenario is also stopped as soon as it provably exceeds a shortfall limit: either before the balancing loop
+	* (from the most that its ESS could discharge) or part way through it. It returns as above, with terminated_early set
+	* and the shortfall found so far. A scenario within the limits has the same result as without them.
+	*/
+	SimulationResult simulateScenario(const TaskData& taskData, SimulationType simulationType, const ScenarioConstraints& constraints) const;
+
+	/**
+	* Simulate a scenario with FullReporting, but only report the given columns
+	* The components don't record the history of any other column, and the baseline_report_data
+	* is restricted to the same columns (unless every column is requested, when the baseline is shared as usual)
+	*/
+	SimulationResult simulateScenario(const TaskData& taskData, ReportColumnMask columns, const ScenarioConstraints& constraints = {}) const;
+
+	/**
+	* Simulate many scenarios in parallel on the shared thread pool
+	* The results are returned in the same order as the scenarios
+	*
+	* The scenarios are grouped by the state they share, such as their heat load, solar and tariff columns
+	* and their state before the balancing loop (see planBatch), so each thread runs those that share it one after another.
+	*
+	* ResultOnly scenarios whose balancing loop only has a CONSUME ESS and/or a balancing EV are grouped by
+	* those components and simulated LOCKSTEP_LANES at a time through the lock-step balancing loop.
+	* The results are the same as simulating each scenario on its own, though the runtime of each
+	* scenario in a group is its share of the group's runtime.
+	*/
+	std::vector<SimulationResult> simulateBatch(std::span<const TaskData> taskData, SimulationType simulationType = SimulationType::ResultOnly) const;
+
+	/**
+	* Overload of simulateBatch to run on a specific thread pool
+	*/
+	std::vector<SimulationResult> simulateBatch(std::span<const TaskData> taskData, SimulationType simulationType, ThreadPool& pool) const;
+
+	/**
+	* Overload of simulateBatch that skips the simulation of every scenario whose capex is outside the constraints
+	*/
+	std::vector<SimulationResult> simulateBatch(std::span<const TaskData> taskData, SimulationType simulationType,
+		const ScenarioConstraints& constraints, ThreadPool& pool = ThreadPool::shared()) const;
+
+	/**
+	* Overload of simulateBatch that reports its progress to control, and skips the remaining scenarios once it is stopped
+	* The skipped scenarios return makeCancelledResult, so the batch returns promptly with the results so far
+	*/
+	std::vector<SimulationResult> simulateBatch(std::span<const TaskData> taskData, SimulationType simulationType,
+		const ScenarioConstraints& constraints, BatchControl& control, ThreadPool& pool = ThreadPool::shared()) const;
+
+	/**
+	* Whether the dispatch of a scenario is the same whichever import tariff it uses
+	* The tariff only changes the dispatch through a CONSUME_PLUS or PRICE_LOOKAHEAD ESS or the hot water cylinder (DHW with a heatpump)
+	*/
+	static bool isTariffIndependent(const TaskData& taskData);
+
+	/**
+	* Simulate a scenario against every one of the SiteData's import tariffs (ignoring its own tariff_index)
+	* The result at position i is for tariff_index i
+	*
+	* When the scenario is tariff independent, the timesteps are only simulated once and the
+	* grid import is priced against every tariff in a single matrix-vector product.
+	* Otherwise, each tariff is simulated in turn.
+	* The runtime of each result is the runtime of the whole call.
+	*/
+	std::vector<SimulationResult> simulateAllTariffs(const TaskData& taskData) const;
+
+	/**
+	* Find the days of interest of a scenario (such as the day with the most heat shortfall) without reporting its timeseries
+	*
+	* Only the DAYS_OF_INTEREST_COLUMNS are recorded while the scenario is simulated, and they are reduced to daily totals
+	* over the days of its import tariff's DayTariffStats, so nothing as long as the timeseries is returned.
+	* Raise an exception if the scenario is invalid
+	*/
+	DaysOfInterest daysOfInterest(const TaskData& taskData) const;
+
+	/**
+	* Optimistic bounds on the objectives of a scenario without simulating its balancing loop or anything after it,
+	* so that a search can discard the candidates that couldn't improve on what it has already found (see objectiveCostBound)
+	*
+	* The capex and annualised cost are exact. The components before the balancing loop are run as usual,
+	* and each timestep's balance is then bounded by the most its ESS could discharge (every other balancing component only adds load):
+	* the least import and the most export and Mop load follow from that balance, and the balancing EV and data centre
+	* are given their full target loads. These optimistic totals are costed as a simulation's would be.
+	*/
+	ObjectiveBounds boundObjectives(const TaskData& taskData) const;
+
+	/**
+	* boundObjectives for a batch of candidates in parallel on the pool, in the same order as the candidates
+	* The candidates that share a state before the balancing loop (such as those that only differ in their ESS or grid)
+	* are bounded one after another from that state, so the components before the loop only run once for them.
+	*/
+	std::vector<ObjectiveBounds> boundObjectives(std::span<const TaskData> taskData, ThreadPool& pool = ThreadPool::shared()) const;
+
+	/**
+	* Estimate the derivative of each objective of a scenario with respect to each of the perturbed parameters
+	*
+	* Every perturbed scenario is simulated (ResultOnly) in parallel on the pool.
+	* The base scenario is simulated once, and perturbations that don't change the state before the balancing loop
+	* (those of the ESS and grid import) start from its state rather than running Hotel, PV and the hot water again.
+	* Raise an exception if the base scenario is invalid, or a perturbation is of a component it doesn't have
+	*/
+	SensitivityResult sensitivities(const TaskData& base, std::span<const Perturbation> perturbations,
+		SensitivityScheme scheme = SensitivityScheme::Central, ThreadPool& pool = ThreadPool::shared()) const;
+
+	/**
+	* Simulate (ResultOnly) the base scenario with each of the sizes of its ESS, returning one result per size in the same order
+	*
+	* The sizes share everything but the ESS, so the components before the balancing loop are only run once, for the base.
+	* A CONSUME ESS is then balanced LOCKSTEP_LANES sizes at a time in lock-step (or by the batch backend, if there is one),
+	* and any other ESS one size per thread; the components after the loop and the costs are run for each size on the pool.
+	* Raise an exception if the base scenario is invalid or has no ESS, or a size is negative
+	*/
+	std::vector<SimulationResult> sweepESS(const TaskData& base, std::span<const ESSSize> sizes,
+		ThreadPool& pool = ThreadPool::shared()) const;
+
+	/**
+	* Simulate (ResultOnly) the base scenario with every combination of the upgrades, applied in their order
+	*
+	* The tree is explored a tier at a time (by the number of upgrades), simulating each tier's nodes in parallel on the pool.
+	* A node that only adds an upgrade which doesn't change the state before the balancing loop (such as an ESS or grid)
+	* starts from the state of the parent without it, and every node shares the memoised component costs.
+	* An invalid node has the result of an invalid scenario.
+	* The base is usually also the SiteData's baseline, so that each node is compared against the site without upgrades.
+	* Raise an exception if there are more than MAX_UPGRADES upgrades
+	*/
+	UpgradeTreeResult simulateUpgradeTree(const TaskData& base, std::span<const Upgrade> upgrades,
+		ThreadPool& pool = ThreadPool::shared()) const;
+
+	/**
+	* Simulate a scenario against every member of the SiteData's ensemble in parallel, returning the spread of its objectives
+	*
+	* Each member is compared against the baseline under its own weather and demand.
+	* The tariff statistics, heatpump tables and costs are shared by every member, so the capex is only calculated once.
+	* Raise an exception if there is no ensemble or the scenario is invalid
+	*/
+	EnsembleResult simulateEnsemble(const TaskData& taskData, ThreadPool& pool = ThreadPool::shared()) const;
+
+	/**
+	* Overload of simulateEnsemble that reports its progress to control, and skips the remaining members once it is stopped
+	*/
+	EnsembleResult simulateEnsemble(const TaskData& taskData, BatchControl& control, ThreadPool& pool = ThreadPool::shared()) const;
+
+	// the number of members of the SiteData's ensemble
+	size_t ensembleMembers() const { return mEnsemble.size(); }
+
 	/**
 	* Perform validation that the data in the SiteData and TaskData are aligned
 	* Raise an exception if they are not compatible
 	*/
 	void validateScenario(const TaskData& taskData) const;
 
+	/**
+	* The same checks as validateScenario, without throwing or allocating
+	* Returns every reason the scenario is invalid as a bitmask, or ScenarioError::None
+	*/
+	ScenarioError checkScenario(const TaskData& taskData) const noexcept;
+
+	/**
+	* Check a whole population of scenarios at once, writing the errors of each to the matching element of errors
+	*/
+	void checkScenarios(std::span<const TaskData> taskData, std::span<ScenarioError> errors) const;
+
+	// a message describing each of the errors of the scenario (as raised by validateScenario)
+	std::string describeScenarioError(const TaskData& taskData, ScenarioError errors) const;
+
 	/**
 	* Calculate the Capital Expenditure (upfront costs) for a given site
 	* returns an object containing the total cost and a breakdown per component
 	*/
 	CapexBreakdown calculateCapexWithDiscounts(const TaskData& taskData) const;
 
+	/**
+	* The result of a scenario that was skipped because its batch was stopped:
+	* the worst value for every objective (as for an invalid scenario) with cancelled set
+	*/
+	SimulationResult makeCancelledResult(const TaskData& taskData) const;
+
+	/**
+	* A Simulator of this site with the columns of update replaced and added (see SiteUpdate),
+	* such as when a new tariff quote arrives or a site's meter data is refreshed
+	*
+	* Everything that doesn't depend on a changed column is shared rather than derived again:
+	* the statistics of the unchanged tariffs, the heatpump profiles (unless the air temperature changes),
+	* the execution plans and learned runtimes, and the baseline itself unless update affects it
+	* (in which case it is simulated again when it is first needed, as for a new Simulator).
+	* The caches and representative days that are enabled on this Simulator are enabled again on the new one, but start empty.
+	* This Simulator is unchanged, so scenarios being simulated on it are unaffected.
+	* Raise an exception if the updated SiteData is invalid
+	*/
+	std::shared_ptr<Simulator> withSiteUpdate(const SiteUpdate& update) const;
+
+	/**
+	* Get the SiteData used by this Simulator, so that it can be shared with another Simulator
+	*/
+	std::shared_ptr<const SiteData> getSiteData() const { return mSiteDataPtr; }
+
+	const TaskConfig& getConfig() const { return mConfig; }
+
+	/**
+	* Get the start of every timestep (see makeTimestampIndex), to index the timeseries of this site's results by
+	*
+	* The index is made the first time it is needed and then shared, so this is cheap to call for every result.
+	* This is safe to call concurrently.
+	*/
+	std::shared_ptr<const TimestampIndex> getTimestamps() const;
+
+	/**
+	* Get the baseline that every scenario is compared against, so that it can be reused by another Simulator
+	*
+	* The baseline is simulated (or read from the baseline cache) the first time it is needed,
+	* which is usually the first scenario to be simulated. This is safe to call concurrently.
+	*/
+	SimulatorBaseline getBaseline() const { return baseline(); }
+
+	// whether the baseline has been simulated (or was provided) yet
+	bool hasBaseline() const { return mBaseline->ready.load(std::memory_order_acquire); }
+
+	/**
+	* Cache the baseline in directory, keyed by the content of the SiteData and config (see baselineCacheKey)
+	*
+	* When the baseline is needed, it is read from the cache if it is there, and otherwise simulated and written to it,
+	* so each site is only simulated once by every process that shares the directory.
+	* The members of the ensemble and the other resolutions always simulate their own baselines.
+	*
+	* This has no effect once the baseline has been simulated, and must not be called while scenarios are being simulated
+	*/
+	void enableBaselineCache(std::filesystem::path directory);
+
+	/**
+	* The daily statistics of an import tariff and the reference heatpump's ambient profile
+	* These are derived from the SiteData's columns, so are shared by Simulators whose columns are interned by one SeriesStore
+	*/
+	const DayTariffStats& getTariffStats(size_t tariffIndex) const { return *mTariffStats.at(tariffIndex); }
+	const HeatPumpProfile& getAmbientHeatPumpProfile() const { return *mAmbientHeatPumpProfile; }
+
+	/**
+	* Cache the results of ResultOnly scenarios, using at most (approximately) byteBudget bytes
+	* The cache is shared by every thread simulating with this Simulator, including batches
+	* 
+	* This replaces any existing cache and must not be called while scenarios are being simulated
+	*/
+	void enableResultCache(size_t byteBudget);
+
+	/**
+	* Get the hit/miss counters and memory use of the result cache, if it is enabled
+	*/
+	std::optional<CacheStats> getResultCacheStats() const;
+
+	void clearResultCache();
+
+	/**
+	* Cache the energy balances before the balancing loop, using at most (approximately) byteBudget bytes
+	* Scenarios that only differ in their ESS, Grid, Mop, DataCentre or balancing EV then skip the
+	* components that run before the balancing loop (Hotel, PV, hot water and the ambient heatpump)
+	*
+	* Only ResultOnly scenarios use this cache.
+	* This replaces any existing cache and must not be called while scenarios are being simulated
+	*/
+	void enablePreBalancingCache(size_t byteBudget);
+
+	/**
+	* Get the hit/miss counters and memory use of the pre-balancing cache, if it is enabled
+	*/
+	std::optional<CacheStats> getPreBalancingCacheStats() const;
+
+	void clearPreBalancingCache();
+
+	/**
+	* Step a CONSUME ESS through the year in parallel blocks on pool (see runConsumeScan),
+	* when there is no balancing EV or DataCentre to couple it to the rest of the balancing loop
+	*
+	* This cuts the latency of a single scenario on a site with many timesteps; the results are the same.
+	* Batches already run a scenario per worker, so this is best left off for a Simulator that runs batches.
+	* This must not be called while scenarios are being simulated
+	*/
+	void enableParallelESS(ThreadPool& pool = ThreadPool::shared()) { mParallelESSPool = &pool; }
+
+	void disableParallelESS() { mParallelESSPool = nullptr; }
+
+	/**
+	* Overlap the independent stages of each FullReporting scenario on pool, for when one scenario is waited on at a time
+	*
+	* The components before the balancing loop are made together (such as the PV generation alongside the hotel's demands),
+	* the component reports and totals after it are written alongside the grid, and a CONSUME ESS is stepped
+	* as with enableParallelESS. Each balance is still applied in the same order, so the results are the same.
+	* ResultOnly scenarios, and so batches, are unaffected.
+	* This must not be called while scenarios are being simulated
+	*/
+	void enableLowLatency(ThreadPool& pool = ThreadPool::shared()) { mLowLatencyPool = &pool; }
+
+	void disableLowLatency() { mLowLatencyPool = nullptr; }
+
+	/**
+	* Balance the lock-step scenarios of each ResultOnly batch with backend (see BatchBackend)
+	*
+	* The scenarios are prepared and finished on the batch's pool as before, a wave of backend->maxLanes() at a time,
+	* and only their balancing loops are run by the backend. The results are the same.
+	* This must not be called while scenarios are being simulated
+	*/
+	void enableBatchBackend(std::shared_ptr<BatchBackend> backend);
+
+	void disableBatchBackend() { mBatchBackend.reset(); }
+
+	// the backend that balances batches, or null to balance each job as it runs
+	const std::shared_ptr<BatchBackend>& getBatchBackend() const { return mBatchBackend; }
+
+	/**
+	* Get the hit/miss counters of the memoised component costs (which are always enabled)
+	*/
+	CacheStats getCostMemoStats() const;
+
+	/**
+	* The ExecutionPlan that simulateTimesteps follows for scenarios of the same shape as taskData
+	* Each plan is built the first time its shape is simulated and kept for the life of the Simulator
+	*/
+	const ExecutionPlan& getExecutionPlan(const TaskData& taskData) const { return mExecutionPlans->get(taskData); }
+
+	// the number of shapes of scenario simulated so far
+	size_t executionPlanCount() const { return mExecutionPlans->size(); }
+
+	/**
+	* The estimated runtime in seconds of a ResultOnly simulation of taskData (see ScenarioCostModel)
+	* This is learned from the batches and portfolios simulated so far, which use it to start the longest scenarios first
+	*/
+	float estimateRuntime(const TaskData& taskData) const;
+
+	/**
+	* Learn from the runtime of a ResultOnly result (results that weren't simulated are ignored)
+	*/
+	void observeRuntime(const TaskData& taskData, const SimulationResult& result) const;
+
+	/**
+	* An estimate of the heap memory in bytes held by this Simulator (see memoryBreakdown)
+	*/
+	size_t memoryFootprint() const;
+
+	/**
+	* The memoryFootprint of the SiteData (as site_data.<column>), the tariff and heatpump data derived from it,
+	* the baseline ReportData and each of the caches
+	* The Simulators of the ensemble, representative days and other resolutions are a part each.
+	* Anything that is shared (between this Simulator and those, or with other Simulators) is only counted once here,
+	* but is counted again by each of the other Simulators that share it.
+	*/
+	MemoryFootprint memoryBreakdown() const;
+
+	/**
+	* Prepare to simulate RepresentativeDays scenarios on (at most) numDays representative days
+	*
+	* Each day is simulated after the day before it, which warms up the state that carries over between days
+	* (the charge of the ESS and the hot water cylinder) without which every day would start from empty.
+	* The totals of the warm-up day (simulated on its own) are subtracted from those of the pair,
+	* and the remainder is weighted by the number of days it represents before calculating the metrics.
+	* The baseline is still the full simulation's.
+	*
+	* This replaces any existing representative days and must not be called while scenarios are being simulated
+	*/
+	void enableRepresentativeDays(size_t numDays);
+
+	// the representative days, if they are enabled
+	std::optional<RepresentativeDays> getRepresentativeDays() const;
+
+	/**
+	* Simulate each scenario both in full and on the representative days,
+	* returning the largest error of the representative days in each of the resultColumns
+	*/
+	std::vector<RepresentativeDaysError> representativeDaysError(std::span<const TaskData> sample) const;
+
+	/**
+	* Get a Simulator of this site that costs scenarios with config, sharing everything that doesn't depend on the costs
+	*
+	* The config only changes the costs and never the timesteps, so the baseline is costed from this Simulator's baseline totals
+	* rather than simulated again, and its timeseries are shared. Each config is built the first time it is requested,
+	* and is then shared by every later call (while it is one of the 256 most recently used). This is safe to call concurrently.
+	*/
+	std::shared_ptr<const Simulator> withConfig(const TaskConfig& config) const;
+
+	/**
+	* Simulate a scenario once and cost it with each of the configs, returning one result per config in the same order
+	* (for funding policy and discount rate studies)
+	*
+	* The timesteps are only simulated once; each config's baseline and memoised component costs are kept (see withConfig),
+	* so every further config only costs the scenario's usage and metrics.
+	* The runtime of each result is the runtime of the whole call.
+	*/
+	std::vector<SimulationResult> simulateConfigs(const TaskData& taskData, std::span<const TaskConfig> configs) const;
+
+	/**
+	* Get a Simulator of this site with a coarser timestep (such as an hour for 5 minute SiteData)
+	* The SiteData is downsampled by resampleSiteData, so interval must be a whole multiple of the timestep
+	*
+	* Each resolution is built the first time it is requested, and is then shared by every later call
+	* (so caches enabled on it are shared too). This is safe to call concurrently.
+	*/
+	std::shared_ptr<Simulator> atResolution(std::chrono::seconds interval) const;
+
 private:
-	ReportData simulateTimesteps(const TaskData& taskData, SimulationType simulationType = SimulationType::ResultOnly) const;
+	// a ChunkedSimulator is made of Simulators of its whole SiteData and of each of its windows
+	friend class ChunkedSimulator;
+
+	// the part of a Simulator that a ChunkedSimulator needs:
+	// a Window simulates the timesteps of one window, and a Summary calculates the results of the whole SiteData.
+	// Neither simulates a baseline, and a Summary has no timeseries of its own
+	enum class Part { Window, Summary };
+
+	// a Simulator of one Part, sharing costEngine unless it is null
+	explicit Simulator(std::shared_ptr<const SiteData> siteData, TaskConfig config, std::shared_ptr<const CostEngine> costEngine, Part part);
+
+	// a Simulator of a representative day and the day before it, and a Simulator of just the day before
+	// (the first day of the timeseries has no warm-up, just as in a full simulation)
+	struct RepresentativeDay {
+		std::shared_ptr<const Simulator> simulator;
+		std::shared_ptr<const Simulator> warmUp;
+		float weight;
+	};
+
+	// a Simulator whose baseline is simulated when it is first needed, unless it is provided
+	explicit Simulator(std::shared_ptr<const SiteData> siteData, TaskConfig config, std::optional<SimulatorBaseline> baseline);
+
+	// a Simulator of one member of the nominal Simulator's ensemble, sharing everything that the member doesn't change
+	explicit Simulator(const Simulator& nominal, size_t member);
+
+	// a Simulator of siteData (the SiteData of base with the columns of update changed), sharing everything that update doesn't change
+	explicit Simulator(const Simulator& base, std::shared_ptr<const SiteData> siteData, const SiteUpdate& update);
+
+	// a Simulator of the SiteData of base that costs scenarios with config, sharing everything else
+	// (and sharing costEngine, unless it is null)
+	explicit Simulator(const Simulator& base, TaskConfig config, std::shared_ptr<const CostEngine> costEngine = nullptr);
+
+	// a Simulator of each member of the SiteData's ensemble
+	void buildEnsemble();
+
+	// the baseline, which is simulated (or read from the baseline cache) by the first call
+	const SimulatorBaseline& baseline() const;
+	// simulate the baseline, setting baselineTotals to the totals it was calculated from
+	SimulatorBaseline simulateBaseline(SimulationTotals& baselineTotals) const;
+
+	// simulateBatch, reporting to control if it is set
+	std::vector<SimulationResult> runBatch(std::span<const TaskData> taskData, SimulationType simulationType,
+		const ScenarioConstraints& constraints, BatchControl* control, ThreadPool& pool) const;
+
+	// simulateEnsemble, reporting to control if it is set
+	EnsembleResult runEnsemble(const TaskData& taskData, BatchControl* control, ThreadPool& pool) const;
+
+	// calculate the baseline usage and metrics from its totals
+	void calculateBaseline(const SimulationTotals& baselineTotals, SimulatorBaseline& baseline) const;
+	// set the baseline from its totals and its timeseries, if it has any
+	// (the Summary of a ChunkedSimulator has no timeseries to report)
+	void setBaseline(const SimulationTotals& baselineTotals, std::shared_ptr<const ReportData> reportData = nullptr);
+
+	SimulationResult simulateRepresentativeDays(const TaskData& taskData) const;
+
+	/**
+	* Run every timestep of a scenario, returning the totals needed to calculate the metrics
+	* The full timeseries are only built when a ReportData is provided;
+	* otherwise components skip recording anything that isn't needed for the totals
+	* Likewise, the time spent in each component is only recorded when timings are provided
+	* If tariffCosts is provided, it is set to the cost of the grid import under each import tariff
+	*/
+	SimulationTotals simulateTimesteps(const TaskData& taskData, ReportData* reportData, PhaseTimings* timings = nullptr,
+		Eigen::VectorXf* tariffCosts = nullptr) const;
+
+	/**
+	* Run every timestep of a scenario, starting from the carried state and updating it to the state after the last timestep
+	*/
+	SimulationTotals simulateWindow(const TaskData& taskData, ReportData* reportData, CarriedState& carried) const;
+
+	// simulateTimesteps is split around the balancing loop so that several scenarios can be balanced together
+	// the pool to overlap the stages of a scenario on (see enableLowLatency), or nullptr to run them in turn
+	ThreadPool* stagePool(const ReportData* reportData) const { return reportData ? mLowLatencyPool : nullptr; }
+
+	struct ScenarioState;
+	void prepareBalancing(const TaskData& taskData, ReportData* reportData, PhaseTimings* timings, ScenarioState& state) const;
+	SimulationTotals finishTimesteps(const TaskData& taskData, ReportData* reportData, PhaseTimings* timings,
+		Eigen::VectorXf* tariffCosts, ScenarioState& state) const;
+
+	/**
+	* Simulate a (valid) ResultOnly scenario, starting from the state before the balancing loop in snapshot if it is set
+	* Otherwise, snapshot is set to this scenario's state before the balancing loop
+	*/
+	SimulationResult simulateFromSnapshot(const TaskData& taskData, std::shared_ptr<const PreBalancingSnapshot>& snapshot) const;
+
+	// boundObjectives, starting from (or otherwise setting) the state before the balancing loop in snapshot, as simulateFromSnapshot
+	ObjectiveBounds boundFromSnapshot(const TaskData& taskData, std::shared_ptr<const PreBalancingSnapshot>& snapshot) const;
+
+	/**
+	* Simulate (up to LOCKSTEP_LANES) ResultOnly scenarios with the same balancing components together,
+	* writing each result to results[index]
+	* Every scenario starts from the state before the balancing loop in snapshot, if it is set (they must all share that state)
+	*/
+	void simulateLockstep(std::span<const TaskData> taskData, std::span<const size_t> indices, std::span<SimulationResult> results,
+		const std::shared_ptr<const PreBalancingSnapshot>& snapshot = nullptr) const;
+
+	// simulateLockstep is split around the balancing loop so that the lanes of many groups can be balanced by a BatchBackend
+	struct LockstepGroup;
+	void prepareLockstep(std::span<const TaskData> taskData, std::span<const size_t> indices, std::span<SimulationResult> results,
+		LockstepGroup& group, const std::shared_ptr<const PreBalancingSnapshot>& snapshot = nullptr) const;
+	// share is the time spent balancing this group
+	void finishLockstep(std::span<const TaskData> taskData, std::span<SimulationResult> results, LockstepGroup& group,
+		float share) const;
+
+	// the lock-step jobs of a batch, balanced by mBatchBackend a wave at a time
+	void runBackendJobs(std::span<const TaskData> taskData, std::span<const std::vector<size_t>> jobs,
+		std::span<SimulationResult> results, BatchControl* control, ThreadPool& pool,
+		const std::shared_ptr<const PreBalancingSnapshot>& snapshot = nullptr) const;
+
+	/**
+	* Calculate the metrics, comparison and capex of a simulated scenario
+	*/
+	void completeResult(SimulationResult& result, const TaskData& taskData, const SimulationTotals& totals, PhaseTimings* timings) const;
 
 	SimulationResult makeInvalidResult(const TaskData& taskData) const;
+	// warn that a scenario is invalid, though only the first few times and then occasionally,
+	// as an optimisation can generate invalid scenarios by the thousand
+	void warnInvalidScenario(std::string_view context, const TaskData& taskData, ScenarioError errors) const;
 
-	CostVectors extractCostVectors(const ReportData& reportData, const TaskData& taskData) const;
+	// simulateScenario, where a FullReporting scenario only reports the given columns
+	SimulationResult runScenario(const TaskData& taskData, SimulationType simulationType, ReportColumnMask columns) const;
+	SimulationResult runScenario(const TaskData& taskData, SimulationType simulationType, ReportColumnMask columns,
+		const ScenarioConstraints& constraints) const;
 
-	SimulationMetrics calculateMetrics(const TaskData& taskData, const ReportData& reportData, const UsageData& usage) const;
+	/**
+	* Simulate a (valid) ResultOnly scenario, stopping as soon as it provably exceeds a shortfall limit of constraints
+	* (see SimulationResult::terminated_early). A scenario that doesn't is simulated in full, with the same result.
+	*/
+	SimulationResult runWithShortfallLimits(const TaskData& taskData, const ScenarioConstraints& constraints) const;
+
+	// the columns of the baseline's ReportData that are in columns
+	std::shared_ptr<const ReportData> baselineReportData(ReportColumnMask columns) const;
+
+	/**
+	* Check the constraints that can be evaluated without simulating the scenario
+	* returns the result to use in place of a simulation if they are violated
+	*/
+	std::optional<SimulationResult> checkConstraints(const TaskData& taskData, const ScenarioConstraints& constraints) const;
+
+	SimulationMetrics calculateMetrics(const TaskData& taskData, const SimulationTotals& totals, const UsageData& usage,
+		std::span<const ComponentView> components, PhaseTimings* timings = nullptr) const;
 
 	float getFixedAvailableImport(const TaskData& taskData) const;
 
-	const SiteData mSiteData;
+	MemoryFootprint memoryBreakdown(MemorySeen& seen) const;
+
+	// these are shared with every Simulator whose SiteData has the same columns (see DerivedCache)
+	static std::vector<std::shared_ptr<const DayTariffStats>> sharedTariffStats(const SiteData& siteData);
+	static std::shared_ptr<const TariffPricing> sharedImportTariffs(const SiteData& siteData);
+	static std::shared_ptr<const HeatPumpProfile> sharedAmbientHeatPumpProfile(const SiteData& siteData, const ASHPLookup& reference);
+
+	// mSiteData is a reference into the shared SiteData, so must be declared after the pointer that owns it
+	const std::shared_ptr<const SiteData> mSiteDataPtr;
+	const SiteData& mSiteData;
 	const TaskConfig mConfig;
-	UsageData mBaselineUsage;
-	SimulationMetrics mBaselineMetrics;
-	ReportData mBaselineReportData;
+	// the block size of the daily kernels for this site's resolution (see DayBlocks.hpp), selected once here
+	const size_t mDayBlock = dayBlockSize(mSiteData);
+	// daily statistics for each of the import tariffs (shared with the members of the ensemble and any other site with the same tariff)
+	const std::vector<std::shared_ptr<const DayTariffStats>> mTariffStats;
+	// every import tariff, ready to price a grid import against them all (shared with the members of the ensemble)
+	const std::shared_ptr<const TariffPricing> mImportTariffs;
+	// the reference (1kW) heatpump table, scaled by each scenario's heatpump
+	const ASHPLookup mHeatPumpLookup;
+	// the reference heatpump's performance at the ambient temperature of every timestep
+	// (shared with any other Simulator with the same air temperature and heatpump tables)
+	const std::shared_ptr<const HeatPumpProfile> mAmbientHeatPumpProfile;
+	// the hotroom heatpump profiles of the scenarios' data centres (this is internally synchronised)
+	const std::shared_ptr<HotRoomProfileCache> mHotRoomProfiles;
+	// the costs of each scenario, with the memoised component costs (this is internally synchronised)
+	// it refers to mSiteData, which every Simulator that shares it keeps alive
+	const std::shared_ptr<const CostEngine> mCostEngine;
+	struct LazyBaseline {
+		std::once_flag once;
+		// set once the baseline is, so that it can be checked for without simulating it
+		std::atomic<bool> ready{ false };
+		SimulatorBaseline baseline;
+		// the totals it was calculated from, unless it was provided or read from the baseline cache
+		std::optional<SimulationTotals> totals;
+	};
+	// the baseline, which is set the first time it is needed (this is internally synchronised)
+	const std::shared_ptr<LazyBaseline> mBaseline = std::make_shared<LazyBaseline>();
+	struct LazyTimestamps {
+		std::once_flag once;
+		std::shared_ptr<const TimestampIndex> index;
+	};
+	// the start of each timestep, which is made the first time it is needed (this is internally synchronised)
+	const std::shared_ptr<LazyTimestamps> mTimestamps = std::make_shared<LazyTimestamps>();
+	// optional directory in which to cache the baseline
+	std::optional<std::filesystem::path> mBaselineCacheDirectory;
+	// optional cache of scenario results (this is internally synchronised)
+	std::shared_ptr<ResultCache> mResultCache;
+	// optional cache of the state before the balancing loop (this is internally synchronised)
+	std::shared_ptr<PreBalancingCache> mPreBalancingCache;
+	// the pool to step a CONSUME ESS on, if it is to be stepped in parallel
+	ThreadPool* mParallelESSPool = nullptr;
+	// the pool to overlap the stages of a FullReporting scenario on, if it is to be
+	ThreadPool* mLowLatencyPool = nullptr;
+	// the backend to balance the lock-step scenarios of a batch with, if any
+	std::shared_ptr<BatchBackend> mBatchBackend;
+	// optional representative days, for screening scenarios
+	std::optional<RepresentativeDays> mRepresentativeDays;
+	std::vector<RepresentativeDay> mRepresentativeDaySimulators;
+
+	struct Resolutions {
+		std::mutex mutex;
+		std::map<std::chrono::seconds, std::shared_ptr<Simulator>> simulators;
+	};
+	// the Simulators of this site at other resolutions (this is internally synchronised)
+	std::shared_ptr<Resolutions> mResolutions;
+	struct Configs {
+		// the most configs to keep (the least recently used is dropped to make room for another)
+		static constexpr size_t MAX_CONFIGS = 256;
+
+		// the Simulator of config, which becomes the most recently used, or null if it isn't kept
+		// (the mutex must be held)
+		std::shared_ptr<const Simulator> find(const TaskConfig& config);
+
+		std::mutex mutex;
+		// in the order they were last used, the most recent last
+		std::vector<std::pair<TaskConfig, std::shared_ptr<const Simulator>>> simulators;
+		// the totals and timeseries of the baseline, which are the same for every config
+		std::once_flag baselineOnce;
+		SimulationTotals baselineTotals{};
+		std::shared_ptr<const ReportData> baselineReportData;
+	};
+	// the Simulators of this site with other configs (this is internally synchronised)
+	std::shared_ptr<Configs> mConfigs = std::make_shared<Configs>();
+	// a Simulator of each member of the SiteData's ensemble
+	std::vector<std::shared_ptr<const Simulator>> mEnsemble;
+	// the learned runtimes of each component mix (this is internally synchronised)
+	const std::shared_ptr<ScenarioCostModel> mCostModel = std::make_shared<ScenarioCostModel>(mSiteData.timesteps);
+	// the plan of each shape of scenario (this is internally synchronised)
+	const std::shared_ptr<ExecutionPlanCache> mExecutionPlans = std::make_shared<ExecutionPlanCache>();
 };
@@ -1,13 +1,20 @@
 #pragma once
 
 #include <chrono>
+#include <format>
 #include <optional>
+#include <stdexcept>
 #include <vector>
 
 #include <Eigen/Core>
 
 #include "../Definitions.hpp"
 #include "Fabric.hpp"
+#include "MemoryFootprint.hpp"
+#include "SiteEnsemble.hpp"
+#include "SiteSeries.hpp"
+#include "SiteSeriesMatrix.hpp"
+#include "TariffPattern.hpp"
 
 
 struct SiteData {
@@ -15,15 +22,15 @@ struct SiteData {
 		std::chrono::system_clock::time_point start_ts,
 		std::chrono::system_clock::time_point end_ts,
 		TaskData baseline,
-		year_TS building_eload,
-		year_TS building_hload,
+		SiteSeries building_eload,
+		SiteSeries building_hload,
 		float peak_hload,
-		year_TS ev_eload,
-		year_TS dhw_demand,
-		year_TS air_temperature,
-		year_TS grid_co2,
-		std::vector<year_TS> solar_yields,
-		std::vector<year_TS> import_tariffs,
+		SiteSeries ev_eload,
+		SiteSeries dhw_demand,
+		SiteSeries air_temperature,
+		SiteSeries grid_co2,
+		std::vector<SiteSeries> solar_yields,
+		std::vector<SiteSeries> import_tariffs,
 		std::vector<FabricIntervention> fabric_interventions,
 		Eigen::MatrixXf ashp_input_table,
 		Eigen::MatrixXf ashp_output_table
@@ -45,6 +52,7 @@ struct SiteData {
 		ashp_output_table(std::move(ashp_output_table))
 	{
 		derive_time_properties();
+		bind_fabric_deltas();
 		validate_site_data();
 	}
 
@@ -55,26 +63,29 @@ struct SiteData {
 	const TaskData baseline;
 
 	// The electrical demand in kWh/timestep
-	year_TS building_eload;
+	SiteSeries building_eload;
 	// The base heating demand in kWh/timestep
-	year_TS building_hload;
+	SiteSeries building_hload;
 	// The peak heating load in kW for the baseline (as calculated by an external source such as PHPP)
 	float peak_hload;
 	// The electric vehicle demand in kWh/timestep
-	year_TS ev_eload;
+	SiteSeries ev_eload;
 	// The hot water demand in kWh/timestep
-	year_TS dhw_demand;
+	SiteSeries dhw_demand;
 	// The ambient air temperature in degrees celsius
-	year_TS air_temperature;
+	SiteSeries air_temperature;
 	// The grid carbon intensity in g/kWh
 	// This must be converted to kg for most of our metrics
-	year_TS grid_co2;
+	SiteSeries grid_co2;
 
 	// The solar yields per timestep for a 1kW peak panel
-	std::vector<year_TS> solar_yields;
+	// (held as the columns of one matrix, so the generation of many arrays is a single matrix-vector product)
+	SiteSeriesMatrix solar_yields;
 	// The electrical import prices in pounds / kWh
-	std::vector<year_TS> import_tariffs;
+	// (always dense; a tariff with a daily pattern of a few bands can be written as one in a SiteData file, see importTariffPattern)
+	std::vector<SiteSeries> import_tariffs;
 	// The (exclusive) fabric intervention options for this site
+	// (each heating demand is either dense or a delta against building_hload, see compactFabricInterventions)
 	std::vector<FabricIntervention> fabric_interventions;
 
 	// The input lookup table for the heatpumps
@@ -82,6 +93,9 @@ struct SiteData {
 	// The output lookup table for the heatpumps
 	Eigen::MatrixXf ashp_output_table;
 
+	// Alternative weather and demand for the site (which is empty unless it is set after construction)
+	SiteEnsemble ensemble;
+
 	// derived properties
 	std::chrono::seconds timestep_interval_s;
 	// the length of a timestep in hours
@@ -89,6 +103,126 @@ struct SiteData {
 	float timestep_hours;
 	size_t timesteps;
 
+	/**
+	* An estimate of the heap memory in bytes held by the timeseries and lookup tables in this SiteData
+	* Timeseries that view a mapped SiteData file are not counted, as the mapping is shared between processes
+	*/
+	size_t memoryFootprint() const {
+		return memoryBreakdown().total();
+	}
+
+	/**
+	* The memoryFootprint of each timeseries and lookup table (with a part for each tariff and fabric intervention)
+	* Storage that is already in seen (such as the series an ensemble member shares with its nominal SiteData) counts as 0
+	*/
+	MemoryFootprint memoryBreakdown(MemorySeen* seen = nullptr) const {
+		auto counted = [seen](const void* storage) {
+			return seen == nullptr || seen->first(storage);
+		};
+		auto owned = [&counted](const SiteSeries& series) {
+			return series.isView() || !counted(series.data()) ? size_t{ 0 } : sizeof(float) * static_cast<size_t>(series.size());
+		};
+
+		MemoryFootprint footprint;
+		footprint.add("building_eload", owned(building_eload));
+		footprint.add("building_hload", owned(building_hload));
+		footprint.add("ev_eload", owned(ev_eload));
+		footprint.add("dhw_demand", owned(dhw_demand));
+		footprint.add("air_temperature", owned(air_temperature));
+		footprint.add("grid_co2", owned(grid_co2));
+		footprint.add("solar_yields", counted(solar_yields.matrix().data()) ? solar_yields.ownedBytes() : 0);
+		for (size_t i = 0; i < import_tariffs.size(); i++) {
+			footprint.add(std::format("import_tariffs[{}]", i), owned(import_tariffs[i]));
+		}
+		for (size_t i = 0; i < fabric_interventions.size(); i++) {
+			const FabricIntervention& fi = fabric_interventions[i];
+			footprint.add(std::format("fabric_interventions[{}]", i),
+				owned(fi.reduced_hload) + (fi.hload_delta ? fi.hload_delta->ownedBytes() : 0));
+		}
+		footprint.add("ashp_input_table", sizeof(float) * static_cast<size_t>(ashp_input_table.size()));
+		footprint.add("ashp_output_table", sizeof(float) * static_cast<size_t>(ashp_output_table.size()));
+		footprint.add("ensemble", ensemble.ownedBytes());
+		return footprint;
+	}
+
+	/**
+	* The number of timesteps in a day, if a day is a whole number of timesteps
+	*/
+	std::optional<Eigen::Index> timestepsPerDay() const {
+		constexpr std::chrono::seconds DAY{ 24 * 60 * 60 };
+		if (timestep_interval_s.count() <= 0 || DAY % timestep_interval_s != std::chrono::seconds{ 0 }) {
+			return std::nullopt;
+		}
+		return static_cast<Eigen::Index>(DAY / timestep_interval_s);
+	}
+
+	/**
+	* The daily pattern of an import tariff, if it repeats the same few bands every day (see TariffPattern)
+	* This is found from the dense tariff each time, so it can never disagree with it.
+	*/
+	std::optional<TariffPattern> importTariffPattern(size_t i) const {
+		const auto period = timestepsPerDay();
+		return period ? TariffPattern::detect(import_tariffs.at(i), *period) : std::nullopt;
+	}
+
+	/**
+	* Hold the heating demand of each fabric intervention that is a scaled building_hload (but for a few timesteps) as a delta
+	* An intervention is compacted if no more than maxOverrideFraction of its timesteps differ from the scaled building_hload.
+	* The demands are unchanged (though their totals are summed in a different order). Returns the number of interventions compacted.
+	*/
+	size_t compactFabricInterventions(double maxOverrideFraction = 0.05) {
+		const auto maxOverrides = static_cast<size_t>(maxOverrideFraction * static_cast<double>(timesteps));
+		size_t compacted = 0;
+		for (FabricIntervention& fi : fabric_interventions) {
+			if (fi.hload_delta) {
+				continue;
+			}
+			if (auto delta = FabricHeatDelta::fit(building_hload, fi.reduced_hload, maxOverrides)) {
+				fi.hload_delta = std::move(delta);
+				fi.reduced_hload = SiteSeries();
+				compacted++;
+			}
+		}
+		return compacted;
+	}
+
+	// the length of each timestep when timesteps span start_ts to end_ts
+	static std::chrono::seconds timestepInterval(
+		std::chrono::system_clock::time_point start_ts, std::chrono::system_clock::time_point end_ts, size_t timesteps) {
+		// deliberately timesteps and not timesteps - 1
+		// start_ts is the lower bound of the first timestep
+		// end_ts is the upper bound of the final timestep
+		return std::chrono::duration_cast<std::chrono::seconds>((end_ts - start_ts) / timesteps);
+	}
+
+	/**
+	* A SiteData with the series of one member of the ensemble in place of this SiteData's own
+	* Every other series is shared rather than copied, and the member has no ensemble of its own
+	*/
+	SiteData ensembleMember(size_t member) const {
+		if (member >= ensemble.members()) {
+			throw std::out_of_range(std::format("Ensemble member {} is out of range for an ensemble of {}", member, ensemble.members()));
+		}
+		auto pick = [member](const SiteSeriesMatrix& alternatives, const SiteSeries& own) -> const SiteSeries& {
+			return alternatives.empty() ? own : alternatives[member];
+		};
+		return SiteData(
+			start_ts, end_ts, baseline,
+			pick(ensemble.building_eload, building_eload),
+			pick(ensemble.building_hload, building_hload),
+			peak_hload,
+			ev_eload,
+			dhw_demand,
+			pick(ensemble.air_temperature, air_temperature),
+			grid_co2,
+			ensemble.solar_yields.empty() ? solar_yields.columns() : ensemble.solar_yields[member].columns(),
+			import_tariffs,
+			fabric_interventions,
+			ashp_input_table,
+			ashp_output_table
+		);
+	}
+
 	void derive_time_properties() {
 		// use building_eload for the length of all vectors
 		timesteps = this->building_eload.size();
@@ -102,17 +236,21 @@ struct SiteData {
 			throw std::runtime_error("start_ts must be less than end_ts");
 		}
 
-		auto total_span = this->end_ts - this->start_ts;
-		timestep_interval_s = std::chrono::duration_cast<std::chrono::seconds>(
-			// deliberately timesteps and not timesteps - 1
-			// start_ts is the lower bound of the first timestep
-			// end_ts is the upper bound of the final timestep
-			total_span / timesteps
-		);
+		timestep_interval_s = timestepInterval(this->start_ts, this->end_ts, timesteps);
 
 		timestep_hours = std::chrono::duration<float>(timestep_interval_s).count() / (60 * 60);
 	}
 
+	// a delta read from a SiteData file is relative to this SiteData's building_hload
+	// (one that is already bound, such as those an ensemble member shares, keeps its base)
+	void bind_fabric_deltas() {
+		for (FabricIntervention& fi : fabric_interventions) {
+			if (fi.hload_delta && fi.hload_delta->base.size() == 0) {
+				fi.hload_delta->base = building_hload;
+			}
+		}
+	}
+
 	void validate_site_data() {
 
 		// we're not using the existing timesteps 
@@ -148,7 +286,21 @@ struct SiteData {
 
 		// check fabric_interventions
 		for (const auto& fi : this->fabric_interventions) {
-			if (fi.reduced_hload.size() != timestep_size) {
+			if (fi.hload_delta) {
+				const FabricHeatDelta& delta = *fi.hload_delta;
+				if (fi.reduced_hload.size() != 0 || delta.base.size() != timestep_size) {
+					throw std::runtime_error("fabric interventions do not have the correct number of timesteps");
+				}
+				if (delta.index.size() != delta.value.size()) {
+					throw std::runtime_error("a fabric intervention's delta must have a value for each index");
+				}
+				for (size_t i = 0; i < delta.index.size(); i++) {
+					if (delta.index[i] >= timesteps || (i > 0 && delta.index[i] <= delta.index[i - 1])) {
+						throw std::runtime_error("a fabric intervention's delta indices must be ascending timesteps");
+					}
+				}
+			}
+			else if (fi.reduced_hload.size() != timestep_size) {
 				throw std::runtime_error("fabric interventions do not have the correct number of timesteps");
 			}
 		}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <format>
+#include <stdexcept>
+#include <vector>
+
+#include <Eigen/Core>
+
+#include "SiteSeriesMatrix.hpp"
+
+/**
+* Alternative weather and demand for a site, such as other weather years or perturbed demands
+*
+* Member m of the ensemble replaces the SiteData's series with column m of each matrix that is non-empty,
+* so a series that is the same for every member need not be repeated.
+* Each member's solar yields are the columns of their own matrix, in the same order as the SiteData's solar_yields.
+*/
+struct SiteEnsemble {
+	SiteSeriesMatrix air_temperature;
+	SiteSeriesMatrix building_eload;
+	SiteSeriesMatrix building_hload;
+	// one matrix per member (or none)
+	std::vector<SiteSeriesMatrix> solar_yields;
+
+	/**
+	* The number of members, which is zero if there is no ensemble
+	*/
+	size_t members() const {
+		return std::max({ air_temperature.size(), building_eload.size(), building_hload.size(), solar_yields.size() });
+	}
+
+	bool empty() const { return members() == 0; }
+
+	/**
+	* Check that every member has the same number of timesteps and solar yields as the SiteData
+	*/
+	void validate(Eigen::Index timesteps, size_t numSolarYields) const {
+		const size_t n = members();
+		auto checkLengths = [&](const SiteSeriesMatrix& series, const char* name) {
+			for (const auto& column : series) {
+				if (column.size() != timesteps) {
+					throw std::runtime_error(std::format("The ensemble {} do not have the correct number of timesteps", name));
+				}
+			}
+		};
+		auto check = [&](const SiteSeriesMatrix& series, const char* name) {
+			if (!series.empty() && series.size() != n) {
+				throw std::runtime_error(std::format("The ensemble has {} members but {} {} members", n, series.size(), name));
+			}
+			checkLengths(series, name);
+		};
+		check(air_temperature, "air_temperature");
+		check(building_eload, "building_eload");
+		check(building_hload, "building_hload");
+
+		if (!solar_yields.empty()) {
+			if (solar_yields.size() != n) {
+				throw std::runtime_error(std::format("The ensemble has {} members but {} solar_yields members", n, solar_yields.size()));
+			}
+			for (const auto& member : solar_yields) {
+				if (member.size() != numSolarYields) {
+					throw std::runtime_error(std::format(
+						"Each ensemble member must have {} solar yields, not {}", numSolarYields, member.size()));
+				}
+				checkLengths(member, "solar_yields");
+			}
+		}
+	}
+
+	// the heap memory in bytes held by the ensemble
+	size_t ownedBytes() const {
+		size_t bytes = air_temperature.ownedBytes() + building_eload.ownedBytes() + building_hload.ownedBytes();
+		for (const auto& member : solar_yields) {
+			bytes += member.ownedBytes();
+		}
+		return bytes;
+	}
+};
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <memory>
+#include <new>
+#include <utility>
+
+#include <Eigen/Core>
+
+/**
+* A read-only timeseries of a SiteData
+*
+* A SiteSeries either owns its values or views storage held by an owner, such as a mapped binary SiteData file.
+* Copies share the values rather than duplicating them.
+* This is an Eigen::Map, so it can be used anywhere an Eigen vector or a year_TS_view is expected.
+*/
+class SiteSeries : public Eigen::Map<const Eigen::VectorXf, Eigen::AlignedMax> {
+public:
+	using Base = Eigen::Map<const Eigen::VectorXf, Eigen::AlignedMax>;
+
+	SiteSeries() : Base(nullptr, 0) {}
+
+	// take ownership of the values
+	SiteSeries(Eigen::VectorXf values) : SiteSeries(std::make_shared<const Eigen::VectorXf>(std::move(values))) {}
+
+	// copy the values of an Eigen expression
+	template <typename Derived>
+	SiteSeries(const Eigen::MatrixBase<Derived>& values) : SiteSeries(Eigen::VectorXf(values)) {}
+
+	/**
+	* View size floats at data, which must be aligned to EIGEN_MAX_ALIGN_BYTES
+	* The values must stay valid and unmodified for as long as the owner is held
+	*/
+	SiteSeries(const float* data, Eigen::Index size, std::shared_ptr<const void> owner)
+		: Base(data, size), mOwner(std::move(owner)), mView(true) {}
+
+	SiteSeries(const SiteSeries& other) = default;
+
+	SiteSeries& operator=(const SiteSeries& other) {
+		// assigning to an Eigen::Map writes through it, so re-seat the map instead
+		new (static_cast<Base*>(this)) Base(other.data(), other.size());
+		mOwner = other.mOwner;
+		mView = other.mView;
+		return *this;
+	}
+
+	// whether the values are held by an external owner rather than by this series
+	bool isView() const { return mView; }
+
+	// the holder of the values (shared by every series viewing the same storage)
+	const std::shared_ptr<const void>& owner() const { return mOwner; }
+
+private:
+	explicit SiteSeries(std::shared_ptr<const Eigen::VectorXf> values)
+		: Base(values->data(), values->size()), mOwner(std::move(values)), mView(false) {}
+
+	std::shared_ptr<const void> mOwner;
+	bool mView = false;
+};
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstddef>
+#include <initializer_list>
+#include <memory>
+#include <vector>
+
+#include <Eigen/Core>
+
+#include "SiteSeries.hpp"
+
+/**
+* A set of SiteSeries held as the columns of one column-major matrix
+*
+* Each column is padded up to a multiple of 16 floats, so every column is as aligned as the matrix itself
+* and can still be used as a SiteSeries.
+* Columns that already view evenly spaced columns of one owner (as in a mapped binary SiteData file) are used in place.
+*/
+class SiteSeriesMatrix {
+public:
+	using MatrixView = Eigen::Map<const Eigen::MatrixXf, Eigen::AlignedMax, Eigen::OuterStride<>>;
+
+	SiteSeriesMatrix() = default;
+
+	SiteSeriesMatrix(std::vector<SiteSeries> columns) : mColumns(std::move(columns)) {
+		pack();
+	}
+
+	SiteSeriesMatrix(std::initializer_list<SiteSeries> columns) : SiteSeriesMatrix(std::vector<SiteSeries>(columns)) {}
+
+	size_t size() const { return mColumns.size(); }
+	bool empty() const { return mColumns.empty(); }
+	const SiteSeries& operator[](size_t i) const { return mColumns[i]; }
+	const SiteSeries& front() const { return mColumns.front(); }
+	const SiteSeries& back() const { return mColumns.back(); }
+	auto begin() const { return mColumns.begin(); }
+	auto end() const { return mColumns.end(); }
+
+	// the columns as individual series
+	const std::vector<SiteSeries>& columns() const { return mColumns; }
+	operator const std::vector<SiteSeries>&() const { return mColumns; }
+
+	/**
+	* The columns as a (timesteps x size()) matrix
+	* This is empty if there are no columns or they are not all the same length
+	*/
+	MatrixView matrix() const {
+		return MatrixView(mData, mRows, mData ? static_cast<Eigen::Index>(mColumns.size()) : 0, Eigen::OuterStride<>(mStride));
+	}
+
+	// the heap memory in bytes held by this matrix (storage viewed from an external owner is not counted)
+	size_t ownedBytes() const {
+		return mOwned ? sizeof(float) * static_cast<size_t>(mStride) * mColumns.size() : 0;
+	}
+
+private:
+	static constexpr Eigen::Index COLUMN_ALIGNMENT = 16;
+
+	void pack() {
+		if (mColumns.empty()) {
+			return;
+		}
+		const Eigen::Index rows = mColumns.front().size();
+		for (const auto& column : mColumns) {
+			if (column.size() != rows) {
+				// leave the columns as they are for SiteData validation to reject
+				return;
+			}
+		}
+		mRows = rows;
+
+		if (viewsEvenlySpacedColumns()) {
+			mData = mColumns.front().data();
+			return;
+		}
+
+		mStride = (rows + COLUMN_ALIGNMENT - 1) / COLUMN_ALIGNMENT * COLUMN_ALIGNMENT;
+		auto storage = std::make_shared<Eigen::VectorXf>(Eigen::VectorXf::Zero(mStride * static_cast<Eigen::Index>(mColumns.size())));
+		for (size_t i = 0; i < mColumns.size(); i++) {
+			storage->segment(static_cast<Eigen::Index>(i) * mStride, rows) = mColumns[i];
+		}
+		for (size_t i = 0; i < mColumns.size(); i++) {
+			mColumns[i] = SiteSeries(storage->data() + static_cast<Eigen::Index>(i) * mStride, rows, storage);
+		}
+		mData = storage->data();
+		mOwned = true;
+	}
+
+	// whether the columns are views of one owner, with the same distance between each column
+	bool viewsEvenlySpacedColumns() {
+		const SiteSeries& first = mColumns.front();
+		if (!first.isView()) {
+			return false;
+		}
+		mStride = mColumns.size() > 1 ? mColumns[1].data() - first.data() : mRows;
+		if (mStride < mRows) {
+			return false;
+		}
+		for (size_t i = 0; i < mColumns.size(); i++) {
+			if (!mColumns[i].isView() || mColumns[i].owner() != first.owner()
+				|| mColumns[i].data() != first.data() + static_cast<Eigen::Index>(i) * mStride) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	std::vector<SiteSeries> mColumns;
+	const float* mData = nullptr;
+	Eigen::Index mRows = 0;
+	Eigen::Index mStride = 0;
+	bool mOwned = false;
+};
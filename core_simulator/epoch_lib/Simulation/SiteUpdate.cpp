@@ -0,0 +1,187 @@
+#include "SiteUpdate.hpp"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <format>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+	struct NamedColumn {
+		std::string_view name;
+		SiteColumn column;
+	};
+
+	constexpr std::array<NamedColumn, 8> SITE_COLUMN_NAMES = { {
+		{ "building_eload", SiteColumn::BuildingEload },
+		{ "building_hload", SiteColumn::BuildingHload },
+		{ "ev_eload", SiteColumn::EvEload },
+		{ "dhw_demand", SiteColumn::DhwDemand },
+		{ "air_temperature", SiteColumn::AirTemperature },
+		{ "grid_co2", SiteColumn::GridCo2 },
+		{ "solar_yields", SiteColumn::SolarYield },
+		{ "import_tariffs", SiteColumn::ImportTariff },
+	} };
+
+	bool isIndexed(SiteColumn column) {
+		return column == SiteColumn::SolarYield || column == SiteColumn::ImportTariff;
+	}
+
+	// the column with this name, and its index ("import_tariffs[2]" is ImportTariff 2)
+	std::pair<SiteColumn, size_t> parseColumnName(std::string_view name) {
+		std::string_view base = name;
+		size_t index = 0;
+		bool hasIndex = false;
+		if (const auto open = name.find('['); open != std::string_view::npos && name.ends_with(']')) {
+			base = name.substr(0, open);
+			const std::string_view digits = name.substr(open + 1, name.size() - open - 2);
+			const auto [end, ec] = std::from_chars(digits.data(), digits.data() + digits.size(), index);
+			hasIndex = ec == std::errc{} && end == digits.data() + digits.size() && !digits.empty();
+			if (!hasIndex) {
+				throw std::invalid_argument(std::format("{} is not a SiteData column", name));
+			}
+		}
+
+		for (const auto& named : SITE_COLUMN_NAMES) {
+			if (named.name == base && hasIndex == isIndexed(named.column)) {
+				return { named.column, index };
+			}
+		}
+		throw std::invalid_argument(std::format("{} is not a SiteData column", name));
+	}
+
+	const SiteSeries*& at(std::vector<const SiteSeries*>& columns, const SiteUpdate::Replacement& replacement) {
+		if (replacement.index >= columns.size()) {
+			throw std::invalid_argument(std::format("Cannot replace {} of a SiteData with {} of them",
+				siteColumnName(replacement.column, replacement.index), columns.size()));
+		}
+		return columns[replacement.index];
+	}
+}
+
+std::string siteColumnName(SiteColumn column, size_t index) {
+	for (const auto& named : SITE_COLUMN_NAMES) {
+		if (named.column == column) {
+			return isIndexed(column) ? std::format("{}[{}]", named.name, index) : std::string(named.name);
+		}
+	}
+	throw std::logic_error("Unknown SiteColumn");
+}
+
+SiteUpdate& SiteUpdate::replace(SiteColumn column, SiteSeries values, size_t index) {
+	replacements.push_back({ column, isIndexed(column) ? index : 0, std::move(values) });
+	return *this;
+}
+
+SiteUpdate& SiteUpdate::replace(std::string_view name, SiteSeries values) {
+	const auto [column, index] = parseColumnName(name);
+	return replace(column, std::move(values), index);
+}
+
+SiteUpdate& SiteUpdate::addImportTariff(SiteSeries tariff) {
+	import_tariffs.push_back(std::move(tariff));
+	return *this;
+}
+
+SiteUpdate& SiteUpdate::addSolarYield(SiteSeries yield) {
+	solar_yields.push_back(std::move(yield));
+	return *this;
+}
+
+bool SiteUpdate::replaces(SiteColumn column) const {
+	return std::ranges::any_of(replacements, [column](const Replacement& r) { return r.column == column; });
+}
+
+bool SiteUpdate::affects(const TaskData& taskData) const {
+	const size_t tariffIndex = taskData.grid ? taskData.grid->tariff_index : 0;
+
+	for (const Replacement& r : replacements) {
+		switch (r.column) {
+		case SiteColumn::EvEload:
+			if (taskData.electric_vehicles) {
+				return true;
+			}
+			break;
+		case SiteColumn::AirTemperature:
+			// only through the ambient and hotroom heatpump profiles
+			if (taskData.heat_pump || taskData.data_centre) {
+				return true;
+			}
+			break;
+		case SiteColumn::SolarYield:
+			for (const SolarData& panel : taskData.solar_panels) {
+				if (panel.yield_index >= 0 && static_cast<size_t>(panel.yield_index) == r.index) {
+					return true;
+				}
+			}
+			break;
+		case SiteColumn::ImportTariff:
+			if (r.index == tariffIndex) {
+				return true;
+			}
+			break;
+		default:
+			// the demands and carbon intensity are read by every scenario
+			return true;
+		}
+	}
+	return false;
+}
+
+SiteData applySiteUpdate(const SiteData& siteData, const SiteUpdate& update) {
+	// in the order of SiteColumn
+	std::array<const SiteSeries*, 6> series = {
+		&siteData.building_eload, &siteData.building_hload, &siteData.ev_eload,
+		&siteData.dhw_demand, &siteData.air_temperature, &siteData.grid_co2
+	};
+	std::vector<const SiteSeries*> solarYields;
+	for (const SiteSeries& yield : siteData.solar_yields) {
+		solarYields.push_back(&yield);
+	}
+	std::vector<const SiteSeries*> importTariffs;
+	for (const SiteSeries& tariff : siteData.import_tariffs) {
+		importTariffs.push_back(&tariff);
+	}
+
+	for (const SiteUpdate::Replacement& r : update.replacements) {
+		switch (r.column) {
+		case SiteColumn::SolarYield:
+			at(solarYields, r) = &r.values;
+			break;
+		case SiteColumn::ImportTariff:
+			at(importTariffs, r) = &r.values;
+			break;
+		default:
+			series[static_cast<size_t>(r.column)] = &r.values;
+		}
+	}
+	for (const SiteSeries& yield : update.solar_yields) {
+		solarYields.push_back(&yield);
+	}
+	for (const SiteSeries& tariff : update.import_tariffs) {
+		importTariffs.push_back(&tariff);
+	}
+
+	auto copies = [](const std::vector<const SiteSeries*>& columns) {
+		std::vector<SiteSeries> copied;
+		copied.reserve(columns.size());
+		for (const SiteSeries* column : columns) {
+			copied.push_back(*column);
+		}
+		return copied;
+	};
+
+	// (the fabric interventions held as deltas stay relative to the building_hload they were bound to)
+	SiteData updated(
+		siteData.start_ts, siteData.end_ts, siteData.baseline,
+		*series[0], *series[1], siteData.peak_hload, *series[2], *series[3], *series[4], *series[5],
+		copies(solarYields),
+		copies(importTariffs),
+		siteData.fabric_interventions,
+		siteData.ashp_input_table,
+		siteData.ashp_output_table
+	);
+	updated.ensemble = siteData.ensemble;
+	return updated;
+}
@@ -0,0 +1,81 @@
+/*
+logic for replacing and adding the columns of a SiteData, so that a live Simulator can be updated (see Simulator::withSiteUpdate)
+*/
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "SiteData.hpp"
+#include "SiteSeries.hpp"
+#include "TaskData.hpp"
+
+/**
+* The timeseries of a SiteData that can be replaced
+* SolarYield and ImportTariff are one of several columns, so are replaced by index
+*/
+enum class SiteColumn {
+	BuildingEload,
+	BuildingHload,
+	EvEload,
+	DhwDemand,
+	AirTemperature,
+	GridCo2,
+	SolarYield,
+	ImportTariff
+};
+
+/**
+* The name of a column, as in a SiteData file and the parts of SiteData::memoryBreakdown
+* (such as "grid_co2" or "import_tariffs[2]")
+*/
+std::string siteColumnName(SiteColumn column, size_t index = 0);
+
+/**
+* A set of changes to the columns of a SiteData: columns to replace and tariffs and solar yields to add
+* The replacements are applied first, so each replaces a column that the SiteData already has,
+* and the added columns take the indices after the SiteData's own.
+*/
+struct SiteUpdate {
+	struct Replacement {
+		SiteColumn column;
+		// the index of the solar yield or import tariff (and 0 for any other column)
+		size_t index;
+		SiteSeries values;
+	};
+
+	std::vector<Replacement> replacements;
+	std::vector<SiteSeries> import_tariffs;
+	std::vector<SiteSeries> solar_yields;
+
+	SiteUpdate& replace(SiteColumn column, SiteSeries values, size_t index = 0);
+
+	/**
+	* Replace the column with this name (see siteColumnName)
+	* Raise an invalid_argument if there is no such column
+	*/
+	SiteUpdate& replace(std::string_view name, SiteSeries values);
+
+	SiteUpdate& addImportTariff(SiteSeries tariff);
+	SiteUpdate& addSolarYield(SiteSeries yield);
+
+	bool empty() const { return replacements.empty() && import_tariffs.empty() && solar_yields.empty(); }
+
+	// whether the update replaces the column (at any index)
+	bool replaces(SiteColumn column) const;
+
+	/**
+	* Whether simulating the scenario reads a column that this update replaces
+	* Added columns are never read by a scenario that was valid before them.
+	*/
+	bool affects(const TaskData& taskData) const;
+};
+
+/**
+* The SiteData with the columns of update replaced and added
+* Every other column is shared rather than copied (as is the ensemble), and the result is validated as any other SiteData.
+* Raise an invalid_argument if a replacement's index is out of range
+*/
+SiteData applySiteUpdate(const SiteData& siteData, const SiteUpdate& update);
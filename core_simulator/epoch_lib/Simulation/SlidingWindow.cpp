@@ -0,0 +1,40 @@
+#include "SlidingWindow.hpp"
+
+#include <deque>
+#include <stdexcept>
+
+namespace {
+	// before(a, b) is true if a should replace b as the front of the window
+	template <typename Before>
+	Eigen::VectorXf slidingWindow(year_TS_view values, size_t window, Before before) {
+		if (window == 0) {
+			throw std::runtime_error("A sliding window must have at least one timestep");
+		}
+		const auto n = values.size();
+		const auto width = static_cast<Eigen::Index>(window);
+		Eigen::VectorXf result(n);
+
+		// the indices that may yet be the extreme of a window, whose values are ordered from the front
+		std::deque<Eigen::Index> candidates;
+		// walk backwards, so the window at t is [t, t + window)
+		for (Eigen::Index t = n - 1; t >= 0; t--) {
+			while (!candidates.empty() && !before(values[candidates.back()], values[t])) {
+				candidates.pop_back();
+			}
+			candidates.push_back(t);
+			if (candidates.front() >= t + width) {
+				candidates.pop_front();
+			}
+			result[t] = values[candidates.front()];
+		}
+		return result;
+	}
+}
+
+Eigen::VectorXf slidingWindowMin(year_TS_view values, size_t window) {
+	return slidingWindow(values, window, [](float a, float b) { return a < b; });
+}
+
+Eigen::VectorXf slidingWindowMax(year_TS_view values, size_t window) {
+	return slidingWindow(values, window, [](float a, float b) { return a > b; });
+}
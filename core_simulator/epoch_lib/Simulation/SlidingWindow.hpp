@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstddef>
+
+#include <Eigen/Core>
+
+#include "../Definitions.hpp"
+
+/**
+* The minimum (or maximum) of values[t, t + window) for every timestep t
+* The window is cut short by the end of the series, so the last value is its own minimum
+*
+* Each is a single pass with a monotonic deque, so is O(n) whatever the window
+*/
+Eigen::VectorXf slidingWindowMin(year_TS_view values, size_t window);
+Eigen::VectorXf slidingWindowMax(year_TS_view values, size_t window);
@@ -0,0 +1,109 @@
+#include "TariffPattern.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <format>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+TariffPattern::TariffPattern(std::vector<TariffBand> bands) :
+	mBands(std::move(bands))
+{
+	if (mBands.empty()) {
+		throw std::invalid_argument("A tariff pattern must have at least one band");
+	}
+	for (const TariffBand& band : mBands) {
+		if (band.length <= 0) {
+			throw std::invalid_argument(std::format("A tariff band must be at least one timestep long, not {}", band.length));
+		}
+		mPeriod += band.length;
+	}
+}
+
+std::optional<TariffPattern> TariffPattern::detect(year_TS_view tariff, Eigen::Index period, size_t maxBands) {
+	if (period <= 0 || tariff.size() < period) {
+		return std::nullopt;
+	}
+
+	std::vector<TariffBand> bands;
+	for (Eigen::Index t = 0; t < period; t++) {
+		if (bands.empty() || tariff[t] != bands.back().price) {
+			if (bands.size() == maxBands) {
+				return std::nullopt;
+			}
+			bands.push_back({ 0, tariff[t] });
+		}
+		bands.back().length++;
+	}
+
+	// every later period (and the part period at the end) must repeat the first
+	for (Eigen::Index start = period; start < tariff.size(); start += period) {
+		const Eigen::Index n = std::min(period, tariff.size() - start);
+		if (tariff.segment(start, n) != tariff.head(n)) {
+			return std::nullopt;
+		}
+	}
+	return TariffPattern(std::move(bands));
+}
+
+Eigen::VectorXf TariffPattern::expand(Eigen::Index timesteps) const {
+	Eigen::VectorXf period(mPeriod);
+	Eigen::Index offset = 0;
+	for (const TariffBand& band : mBands) {
+		period.segment(offset, band.length).setConstant(band.price);
+		offset += band.length;
+	}
+
+	Eigen::VectorXf tariff(timesteps);
+	for (Eigen::Index start = 0; start < timesteps; start += mPeriod) {
+		const Eigen::Index n = std::min(mPeriod, timesteps - start);
+		tariff.segment(start, n) = period.head(n);
+	}
+	return tariff;
+}
+
+double TariffPattern::price(const Eigen::VectorXd& phaseImport) const {
+	if (phaseImport.size() != mPeriod) {
+		throw std::invalid_argument(std::format("Cannot price {} timesteps against a period of {}", phaseImport.size(), mPeriod));
+	}
+	double cost = 0.0;
+	Eigen::Index offset = 0;
+	for (const TariffBand& band : mBands) {
+		cost += static_cast<double>(band.price) * phaseImport.segment(offset, band.length).sum();
+		offset += band.length;
+	}
+	return cost;
+}
+
+TariffPattern TariffPatternHours::atInterval(std::chrono::seconds interval) const {
+	const double intervalHours = std::chrono::duration<double, std::ratio<3600>>(interval).count();
+	if (intervalHours <= 0.0) {
+		throw std::runtime_error("A tariff pattern needs a positive timestep interval");
+	}
+	auto toTimesteps = [intervalHours, interval](double hours, std::string_view what) {
+		const double timesteps = hours / intervalHours;
+		const double whole = std::round(timesteps);
+		if (whole < 1.0 || std::abs(timesteps - whole) > 1e-6 * std::max(1.0, whole)) {
+			throw std::runtime_error(std::format("The {} of {} hours is not a whole number of {}s timesteps",
+				what, hours, interval.count()));
+		}
+		return static_cast<Eigen::Index>(whole);
+	};
+
+	std::vector<TariffBand> timestepBands;
+	timestepBands.reserve(bands.size());
+	for (const TariffBandHours& band : bands) {
+		timestepBands.push_back({ toTimesteps(band.hours, "tariff band"), band.price });
+	}
+	if (timestepBands.empty()) {
+		throw std::runtime_error("A tariff pattern must have at least one band");
+	}
+
+	TariffPattern pattern(std::move(timestepBands));
+	if (pattern.period() != toTimesteps(period_hours, "tariff period")) {
+		throw std::runtime_error(std::format("The tariff bands span {} timesteps, not the period of {} hours",
+			pattern.period(), period_hours));
+	}
+	return pattern;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <optional>
+#include <vector>
+
+#include <Eigen/Core>
+
+#include "../Definitions.hpp"
+
+// the most bands a period may have for a tariff to be held as a pattern rather than only as a dense timeseries
+constexpr size_t MAX_TARIFF_BANDS = 12;
+
+// a price that holds for length consecutive timesteps
+struct TariffBand {
+	Eigen::Index length;
+	float price;
+};
+
+/**
+* An import tariff that repeats the same bands of constant price every period
+*
+* A flat tariff is a single band and a day/night tariff two or three bands a day.
+* The first band starts at the first timestep of the SiteData (so a daily pattern starts at start_ts, as the days of DayTariffStats do).
+*/
+class TariffPattern {
+public:
+	// throws std::invalid_argument unless there is at least one band and every band has a positive length
+	explicit TariffPattern(std::vector<TariffBand> bands);
+
+	/**
+	* The pattern of a tariff that repeats every period timesteps with no more than maxBands bands in each period
+	* Returns nullopt if it doesn't, or if the tariff is shorter than the period.
+	*/
+	static std::optional<TariffPattern> detect(year_TS_view tariff, Eigen::Index period, size_t maxBands = MAX_TARIFF_BANDS);
+
+	Eigen::Index period() const { return mPeriod; }
+	const std::vector<TariffBand>& bands() const { return mBands; }
+	bool isFlat() const { return mBands.size() == 1; }
+
+	// the tariff as a dense timeseries of the given length
+	Eigen::VectorXf expand(Eigen::Index timesteps) const;
+
+	/**
+	* The cost of a grid import, from the import summed at each timestep of the period
+	* Each band is priced on the sum of its timesteps, so this is one multiply per band.
+	*/
+	double price(const Eigen::VectorXd& phaseImport) const;
+
+private:
+	std::vector<TariffBand> mBands;
+	Eigen::Index mPeriod = 0;
+};
+
+// a band of a TariffPatternHours
+struct TariffBandHours {
+	double hours = 0.0;
+	float price = 0.0f;
+};
+
+/**
+* A tariff pattern as it is written in a SiteData file, with its bands in hours rather than timesteps
+*/
+struct TariffPatternHours {
+	double period_hours = 24.0;
+	std::vector<TariffBandHours> bands;
+
+	/**
+	* The pattern at timesteps of the given interval
+	* Throws a std::runtime_error if any band isn't a whole number of timesteps or the bands don't span the period.
+	*/
+	TariffPattern atInterval(std::chrono::seconds interval) const;
+};
@@ -0,0 +1,45 @@
+#include "TariffPricing.hpp"
+
+TariffPricing::TariffPricing(const SiteData& siteData) :
+	mTariffs(siteData.import_tariffs.size())
+{
+	for (size_t i = 0; i < mTariffs; i++) {
+		if (auto pattern = siteData.importTariffPattern(i)) {
+			if (!pattern->isFlat()) {
+				mPeriod = pattern->period();
+			}
+			mPatterns.push_back(std::move(*pattern));
+			mPatternIndex.push_back(i);
+		}
+		else {
+			mDenseIndex.push_back(i);
+		}
+	}
+
+	mDense.resize(static_cast<Eigen::Index>(siteData.timesteps), static_cast<Eigen::Index>(mDenseIndex.size()));
+	for (size_t c = 0; c < mDenseIndex.size(); c++) {
+		mDense.col(static_cast<Eigen::Index>(c)) = siteData.import_tariffs[mDenseIndex[c]];
+	}
+}
+
+void TariffPricing::costs(const Sums& sums, Eigen::VectorXf& costs) const {
+	costs.resize(static_cast<Eigen::Index>(mTariffs));
+	for (size_t c = 0; c < mDenseIndex.size(); c++) {
+		costs[static_cast<Eigen::Index>(mDenseIndex[c])] = sums.dense[static_cast<Eigen::Index>(c)];
+	}
+	for (size_t p = 0; p < mPatterns.size(); p++) {
+		const TariffPattern& pattern = mPatterns[p];
+		const double cost = pattern.isFlat() ? static_cast<double>(pattern.bands().front().price) * sums.total : pattern.price(sums.phase);
+		costs[static_cast<Eigen::Index>(mPatternIndex[p])] = static_cast<float>(cost);
+	}
+}
+
+size_t TariffPricing::ownedBytes() const {
+	size_t bytes = sizeof(float) * static_cast<size_t>(mDense.size())
+		+ sizeof(size_t) * (mDenseIndex.capacity() + mPatternIndex.capacity())
+		+ sizeof(TariffPattern) * mPatterns.capacity();
+	for (const TariffPattern& pattern : mPatterns) {
+		bytes += sizeof(TariffBand) * pattern.bands().capacity();
+	}
+	return bytes;
+}
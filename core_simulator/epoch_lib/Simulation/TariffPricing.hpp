@@ -0,0 +1,76 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include <Eigen/Core>
+
+#include "SiteData.hpp"
+#include "TariffPattern.hpp"
+
+/**
+* Every import tariff of a site, arranged to price one grid import against all of them at once
+*
+* A tariff with a daily pattern (see SiteData::importTariffPattern) is priced on the import summed at each timestep of the day,
+* so the work per timestep is a single add however many of them there are, and a flat tariff only needs the total import.
+* Every other tariff is a column of a dense (timesteps x tariffs) matrix that the import is multiplied by.
+*/
+class TariffPricing {
+public:
+	TariffPricing() = default;
+	explicit TariffPricing(const SiteData& siteData);
+
+	// the running sums of one grid import
+	struct Sums {
+		// the cost under each dense tariff
+		Eigen::VectorXf dense;
+		// the import at each timestep of the day (for the patterns that aren't flat)
+		Eigen::VectorXd phase;
+		double total = 0.0;
+	};
+
+	size_t size() const { return mTariffs; }
+
+	Sums start() const {
+		return Sums{ Eigen::VectorXf::Zero(mDense.cols()), Eigen::VectorXd::Zero(mPeriod), 0.0 };
+	}
+
+	// add the import of the timesteps from start onwards
+	void add(Sums& sums, Eigen::Index start, const Eigen::Ref<const Eigen::VectorXf>& imp) const {
+		const Eigen::Index n = imp.size();
+		if (mDense.cols() > 0) {
+			sums.dense.noalias() += mDense.middleRows(start, n).transpose() * imp;
+		}
+		if (mPatterns.empty()) {
+			return;
+		}
+		sums.total += imp.cast<double>().sum();
+		if (mPeriod > 0) {
+			Eigen::Index phase = start % mPeriod;
+			for (Eigen::Index i = 0; i < n; phase = 0) {
+				const Eigen::Index run = std::min(n - i, mPeriod - phase);
+				sums.phase.segment(phase, run) += imp.segment(i, run).cast<double>();
+				i += run;
+			}
+		}
+	}
+
+	// the cost under each tariff, in the order of the SiteData's import_tariffs
+	void costs(const Sums& sums, Eigen::VectorXf& costs) const;
+
+	// the heap memory in bytes held by the dense tariffs and the patterns
+	size_t ownedBytes() const;
+
+private:
+	size_t mTariffs = 0;
+
+	Eigen::MatrixXf mDense;
+	// the index of the tariff in each column of mDense
+	std::vector<size_t> mDenseIndex;
+
+	std::vector<TariffPattern> mPatterns;
+	std::vector<size_t> mPatternIndex;
+	// the period of the patterns that aren't flat (0 if there are none)
+	Eigen::Index mPeriod = 0;
+};
@@ -1,9 +1,12 @@
 #pragma once
 
 #include <optional>
+#include <span>
 #include <vector>
 #include <bit>
 #include <cstdint>
+
+#include "InlineVector.hpp"
 // This file contains definitions for the component types that make up a TaskData
 
 
@@ -61,7 +64,8 @@ struct ElectricVehicles {
     bool operator==(const ElectricVehicles&) const = default;
 };
 
-enum class BatteryMode {CONSUME, CONSUME_PLUS};
+// The lookahead modes charge from the grid at the cheapest (or lowest carbon) timestep of the day ahead
+enum class BatteryMode {CONSUME, CONSUME_PLUS, PRICE_LOOKAHEAD, CARBON_LOOKAHEAD};
 
 struct EnergyStorageSystem {
     float capacity = 20.0f;
@@ -136,6 +140,9 @@ struct SolarData {
     bool operator==(const SolarData&) const = default;
 };
 
+// The solar panels of a scenario; up to 4 are held inline, so most TaskData are copied without allocating
+using SolarPanels = InlineVector<SolarData, 4>;
+
 struct Renewables {
     std::vector<SolarData> solar_panels = {};
 
@@ -254,7 +261,7 @@ class vector_hasher {
     // Hash a vector, which we need for the renewables
     // Taken from https://stackoverflow.com/questions/20511347/a-good-hash-function-for-a-vector
     public:
-    std::size_t operator()(std::vector<T> const& vec) const {
+    std::size_t operator()(std::span<const T> vec) const {
         std::size_t seed = vec.size();
         std::hash<T> hasher;
 
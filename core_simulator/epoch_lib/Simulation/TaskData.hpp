@@ -1,10 +1,10 @@
 #pragma once
 
 #include <optional>
-#include <vector>
 
 #include <nlohmann/json.hpp>
 
+#include "ScenarioKey.hpp"
 #include "TaskComponents.hpp"
 #include "TaskConfig.hpp"
 
@@ -18,7 +18,7 @@ struct TaskData {
 	std::optional<GridData> grid;
 	std::optional<HeatPumpData> heat_pump;
 	std::optional<MopData> mop;
-	std::vector<SolarData> solar_panels;
+	SolarPanels solar_panels;
 
 	bool operator==(const TaskData& other) const { 
 		return (
@@ -35,25 +35,11 @@ struct TaskData {
 		}
 };
 
+// hashed by its ScenarioKey, which depends only on the values of its fields (and so is the same in every process)
 template<>
 struct std::hash<TaskData>
 {
-    std::size_t operator()(const TaskData& td) const noexcept
-    {
-        std::size_t h = 0;
-		hash_combine(
-			h, 
-			td.building,
-			td.data_centre, 
-			td.domestic_hot_water, 
-			td.electric_vehicles,
-			td.energy_storage_system,
-			td.gas_heater,
-			td.grid,
-			td.heat_pump,
-			td.mop,
-			vector_hasher<SolarData>{}(td.solar_panels)
-		);
-        return h;
-    }
-};
\ No newline at end of file
+	std::size_t operator()(const TaskData& td) const noexcept {
+		return static_cast<std::size_t>(scenarioKey(td).low);
+	}
+};
@@ -0,0 +1,334 @@
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <format>
+#include <numeric>
+#include <stdexcept>
+#include <unordered_map>
+
+#include "Trace.hpp"
+
+namespace {
+	// Identifies which pool (if any) the current thread is a worker of
+	thread_local const ThreadPool* tCurrentPool = nullptr;
+	thread_local size_t tWorkerIndex = 0;
+}
+
+ThreadPool::ThreadPool(size_t numThreads) {
+	if (numThreads == 0) {
+		numThreads = std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	mQueues.reserve(numThreads);
+	for (size_t i = 0; i < numThreads; i++) {
+		mQueues.push_back(std::make_unique<WorkQueue>());
+	}
+
+	mWorkers.reserve(numThreads);
+	for (size_t i = 0; i < numThreads; i++) {
+		mWorkers.emplace_back([this, i]() { workerLoop(i); });
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(mSleepMutex);
+		mStopping = true;
+	}
+	mWake.notify_all();
+
+	for (auto& worker : mWorkers) {
+		worker.join();
+	}
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+	// workers push onto their own queue to keep related work together
+	size_t queueIndex = (tCurrentPool == this)
+		? tWorkerIndex
+		: mNextQueue.fetch_add(1, std::memory_order_relaxed) % mQueues.size();
+
+	{
+		std::lock_guard<std::mutex> lock(mQueues[queueIndex]->mutex);
+		mQueues[queueIndex]->tasks.push_back(std::move(task));
+	}
+
+	{
+		// modify the pending count under the sleep mutex so that a worker cannot miss the wakeup
+		std::lock_guard<std::mutex> lock(mSleepMutex);
+		mPending.fetch_add(1, std::memory_order_release);
+	}
+	mWake.notify_one();
+}
+
+bool ThreadPool::tryPopTask(std::function<void()>& task) {
+	size_t numQueues = mQueues.size();
+	size_t start = 0;
+
+	if (tCurrentPool == this) {
+		// take the most recently pushed task from our own queue
+		start = tWorkerIndex;
+		WorkQueue& own = *mQueues[start];
+		std::lock_guard<std::mutex> lock(own.mutex);
+		if (!own.tasks.empty()) {
+			task = std::move(own.tasks.back());
+			own.tasks.pop_back();
+			mPending.fetch_sub(1, std::memory_order_acq_rel);
+			return true;
+		}
+	}
+
+	// steal the oldest task from another queue
+	for (size_t offset = 1; offset <= numQueues; offset++) {
+		WorkQueue& victim = *mQueues[(start + offset) % numQueues];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+		if (!victim.tasks.empty()) {
+			task = std::move(victim.tasks.front());
+			victim.tasks.pop_front();
+			mPending.fetch_sub(1, std::memory_order_acq_rel);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void ThreadPool::workerLoop(size_t workerIndex) {
+	tCurrentPool = this;
+	tWorkerIndex = workerIndex;
+
+	std::function<void()> task;
+	while (true) {
+		if (tryPopTask(task)) {
+			task();
+			task = nullptr;
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(mSleepMutex);
+		mWake.wait(lock, [this]() { return mStopping || mPending.load(std::memory_order_acquire) > 0; });
+		if (mStopping && mPending.load(std::memory_order_acquire) == 0) {
+			return;
+		}
+	}
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& fn) {
+	if (count == 0) {
+		return;
+	}
+	TraceScope trace{ "parallelFor", "scheduler" };
+
+	// The remaining count is guarded by groupMutex so that the last task has
+	// finished touching this stack frame before the caller is able to return
+	std::mutex groupMutex;
+	std::condition_variable groupDone;
+	size_t remaining = count;
+	std::exception_ptr firstError;
+
+	for (size_t i = 0; i < count; i++) {
+		submit([&, i]() {
+			std::exception_ptr error;
+			try {
+				fn(i);
+			}
+			catch (...) {
+				error = std::current_exception();
+			}
+
+			std::lock_guard<std::mutex> lock(groupMutex);
+			if (error && !firstError) {
+				firstError = error;
+			}
+			if (--remaining == 0) {
+				groupDone.notify_all();
+			}
+		});
+	}
+
+	// help with the queued work rather than blocking a thread
+	std::function<void()> task;
+	while (true) {
+		{
+			std::lock_guard<std::mutex> lock(groupMutex);
+			if (remaining == 0) {
+				break;
+			}
+		}
+
+		if (tryPopTask(task)) {
+			task();
+			task = nullptr;
+		}
+		else {
+			// Everything has been picked up, so wait for the stragglers
+			std::unique_lock<std::mutex> lock(groupMutex);
+			groupDone.wait(lock, [&]() { return remaining == 0; });
+			break;
+		}
+	}
+
+	if (firstError) {
+		std::rethrow_exception(firstError);
+	}
+}
+
+void ThreadPool::parallelForByCost(std::span<const float> costs, std::span<const size_t> affinity, const std::function<void(size_t)>& fn) {
+	const size_t count = costs.size();
+	if (count == 0) {
+		return;
+	}
+	if (!affinity.empty() && affinity.size() != count) {
+		throw std::invalid_argument(std::format("There are {} affinities for {} jobs", affinity.size(), count));
+	}
+	TraceScope trace{ "parallelForByCost", "scheduler" };
+
+	struct Lane {
+		std::mutex mutex;
+		// the jobs still to run (see dealByCost)
+		std::deque<size_t> jobs;
+	};
+	// (the calling thread runs a lane too)
+	const size_t numLanes = std::min(count, size() + 1);
+	std::vector<Lane> lanes(numLanes);
+	auto dealt = dealByCost(costs, affinity, numLanes);
+	for (size_t l = 0; l < numLanes; l++) {
+		lanes[l].jobs = std::move(dealt[l]);
+	}
+
+	std::mutex errorMutex;
+	std::exception_ptr firstError;
+	auto run = [&](size_t job) {
+		try {
+			fn(job);
+		}
+		catch (...) {
+			std::lock_guard<std::mutex> lock(errorMutex);
+			if (!firstError) {
+				firstError = std::current_exception();
+			}
+		}
+	};
+
+	// the longest of the jobs at the front of each lane (which is usually the longest job left in it)
+	auto steal = [&](size_t& job) {
+		size_t victim = numLanes;
+		float longest = 0.0f;
+		for (size_t l = 0; l < numLanes; l++) {
+			std::lock_guard<std::mutex> lock(lanes[l].mutex);
+			if (!lanes[l].jobs.empty() && (victim == numLanes || costs[lanes[l].jobs.front()] > longest)) {
+				victim = l;
+				longest = costs[lanes[l].jobs.front()];
+			}
+		}
+		if (victim == numLanes) {
+			return false;
+		}
+		std::lock_guard<std::mutex> lock(lanes[victim].mutex);
+		// another lane may have taken it in the meantime, in which case take the next
+		if (lanes[victim].jobs.empty()) {
+			return true;
+		}
+		job = lanes[victim].jobs.front();
+		lanes[victim].jobs.pop_front();
+		return true;
+	};
+
+	parallelFor(numLanes, [&](size_t l) {
+		Lane& lane = lanes[l];
+		while (true) {
+			size_t job = count;
+			{
+				std::lock_guard<std::mutex> lock(lane.mutex);
+				if (!lane.jobs.empty()) {
+					job = lane.jobs.front();
+					lane.jobs.pop_front();
+				}
+			}
+			if (job == count && !steal(job)) {
+				return;
+			}
+			if (job != count) {
+				run(job);
+			}
+		}
+	});
+
+	if (firstError) {
+		std::rethrow_exception(firstError);
+	}
+}
+
+std::vector<std::deque<size_t>> ThreadPool::dealByCost(std::span<const float> costs, std::span<const size_t> affinity, size_t numLanes) {
+	std::vector<size_t> order(costs.size());
+	std::iota(order.begin(), order.end(), size_t{ 0 });
+	std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return costs[a] > costs[b]; });
+
+	std::vector<std::deque<size_t>> lanes(numLanes);
+	std::vector<double> loads(numLanes, 0.0);
+	std::unordered_map<size_t, size_t> affinityLanes;
+
+	// a lane's share of the total cost (which can be no less than the longest job)
+	double share = 0.0;
+	for (float cost : costs) {
+		share += std::max(cost, 0.0f);
+	}
+	share = std::max(share / static_cast<double>(numLanes), order.empty() ? 0.0 : std::max(costs[order.front()], 0.0f));
+
+	// deal out the jobs longest first to the least loaded lane (the LPT heuristic),
+	// unless the lane of the job's affinity would still hold no more than its share with the job
+	for (size_t job : order) {
+		const double cost = std::max(costs[job], 0.0f);
+		size_t lane = static_cast<size_t>(std::min_element(loads.begin(), loads.end()) - loads.begin());
+		if (!affinity.empty()) {
+			auto [it, inserted] = affinityLanes.try_emplace(affinity[job], lane);
+			if (!inserted && loads[it->second] + cost <= share) {
+				lane = it->second;
+			}
+		}
+		lanes[lane].push_back(job);
+		loads[lane] += cost;
+	}
+
+	// each lane runs the jobs of an affinity one after another (longest first),
+	// starting with the affinity of its longest job, so that they find what they share still in the cache
+	if (!affinity.empty()) {
+		// (the buffers are shared by every lane, so this allocates little however many affinities there are)
+		std::vector<std::pair<size_t, size_t>> positions;
+		std::vector<size_t> jobs;
+		positions.reserve(costs.size());
+		jobs.reserve(costs.size());
+		for (auto& lane : lanes) {
+			// each position by its affinity, then the position of the first job of that affinity with each
+			positions.clear();
+			for (size_t pos = 0; pos < lane.size(); pos++) {
+				positions.emplace_back(affinity[lane[pos]], pos);
+			}
+			std::sort(positions.begin(), positions.end());
+			for (size_t first = 0; first < positions.size();) {
+				size_t last = first;
+				const size_t firstPosition = positions[first].second;
+				for (; last < positions.size() && positions[last].first == positions[first].first; last++) {}
+				for (size_t k = first; k < last; k++) {
+					positions[k].first = firstPosition;
+				}
+				first = last;
+			}
+			std::sort(positions.begin(), positions.end());
+
+			jobs.assign(lane.begin(), lane.end());
+			for (size_t k = 0; k < positions.size(); k++) {
+				lane[k] = jobs[positions[k].second];
+			}
+		}
+	}
+	return lanes;
+}
+
+ThreadPool& ThreadPool::shared() {
+	// Deliberately leaked: joining worker threads during static destruction
+	// can deadlock when the library is unloaded as part of a Python extension module
+	static ThreadPool* pool = new ThreadPool();
+	return *pool;
+}
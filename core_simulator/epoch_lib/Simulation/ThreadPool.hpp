@@ -0,0 +1,95 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+/**
+* A persistent pool of worker threads with per-worker task queues
+*
+* Each worker takes tasks from the back of its own queue and, when that is empty,
+* steals from the front of the other workers' queues.
+* Tasks submitted from outside of the pool are distributed round robin across the queues.
+*
+* The pool is intended for coarse-grained work (e.g. one task per scenario),
+* so the queues use a mutex each rather than a lock-free deque.
+*/
+class ThreadPool {
+public:
+	/**
+	* Construct a pool with the given number of worker threads
+	* A value of 0 uses the number of hardware threads
+	*/
+	explicit ThreadPool(size_t numThreads = 0);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	size_t size() const { return mWorkers.size(); }
+
+	/**
+	* Queue a task to be run on one of the workers
+	* Exceptions must not escape the task
+	*/
+	void submit(std::function<void()> task);
+
+	/**
+	* Run fn(i) for every i in [0, count) and block until they have all completed
+	*
+	* The calling thread helps to run queued tasks while it waits, so this is safe to call from within a task.
+	* If any invocation throws, the first exception is rethrown once all invocations have finished.
+	*/
+	void parallelFor(size_t count, const std::function<void(size_t)>& fn);
+
+	/**
+	* Run fn(i) for every i in [0, costs.size()), longest first, and block until they have all completed
+	*
+	* costs are the estimated costs of each job (in any unit). The jobs are dealt out longest first to a lane
+	* for each worker and the calling thread, keeping jobs with the same affinity (such as the scenarios of one site,
+	* which share its SiteData) in the same lane until it holds its share of the total cost.
+	* Each lane runs its own jobs longest first, though the jobs of one affinity are run one after another
+	* (starting with the affinity of its longest job); a lane that runs out steals the job at the front of another,
+	* choosing the longest of those.
+	* affinity may be empty, and otherwise has an entry for every job.
+	* As with parallelFor, the first exception is rethrown once every job has finished.
+	*/
+	void parallelForByCost(std::span<const float> costs, std::span<const size_t> affinity, const std::function<void(size_t)>& fn);
+
+	/**
+	* The jobs of each of numLanes lanes, as parallelForByCost deals them out (each lane longest first)
+	*/
+	static std::vector<std::deque<size_t>> dealByCost(std::span<const float> costs, std::span<const size_t> affinity, size_t numLanes);
+
+	/**
+	* A process-wide pool, created on first use and sized to the hardware
+	*/
+	static ThreadPool& shared();
+
+private:
+	struct WorkQueue {
+		std::mutex mutex;
+		std::deque<std::function<void()>> tasks;
+	};
+
+	void workerLoop(size_t workerIndex);
+
+	// Pop a task from our own queue (if we are a worker) or steal from another
+	bool tryPopTask(std::function<void()>& task);
+
+	std::vector<std::unique_ptr<WorkQueue>> mQueues;
+	std::vector<std::thread> mWorkers;
+
+	std::mutex mSleepMutex;
+	std::condition_variable mWake;
+	std::atomic<size_t> mPending{ 0 };
+	std::atomic<size_t> mNextQueue{ 0 };
+	bool mStopping = false;
+};
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include <Eigen/Core>
+
+/**
+* The timeseries buffers released by the scenarios simulated on this thread, kept for the next scenario to reuse
+*
+* Every scenario of a Simulator uses the same number of vectors of the same length,
+* so once a thread has simulated one scenario the next is simulated without allocating any timeseries.
+*/
+class TimeseriesPool {
+public:
+	// enough for the vectors of every component of a scenario and the snapshot of its TempSum
+	static constexpr size_t MAX_BUFFERS = 64;
+
+	// give buffer a free block of n floats (with unspecified values), allocating only if there isn't one
+	static void acquire(Eigen::VectorXf& buffer, Eigen::Index n) {
+		if (Pool* pool = local()) {
+			auto& free = pool->buffers;
+			for (size_t i = free.size(); i-- > 0;) {
+				if (free[i].size() == n) {
+					buffer.swap(free[i]);
+					free[i].swap(free.back());
+					free.pop_back();
+					return;
+				}
+			}
+		}
+		buffer.resize(n);
+	}
+
+	// take the buffer back for reuse, leaving it empty; it is freed instead if the pool is full
+	static void release(Eigen::VectorXf& buffer) {
+		if (buffer.size() == 0) {
+			return;
+		}
+		Pool* pool = local();
+		if (pool && pool->buffers.size() < MAX_BUFFERS) {
+			pool->buffers.emplace_back().swap(buffer);
+		}
+		else {
+			buffer.resize(0);
+		}
+	}
+
+	// the number of free buffers held for this thread
+	static size_t size() {
+		Pool* pool = local();
+		return pool ? pool->buffers.size() : 0;
+	}
+
+	// free every buffer held for this thread
+	static void clear() {
+		if (Pool* pool = local()) {
+			pool->buffers.clear();
+		}
+	}
+
+private:
+	struct Pool {
+		Pool() { buffers.reserve(MAX_BUFFERS); }
+		~Pool() { destroyed() = true; }
+		std::vector<Eigen::VectorXf> buffers;
+	};
+
+	// set once the thread's pool has been destroyed at thread exit, as later destructors may still release to it
+	static bool& destroyed() {
+		thread_local bool isDestroyed = false;
+		return isDestroyed;
+	}
+
+	static Pool* local() {
+		if (destroyed()) {
+			return nullptr;
+		}
+		thread_local Pool pool;
+		return &pool;
+	}
+};
+
+/**
+* A year_TS whose buffer is taken from and returned to the thread's TimeseriesPool
+*
+* The components that a scenario constructs hold their timeseries as PooledTS,
+* so simulating a scenario reuses the buffers of the scenario before it.
+* The size constructor zeroes the values like Eigen::VectorXf::Zero.
+*/
+class PooledTS : public Eigen::VectorXf {
+public:
+	using Base = Eigen::VectorXf;
+
+	PooledTS() = default;
+
+	explicit PooledTS(Eigen::Index n, float value = 0.0f) : Base() {
+		TimeseriesPool::acquire(*this, n);
+		Base::setConstant(value);
+	}
+
+	PooledTS(const PooledTS& other) : Base() {
+		TimeseriesPool::acquire(*this, other.size());
+		Base::operator=(other);
+	}
+
+	PooledTS(PooledTS&& other) noexcept : Base(std::move(static_cast<Base&>(other))) {}
+
+	// evaluate an Eigen expression into a pooled buffer
+	template <typename Derived>
+	PooledTS(const Eigen::DenseBase<Derived>& other) : Base() {
+		TimeseriesPool::acquire(*this, other.size());
+		Base::operator=(other);
+	}
+
+	~PooledTS() {
+		TimeseriesPool::release(*this);
+	}
+
+	PooledTS& operator=(const PooledTS& other) {
+		return assign(other);
+	}
+
+	PooledTS& operator=(PooledTS&& other) noexcept {
+		// other returns this buffer to the pool
+		Base::swap(static_cast<Base&>(other));
+		return *this;
+	}
+
+	template <typename Derived>
+	PooledTS& operator=(const Eigen::DenseBase<Derived>& other) {
+		return assign(other);
+	}
+
+private:
+	template <typename Derived>
+	PooledTS& assign(const Eigen::DenseBase<Derived>& other) {
+		if (other.size() != size()) {
+			// evaluate into a new buffer first, as the expression may refer to this one
+			PooledTS resized(other);
+			Base::swap(static_cast<Base&>(resized));
+		}
+		else {
+			Base::operator=(other);
+		}
+		return *this;
+	}
+};
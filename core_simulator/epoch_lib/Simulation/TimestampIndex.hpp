@@ -0,0 +1,27 @@
+#pragma once
+// the time at which each timestep of a site starts
+
+#include <chrono>
+#include <cstdint>
+
+#include <Eigen/Core>
+
+#include "SiteData.hpp"
+
+// the start of each timestep, in nanoseconds since the unix epoch (UTC)
+// (the representation of pandas' datetime64[ns] and Arrow's timestamp[ns])
+using TimestampIndex = Eigen::Matrix<int64_t, Eigen::Dynamic, 1>;
+
+/**
+* The start of every timestep of a SiteData, which is start_ts and then every timestep_interval_s after it
+*/
+inline TimestampIndex makeTimestampIndex(const SiteData& siteData) {
+	const int64_t start = std::chrono::duration_cast<std::chrono::nanoseconds>(siteData.start_ts.time_since_epoch()).count();
+	const int64_t interval = std::chrono::duration_cast<std::chrono::nanoseconds>(siteData.timestep_interval_s).count();
+
+	TimestampIndex index(static_cast<Eigen::Index>(siteData.timesteps));
+	for (Eigen::Index t = 0; t < index.size(); t++) {
+		index[t] = start + interval * t;
+	}
+	return index;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+* One bit per timestep, for the conditions that only depend on the SiteData
+* (such as whether a tariff is low enough for the ESS to charge from the grid)
+* These are precalculated when the Simulator is constructed and read by the balancing loop
+*/
+class TimestepMask {
+public:
+	TimestepMask() = default;
+
+	explicit TimestepMask(size_t timesteps) :
+		mWords((timesteps + 63) / 64, 0)
+	{}
+
+	void set(size_t timestep, bool value) {
+		const uint64_t bit = uint64_t{ 1 } << (timestep % 64);
+		mWords[timestep / 64] = value ? mWords[timestep / 64] | bit : mWords[timestep / 64] & ~bit;
+	}
+
+	bool test(size_t timestep) const {
+		return (mWords[timestep / 64] >> (timestep % 64)) & 1;
+	}
+
+	// the number of timesteps that are set
+	size_t count() const {
+		size_t n = 0;
+		for (uint64_t word : mWords) {
+			n += static_cast<size_t>(std::popcount(word));
+		}
+		return n;
+	}
+
+	size_t ownedBytes() const {
+		return sizeof(uint64_t) * mWords.capacity();
+	}
+
+private:
+	std::vector<uint64_t> mWords;
+};
@@ -0,0 +1,173 @@
+#include "Trace.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <memory>
+#include <mutex>
+
+#include <nlohmann/json.hpp>
+
+#include "../Exceptions.hpp"
+
+namespace {
+	struct ThreadBuffer {
+		ThreadBuffer(uint32_t threadId, size_t capacity) :
+			threadId(threadId), events(capacity) {}
+
+		uint32_t threadId;
+		std::vector<TraceEvent> events;
+		// every event ever recorded into this buffer; events[written % capacity] is the next to be written
+		std::atomic<uint64_t> written{ 0 };
+	};
+
+	struct Registry {
+		std::mutex mutex;
+		// the buffers are owned here as well as by their thread, so the events of a finished thread are kept
+		std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+		size_t capacity = DEFAULT_TRACE_EVENTS_PER_THREAD;
+	};
+
+	Registry& registry() {
+		static Registry instance;
+		return instance;
+	}
+
+	// the session that each thread's buffer belongs to (0 before tracing is first started)
+	std::atomic<uint64_t> gSession{ 0 };
+	// when the current session started, in steady_clock nanoseconds
+	std::atomic<int64_t> gEpochNs{ 0 };
+
+	thread_local std::shared_ptr<ThreadBuffer> tBuffer;
+	thread_local uint64_t tSession = 0;
+
+	int64_t toNanoseconds(std::chrono::steady_clock::time_point t) {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+	}
+
+	uint32_t currentThreadId() {
+		static std::atomic<uint32_t> next{ 1 };
+		thread_local const uint32_t id = next.fetch_add(1, std::memory_order_relaxed);
+		return id;
+	}
+
+	ThreadBuffer& localBuffer() {
+		if (tSession != gSession.load(std::memory_order_acquire)) {
+			Registry& reg = registry();
+			std::lock_guard<std::mutex> lock(reg.mutex);
+			tBuffer = std::make_shared<ThreadBuffer>(currentThreadId(), reg.capacity);
+			tSession = gSession.load(std::memory_order_relaxed);
+			reg.buffers.push_back(tBuffer);
+		}
+		return *tBuffer;
+	}
+}
+
+void Tracer::start(size_t eventsPerThread) {
+	Registry& reg = registry();
+	std::lock_guard<std::mutex> lock(reg.mutex);
+	sActive.store(false, std::memory_order_relaxed);
+
+	reg.buffers.clear();
+	reg.capacity = std::max<size_t>(eventsPerThread, 1);
+	gEpochNs.store(toNanoseconds(std::chrono::steady_clock::now()), std::memory_order_relaxed);
+	gSession.fetch_add(1, std::memory_order_release);
+
+	sActive.store(true, std::memory_order_release);
+}
+
+void Tracer::stop() {
+	sActive.store(false, std::memory_order_release);
+}
+
+void Tracer::record(const char* name, const char* category,
+	std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end, std::string_view detail) {
+	const int64_t startNs = toNanoseconds(start) - gEpochNs.load(std::memory_order_relaxed);
+	if (startNs < 0) {
+		// this began before the current session
+		return;
+	}
+
+	ThreadBuffer& buffer = localBuffer();
+	const uint64_t n = buffer.written.load(std::memory_order_relaxed);
+	TraceEvent& event = buffer.events[n % buffer.events.size()];
+
+	event.name = name;
+	event.category = category;
+	event.start_ns = startNs;
+	event.duration_ns = toNanoseconds(end) - toNanoseconds(start);
+	// keep the detail null-terminated
+	const size_t length = std::min(detail.size(), event.detail.size() - 1);
+	std::memcpy(event.detail.data(), detail.data(), length);
+	event.detail[length] = '\0';
+
+	buffer.written.store(n + 1, std::memory_order_release);
+}
+
+std::vector<TraceThread> Tracer::collect() {
+	Registry& reg = registry();
+	std::lock_guard<std::mutex> lock(reg.mutex);
+
+	std::vector<TraceThread> threads;
+	threads.reserve(reg.buffers.size());
+	for (const auto& buffer : reg.buffers) {
+		const uint64_t written = buffer->written.load(std::memory_order_acquire);
+		const uint64_t capacity = buffer->events.size();
+		const uint64_t kept = std::min(written, capacity);
+
+		TraceThread& thread = threads.emplace_back();
+		thread.thread_id = buffer->threadId;
+		thread.dropped = written - kept;
+		thread.events.reserve(kept);
+		for (uint64_t i = written - kept; i < written; i++) {
+			thread.events.push_back(buffer->events[i % capacity]);
+		}
+	}
+
+	std::sort(threads.begin(), threads.end(), [](const TraceThread& a, const TraceThread& b) { return a.thread_id < b.thread_id; });
+	return threads;
+}
+
+std::string Tracer::chromeTrace() {
+	nlohmann::json events = nlohmann::json::array();
+	uint64_t dropped = 0;
+
+	for (const TraceThread& thread : collect()) {
+		events.push_back({
+			{"name", "thread_name"}, {"ph", "M"}, {"pid", 1}, {"tid", thread.thread_id},
+			{"args", {{"name", std::format("thread {}", thread.thread_id)}}}
+		});
+
+		for (const TraceEvent& event : thread.events) {
+			nlohmann::json e = {
+				{"name", event.name}, {"cat", event.category}, {"ph", "X"},
+				// the format's times are in microseconds
+				{"ts", static_cast<double>(event.start_ns) / 1000.0},
+				{"dur", static_cast<double>(event.duration_ns) / 1000.0},
+				{"pid", 1}, {"tid", thread.thread_id}
+			};
+			if (event.detail[0] != '\0') {
+				e["args"] = {{"detail", std::string(event.detail.data())}};
+			}
+			events.push_back(std::move(e));
+		}
+		dropped += thread.dropped;
+	}
+
+	nlohmann::json trace = {
+		{"traceEvents", std::move(events)},
+		{"displayTimeUnit", "ms"},
+		{"otherData", {{"dropped_events", dropped}}}
+	};
+	// a truncated detail may end part way through a multi-byte character
+	return trace.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace);
+}
+
+void Tracer::writeChromeTrace(const std::filesystem::path& path) {
+	std::ofstream out(path, std::ios::binary | std::ios::trunc);
+	if (!out.is_open()) {
+		throw FileWriteException(path.filename().string());
+	}
+	out << chromeTrace();
+}
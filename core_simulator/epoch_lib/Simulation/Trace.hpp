@@ -0,0 +1,113 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#ifdef EPOCH_TRACING
+constexpr bool TRACING_ENABLED = true;
+#else
+constexpr bool TRACING_ENABLED = false;
+#endif
+
+/**
+* A completed span of work on one thread
+*
+* The name and category must be string literals (only the pointers are kept);
+* the detail (such as a site name) is copied, and truncated to fit.
+*/
+struct TraceEvent {
+	const char* name = nullptr;
+	const char* category = nullptr;
+	// nanoseconds since tracing was started
+	int64_t start_ns = 0;
+	int64_t duration_ns = 0;
+	std::array<char, 40> detail{};
+};
+
+/**
+* The events recorded by one thread, oldest first
+*/
+struct TraceThread {
+	uint32_t thread_id = 0;
+	std::vector<TraceEvent> events;
+	// the events that were overwritten once the thread's buffer was full
+	uint64_t dropped = 0;
+};
+
+inline constexpr size_t DEFAULT_TRACE_EVENTS_PER_THREAD = 1 << 16;
+
+/**
+* Records TraceEvents into a fixed-size ring buffer per thread
+*
+* Recording takes no lock: each thread only ever writes its own buffer
+* (the buffers are registered under a lock, once per thread per session).
+* When a buffer is full its oldest events are overwritten, so a long run keeps its most recent events.
+*
+* Collect the events (or write the Chrome trace) once the traced work has finished;
+* events still being recorded while they are collected may be missed.
+*
+* This compiles away when EPOCH_TRACING is not defined,
+* and while tracing is stopped each TraceScope costs a single relaxed atomic load.
+*/
+class Tracer {
+public:
+	// start a new session, discarding any events already recorded
+	static void start(size_t eventsPerThread = DEFAULT_TRACE_EVENTS_PER_THREAD);
+	// stop recording (the recorded events are kept until the next start)
+	static void stop();
+	static bool active() { return sActive.load(std::memory_order_relaxed); }
+
+	static void record(const char* name, const char* category,
+		std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end, std::string_view detail = {});
+
+	static std::vector<TraceThread> collect();
+
+	// the recorded events in the Chrome trace event format, which Perfetto and chrome://tracing can open
+	static std::string chromeTrace();
+	static void writeChromeTrace(const std::filesystem::path& path);
+
+private:
+	static inline std::atomic<bool> sActive{ false };
+};
+
+/**
+* Records the time between construction and destruction as a TraceEvent on the current thread
+*/
+class TraceScope {
+public:
+	TraceScope(const char* name, const char* category, std::string_view detail = {}) {
+		if constexpr (TRACING_ENABLED) {
+			if (Tracer::active()) {
+				mName = name;
+				mCategory = category;
+				mDetail = detail;
+				mStart = std::chrono::steady_clock::now();
+			}
+		}
+	}
+
+	~TraceScope() {
+		if constexpr (TRACING_ENABLED) {
+			if (mName) {
+				Tracer::record(mName, mCategory, mStart, std::chrono::steady_clock::now(), mDetail);
+			}
+		}
+	}
+
+	TraceScope(const TraceScope&) = delete;
+	TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+	const char* mName = nullptr;
+	const char* mCategory = nullptr;
+	// the detail must outlive the scope
+	std::string_view mDetail;
+	std::chrono::steady_clock::time_point mStart;
+};
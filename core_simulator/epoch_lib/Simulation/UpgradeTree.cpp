@@ -0,0 +1,96 @@
+#include "UpgradeTree.hpp"
+
+#include <algorithm>
+#include <format>
+#include <stdexcept>
+
+namespace {
+	template <typename Component>
+	Upgrade replace(const std::string& name, Component TaskData::* member, const TaskData& end) {
+		return { name, [member, value = end.*member](TaskData& taskData) { taskData.*member = value; } };
+	}
+}
+
+std::vector<std::string> differingComponents(const TaskData& start, const TaskData& end) {
+	std::vector<std::string> components;
+	auto compare = [&](const char* name, const auto& a, const auto& b) {
+		if (a != b) {
+			components.emplace_back(name);
+		}
+	};
+
+	compare("building", start.building, end.building);
+	compare("data_centre", start.data_centre, end.data_centre);
+	compare("domestic_hot_water", start.domestic_hot_water, end.domestic_hot_water);
+	compare("electric_vehicles", start.electric_vehicles, end.electric_vehicles);
+	compare("energy_storage_system", start.energy_storage_system, end.energy_storage_system);
+	compare("grid", start.grid, end.grid);
+	compare("heat_pump", start.heat_pump, end.heat_pump);
+	compare("mop", start.mop, end.mop);
+	compare("solar_panels", start.solar_panels, end.solar_panels);
+
+	const bool removesGasHeater = start.gas_heater && !end.gas_heater;
+	const bool installsHeatPump = end.heat_pump && start.heat_pump != end.heat_pump;
+	if (start.gas_heater != end.gas_heater && !(removesGasHeater && installsHeatPump)) {
+		components.emplace_back("gas_heater");
+	}
+
+	std::sort(components.begin(), components.end());
+	return components;
+}
+
+std::vector<Upgrade> componentUpgrades(const TaskData& end, std::span<const std::string> components) {
+	std::vector<Upgrade> upgrades;
+	for (const std::string& name : components) {
+		if (name == "building") {
+			upgrades.push_back(replace(name, &TaskData::building, end));
+		}
+		else if (name == "data_centre") {
+			upgrades.push_back(replace(name, &TaskData::data_centre, end));
+		}
+		else if (name == "domestic_hot_water") {
+			upgrades.push_back(replace(name, &TaskData::domestic_hot_water, end));
+		}
+		else if (name == "electric_vehicles") {
+			upgrades.push_back(replace(name, &TaskData::electric_vehicles, end));
+		}
+		else if (name == "energy_storage_system") {
+			upgrades.push_back(replace(name, &TaskData::energy_storage_system, end));
+		}
+		else if (name == "gas_heater") {
+			upgrades.push_back(replace(name, &TaskData::gas_heater, end));
+		}
+		else if (name == "grid") {
+			upgrades.push_back(replace(name, &TaskData::grid, end));
+		}
+		else if (name == "heat_pump") {
+			const bool removeGasHeater = !end.gas_heater;
+			upgrades.push_back({ name, [heatPump = end.heat_pump, removeGasHeater](TaskData& taskData) {
+				taskData.heat_pump = heatPump;
+				if (removeGasHeater) {
+					taskData.gas_heater.reset();
+				}
+			} });
+		}
+		else if (name == "mop") {
+			upgrades.push_back(replace(name, &TaskData::mop, end));
+		}
+		else if (name == "solar_panels") {
+			upgrades.push_back(replace(name, &TaskData::solar_panels, end));
+		}
+		else {
+			throw std::runtime_error(std::format("Unknown component {} to upgrade", name));
+		}
+	}
+	return upgrades;
+}
+
+std::string upgradeNodeName(size_t mask, size_t numUpgrades) {
+	std::string name(numUpgrades, '0');
+	for (size_t i = 0; i < numUpgrades; i++) {
+		if (mask & (size_t{ 1 } << i)) {
+			name[i] = '1';
+		}
+	}
+	return name;
+}
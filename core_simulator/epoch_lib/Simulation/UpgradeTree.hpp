@@ -0,0 +1,48 @@
+#pragma once
+// every combination of a set of upgrades to a scenario, as in the optimisation service's upgrade tree
+
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "../Definitions.hpp"
+#include "TaskData.hpp"
+
+// the most upgrades in a tree (which has 2^n nodes)
+inline constexpr size_t MAX_UPGRADES = 16;
+
+/**
+* A change to a scenario, such as installing a heat pump
+*/
+struct Upgrade {
+	std::string name;
+	std::function<void(TaskData&)> apply;
+};
+
+struct UpgradeTreeResult {
+	// the names of the upgrades, in the order of the characters of each node
+	std::vector<std::string> upgrades;
+	// the result of every combination of the upgrades, keyed by whether each upgrade is included (such as "0110")
+	std::map<std::string, SimulationResult> nodes;
+	// the number of nodes that were simulated from their parent's state before the balancing loop
+	size_t reused_pre_balancing = 0;
+};
+
+/**
+* The components of end that differ from start, in alphabetical order (as in the optimisation service's analyse_differences)
+* The removal of the gas heater when a heat pump is installed is part of installing the heat pump, so it isn't a difference of its own
+*/
+std::vector<std::string> differingComponents(const TaskData& start, const TaskData& end);
+
+/**
+* An upgrade for each of the named components that replaces the scenario's component (or solar panels) with that of end
+* Installing a heat pump also removes the gas heater when end has none.
+* Raise an exception for an unknown component
+*/
+std::vector<Upgrade> componentUpgrades(const TaskData& end, std::span<const std::string> components);
+
+// the node of a tree with the upgrades in a bitmask, with upgrade i as character i
+std::string upgradeNodeName(size_t mask, size_t numUpgrades);
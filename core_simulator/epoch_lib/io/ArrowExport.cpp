@@ -0,0 +1,216 @@
+#include "ArrowExport.hpp"
+
+#include <array>
+#include <cerrno>
+#include <exception>
+#include <format>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+	// a column of the batch: its name, Arrow format and values
+	struct ExportColumn {
+		const char* name;
+		const char* format;
+		const void* data;
+	};
+
+	// the schema's children are never owned by their parent, so a child that a consumer moves out stays valid
+	void releaseChildSchema(ArrowSchema* schema) {
+		schema->release = nullptr;
+	}
+
+	struct SchemaData {
+		std::vector<ArrowSchema> children;
+		std::vector<ArrowSchema*> childPointers;
+	};
+
+	void releaseSchema(ArrowSchema* schema) {
+		auto* data = static_cast<SchemaData*>(schema->private_data);
+		for (ArrowSchema& child : data->children) {
+			if (child.release) {
+				child.release(&child);
+			}
+		}
+		delete data;
+		schema->release = nullptr;
+	}
+
+	// each column keeps the storage alive for itself, as it may be moved out and outlive the batch
+	struct ColumnData {
+		std::shared_ptr<const void> owner;
+		std::array<const void*, 2> buffers;
+	};
+
+	void releaseColumn(ArrowArray* array) {
+		delete static_cast<ColumnData*>(array->private_data);
+		array->release = nullptr;
+	}
+
+	struct BatchData {
+		std::vector<ArrowArray> children;
+		std::vector<ArrowArray*> childPointers;
+		// a struct array has only a validity buffer, which is absent as there are no nulls
+		std::array<const void*, 1> buffers{ nullptr };
+	};
+
+	void releaseBatch(ArrowArray* array) {
+		auto* data = static_cast<BatchData*>(array->private_data);
+		for (ArrowArray& child : data->children) {
+			if (child.release) {
+				child.release(&child);
+			}
+		}
+		delete data;
+		array->release = nullptr;
+	}
+
+	struct StreamData {
+		ArrowReportExport source;
+		bool exported = false;
+		std::string lastError;
+	};
+
+	// run an export of a stream callback, returning an errno code rather than throwing across the C interface
+	template <typename Export>
+	int streamCall(ArrowArrayStream* stream, Export&& exportTo) {
+		auto* data = static_cast<StreamData*>(stream->private_data);
+		try {
+			exportTo(*data);
+			return 0;
+		}
+		catch (const std::bad_alloc&) {
+			data->lastError = "Out of memory";
+			return ENOMEM;
+		}
+		catch (const std::exception& e) {
+			data->lastError = e.what();
+			return EIO;
+		}
+	}
+
+	std::vector<ExportColumn> exportColumns(const ReportData& reportData, const TimestampIndex* timestamps) {
+		std::vector<ExportColumn> columns;
+		if (timestamps) {
+			columns.push_back(ExportColumn{ ARROW_TIMESTAMP_COLUMN, "tsn:UTC", timestamps->data() });
+		}
+		for (ReportColumn column : reportData.populatedColumns()) {
+			columns.push_back(ExportColumn{ REPORT_COLUMN_NAMES[static_cast<size_t>(column)], "f", reportData.get(column).data() });
+		}
+		return columns;
+	}
+}
+
+ArrowReportExport::ArrowReportExport(const ReportData& reportData, std::shared_ptr<const TimestampIndex> timestamps,
+	std::shared_ptr<const void> owner) :
+	mReportData(reportData),
+	mTimestamps(std::move(timestamps)),
+	mOwner(std::move(owner))
+{
+	// an empty ReportData has no columns, so is as long as any index
+	if (mTimestamps && mReportData.numPopulated() > 0 && mTimestamps->size() != mReportData.timesteps()) {
+		throw std::runtime_error(std::format("Cannot index a ReportData of {} timesteps with {} timestamps",
+			mReportData.timesteps(), mTimestamps->size()));
+	}
+}
+
+void ArrowReportExport::exportSchema(ArrowSchema* out) const {
+	const std::vector<ExportColumn> columns = exportColumns(mReportData, mTimestamps.get());
+
+	auto data = std::make_unique<SchemaData>();
+	data->children.resize(columns.size());
+	for (size_t i = 0; i < columns.size(); i++) {
+		data->children[i] = ArrowSchema{
+			.format = columns[i].format,
+			.name = columns[i].name,
+			.metadata = nullptr,
+			.flags = 0,
+			.n_children = 0,
+			.children = nullptr,
+			.dictionary = nullptr,
+			.release = releaseChildSchema,
+			.private_data = nullptr
+		};
+		data->childPointers.push_back(&data->children[i]);
+	}
+
+	*out = ArrowSchema{
+		.format = "+s",
+		.name = "",
+		.metadata = nullptr,
+		.flags = 0,
+		.n_children = static_cast<int64_t>(columns.size()),
+		.children = data->childPointers.data(),
+		.dictionary = nullptr,
+		.release = releaseSchema,
+		.private_data = data.release()
+	};
+}
+
+void ArrowReportExport::exportArray(ArrowArray* out) const {
+	const std::vector<ExportColumn> columns = exportColumns(mReportData, mTimestamps.get());
+	// the length of an empty ReportData is that of its index, so that the timestamps are all exported
+	const int64_t length = mReportData.numPopulated() > 0 || !mTimestamps
+		? static_cast<int64_t>(mReportData.timesteps()) : static_cast<int64_t>(mTimestamps->size());
+
+	auto data = std::make_unique<BatchData>();
+	data->children.resize(columns.size());
+	for (size_t i = 0; i < columns.size(); i++) {
+		auto column = std::make_unique<ColumnData>(ColumnData{ mOwner, { nullptr, columns[i].data } });
+		data->children[i] = ArrowArray{
+			.length = length,
+			.null_count = 0,
+			.offset = 0,
+			.n_buffers = 2,
+			.n_children = 0,
+			.buffers = column->buffers.data(),
+			.children = nullptr,
+			.dictionary = nullptr,
+			.release = releaseColumn,
+			.private_data = column.release()
+		};
+		data->childPointers.push_back(&data->children[i]);
+	}
+
+	*out = ArrowArray{
+		.length = length,
+		.null_count = 0,
+		.offset = 0,
+		.n_buffers = 1,
+		.n_children = static_cast<int64_t>(columns.size()),
+		.buffers = data->buffers.data(),
+		.children = data->childPointers.data(),
+		.dictionary = nullptr,
+		.release = releaseBatch,
+		.private_data = data.release()
+	};
+}
+
+void ArrowReportExport::exportStream(ArrowArrayStream* out) const {
+	*out = ArrowArrayStream{
+		.get_schema = [](ArrowArrayStream* stream, ArrowSchema* schema) {
+			return streamCall(stream, [schema](StreamData& data) { data.source.exportSchema(schema); });
+		},
+		.get_next = [](ArrowArrayStream* stream, ArrowArray* array) {
+			return streamCall(stream, [array](StreamData& data) {
+				if (data.exported) {
+					// a released array marks the end of the stream
+					array->release = nullptr;
+					return;
+				}
+				data.source.exportArray(array);
+				data.exported = true;
+			});
+		},
+		.get_last_error = [](ArrowArrayStream* stream) -> const char* {
+			const auto* data = static_cast<const StreamData*>(stream->private_data);
+			return data->lastError.empty() ? nullptr : data->lastError.c_str();
+		},
+		.release = [](ArrowArrayStream* stream) {
+			delete static_cast<StreamData*>(stream->private_data);
+			stream->release = nullptr;
+		},
+		.private_data = new StreamData{ *this, false, {} }
+	};
+}
@@ -0,0 +1,90 @@
+#pragma once
+// zero-copy export of the timeseries of a simulation through the Arrow C data interface
+
+#include <cstdint>
+#include <memory>
+
+#include "../Definitions.hpp"
+#include "../Simulation/TimestampIndex.hpp"
+
+// The structures of the Arrow C data interface (https://arrow.apache.org/docs/format/CDataInterface.html)
+// These are a stable ABI, which is meant to be copied rather than included from Arrow
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+struct ArrowSchema {
+	const char* format;
+	const char* name;
+	const char* metadata;
+	int64_t flags;
+	int64_t n_children;
+	struct ArrowSchema** children;
+	struct ArrowSchema* dictionary;
+	void (*release)(struct ArrowSchema*);
+	void* private_data;
+};
+
+struct ArrowArray {
+	int64_t length;
+	int64_t null_count;
+	int64_t offset;
+	int64_t n_buffers;
+	int64_t n_children;
+	const void** buffers;
+	struct ArrowArray** children;
+	struct ArrowArray* dictionary;
+	void (*release)(struct ArrowArray*);
+	void* private_data;
+};
+
+#endif // ARROW_C_DATA_INTERFACE
+
+#ifndef ARROW_C_STREAM_INTERFACE
+#define ARROW_C_STREAM_INTERFACE
+
+struct ArrowArrayStream {
+	int (*get_schema)(struct ArrowArrayStream*, struct ArrowSchema* out);
+	int (*get_next)(struct ArrowArrayStream*, struct ArrowArray* out);
+	const char* (*get_last_error)(struct ArrowArrayStream*);
+	void (*release)(struct ArrowArrayStream*);
+	void* private_data;
+};
+
+#endif // ARROW_C_STREAM_INTERFACE
+
+// the name of the timestamp column of an export with a TimestampIndex
+inline constexpr const char* ARROW_TIMESTAMP_COLUMN = "timestamp";
+
+/**
+* The columns of a ReportData as an Arrow record batch
+*
+* The batch has a (UTC, nanosecond) timestamp column if it has a TimestampIndex,
+* followed by a float32 column for each populated ReportColumn, named as in REPORT_COLUMN_NAMES
+* and in the order of populated().
+* None of the columns are copied: the exported arrays view the storage of the ReportData and the TimestampIndex,
+* which owner must keep alive (and unchanged) until the last of the exported arrays is released.
+* owner is released when that happens, which may be on any thread.
+*/
+class ArrowReportExport {
+public:
+	/**
+	* Raise an exception if timestamps does not have a time for every timestep of reportData
+	*/
+	ArrowReportExport(const ReportData& reportData, std::shared_ptr<const TimestampIndex> timestamps, std::shared_ptr<const void> owner);
+
+	// export the type of the batch (a struct of its columns) into an uninitialised ArrowSchema
+	void exportSchema(ArrowSchema* out) const;
+	// export the batch (a struct array of its columns) into an uninitialised ArrowArray
+	void exportArray(ArrowArray* out) const;
+	// export a stream of the one batch into an uninitialised ArrowArrayStream
+	void exportStream(ArrowArrayStream* out) const;
+
+private:
+	const ReportData& mReportData;
+	std::shared_ptr<const TimestampIndex> mTimestamps;
+	std::shared_ptr<const void> mOwner;
+};
@@ -0,0 +1,135 @@
+#include "BaselineCache.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+
+#include "BinaryArchive.hpp"
+#include "SimulatorSnapshot.hpp"
+#include "SiteDataBinary.hpp"
+#include "../Definitions.hpp"
+
+namespace {
+	std::filesystem::path cachePath(const std::filesystem::path& directory, const ScenarioKey& key) {
+		return directory / (key.toHex() + ".baseline");
+	}
+
+	std::vector<std::byte> readFile(const std::filesystem::path& path) {
+		std::ifstream in(path, std::ios::binary);
+		if (!in.is_open()) {
+			return {};
+		}
+		in.seekg(0, std::ios::end);
+		std::vector<std::byte> bytes(static_cast<size_t>(std::max<std::streamoff>(in.tellg(), 0)));
+		in.seekg(0);
+		in.read(reinterpret_cast<char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+		if (!in) {
+			return {};
+		}
+		return bytes;
+	}
+
+	SimulatorBaseline decodeBaseline(std::span<const std::byte> bytes, const ScenarioKey& key, size_t timesteps) {
+		binary::Reader reader(bytes, "cached baseline", "baseline");
+
+		const std::span<const std::byte> magic = reader.readBytes(BASELINE_CACHE_MAGIC.size());
+		if (std::memcmp(magic.data(), BASELINE_CACHE_MAGIC.data(), magic.size()) != 0) {
+			throw std::runtime_error("This is not a cached baseline");
+		}
+		uint32_t version;
+		reader(version);
+		if (version != BASELINE_CACHE_VERSION) {
+			throw std::runtime_error(std::format(
+				"The cached baseline is version {} but only version {} is supported", version, BASELINE_CACHE_VERSION));
+		}
+		ScenarioKey fileKey;
+		reader(fileKey.low, fileKey.high);
+		if (fileKey != key) {
+			throw std::runtime_error(std::format("The cached baseline holds the baseline of {}", fileKey.toHex()));
+		}
+
+		SimulatorBaseline baseline{};
+		reader(baseline.usage, baseline.metrics);
+		baseline.reportData = readReportData(reader);
+		reader.requireFinished();
+
+		if (baseline.reportData->timesteps() != static_cast<Eigen::Index>(timesteps)) {
+			throw std::runtime_error("The cached baseline does not match the timesteps of the SiteData");
+		}
+		return baseline;
+	}
+}
+
+
+ScenarioKey baselineCacheKey(const SiteData& siteData, const TaskConfig& config) {
+	if constexpr (std::endian::native != std::endian::little) {
+		throw std::runtime_error("Cached baselines are only supported on little-endian platforms");
+	}
+
+	std::ostringstream bytes;
+	writeSiteDataBinary(siteData, bytes);
+	binary::Writer writer(bytes);
+	writer(config, EPOCH_VERSION, BASELINE_CACHE_VERSION);
+
+	const std::string encoded = std::move(bytes).str();
+	return murmurHash128(encoded.data(), encoded.size());
+}
+
+std::optional<SimulatorBaseline> loadCachedBaseline(const std::filesystem::path& directory, const ScenarioKey& key,
+	size_t timesteps) {
+	const std::filesystem::path path = cachePath(directory, key);
+	const std::vector<std::byte> bytes = readFile(path);
+	if (bytes.empty()) {
+		return std::nullopt;
+	}
+
+	try {
+		return decodeBaseline(bytes, key, timesteps);
+	}
+	catch (const std::exception& e) {
+		spdlog::warn("Ignoring the cached baseline {}: {}", path.string(), e.what());
+		return std::nullopt;
+	}
+}
+
+void storeCachedBaseline(const std::filesystem::path& directory, const ScenarioKey& key, const SimulatorBaseline& baseline) {
+	const std::filesystem::path path = cachePath(directory, key);
+	// unique to this thread, so that processes and threads caching the same baseline don't write over each other's files
+	std::filesystem::path temporary = path;
+	temporary += std::format(".{}.tmp", std::hash<std::thread::id>{}(std::this_thread::get_id()));
+
+	try {
+		std::filesystem::create_directories(directory);
+		{
+			std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+			if (!out.is_open()) {
+				throw std::runtime_error("it could not be opened for writing");
+			}
+			binary::Writer writer(out);
+			writer.writeBytes(std::as_bytes(std::span(BASELINE_CACHE_MAGIC)));
+			writer(BASELINE_CACHE_VERSION, key.low, key.high, baseline.usage, baseline.metrics);
+			writeReportData(writer, *baseline.reportData);
+			out.flush();
+			if (!out.good()) {
+				throw std::runtime_error("it could not be written");
+			}
+		}
+		std::filesystem::rename(temporary, path);
+	}
+	catch (const std::exception& e) {
+		spdlog::warn("Could not cache the baseline to {}: {}", path.string(), e.what());
+		std::error_code ignored;
+		std::filesystem::remove(temporary, ignored);
+	}
+}
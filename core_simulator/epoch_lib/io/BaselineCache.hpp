@@ -0,0 +1,46 @@
+/*
+logic for caching the baselines of Simulators on disk, so that a site is only simulated once across processes and runs
+*/
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+
+#include "../Simulation/ScenarioKey.hpp"
+#include "../Simulation/Simulate.hpp"
+
+/**
+* A cached baseline is a file named <key>.baseline, where the key is that of its SiteData and TaskConfig (see baselineCacheKey).
+* All values are little-endian. The file consists of:
+* - the BASELINE_CACHE_MAGIC and BASELINE_CACHE_VERSION
+* - the key, which must match the file's name
+* - the baseline UsageData and SimulationMetrics, field by field
+* - the columns of the baseline ReportData (see writeReportData)
+*/
+inline constexpr std::array<char, 8> BASELINE_CACHE_MAGIC = { 'E', 'P', 'O', 'C', 'H', 'B', 'L', '\0' };
+inline constexpr uint32_t BASELINE_CACHE_VERSION = 1;
+
+/**
+* The key of the baseline of a SiteData and TaskConfig
+*
+* This is the 128-bit hash of the binary SiteData, the TaskConfig and the EPOCH_VERSION,
+* so a change to any timeseries, to the config or to the simulator gives a different key.
+*/
+ScenarioKey baselineCacheKey(const SiteData& siteData, const TaskConfig& config);
+
+/**
+* Read the baseline cached under key in directory, if there is one
+* A cached file that is corrupt, of another version or of another length of timeseries is ignored (with a warning),
+* so that the baseline is simulated again and the file replaced
+*/
+std::optional<SimulatorBaseline> loadCachedBaseline(const std::filesystem::path& directory, const ScenarioKey& key,
+	size_t timesteps);
+
+/**
+* Write a baseline to directory under key, replacing any already cached under it
+* The file is written beside its final name and then renamed into place, so a concurrent reader never sees part of one.
+* A failure is logged rather than thrown, as the cache is only an optimisation.
+*/
+void storeCachedBaseline(const std::filesystem::path& directory, const ScenarioKey& key, const SimulatorBaseline& baseline);
@@ -0,0 +1,275 @@
+/*
+the field-by-field binary archive shared by the Simulator snapshot and the binary SimulationResult
+*/
+#pragma once
+
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <optional>
+#include <ostream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "../Definitions.hpp"
+#include "../Simulation/Costs/CostData.hpp"
+#include "../Simulation/Costs/Usage.hpp"
+#include "../Simulation/TaskConfig.hpp"
+
+namespace binary {
+	template <typename S, typename T>
+	concept FieldsOf = std::same_as<std::remove_const_t<S>, T>;
+
+	// The fields of each struct, in the order they are stored
+	// These are shared by the writer (with const structs) and the reader.
+	// Every field must be visited, so a new field must be added here
+	// (and the version of each format that stores the struct incremented: SIMULATOR_SNAPSHOT_VERSION and RESULT_BINARY_VERSION)
+
+	template <typename Archive, FieldsOf<Segment> S>
+	void visitFields(Archive& ar, S& segment) {
+		ar(segment.upper, segment.rate);
+	}
+
+	template <typename Archive, FieldsOf<PiecewiseCostModel> S>
+	void visitFields(Archive& ar, S& model) {
+		ar(model.fixed_cost, model.segments, model.final_rate);
+	}
+
+	template <typename Archive, FieldsOf<EVChargerCosts> S>
+	void visitFields(Archive& ar, S& ev) {
+		ar(ev.small_cost, ev.fast_cost, ev.rapid_cost, ev.ultra_cost,
+			ev.small_install, ev.fast_install, ev.rapid_install, ev.ultra_install);
+	}
+
+	template <typename Archive, FieldsOf<CapexModel> S>
+	void visitFields(Archive& ar, S& model) {
+		ar(model.dhw_prices, model.ev_prices,
+			model.gas_heater_prices, model.grid_prices, model.heatpump_prices,
+			model.ess_pcs_prices, model.ess_enclosure_prices, model.ess_enclosure_disposal_prices,
+			model.pv_panel_prices, model.pv_roof_prices, model.pv_ground_prices, model.pv_BoP_prices);
+	}
+
+	template <typename Archive, FieldsOf<OpexModel> S>
+	void visitFields(Archive& ar, S& model) {
+		ar(model.ess_pcs_prices, model.ess_enclosure_prices, model.gas_heater_prices, model.heatpump_prices, model.pv_prices);
+	}
+
+	template <typename Archive, FieldsOf<TaskConfig> S>
+	void visitFields(Archive& ar, S& config) {
+		ar(config.use_boiler_upgrade_scheme, config.general_grant_funding,
+			config.npv_time_horizon, config.npv_discount_factor,
+			config.capex_model, config.opex_model);
+	}
+
+	template <typename Archive, FieldsOf<FabricCostBreakdown> S>
+	void visitFields(Archive& ar, S& breakdown) {
+		ar(breakdown.name, breakdown.area, breakdown.cost);
+	}
+
+	template <typename Archive, FieldsOf<CapexBreakdown> S>
+	void visitFields(Archive& ar, S& capex) {
+		ar(capex.building_fabric_capex, capex.fabric_cost_breakdown,
+			capex.dhw_capex,
+			capex.ev_charger_cost, capex.ev_charger_install,
+			capex.gas_heater_capex,
+			capex.grid_capex,
+			capex.heatpump_capex,
+			capex.ess_pcs_capex, capex.ess_enclosure_capex, capex.ess_enclosure_disposal,
+			capex.pv_panel_capex, capex.pv_roof_capex, capex.pv_ground_capex, capex.pv_BoP_capex,
+			capex.boiler_upgrade_scheme_funding, capex.general_grant_funding,
+			capex.total_capex);
+	}
+
+	template <typename Archive, FieldsOf<OpexBreakdown> S>
+	void visitFields(Archive& ar, S& opex) {
+		ar(opex.ess_pcs_opex, opex.ess_enclosure_opex, opex.gas_heater_opex, opex.heatpump_opex, opex.pv_opex);
+	}
+
+	template <typename Archive, FieldsOf<UsageData> S>
+	void visitFields(Archive& ar, S& usage) {
+		ar(usage.elec_cost, usage.elec_kg_CO2e, usage.export_revenue, usage.export_kg_CO2e,
+			usage.fuel_cost, usage.fuel_kg_CO2e,
+			usage.low_priority_kg_CO2e_avoided,
+			usage.carbon_scope_1_kg_CO2e, usage.carbon_scope_2_kg_CO2e,
+			usage.electric_vehicle_revenue, usage.high_priority_revenue, usage.low_priority_revenue,
+			usage.total_meter_cost, usage.total_operating_cost,
+			usage.capex_breakdown, usage.opex_breakdown);
+	}
+
+	template <typename Archive, FieldsOf<SimulationMetrics> S>
+	void visitFields(Archive& ar, S& metrics) {
+		ar(metrics.total_gas_used, metrics.total_electricity_imported, metrics.total_electricity_generated,
+			metrics.total_electricity_exported, metrics.total_electricity_curtailed, metrics.total_electricity_used,
+			metrics.total_heat_load, metrics.total_dhw_load, metrics.total_ch_load,
+			metrics.total_electrical_shortfall, metrics.total_heat_shortfall, metrics.total_ch_shortfall,
+			metrics.total_dhw_shortfall, metrics.peak_hload_shortfall,
+			metrics.total_capex, metrics.total_gas_import_cost, metrics.total_electricity_import_cost,
+			metrics.total_electricity_export_gain,
+			metrics.total_meter_cost, metrics.total_operating_cost, metrics.total_annualised_cost,
+			metrics.total_net_present_value,
+			metrics.total_scope_1_emissions, metrics.total_scope_2_emissions, metrics.total_combined_carbon_emissions,
+			metrics.environmental_impact_score, metrics.environmental_impact_grade);
+	}
+
+	template <typename Archive, FieldsOf<ScenarioComparison> S>
+	void visitFields(Archive& ar, S& comparison) {
+		ar(comparison.meter_balance, comparison.operating_balance, comparison.cost_balance, comparison.npv_balance,
+			comparison.payback_horizon_years, comparison.return_on_investment,
+			comparison.carbon_balance_scope_1, comparison.carbon_balance_scope_2, comparison.combined_carbon_balance,
+			comparison.carbon_cost);
+	}
+
+	template <typename Archive, FieldsOf<PhaseTimings> S>
+	void visitFields(Archive& ar, S& timings) {
+		ar(timings.validation,
+			timings.hotel, timings.pv, timings.ev, timings.hot_water_cylinder, timings.instant_water_heater,
+			timings.heat_pump, timings.data_centre, timings.ess,
+			timings.balancing_loop,
+			timings.gas_ch, timings.post_balancing, timings.totals,
+			timings.usage, timings.metrics, timings.npv, timings.comparison, timings.capex);
+	}
+
+	/**
+	* Writes each value in turn: numbers as their raw bytes and structs as each of their fields
+	* Strings, optionals and vectors are preceded by their length (or whether they hold a value)
+	*/
+	class Writer {
+	public:
+		explicit Writer(std::ostream& out) : mOut(out) {}
+
+		template <typename... Ts>
+		void operator()(const Ts&... values) {
+			(write(values), ...);
+		}
+
+		void writeFloats(const float* data, size_t count) {
+			mOut.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(count * sizeof(float)));
+		}
+
+		void writeBytes(std::span<const std::byte> bytes) {
+			mOut.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+		}
+
+	private:
+		template <typename T> requires std::is_arithmetic_v<T> || std::is_enum_v<T>
+		void write(const T& value) {
+			mOut.write(reinterpret_cast<const char*>(&value), sizeof(T));
+		}
+
+		void write(const std::string& value) {
+			write(static_cast<uint64_t>(value.size()));
+			mOut.write(value.data(), static_cast<std::streamsize>(value.size()));
+		}
+
+		template <typename T>
+		void write(const std::optional<T>& value) {
+			write(value.has_value());
+			if (value) {
+				write(value.value());
+			}
+		}
+
+		template <typename T>
+		void write(const std::vector<T>& values) {
+			write(static_cast<uint64_t>(values.size()));
+			for (const auto& value : values) {
+				write(value);
+			}
+		}
+
+		template <typename T> requires std::is_class_v<T>
+		void write(const T& value) {
+			visitFields(*this, value);
+		}
+
+		std::ostream& mOut;
+	};
+
+	/**
+	* Reads the values written by a Writer, raising an exception if the section is too short
+	* container names what is being read (such as "Simulator snapshot") for the error messages
+	*/
+	class Reader {
+	public:
+		Reader(std::span<const std::byte> bytes, const char* container, const char* section) :
+			mBytes(bytes), mContainer(container), mSection(section) {}
+
+		template <typename... Ts>
+		void operator()(Ts&... values) {
+			(read(values), ...);
+		}
+
+		void readFloats(float* data, size_t count) {
+			std::memcpy(data, take(count * sizeof(float)), count * sizeof(float));
+		}
+
+		// a view of the next count bytes, which remains valid as long as the bytes being read
+		std::span<const std::byte> readBytes(size_t count) {
+			return { take(count), count };
+		}
+
+		// every section must be read exactly, so any trailing bytes mean the snapshot is corrupt
+		void requireFinished() const {
+			if (mPosition != mBytes.size()) {
+				throw std::runtime_error(std::format("The {} section of the {} is corrupt", mSection, mContainer));
+			}
+		}
+
+	private:
+		const std::byte* take(size_t count) {
+			if (count > mBytes.size() - mPosition) {
+				throw std::runtime_error(std::format("The {} section of the {} is truncated", mSection, mContainer));
+			}
+			const std::byte* start = mBytes.data() + mPosition;
+			mPosition += count;
+			return start;
+		}
+
+		template <typename T> requires std::is_arithmetic_v<T> || std::is_enum_v<T>
+		void read(T& value) {
+			std::memcpy(&value, take(sizeof(T)), sizeof(T));
+		}
+
+		void read(std::string& value) {
+			uint64_t size;
+			read(size);
+			const char* start = reinterpret_cast<const char*>(take(size));
+			value.assign(start, start + size);
+		}
+
+		template <typename T>
+		void read(std::optional<T>& value) {
+			bool hasValue;
+			read(hasValue);
+			value.reset();
+			if (hasValue) {
+				read(value.emplace());
+			}
+		}
+
+		template <typename T>
+		void read(std::vector<T>& values) {
+			uint64_t size;
+			read(size);
+			values.clear();
+			for (uint64_t i = 0; i < size; i++) {
+				read(values.emplace_back());
+			}
+		}
+
+		template <typename T> requires std::is_class_v<T>
+		void read(T& value) {
+			visitFields(*this, value);
+		}
+
+		std::span<const std::byte> mBytes;
+		size_t mPosition = 0;
+		const char* mContainer;
+		const char* mSection;
+	};
+}
@@ -0,0 +1,94 @@
+// logic for serializing and deserializing the checkpoints of a ChunkedSimulator to nlohmann json
+
+#include "CheckpointJson.hpp"
+
+namespace {
+	std::optional<float> optionalFloat(const json& j, const char* key) {
+		if (j.contains(key) && !j.at(key).is_null()) {
+			return j.at(key).get<float>();
+		}
+		return std::nullopt;
+	}
+
+	json valueOrNull(const std::optional<float>& value) {
+		return value.has_value() ? json(value.value()) : json(nullptr);
+	}
+}
+
+// CarriedState
+void from_json(const json& j, CarriedState& carried) {
+	carried.ess_charge = optionalFloat(j, "ess_charge");
+	carried.cylinder_energy = optionalFloat(j, "cylinder_energy");
+}
+
+void to_json(json& j, const CarriedState& carried) {
+	j = json{
+		{"ess_charge", valueOrNull(carried.ess_charge)},
+		{"cylinder_energy", valueOrNull(carried.cylinder_energy)}
+	};
+}
+
+// SimulationTotals
+void from_json(const json& j, SimulationTotals& totals) {
+	j.at("gas_import_h").get_to(totals.gas_import_h);
+
+	j.at("grid_import_e").get_to(totals.grid_import_e);
+	j.at("grid_import_cost").get_to(totals.grid_import_cost);
+	j.at("grid_import_co2_g").get_to(totals.grid_import_co2_g);
+	j.at("grid_export_e").get_to(totals.grid_export_e);
+	j.at("grid_export_revenue").get_to(totals.grid_export_revenue);
+	j.at("grid_export_co2_g").get_to(totals.grid_export_co2_g);
+
+	j.at("pv_generation_e").get_to(totals.pv_generation_e);
+
+	j.at("import_shortfall_e").get_to(totals.import_shortfall_e);
+	j.at("curtailed_export_e").get_to(totals.curtailed_export_e);
+	j.at("heat_shortfall_h").get_to(totals.heat_shortfall_h);
+	j.at("ch_shortfall_h").get_to(totals.ch_shortfall_h);
+	j.at("dhw_shortfall_h").get_to(totals.dhw_shortfall_h);
+
+	j.at("ch_demand_h").get_to(totals.ch_demand_h);
+	j.at("dhw_demand_h").get_to(totals.dhw_demand_h);
+
+	j.at("ev_load_e").get_to(totals.ev_load_e);
+	j.at("data_centre_load_e").get_to(totals.data_centre_load_e);
+	j.at("low_priority_load_e").get_to(totals.low_priority_load_e);
+}
+
+void to_json(json& j, const SimulationTotals& totals) {
+	j = json{
+		{"gas_import_h", totals.gas_import_h},
+		{"grid_import_e", totals.grid_import_e},
+		{"grid_import_cost", totals.grid_import_cost},
+		{"grid_import_co2_g", totals.grid_import_co2_g},
+		{"grid_export_e", totals.grid_export_e},
+		{"grid_export_revenue", totals.grid_export_revenue},
+		{"grid_export_co2_g", totals.grid_export_co2_g},
+		{"pv_generation_e", totals.pv_generation_e},
+		{"import_shortfall_e", totals.import_shortfall_e},
+		{"curtailed_export_e", totals.curtailed_export_e},
+		{"heat_shortfall_h", totals.heat_shortfall_h},
+		{"ch_shortfall_h", totals.ch_shortfall_h},
+		{"dhw_shortfall_h", totals.dhw_shortfall_h},
+		{"ch_demand_h", totals.ch_demand_h},
+		{"dhw_demand_h", totals.dhw_demand_h},
+		{"ev_load_e", totals.ev_load_e},
+		{"data_centre_load_e", totals.data_centre_load_e},
+		{"low_priority_load_e", totals.low_priority_load_e}
+	};
+}
+
+// SimulationCheckpoint
+void from_json(const json& j, SimulationCheckpoint& checkpoint) {
+	j.at("timesteps").get_to(checkpoint.timesteps);
+	j.at("carried").get_to(checkpoint.carried);
+	j.at("totals").get_to(checkpoint.totals);
+}
+
+void to_json(json& j, const SimulationCheckpoint& checkpoint) {
+	j = json{
+		{"timesteps", checkpoint.timesteps},
+		{"carried", checkpoint.carried},
+		{"totals", checkpoint.totals}
+	};
+}
@@ -0,0 +1,20 @@
+#pragma once
+// logic for serializing and deserializing the checkpoints of a ChunkedSimulator to nlohmann json
+
+#include <nlohmann/json.hpp>
+
+#include "../Definitions.hpp"
+#include "../Simulation/CarriedState.hpp"
+#include "../Simulation/ChunkedSimulator.hpp"
+
+using json = nlohmann::json;
+
+void from_json(const json& j, CarriedState& carried);
+void to_json(json& j, const CarriedState& carried);
+
+void from_json(const json& j, SimulationTotals& totals);
+void to_json(json& j, const SimulationTotals& totals);
+
+// every float is written with enough digits to be read back exactly, so a resumed run is the same as an uninterrupted one
+void from_json(const json& j, SimulationCheckpoint& checkpoint);
+void to_json(json& j, const SimulationCheckpoint& checkpoint);
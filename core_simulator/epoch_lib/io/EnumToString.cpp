@@ -19,6 +19,10 @@ std::string enumToString(const BatteryMode battery_mode) {
 		return "CONSUME";
 	case BatteryMode::CONSUME_PLUS:
 		return "CONSUME_PLUS";
+	case BatteryMode::PRICE_LOOKAHEAD:
+		return "PRICE_LOOKAHEAD";
+	case BatteryMode::CARBON_LOOKAHEAD:
+		return "CARBON_LOOKAHEAD";
 	default:
 		throw std::invalid_argument("Invalid Battery Mode");
 	}
@@ -57,3 +61,21 @@ std::string enumToString(const RatingGrade grade)
 
 	}
 }
+
+std::string enumToString(const Objective objective)
+{
+	switch (objective) {
+	case Objective::CAPEX:
+		return "capex";
+	case Objective::AnnualisedCost:
+		return "annualised_cost";
+	case Objective::PaybackHorizon:
+		return "payback_horizon";
+	case Objective::CostBalance:
+		return "cost_balance";
+	case Objective::CarbonBalance:
+		return "carbon_balance";
+	default:
+		throw std::invalid_argument("Invalid Objective");
+	}
+}
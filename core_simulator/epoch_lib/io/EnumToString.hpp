@@ -10,3 +10,4 @@ std::string enumToString(const HeatSource heat_source);
 std::string enumToString(const BatteryMode battery_mode);
 std::string enumToString(const GasType gas_type);
 std::string enumToString(const RatingGrade grade);
+std::string enumToString(const Objective objective);
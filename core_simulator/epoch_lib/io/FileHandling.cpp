@@ -16,8 +16,11 @@
 #include "../Definitions.hpp"
 #include "../Exceptions.hpp"
 #include "EnumToString.hpp"
+#include "OnDemandJson.hpp"
+#include "SiteDataBinary.hpp"
 #include "SiteDataJson.hpp"
 #include "TaskDataJson.hpp"
+#include "../Simulation/Trace.hpp"
 
 // Define macros to simplify creating the mapping for each struct member
 #define OUT_MEMBER_MAPPING_FLOAT(member) {#member, [](const OutputValues& s) -> float { return s.member; }, nullptr}
@@ -74,6 +77,10 @@ void writeResultsToCSV(std::filesystem::path filepath, const std::vector<Objecti
 }
 
 void appendResultToCSV(std::filesystem::path filepath, const ObjectiveResult& result) {
+	appendResultToCSV(filepath, std::span<const ObjectiveResult>(&result, 1));
+}
+
+void appendResultToCSV(std::filesystem::path filepath, std::span<const ObjectiveResult> results) {
 	// open the file in append mode
 	std::ofstream outFile(filepath, std::ios::app);
 
@@ -82,8 +89,10 @@ void appendResultToCSV(std::filesystem::path filepath, const ObjectiveResult& re
 		throw FileReadException(filepath.filename().string());
 	}
 
-	outFile << result.payback_horizon_years << "," << result.total_capex << "\n";
-
+	// the rows must match the header written by writeResultsToCSV
+	for (const auto& result : results) {
+		writeObjectiveResultRow(outFile, result);
+	}
 }
 
 void writeObjectiveResultHeader(std::ofstream& outFile) {
@@ -156,8 +165,8 @@ void writeObjectiveResultRow(std::ofstream& outFile, const ObjectiveResult& resu
 
 	if (taskData.building) {
 		outFile << taskData.building->scalar_heat_load << ",";
-		outFile << taskData.building->scalar_heat_load << ",";
-		outFile << taskData.building->scalar_heat_load << ",";
+		outFile << taskData.building->scalar_electrical_load << ",";
+		outFile << taskData.building->fabric_intervention_index << ",";
 	}
 	else {
 		outFile << ",,,";
@@ -208,7 +217,7 @@ void writeObjectiveResultRow(std::ofstream& outFile, const ObjectiveResult& resu
 		outFile << taskData.grid->tariff_index << ",";
 	}
 	else {
-		outFile << ",,,,,,";
+		outFile << ",,,,";
 	}
 
 	if (taskData.heat_pump) {
@@ -232,101 +241,13 @@ void writeObjectiveResultRow(std::ofstream& outFile, const ObjectiveResult& resu
 
 // Utility method for writing cells in a CSV
 // Return the string value if safe, otherwise the empty string
-std::string valueOrEmpty(const year_TS& vec, Eigen::Index i) {
+std::string valueOrEmpty(const year_TS_view& vec, Eigen::Index i) {
 	if (vec.size() > i) {
 		return std::to_string(vec[i]);
 	}
 	return "";
 }
 
-void writeTimeSeriesToCSV(std::filesystem::path filepath, const ReportData& reportData)
-{
-	std::ofstream outFile(filepath);
-
-	if (!outFile.is_open()) {
-		spdlog::error("Failed to open the output file!");
-		throw FileReadException(filepath.filename().string());
-	}
-
-	// Write the column headers
-	outFile << "Actual_import_shortfall" << ",";
-	outFile << "Actual_curtailed_export" << ",";
-	outFile << "Heat_shortfall" << ",";
-	outFile << "Heat_surplus" << ",";
-	outFile << "Hotel_load" << ",";
-	outFile << "Heatload" << ",";
-	outFile << "CH_demand" << ",";
-	outFile << "DHW_demand" << ",";
-	outFile << "PVdcGen" << ",";
-	outFile << "PVacGen" << ",";
-	outFile << "EV_targetload" << ",";
-	outFile << "EV_actualload" << ",";
-	outFile << "ESS_charge" << ",";
-	outFile << "ESS_discharge" << ",";
-	outFile << "ESS_resulting_SoC" << ",";
-	outFile << "ESS_AuxLoad" << ",";
-	outFile << "ESS_RTL" << ",";
-	outFile << "Data_centre_target_load" << ",";
-	outFile << "Data_centre_actual_load" << ",";
-	outFile << "Data_centre_target_heat" << ",";
-	outFile << "Data_centre_available_hot_heat" << ",";
-	outFile << "Grid_Import" << ",";
-	outFile << "Grid_Export" << ",";
-	outFile << "MOP_load" << ",";
-	outFile << "GasCH_load" << ",";
-	outFile << "DHW_load" << ",";
-	outFile << "DHW_charging" << ",";
-	outFile << "DHW_SoC" << ",";
-	outFile << "DHW_Standby_loss" << ",";
-	outFile << "DHW_ave_temperature" << ",";
-	outFile << "DHW_Shortfall";  // no trailing comma
-	outFile << "\n"; // newline
-
-	// Actual import shortfall is derived from TempSum so should always be present
-	Eigen::Index timesteps = reportData.Actual_import_shortfall.size();
-
-	// Write the values, handling empty vectors
-	for (Eigen::Index i = 0; i < timesteps; ++i) {
-		outFile << valueOrEmpty(reportData.Actual_import_shortfall, i) << ","
-			<< valueOrEmpty(reportData.Actual_curtailed_export, i) << ","
-			<< valueOrEmpty(reportData.Heat_shortfall, i) << ","
-			<< valueOrEmpty(reportData.Heat_surplus, i) << ","
-			<< valueOrEmpty(reportData.Hotel_load, i) << ","
-			<< valueOrEmpty(reportData.CH_demand, i) << ","
-			<< valueOrEmpty(reportData.DHW_demand, i) << ","
-			<< valueOrEmpty(reportData.Heatload, i) << ","
-			<< valueOrEmpty(reportData.PVdcGen, i) << ","
-			<< valueOrEmpty(reportData.PVacGen, i) << ","
-			<< valueOrEmpty(reportData.EV_targetload, i) << ","
-			<< valueOrEmpty(reportData.EV_actualload, i) << ","
-			<< valueOrEmpty(reportData.ESS_charge, i) << ","
-			<< valueOrEmpty(reportData.ESS_discharge, i) << ","
-			<< valueOrEmpty(reportData.ESS_resulting_SoC, i) << ","
-			<< valueOrEmpty(reportData.ESS_AuxLoad, i) << ","
-			<< valueOrEmpty(reportData.ESS_RTL, i) << ","
-			<< valueOrEmpty(reportData.Data_centre_target_load, i) << ","
-			<< valueOrEmpty(reportData.Data_centre_actual_load, i) << ","
-			<< valueOrEmpty(reportData.Data_centre_target_heat, i) << ","
-			<< valueOrEmpty(reportData.Data_centre_available_hot_heat, i) << ","
-			<< valueOrEmpty(reportData.Grid_Import, i) << ","
-			<< valueOrEmpty(reportData.Grid_Export, i) << ","
-			<< valueOrEmpty(reportData.MOP_load, i) << ","
-			<< valueOrEmpty(reportData.GasCH_load, i) << ","
-			<< valueOrEmpty(reportData.DHW_load, i) << ","
-			<< valueOrEmpty(reportData.DHW_charging, i) << ","
-			<< valueOrEmpty(reportData.DHW_SoC, i) << ","
-			<< valueOrEmpty(reportData.DHW_Standby_loss, i) << ","
-			<< valueOrEmpty(reportData.DHW_ave_temperature, i) << ","
-			<< valueOrEmpty(reportData.DHW_Shortfall, i) << ","
-			<< valueOrEmpty(reportData.ASHP_elec_load, i) << ","
-			<< valueOrEmpty(reportData.ASHP_DHW_output, i) << ","
-			<< valueOrEmpty(reportData.ASHP_CH_output, i) << ","
-			<< valueOrEmpty(reportData.ASHP_free_heat, i) << ","
-			<< valueOrEmpty(reportData.ASHP_used_hotroom_heat, i) << "\n";
-	}
-}
-
-
 // Custom function to convert a struct to a JSON object
 nlohmann::json outputToJson(const OutputValues& data) {
 
@@ -404,6 +325,20 @@ nlohmann::json readJsonFromFile(std::filesystem::path filepath)
 	}
 }
 
+/**
+* read the whole of a text file into a string
+*/
+static std::string readTextFromFile(const std::filesystem::path& filepath)
+{
+	std::ifstream f(filepath, std::ios::binary);
+	if (!f.is_open()) {
+		throw FileReadException(filepath.filename().string());
+	}
+	std::ostringstream contents;
+	contents << f.rdbuf();
+	return std::move(contents).str();
+}
+
 /**
 * read a SiteData.json file from the path specified within a FileConfig
 */
@@ -413,21 +348,24 @@ const SiteData readSiteData(const FileConfig& fileConfig) {
 }
 
 /**
-* read a SiteData.json file from a directly specified filepath
+* read a SiteData file from a directly specified filepath
+* this may be either json or the binary format (see SiteDataBinary.hpp)
 */
 const SiteData readSiteData(const std::filesystem::path& siteDataPath) {
-	auto j = readJsonFromFile(siteDataPath);
-	SiteData sd = j.get<SiteData>();
-	return sd;
+	TraceScope trace{ "readSiteData", "io" };
+	if (isSiteDataBinary(siteDataPath)) {
+		return readSiteDataBinary(siteDataPath);
+	}
+
+	return parseSiteDataJson(readTextFromFile(siteDataPath));
 }
 
 /**
 * read a TaskData.json file from a directly specified filepath
 */
 const TaskData readTaskData(const std::filesystem::path& taskDataPath) {
-	auto j = readJsonFromFile(taskDataPath);
-	TaskData td = j.get<TaskData>();
-	return td;
+	TraceScope trace{ "readTaskData", "io" };
+	return parseTaskDataJson(readTextFromFile(taskDataPath));
 }
 
 Eigen::VectorXf toEigen(const std::vector<float>& vec)
@@ -458,7 +396,7 @@ Eigen::MatrixXf toEigen(const std::vector<std::vector<float>>& mat) {
 	return eig;
 }
 
-std::vector<float> toStdVec(const Eigen::VectorXf& vec) {
+std::vector<float> toStdVec(year_TS_view vec) {
 	return std::vector<float>(vec.data(), vec.data() + vec.size());
 }
 
@@ -3,21 +3,24 @@
 #include "../Definitions.hpp"
 #include "FileConfig.hpp"
 #include "../Simulation/SiteData.hpp"
+#include "TimeSeriesWriter.hpp"
 
 #include <nlohmann/json.hpp>
 
 #include <filesystem>
+#include <span>
 #include <string>
 #include <vector>
 
 void writeResultsToCSV(std::filesystem::path filepath, const std::vector<ObjectiveResult>& results);
 void appendResultToCSV(std::filesystem::path filepath, const ObjectiveResult& result);
+// append several rows, opening the file only once
+void appendResultToCSV(std::filesystem::path filepath, std::span<const ObjectiveResult> results);
 
 void writeObjectiveResultHeader(std::ofstream& outFile);
 void writeObjectiveResultRow(std::ofstream& outFile, const ObjectiveResult& result);
 
-std::string valueOrEmpty(const year_TS& vec, Eigen::Index i);
-void writeTimeSeriesToCSV(std::filesystem::path filepath, const ReportData& reportData);
+std::string valueOrEmpty(const year_TS_view& vec, Eigen::Index i);
 
 nlohmann::json outputToJson(const OutputValues& data);
 nlohmann::json convert_to_ranges(nlohmann::json& j);
@@ -32,7 +35,7 @@ const TaskData readTaskData(const std::filesystem::path& taskDataPath);
 Eigen::VectorXf toEigen(const std::vector<float>& vec);
 Eigen::MatrixXf toEigen(const std::vector<std::vector<float>>& mat);
 
-std::vector<float> toStdVec(const Eigen::VectorXf& vec);
+std::vector<float> toStdVec(year_TS_view vec);
 std::vector<std::vector<float>> toStdVecOfVec(const Eigen::MatrixXf& mat);
 
 std::string toIso8601(const std::chrono::system_clock::time_point& tp);
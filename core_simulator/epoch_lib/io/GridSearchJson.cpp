@@ -0,0 +1,39 @@
+// logic for serializing the results of a GridSearch to nlohmann json
+
+#include "GridSearchJson.hpp"
+
+#include "EnumToString.hpp"
+#include "TaskDataJson.hpp"
+
+void to_json(json& j, const ObjectiveResult& result) {
+	j = json{
+		{"total_annualised_cost", result.total_annualised_cost},
+		{"total_capex", result.total_capex},
+		{"scenario_cost_balance", result.scenario_cost_balance},
+		{"payback_horizon_years", result.payback_horizon_years},
+		{"scenario_carbon_balance_scope_1", result.scenario_carbon_balance_scope_1},
+		{"scenario_carbon_balance_scope_2", result.scenario_carbon_balance_scope_2},
+		{"task_data", result.taskData}
+	};
+}
+
+void to_json(json& j, const GridSearchEntry& entry) {
+	j = entry.result;
+	j["scenario_index"] = entry.scenario_index;
+}
+
+void to_json(json& j, const GridSearchResult& result) {
+	json best = json::object();
+	for (size_t i = 0; i < result.best.size() && i < ALL_OBJECTIVES.size(); i++) {
+		best[enumToString(ALL_OBJECTIVES[i])] = result.best[i];
+	}
+
+	j = json{
+		{"num_scenarios", result.num_scenarios},
+		{"simulated", result.simulated},
+		{"pruned", result.pruned},
+		{"time_taken", result.time_taken},
+		{"best", best},
+		{"pareto", result.pareto}
+	};
+}
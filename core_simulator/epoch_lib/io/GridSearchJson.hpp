@@ -0,0 +1,14 @@
+#pragma once
+// logic for serializing the results of a GridSearch to nlohmann json
+
+#include <nlohmann/json.hpp>
+
+#include "../Definitions.hpp"
+#include "../Optimisation/GridSearch.hpp"
+
+using json = nlohmann::json;
+
+// as with the other results, there's no need to read these in again
+void to_json(json& j, const ObjectiveResult& result);
+void to_json(json& j, const GridSearchEntry& entry);
+void to_json(json& j, const GridSearchResult& result);
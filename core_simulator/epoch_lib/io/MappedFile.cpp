@@ -0,0 +1,84 @@
+#include "MappedFile.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "../Exceptions.hpp"
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::filesystem::path& filepath) {
+	HANDLE file = CreateFileW(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		throw FileReadException(filepath.filename().string());
+	}
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+		CloseHandle(file);
+		throw FileReadException(filepath.filename().string());
+	}
+
+	HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping == nullptr) {
+		CloseHandle(file);
+		throw FileReadException(filepath.filename().string());
+	}
+
+	void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (view == nullptr) {
+		CloseHandle(mapping);
+		CloseHandle(file);
+		throw FileReadException(filepath.filename().string());
+	}
+
+	mData = static_cast<const std::byte*>(view);
+	mSize = static_cast<size_t>(size.QuadPart);
+	mFileHandle = file;
+	mMappingHandle = mapping;
+}
+
+MappedFile::~MappedFile() {
+	UnmapViewOfFile(mData);
+	CloseHandle(mMappingHandle);
+	CloseHandle(mFileHandle);
+}
+
+#else
+
+MappedFile::MappedFile(const std::filesystem::path& filepath) {
+	int fd = ::open(filepath.c_str(), O_RDONLY);
+	if (fd < 0) {
+		throw FileReadException(filepath.filename().string());
+	}
+
+	struct stat st;
+	if (::fstat(fd, &st) != 0 || st.st_size == 0) {
+		::close(fd);
+		throw FileReadException(filepath.filename().string());
+	}
+
+	void* view = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+	// the mapping holds its own reference to the file
+	::close(fd);
+	if (view == MAP_FAILED) {
+		throw FileReadException(filepath.filename().string());
+	}
+
+	mData = static_cast<const std::byte*>(view);
+	mSize = static_cast<size_t>(st.st_size);
+}
+
+MappedFile::~MappedFile() {
+	::munmap(const_cast<std::byte*>(mData), mSize);
+}
+
+#endif
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+
+/**
+* A read-only memory mapping of an entire file
+*
+* The mapping is released when this is destroyed, so any views into data() must not outlive it
+*/
+class MappedFile {
+public:
+	explicit MappedFile(const std::filesystem::path& filepath);
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	const std::byte* data() const { return mData; }
+	size_t size() const { return mSize; }
+
+private:
+	const std::byte* mData = nullptr;
+	size_t mSize = 0;
+#ifdef _WIN32
+	void* mFileHandle = nullptr;
+	void* mMappingHandle = nullptr;
+#endif
+};
@@ -0,0 +1,707 @@
+#include "OnDemandJson.hpp"
+
+#include <charconv>
+#include <cstdint>
+#include <format>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+#include <Eigen/Core>
+#include <nlohmann/json.hpp>
+
+#include "FileHandling.hpp"
+#include "SiteDataJson.hpp"
+#include "TaskDataJson.hpp"
+
+namespace {
+
+	/**
+	* A forward-only cursor over json text
+	* Each value is read in place as it is reached, so no json document is built
+	*/
+	class JsonCursor {
+	public:
+		explicit JsonCursor(std::string_view text) : mText(text) {}
+
+		[[noreturn]] void fail(std::string_view what) const {
+			throw std::runtime_error(std::format("Invalid json at offset {}: {}", mPos, what));
+		}
+
+		// the next non-whitespace character, or '\0' at the end of the text
+		char peek() {
+			while (mPos < mText.size() && isWhitespace(mText[mPos])) {
+				mPos++;
+			}
+			return mPos < mText.size() ? mText[mPos] : '\0';
+		}
+
+		void expect(char c) {
+			if (peek() != c) {
+				fail(std::format("expected '{}'", c));
+			}
+			mPos++;
+		}
+
+		void finish() {
+			if (peek() != '\0') {
+				fail("unexpected characters after the json value");
+			}
+		}
+
+		// consume the next value if it is null
+		bool readNull() {
+			if (peek() != 'n') {
+				return false;
+			}
+			expectLiteral("null");
+			return true;
+		}
+
+		bool readBool() {
+			const char c = peek();
+			if (c == 't') {
+				expectLiteral("true");
+				return true;
+			}
+			if (c == 'f') {
+				expectLiteral("false");
+				return false;
+			}
+			fail("expected a boolean");
+		}
+
+		/**
+		* Read a string
+		* The result views the text, unless the string has escapes, in which case it is decoded into scratch
+		*/
+		std::string_view readString(std::string& scratch) {
+			expect('"');
+			const size_t start = mPos;
+			while (mPos < mText.size() && mText[mPos] != '"' && mText[mPos] != '\\') {
+				requirePrintable(mText[mPos]);
+				mPos++;
+			}
+			if (mPos == mText.size()) {
+				fail("unterminated string");
+			}
+			if (mText[mPos] == '"') {
+				return mText.substr(start, mPos++ - start);
+			}
+
+			scratch.assign(mText.substr(start, mPos - start));
+			while (mPos < mText.size()) {
+				const char c = mText[mPos++];
+				if (c == '"') {
+					return scratch;
+				}
+				if (c != '\\') {
+					requirePrintable(c);
+					scratch.push_back(c);
+					continue;
+				}
+				if (mPos == mText.size()) {
+					break;
+				}
+				switch (mText[mPos++]) {
+				case '"': scratch.push_back('"'); break;
+				case '\\': scratch.push_back('\\'); break;
+				case '/': scratch.push_back('/'); break;
+				case 'b': scratch.push_back('\b'); break;
+				case 'f': scratch.push_back('\f'); break;
+				case 'n': scratch.push_back('\n'); break;
+				case 'r': scratch.push_back('\r'); break;
+				case 't': scratch.push_back('\t'); break;
+				case 'u': appendCodepoint(scratch); break;
+				default: fail("invalid escape in string");
+				}
+			}
+			fail("unterminated string");
+		}
+
+		/**
+		* Read a number as T
+		* As with nlohmann, integers are read exactly and anything else is read as a double and then cast
+		*/
+		template <typename T>
+		T readNumber() {
+			// a number starts with a digit after any minus sign, so from_chars never reads an inf or nan (which aren't json)
+			const size_t digit = peek() == '-' ? mPos + 1 : mPos;
+			if (digit >= mText.size() || mText[digit] < '0' || mText[digit] > '9') {
+				fail("expected a number");
+			}
+			const char* first = mText.data() + mPos;
+			const char* last = mText.data() + mText.size();
+
+			if constexpr (std::is_integral_v<T>) {
+				int64_t integer = 0;
+				const auto [end, ec] = std::from_chars(first, last, integer);
+				if (ec == std::errc{} && (end == last || (*end != '.' && *end != 'e' && *end != 'E'))) {
+					mPos += static_cast<size_t>(end - first);
+					return static_cast<T>(integer);
+				}
+			}
+
+			double value = 0.0;
+			const auto [end, ec] = std::from_chars(first, last, value);
+			if (ec != std::errc{}) {
+				fail("expected a number");
+			}
+			mPos += static_cast<size_t>(end - first);
+			return static_cast<T>(value);
+		}
+
+		/**
+		* Read an array of numbers straight into a vector of the right length
+		*/
+		Eigen::VectorXf readFloatArray() {
+			expect('[');
+
+			// numbers can't contain commas, so the length is one more than the number of commas
+			size_t commas = 0;
+			bool empty = true;
+			size_t end = mPos;
+			for (; end < mText.size() && mText[end] != ']'; end++) {
+				const char c = mText[end];
+				if (c == ',') {
+					commas++;
+				}
+				else if (c == '[' || c == '{' || c == '"') {
+					fail("expected an array of numbers");
+				}
+				else if (!isWhitespace(c)) {
+					empty = false;
+				}
+			}
+			if (end == mText.size()) {
+				fail("unterminated array");
+			}
+
+			Eigen::VectorXf values(empty ? 0 : static_cast<Eigen::Index>(commas + 1));
+			for (Eigen::Index i = 0; i < values.size(); i++) {
+				if (i > 0) {
+					expect(',');
+				}
+				values[i] = readNumber<float>();
+			}
+			expect(']');
+			return values;
+		}
+
+		// call onMember(key) with the cursor at the value of each member of an object
+		template <typename F>
+		void readObject(F&& onMember) {
+			expect('{');
+			if (peek() == '}') {
+				mPos++;
+				return;
+			}
+			std::string scratch;
+			while (true) {
+				const std::string_view key = readString(scratch);
+				expect(':');
+				onMember(key);
+				if (peek() != ',') {
+					break;
+				}
+				mPos++;
+			}
+			expect('}');
+		}
+
+		// call onElement() with the cursor at each element of an array
+		template <typename F>
+		void readArray(F&& onElement) {
+			expect('[');
+			if (peek() == ']') {
+				mPos++;
+				return;
+			}
+			while (true) {
+				onElement();
+				if (peek() != ',') {
+					break;
+				}
+				mPos++;
+			}
+			expect(']');
+		}
+
+		void skipValue() {
+			const char c = peek();
+			if (c == '"') {
+				std::string scratch;
+				readString(scratch);
+			}
+			else if (c == '{') {
+				readObject([this](std::string_view) { skipValue(); });
+			}
+			else if (c == '[') {
+				readArray([this] { skipValue(); });
+			}
+			else if (c == 't' || c == 'f') {
+				readBool();
+			}
+			else if (!readNull()) {
+				readNumber<double>();
+			}
+		}
+
+	private:
+		static bool isWhitespace(char c) {
+			return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+		}
+
+		void requirePrintable(char c) const {
+			if (static_cast<unsigned char>(c) < 0x20) {
+				fail("control character in string");
+			}
+		}
+
+		void expectLiteral(std::string_view literal) {
+			if (mText.substr(mPos, literal.size()) != literal) {
+				fail(std::format("expected {}", literal));
+			}
+			mPos += literal.size();
+		}
+
+		uint32_t readHex4() {
+			if (mText.size() - mPos < 4) {
+				fail("truncated unicode escape");
+			}
+			uint32_t value = 0;
+			const char* first = mText.data() + mPos;
+			const auto [end, ec] = std::from_chars(first, first + 4, value, 16);
+			if (ec != std::errc{} || end != first + 4) {
+				fail("invalid unicode escape");
+			}
+			mPos += 4;
+			return value;
+		}
+
+		// decode the XXXX of a \uXXXX escape (and the low half of a surrogate pair) as UTF-8
+		void appendCodepoint(std::string& out) {
+			uint32_t codepoint = readHex4();
+			if (codepoint >= 0xD800 && codepoint <= 0xDBFF) {
+				if (mText.substr(mPos, 2) != "\\u") {
+					fail("unpaired surrogate in unicode escape");
+				}
+				mPos += 2;
+				const uint32_t low = readHex4();
+				if (low < 0xDC00 || low > 0xDFFF) {
+					fail("unpaired surrogate in unicode escape");
+				}
+				codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00);
+			}
+			else if (codepoint >= 0xDC00 && codepoint <= 0xDFFF) {
+				fail("unpaired surrogate in unicode escape");
+			}
+
+			if (codepoint < 0x80) {
+				out.push_back(static_cast<char>(codepoint));
+			}
+			else if (codepoint < 0x800) {
+				out.push_back(static_cast<char>(0xC0 | (codepoint >> 6)));
+				out.push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
+			}
+			else if (codepoint < 0x10000) {
+				out.push_back(static_cast<char>(0xE0 | (codepoint >> 12)));
+				out.push_back(static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F)));
+				out.push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
+			}
+			else {
+				out.push_back(static_cast<char>(0xF0 | (codepoint >> 18)));
+				out.push_back(static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F)));
+				out.push_back(static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F)));
+				out.push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
+			}
+		}
+
+		std::string_view mText;
+		size_t mPos = 0;
+	};
+
+
+	/*
+	* The members of each json object, as named in SiteDataJson.cpp and TaskDataJson.cpp
+	* visit(name, member, required) is called for each member
+	* Optional members that are absent keep their (value-initialised) defaults
+	*/
+
+	template <typename V> void visitMembers(FabricCostBreakdown& breakdown, V&& visit) {
+		visit("name", breakdown.name, true);
+		visit("area", breakdown.area, false);
+		visit("cost", breakdown.cost, true);
+	}
+
+	template <typename V> void visitMembers(FabricIntervention& intervention, V&& visit) {
+		visit("cost", intervention.cost, true);
+		visit("cost_breakdown", intervention.cost_breakdown, false);
+		// one of reduced_hload and hload_delta is required, which the SiteData checks
+		visit("reduced_hload", intervention.reduced_hload, false);
+		visit("peak_hload", intervention.peak_hload, false);
+		visit("hload_delta", intervention.hload_delta, false);
+	}
+
+	template <typename V> void visitMembers(FabricHeatDelta& delta, V&& visit) {
+		visit("scale", delta.scale, true);
+		visit("index", delta.index, false);
+		visit("value", delta.value, false);
+	}
+
+	template <typename V> void visitMembers(TariffBandHours& band, V&& visit) {
+		visit("hours", band.hours, true);
+		visit("price", band.price, true);
+	}
+
+	template <typename V> void visitMembers(TariffPatternHours& pattern, V&& visit) {
+		visit("period_hours", pattern.period_hours, false);
+		visit("bands", pattern.bands, true);
+	}
+
+	template <typename V> void visitMembers(Building& building, V&& visit) {
+		visit("scalar_heat_load", building.scalar_heat_load, true);
+		visit("scalar_electrical_load", building.scalar_electrical_load, true);
+		visit("fabric_intervention_index", building.fabric_intervention_index, true);
+		visit("incumbent", building.incumbent, true);
+		visit("age", building.age, true);
+		visit("lifetime", building.lifetime, true);
+		visit("floor_area", building.floor_area, false);
+	}
+
+	template <typename V> void visitMembers(DataCentreData& dc, V&& visit) {
+		visit("maximum_load", dc.maximum_load, true);
+		visit("hotroom_temp", dc.hotroom_temp, true);
+		visit("incumbent", dc.incumbent, true);
+		visit("age", dc.age, true);
+		visit("lifetime", dc.lifetime, true);
+	}
+
+	template <typename V> void visitMembers(DomesticHotWater& dhw, V&& visit) {
+		visit("cylinder_volume", dhw.cylinder_volume, true);
+		visit("incumbent", dhw.incumbent, true);
+		visit("age", dhw.age, true);
+		visit("lifetime", dhw.lifetime, true);
+	}
+
+	template <typename V> void visitMembers(ElectricVehicles& ev, V&& visit) {
+		visit("flexible_load_ratio", ev.flexible_load_ratio, true);
+		visit("small_chargers", ev.small_chargers, true);
+		visit("fast_chargers", ev.fast_chargers, true);
+		visit("rapid_chargers", ev.rapid_chargers, true);
+		visit("ultra_chargers", ev.ultra_chargers, true);
+		visit("scalar_electrical_load", ev.scalar_electrical_load, true);
+		visit("incumbent", ev.incumbent, true);
+		visit("age", ev.age, true);
+		visit("lifetime", ev.lifetime, true);
+	}
+
+	template <typename V> void visitMembers(EnergyStorageSystem& ess, V&& visit) {
+		visit("capacity", ess.capacity, true);
+		visit("charge_power", ess.charge_power, true);
+		visit("discharge_power", ess.discharge_power, true);
+		visit("battery_mode", ess.battery_mode, true);
+		visit("initial_charge", ess.initial_charge, true);
+		visit("incumbent", ess.incumbent, true);
+		visit("age", ess.age, true);
+		visit("lifetime", ess.lifetime, true);
+	}
+
+	template <typename V> void visitMembers(GasCHData& gas_heater, V&& visit) {
+		visit("maximum_output", gas_heater.maximum_output, true);
+		visit("boiler_efficiency", gas_heater.boiler_efficiency, true);
+		visit("gas_type", gas_heater.gas_type, true);
+		visit("fixed_gas_price", gas_heater.fixed_gas_price, true);
+		visit("incumbent", gas_heater.incumbent, true);
+		visit("age", gas_heater.age, true);
+		visit("lifetime", gas_heater.lifetime, true);
+	}
+
+	template <typename V> void visitMembers(GridData& grid, V&& visit) {
+		visit("grid_export", grid.grid_export, true);
+		visit("grid_import", grid.grid_import, true);
+		visit("import_headroom", grid.import_headroom, true);
+		visit("tariff_index", grid.tariff_index, true);
+		visit("export_tariff", grid.export_tariff, true);
+		visit("incumbent", grid.incumbent, true);
+		visit("age", grid.age, true);
+		visit("lifetime", grid.lifetime, true);
+	}
+
+	template <typename V> void visitMembers(HeatPumpData& hp, V&& visit) {
+		visit("heat_power", hp.heat_power, true);
+		visit("heat_source", hp.heat_source, true);
+		visit("send_temp", hp.send_temp, true);
+		visit("incumbent", hp.incumbent, true);
+		visit("age", hp.age, true);
+		visit("lifetime", hp.lifetime, true);
+	}
+
+	template <typename V> void visitMembers(MopData& mop, V&& visit) {
+		visit("maximum_load", mop.maximum_load, true);
+		visit("incumbent", mop.incumbent, true);
+		visit("age", mop.age, true);
+		visit("lifetime", mop.lifetime, true);
+	}
+
+	template <typename V> void visitMembers(SolarData& solar, V&& visit) {
+		visit("yield_scalar", solar.yield_scalar, true);
+		visit("yield_index", solar.yield_index, true);
+		visit("incumbent", solar.incumbent, true);
+		visit("age", solar.age, true);
+		visit("lifetime", solar.lifetime, true);
+	}
+
+	template <typename V> void visitMembers(TaskData& taskData, V&& visit) {
+		visit("building", taskData.building, false);
+		visit("data_centre", taskData.data_centre, false);
+		visit("domestic_hot_water", taskData.domestic_hot_water, false);
+		visit("electric_vehicles", taskData.electric_vehicles, false);
+		visit("energy_storage_system", taskData.energy_storage_system, false);
+		visit("gas_heater", taskData.gas_heater, false);
+		visit("grid", taskData.grid, false);
+		visit("heat_pump", taskData.heat_pump, false);
+		visit("mop", taskData.mop, false);
+		visit("solar_panels", taskData.solar_panels, false);
+	}
+
+	template <typename T>
+	concept JsonObject = requires(T& value) {
+		visitMembers(value, [](std::string_view, auto&, bool) {});
+	};
+
+
+	// the value readers are declared up front, as they call each other for nested values
+
+	void readValue(JsonCursor& in, bool& value);
+	void readValue(JsonCursor& in, std::string& value);
+	void readValue(JsonCursor& in, SiteSeries& value);
+	void readValue(JsonCursor& in, ImportTariffEntry& value);
+
+	template <typename T> requires std::is_arithmetic_v<T>
+	void readValue(JsonCursor& in, T& value);
+
+	template <typename T> requires std::is_enum_v<T>
+	void readValue(JsonCursor& in, T& value);
+
+	template <typename T>
+	void readValue(JsonCursor& in, std::optional<T>& value);
+
+	template <typename T>
+	void readValue(JsonCursor& in, std::vector<T>& values);
+
+	template <typename T, size_t N>
+	void readValue(JsonCursor& in, InlineVector<T, N>& values);
+
+	template <JsonObject T>
+	void readValue(JsonCursor& in, T& value);
+
+
+	void readValue(JsonCursor& in, bool& value) {
+		value = in.readBool();
+	}
+
+	void readValue(JsonCursor& in, std::string& value) {
+		std::string scratch;
+		value = in.readString(scratch);
+	}
+
+	void readValue(JsonCursor& in, SiteSeries& value) {
+		value = in.readFloatArray();
+	}
+
+	// an import tariff is either a timeseries or an object holding a pattern of bands
+	void readValue(JsonCursor& in, ImportTariffEntry& value) {
+		if (in.peek() == '{') {
+			readValue(in, value.emplace<TariffPatternHours>());
+		}
+		else {
+			readValue(in, value.emplace<SiteSeries>());
+		}
+	}
+
+	template <typename T> requires std::is_arithmetic_v<T>
+	void readValue(JsonCursor& in, T& value) {
+		value = in.readNumber<T>();
+	}
+
+	// enums are converted by their nlohmann serializers, so accept exactly the same names
+	template <typename T> requires std::is_enum_v<T>
+	void readValue(JsonCursor& in, T& value) {
+		std::string scratch;
+		from_json(nlohmann::json(std::string(in.readString(scratch))), value);
+	}
+
+	// null is read as an empty optional
+	template <typename T>
+	void readValue(JsonCursor& in, std::optional<T>& value) {
+		if (in.readNull()) {
+			value.reset();
+			return;
+		}
+		readValue(in, value.emplace());
+	}
+
+	// null is read as an empty array, matching TaskData's solar_panels and a fabric intervention's cost_breakdown
+	template <typename T>
+	void readValue(JsonCursor& in, std::vector<T>& values) {
+		values.clear();
+		if (in.readNull()) {
+			return;
+		}
+		in.readArray([&] { readValue(in, values.emplace_back()); });
+	}
+
+	template <typename T, size_t N>
+	void readValue(JsonCursor& in, InlineVector<T, N>& values) {
+		values.clear();
+		if (in.readNull()) {
+			return;
+		}
+		in.readArray([&] { readValue(in, values.emplace_back()); });
+	}
+
+	// read the members of an object in whatever order they appear, ignoring any unknown members
+	template <JsonObject T>
+	void readValue(JsonCursor& in, T& value) {
+		uint64_t seen = 0;
+		in.readObject([&](std::string_view key) {
+			bool matched = false;
+			size_t index = 0;
+			visitMembers(value, [&](std::string_view name, auto& member, bool) {
+				if (!matched && name == key) {
+					readValue(in, member);
+					seen |= uint64_t{ 1 } << index;
+					matched = true;
+				}
+				index++;
+			});
+			if (!matched) {
+				in.skipValue();
+			}
+		});
+
+		size_t index = 0;
+		visitMembers(value, [&](std::string_view name, auto&, bool required) {
+			if (required && !(seen & (uint64_t{ 1 } << index))) {
+				in.fail(std::format("missing member \"{}\"", name));
+			}
+			index++;
+		});
+	}
+
+	Eigen::MatrixXf readTable(JsonCursor& in) {
+		// the table is an array of rows
+		std::vector<Eigen::VectorXf> rows;
+		in.readArray([&] { rows.push_back(in.readFloatArray()); });
+		if (rows.empty()) {
+			return {};
+		}
+
+		Eigen::MatrixXf table(static_cast<Eigen::Index>(rows.size()), rows.front().size());
+		for (size_t i = 0; i < rows.size(); i++) {
+			if (rows[i].size() != table.cols()) {
+				in.fail("the rows of a table must all be the same length");
+			}
+			table.row(static_cast<Eigen::Index>(i)) = rows[i].transpose();
+		}
+		return table;
+	}
+
+	template <typename T>
+	T require(std::optional<T>& value, JsonCursor& in, std::string_view name) {
+		if (!value) {
+			in.fail(std::format("missing member \"{}\"", name));
+		}
+		return std::move(*value);
+	}
+}
+
+
+SiteData parseSiteDataOnDemand(std::string_view text) {
+	JsonCursor in(text);
+
+	std::optional<std::string> start_ts, end_ts;
+	std::optional<TaskData> baseline;
+	std::optional<SiteSeries> building_eload, building_hload, ev_eload, dhw_demand, air_temperature, grid_co2;
+	float peak_hload = 0.0f;
+	std::optional<std::vector<SiteSeries>> solar_yields;
+	std::optional<std::vector<ImportTariffEntry>> import_tariffs;
+	std::optional<std::vector<FabricIntervention>> fabric_interventions;
+	std::optional<Eigen::MatrixXf> ashp_input_table, ashp_output_table;
+
+	in.readObject([&](std::string_view key) {
+		if (key == "start_ts") { readValue(in, start_ts.emplace()); }
+		else if (key == "end_ts") { readValue(in, end_ts.emplace()); }
+		else if (key == "baseline") { readValue(in, baseline.emplace()); }
+		else if (key == "building_eload") { readValue(in, building_eload.emplace()); }
+		else if (key == "building_hload") { readValue(in, building_hload.emplace()); }
+		else if (key == "peak_hload") { readValue(in, peak_hload); }
+		else if (key == "ev_eload") { readValue(in, ev_eload.emplace()); }
+		else if (key == "dhw_demand") { readValue(in, dhw_demand.emplace()); }
+		else if (key == "air_temperature") { readValue(in, air_temperature.emplace()); }
+		else if (key == "grid_co2") { readValue(in, grid_co2.emplace()); }
+		else if (key == "solar_yields") { readValue(in, solar_yields.emplace()); }
+		else if (key == "import_tariffs") { readValue(in, import_tariffs.emplace()); }
+		else if (key == "fabric_interventions") { readValue(in, fabric_interventions.emplace()); }
+		else if (key == "ashp_input_table") { ashp_input_table = readTable(in); }
+		else if (key == "ashp_output_table") { ashp_output_table = readTable(in); }
+		else { in.skipValue(); }
+	});
+	in.finish();
+
+	SiteSeries eload = require(building_eload, in, "building_eload");
+	if (!ev_eload) {
+		ev_eload.emplace(Eigen::VectorXf::Zero(eload.size()));
+	}
+	const auto start = fromIso8601(require(start_ts, in, "start_ts"));
+	const auto end = fromIso8601(require(end_ts, in, "end_ts"));
+	std::vector<SiteSeries> tariffs = expandImportTariffs(require(import_tariffs, in, "import_tariffs"),
+		start, end, static_cast<size_t>(eload.size()));
+
+	return SiteData(
+		start,
+		end,
+		require(baseline, in, "baseline"),
+		std::move(eload),
+		require(building_hload, in, "building_hload"),
+		peak_hload,
+		std::move(*ev_eload),
+		require(dhw_demand, in, "dhw_demand"),
+		require(air_temperature, in, "air_temperature"),
+		require(grid_co2, in, "grid_co2"),
+		require(solar_yields, in, "solar_yields"),
+		std::move(tariffs),
+		require(fabric_interventions, in, "fabric_interventions"),
+		require(ashp_input_table, in, "ashp_input_table"),
+		require(ashp_output_table, in, "ashp_output_table")
+	);
+}
+
+TaskData parseTaskDataOnDemand(std::string_view text) {
+	JsonCursor in(text);
+	TaskData taskData{};
+	readValue(in, taskData);
+	in.finish();
+	return taskData;
+}
+
+SiteData parseSiteDataJson(std::string_view text) {
+#ifdef EPOCH_FAST_JSON
+	return parseSiteDataOnDemand(text);
+#else
+	return nlohmann::json::parse(text).get<SiteData>();
+#endif
+}
+
+TaskData parseTaskDataJson(std::string_view text) {
+#ifdef EPOCH_FAST_JSON
+	return parseTaskDataOnDemand(text);
+#else
+	return nlohmann::json::parse(text).get<TaskData>();
+#endif
+}
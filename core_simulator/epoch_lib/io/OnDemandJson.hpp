@@ -0,0 +1,36 @@
+/*
+logic for parsing SiteData and TaskData json on demand, without building a json document
+*/
+#pragma once
+
+#include <string_view>
+
+#include "../Simulation/SiteData.hpp"
+#include "../Simulation/TaskData.hpp"
+
+/**
+* Parse SiteData json in a single pass over the text
+*
+* Each number array is decoded straight into preallocated Eigen storage,
+* rather than into json nodes and then a std::vector<float>.
+* This accepts the same schema as the nlohmann serializer in SiteDataJson.hpp and gives the same values.
+*/
+SiteData parseSiteDataOnDemand(std::string_view text);
+
+/**
+* Parse TaskData json in a single pass over the text
+* This accepts the same schema as the nlohmann serializers in TaskDataJson.hpp and gives the same values.
+*/
+TaskData parseTaskDataOnDemand(std::string_view text);
+
+/**
+* Parse SiteData json with the parser selected at build time
+* This is the on-demand parser when EPOCH_FAST_JSON is set, and nlohmann otherwise
+*/
+SiteData parseSiteDataJson(std::string_view text);
+
+/**
+* Parse TaskData json with the parser selected at build time
+* This is the on-demand parser when EPOCH_FAST_JSON is set, and nlohmann otherwise
+*/
+TaskData parseTaskDataJson(std::string_view text);
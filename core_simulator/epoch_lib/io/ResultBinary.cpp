@@ -0,0 +1,357 @@
+#include "ResultBinary.hpp"
+
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include <Eigen/Core>
+
+#include "../Exceptions.hpp"
+#include "BinaryArchive.hpp"
+#include "MappedFile.hpp"
+
+namespace {
+	constexpr const char* CONTAINER = "binary SimulationResult";
+	constexpr uint32_t HAS_REPORT = 1;
+	constexpr uint32_t HAS_BASELINE = 2;
+
+	void requireLittleEndian() {
+		if constexpr (std::endian::native != std::endian::little) {
+			throw std::runtime_error("Binary SimulationResults are only supported on little-endian platforms");
+		}
+	}
+
+	[[noreturn]] void corrupt(const char* section) {
+		throw std::runtime_error(std::format("The {} section of the {} is corrupt", section, CONTAINER));
+	}
+
+	// IEEE half precision, rounding to the nearest (ties to even)
+	uint16_t floatToHalf(float value) {
+		const uint32_t bits = std::bit_cast<uint32_t>(value);
+		const uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000u);
+		uint32_t magnitude = bits & 0x7fffffffu;
+
+		if (magnitude >= 0x7f800000u) {
+			// infinity, or a NaN (which stays a quiet NaN)
+			return sign | 0x7c00u | (magnitude > 0x7f800000u ? 0x0200u : 0u);
+		}
+		if (magnitude >= 0x477ff000u) {
+			// at least 65520, which rounds past the largest half (65504)
+			return sign | 0x7c00u;
+		}
+		if (magnitude < 0x38800000u) {
+			// below the smallest normal half (2^-14), so a subnormal in units of 2^-24
+			const float scaled = std::bit_cast<float>(magnitude) * 16777216.0f;
+			return sign | static_cast<uint16_t>(std::nearbyint(scaled));
+		}
+		// rebias the exponent from 127 to 15, then round away the low 13 bits of the mantissa
+		magnitude -= 112u << 23;
+		magnitude += 0x0fffu + ((magnitude >> 13) & 1u);
+		return sign | static_cast<uint16_t>(magnitude >> 13);
+	}
+
+	float halfToFloat(uint16_t half) {
+		const uint32_t sign = static_cast<uint32_t>(half & 0x8000u) << 16;
+		const uint32_t exponent = (half >> 10) & 0x1fu;
+		const uint32_t mantissa = half & 0x03ffu;
+
+		if (exponent == 0) {
+			const float magnitude = std::ldexp(static_cast<float>(mantissa), -24);
+			return sign ? -magnitude : magnitude;
+		}
+		if (exponent == 0x1f) {
+			return std::bit_cast<float>(sign | 0x7f800000u | (mantissa << 13));
+		}
+		return std::bit_cast<float>(sign | ((exponent + 112u) << 23) | (mantissa << 13));
+	}
+
+	void appendVarint(std::string& out, uint32_t value) {
+		while (value >= 0x80u) {
+			out.push_back(static_cast<char>((value & 0x7fu) | 0x80u));
+			value >>= 7;
+		}
+		out.push_back(static_cast<char>(value));
+	}
+
+	uint32_t readVarint(std::span<const std::byte> bytes, size_t& position, const char* section) {
+		uint32_t value = 0;
+		for (int shift = 0; shift < 35; shift += 7) {
+			if (position >= bytes.size()) {
+				corrupt(section);
+			}
+			const uint32_t byte = std::to_integer<uint32_t>(bytes[position++]);
+			value |= (byte & 0x7fu) << shift;
+			if ((byte & 0x80u) == 0) {
+				return value;
+			}
+		}
+		corrupt(section);
+	}
+
+	// a zero token is followed by the length of a run of unchanged values; any other token is an XOR
+	std::string encodeDelta(std::span<const float> values) {
+		std::string out;
+		uint32_t previous = 0;
+		uint32_t run = 0;
+		for (float value : values) {
+			const uint32_t bits = std::bit_cast<uint32_t>(value);
+			const uint32_t delta = bits ^ previous;
+			previous = bits;
+			if (delta == 0) {
+				run++;
+				continue;
+			}
+			if (run > 0) {
+				appendVarint(out, 0);
+				appendVarint(out, run);
+				run = 0;
+			}
+			appendVarint(out, delta);
+		}
+		if (run > 0) {
+			appendVarint(out, 0);
+			appendVarint(out, run);
+		}
+		return out;
+	}
+
+	void decodeDelta(std::span<const std::byte> bytes, std::span<float> values, const char* section) {
+		size_t position = 0;
+		size_t t = 0;
+		uint32_t previous = 0;
+		while (t < values.size()) {
+			const uint32_t token = readVarint(bytes, position, section);
+			if (token == 0) {
+				const uint32_t run = readVarint(bytes, position, section);
+				if (run == 0 || run > values.size() - t) {
+					corrupt(section);
+				}
+				for (uint32_t i = 0; i < run; i++) {
+					values[t++] = std::bit_cast<float>(previous);
+				}
+			}
+			else {
+				previous ^= token;
+				values[t++] = std::bit_cast<float>(previous);
+			}
+		}
+		if (position != bytes.size()) {
+			corrupt(section);
+		}
+	}
+
+	std::string encodeColumn(std::span<const float> values, TimeseriesEncoding encoding) {
+		switch (encoding) {
+		case TimeseriesEncoding::Float32:
+			return std::string(reinterpret_cast<const char*>(values.data()), values.size_bytes());
+		case TimeseriesEncoding::Float16: {
+			std::string out(values.size() * sizeof(uint16_t), '\0');
+			for (size_t t = 0; t < values.size(); t++) {
+				const uint16_t half = floatToHalf(values[t]);
+				std::memcpy(out.data() + t * sizeof(uint16_t), &half, sizeof(uint16_t));
+			}
+			return out;
+		}
+		case TimeseriesEncoding::Delta:
+			return encodeDelta(values);
+		}
+		throw std::invalid_argument("Unknown TimeseriesEncoding");
+	}
+
+	void decodeColumn(std::span<const std::byte> bytes, std::span<float> values, TimeseriesEncoding encoding, const char* section) {
+		switch (encoding) {
+		case TimeseriesEncoding::Float32:
+			if (bytes.size() != values.size_bytes()) {
+				corrupt(section);
+			}
+			std::memcpy(values.data(), bytes.data(), bytes.size());
+			return;
+		case TimeseriesEncoding::Float16:
+			if (bytes.size() != values.size() * sizeof(uint16_t)) {
+				corrupt(section);
+			}
+			for (size_t t = 0; t < values.size(); t++) {
+				uint16_t half;
+				std::memcpy(&half, bytes.data() + t * sizeof(uint16_t), sizeof(uint16_t));
+				values[t] = halfToFloat(half);
+			}
+			return;
+		case TimeseriesEncoding::Delta:
+			decodeDelta(bytes, values, section);
+			return;
+		}
+		corrupt(section);
+	}
+
+	std::string encodeReportData(const ReportData& reportData, TimeseriesEncoding encoding) {
+		std::ostringstream out;
+		binary::Writer writer(out);
+		const std::vector<ReportColumn> columns = reportData.populatedColumns();
+		writer(static_cast<uint64_t>(reportData.timesteps()), static_cast<uint32_t>(columns.size()));
+		for (ReportColumn col : columns) {
+			const auto values = reportData.get(col);
+			const std::string encoded = encodeColumn(std::span<const float>(values.data(), static_cast<size_t>(values.size())), encoding);
+			writer(static_cast<uint32_t>(col), static_cast<uint64_t>(encoded.size()));
+			writer.writeBytes(std::as_bytes(std::span<const char>(encoded)));
+		}
+		return out.str();
+	}
+
+	ReportData decodeReportData(std::span<const std::byte> bytes, TimeseriesEncoding encoding, const char* section) {
+		binary::Reader reader(bytes, CONTAINER, section);
+		uint64_t timesteps;
+		uint32_t numColumns;
+		reader(timesteps, numColumns);
+		// every value takes at least one byte in any encoding, except a run of unchanged values
+		if (numColumns > NUM_REPORT_COLUMNS || (encoding != TimeseriesEncoding::Delta && timesteps > bytes.size())) {
+			corrupt(section);
+		}
+
+		ReportData reportData;
+		Eigen::VectorXf values(static_cast<Eigen::Index>(timesteps));
+		for (uint32_t i = 0; i < numColumns; i++) {
+			uint32_t col;
+			uint64_t size;
+			reader(col, size);
+			if (col >= NUM_REPORT_COLUMNS) {
+				throw std::runtime_error(std::format("The {} reports an unknown column {}", CONTAINER, col));
+			}
+			decodeColumn(reader.readBytes(static_cast<size_t>(size)),
+				std::span<float>(values.data(), static_cast<size_t>(values.size())), encoding, section);
+			reportData.set(static_cast<ReportColumn>(col), values);
+		}
+		reader.requireFinished();
+		reportData.shrinkToPopulated();
+		return reportData;
+	}
+
+	std::span<const std::byte> section(std::span<const std::byte> bytes, uint64_t offset, uint64_t size) {
+		if (offset > bytes.size() || size > bytes.size() - offset) {
+			throw std::runtime_error(std::format("The {} has a corrupt layout", CONTAINER));
+		}
+		return bytes.subspan(static_cast<size_t>(offset), static_cast<size_t>(size));
+	}
+}
+
+
+TimeseriesEncoding timeseriesEncodingFromString(std::string_view name) {
+	if (name == "float32") {
+		return TimeseriesEncoding::Float32;
+	}
+	if (name == "float16") {
+		return TimeseriesEncoding::Float16;
+	}
+	if (name == "delta") {
+		return TimeseriesEncoding::Delta;
+	}
+	throw std::runtime_error(std::format("Unknown timeseries encoding {} (expected float32, float16 or delta)", name));
+}
+
+std::vector<std::byte> encodeResult(const SimulationResult& result, TimeseriesEncoding encoding, bool includeBaseline) {
+	requireLittleEndian();
+
+	std::ostringstream resultOut;
+	binary::Writer resultWriter(resultOut);
+	resultWriter(result.runtime, result.timings, result.comparison, result.metrics, result.baseline_metrics,
+		result.scenario_capex_breakdown, result.violates_constraints, result.cancelled, result.terminated_early);
+
+	ResultBinaryHeader header{};
+	header.magic = RESULT_BINARY_MAGIC;
+	header.version = RESULT_BINARY_VERSION;
+	header.header_size = sizeof(ResultBinaryHeader);
+	header.encoding = static_cast<uint32_t>(encoding);
+
+	std::string sections[] = { resultOut.str(), std::string{}, std::string{} };
+	if (result.report_data) {
+		header.sections |= HAS_REPORT;
+		sections[1] = encodeReportData(*result.report_data, encoding);
+	}
+	if (includeBaseline && result.baseline_report_data) {
+		header.sections |= HAS_BASELINE;
+		sections[2] = encodeReportData(*result.baseline_report_data, encoding);
+	}
+
+	header.result_offset = sizeof(ResultBinaryHeader);
+	header.result_size = sections[0].size();
+	header.report_offset = header.result_offset + header.result_size;
+	header.report_size = sections[1].size();
+	header.baseline_offset = header.report_offset + header.report_size;
+	header.baseline_size = sections[2].size();
+	header.total_size = header.baseline_offset + header.baseline_size;
+
+	std::vector<std::byte> bytes(header.total_size);
+	std::memcpy(bytes.data(), &header, sizeof(header));
+	size_t offset = header.result_offset;
+	for (const std::string& section : sections) {
+		std::memcpy(bytes.data() + offset, section.data(), section.size());
+		offset += section.size();
+	}
+	return bytes;
+}
+
+SimulationResult decodeResult(std::span<const std::byte> bytes) {
+	requireLittleEndian();
+
+	if (bytes.size() < sizeof(ResultBinaryHeader)) {
+		throw std::runtime_error(std::format("The {} is too small to hold a header", CONTAINER));
+	}
+	ResultBinaryHeader header;
+	std::memcpy(&header, bytes.data(), sizeof(header));
+
+	if (header.magic != RESULT_BINARY_MAGIC) {
+		throw std::runtime_error("This is not a binary SimulationResult");
+	}
+	if (header.version != RESULT_BINARY_VERSION) {
+		throw std::runtime_error(std::format(
+			"The {} is version {} but only version {} is supported",
+			CONTAINER, header.version, RESULT_BINARY_VERSION
+		));
+	}
+	if (header.header_size != sizeof(ResultBinaryHeader) || header.total_size != bytes.size()) {
+		throw std::runtime_error(std::format("The {} is truncated or has a corrupt header", CONTAINER));
+	}
+	if (header.encoding > static_cast<uint32_t>(TimeseriesEncoding::Delta)) {
+		throw std::runtime_error(std::format("The {} has an unknown timeseries encoding {}", CONTAINER, header.encoding));
+	}
+	const auto encoding = static_cast<TimeseriesEncoding>(header.encoding);
+
+	SimulationResult result{};
+	binary::Reader resultReader(section(bytes, header.result_offset, header.result_size), CONTAINER, "result");
+	resultReader(result.runtime, result.timings, result.comparison, result.metrics, result.baseline_metrics,
+		result.scenario_capex_breakdown, result.violates_constraints, result.cancelled, result.terminated_early);
+	resultReader.requireFinished();
+
+	if (header.sections & HAS_REPORT) {
+		result.report_data = decodeReportData(section(bytes, header.report_offset, header.report_size), encoding, "report");
+	}
+	if (header.sections & HAS_BASELINE) {
+		result.baseline_report_data = std::make_shared<const ReportData>(
+			decodeReportData(section(bytes, header.baseline_offset, header.baseline_size), encoding, "baseline"));
+	}
+	return result;
+}
+
+void writeResultBinary(const std::filesystem::path& filepath, const SimulationResult& result,
+	TimeseriesEncoding encoding, bool includeBaseline) {
+	const std::vector<std::byte> bytes = encodeResult(result, encoding, includeBaseline);
+
+	std::ofstream out(filepath, std::ios::binary | std::ios::trunc);
+	if (!out.is_open()) {
+		throw FileWriteException(filepath.filename().string());
+	}
+	out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+	if (!out) {
+		throw FileWriteException(filepath.filename().string());
+	}
+}
+
+SimulationResult readResultBinary(const std::filesystem::path& filepath) {
+	const MappedFile file(filepath);
+	return decodeResult(std::span<const std::byte>(file.data(), file.size()));
+}
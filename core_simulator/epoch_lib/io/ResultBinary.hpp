@@ -0,0 +1,81 @@
+/*
+logic for encoding a SimulationResult (with its timeseries) in a compact binary format
+*/
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "../Definitions.hpp"
+
+/**
+* How the ReportData columns of a binary SimulationResult are stored
+*
+* - Float32 stores every value exactly
+* - Float16 stores each value as an IEEE half float, which is lossy (about 3 significant figures, up to 65504)
+* - Delta is lossless: each value's bits are XORed with the previous value's in the column,
+*   then runs of unchanged values are run-length encoded and the remaining XORs are stored as varints.
+*   Constant and empty columns shrink to a few bytes, and slowly varying ones to about three bytes per value.
+*/
+enum class TimeseriesEncoding : uint32_t { Float32, Float16, Delta };
+
+// parse "float32", "float16" or "delta"
+TimeseriesEncoding timeseriesEncodingFromString(std::string_view name);
+
+/**
+* The binary SimulationResult container
+*
+* All values are little-endian. A result consists of:
+* - a ResultBinaryHeader
+* - the result section: the runtime, timings, comparison, metrics, baseline metrics, capex breakdown and flags,
+*   stored field by field (so every float is restored exactly)
+* - the report section: the scenario's ReportData, if it has one
+* - the baseline section: the baseline's ReportData, if it was included
+*
+* Each ReportData section holds the number of timesteps and columns,
+* then each ReportColumn followed by the byte size of its values and the values in the header's TimeseriesEncoding.
+*/
+inline constexpr std::array<char, 8> RESULT_BINARY_MAGIC = { 'E', 'P', 'O', 'C', 'H', 'R', 'S', '\0' };
+inline constexpr uint32_t RESULT_BINARY_VERSION = 2;
+
+struct ResultBinaryHeader {
+	std::array<char, 8> magic;
+	uint32_t version;
+	uint32_t header_size;
+
+	uint32_t encoding;
+	// bit 0 is set if there is a report section, bit 1 if there is a baseline section
+	uint32_t sections;
+
+	uint64_t result_offset;
+	uint64_t result_size;
+	uint64_t report_offset;
+	uint64_t report_size;
+	uint64_t baseline_offset;
+	uint64_t baseline_size;
+	uint64_t total_size;
+};
+
+static_assert(sizeof(ResultBinaryHeader) == 80, "The ResultBinaryHeader layout must not change within a version");
+
+
+/**
+* Encode a SimulationResult, with its report_data in the given encoding
+* The baseline_report_data is the same for every result of a Simulator, so it is only included if requested
+*/
+std::vector<std::byte> encodeResult(const SimulationResult& result,
+	TimeseriesEncoding encoding = TimeseriesEncoding::Float32, bool includeBaseline = false);
+
+/**
+* Decode a SimulationResult written by encodeResult
+*/
+SimulationResult decodeResult(std::span<const std::byte> bytes);
+
+void writeResultBinary(const std::filesystem::path& filepath, const SimulationResult& result,
+	TimeseriesEncoding encoding = TimeseriesEncoding::Float32, bool includeBaseline = false);
+SimulationResult readResultBinary(const std::filesystem::path& filepath);
@@ -62,11 +62,40 @@ void to_json(json& j, const SimulationMetrics m) {
     };
 }
 
+void to_json(json& j, const PhaseTimings t) {
+    j = json{
+        {"validation", t.validation},
+
+        {"hotel", t.hotel},
+        {"pv", t.pv},
+        {"ev", t.ev},
+        {"hot_water_cylinder", t.hot_water_cylinder},
+        {"instant_water_heater", t.instant_water_heater},
+        {"heat_pump", t.heat_pump},
+        {"data_centre", t.data_centre},
+        {"ess", t.ess},
+
+        {"balancing_loop", t.balancing_loop},
+
+        {"gas_ch", t.gas_ch},
+        {"post_balancing", t.post_balancing},
+        {"totals", t.totals},
+
+        {"usage", t.usage},
+        {"metrics", t.metrics},
+        {"npv", t.npv},
+        {"comparison", t.comparison},
+        {"capex", t.capex},
+    };
+}
+
 void to_json(json& j, const SimulationResult result) {
     j = json{
         {"comparison", result.comparison},
         {"metrics", result.metrics},
-        {"baseline_metrics", result.baseline_metrics}
+        {"baseline_metrics", result.baseline_metrics},
+        {"runtime", result.runtime},
+        {"timings", result.timings ? json(*result.timings) : json(nullptr)}
     };
 }
 
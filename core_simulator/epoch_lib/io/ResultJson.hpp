@@ -13,5 +13,6 @@ using json = nlohmann::json;
 
 void to_json(json& j, const ScenarioComparison comparison);
 void to_json(json& j, const SimulationMetrics metrics);
+void to_json(json& j, const PhaseTimings timings);
 
 void to_json(json& j, const SimulationResult result);
@@ -0,0 +1,89 @@
+#include "ResultTable.hpp"
+
+#include <limits>
+
+namespace {
+	template <float ScenarioComparison::* member>
+	double comparison(const SimulationResult& result) {
+		return result.comparison.*member;
+	}
+
+	template <float SimulationMetrics::* member>
+	double metric(const SimulationResult& result) {
+		return result.metrics.*member;
+	}
+
+	double returnOnInvestment(const SimulationResult& result) {
+		return result.comparison.return_on_investment.value_or(result.comparison.operating_balance);
+	}
+
+	double environmentalImpactScore(const SimulationResult& result) {
+		const auto& score = result.metrics.environmental_impact_score;
+		return score ? static_cast<double>(*score) : std::numeric_limits<double>::quiet_NaN();
+	}
+}
+
+const std::vector<ResultColumn>& resultColumns() {
+	static const std::vector<ResultColumn> columns = {
+		{"meter_balance", -1, &comparison<&ScenarioComparison::meter_balance>},
+		{"operating_balance", -1, &comparison<&ScenarioComparison::operating_balance>},
+		{"cost_balance", -1, &comparison<&ScenarioComparison::cost_balance>},
+		{"npv_balance", -1, &comparison<&ScenarioComparison::npv_balance>},
+		{"payback_horizon", 1, &comparison<&ScenarioComparison::payback_horizon_years>},
+		{"return_on_investment", -1, &returnOnInvestment},
+		{"carbon_balance_scope_1", -1, &comparison<&ScenarioComparison::carbon_balance_scope_1>},
+		{"carbon_balance_scope_2", -1, &comparison<&ScenarioComparison::carbon_balance_scope_2>},
+		{"carbon_balance_total", -1, &comparison<&ScenarioComparison::combined_carbon_balance>},
+		{"carbon_cost", 1, &comparison<&ScenarioComparison::carbon_cost>},
+
+		{"total_gas_used", 1, &metric<&SimulationMetrics::total_gas_used>},
+		{"total_electricity_imported", 1, &metric<&SimulationMetrics::total_electricity_imported>},
+		{"total_electricity_generated", -1, &metric<&SimulationMetrics::total_electricity_generated>},
+		{"total_electricity_exported", -1, &metric<&SimulationMetrics::total_electricity_exported>},
+		{"total_electricity_curtailed", 1, &metric<&SimulationMetrics::total_electricity_curtailed>},
+		{"total_electricity_used", 1, &metric<&SimulationMetrics::total_electricity_used>},
+
+		{"total_heat_load", 0, &metric<&SimulationMetrics::total_heat_load>},
+		{"total_dhw_load", 0, &metric<&SimulationMetrics::total_dhw_load>},
+		{"total_ch_load", 0, &metric<&SimulationMetrics::total_ch_load>},
+
+		{"total_electrical_shortfall", 1, &metric<&SimulationMetrics::total_electrical_shortfall>},
+		{"total_heat_shortfall", 1, &metric<&SimulationMetrics::total_heat_shortfall>},
+		{"total_ch_shortfall", 1, &metric<&SimulationMetrics::total_ch_shortfall>},
+		{"total_dhw_shortfall", 1, &metric<&SimulationMetrics::total_dhw_shortfall>},
+		{"peak_hload_shortfall", 1, &metric<&SimulationMetrics::peak_hload_shortfall>},
+
+		{"capex", 1, &metric<&SimulationMetrics::total_capex>},
+		{"total_gas_import_cost", 1, &metric<&SimulationMetrics::total_gas_import_cost>},
+		{"total_electricity_import_cost", 1, &metric<&SimulationMetrics::total_electricity_import_cost>},
+		{"total_electricity_export_gain", -1, &metric<&SimulationMetrics::total_electricity_export_gain>},
+
+		{"total_meter_cost", 1, &metric<&SimulationMetrics::total_meter_cost>},
+		{"total_operating_cost", 1, &metric<&SimulationMetrics::total_operating_cost>},
+		{"annualised_cost", 1, &metric<&SimulationMetrics::total_annualised_cost>},
+		{"total_net_present_value", -1, &metric<&SimulationMetrics::total_net_present_value>},
+
+		{"total_scope_1_emissions", 1, &metric<&SimulationMetrics::total_scope_1_emissions>},
+		{"total_scope_2_emissions", 1, &metric<&SimulationMetrics::total_scope_2_emissions>},
+		{"total_combined_carbon_emissions", 1, &metric<&SimulationMetrics::total_combined_carbon_emissions>},
+
+		{"environmental_impact_score", 0, &environmentalImpactScore}
+	};
+	return columns;
+}
+
+void writeResultRow(const SimulationResult& result, double* row, bool applyDirections) {
+	const auto& columns = resultColumns();
+	for (size_t c = 0; c < columns.size(); c++) {
+		double value = columns[c].value(result);
+		row[c] = applyDirections ? value * columns[c].direction : value;
+	}
+}
+
+ResultTable resultsToTable(std::span<const SimulationResult> results, bool applyDirections) {
+	ResultTable table(static_cast<Eigen::Index>(results.size()), static_cast<Eigen::Index>(resultColumns().size()));
+	for (size_t i = 0; i < results.size(); i++) {
+		writeResultRow(results[i], table.row(static_cast<Eigen::Index>(i)).data(), applyDirections);
+	}
+	return table;
+}
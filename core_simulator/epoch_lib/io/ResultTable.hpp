@@ -0,0 +1,38 @@
+#pragma once
+// conversion of many results to a single table of metrics
+
+#include <Eigen/Core>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "../Definitions.hpp"
+
+// one row per scenario and one column per RESULT_COLUMNS entry
+using ResultTable = Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+
+struct ResultColumn {
+	// the name of the metric in the optimisation service
+	std::string_view name;
+	// 1 for metrics to minimise, -1 for metrics to maximise and 0 for metrics that aren't objectives
+	int direction;
+	double (*value)(const SimulationResult& result);
+};
+
+/**
+* Every SimulationMetrics and ScenarioComparison value of a result, in column order
+*
+* The values match the optimisation service's simulation_result_to_metric_dict;
+* in particular return_on_investment falls back to the operating_balance when it is undefined.
+* A missing environmental_impact_score is NaN.
+*/
+const std::vector<ResultColumn>& resultColumns();
+
+/**
+* Write the values of a result into one row of a table
+* If applyDirections is true, each value is multiplied by its column's direction
+* so that every objective is minimised
+*/
+void writeResultRow(const SimulationResult& result, double* row, bool applyDirections = false);
+
+ResultTable resultsToTable(std::span<const SimulationResult> results, bool applyDirections = false);
@@ -0,0 +1,341 @@
+#include "ScenarioCodec.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <format>
+#include <map>
+#include <set>
+#include <stdexcept>
+
+#include "TaskDataJson.hpp"
+
+namespace {
+	// these are always fixed, even when they are lists
+	const std::set<std::string> FIXED_PARAMETERS = { "incumbent", "age", "lifetime", "floor_area", "fixed_gas_price" };
+
+	// given a json value, make a function that assigns it (converted to the field's type) to a component
+	template <typename Component>
+	using FieldBinder = std::function<std::function<void(Component&)>(const json&)>;
+
+	template <typename Component>
+	using FieldTable = std::map<std::string, FieldBinder<Component>>;
+
+	template <typename Component, typename T>
+	FieldBinder<Component> field(T Component::* member) {
+		return [member](const json& value) {
+			T typed = value.get<T>();
+			return std::function<void(Component&)>([member, typed](Component& component) { component.*member = typed; });
+		};
+	}
+
+	// the fields that can be optimised for each component
+	template <typename Component>
+	const FieldTable<Component>& fieldsOf();
+
+	template <>
+	const FieldTable<Building>& fieldsOf() {
+		static const FieldTable<Building> fields = {
+			{"scalar_heat_load", field(&Building::scalar_heat_load)},
+			{"scalar_electrical_load", field(&Building::scalar_electrical_load)},
+			{"fabric_intervention_index", field(&Building::fabric_intervention_index)}
+		};
+		return fields;
+	}
+
+	template <>
+	const FieldTable<DataCentreData>& fieldsOf() {
+		static const FieldTable<DataCentreData> fields = {
+			{"maximum_load", field(&DataCentreData::maximum_load)},
+			{"hotroom_temp", field(&DataCentreData::hotroom_temp)}
+		};
+		return fields;
+	}
+
+	template <>
+	const FieldTable<DomesticHotWater>& fieldsOf() {
+		static const FieldTable<DomesticHotWater> fields = {
+			{"cylinder_volume", field(&DomesticHotWater::cylinder_volume)}
+		};
+		return fields;
+	}
+
+	template <>
+	const FieldTable<ElectricVehicles>& fieldsOf() {
+		static const FieldTable<ElectricVehicles> fields = {
+			{"flexible_load_ratio", field(&ElectricVehicles::flexible_load_ratio)},
+			{"small_chargers", field(&ElectricVehicles::small_chargers)},
+			{"fast_chargers", field(&ElectricVehicles::fast_chargers)},
+			{"rapid_chargers", field(&ElectricVehicles::rapid_chargers)},
+			{"ultra_chargers", field(&ElectricVehicles::ultra_chargers)},
+			{"scalar_electrical_load", field(&ElectricVehicles::scalar_electrical_load)}
+		};
+		return fields;
+	}
+
+	template <>
+	const FieldTable<EnergyStorageSystem>& fieldsOf() {
+		static const FieldTable<EnergyStorageSystem> fields = {
+			{"capacity", field(&EnergyStorageSystem::capacity)},
+			{"charge_power", field(&EnergyStorageSystem::charge_power)},
+			{"discharge_power", field(&EnergyStorageSystem::discharge_power)},
+			{"battery_mode", field(&EnergyStorageSystem::battery_mode)},
+			{"initial_charge", field(&EnergyStorageSystem::initial_charge)}
+		};
+		return fields;
+	}
+
+	template <>
+	const FieldTable<GasCHData>& fieldsOf() {
+		static const FieldTable<GasCHData> fields = {
+			{"maximum_output", field(&GasCHData::maximum_output)},
+			{"boiler_efficiency", field(&GasCHData::boiler_efficiency)},
+			{"gas_type", field(&GasCHData::gas_type)}
+		};
+		return fields;
+	}
+
+	template <>
+	const FieldTable<GridData>& fieldsOf() {
+		static const FieldTable<GridData> fields = {
+			{"grid_export", field(&GridData::grid_export)},
+			{"grid_import", field(&GridData::grid_import)},
+			{"import_headroom", field(&GridData::import_headroom)},
+			{"tariff_index", field(&GridData::tariff_index)},
+			{"export_tariff", field(&GridData::export_tariff)}
+		};
+		return fields;
+	}
+
+	template <>
+	const FieldTable<HeatPumpData>& fieldsOf() {
+		static const FieldTable<HeatPumpData> fields = {
+			{"heat_power", field(&HeatPumpData::heat_power)},
+			{"heat_source", field(&HeatPumpData::heat_source)},
+			{"send_temp", field(&HeatPumpData::send_temp)}
+		};
+		return fields;
+	}
+
+	template <>
+	const FieldTable<MopData>& fieldsOf() {
+		static const FieldTable<MopData> fields = {
+			{"maximum_load", field(&MopData::maximum_load)}
+		};
+		return fields;
+	}
+
+	template <>
+	const FieldTable<SolarData>& fieldsOf() {
+		static const FieldTable<SolarData> fields = {
+			{"yield_scalar", field(&SolarData::yield_scalar)},
+			{"yield_index", field(&SolarData::yield_index)}
+		};
+		return fields;
+	}
+
+	// the site range preserves its key order, but the TaskData serialisers use the default json type
+	json toJson(const nlohmann::ordered_json& value) {
+		return json::parse(value.dump());
+	}
+
+	template <typename Component>
+	std::function<Component& (TaskData&)> accessSingleton(std::optional<Component> TaskData::* member) {
+		return [member](TaskData& taskData) -> Component& { return *(taskData.*member); };
+	}
+}
+
+ScenarioCodec::ScenarioCodec(const std::string& siteRangeJson) {
+	auto siteRange = nlohmann::ordered_json::parse(siteRangeJson);
+	if (!siteRange.is_object()) {
+		throw std::runtime_error("The site range must be a json object");
+	}
+
+	// add the component to the defaults, then add its genes
+	auto addSingleton = [&]<typename Component>(const std::string& name, const nlohmann::ordered_json& asset,
+		std::optional<Component> TaskData::* member) {
+		mDefaults.*member = Component{};
+		addComponent<Component>(name, asset, accessSingleton(member),
+			[member](TaskData& taskData) { (taskData.*member).reset(); }, std::nullopt);
+	};
+
+	for (const auto& [name, asset] : siteRange.items()) {
+		if (name == "building") {
+			addSingleton(name, asset, &TaskData::building);
+		}
+		else if (name == "data_centre") {
+			addSingleton(name, asset, &TaskData::data_centre);
+		}
+		else if (name == "domestic_hot_water") {
+			addSingleton(name, asset, &TaskData::domestic_hot_water);
+		}
+		else if (name == "electric_vehicles") {
+			addSingleton(name, asset, &TaskData::electric_vehicles);
+		}
+		else if (name == "energy_storage_system") {
+			addSingleton(name, asset, &TaskData::energy_storage_system);
+		}
+		else if (name == "gas_heater") {
+			addSingleton(name, asset, &TaskData::gas_heater);
+		}
+		else if (name == "grid") {
+			addSingleton(name, asset, &TaskData::grid);
+		}
+		else if (name == "heat_pump") {
+			addSingleton(name, asset, &TaskData::heat_pump);
+		}
+		else if (name == "mop") {
+			addSingleton(name, asset, &TaskData::mop);
+		}
+		else if (name == "solar_panels") {
+			if (!asset.is_array()) {
+				throw std::runtime_error("solar_panels must be a list in the site range");
+			}
+			mDefaults.solar_panels.resize(asset.size());
+			for (size_t i = 0; i < asset.size(); i++) {
+				addComponent<SolarData>(std::format("solar_panels[{}]", i), asset[i],
+					[i](TaskData& taskData) -> SolarData& { return taskData.solar_panels[i]; }, nullptr, i);
+			}
+		}
+		else {
+			throw std::runtime_error(std::format("Unknown component {} in the site range", name));
+		}
+	}
+}
+
+template <typename Component>
+void ScenarioCodec::addComponent(const std::string& name, const nlohmann::ordered_json& asset,
+	std::function<Component& (TaskData&)> access, Setter removeSingleton, std::optional<size_t> solarIndex) {
+
+	if (!asset.is_object()) {
+		throw std::runtime_error(std::format("{} must be a json object in the site range", name));
+	}
+
+	// start from the component's defaults, so that the fixed values only need to be given when they differ
+	json defaults = Component{};
+	std::vector<Gene> attributeGenes;
+
+	for (const auto& item : asset.items()) {
+		const std::string& attr = item.key();
+		const nlohmann::ordered_json& value = item.value();
+
+		if (attr == "COMPONENT_IS_MANDATORY") {
+			if (!value.get<bool>()) {
+				// the presence gene comes before the component's attributes
+				Gene presence{ name, 2, {}, true, removeSingleton, solarIndex };
+				mGenes.push_back(std::move(presence));
+			}
+		}
+		else if (FIXED_PARAMETERS.contains(attr) || !value.is_array()) {
+			defaults[attr] = toJson(value);
+		}
+		else if (value.empty()) {
+			throw std::runtime_error(std::format("{}.{} has no values in the site range", name, attr));
+		}
+		else if (value.size() == 1) {
+			defaults[attr] = toJson(value[0]);
+		}
+		else {
+			const auto& fields = fieldsOf<Component>();
+			auto binder = fields.find(attr);
+			if (binder == fields.end()) {
+				throw std::runtime_error(std::format("{}.{} cannot be optimised", name, attr));
+			}
+
+			Gene gene{ std::format("{}.{}", name, attr), value.size(), {}, false, nullptr, std::nullopt };
+			for (const auto& option : value) {
+				std::function<void(Component&)> set;
+				try {
+					set = binder->second(toJson(option));
+				}
+				catch (const std::exception& e) {
+					throw std::runtime_error(std::format("Invalid value {} for {}: {}", option.dump(), gene.name, e.what()));
+				}
+				gene.values.push_back([access, set](TaskData& taskData) { set(access(taskData)); });
+			}
+			// use the first value until the gene is decoded
+			defaults[attr] = toJson(value[0]);
+			attributeGenes.push_back(std::move(gene));
+		}
+	}
+
+	try {
+		access(mDefaults) = defaults.get<Component>();
+	}
+	catch (const std::exception& e) {
+		throw std::runtime_error(std::format("Invalid {} in the site range: {}", name, e.what()));
+	}
+
+	for (auto& gene : attributeGenes) {
+		mGenes.push_back(std::move(gene));
+	}
+}
+
+std::vector<size_t> ScenarioCodec::geneSizes() const {
+	std::vector<size_t> sizes;
+	sizes.reserve(mGenes.size());
+	for (const auto& gene : mGenes) {
+		sizes.push_back(gene.numValues);
+	}
+	return sizes;
+}
+
+std::vector<std::string> ScenarioCodec::geneNames() const {
+	std::vector<std::string> names;
+	names.reserve(mGenes.size());
+	for (const auto& gene : mGenes) {
+		names.push_back(gene.presence ? gene.name + ".COMPONENT_IS_MANDATORY" : gene.name);
+	}
+	return names;
+}
+
+size_t ScenarioCodec::valueIndex(const Gene& gene, double value) const {
+	// optimisers can produce integer genes as floating point values
+	double rounded = std::round(value);
+	if (!(rounded >= 0.0 && rounded < static_cast<double>(gene.numValues))) {
+		throw std::runtime_error(std::format("Value {} for gene {} is not one of its {} values", value, gene.name, gene.numValues));
+	}
+	return static_cast<size_t>(rounded);
+}
+
+TaskData ScenarioCodec::decode(std::span<const double> chromosome) const {
+	if (chromosome.size() != mGenes.size()) {
+		throw std::runtime_error(std::format("Expected a chromosome of {} genes but got {}", mGenes.size(), chromosome.size()));
+	}
+
+	TaskData taskData = mDefaults;
+	std::vector<size_t> solarToRemove;
+
+	for (size_t g = 0; g < mGenes.size(); g++) {
+		const Gene& gene = mGenes[g];
+		size_t index = valueIndex(gene, chromosome[g]);
+
+		if (!gene.presence) {
+			gene.values[index](taskData);
+		}
+		else if (index == 0) {
+			if (gene.solarIndex) {
+				solarToRemove.push_back(*gene.solarIndex);
+			}
+			else {
+				gene.removeSingleton(taskData);
+			}
+		}
+	}
+
+	// remove the panels from the back so the remaining indices stay valid
+	std::sort(solarToRemove.rbegin(), solarToRemove.rend());
+	for (size_t i : solarToRemove) {
+		taskData.solar_panels.erase(taskData.solar_panels.begin() + static_cast<std::ptrdiff_t>(i));
+	}
+
+	return taskData;
+}
+
+std::vector<TaskData> ScenarioCodec::decode(const Eigen::Ref<const Chromosomes>& chromosomes) const {
+	std::vector<TaskData> taskData;
+	taskData.reserve(static_cast<size_t>(chromosomes.rows()));
+	for (Eigen::Index row = 0; row < chromosomes.rows(); row++) {
+		taskData.push_back(decode(std::span<const double>(chromosomes.row(row).data(), static_cast<size_t>(chromosomes.cols()))));
+	}
+	return taskData;
+}
@@ -0,0 +1,71 @@
+#pragma once
+// decoding of optimiser chromosomes directly into TaskData
+
+#include <Eigen/Core>
+#include <nlohmann/json.hpp>
+#include <functional>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "../Simulation/TaskData.hpp"
+
+// candidate solutions, one per row, holding the index of the chosen value for each gene
+using Chromosomes = Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+
+/**
+* Decode chromosomes into TaskData without going through json
+*
+* The codec is described once by a site range: a json object with an entry per component
+* (and a list of entries for solar_panels). Each attribute of a component is either a fixed value
+* or a list of the values it may take, and each list with more than one value is a gene.
+* A component whose COMPONENT_IS_MANDATORY is false has an extra gene (before its attributes)
+* choosing whether it is present: 0 removes it and 1 keeps it.
+*
+* The genes are in the order they appear in the site range, as in the optimisation service's ProblemInstance.
+* Every value is converted to its TaskData type when the codec is constructed, so decoding does no parsing.
+*/
+class ScenarioCodec {
+public:
+	explicit ScenarioCodec(const std::string& siteRangeJson);
+
+	size_t numGenes() const { return mGenes.size(); }
+
+	// the number of values that each gene can take
+	std::vector<size_t> geneSizes() const;
+
+	// a readable name for each gene, such as "grid.grid_import" or "solar_panels[1].yield_scalar"
+	std::vector<std::string> geneNames() const;
+
+	/**
+	* Decode a single chromosome, which must have exactly numGenes values
+	* Raise an exception if any value is not the index of one of its gene's values
+	*/
+	TaskData decode(std::span<const double> chromosome) const;
+
+	std::vector<TaskData> decode(const Eigen::Ref<const Chromosomes>& chromosomes) const;
+
+private:
+	using Setter = std::function<void(TaskData&)>;
+
+	struct Gene {
+		std::string name;
+		size_t numValues;
+		// an attribute gene sets the chosen value
+		std::vector<Setter> values;
+		// a presence gene removes its component when its value is 0
+		bool presence = false;
+		Setter removeSingleton;
+		std::optional<size_t> solarIndex;
+	};
+
+	template <typename Component>
+	void addComponent(const std::string& name, const nlohmann::ordered_json& asset,
+		std::function<Component& (TaskData&)> access, Setter removeSingleton, std::optional<size_t> solarIndex);
+
+	size_t valueIndex(const Gene& gene, double value) const;
+
+	TaskData mDefaults;
+	std::vector<Gene> mGenes;
+};
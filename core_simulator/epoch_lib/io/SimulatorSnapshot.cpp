@@ -0,0 +1,154 @@
+#include "SimulatorSnapshot.hpp"
+
+#include <bit>
+#include <concepts>
+#include <cstring>
+#include <format>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#include <Eigen/Core>
+
+#include "BinaryArchive.hpp"
+#include "SiteDataBinary.hpp"
+
+namespace {
+	size_t alignUp(size_t bytes) {
+		return (bytes + SITE_DATA_BINARY_ALIGNMENT - 1) / SITE_DATA_BINARY_ALIGNMENT * SITE_DATA_BINARY_ALIGNMENT;
+	}
+
+	void requireLittleEndian() {
+		if constexpr (std::endian::native != std::endian::little) {
+			throw std::runtime_error("Simulator snapshots are only supported on little-endian platforms");
+		}
+	}
+
+	std::span<const std::byte> section(std::span<const std::byte> snapshot, uint64_t offset, uint64_t size) {
+		if (offset > snapshot.size() || size > snapshot.size() - offset) {
+			throw std::runtime_error("The Simulator snapshot has a corrupt layout");
+		}
+		return snapshot.subspan(static_cast<size_t>(offset), static_cast<size_t>(size));
+	}
+}
+
+
+void writeReportData(binary::Writer& writer, const ReportData& reportData) {
+	const std::vector<ReportColumn> columns = reportData.populatedColumns();
+	writer(static_cast<uint64_t>(reportData.timesteps()), static_cast<uint32_t>(columns.size()));
+	for (ReportColumn col : columns) {
+		writer(static_cast<uint32_t>(col));
+		writer.writeFloats(reportData.get(col).data(), static_cast<size_t>(reportData.timesteps()));
+	}
+}
+
+std::shared_ptr<const ReportData> readReportData(binary::Reader& reader) {
+	uint64_t timesteps;
+	uint32_t numColumns;
+	reader(timesteps, numColumns);
+
+	auto reportData = std::make_shared<ReportData>();
+	Eigen::VectorXf values(static_cast<Eigen::Index>(timesteps));
+	for (uint32_t i = 0; i < numColumns; i++) {
+		uint32_t col;
+		reader(col);
+		if (col >= NUM_REPORT_COLUMNS) {
+			throw std::runtime_error(std::format("The report section holds an unknown column {}", col));
+		}
+		reader.readFloats(values.data(), static_cast<size_t>(timesteps));
+		reportData->set(static_cast<ReportColumn>(col), values);
+	}
+	reportData->shrinkToPopulated();
+	return reportData;
+}
+
+
+std::vector<std::byte> snapshotSimulator(const Simulator& simulator) {
+	requireLittleEndian();
+
+	std::ostringstream siteData;
+	writeSiteDataBinary(*simulator.getSiteData(), siteData);
+
+	std::ostringstream configOut;
+	binary::Writer configWriter(configOut);
+	configWriter(simulator.getConfig());
+
+	const SimulatorBaseline baseline = simulator.getBaseline();
+	std::ostringstream baselineOut;
+	binary::Writer baselineWriter(baselineOut);
+	baselineWriter(baseline.usage, baseline.metrics);
+
+	std::ostringstream reportOut;
+	binary::Writer reportWriter(reportOut);
+	writeReportData(reportWriter, *baseline.reportData);
+
+	const std::string sections[] = { siteData.str(), configOut.str(), baselineOut.str(), reportOut.str() };
+
+	SimulatorSnapshotHeader header{};
+	header.magic = SIMULATOR_SNAPSHOT_MAGIC;
+	header.version = SIMULATOR_SNAPSHOT_VERSION;
+	header.header_size = sizeof(SimulatorSnapshotHeader);
+	// the binary SiteData is aligned, so that it can be viewed in place when the snapshot is
+	header.site_data_offset = alignUp(sizeof(SimulatorSnapshotHeader));
+	header.site_data_size = sections[0].size();
+	header.config_offset = header.site_data_offset + header.site_data_size;
+	header.config_size = sections[1].size();
+	header.baseline_offset = header.config_offset + header.config_size;
+	header.baseline_size = sections[2].size();
+	header.report_offset = header.baseline_offset + header.baseline_size;
+	header.report_size = sections[3].size();
+	header.snapshot_size = header.report_offset + header.report_size;
+
+	std::vector<std::byte> snapshot(header.snapshot_size);
+	std::memcpy(snapshot.data(), &header, sizeof(header));
+	size_t offset = header.site_data_offset;
+	for (const std::string& bytes : sections) {
+		std::memcpy(snapshot.data() + offset, bytes.data(), bytes.size());
+		offset += bytes.size();
+	}
+	return snapshot;
+}
+
+std::shared_ptr<Simulator> restoreSimulator(std::span<const std::byte> snapshot) {
+	requireLittleEndian();
+
+	if (snapshot.size() < sizeof(SimulatorSnapshotHeader)) {
+		throw std::runtime_error("The Simulator snapshot is too small to hold a header");
+	}
+	SimulatorSnapshotHeader header;
+	std::memcpy(&header, snapshot.data(), sizeof(header));
+
+	if (header.magic != SIMULATOR_SNAPSHOT_MAGIC) {
+		throw std::runtime_error("This is not a Simulator snapshot");
+	}
+	if (header.version != SIMULATOR_SNAPSHOT_VERSION) {
+		throw std::runtime_error(std::format(
+			"The Simulator snapshot is version {} but only version {} is supported",
+			header.version, SIMULATOR_SNAPSHOT_VERSION
+		));
+	}
+	if (header.header_size != sizeof(SimulatorSnapshotHeader) || header.snapshot_size != snapshot.size()) {
+		throw std::runtime_error("The Simulator snapshot is truncated or has a corrupt header");
+	}
+
+	auto siteData = std::make_shared<const SiteData>(
+		readSiteDataBinary(section(snapshot, header.site_data_offset, header.site_data_size)));
+
+	TaskConfig config{};
+	binary::Reader configReader(section(snapshot, header.config_offset, header.config_size), "Simulator snapshot", "config");
+	configReader(config);
+	configReader.requireFinished();
+
+	SimulatorBaseline baseline{};
+	binary::Reader baselineReader(section(snapshot, header.baseline_offset, header.baseline_size), "Simulator snapshot", "baseline");
+	baselineReader(baseline.usage, baseline.metrics);
+	baselineReader.requireFinished();
+
+	binary::Reader reportReader(section(snapshot, header.report_offset, header.report_size), "Simulator snapshot", "report");
+	baseline.reportData = readReportData(reportReader);
+	reportReader.requireFinished();
+
+	return std::make_shared<Simulator>(std::move(siteData), std::move(config), std::move(baseline));
+}
@@ -0,0 +1,73 @@
+/*
+logic for snapshotting a constructed Simulator, so that it can be restored without simulating its baseline
+*/
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "BinaryArchive.hpp"
+#include "../Simulation/Simulate.hpp"
+
+/**
+* The Simulator snapshot container
+*
+* All values are little-endian. A snapshot consists of:
+* - a SimulatorSnapshotHeader
+* - the SiteData, in the binary SiteData format (starting on a SITE_DATA_BINARY_ALIGNMENT byte boundary)
+* - the TaskConfig
+* - the baseline UsageData and SimulationMetrics
+* - the columns of the baseline ReportData
+*
+* The TaskConfig and baseline are stored field by field (rather than as JSON), so every float is restored exactly.
+* The tariff statistics and heatpump tables are recalculated from the SiteData when the snapshot is restored.
+* They take a single pass over the timeseries, whereas the baseline is a full simulation.
+* The caches and representative days of the Simulator are not included.
+*/
+inline constexpr std::array<char, 8> SIMULATOR_SNAPSHOT_MAGIC = { 'E', 'P', 'O', 'C', 'H', 'S', 'N', '\0' };
+inline constexpr uint32_t SIMULATOR_SNAPSHOT_VERSION = 1;
+
+struct SimulatorSnapshotHeader {
+	std::array<char, 8> magic;
+	uint32_t version;
+	uint32_t header_size;
+
+	uint64_t site_data_offset;
+	uint64_t site_data_size;
+	uint64_t config_offset;
+	uint64_t config_size;
+	uint64_t baseline_offset;
+	uint64_t baseline_size;
+	uint64_t report_offset;
+	uint64_t report_size;
+	uint64_t snapshot_size;
+};
+
+static_assert(sizeof(SimulatorSnapshotHeader) == 88, "The SimulatorSnapshotHeader layout must not change within a version");
+
+
+/**
+* Write a constructed Simulator to a snapshot
+*/
+std::vector<std::byte> snapshotSimulator(const Simulator& simulator);
+
+/**
+* Restore a Simulator from a snapshot, without simulating its baseline
+* The results of the restored Simulator are identical to those of the original
+*/
+std::shared_ptr<Simulator> restoreSimulator(std::span<const std::byte> snapshot);
+
+/**
+* Write the populated columns of a ReportData: the number of timesteps and columns, then each ReportColumn followed by its values
+* (as in the report section of a snapshot)
+*/
+void writeReportData(binary::Writer& writer, const ReportData& reportData);
+
+/**
+* Read the columns written by writeReportData
+*/
+std::shared_ptr<const ReportData> readReportData(binary::Reader& reader);
@@ -0,0 +1,315 @@
+#include "SiteDataBinary.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../Exceptions.hpp"
+#include "SiteDataJson.hpp"
+#include "TaskDataJson.hpp"
+
+using json = nlohmann::json;
+
+namespace {
+	// the six fixed timeseries before the solar yields
+	constexpr size_t NUM_FIXED_COLUMNS = 6;
+
+	size_t alignUp(size_t bytes) {
+		return (bytes + SITE_DATA_BINARY_ALIGNMENT - 1) / SITE_DATA_BINARY_ALIGNMENT * SITE_DATA_BINARY_ALIGNMENT;
+	}
+
+	void requireLittleEndian() {
+		if constexpr (std::endian::native != std::endian::little) {
+			throw std::runtime_error("Binary SiteData is only supported on little-endian platforms");
+		}
+	}
+
+	int64_t toNanoseconds(std::chrono::system_clock::time_point tp) {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(tp.time_since_epoch()).count();
+	}
+
+	std::chrono::system_clock::time_point fromNanoseconds(int64_t ns) {
+		return std::chrono::system_clock::time_point{
+			std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds{ ns }) };
+	}
+
+	size_t numColumns(const SiteDataBinaryHeader& header) {
+		return NUM_FIXED_COLUMNS + header.num_solar_yields + header.num_import_tariffs + header.num_fabric_interventions;
+	}
+
+	void writePadding(std::ostream& out, size_t bytes) {
+		static const std::array<char, SITE_DATA_BINARY_ALIGNMENT> zeros{};
+		out.write(zeros.data(), static_cast<std::streamsize>(bytes));
+	}
+
+	void writeFloats(std::ostream& out, const float* data, size_t count, size_t stride) {
+		const size_t bytes = count * sizeof(float);
+		out.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(bytes));
+		writePadding(out, stride - bytes);
+	}
+
+	// a block of SITE_DATA_BINARY_ALIGNMENT bytes, so that a vector of them is suitably aligned for a SiteDataView
+	struct alignas(SITE_DATA_BINARY_ALIGNMENT) AlignedBlock {
+		std::array<std::byte, SITE_DATA_BINARY_ALIGNMENT> bytes;
+	};
+}
+
+
+SiteDataView::SiteDataView(const std::filesystem::path& filepath) :
+	mFile(std::make_shared<const MappedFile>(filepath)),
+	mBytes(mFile->data(), mFile->size())
+{
+	parse(filepath.filename().string());
+}
+
+SiteDataView::SiteDataView(std::span<const std::byte> bytes) :
+	mBytes(bytes)
+{
+	if (reinterpret_cast<uintptr_t>(mBytes.data()) % SITE_DATA_BINARY_ALIGNMENT != 0) {
+		throw std::runtime_error(std::format("Binary SiteData in memory must be aligned to a {} byte boundary", SITE_DATA_BINARY_ALIGNMENT));
+	}
+	parse("Binary SiteData");
+}
+
+void SiteDataView::parse(const std::string& filename) {
+	requireLittleEndian();
+
+	if (mBytes.size() < sizeof(SiteDataBinaryHeader)) {
+		throw std::runtime_error(std::format("{} is too small to be a binary SiteData file", filename));
+	}
+	std::memcpy(&mHeader, mBytes.data(), sizeof(SiteDataBinaryHeader));
+
+	if (mHeader.magic != SITE_DATA_BINARY_MAGIC) {
+		throw std::runtime_error(std::format("{} is not a binary SiteData file", filename));
+	}
+	if (mHeader.version != SITE_DATA_BINARY_VERSION) {
+		throw std::runtime_error(std::format(
+			"{} is binary SiteData version {} but only version {} is supported",
+			filename, mHeader.version, SITE_DATA_BINARY_VERSION
+		));
+	}
+	if (mHeader.header_size != sizeof(SiteDataBinaryHeader) || mHeader.file_size != mBytes.size()) {
+		throw std::runtime_error(std::format("{} is truncated or has a corrupt header", filename));
+	}
+
+	mColumnStride = alignUp(mHeader.timesteps * sizeof(float));
+	mTableStride = alignUp(static_cast<size_t>(mHeader.ashp_rows) * mHeader.ashp_cols * sizeof(float));
+
+	const size_t columnsEnd = mHeader.columns_offset + numColumns(mHeader) * mColumnStride + 2 * mTableStride;
+	if (mHeader.columns_offset % SITE_DATA_BINARY_ALIGNMENT != 0
+		|| mHeader.metadata_offset + mHeader.metadata_size > mHeader.columns_offset
+		|| columnsEnd > mBytes.size())
+	{
+		throw std::runtime_error(std::format("{} has a corrupt layout", filename));
+	}
+
+	const char* metadata = reinterpret_cast<const char*>(mBytes.data() + mHeader.metadata_offset);
+	mMetadata = json::parse(metadata, metadata + mHeader.metadata_size);
+}
+
+SiteDataView::ColumnView SiteDataView::solar_yield(size_t i) const {
+	if (i >= mHeader.num_solar_yields) {
+		throw std::out_of_range("solar yield index out of range");
+	}
+	return column(NUM_FIXED_COLUMNS + i);
+}
+
+SiteDataView::ColumnView SiteDataView::import_tariff(size_t i) const {
+	if (i >= mHeader.num_import_tariffs) {
+		throw std::out_of_range("import tariff index out of range");
+	}
+	return column(NUM_FIXED_COLUMNS + mHeader.num_solar_yields + i);
+}
+
+SiteDataView::ColumnView SiteDataView::fabric_reduced_hload(size_t i) const {
+	if (i >= mHeader.num_fabric_interventions) {
+		throw std::out_of_range("fabric intervention index out of range");
+	}
+	return column(NUM_FIXED_COLUMNS + mHeader.num_solar_yields + mHeader.num_import_tariffs + i);
+}
+
+SiteDataView::ColumnView SiteDataView::column(size_t index) const {
+	const std::byte* start = mBytes.data() + mHeader.columns_offset + index * mColumnStride;
+	return ColumnView(reinterpret_cast<const float*>(start), static_cast<Eigen::Index>(mHeader.timesteps));
+}
+
+SiteDataView::TableView SiteDataView::table(size_t index) const {
+	const std::byte* start = mBytes.data() + mHeader.columns_offset + numColumns(mHeader) * mColumnStride + index * mTableStride;
+	return TableView(reinterpret_cast<const float*>(start), mHeader.ashp_rows, mHeader.ashp_cols);
+}
+
+SiteData SiteDataView::toSiteData() const {
+	return makeSiteData(false);
+}
+
+SiteData SiteDataView::toMappedSiteData() const {
+	if (!mFile) {
+		throw std::runtime_error("Only a view of a binary SiteData file can share its mapping");
+	}
+	return makeSiteData(true);
+}
+
+SiteData SiteDataView::makeSiteData(bool viewMapping) const {
+	auto series = [&](ColumnView column) {
+		return viewMapping ? SiteSeries(column.data(), column.size(), mFile) : SiteSeries(column);
+	};
+
+
+	std::vector<SiteSeries> solar_yields;
+	solar_yields.reserve(mHeader.num_solar_yields);
+	for (size_t i = 0; i < mHeader.num_solar_yields; i++) {
+		solar_yields.push_back(series(solar_yield(i)));
+	}
+
+	std::vector<SiteSeries> import_tariffs;
+	import_tariffs.reserve(mHeader.num_import_tariffs);
+	for (size_t i = 0; i < mHeader.num_import_tariffs; i++) {
+		import_tariffs.push_back(series(import_tariff(i)));
+	}
+
+	const json& fabricMetadata = mMetadata.at("fabric_interventions");
+	if (fabricMetadata.size() != mHeader.num_fabric_interventions) {
+		throw std::runtime_error("Binary SiteData metadata does not match the number of fabric interventions");
+	}
+
+	std::vector<FabricIntervention> fabric_interventions;
+	fabric_interventions.reserve(mHeader.num_fabric_interventions);
+	for (size_t i = 0; i < mHeader.num_fabric_interventions; i++) {
+		FabricIntervention intervention;
+		intervention.cost = fabricMetadata[i].at("cost").get<float>();
+		intervention.cost_breakdown = fabricMetadata[i].at("cost_breakdown").get<std::vector<FabricCostBreakdown>>();
+		intervention.peak_hload = fabricMetadata[i].at("peak_hload").get<float>();
+		intervention.reduced_hload = series(fabric_reduced_hload(i));
+		fabric_interventions.push_back(std::move(intervention));
+	}
+
+	return SiteData(
+		fromNanoseconds(mHeader.start_ts_ns),
+		fromNanoseconds(mHeader.end_ts_ns),
+		mMetadata.at("baseline").get<TaskData>(),
+		series(building_eload()),
+		series(building_hload()),
+		mHeader.peak_hload,
+		series(ev_eload()),
+		series(dhw_demand()),
+		series(air_temperature()),
+		series(grid_co2()),
+		std::move(solar_yields),
+		std::move(import_tariffs),
+		std::move(fabric_interventions),
+		ashp_input_table(),
+		ashp_output_table()
+	);
+}
+
+
+void writeSiteDataBinary(const SiteData& siteData, const std::filesystem::path& filepath) {
+	std::ofstream out(filepath, std::ios::binary | std::ios::trunc);
+	if (!out.is_open()) {
+		throw FileWriteException(filepath.filename().string());
+	}
+
+	writeSiteDataBinary(siteData, out);
+
+	if (!out) {
+		throw FileWriteException(filepath.filename().string());
+	}
+}
+
+void writeSiteDataBinary(const SiteData& siteData, std::ostream& out) {
+	requireLittleEndian();
+	if (!siteData.ensemble.empty()) {
+		// rather than silently dropping it
+		throw std::runtime_error("The binary SiteData format cannot hold an ensemble");
+	}
+
+	// the fabric interventions without their timeseries
+	json fabricMetadata = json::array();
+	for (const auto& fi : siteData.fabric_interventions) {
+		fabricMetadata.push_back(json{
+			{"cost", fi.cost},
+			{"cost_breakdown", fi.cost_breakdown},
+			{"peak_hload", fi.peak_hload}
+		});
+	}
+	const std::string metadata = json{
+		{"baseline", siteData.baseline},
+		{"fabric_interventions", fabricMetadata}
+	}.dump();
+
+	SiteDataBinaryHeader header{};
+	header.magic = SITE_DATA_BINARY_MAGIC;
+	header.version = SITE_DATA_BINARY_VERSION;
+	header.header_size = sizeof(SiteDataBinaryHeader);
+	header.timesteps = siteData.timesteps;
+	header.start_ts_ns = toNanoseconds(siteData.start_ts);
+	header.end_ts_ns = toNanoseconds(siteData.end_ts);
+	header.peak_hload = siteData.peak_hload;
+	header.num_solar_yields = static_cast<uint32_t>(siteData.solar_yields.size());
+	header.num_import_tariffs = static_cast<uint32_t>(siteData.import_tariffs.size());
+	header.num_fabric_interventions = static_cast<uint32_t>(siteData.fabric_interventions.size());
+	header.ashp_rows = static_cast<uint32_t>(siteData.ashp_input_table.rows());
+	header.ashp_cols = static_cast<uint32_t>(siteData.ashp_input_table.cols());
+	header.metadata_offset = sizeof(SiteDataBinaryHeader);
+	header.metadata_size = metadata.size();
+	header.columns_offset = alignUp(header.metadata_offset + header.metadata_size);
+
+	const size_t columnStride = alignUp(siteData.timesteps * sizeof(float));
+	const size_t tableStride = alignUp(siteData.ashp_input_table.size() * sizeof(float));
+	header.file_size = header.columns_offset + numColumns(header) * columnStride + 2 * tableStride;
+
+	out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	out.write(metadata.data(), static_cast<std::streamsize>(metadata.size()));
+	writePadding(out, header.columns_offset - header.metadata_offset - header.metadata_size);
+
+	for (const SiteSeries* ts : { &siteData.building_eload, &siteData.building_hload, &siteData.ev_eload,
+		&siteData.dhw_demand, &siteData.air_temperature, &siteData.grid_co2 }) {
+		writeFloats(out, ts->data(), siteData.timesteps, columnStride);
+	}
+	for (const auto& ts : siteData.solar_yields) {
+		writeFloats(out, ts.data(), siteData.timesteps, columnStride);
+	}
+	for (const auto& ts : siteData.import_tariffs) {
+		writeFloats(out, ts.data(), siteData.timesteps, columnStride);
+	}
+	for (const auto& fi : siteData.fabric_interventions) {
+		// the binary format only has dense columns, so a delta is written as its demand
+		writeFloats(out, fi.heatLoad().data(), siteData.timesteps, columnStride);
+	}
+
+	// Eigen matrices are column-major by default, which is the order we store them in
+	writeFloats(out, siteData.ashp_input_table.data(), siteData.ashp_input_table.size(), tableStride);
+	writeFloats(out, siteData.ashp_output_table.data(), siteData.ashp_output_table.size(), tableStride);
+}
+
+SiteData readSiteDataBinary(const std::filesystem::path& filepath) {
+	return SiteDataView(filepath).toSiteData();
+}
+
+SiteData mapSiteDataBinary(const std::filesystem::path& filepath) {
+	return SiteDataView(filepath).toMappedSiteData();
+}
+
+SiteData readSiteDataBinary(std::span<const std::byte> bytes) {
+	if (reinterpret_cast<uintptr_t>(bytes.data()) % SITE_DATA_BINARY_ALIGNMENT == 0) {
+		return SiteDataView(bytes).toSiteData();
+	}
+
+	std::vector<AlignedBlock> aligned(std::max<size_t>(1, alignUp(bytes.size()) / SITE_DATA_BINARY_ALIGNMENT));
+	std::memcpy(aligned.data(), bytes.data(), bytes.size());
+	return SiteDataView(std::span<const std::byte>(aligned.front().bytes.data(), bytes.size())).toSiteData();
+}
+
+bool isSiteDataBinary(const std::filesystem::path& filepath) {
+	std::ifstream in(filepath, std::ios::binary);
+	std::array<char, 8> magic{};
+	in.read(magic.data(), magic.size());
+	return in.gcount() == static_cast<std::streamsize>(magic.size()) && magic == SITE_DATA_BINARY_MAGIC;
+}
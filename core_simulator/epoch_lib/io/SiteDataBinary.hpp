@@ -0,0 +1,166 @@
+/*
+logic for reading and writing SiteData in a binary, memory-mappable format
+*/
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <ostream>
+#include <span>
+#include <string>
+
+#include <Eigen/Core>
+#include <nlohmann/json.hpp>
+
+#include "../Definitions.hpp"
+#include "../Simulation/SiteData.hpp"
+#include "MappedFile.hpp"
+
+/**
+* The binary SiteData container
+*
+* All values are little-endian. The file consists of:
+* - a SiteDataBinaryHeader
+* - a JSON metadata block holding the baseline and the (non-timeseries) fabric intervention fields
+* - the float32 timeseries, one column after another:
+*   building_eload, building_hload, ev_eload, dhw_demand, air_temperature, grid_co2,
+*   each solar yield, each import tariff, then each fabric intervention's reduced_hload
+* - the ashp input and output tables (column-major)
+*
+* Every column and table starts on a SITE_DATA_BINARY_ALIGNMENT byte boundary,
+* so they can be used directly from a memory mapping of the file
+*/
+inline constexpr std::array<char, 8> SITE_DATA_BINARY_MAGIC = { 'E', 'P', 'O', 'C', 'H', 'S', 'D', '\0' };
+inline constexpr uint32_t SITE_DATA_BINARY_VERSION = 1;
+inline constexpr size_t SITE_DATA_BINARY_ALIGNMENT = 64;
+
+struct SiteDataBinaryHeader {
+	std::array<char, 8> magic;
+	uint32_t version;
+	uint32_t header_size;
+
+	uint64_t timesteps;
+	// nanoseconds since the unix epoch
+	int64_t start_ts_ns;
+	int64_t end_ts_ns;
+
+	float peak_hload;
+	uint32_t num_solar_yields;
+	uint32_t num_import_tariffs;
+	uint32_t num_fabric_interventions;
+	uint32_t ashp_rows;
+	uint32_t ashp_cols;
+
+	uint64_t metadata_offset;
+	uint64_t metadata_size;
+	uint64_t columns_offset;
+	uint64_t file_size;
+};
+
+static_assert(sizeof(SiteDataBinaryHeader) == 96, "The SiteDataBinaryHeader layout must not change within a version");
+
+
+/**
+* Read-only views of the timeseries and lookup tables in a memory-mapped binary SiteData file
+*
+* The views point straight into the mapping, so are only valid for the lifetime of this object
+* (unless they are taken with toMappedSiteData, which shares ownership of the mapping)
+*/
+class SiteDataView {
+public:
+	using ColumnView = Eigen::Map<const year_TS, Eigen::AlignedMax>;
+	using TableView = Eigen::Map<const Eigen::MatrixXf, Eigen::AlignedMax>;
+
+	explicit SiteDataView(const std::filesystem::path& filepath);
+
+	/**
+	* A view of binary SiteData that is already in memory
+	* The bytes must outlive the view and start on a SITE_DATA_BINARY_ALIGNMENT byte boundary
+	*/
+	explicit SiteDataView(std::span<const std::byte> bytes);
+
+	const SiteDataBinaryHeader& header() const { return mHeader; }
+	size_t timesteps() const { return mHeader.timesteps; }
+
+	ColumnView building_eload() const { return column(0); }
+	ColumnView building_hload() const { return column(1); }
+	ColumnView ev_eload() const { return column(2); }
+	ColumnView dhw_demand() const { return column(3); }
+	ColumnView air_temperature() const { return column(4); }
+	ColumnView grid_co2() const { return column(5); }
+
+	ColumnView solar_yield(size_t i) const;
+	ColumnView import_tariff(size_t i) const;
+	ColumnView fabric_reduced_hload(size_t i) const;
+
+	TableView ashp_input_table() const { return table(0); }
+	TableView ashp_output_table() const { return table(1); }
+
+	/**
+	* Copy the views into an (owning) SiteData
+	*/
+	SiteData toSiteData() const;
+
+	/**
+	* Make a SiteData whose timeseries view the mapping rather than copying it
+	* The SiteData (and its copies) keep the mapping alive, so may outlive this object
+	* Only available for a view of a file
+	*/
+	SiteData toMappedSiteData() const;
+
+private:
+	// check the header and parse the metadata of mBytes, naming the file in any errors
+	void parse(const std::string& filename);
+
+	ColumnView column(size_t index) const;
+	TableView table(size_t index) const;
+
+	// make a SiteData, either viewing or copying the timeseries
+	SiteData makeSiteData(bool viewMapping) const;
+
+	// only set when the view owns a mapping of its file
+	std::shared_ptr<const MappedFile> mFile;
+	std::span<const std::byte> mBytes;
+	SiteDataBinaryHeader mHeader;
+	nlohmann::json mMetadata;
+	size_t mColumnStride;
+	size_t mTableStride;
+};
+
+/**
+* Write a SiteData in the binary format
+*/
+void writeSiteDataBinary(const SiteData& siteData, const std::filesystem::path& filepath);
+
+/**
+* Write a SiteData in the binary format to a stream (such as a snapshot in memory)
+*/
+void writeSiteDataBinary(const SiteData& siteData, std::ostream& out);
+
+/**
+* Read a binary SiteData file
+*/
+SiteData readSiteDataBinary(const std::filesystem::path& filepath);
+
+/**
+* Map a binary SiteData file, without copying its timeseries
+*
+* The file is mapped read-only, so every process that maps the same file shares the page cache pages
+* and the timeseries are held once per node rather than once per worker.
+* A file in /dev/shm (a named POSIX shared memory segment) is never written back to disk.
+*/
+SiteData mapSiteDataBinary(const std::filesystem::path& filepath);
+
+/**
+* Read binary SiteData from memory
+* The bytes need not be aligned; if they aren't, they are copied to an aligned buffer first
+*/
+SiteData readSiteDataBinary(std::span<const std::byte> bytes);
+
+/**
+* Check whether a file starts with the binary SiteData magic bytes
+*/
+bool isSiteDataBinary(const std::filesystem::path& filepath);
@@ -34,6 +34,21 @@ void to_json(json& j, const FabricCostBreakdown& breakdown) {
     }
 }
 
+// the base of a delta isn't written, as it is the building_hload of the SiteData it is read into
+void from_json(const json& j, FabricHeatDelta& delta) {
+    delta.scale = j.at("scale").get<float>();
+    delta.index = j.value("index", std::vector<uint32_t>{});
+    delta.value = j.value("value", std::vector<float>{});
+}
+
+void to_json(json& j, const FabricHeatDelta& delta) {
+    j = json{
+        {"scale", delta.scale},
+        {"index", delta.index},
+        {"value", delta.value}
+    };
+}
+
 void from_json(const json& j, FabricIntervention& intervention) {
     intervention.cost = j.at("cost").get<float>();
     if (j.contains("cost_breakdown") && !j.at("cost_breakdown").is_null()) {
@@ -42,7 +57,15 @@ void from_json(const json& j, FabricIntervention& intervention) {
     else {
         intervention.cost_breakdown.clear();
     }
-    intervention.reduced_hload = toEigen(j.at("reduced_hload").get<std::vector<float>>());
+    // the heating demand is either a timeseries or a delta against building_hload
+    if (j.contains("hload_delta")) {
+        intervention.hload_delta = j.at("hload_delta").get<FabricHeatDelta>();
+        intervention.reduced_hload = SiteSeries();
+    }
+    else {
+        intervention.hload_delta.reset();
+        intervention.reduced_hload = toEigen(j.at("reduced_hload").get<std::vector<float>>());
+    }
     intervention.peak_hload = j.value("peak_hload", 0.0f);  // default to 0.0f
 }
 
@@ -50,14 +73,19 @@ void to_json(json& j, const FabricIntervention& intervention) {
     j = json{
         {"cost", intervention.cost},
         {"cost_breakdown", intervention.cost_breakdown},
-        {"reduced_hload", toStdVec(intervention.reduced_hload)},
         {"peak_hload", intervention.peak_hload}
     };
+    if (intervention.hload_delta) {
+        j["hload_delta"] = *intervention.hload_delta;
+    }
+    else {
+        j["reduced_hload"] = toStdVec(intervention.reduced_hload);
+    }
 }
 
-// Utility to parse vector of vectors into a std::vector<year_TS>
-static std::vector<year_TS> parseVectorOfVectors(const json& arr) {
-    std::vector<year_TS> result;
+// Utility to parse vector of vectors into a std::vector<SiteSeries>
+static std::vector<SiteSeries> parseVectorOfVectors(const json& arr) {
+    std::vector<SiteSeries> result;
     result.reserve(arr.size());
     for (const auto& subArr : arr) {
         auto tmp = subArr.get<std::vector<float>>();
@@ -66,8 +94,66 @@ static std::vector<year_TS> parseVectorOfVectors(const json& arr) {
     return result;
 }
 
+void from_json(const json& j, TariffBandHours& band) {
+    band.hours = j.at("hours").get<double>();
+    band.price = j.at("price").get<float>();
+}
+
+void to_json(json& j, const TariffBandHours& band) {
+    j = json{
+        {"hours", band.hours},
+        {"price", band.price}
+    };
+}
+
+void from_json(const json& j, TariffPatternHours& pattern) {
+    pattern.period_hours = j.value("period_hours", 24.0);  // default to a daily pattern
+    pattern.bands = j.at("bands").get<std::vector<TariffBandHours>>();
+}
+
+void to_json(json& j, const TariffPatternHours& pattern) {
+    j = json{
+        {"period_hours", pattern.period_hours},
+        {"bands", pattern.bands}
+    };
+}
+
+std::vector<SiteSeries> expandImportTariffs(std::vector<ImportTariffEntry> entries,
+    std::chrono::system_clock::time_point start_ts, std::chrono::system_clock::time_point end_ts, size_t timesteps) {
+    // (an empty SiteData is rejected by its constructor; here it only needs to not divide by zero)
+    const std::chrono::seconds interval = timesteps > 0
+        ? SiteData::timestepInterval(start_ts, end_ts, timesteps) : std::chrono::seconds{ 0 };
+
+    std::vector<SiteSeries> tariffs;
+    tariffs.reserve(entries.size());
+    for (auto& entry : entries) {
+        if (auto* pattern = std::get_if<TariffPatternHours>(&entry)) {
+            tariffs.push_back(pattern->atInterval(interval).expand(static_cast<Eigen::Index>(timesteps)));
+        }
+        else {
+            tariffs.push_back(std::move(std::get<SiteSeries>(entry)));
+        }
+    }
+    return tariffs;
+}
+
+// Utility to parse the import tariffs, each of which is either a timeseries or a pattern of bands
+static std::vector<ImportTariffEntry> parseImportTariffs(const json& arr) {
+    std::vector<ImportTariffEntry> result;
+    result.reserve(arr.size());
+    for (const auto& tariff : arr) {
+        if (tariff.is_object()) {
+            result.emplace_back(tariff.get<TariffPatternHours>());
+        }
+        else {
+            result.emplace_back(SiteSeries(toEigen(tariff.get<std::vector<float>>())));
+        }
+    }
+    return result;
+}
+
 // Utility to convert back to a nested std::vec before deserialization
-static std::vector<std::vector<float>> toVectorOfVectors(std::vector<year_TS> vec) {
+static std::vector<std::vector<float>> toVectorOfVectors(const std::vector<SiteSeries>& vec) {
     std::vector<std::vector<float>> output;
     output.reserve(vec.size());
     for (const auto& v : vec) {
@@ -110,7 +196,8 @@ namespace nlohmann {
 
         // Vectors of year_TS
         auto solar_yields = parseVectorOfVectors(j.at("solar_yields"));
-        auto import_tariffs = parseVectorOfVectors(j.at("import_tariffs"));
+        auto import_tariffs = expandImportTariffs(parseImportTariffs(j.at("import_tariffs")),
+            start_ts, end_ts, static_cast<size_t>(reference_size));
 
         // Fabric interventions
         auto fabric_interventions = j.at("fabric_interventions").get<std::vector<FabricIntervention>>();
@@ -158,7 +245,7 @@ namespace nlohmann {
             {"grid_co2", toStdVec(sd.grid_co2)},
 
             // Vectors of year_TS
-            {"solar_yields", toVectorOfVectors(sd.solar_yields)},
+            {"solar_yields", toVectorOfVectors(sd.solar_yields.columns())},
             {"import_tariffs", toVectorOfVectors(sd.import_tariffs)},
 
             // Fabric interventions
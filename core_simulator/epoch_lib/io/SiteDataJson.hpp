@@ -3,13 +3,40 @@ logic for serializing and deserializing SiteData to nlohmann json
 */
 #pragma once
 
+#include <chrono>
+#include <variant>
+#include <vector>
+
 #include <nlohmann/json.hpp>
 
 #include "../Simulation/SiteData.hpp"
+#include "../Simulation/TariffPattern.hpp"
+
+void from_json(const nlohmann::json& j, FabricCostBreakdown& breakdown);
+void to_json(nlohmann::json& j, const FabricCostBreakdown& breakdown);
+
+void from_json(const nlohmann::json& j, FabricHeatDelta& delta);
+void to_json(nlohmann::json& j, const FabricHeatDelta& delta);
 
 void from_json(const nlohmann::json& j, FabricIntervention& intervention);
 void to_json(nlohmann::json& j, const FabricIntervention& intervention);
 
+void from_json(const nlohmann::json& j, TariffBandHours& band);
+void to_json(nlohmann::json& j, const TariffBandHours& band);
+
+void from_json(const nlohmann::json& j, TariffPatternHours& pattern);
+void to_json(nlohmann::json& j, const TariffPatternHours& pattern);
+
+// an import tariff as it is written in a SiteData file: a timeseries, or an object holding a TariffPatternHours
+using ImportTariffEntry = std::variant<SiteSeries, TariffPatternHours>;
+
+/**
+* The dense import tariffs of a SiteData whose timesteps span start_ts to end_ts
+* Each pattern is expanded to a timeseries, starting from its first band at start_ts.
+*/
+std::vector<SiteSeries> expandImportTariffs(std::vector<ImportTariffEntry> entries,
+    std::chrono::system_clock::time_point start_ts, std::chrono::system_clock::time_point end_ts, size_t timesteps);
+
 namespace nlohmann {
     template <>
     struct adl_serializer<SiteData> {
@@ -0,0 +1,342 @@
+#include "TaskDataBinary.hpp"
+
+#include <bit>
+#include <concepts>
+#include <cstring>
+#include <format>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+
+namespace {
+	constexpr const char* CONTAINER = "binary TaskData batch";
+
+	void requireLittleEndian() {
+		if constexpr (std::endian::native != std::endian::little) {
+			throw std::runtime_error("Binary TaskData records are only supported on little-endian platforms");
+		}
+	}
+
+	[[noreturn]] void corrupt() {
+		throw std::runtime_error("The TaskData record is corrupt");
+	}
+
+	// one more than the largest value of each enum
+	constexpr uint32_t enumLimit(BatteryMode) { return 4; }
+	constexpr uint32_t enumLimit(GasType) { return 2; }
+	constexpr uint32_t enumLimit(HeatSource) { return 2; }
+
+	template <typename S, typename T>
+	concept FieldsOf = std::same_as<std::remove_const_t<S>, T>;
+
+	// The fields of each component, in the order they are stored
+	// A new field must be added here (and TASK_DATA_RECORD_SIZE and TASK_DATA_BATCH_VERSION updated)
+
+	template <typename Archive, FieldsOf<Building> S>
+	void visitFields(Archive& ar, S& b) {
+		ar(b.scalar_heat_load, b.scalar_electrical_load, b.fabric_intervention_index, b.floor_area, b.incumbent, b.age, b.lifetime);
+	}
+
+	template <typename Archive, FieldsOf<DataCentreData> S>
+	void visitFields(Archive& ar, S& d) {
+		ar(d.maximum_load, d.hotroom_temp, d.incumbent, d.age, d.lifetime);
+	}
+
+	template <typename Archive, FieldsOf<DomesticHotWater> S>
+	void visitFields(Archive& ar, S& d) {
+		ar(d.cylinder_volume, d.incumbent, d.age, d.lifetime);
+	}
+
+	template <typename Archive, FieldsOf<ElectricVehicles> S>
+	void visitFields(Archive& ar, S& ev) {
+		ar(ev.flexible_load_ratio, ev.small_chargers, ev.fast_chargers, ev.rapid_chargers, ev.ultra_chargers,
+			ev.scalar_electrical_load, ev.incumbent, ev.age, ev.lifetime);
+	}
+
+	template <typename Archive, FieldsOf<EnergyStorageSystem> S>
+	void visitFields(Archive& ar, S& ess) {
+		ar(ess.capacity, ess.charge_power, ess.discharge_power, ess.battery_mode, ess.initial_charge, ess.incumbent, ess.age, ess.lifetime);
+	}
+
+	template <typename Archive, FieldsOf<GasCHData> S>
+	void visitFields(Archive& ar, S& gch) {
+		ar(gch.maximum_output, gch.boiler_efficiency, gch.gas_type, gch.fixed_gas_price, gch.incumbent, gch.age, gch.lifetime);
+	}
+
+	template <typename Archive, FieldsOf<GridData> S>
+	void visitFields(Archive& ar, S& grid) {
+		ar(grid.grid_export, grid.grid_import, grid.import_headroom, grid.tariff_index, grid.export_tariff,
+			grid.incumbent, grid.age, grid.lifetime);
+	}
+
+	template <typename Archive, FieldsOf<HeatPumpData> S>
+	void visitFields(Archive& ar, S& hp) {
+		ar(hp.heat_power, hp.heat_source, hp.send_temp, hp.incumbent, hp.age, hp.lifetime);
+	}
+
+	template <typename Archive, FieldsOf<MopData> S>
+	void visitFields(Archive& ar, S& m) {
+		ar(m.maximum_load, m.incumbent, m.age, m.lifetime);
+	}
+
+	template <typename Archive, FieldsOf<SolarData> S>
+	void visitFields(Archive& ar, S& sd) {
+		ar(sd.yield_scalar, sd.yield_index, sd.incumbent, sd.age, sd.lifetime);
+	}
+
+	template <typename Archive, FieldsOf<TaskData> S>
+	void visitFields(Archive& ar, S& td) {
+		ar(td.building, td.data_centre, td.domestic_hot_water, td.electric_vehicles, td.energy_storage_system,
+			td.gas_heater, td.grid, td.heat_pump, td.mop, td.solar_panels);
+	}
+
+	/**
+	* Writes each value at the next position of a record
+	* Signed integers are stored as int32, unsigned integers as uint64 and enums as uint32.
+	*/
+	class RecordWriter {
+	public:
+		explicit RecordWriter(std::span<std::byte, TASK_DATA_RECORD_SIZE> record) : mRecord(record) {}
+
+		template <typename... Ts>
+		void operator()(const Ts&... values) {
+			(write(values), ...);
+		}
+
+		size_t position() const { return mPosition; }
+
+	private:
+		void put(const void* value, size_t size) {
+			if (size > mRecord.size() - mPosition) {
+				throw std::logic_error("A TaskData doesn't fit in TASK_DATA_RECORD_SIZE bytes");
+			}
+			std::memcpy(mRecord.data() + mPosition, value, size);
+			mPosition += size;
+		}
+
+		void write(bool value) {
+			const uint8_t byte = value ? 1 : 0;
+			put(&byte, 1);
+		}
+
+		void write(float value) {
+			put(&value, sizeof(value));
+		}
+
+		template <std::integral T>
+		void write(T value) {
+			if constexpr (std::is_signed_v<T>) {
+				const auto stored = static_cast<int32_t>(value);
+				put(&stored, sizeof(stored));
+			}
+			else {
+				const auto stored = static_cast<uint64_t>(value);
+				put(&stored, sizeof(stored));
+			}
+		}
+
+		template <typename E> requires std::is_enum_v<E>
+		void write(E value) {
+			const auto stored = static_cast<uint32_t>(value);
+			put(&stored, sizeof(stored));
+		}
+
+		template <typename T>
+		void write(const std::optional<T>& value) {
+			write(value.has_value());
+			write(value ? *value : T{});
+		}
+
+		void write(const SolarPanels& panels) {
+			const auto count = static_cast<uint32_t>(panels.size());
+			put(&count, sizeof(count));
+			for (size_t i = 0; i < TASK_DATA_RECORD_SOLAR_PANELS; i++) {
+				write(i < panels.size() ? panels[i] : SolarData{});
+			}
+		}
+
+		template <typename T> requires std::is_class_v<T>
+		void write(const T& value) {
+			visitFields(*this, value);
+		}
+
+		std::span<std::byte, TASK_DATA_RECORD_SIZE> mRecord;
+		size_t mPosition = 0;
+	};
+
+	/**
+	* Reads the values written by a RecordWriter, checking that each bool and enum holds one of its values
+	*/
+	class RecordReader {
+	public:
+		explicit RecordReader(std::span<const std::byte, TASK_DATA_RECORD_SIZE> record) : mRecord(record) {}
+
+		template <typename... Ts>
+		void operator()(Ts&... values) {
+			(read(values), ...);
+		}
+
+		size_t position() const { return mPosition; }
+
+	private:
+		void take(void* value, size_t size) {
+			if (size > mRecord.size() - mPosition) {
+				corrupt();
+			}
+			std::memcpy(value, mRecord.data() + mPosition, size);
+			mPosition += size;
+		}
+
+		void read(bool& value) {
+			uint8_t byte;
+			take(&byte, 1);
+			if (byte > 1) {
+				corrupt();
+			}
+			value = byte == 1;
+		}
+
+		void read(float& value) {
+			take(&value, sizeof(value));
+		}
+
+		template <std::integral T>
+		void read(T& value) {
+			if constexpr (std::is_signed_v<T>) {
+				int32_t stored;
+				take(&stored, sizeof(stored));
+				value = static_cast<T>(stored);
+			}
+			else {
+				uint64_t stored;
+				take(&stored, sizeof(stored));
+				value = static_cast<T>(stored);
+			}
+		}
+
+		template <typename E> requires std::is_enum_v<E>
+		void read(E& value) {
+			uint32_t stored;
+			take(&stored, sizeof(stored));
+			if (stored >= enumLimit(E{})) {
+				corrupt();
+			}
+			value = static_cast<E>(stored);
+		}
+
+		template <typename T>
+		void read(std::optional<T>& value) {
+			bool hasValue;
+			T fields{};
+			read(hasValue);
+			read(fields);
+			if (hasValue) {
+				value = fields;
+			}
+			else {
+				value.reset();
+			}
+		}
+
+		void read(SolarPanels& panels) {
+			uint32_t count;
+			take(&count, sizeof(count));
+			if (count > TASK_DATA_RECORD_SOLAR_PANELS) {
+				corrupt();
+			}
+			panels.clear();
+			for (size_t i = 0; i < TASK_DATA_RECORD_SOLAR_PANELS; i++) {
+				SolarData panel;
+				read(panel);
+				if (i < count) {
+					panels.push_back(panel);
+				}
+			}
+		}
+
+		template <typename T> requires std::is_class_v<T>
+		void read(T& value) {
+			visitFields(*this, value);
+		}
+
+		std::span<const std::byte, TASK_DATA_RECORD_SIZE> mRecord;
+		size_t mPosition = 0;
+	};
+}
+
+
+bool hasTaskDataRecord(const TaskData& taskData) {
+	return taskData.solar_panels.size() <= TASK_DATA_RECORD_SOLAR_PANELS;
+}
+
+void encodeTaskDataRecord(const TaskData& taskData, std::span<std::byte, TASK_DATA_RECORD_SIZE> record) {
+	requireLittleEndian();
+	if (!hasTaskDataRecord(taskData)) {
+		throw std::invalid_argument(std::format("A TaskData record holds at most {} solar panels, not {}",
+			TASK_DATA_RECORD_SOLAR_PANELS, taskData.solar_panels.size()));
+	}
+
+	RecordWriter writer(record);
+	writer(taskData);
+	if (writer.position() != TASK_DATA_RECORD_SIZE) {
+		throw std::logic_error("A TaskData doesn't fill TASK_DATA_RECORD_SIZE bytes");
+	}
+}
+
+TaskData decodeTaskDataRecord(std::span<const std::byte, TASK_DATA_RECORD_SIZE> record) {
+	requireLittleEndian();
+	TaskData taskData;
+	RecordReader reader(record);
+	reader(taskData);
+	return taskData;
+}
+
+std::vector<std::byte> encodeTaskDataBatch(std::span<const TaskData> tasks) {
+	TaskDataBatchHeader header{};
+	header.magic = TASK_DATA_BATCH_MAGIC;
+	header.version = TASK_DATA_BATCH_VERSION;
+	header.header_size = sizeof(TaskDataBatchHeader);
+	header.record_size = TASK_DATA_RECORD_SIZE;
+	header.count = tasks.size();
+
+	std::vector<std::byte> bytes(sizeof(TaskDataBatchHeader) + tasks.size() * TASK_DATA_RECORD_SIZE);
+	std::memcpy(bytes.data(), &header, sizeof(header));
+	for (size_t i = 0; i < tasks.size(); i++) {
+		encodeTaskDataRecord(tasks[i],
+			std::span<std::byte, TASK_DATA_RECORD_SIZE>(bytes.data() + sizeof(TaskDataBatchHeader) + i * TASK_DATA_RECORD_SIZE, TASK_DATA_RECORD_SIZE));
+	}
+	return bytes;
+}
+
+std::vector<TaskData> decodeTaskDataBatch(std::span<const std::byte> bytes) {
+	requireLittleEndian();
+
+	if (bytes.size() < sizeof(TaskDataBatchHeader)) {
+		throw std::runtime_error(std::format("The {} is too small to hold a header", CONTAINER));
+	}
+	TaskDataBatchHeader header;
+	std::memcpy(&header, bytes.data(), sizeof(header));
+
+	if (header.magic != TASK_DATA_BATCH_MAGIC) {
+		throw std::runtime_error("This is not a binary TaskData batch");
+	}
+	if (header.version != TASK_DATA_BATCH_VERSION) {
+		throw std::runtime_error(std::format(
+			"The {} is version {} but only version {} is supported",
+			CONTAINER, header.version, TASK_DATA_BATCH_VERSION
+		));
+	}
+	const size_t recordBytes = bytes.size() - sizeof(TaskDataBatchHeader);
+	if (header.header_size != sizeof(TaskDataBatchHeader) || header.record_size != TASK_DATA_RECORD_SIZE
+		|| recordBytes / TASK_DATA_RECORD_SIZE != header.count || recordBytes % TASK_DATA_RECORD_SIZE != 0) {
+		throw std::runtime_error(std::format("The {} is truncated or has a corrupt header", CONTAINER));
+	}
+
+	std::vector<TaskData> tasks;
+	tasks.reserve(header.count);
+	for (size_t i = 0; i < header.count; i++) {
+		tasks.push_back(decodeTaskDataRecord(std::span<const std::byte, TASK_DATA_RECORD_SIZE>(
+			bytes.data() + sizeof(TaskDataBatchHeader) + i * TASK_DATA_RECORD_SIZE, TASK_DATA_RECORD_SIZE)));
+	}
+	return tasks;
+}
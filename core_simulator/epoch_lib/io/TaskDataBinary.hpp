@@ -0,0 +1,61 @@
+/*
+logic for encoding TaskData as fixed-size binary records, for sending batches of scenarios without json
+*/
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "../Simulation/TaskData.hpp"
+
+/**
+* The binary TaskData record
+*
+* Every TaskData is encoded in the same TASK_DATA_RECORD_SIZE bytes, so a batch of them is a flat array
+* that can be indexed (and decoded in parallel) without parsing the records before it. All values are little-endian.
+* Each component is stored in the order of TaskData's fields, as a presence byte followed by every field
+* (the fields of a component that is absent are its defaults). size_t fields are stored as uint64 and enums as uint32.
+* The solar panels are stored as their count followed by TASK_DATA_RECORD_SOLAR_PANELS slots,
+* so a TaskData with more solar panels than that has no record.
+*/
+inline constexpr size_t TASK_DATA_RECORD_SOLAR_PANELS = SolarPanels::inline_capacity;
+inline constexpr size_t TASK_DATA_RECORD_SIZE = 311;
+
+/**
+* A batch of records is a TaskDataBatchHeader followed by count records
+*/
+inline constexpr std::array<char, 8> TASK_DATA_BATCH_MAGIC = { 'E', 'P', 'O', 'C', 'H', 'T', 'D', '\0' };
+inline constexpr uint32_t TASK_DATA_BATCH_VERSION = 1;
+
+struct TaskDataBatchHeader {
+	std::array<char, 8> magic;
+	uint32_t version;
+	uint32_t header_size;
+
+	uint32_t record_size;
+	uint32_t reserved;
+	uint64_t count;
+};
+
+static_assert(sizeof(TaskDataBatchHeader) == 32, "The TaskDataBatchHeader layout must not change within a version");
+
+
+// whether a TaskData can be encoded as a record (it has at most TASK_DATA_RECORD_SOLAR_PANELS solar panels)
+bool hasTaskDataRecord(const TaskData& taskData);
+
+/**
+* Encode a TaskData into a record, raising an invalid_argument if it has too many solar panels
+*/
+void encodeTaskDataRecord(const TaskData& taskData, std::span<std::byte, TASK_DATA_RECORD_SIZE> record);
+
+/**
+* Decode a record written by encodeTaskDataRecord, raising a runtime_error if it is corrupt
+*/
+TaskData decodeTaskDataRecord(std::span<const std::byte, TASK_DATA_RECORD_SIZE> record);
+
+std::vector<std::byte> encodeTaskDataBatch(std::span<const TaskData> tasks);
+
+std::vector<TaskData> decodeTaskDataBatch(std::span<const std::byte> bytes);
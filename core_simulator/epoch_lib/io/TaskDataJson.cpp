@@ -112,6 +112,12 @@ void from_json(const json& j, BatteryMode& mode) {
 	else if (str == "CONSUME_PLUS") {
 		mode = BatteryMode::CONSUME_PLUS;
 	}
+	else if (str == "PRICE_LOOKAHEAD") {
+		mode = BatteryMode::PRICE_LOOKAHEAD;
+	}
+	else if (str == "CARBON_LOOKAHEAD") {
+		mode = BatteryMode::CARBON_LOOKAHEAD;
+	}
 	else {
 		throw std::invalid_argument("Invalid Battery Mode - " + str);
 	}
@@ -56,6 +56,10 @@ void to_json(json& j, const HeatPumpData& hp);
 void from_json(const json& j, MopData& mop);
 void to_json(json& j, const MopData& mop);
 
+// SolarData
+void from_json(const json& j, SolarData& solar);
+void to_json(json& j, const SolarData& solar);
+
 // Renewables
 void from_json(const json& j, Renewables& renewables);
 void to_json(json& j, const Renewables& renewables);
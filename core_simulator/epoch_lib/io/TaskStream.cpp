@@ -0,0 +1,198 @@
+#include "TaskStream.hpp"
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <semaphore>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include <nlohmann/json.hpp>
+
+#include "OnDemandJson.hpp"
+#include "ResultJson.hpp"
+#include "TaskDataJson.hpp"
+
+std::optional<std::string> readFrame(std::istream& in) {
+	std::array<unsigned char, 4> prefix{};
+	if (!in.read(reinterpret_cast<char*>(prefix.data()), prefix.size())) {
+		if (in.gcount() == 0) {
+			return std::nullopt;
+		}
+		throw std::runtime_error("Truncated length prefix in the task stream");
+	}
+	const uint32_t length = prefix[0] | (prefix[1] << 8) | (prefix[2] << 16) | (static_cast<uint32_t>(prefix[3]) << 24);
+	if (length > MAX_FRAME_BYTES) {
+		throw std::runtime_error("Message in the task stream exceeds the maximum length");
+	}
+	std::string message(length, '\0');
+	if (!in.read(message.data(), length)) {
+		throw std::runtime_error("Truncated message in the task stream");
+	}
+	return message;
+}
+
+void writeFrame(std::ostream& out, std::string_view message) {
+	const auto length = static_cast<uint32_t>(message.size());
+	const std::array<char, 4> prefix = {
+		static_cast<char>(length & 0xFF), static_cast<char>((length >> 8) & 0xFF),
+		static_cast<char>((length >> 16) & 0xFF), static_cast<char>((length >> 24) & 0xFF)
+	};
+	out.write(prefix.data(), prefix.size());
+	out.write(message.data(), static_cast<std::streamsize>(message.size()));
+	out.flush();
+}
+
+namespace {
+	std::optional<std::string> readMessage(std::istream& in, StreamFraming framing) {
+		std::string message;
+
+		if (framing == StreamFraming::Lines) {
+			while (std::getline(in, message)) {
+				if (!message.empty() && message.back() == '\r') {
+					message.pop_back();
+				}
+				// skip blank lines
+				if (message.find_first_not_of(" \t") != std::string::npos) {
+					return message;
+				}
+			}
+			return std::nullopt;
+		}
+
+		return readFrame(in);
+	}
+
+	void writeMessage(std::ostream& out, const std::string& message, StreamFraming framing) {
+		if (framing == StreamFraming::Lines) {
+			out << message << '\n';
+			out.flush();
+		}
+		else {
+			writeFrame(out, message);
+		}
+	}
+
+	std::string evaluate(const Simulator& simulator, const std::string& message) {
+		try {
+			const TaskData taskData = parseTaskDataJson(message);
+			return json(simulator.simulateScenario(taskData)).dump();
+		}
+		catch (const std::exception& e) {
+			return json{ {"error", e.what()} }.dump();
+		}
+	}
+
+	/**
+	* The results that have been submitted but not yet written, in the order they were read
+	*/
+	class PendingResults {
+	public:
+		void push(std::future<std::string> result) {
+			{
+				std::lock_guard<std::mutex> lock(mMutex);
+				mResults.push_back(std::move(result));
+			}
+			mChanged.notify_one();
+		}
+
+		void finish() {
+			{
+				std::lock_guard<std::mutex> lock(mMutex);
+				mFinished = true;
+			}
+			mChanged.notify_one();
+		}
+
+		// the next result to write, or nullopt once the input is finished and everything has been written
+		std::optional<std::future<std::string>> pop() {
+			std::unique_lock<std::mutex> lock(mMutex);
+			mChanged.wait(lock, [this] { return mFinished || !mResults.empty(); });
+			if (mResults.empty()) {
+				return std::nullopt;
+			}
+			auto result = std::move(mResults.front());
+			mResults.pop_front();
+			return result;
+		}
+
+	private:
+		std::mutex mMutex;
+		std::condition_variable mChanged;
+		std::deque<std::future<std::string>> mResults;
+		bool mFinished = false;
+	};
+}
+
+
+void serveTaskStream(const Simulator& simulator, std::istream& in, std::ostream& out, ThreadPool& pool,
+	const TaskStreamOptions& options)
+{
+	const size_t maxInFlight = options.maxInFlight > 0 ? options.maxInFlight : 2 * pool.size();
+	std::counting_semaphore<> slots(static_cast<std::ptrdiff_t>(maxInFlight));
+	PendingResults pending;
+
+	// the output is written from another thread, so reading must not flush it (as std::cin does to std::cout)
+	std::ostream* tied = in.tie(nullptr);
+
+	// results are written from a separate thread so that they are not held back waiting for more input
+	std::exception_ptr writeError;
+	std::atomic<bool> writeFailed{ false };
+	std::thread writer([&] {
+		while (auto result = pending.pop()) {
+			try {
+				if (!writeFailed) {
+					writeMessage(out, result->get(), options.framing);
+					if (!out) {
+						throw std::runtime_error("Failed to write to the result stream");
+					}
+				}
+			}
+			catch (...) {
+				writeError = std::current_exception();
+				writeFailed = true;
+			}
+			slots.release();
+		}
+	});
+
+	std::exception_ptr readError;
+	try {
+		// stop reading once the output is broken, as nothing more can be returned
+		while (!writeFailed) {
+			auto message = readMessage(in, options.framing);
+			if (!message) {
+				break;
+			}
+			slots.acquire();
+
+			auto task = std::make_shared<std::packaged_task<std::string()>>(
+				[&simulator, message = std::move(*message)] { return evaluate(simulator, message); });
+			pending.push(task->get_future());
+			pool.submit([task] { (*task)(); });
+		}
+	}
+	catch (...) {
+		readError = std::current_exception();
+	}
+
+	// write everything that has already been read before reporting any error
+	pending.finish();
+	writer.join();
+	in.tie(tied);
+
+	if (readError) {
+		std::rethrow_exception(readError);
+	}
+	if (writeError) {
+		std::rethrow_exception(writeError);
+	}
+}
@@ -0,0 +1,54 @@
+/*
+logic for evaluating a stream of TaskData against a single Simulator
+*/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+#include "../Simulation/Simulate.hpp"
+#include "../Simulation/ThreadPool.hpp"
+
+/**
+* How each message is delimited on the input and output streams
+*
+* Lines: one compact JSON document per line
+* LengthPrefixed: a 4-byte little-endian length followed by that many bytes of JSON
+*/
+enum class StreamFraming { Lines, LengthPrefixed };
+
+struct TaskStreamOptions {
+	StreamFraming framing = StreamFraming::Lines;
+	// the most tasks that can be read but not yet written; 0 uses twice the size of the pool
+	size_t maxInFlight = 0;
+};
+
+// the largest message accepted in the length-prefixed framing
+constexpr uint32_t MAX_FRAME_BYTES = 64 << 20;
+
+/**
+* Read one length-prefixed message (a 4-byte little-endian length followed by that many bytes)
+* Returns nullopt at the end of the stream, and raises an exception if the message is truncated or too long
+*/
+std::optional<std::string> readFrame(std::istream& in);
+
+/**
+* Write one length-prefixed message and flush the output
+*/
+void writeFrame(std::ostream& out, std::string_view message);
+
+/**
+* Read TaskData from the input until it is exhausted, writing a result for each to the output
+*
+* Tasks are simulated in parallel on the pool, but the results are written in the order the tasks were read.
+* Each result is the compact JSON of the SimulationResult. A task that cannot be parsed produces
+* {"error": "..."} in its place rather than stopping the stream.
+* The output is flushed after every result, so a client can wait for each result before sending the next task.
+*/
+void serveTaskStream(const Simulator& simulator, std::istream& in, std::ostream& out, ThreadPool& pool,
+	const TaskStreamOptions& options = {});
@@ -0,0 +1,195 @@
+#include "TimeSeriesWriter.hpp"
+
+#include <charconv>
+#include <format>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+
+#ifdef EPOCH_PARQUET
+#include <arrow/api.h>
+#include <arrow/io/file.h>
+#include <parquet/arrow/writer.h>
+#endif
+
+#include "../Exceptions.hpp"
+
+/**
+* Accumulates output in a fixed-size buffer and writes it to the file in large blocks
+*/
+class BufferedFileWriter {
+public:
+	explicit BufferedFileWriter(const std::filesystem::path& filepath) :
+		mFilename(filepath.filename().string()),
+		mFile(filepath, std::ios::binary | std::ios::trunc),
+		mBuffer(BUFFER_SIZE)
+	{
+		if (!mFile.is_open()) {
+			spdlog::error("Failed to open the output file!");
+			throw FileWriteException(mFilename);
+		}
+	}
+
+	void write(std::string_view text) {
+		reserve(text.size());
+		text.copy(mBuffer.data() + mUsed, text.size());
+		mUsed += text.size();
+	}
+
+	void put(char c) {
+		reserve(1);
+		mBuffer[mUsed++] = c;
+	}
+
+	// write a float in the same form as std::to_string (%f)
+	void write(float value) {
+		reserve(MAX_FLOAT_CHARS);
+		auto [end, ec] = std::to_chars(mBuffer.data() + mUsed, mBuffer.data() + mBuffer.size(), value, std::chars_format::fixed, 6);
+		if (ec != std::errc{}) {
+			throw std::runtime_error("Failed to format a timeseries value");
+		}
+		mUsed = static_cast<size_t>(end - mBuffer.data());
+	}
+
+	// flush the buffer and check that everything was written
+	void close() {
+		flush();
+		mFile.close();
+		if (!mFile) {
+			throw FileWriteException(mFilename);
+		}
+	}
+
+private:
+	static constexpr size_t BUFFER_SIZE = 1 << 20;
+	// the longest float in fixed notation: a sign, 39 integer digits, the point and 6 decimals
+	static constexpr size_t MAX_FLOAT_CHARS = 48;
+
+	void reserve(size_t bytes) {
+		if (mUsed + bytes > mBuffer.size()) {
+			flush();
+		}
+	}
+
+	void flush() {
+		mFile.write(mBuffer.data(), static_cast<std::streamsize>(mUsed));
+		mUsed = 0;
+	}
+
+	std::string mFilename;
+	std::ofstream mFile;
+	std::vector<char> mBuffer;
+	size_t mUsed = 0;
+};
+
+
+void writeTimeSeries(const std::filesystem::path& filepath, const ReportData& reportData, TimeSeriesFormat format) {
+	switch (format) {
+	case TimeSeriesFormat::CSV:
+		writeTimeSeriesToCSV(filepath, reportData);
+		return;
+	case TimeSeriesFormat::Parquet:
+		writeTimeSeriesToParquet(filepath, reportData);
+		return;
+	}
+	throw std::invalid_argument("Unknown TimeSeriesFormat");
+}
+
+void writeTimeSeriesToCSV(const std::filesystem::path& filepath, const ReportData& reportData) {
+	TimeSeriesCSVStream stream(filepath);
+	stream.append(reportData);
+	stream.close();
+}
+
+TimeSeriesCSVStream::TimeSeriesCSVStream(const std::filesystem::path& filepath) :
+	mOut(std::make_unique<BufferedFileWriter>(filepath))
+{
+	// Write the column headers
+	for (size_t c = 0; c < TIMESERIES_COLUMNS.size(); c++) {
+		mOut->write(REPORT_COLUMN_NAMES[static_cast<size_t>(TIMESERIES_COLUMNS[c])]);
+		mOut->put(c + 1 < TIMESERIES_COLUMNS.size() ? ',' : '\n');
+	}
+}
+
+TimeSeriesCSVStream::~TimeSeriesCSVStream() = default;
+
+void TimeSeriesCSVStream::append(const ReportData& reportData) {
+	BufferedFileWriter& out = *mOut;
+
+	// absent columns are empty views
+	std::vector<ReportData::ConstColumnView> columns;
+	columns.reserve(TIMESERIES_COLUMNS.size());
+	for (ReportColumn column : TIMESERIES_COLUMNS) {
+		columns.push_back(reportData.get(column));
+	}
+
+	// Write the values row by row, reading across the column views
+	for (Eigen::Index i = 0; i < reportData.timesteps(); ++i) {
+		for (size_t c = 0; c < columns.size(); c++) {
+			if (columns[c].size() > i) {
+				out.write(columns[c][i]);
+			}
+			out.put(c + 1 < columns.size() ? ',' : '\n');
+		}
+	}
+}
+
+void TimeSeriesCSVStream::close() {
+	mOut->close();
+}
+
+#ifdef EPOCH_PARQUET
+
+void writeTimeSeriesToParquet(const std::filesystem::path& filepath, const ReportData& reportData) {
+	const std::string filename = filepath.filename().string();
+
+	std::vector<std::shared_ptr<arrow::Field>> fields;
+	std::vector<std::shared_ptr<arrow::Array>> arrays;
+	for (ReportColumn column : TIMESERIES_COLUMNS) {
+		if (!reportData.has(column)) {
+			continue;
+		}
+		auto view = reportData.get(column);
+		// the arrays borrow the ReportData's storage, which outlives the write
+		auto buffer = std::make_shared<arrow::Buffer>(
+			reinterpret_cast<const uint8_t*>(view.data()), static_cast<int64_t>(view.size() * sizeof(float)));
+		arrays.push_back(std::make_shared<arrow::FloatArray>(view.size(), std::move(buffer)));
+		fields.push_back(arrow::field(REPORT_COLUMN_NAMES[static_cast<size_t>(column)], arrow::float32(), false));
+	}
+
+	auto table = arrow::Table::Make(arrow::schema(fields), arrays, reportData.timesteps());
+
+	auto outfile = arrow::io::FileOutputStream::Open(filepath.string());
+	if (!outfile.ok()) {
+		spdlog::error("Failed to open the output file!");
+		throw FileWriteException(filename);
+	}
+
+	arrow::Status status = parquet::arrow::WriteTable(*table, arrow::default_memory_pool(), *outfile, reportData.timesteps());
+	if (status.ok()) {
+		status = (*outfile)->Close();
+	}
+	if (!status.ok()) {
+		throw std::runtime_error(std::format("Failed to write {}: {}", filename, status.ToString()));
+	}
+}
+
+bool parquetSupported() {
+	return true;
+}
+
+#else
+
+void writeTimeSeriesToParquet(const std::filesystem::path&, const ReportData&) {
+	throw std::runtime_error("Epoch was built without Parquet support (configure with -DEPOCH_PARQUET=ON)");
+}
+
+bool parquetSupported() {
+	return false;
+}
+
+#endif
@@ -0,0 +1,99 @@
+/*
+logic for writing the full timeseries of a simulation (the ReportData) to disk
+*/
+#pragma once
+
+#include <array>
+#include <filesystem>
+#include <memory>
+
+#include "../Definitions.hpp"
+
+enum class TimeSeriesFormat { CSV, Parquet };
+
+// The columns of the timeseries output, in the order they are written
+inline constexpr std::array<ReportColumn, 36> TIMESERIES_COLUMNS = {
+	ReportColumn::Actual_import_shortfall,
+	ReportColumn::Actual_curtailed_export,
+	ReportColumn::Heat_shortfall,
+	ReportColumn::Heat_surplus,
+	ReportColumn::Hotel_load,
+	ReportColumn::CH_demand,
+	ReportColumn::DHW_demand,
+	ReportColumn::Heatload,
+	ReportColumn::PVdcGen,
+	ReportColumn::PVacGen,
+	ReportColumn::EV_targetload,
+	ReportColumn::EV_actualload,
+	ReportColumn::ESS_charge,
+	ReportColumn::ESS_discharge,
+	ReportColumn::ESS_resulting_SoC,
+	ReportColumn::ESS_AuxLoad,
+	ReportColumn::ESS_RTL,
+	ReportColumn::Data_centre_target_load,
+	ReportColumn::Data_centre_actual_load,
+	ReportColumn::Data_centre_target_heat,
+	ReportColumn::Data_centre_available_hot_heat,
+	ReportColumn::Grid_Import,
+	ReportColumn::Grid_Export,
+	ReportColumn::MOP_load,
+	ReportColumn::GasCH_load,
+	ReportColumn::DHW_load,
+	ReportColumn::DHW_charging,
+	ReportColumn::DHW_SoC,
+	ReportColumn::DHW_Standby_loss,
+	ReportColumn::DHW_ave_temperature,
+	ReportColumn::DHW_Shortfall,
+	ReportColumn::ASHP_elec_load,
+	ReportColumn::ASHP_DHW_output,
+	ReportColumn::ASHP_CH_output,
+	ReportColumn::ASHP_free_heat,
+	ReportColumn::ASHP_used_hotroom_heat,
+};
+
+/**
+* Write the timeseries in the given format
+*/
+void writeTimeSeries(const std::filesystem::path& filepath, const ReportData& reportData, TimeSeriesFormat format);
+
+/**
+* Write every one of the TIMESERIES_COLUMNS as CSV
+*
+* Values are written with six decimal places and the columns for absent components are left empty.
+* The rows are formatted into a large reusable buffer, so this makes no allocations per value.
+*/
+void writeTimeSeriesToCSV(const std::filesystem::path& filepath, const ReportData& reportData);
+
+class BufferedFileWriter;
+
+/**
+* Write the TIMESERIES_COLUMNS as CSV one block of timesteps at a time (such as the windows of a ChunkedSimulator)
+*
+* The column headers are written when the file is opened, and the rows of each block are appended after those before it,
+* so the file is the same as writeTimeSeriesToCSV of every block laid end to end.
+*/
+class TimeSeriesCSVStream {
+public:
+	explicit TimeSeriesCSVStream(const std::filesystem::path& filepath);
+	~TimeSeriesCSVStream();
+
+	void append(const ReportData& reportData);
+
+	// flush the rows and check that everything was written
+	void close();
+
+private:
+	std::unique_ptr<BufferedFileWriter> mOut;
+};
+
+/**
+* Write the TIMESERIES_COLUMNS that are present as a Parquet file of float32 columns
+*
+* This requires Epoch to be built with EPOCH_PARQUET, and throws otherwise
+*/
+void writeTimeSeriesToParquet(const std::filesystem::path& filepath, const ReportData& reportData);
+
+/**
+* Whether this build of Epoch can write Parquet
+*/
+bool parquetSupported();
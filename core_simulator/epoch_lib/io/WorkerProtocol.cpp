@@ -0,0 +1,366 @@
+#include "WorkerProtocol.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <format>
+#include <mutex>
+#include <semaphore>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+#include <nlohmann/json.hpp>
+
+#include "BinaryArchive.hpp"
+#include "OnDemandJson.hpp"
+#include "SimulatorSnapshot.hpp"
+#include "TaskDataBinary.hpp"
+#include "TaskDataJson.hpp"
+#include "TaskStream.hpp"
+
+namespace {
+	constexpr const char* CONTAINER = "worker message";
+
+	std::span<const std::byte> asBytes(const std::string& message) {
+		return std::as_bytes(std::span<const char>(message.data(), message.size()));
+	}
+
+	// the payload written by write, with its length prefix
+	template <typename Write>
+	std::string encodeFrame(WorkerMessageType type, uint64_t requestId, Write&& write) {
+		std::ostringstream payload;
+		binary::Writer writer(payload);
+		writer(type, requestId);
+		write(writer);
+
+		std::ostringstream frame;
+		writeFrame(frame, payload.view());
+		return std::move(frame).str();
+	}
+
+	std::string encodeError(uint64_t requestId, const std::string& message) {
+		return encodeFrame(WorkerMessageType::Error, requestId, [&](binary::Writer& writer) { writer(message); });
+	}
+
+	std::string encodeResults(uint64_t requestId, const std::vector<SimulationResult>& results, TimeseriesEncoding encoding) {
+		return encodeFrame(WorkerMessageType::Results, requestId, [&](binary::Writer& writer) {
+			writer(static_cast<uint64_t>(results.size()));
+			for (const SimulationResult& result : results) {
+				const std::vector<std::byte> bytes = encodeResult(result, encoding);
+				writer(static_cast<uint64_t>(bytes.size()));
+				writer.writeBytes(bytes);
+			}
+		});
+	}
+
+	struct WorkerSite {
+		std::shared_ptr<const Simulator> simulator;
+		// set if the site was loaded with a site range, so that it can be sent chromosomes
+		std::shared_ptr<const ScenarioCodec> codec;
+	};
+
+	// a batch that has been read, to be decoded and simulated on the pool
+	struct WorkerBatch {
+		uint64_t requestId;
+		WorkerSite site;
+		SimulationType simulationType;
+		TimeseriesEncoding encoding;
+		std::vector<std::string> tasks;
+		std::optional<Chromosomes> chromosomes;
+		// the decoded TaskData of a SimulateTaskRecords request
+		std::optional<std::vector<TaskData>> records;
+	};
+
+	struct Reply {
+		std::string frame;
+		// whether this is the reply to a batch, which holds one of the in-flight slots until it is written
+		bool holdsSlot;
+	};
+
+	/**
+	* The replies waiting to be written, in the order they were finished
+	*/
+	class Replies {
+	public:
+		void push(Reply reply) {
+			{
+				std::lock_guard<std::mutex> lock(mMutex);
+				mReplies.push_back(std::move(reply));
+			}
+			mChanged.notify_one();
+		}
+
+		void finish() {
+			{
+				std::lock_guard<std::mutex> lock(mMutex);
+				mFinished = true;
+			}
+			mChanged.notify_one();
+		}
+
+		// the next reply to write, or nullopt once serving has finished and every reply has been written
+		std::optional<Reply> pop() {
+			std::unique_lock<std::mutex> lock(mMutex);
+			mChanged.wait(lock, [this] { return mFinished || !mReplies.empty(); });
+			if (mReplies.empty()) {
+				return std::nullopt;
+			}
+			Reply reply = std::move(mReplies.front());
+			mReplies.pop_front();
+			return reply;
+		}
+
+	private:
+		std::mutex mMutex;
+		std::condition_variable mChanged;
+		std::deque<Reply> mReplies;
+		bool mFinished = false;
+	};
+
+	std::vector<SimulationResult> simulate(const WorkerBatch& batch, ThreadPool& pool) {
+		if (batch.records) {
+			return batch.site.simulator->simulateBatch(*batch.records, batch.simulationType, pool);
+		}
+		std::vector<TaskData> taskData;
+		if (batch.chromosomes) {
+			taskData = batch.site.codec->decode(*batch.chromosomes);
+		}
+		else {
+			taskData.reserve(batch.tasks.size());
+			for (const std::string& task : batch.tasks) {
+				taskData.push_back(parseTaskDataJson(task));
+			}
+		}
+		return batch.site.simulator->simulateBatch(taskData, batch.simulationType, pool);
+	}
+}
+
+
+void serveWorker(std::map<std::string, std::shared_ptr<const Simulator>> simulators,
+	std::istream& in, std::ostream& out, ThreadPool& pool, const WorkerOptions& options)
+{
+	std::map<std::string, WorkerSite> sites;
+	for (auto& [name, simulator] : simulators) {
+		sites[name] = WorkerSite{ std::move(simulator), nullptr };
+	}
+
+	const size_t maxInFlight = options.maxInFlight > 0 ? options.maxInFlight : 2 * pool.size();
+	std::counting_semaphore<> slots(static_cast<std::ptrdiff_t>(maxInFlight));
+	Replies replies;
+
+	// the output is written from another thread, so reading must not flush it (as std::cin does to std::cout)
+	std::ostream* tied = in.tie(nullptr);
+
+	std::exception_ptr writeError;
+	std::atomic<bool> writeFailed{ false };
+	std::thread writer([&] {
+		while (auto reply = replies.pop()) {
+			try {
+				if (!writeFailed) {
+					// (the frame already has its length prefix)
+					out.write(reply->frame.data(), static_cast<std::streamsize>(reply->frame.size()));
+					out.flush();
+					if (!out) {
+						throw std::runtime_error("Failed to write to the worker's output");
+					}
+				}
+			}
+			catch (...) {
+				writeError = std::current_exception();
+				writeFailed = true;
+			}
+			if (reply->holdsSlot) {
+				slots.release();
+			}
+		}
+	});
+
+	std::exception_ptr readError;
+	try {
+		// stop reading once the output is broken, as nothing more can be returned
+		while (!writeFailed) {
+			auto message = readFrame(in);
+			if (!message) {
+				break;
+			}
+
+			uint64_t requestId = 0;
+			try {
+				binary::Reader reader(asBytes(*message), CONTAINER, "request");
+				WorkerMessageType type;
+				std::string site;
+				reader(type, requestId, site);
+
+				if (type == WorkerMessageType::LoadSimulator) {
+					uint64_t snapshotSize;
+					reader(snapshotSize);
+					const auto snapshot = reader.readBytes(snapshotSize);
+					std::optional<std::string> siteRange;
+					reader(siteRange);
+					reader.requireFinished();
+
+					sites[site] = WorkerSite{
+						restoreSimulator(snapshot), siteRange ? std::make_shared<const ScenarioCodec>(*siteRange) : nullptr };
+					replies.push({ encodeFrame(WorkerMessageType::Loaded, requestId, [](binary::Writer&) {}), false });
+					continue;
+				}
+				if (type != WorkerMessageType::SimulateTasks && type != WorkerMessageType::SimulateChromosomes
+					&& type != WorkerMessageType::SimulateTaskRecords) {
+					throw std::runtime_error(std::format("{} is not a worker request", static_cast<uint32_t>(type)));
+				}
+
+				auto it = sites.find(site);
+				if (it == sites.end()) {
+					throw std::runtime_error(std::format("No Simulator has been loaded for site {}", site));
+				}
+				WorkerBatch batch{ requestId, it->second, SimulationType::ResultOnly, TimeseriesEncoding::Float32, {}, std::nullopt, std::nullopt };
+				reader(batch.simulationType, batch.encoding);
+				if (batch.simulationType != SimulationType::ResultOnly && batch.simulationType != SimulationType::FullReporting) {
+					throw std::runtime_error(std::format("{} is not a SimulationType", static_cast<int>(batch.simulationType)));
+				}
+				if (static_cast<uint32_t>(batch.encoding) > static_cast<uint32_t>(TimeseriesEncoding::Delta)) {
+					throw std::runtime_error(std::format("{} is not a TimeseriesEncoding", static_cast<uint32_t>(batch.encoding)));
+				}
+
+				if (type == WorkerMessageType::SimulateTasks) {
+					reader(batch.tasks);
+				}
+				else if (type == WorkerMessageType::SimulateTaskRecords) {
+					uint64_t batchSize;
+					reader(batchSize);
+					batch.records = decodeTaskDataBatch(reader.readBytes(batchSize));
+				}
+				else {
+					if (!batch.site.codec) {
+						throw std::runtime_error(std::format("Site {} was loaded without a site range, so cannot decode chromosomes", site));
+					}
+					uint64_t rows;
+					uint64_t cols;
+					reader(rows, cols);
+					if (cols > message->size() || (cols != 0 && rows > message->size() / cols / sizeof(double))) {
+						throw std::runtime_error(std::format("The {} section of the {} is truncated", "request", CONTAINER));
+					}
+					Chromosomes& chromosomes = batch.chromosomes.emplace(static_cast<Eigen::Index>(rows), static_cast<Eigen::Index>(cols));
+					const auto values = reader.readBytes(rows * cols * sizeof(double));
+					std::memcpy(chromosomes.data(), values.data(), values.size());
+				}
+				reader.requireFinished();
+
+				slots.acquire();
+				auto shared = std::make_shared<WorkerBatch>(std::move(batch));
+				pool.submit([shared, &pool, &replies] {
+					std::string frame;
+					try {
+						frame = encodeResults(shared->requestId, simulate(*shared, pool), shared->encoding);
+						if (frame.size() > MAX_FRAME_BYTES + 4) {
+							frame = encodeError(shared->requestId, std::format(
+								"The results of {} scenarios are {} bytes, more than a frame can hold; send a smaller batch",
+								shared->chromosomes ? shared->chromosomes->rows() : static_cast<Eigen::Index>(shared->records ? shared->records->size() : shared->tasks.size()),
+								frame.size() - 4));
+						}
+					}
+					catch (const std::exception& e) {
+						frame = encodeError(shared->requestId, e.what());
+					}
+					replies.push({ std::move(frame), true });
+				});
+			}
+			catch (const std::exception& e) {
+				// a bad request is returned as an error, so the client can carry on
+				replies.push({ encodeError(requestId, e.what()), false });
+			}
+		}
+	}
+	catch (...) {
+		readError = std::current_exception();
+	}
+
+	// wait for every batch that has been read to be written before reporting any error
+	for (size_t i = 0; i < maxInFlight; i++) {
+		slots.acquire();
+	}
+	replies.finish();
+	writer.join();
+	in.tie(tied);
+
+	if (readError) {
+		std::rethrow_exception(readError);
+	}
+	if (writeError) {
+		std::rethrow_exception(writeError);
+	}
+}
+
+std::string encodeLoadRequest(uint64_t requestId, const std::string& site, std::span<const std::byte> snapshot,
+	const std::optional<std::string>& siteRange)
+{
+	return encodeFrame(WorkerMessageType::LoadSimulator, requestId, [&](binary::Writer& writer) {
+		writer(site, static_cast<uint64_t>(snapshot.size()));
+		writer.writeBytes(snapshot);
+		writer(siteRange);
+	});
+}
+
+std::string encodeTasksRequest(uint64_t requestId, const std::string& site, std::span<const TaskData> tasks,
+	SimulationType simulationType, TimeseriesEncoding encoding)
+{
+	return encodeFrame(WorkerMessageType::SimulateTasks, requestId, [&](binary::Writer& writer) {
+		writer(site, simulationType, encoding, static_cast<uint64_t>(tasks.size()));
+		for (const TaskData& task : tasks) {
+			writer(nlohmann::json(task).dump());
+		}
+	});
+}
+
+std::string encodeTaskRecordsRequest(uint64_t requestId, const std::string& site, std::span<const TaskData> tasks,
+	SimulationType simulationType, TimeseriesEncoding encoding)
+{
+	const std::vector<std::byte> records = encodeTaskDataBatch(tasks);
+	return encodeFrame(WorkerMessageType::SimulateTaskRecords, requestId, [&](binary::Writer& writer) {
+		writer(site, simulationType, encoding, static_cast<uint64_t>(records.size()));
+		writer.writeBytes(records);
+	});
+}
+
+std::string encodeChromosomesRequest(uint64_t requestId, const std::string& site, const Eigen::Ref<const Chromosomes>& chromosomes,
+	SimulationType simulationType, TimeseriesEncoding encoding)
+{
+	// (a copy, as the Ref may not be contiguous)
+	const Chromosomes values = chromosomes;
+	return encodeFrame(WorkerMessageType::SimulateChromosomes, requestId, [&](binary::Writer& writer) {
+		writer(site, simulationType, encoding, static_cast<uint64_t>(values.rows()), static_cast<uint64_t>(values.cols()));
+		writer.writeBytes(std::as_bytes(std::span<const double>(values.data(), static_cast<size_t>(values.size()))));
+	});
+}
+
+WorkerResponse decodeResponse(std::span<const std::byte> payload) {
+	binary::Reader reader(payload, CONTAINER, "reply");
+	WorkerResponse response{};
+	reader(response.type, response.request_id);
+
+	switch (response.type) {
+	case WorkerMessageType::Loaded:
+		break;
+	case WorkerMessageType::Results: {
+		uint64_t count;
+		reader(count);
+		for (uint64_t i = 0; i < count; i++) {
+			uint64_t size;
+			reader(size);
+			response.results.push_back(decodeResult(reader.readBytes(size)));
+		}
+		break;
+	}
+	case WorkerMessageType::Error:
+		reader(response.error);
+		break;
+	default:
+		throw std::runtime_error(std::format("{} is not a worker reply", static_cast<uint32_t>(response.type)));
+	}
+	reader.requireFinished();
+	return response;
+}
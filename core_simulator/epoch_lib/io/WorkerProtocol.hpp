@@ -0,0 +1,92 @@
+/*
+logic for evaluating batches of scenarios on a worker node, for spreading an optimisation across several machines
+*/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <map>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "../Definitions.hpp"
+#include "../Simulation/Simulate.hpp"
+#include "../Simulation/ThreadPool.hpp"
+#include "ResultBinary.hpp"
+#include "ScenarioCodec.hpp"
+
+/**
+* The worker protocol
+*
+* Every message is a frame (see readFrame): a 4-byte little-endian length followed by the payload.
+* Each payload starts with its WorkerMessageType and a request id chosen by the client, stored as in binary::Writer:
+* - LoadSimulator: the site name, the Simulator snapshot (see SimulatorSnapshot.hpp) and an optional site range,
+*   from which the site's ScenarioCodec is built so that chromosomes can be sent in place of TaskData
+* - SimulateTasks: the site name, the SimulationType, the TimeseriesEncoding and a list of TaskData json documents
+* - SimulateChromosomes: as SimulateTasks but with the rows, columns and values of a Chromosomes matrix
+* - SimulateTaskRecords: as SimulateTasks but with the byte size of a binary TaskData batch (see TaskDataBinary.hpp)
+*   and the batch, which is decoded without parsing any json
+*
+* The worker replies to every request with a frame of the same request id:
+* - Loaded, once the Simulator has been restored
+* - Results: a binary SimulationResult (see ResultBinary.hpp) for each scenario, in the order they were sent
+* - Error: a message, if the request could not be carried out (the worker carries on with the next request)
+*
+* Requests are pipelined: a client may send many before reading any replies, and the replies to batches are written
+* as each batch finishes, so they need not be in the order the requests were sent.
+*/
+enum class WorkerMessageType : uint32_t {
+	LoadSimulator = 1,
+	SimulateTasks = 2,
+	SimulateChromosomes = 3,
+	SimulateTaskRecords = 4,
+	Loaded = 101,
+	Results = 102,
+	Error = 103,
+};
+
+struct WorkerOptions {
+	// the most batches that may be simulated at once; once reached, the worker stops reading
+	// until one finishes, which pushes back on the client. 0 uses twice the size of the pool
+	size_t maxInFlight = 0;
+};
+
+/**
+* Serve the worker protocol until the input is exhausted, simulating each batch with simulateBatch on the pool
+* simulators holds any Simulators that are loaded before serving; LoadSimulator adds to (or replaces) them.
+* Every reply to a request that has been read is written before this returns.
+*/
+void serveWorker(std::map<std::string, std::shared_ptr<const Simulator>> simulators,
+	std::istream& in, std::ostream& out, ThreadPool& pool, const WorkerOptions& options = {});
+
+/**
+* The frames that a client sends (each with its length prefix)
+*/
+std::string encodeLoadRequest(uint64_t requestId, const std::string& site, std::span<const std::byte> snapshot,
+	const std::optional<std::string>& siteRange = std::nullopt);
+std::string encodeTasksRequest(uint64_t requestId, const std::string& site, std::span<const TaskData> tasks,
+	SimulationType simulationType = SimulationType::ResultOnly, TimeseriesEncoding encoding = TimeseriesEncoding::Float32);
+// every TaskData must have a binary record (see hasTaskDataRecord)
+std::string encodeTaskRecordsRequest(uint64_t requestId, const std::string& site, std::span<const TaskData> tasks,
+	SimulationType simulationType = SimulationType::ResultOnly, TimeseriesEncoding encoding = TimeseriesEncoding::Float32);
+std::string encodeChromosomesRequest(uint64_t requestId, const std::string& site, const Eigen::Ref<const Chromosomes>& chromosomes,
+	SimulationType simulationType = SimulationType::ResultOnly, TimeseriesEncoding encoding = TimeseriesEncoding::Float32);
+
+struct WorkerResponse {
+	WorkerMessageType type;
+	uint64_t request_id;
+	// the results of a batch, in the order its scenarios were sent
+	std::vector<SimulationResult> results;
+	// the message of an Error
+	std::string error;
+};
+
+/**
+* Decode the payload of a reply (without its length prefix)
+*/
+WorkerResponse decodeResponse(std::span<const std::byte> payload);
@@ -1,9 +1,17 @@
 #pragma once
 
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
 #include <argparse/argparse.hpp>
 #include <spdlog/spdlog.h>
 
 #include "../epoch_lib/Definitions.hpp"
+#include "../epoch_lib/io/ResultBinary.hpp"
+#include "../epoch_lib/io/TaskStream.hpp"
+#include "../epoch_lib/io/TimeSeriesWriter.hpp"
 
 
 enum class OutputFormat { Human, Json };
@@ -11,9 +19,32 @@ enum class OutputFormat { Human, Json };
 struct CommandlineArgs {
 	std::string inputDir;
 	std::string outputDir;
+	// overrides the siteData.json in the inputDir (this may be json or binary)
+	std::optional<std::string> siteDataPath;
+	// when set, convert the first (json) SiteData file to the binary format at the second path instead of simulating
+	std::optional<std::pair<std::string, std::string>> convertSiteData;
 	bool verbose = false;
 
 	OutputFormat format = OutputFormat::Human;
+	// the format of the FullTimeSeries file written to the outputDir
+	TimeSeriesFormat timeSeriesFormat = TimeSeriesFormat::CSV;
+	// when set, also write the result (with its timeseries in this encoding) to result.bin in the outputDir
+	std::optional<TimeseriesEncoding> binaryResult;
+	// when set, trace the run and write it to this path as a Chrome trace
+	std::optional<std::string> tracePath;
+	// when set, read the baseline from (or write it to) this directory rather than always simulating it
+	std::optional<std::string> baselineCacheDir;
+
+	// when set, read TaskData from stdin and write results to stdout until stdin is closed
+	bool serve = false;
+	TaskStreamOptions serveOptions;
+	// when set, serve the worker protocol (see WorkerProtocol.hpp) on stdin and stdout until stdin is closed
+	bool worker = false;
+
+	// when set, simulate every scenario in this site range instead of the TaskData
+	std::optional<std::string> searchPath;
+	size_t topK = 10;
+	std::optional<float> maxCapex;
 };
 
 
@@ -29,6 +60,59 @@ CommandlineArgs handleArgs(int argc, char* argv[]) {
 		.help("The directory to write all output files to")
 		.default_value(std::string("./OutputData"));
 
+	argParser.add_argument("--site-data")
+		.help("A SiteData file (json or binary) to use instead of siteData.json in the input directory");
+
+	argParser.add_argument("--convert-site-data")
+		.help("Convert a SiteData json file to the binary format and exit")
+		.nargs(2)
+		.metavar("JSON BINARY");
+
+	argParser.add_argument("--output-format")
+		.help("The format to write the full timeseries in")
+		.default_value(std::string("csv"))
+		.choices("csv", "parquet");
+
+	argParser.add_argument("--binary-result")
+		.help("Also write the result and its timeseries to result.bin, storing the timeseries in this encoding")
+		.choices("float32", "float16", "delta");
+
+	argParser.add_argument("--trace")
+		.help("Trace the run and write it as a Chrome trace json file (open it in Perfetto or chrome://tracing)");
+
+	argParser.add_argument("--baseline-cache")
+		.help("A directory in which to cache the simulated baseline of each site and config, so that it is only simulated once");
+
+	argParser.add_argument("--serve")
+		.help("Load the SiteData once, then simulate each TaskData read from stdin and write its result to stdout")
+		.flag();
+
+	argParser.add_argument("--framing")
+		.help("How --serve delimits each TaskData and result: one JSON document per line, or a 4-byte little-endian length before each")
+		.default_value(std::string("lines"))
+		.choices("lines", "length-prefixed");
+
+	argParser.add_argument("--worker")
+		.help("Serve the worker protocol on stdin and stdout, simulating the batches a client sends for the Simulators it loads")
+		.flag();
+
+	argParser.add_argument("--max-in-flight")
+		.help("The most tasks --serve (or batches --worker) will read ahead of the results it has written (0 for twice the number of threads)")
+		.default_value(size_t{ 0 })
+		.scan<'u', size_t>();
+
+	argParser.add_argument("--search")
+		.help("Simulate every combination of the values in a site range json file and keep the best scenarios for each objective");
+
+	argParser.add_argument("--top-k")
+		.help("The number of best scenarios --search keeps for each objective")
+		.default_value(size_t{ 10 })
+		.scan<'u', size_t>();
+
+	argParser.add_argument("--max-capex")
+		.help("Skip every scenario in --search whose capex is above this")
+		.scan<'g', float>();
+
 	// Enable verbose logging
 	argParser.add_argument("--verbose")
 		.help("Set logging to verbose")
@@ -50,6 +134,38 @@ CommandlineArgs handleArgs(int argc, char* argv[]) {
 	args.outputDir = argParser.get<std::string>("--output");
 	args.verbose = argParser.get<bool>("--verbose");
 
+	if (auto siteDataPath = argParser.present("--site-data")) {
+		args.siteDataPath = *siteDataPath;
+	}
+	if (auto convert = argParser.present<std::vector<std::string>>("--convert-site-data")) {
+		args.convertSiteData = std::make_pair((*convert)[0], (*convert)[1]);
+	}
+
+	args.timeSeriesFormat = argParser.get<std::string>("--output-format") == "parquet"
+		? TimeSeriesFormat::Parquet : TimeSeriesFormat::CSV;
+	if (auto binaryResult = argParser.present("--binary-result")) {
+		args.binaryResult = timeseriesEncodingFromString(*binaryResult);
+	}
+
+	if (auto tracePath = argParser.present("--trace")) {
+		args.tracePath = *tracePath;
+	}
+	if (auto baselineCacheDir = argParser.present("--baseline-cache")) {
+		args.baselineCacheDir = *baselineCacheDir;
+	}
+
+	args.serve = argParser.get<bool>("--serve");
+	args.serveOptions.framing = argParser.get<std::string>("--framing") == "length-prefixed"
+		? StreamFraming::LengthPrefixed : StreamFraming::Lines;
+	args.serveOptions.maxInFlight = argParser.get<size_t>("--max-in-flight");
+	args.worker = argParser.get<bool>("--worker");
+
+	if (auto searchPath = argParser.present("--search")) {
+		args.searchPath = *searchPath;
+	}
+	args.topK = argParser.get<size_t>("--top-k");
+	args.maxCapex = argParser.present<float>("--max-capex");
+
 	const bool jsonFlag = argParser.get<bool>("--json");
 
 	if (jsonFlag) {
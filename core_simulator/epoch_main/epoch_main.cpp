@@ -1,17 +1,37 @@
 #include "epoch_main.hpp"
+#include <fstream>
 #include <iostream>
+#include <sstream>
 #include <spdlog/spdlog.h>
+#include <spdlog/sinks/stdout_color_sinks.h>
 
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+#include "../epoch_lib/Optimisation/GridSearch.hpp"
 #include "../epoch_lib/Simulation/Simulate.hpp"
 #include "../epoch_lib/Simulation/TaskData.hpp"
+#include "../epoch_lib/Simulation/Trace.hpp"
+#include "../epoch_lib/io/EnumToString.hpp"
 #include "../epoch_lib/io/FileHandling.hpp"
+#include "../epoch_lib/io/GridSearchJson.hpp"
+#include "../epoch_lib/io/SiteDataBinary.hpp"
+#include "../epoch_lib/io/TaskStream.hpp"
 #include "../epoch_lib/io/TaskDataJson.hpp"
+#include "../epoch_lib/io/WorkerProtocol.hpp"
 #include "../epoch_lib/io/ToString.hpp"
 #include "../epoch_lib/io/SiteDataJson.hpp"
 #include "../epoch_lib/io/ResultJson.hpp"
 
 
 static void configureLogging(const CommandlineArgs& args) {
+	if (args.serve || args.worker) {
+		// stdout carries the results, so log to stderr instead
+		spdlog::set_default_logger(spdlog::stderr_color_mt("epoch"));
+	}
+
 	if (args.format == OutputFormat::Json) {
 		// JSON sets quiet mode for piping
 		spdlog::set_level(spdlog::level::off);
@@ -34,11 +54,40 @@ int main(int argc, char* argv[]) {
 
 		spdlog::info("Running Epoch version {}", EPOCH_VERSION);
 
-		FileConfig fileConfig{ args.inputDir, args.outputDir };
-		ConfigHandler configHandler(fileConfig.getConfigFilepath());
-		const EpochConfig config = configHandler.getConfig();
-
-		simulate(fileConfig, config, args);
+		if (args.convertSiteData) {
+			convertSiteData(args.convertSiteData->first, args.convertSiteData->second);
+			return 0;
+		}
+
+		if (args.tracePath) {
+			Tracer::start();
+		}
+
+		if (args.worker) {
+			// the client sends the Simulators, so nothing is read from the input directory
+			worker(args);
+		}
+		else {
+			FileConfig fileConfig{ args.inputDir, args.outputDir };
+			ConfigHandler configHandler(fileConfig.getConfigFilepath());
+			const EpochConfig config = configHandler.getConfig();
+
+			if (args.serve) {
+				serve(fileConfig, config, args);
+			}
+			else if (args.searchPath) {
+				search(fileConfig, config, args);
+			}
+			else {
+				simulate(fileConfig, config, args);
+			}
+		}
+
+		if (args.tracePath) {
+			Tracer::stop();
+			Tracer::writeChromeTrace(*args.tracePath);
+			spdlog::info("Wrote the trace to {}", *args.tracePath);
+		}
 	}
 	catch (const std::exception& e) {
 		spdlog::error(e.what());
@@ -47,20 +96,44 @@ int main(int argc, char* argv[]) {
 }
 
 
+// with --verbose, log what each part of the Simulator and the result holds, for sizing the workers that run them
+static void logMemoryFootprint(const Simulator& simulator, const SimulationResult& result) {
+	if (!spdlog::should_log(spdlog::level::debug)) {
+		return;
+	}
+	const MemoryFootprint footprint = simulator.memoryBreakdown();
+	for (const auto& part : footprint.parts) {
+		if (part.bytes > 0) {
+			spdlog::debug("Memory: {} {} bytes", part.name, part.bytes);
+		}
+	}
+	spdlog::debug("Memory: Simulator {} bytes, result {} bytes ({} without its report data)",
+		footprint.total(), result.memoryFootprint(), result.memoryFootprint(false));
+}
+
 void simulate(const FileConfig& fileConfig, const EpochConfig& config, const CommandlineArgs& args) {
 	spdlog::info("Loading Simulator");
 
-	SiteData siteData = readSiteData(fileConfig.getSiteDataFilepath());
+	SiteData siteData = readSiteData(args.siteDataPath ? std::filesystem::path(*args.siteDataPath) : fileConfig.getSiteDataFilepath());
 	TaskData taskData = readTaskData(fileConfig.getTaskDataFilepath());
 
 	Simulator simulator{ siteData, config.taskConfig };
+	if (args.baselineCacheDir) {
+		simulator.enableBaselineCache(*args.baselineCacheDir);
+	}
 
 	auto result = simulator.simulateScenario(taskData, SimulationType::FullReporting);
+	logMemoryFootprint(simulator, result);
 
 	// an invalid result will have no report data
 	if (result.report_data) {
-		auto fp = fileConfig.getOutputDir() / "FullTimeSeries.csv";
-		writeTimeSeriesToCSV(fp, *result.report_data);
+		const bool parquet = args.timeSeriesFormat == TimeSeriesFormat::Parquet;
+		auto fp = fileConfig.getOutputDir() / (parquet ? "FullTimeSeries.parquet" : "FullTimeSeries.csv");
+		writeTimeSeries(fp, *result.report_data, args.timeSeriesFormat);
+	}
+
+	if (args.binaryResult) {
+		writeResultBinary(fileConfig.getOutputDir() / "result.bin", result, *args.binaryResult);
 	}
 
 	if (args.format == OutputFormat::Json) {
@@ -71,3 +144,88 @@ void simulate(const FileConfig& fileConfig, const EpochConfig& config, const Com
 		spdlog::info(resultToString(result));
 	}
 }
+
+void search(const FileConfig& fileConfig, const EpochConfig& config, const CommandlineArgs& args) {
+	spdlog::info("Loading Simulator");
+
+	SiteData siteData = readSiteData(args.siteDataPath ? std::filesystem::path(*args.siteDataPath) : fileConfig.getSiteDataFilepath());
+	Simulator simulator{ siteData, config.taskConfig };
+	if (args.baselineCacheDir) {
+		simulator.enableBaselineCache(*args.baselineCacheDir);
+	}
+
+	// read the site range as text, as the order of its genes follows the order of its keys
+	std::ifstream siteRangeFile(*args.searchPath, std::ios::binary);
+	if (!siteRangeFile.is_open()) {
+		throw FileReadException(std::filesystem::path(*args.searchPath).filename().string());
+	}
+	std::ostringstream siteRange;
+	siteRange << siteRangeFile.rdbuf();
+
+	GridSearch gridSearch{ simulator, siteRange.str() };
+	spdlog::info("Searching {} scenarios", gridSearch.numScenarios());
+
+	GridSearchOptions options;
+	options.top_k = args.topK;
+	options.max_capex = args.maxCapex;
+	options.results_csv = fileConfig.getOutputCSVFilepath();
+
+	const GridSearchResult result = gridSearch.run(options);
+
+	nlohmann::json j = result;
+	writeJsonToFile(j, fileConfig.getOutputJsonFilepath());
+
+	if (args.format == OutputFormat::Json) {
+		std::cout << j.dump(2) << '\n';
+	}
+	else {
+		spdlog::info("Simulated {} scenarios and pruned {} in {:.2f}s", result.simulated, result.pruned, result.time_taken);
+		for (size_t i = 0; i < ALL_OBJECTIVES.size(); i++) {
+			if (!result.best[i].empty()) {
+				spdlog::info("Best {}: scenario {}", enumToString(ALL_OBJECTIVES[i]), result.best[i].front().scenario_index);
+			}
+		}
+		spdlog::info("{} scenarios are Pareto optimal", result.pareto.size());
+	}
+}
+
+void serve(const FileConfig& fileConfig, const EpochConfig& config, const CommandlineArgs& args) {
+	spdlog::info("Loading Simulator");
+
+	SiteData siteData = readSiteData(args.siteDataPath ? std::filesystem::path(*args.siteDataPath) : fileConfig.getSiteDataFilepath());
+	Simulator simulator{ siteData, config.taskConfig };
+	if (args.baselineCacheDir) {
+		simulator.enableBaselineCache(*args.baselineCacheDir);
+	}
+
+#ifdef _WIN32
+	// the length prefixes must not be altered by newline translation
+	_setmode(_fileno(stdin), _O_BINARY);
+	_setmode(_fileno(stdout), _O_BINARY);
+#endif
+	std::ios::sync_with_stdio(false);
+
+	spdlog::info("Serving TaskData from stdin");
+	serveTaskStream(simulator, std::cin, std::cout, ThreadPool::shared(), args.serveOptions);
+}
+
+void worker(const CommandlineArgs& args) {
+#ifdef _WIN32
+	// the length prefixes and snapshots must not be altered by newline translation
+	_setmode(_fileno(stdin), _O_BINARY);
+	_setmode(_fileno(stdout), _O_BINARY);
+#endif
+	std::ios::sync_with_stdio(false);
+
+	spdlog::info("Serving the worker protocol on stdin");
+	serveWorker({}, std::cin, std::cout, ThreadPool::shared(), WorkerOptions{ args.serveOptions.maxInFlight });
+}
+
+void convertSiteData(const std::filesystem::path& jsonPath, const std::filesystem::path& binaryPath) {
+	spdlog::info("Converting {} to binary SiteData", jsonPath.string());
+
+	SiteData siteData = readSiteData(jsonPath);
+	writeSiteDataBinary(siteData, binaryPath);
+
+	spdlog::info("Wrote {} ({} timesteps)", binaryPath.string(), siteData.timesteps);
+}
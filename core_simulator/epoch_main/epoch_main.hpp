@@ -2,6 +2,8 @@
 
 #include <mimalloc.h>
 
+#include <filesystem>
+
 #include "ArgHandling.hpp"
 #include "../epoch_lib/io/FileConfig.hpp"
 #include "../epoch_lib/io/EpochConfig.hpp"
@@ -10,3 +12,7 @@
 int apply_mimalloc = mi_version();
 
 static void simulate(const FileConfig& fileConfig, const EpochConfig& config, const CommandlineArgs& args);
+static void search(const FileConfig& fileConfig, const EpochConfig& config, const CommandlineArgs& args);
+static void serve(const FileConfig& fileConfig, const EpochConfig& config, const CommandlineArgs& args);
+static void worker(const CommandlineArgs& args);
+static void convertSiteData(const std::filesystem::path& jsonPath, const std::filesystem::path& binaryPath);
@@ -1,37 +1,361 @@
 #include "Bindings.hpp"
 
+#include <array>
+#include <chrono>
 #include <format>
+#include <numeric>
+#include <pybind11/critical_section.h>
 #include <pybind11/eigen.h>
 #include <pybind11/stl.h>
 #include <pybind11/stl/filesystem.h>
 #include <pybind11/native_enum.h>
+#include <span>
 #include <sstream>
+#include <string_view>
 
 #include "Simulate_py.hpp"
+#include "../epoch_lib/Simulation/ScenarioKey.hpp"
 #include "../epoch_lib/Simulation/TaskData.hpp"
 #include "../epoch_lib/Definitions.hpp"
+#include "../epoch_lib/io/ArrowExport.hpp"
 #include "../epoch_lib/io/EnumToString.hpp"
+#include "../epoch_lib/io/FileHandling.hpp"
+#include "../epoch_lib/io/OnDemandJson.hpp"
+#include "../epoch_lib/io/ResultBinary.hpp"
+#include "../epoch_lib/io/ResultTable.hpp"
+#include "../epoch_lib/io/SimulatorSnapshot.hpp"
+#include "../epoch_lib/io/SiteDataBinary.hpp"
+#include "../epoch_lib/io/TaskConfigJson.hpp"
+#include "../epoch_lib/io/TaskDataBinary.hpp"
 #include "../epoch_lib/io/TaskDataJson.hpp"
+#include "../epoch_lib/io/WorkerProtocol.hpp"
 #include "../epoch_lib/io/ToString.hpp"
+#include "../epoch_lib/Optimisation/NSGA2.hpp"
+#include "../epoch_lib/Optimisation/Pareto.hpp"
 #include "../epoch_lib/Portfolio/Portfolio.hpp"
+#include "../epoch_lib/Portfolio/PortfolioSimulator.hpp"
 #include "../epoch_lib/Simulation/Costs/CostData.hpp"
 #include "../epoch_lib/Simulation/Costs/Capex.hpp"
 #include "../epoch_lib/Simulation/Fabric.hpp"
+#include "../epoch_lib/Simulation/Trace.hpp"
 
 
-PYBIND11_MODULE(epoch_simulator, m) {
+namespace {
+	// a dict of site name to the snapshot of its Simulator, which is the pickled state of a PortfolioSimulator
+	pybind11::dict snapshotPortfolio(const PortfolioSimulator& portfolio) {
+		pybind11::dict snapshots;
+		for (const std::string& name : portfolio.siteNames()) {
+			std::vector<std::byte> bytes;
+			{
+				pybind11::gil_scoped_release release;
+				bytes = snapshotSimulator(portfolio.getSimulator(name));
+			}
+			snapshots[pybind11::str(name)] = pybind11::bytes(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+		}
+		return snapshots;
+	}
+
+	PortfolioSimulator restorePortfolio(const pybind11::dict& snapshots) {
+		std::map<std::string, std::shared_ptr<const Simulator>> simulators;
+		for (const auto& [name, snapshot] : snapshots) {
+			const std::string siteName = name.cast<std::string>();
+			const pybind11::bytes bytes = snapshot.cast<pybind11::bytes>();
+			const std::string_view view = bytes;
+			pybind11::gil_scoped_release release;
+			simulators.emplace(siteName, restoreSimulator(std::as_bytes(std::span(view.data(), view.size()))));
+		}
+		return PortfolioSimulator(std::move(simulators));
+	}
+
+	// a reference to a python object that C++ can drop from any thread (such as when an Arrow consumer releases an array)
+	std::shared_ptr<const void> keepAlive(pybind11::handle object) {
+		object.inc_ref();
+		return std::shared_ptr<const void>(object.ptr(), [](PyObject* ptr) {
+			pybind11::gil_scoped_acquire gil;
+			Py_DECREF(ptr);
+		});
+	}
+
+	// a capsule of the Arrow PyCapsule interface, which releases the structure unless a consumer has moved it out
+	template <typename T>
+	pybind11::capsule arrowCapsule(std::unique_ptr<T> exported, const char* name) {
+		return pybind11::capsule(exported.release(), name, [](PyObject* capsule) {
+			auto* exported = static_cast<T*>(PyCapsule_GetPointer(capsule, PyCapsule_GetName(capsule)));
+			if (exported->release) {
+				exported->release(exported);
+			}
+			delete exported;
+		});
+	}
+
+	/**
+	* Define the Arrow PyCapsule interface (__arrow_c_schema__, __arrow_c_array__ and __arrow_c_stream__) of a class
+	* makeExport makes the ArrowReportExport of an instance, which must keep the instance alive
+	* A requested_schema is ignored, as the columns are only ever exported as they are stored
+	*/
+	template <typename Class, typename MakeExport>
+	void defArrowExport(Class& cls, MakeExport makeExport) {
+		cls.def("__arrow_c_schema__", [makeExport](pybind11::handle self) {
+			auto schema = std::make_unique<ArrowSchema>();
+			makeExport(self).exportSchema(schema.get());
+			return arrowCapsule(std::move(schema), "arrow_schema");
+		});
+		cls.def("__arrow_c_array__", [makeExport](pybind11::handle self, pybind11::object) {
+			const ArrowReportExport source = makeExport(self);
+			auto schema = std::make_unique<ArrowSchema>();
+			source.exportSchema(schema.get());
+			pybind11::capsule schemaCapsule = arrowCapsule(std::move(schema), "arrow_schema");
+			auto array = std::make_unique<ArrowArray>();
+			source.exportArray(array.get());
+			return pybind11::make_tuple(schemaCapsule, arrowCapsule(std::move(array), "arrow_array"));
+		}, pybind11::arg("requested_schema") = pybind11::none());
+		cls.def("__arrow_c_stream__", [makeExport](pybind11::handle self, pybind11::object) {
+			auto stream = std::make_unique<ArrowArrayStream>();
+			makeExport(self).exportStream(stream.get());
+			return arrowCapsule(std::move(stream), "arrow_array_stream");
+		}, pybind11::arg("requested_schema") = pybind11::none());
+	}
+
+	// the timeseries of a result with the time of each timestep, which is exported to Arrow as a single record batch
+	struct ReportFrame {
+		pybind11::object reportData;
+		std::shared_ptr<const TimestampIndex> timestamps;
+	};
+}
+
+
+// The module can be used without the GIL (by a free-threaded build of python) and from subinterpreters with a GIL of their own.
+// Simulators can be shared between python threads (see Simulator_py::Shared), the results are read-only,
+// and the mutable objects that are changed in C++ (such as a ParetoArchive) lock themselves.
+PYBIND11_MODULE(epoch_simulator, m, pybind11::mod_gil_not_used(), pybind11::multiple_interpreters::per_interpreter_gil()) {
 	m.attr("__version__") = EPOCH_VERSION;
 
 	pybind11::class_<Simulator_py>(m, "Simulator")
 		.def_static("from_file", &Simulator_py::from_file, pybind11::arg("site_data_path"), pybind11::arg("config_path"))
 		.def_static("from_json", &Simulator_py::from_json, pybind11::arg("site_data_json_str"), pybind11::arg("config_json_str"))
+		.def_static("from_mapped_file", &Simulator_py::from_mapped_file, pybind11::arg("site_data_path"), pybind11::arg("config_path"))
+		.def_static("from_snapshot", &Simulator_py::from_snapshot, pybind11::arg("snapshot"))
+		.def("snapshot", &Simulator_py::snapshot)
+		.def(pybind11::pickle(
+			[](const Simulator_py& self) { return self.snapshot(); },
+			[](const pybind11::bytes& snapshot) { return Simulator_py::from_snapshot(snapshot); }
+		))
 		.def("simulate_scenario", &Simulator_py::simulateScenario,
 			pybind11::arg("taskData"),
-			pybind11::arg("fullReporting") = false)
+			pybind11::arg("fullReporting") = false,
+			pybind11::arg("constraints") = pybind11::none(),
+			pybind11::arg("columns") = pybind11::none())
+		.def("simulate_batch", &Simulator_py::simulateBatch,
+			pybind11::arg("taskData"),
+			pybind11::arg("fullReporting") = false,
+			pybind11::arg("constraints") = pybind11::none(),
+			pybind11::arg("control") = pybind11::none())
+		.def("simulate_task_batch", &Simulator_py::simulateTaskBatch,
+			pybind11::arg("batch"),
+			pybind11::arg("fullReporting") = false,
+			pybind11::arg("constraints") = pybind11::none(),
+			pybind11::arg("control") = pybind11::none())
+		.def("simulate_scenario_async", &Simulator_py::simulateScenarioAsync,
+			pybind11::arg("taskData"),
+			pybind11::arg("fullReporting") = false,
+			pybind11::arg("constraints") = pybind11::none(),
+			pybind11::arg("columns") = pybind11::none())
+		.def("simulate_batch_async", &Simulator_py::simulateBatchAsync,
+			pybind11::arg("taskData"),
+			pybind11::arg("fullReporting") = false,
+			pybind11::arg("constraints") = pybind11::none(),
+			pybind11::arg("control") = pybind11::none())
+		.def("simulate_all_tariffs", &Simulator_py::simulateAllTariffs, pybind11::arg("taskData"))
+		.def("bound_objectives", &Simulator_py::boundObjectives, pybind11::arg("taskData"))
+		.def("sweep_ess", &Simulator_py::sweepESS, pybind11::arg("taskData"), pybind11::arg("sizes"))
+		.def("simulate_configs", &Simulator_py::simulateConfigs, pybind11::arg("taskData"), pybind11::arg("configs"))
+		.def("days_of_interest", &Simulator_py::daysOfInterest, pybind11::arg("taskData"))
+		.def("sensitivities", &Simulator_py::sensitivities,
+			pybind11::arg("taskData"),
+			pybind11::arg("perturbations"),
+			pybind11::arg("central") = true)
+		.def("simulate_upgrade_tree", &Simulator_py::simulateUpgradeTree,
+			pybind11::arg("start"),
+			pybind11::arg("end"),
+			pybind11::arg("components") = pybind11::none())
+		.def("simulate_chromosomes", &Simulator_py::simulateChromosomes,
+			pybind11::arg("codec"),
+			pybind11::arg("chromosomes"),
+			pybind11::arg("fullReporting") = false,
+			pybind11::arg("constraints") = pybind11::none(),
+			pybind11::arg("control") = pybind11::none())
+		.def_static("is_tariff_independent", &Simulator::isTariffIndependent, pybind11::arg("taskData"))
 		.def("is_valid", &Simulator_py::isValid, pybind11::arg("taskData"))
+		.def("check_scenarios", &Simulator_py::checkScenarios, pybind11::arg("taskData"))
 		.def("calculate_capex", &Simulator_py::calculateCapexWithDiscounts, pybind11::arg("taskData"))
+		.def("with_config", &Simulator_py::withConfig, pybind11::arg("config"))
+		.def("with_ensemble", &Simulator_py::withEnsemble,
+			pybind11::kw_only(),
+			pybind11::arg("air_temperature") = pybind11::none(),
+			pybind11::arg("building_eload") = pybind11::none(),
+			pybind11::arg("building_hload") = pybind11::none(),
+			pybind11::arg("solar_yields") = std::vector<Eigen::MatrixXf>{})
+		.def("add_import_tariff", &Simulator_py::addImportTariff, pybind11::arg("tariff"))
+		.def("add_solar_yield", &Simulator_py::addSolarYield, pybind11::arg("solar_yield"))
+		.def("replace_columns", &Simulator_py::replaceColumns, pybind11::arg("columns"))
+		.def("simulate_ensemble", &Simulator_py::simulateEnsemble, pybind11::arg("taskData"), pybind11::arg("control") = pybind11::none())
+		.def("at_resolution", &Simulator_py::atResolution, pybind11::arg("interval_seconds"))
+		.def_property_readonly("timestamps", &Simulator_py::timestamps)
+		.def("report_frame",
+			[](const Simulator_py& self, pybind11::object reportData) {
+				ReportFrame frame{ reportData, self.acquire()->getTimestamps() };
+				// (which checks that there is a timestamp for every timestep)
+				ArrowReportExport(reportData.cast<const ReportData&>(), frame.timestamps, nullptr);
+				return frame;
+			},
+			pybind11::arg("report_data"))
+		.def_property_readonly("site_data_bytes", &Simulator_py::siteDataMemoryFootprint)
+		.def("memory_footprint", &Simulator_py::memoryFootprint)
+		.def("enable_baseline_cache", &Simulator_py::enableBaselineCache, pybind11::arg("directory"))
+		.def_property_readonly("has_baseline", &Simulator_py::hasBaseline)
+		.def("enable_result_cache", &Simulator_py::enableResultCache, pybind11::arg("max_bytes"))
+		.def("clear_result_cache", &Simulator_py::clearResultCache)
+		.def_property_readonly("result_cache_stats", &Simulator_py::resultCacheStats)
+		.def("enable_pre_balancing_cache", &Simulator_py::enablePreBalancingCache, pybind11::arg("max_bytes"))
+		.def("clear_pre_balancing_cache", &Simulator_py::clearPreBalancingCache)
+		.def_property_readonly("pre_balancing_cache_stats", &Simulator_py::preBalancingCacheStats)
+		.def("enable_parallel_ess", &Simulator_py::enableParallelESS)
+		.def("disable_parallel_ess", &Simulator_py::disableParallelESS)
+		.def("enable_low_latency", &Simulator_py::enableLowLatency)
+		.def("disable_low_latency", &Simulator_py::disableLowLatency)
+		.def("enable_batch_backend", &Simulator_py::enableBatchBackend, pybind11::arg("backend") = "cpu", pybind11::arg("device") = 0)
+		.def("disable_batch_backend", &Simulator_py::disableBatchBackend)
+		.def_property_readonly("batch_backend", &Simulator_py::batchBackend)
+		.def("enable_representative_days", &Simulator_py::enableRepresentativeDays, pybind11::arg("num_days"))
+		.def_property_readonly("representative_days", &Simulator_py::representativeDays)
+		.def("simulate_representative_days", &Simulator_py::simulateRepresentativeDays, pybind11::arg("taskData"))
+		.def("representative_days_error", &Simulator_py::representativeDaysError, pybind11::arg("sample"))
 		.def_readonly("config", &Simulator_py::config);
 
+	pybind11::class_<ScenarioCodec>(m, "ScenarioCodec")
+		.def(pybind11::init<const std::string&>(), pybind11::arg("site_range_json_str"))
+		.def_property_readonly("num_genes", &ScenarioCodec::numGenes)
+		.def_property_readonly("gene_sizes", &ScenarioCodec::geneSizes)
+		.def_property_readonly("gene_names", &ScenarioCodec::geneNames)
+		.def("decode", [](const ScenarioCodec& self, const Eigen::Ref<const Chromosomes>& chromosomes) {
+			return self.decode(chromosomes);
+		}, pybind11::arg("chromosomes"));
+
+	pybind11::class_<ScenarioConstraints>(m, "ScenarioConstraints")
+		.def(pybind11::init([](std::optional<float> minCapex, std::optional<float> maxCapex,
+			std::optional<float> maxElectricalShortfall, std::optional<float> maxHeatShortfall) {
+			return ScenarioConstraints{ minCapex, maxCapex, maxElectricalShortfall, maxHeatShortfall };
+		}), pybind11::kw_only(), pybind11::arg("min_capex") = pybind11::none(), pybind11::arg("max_capex") = pybind11::none(),
+			pybind11::arg("max_electrical_shortfall") = pybind11::none(), pybind11::arg("max_heat_shortfall") = pybind11::none())
+		.def_readwrite("min_capex", &ScenarioConstraints::min_capex)
+		.def_readwrite("max_capex", &ScenarioConstraints::max_capex)
+		.def_readwrite("max_electrical_shortfall", &ScenarioConstraints::max_electrical_shortfall)
+		.def_readwrite("max_heat_shortfall", &ScenarioConstraints::max_heat_shortfall);
+
+	pybind11::class_<RepresentativeDays>(m, "RepresentativeDays")
+		.def_readonly("timesteps_per_day", &RepresentativeDays::timestepsPerDay)
+		.def_readonly("days", &RepresentativeDays::days)
+		.def_readonly("weights", &RepresentativeDays::weights);
+
+	pybind11::class_<RepresentativeDaysError>(m, "RepresentativeDaysError")
+		.def_property_readonly("metric", [](const RepresentativeDaysError& self) { return std::string(self.metric); })
+		.def_readonly("max_absolute_error", &RepresentativeDaysError::max_absolute_error)
+		.def_readonly("max_relative_error", &RepresentativeDaysError::max_relative_error);
+
+	// the bits of each mask returned by Simulator.check_scenarios
+	pybind11::native_enum<ScenarioError>(m, "ScenarioError", "enum.IntFlag", "The reasons a scenario cannot be simulated with a site's data")
+		.value("FabricInterventionIndex", ScenarioError::FabricInterventionIndex)
+		.value("TariffIndex", ScenarioError::TariffIndex)
+		.value("YieldIndex", ScenarioError::YieldIndex)
+		.finalize();
+
+	pybind11::native_enum<SensitivityParameter>(m, "SensitivityParameter", "enum.Enum", "The continuous parameters a scenario can be perturbed in")
+		.value("ESSCapacity", SensitivityParameter::ESSCapacity)
+		.value("ESSChargePower", SensitivityParameter::ESSChargePower)
+		.value("ESSDischargePower", SensitivityParameter::ESSDischargePower)
+		.value("HeatPower", SensitivityParameter::HeatPower)
+		.value("YieldScalar", SensitivityParameter::YieldScalar)
+		.value("GridImport", SensitivityParameter::GridImport)
+		.finalize();
+
+	pybind11::class_<Perturbation>(m, "Perturbation")
+		.def(pybind11::init([](SensitivityParameter parameter, float step, size_t panel) {
+			return Perturbation{ parameter, step, panel };
+		}), pybind11::arg("parameter"), pybind11::arg("step"), pybind11::arg("panel") = 0)
+		.def_readwrite("parameter", &Perturbation::parameter)
+		.def_readwrite("step", &Perturbation::step)
+		.def_readwrite("panel", &Perturbation::panel);
+
+	pybind11::class_<SensitivityResult>(m, "SensitivityResult")
+		.def_property_readonly("objectives", [](const SensitivityResult&) {
+			return std::vector<std::string>(OBJECTIVE_FIELD_NAMES.begin(), OBJECTIVE_FIELD_NAMES.end());
+		})
+		.def_property_readonly("base", [](const SensitivityResult& self) { return objectiveFields(self.base); })
+		.def_readonly("jacobian", &SensitivityResult::jacobian)
+		.def_readonly("reused_pre_balancing", &SensitivityResult::reused_pre_balancing);
+
+	pybind11::class_<DaysOfInterest>(m, "DaysOfInterest")
+		.def_property_readonly("categories", [](const DaysOfInterest&) {
+			return std::vector<std::string>(DAY_OF_INTEREST_NAMES.begin(), DAY_OF_INTEREST_NAMES.end());
+		})
+		.def_property_readonly("days", [](const DaysOfInterest& self) {
+			std::map<std::string, std::optional<size_t>> days;
+			for (size_t c = 0; c < NUM_DAYS_OF_INTEREST; c++) {
+				days.emplace(DAY_OF_INTEREST_NAMES[c], self.days[c]);
+			}
+			return days;
+		})
+		.def_readonly("daily", &DaysOfInterest::daily)
+		.def_readonly("day_starts", &DaysOfInterest::day_starts);
+
+	pybind11::class_<ObjectiveBounds>(m, "ObjectiveBounds")
+		.def_readonly("total_capex", &ObjectiveBounds::total_capex)
+		.def_readonly("total_annualised_cost", &ObjectiveBounds::total_annualised_cost)
+		.def_readonly("cost_balance", &ObjectiveBounds::cost_balance)
+		.def_readonly("operating_balance", &ObjectiveBounds::operating_balance)
+		.def_readonly("combined_carbon_balance", &ObjectiveBounds::combined_carbon_balance)
+		.def_readonly("payback_horizon_years", &ObjectiveBounds::payback_horizon_years)
+		.def_readonly("invalid", &ObjectiveBounds::invalid);
+
+	pybind11::class_<EnsembleStatistics>(m, "EnsembleStatistics")
+		.def_readonly("mean", &EnsembleStatistics::mean)
+		.def_readonly("min", &EnsembleStatistics::min)
+		.def_readonly("max", &EnsembleStatistics::max)
+		.def_readonly("p10", &EnsembleStatistics::p10)
+		.def_readonly("p50", &EnsembleStatistics::p50)
+		.def_readonly("p90", &EnsembleStatistics::p90);
+
+	pybind11::class_<EnsembleResult>(m, "EnsembleResult")
+		.def_property_readonly("objectives", [](const EnsembleResult&) {
+			return std::vector<std::string>(OBJECTIVE_FIELD_NAMES.begin(), OBJECTIVE_FIELD_NAMES.end());
+		})
+		.def_readonly("member_objectives", &EnsembleResult::objectives)
+		.def_readonly("simulated_members", &EnsembleResult::simulated_members)
+		.def_property_readonly("statistics", [](const EnsembleResult& self) {
+			return std::vector<EnsembleStatistics>(self.statistics.begin(), self.statistics.end());
+		});
+
+	// every member is an atomic, so these never block the batch that is using it
+	pybind11::class_<BatchControl>(m, "BatchControl")
+		.def(pybind11::init<>())
+		.def("cancel", &BatchControl::cancel)
+		.def("set_timeout", [](BatchControl& self, double seconds) {
+			self.setTimeout(std::chrono::duration_cast<BatchControl::Clock::duration>(std::chrono::duration<double>(seconds)));
+		}, pybind11::arg("seconds"))
+		.def_property_readonly("cancelled", &BatchControl::cancelled)
+		.def_property_readonly("stop_requested", &BatchControl::stopRequested)
+		.def_property_readonly("total", &BatchControl::total)
+		.def_property_readonly("completed", &BatchControl::completed)
+		.def_property_readonly("skipped", &BatchControl::skipped);
+
+	pybind11::class_<CacheStats>(m, "CacheStats")
+		.def_readonly("hits", &CacheStats::hits)
+		.def_readonly("misses", &CacheStats::misses)
+		.def_readonly("evictions", &CacheStats::evictions)
+		.def_readonly("entries", &CacheStats::entries)
+		.def_readonly("bytes", &CacheStats::bytes)
+		.def_readonly("byte_budget", &CacheStats::byte_budget);
+
 	pybind11::class_<TaskData>(m, "TaskData")
 		.def(pybind11::init<>())
 		.def_readwrite("building", &TaskData::building)
@@ -43,10 +367,12 @@ PYBIND11_MODULE(epoch_simulator, m) {
 		.def_readwrite("grid", &TaskData::grid)
 		.def_readwrite("heat_pump", &TaskData::heat_pump)
 		.def_readwrite("mop", &TaskData::mop)
-		.def_readwrite("solar_panels", &TaskData::solar_panels)
+		// (as a list, like the other list fields: the panels of a TaskData are held inline, see SolarPanels)
+		.def_property("solar_panels",
+			[](const TaskData& self) { return std::vector<SolarData>(self.solar_panels.begin(), self.solar_panels.end()); },
+			[](TaskData& self, const std::vector<SolarData>& panels) { self.solar_panels = panels; })
 		.def_static("from_json", [](const std::string& json_str) {
-			nlohmann::json j = nlohmann::json::parse(json_str);
-			return j.get<TaskData>();
+			return parseTaskDataJson(json_str);
 		})
 		.def("to_json", [](const TaskData& self) {
 			nlohmann::json j = self;
@@ -54,6 +380,28 @@ PYBIND11_MODULE(epoch_simulator, m) {
 		})
 		.def("__repr__", &taskDataToString)
 		.def("__hash__", [](const TaskData& self){ return std::hash<TaskData>{}(self);})
+		// a key that is the same in every process and on every platform, for caches shared between workers
+		.def("scenario_key", [](const TaskData& self, int mantissaBits) {
+			return scenarioKey(self, KeyQuantisation{ mantissaBits }).toHex();
+		}, pybind11::arg("mantissa_bits") = 23)
+		.def("canonical_bytes", [](const TaskData& self, int mantissaBits) {
+			const std::vector<std::byte> bytes = canonicalEncoding(self, KeyQuantisation{ mantissaBits });
+			return pybind11::bytes(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+		}, pybind11::arg("mantissa_bits") = 23)
+		// the fixed-size binary record (see TaskDataBinary.hpp)
+		.def("to_record", [](const TaskData& self) {
+			std::array<std::byte, TASK_DATA_RECORD_SIZE> record;
+			encodeTaskDataRecord(self, record);
+			return pybind11::bytes(reinterpret_cast<const char*>(record.data()), record.size());
+		})
+		.def_static("from_record", [](const pybind11::bytes& record) {
+			const std::string_view view = record;
+			if (view.size() != TASK_DATA_RECORD_SIZE) {
+				throw pybind11::value_error(std::format("A TaskData record is {} bytes, not {}", TASK_DATA_RECORD_SIZE, view.size()));
+			}
+			return decodeTaskDataRecord(std::span<const std::byte, TASK_DATA_RECORD_SIZE>(
+				reinterpret_cast<const std::byte*>(view.data()), TASK_DATA_RECORD_SIZE));
+		}, pybind11::arg("record"))
 		.def("__eq__", &TaskData::operator==);
 
 	pybind11::class_<Building>(m, "Building")
@@ -110,7 +458,9 @@ PYBIND11_MODULE(epoch_simulator, m) {
 
 	pybind11::enum_<BatteryMode>(m, "BatteryMode")
 		.value("CONSUME", BatteryMode::CONSUME)
-		.value("CONSUME_PLUS", BatteryMode::CONSUME_PLUS);
+		.value("CONSUME_PLUS", BatteryMode::CONSUME_PLUS)
+		.value("PRICE_LOOKAHEAD", BatteryMode::PRICE_LOOKAHEAD)
+		.value("CARBON_LOOKAHEAD", BatteryMode::CARBON_LOOKAHEAD);
 
 	pybind11::class_<GasCHData>(m, "GasHeater")
 		.def(pybind11::init<>())
@@ -184,11 +534,63 @@ PYBIND11_MODULE(epoch_simulator, m) {
 		.def_readwrite("comparison", &SimulationResult::comparison)
 		.def_readwrite("metrics", &SimulationResult::metrics)
 		.def_readwrite("baseline_metrics", &SimulationResult::baseline_metrics)
+		.def_readwrite("violates_constraints", &SimulationResult::violates_constraints)
+		.def_readwrite("cancelled", &SimulationResult::cancelled)
+		.def_readwrite("terminated_early", &SimulationResult::terminated_early)
 		.def_readwrite("scenario_capex_breakdown", &SimulationResult::scenario_capex_breakdown)
-		.def_readwrite("report_data", &SimulationResult::report_data)
-		.def_readwrite("baseline_report_data", &SimulationResult::baseline_report_data)
+		// return the ReportData by reference so that its timeseries can be viewed without copying
+		.def_property("report_data",
+			[](const SimulationResult& r) { return r.report_data ? &r.report_data.value() : nullptr; },
+			[](SimulationResult& r, std::optional<ReportData> reportData) { r.report_data = std::move(reportData); },
+			pybind11::return_value_policy::reference_internal)
+		.def_property("baseline_report_data",
+			// the baseline is shared by every result from the same Simulator, so hand out the shared handle
+			[](const SimulationResult& r) { return std::const_pointer_cast<ReportData>(r.baseline_report_data); },
+			[](SimulationResult& r, std::shared_ptr<ReportData> reportData) { r.baseline_report_data = std::move(reportData); })
+		.def_readonly("runtime", &SimulationResult::runtime)
+		.def_readonly("timings", &SimulationResult::timings)
+		.def("memory_footprint", &SimulationResult::memoryFootprint, pybind11::arg("include_report_data") = true)
+		// the compact binary form of the result (see ResultBinary.hpp), with the timeseries as "float32", "float16" or "delta"
+		.def("to_bytes",
+			[](const SimulationResult& r, std::string_view encoding, bool includeBaseline) {
+				const TimeseriesEncoding timeseriesEncoding = timeseriesEncodingFromString(encoding);
+				std::vector<std::byte> bytes;
+				{
+					pybind11::gil_scoped_release release;
+					bytes = encodeResult(r, timeseriesEncoding, includeBaseline);
+				}
+				return pybind11::bytes(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+			},
+			pybind11::arg("encoding") = "float32", pybind11::arg("include_baseline") = false)
+		.def_static("from_bytes",
+			[](const pybind11::bytes& bytes) {
+				const std::string_view view = bytes;
+				pybind11::gil_scoped_release release;
+				return decodeResult(std::as_bytes(std::span(view.data(), view.size())));
+			},
+			pybind11::arg("bytes"))
 		.def("__repr__", &resultToString);
 
+	pybind11::class_<PhaseTimings>(m, "PhaseTimings")
+		.def_readonly("validation", &PhaseTimings::validation)
+		.def_readonly("hotel", &PhaseTimings::hotel)
+		.def_readonly("pv", &PhaseTimings::pv)
+		.def_readonly("ev", &PhaseTimings::ev)
+		.def_readonly("hot_water_cylinder", &PhaseTimings::hot_water_cylinder)
+		.def_readonly("instant_water_heater", &PhaseTimings::instant_water_heater)
+		.def_readonly("heat_pump", &PhaseTimings::heat_pump)
+		.def_readonly("data_centre", &PhaseTimings::data_centre)
+		.def_readonly("ess", &PhaseTimings::ess)
+		.def_readonly("balancing_loop", &PhaseTimings::balancing_loop)
+		.def_readonly("gas_ch", &PhaseTimings::gas_ch)
+		.def_readonly("post_balancing", &PhaseTimings::post_balancing)
+		.def_readonly("totals", &PhaseTimings::totals)
+		.def_readonly("usage", &PhaseTimings::usage)
+		.def_readonly("metrics", &PhaseTimings::metrics)
+		.def_readonly("npv", &PhaseTimings::npv)
+		.def_readonly("comparison", &PhaseTimings::comparison)
+		.def_readonly("capex", &PhaseTimings::capex);
+
 	pybind11::class_<ScenarioComparison>(m, "ScenarioComparison")
 		.def_readwrite("meter_balance", &ScenarioComparison::meter_balance)
 		.def_readwrite("operating_balance", &ScenarioComparison::operating_balance)
@@ -248,50 +650,37 @@ PYBIND11_MODULE(epoch_simulator, m) {
 		.def_readwrite("environmental_impact_grade", &SimulationMetrics::environmental_impact_grade)
 		.def("__repr__", &metricsToString);
 
-	pybind11::class_<ReportData>(m, "ReportData")
-		.def_readonly("Actual_import_shortfall", &ReportData::Actual_import_shortfall)
-		.def_readonly("Actual_curtailed_export", &ReportData::Actual_curtailed_export)
-		.def_readonly("Heat_shortfall", &ReportData::Heat_shortfall)
-		.def_readonly("CH_shortfall", &ReportData::CH_shortfall)
-		.def_readonly("DHW_Shortfall", &ReportData::DHW_Shortfall)
-		.def_readonly("Heat_surplus", &ReportData::Heat_surplus)
-		.def_readonly("Hotel_load", &ReportData::Hotel_load)
-		.def_readonly("Heatload", &ReportData::Heatload)
-		.def_readonly("CH_demand", &ReportData::CH_demand)
-		.def_readonly("DHW_demand", &ReportData::DHW_demand)
-		.def_readonly("PVdcGen", &ReportData::PVdcGen)
-		.def_readonly("PVacGen", &ReportData::PVacGen)
-		.def_readonly("EV_targetload", &ReportData::EV_targetload)
-		.def_readonly("EV_actualload", &ReportData::EV_actualload)
-		.def_readonly("ESS_charge", &ReportData::ESS_charge)
-		.def_readonly("ESS_discharge", &ReportData::ESS_discharge)
-		.def_readonly("ESS_resulting_SoC", &ReportData::ESS_resulting_SoC)
-		.def_readonly("ESS_AuxLoad", &ReportData::ESS_AuxLoad)
-		.def_readonly("ESS_RTL", &ReportData::ESS_RTL)
-		.def_readonly("Data_centre_target_load", &ReportData::Data_centre_target_load)
-		.def_readonly("Data_centre_actual_load", &ReportData::Data_centre_actual_load)
-		.def_readonly("Data_centre_target_heat", &ReportData::Data_centre_target_heat)
-		.def_readonly("Data_centre_available_hot_heat", &ReportData::Data_centre_available_hot_heat)
-		.def_readonly("Grid_Import", &ReportData::Grid_Import)
-		.def_readonly("Grid_Export", &ReportData::Grid_Export)
-		.def_readonly("MOP_load", &ReportData::MOP_load)
-		.def_readonly("GasCH_load", &ReportData::GasCH_load)
-		.def_readonly("DHW_load", &ReportData::DHW_load)
-		.def_readonly("DHW_charging", &ReportData::DHW_charging)
-		.def_readonly("DHW_SoC", &ReportData::DHW_SoC)
-		.def_readonly("DHW_Standby_loss", &ReportData::DHW_Standby_loss)
-		.def_readonly("DHW_ave_temperature", &ReportData::DHW_ave_temperature)
-		.def_readonly("DHW_immersion_top_up", &ReportData::DHW_immersion_top_up)
-		.def_readonly("DHW_diverter_load", &ReportData::DHW_diverter_load)
-		.def_readonly("DHW_resistive_load", &ReportData::DHW_resistive_load)
-		.def_readonly("ASHP_elec_load", &ReportData::ASHP_elec_load)
-		.def_readonly("ASHP_DHW_output", &ReportData::ASHP_DHW_output)
-		.def_readonly("ASHP_CH_output", &ReportData::ASHP_CH_output)
-		.def_readonly("ASHP_free_heat", &ReportData::ASHP_free_heat)
-		.def_readonly("ASHP_used_hotroom_heat", &ReportData::ASHP_used_hotroom_heat)
-		.def_readonly("_TempSum_elec_e", &ReportData::_TempSum_elec_e)
-		.def_readonly("_TempSum_heat_h", &ReportData::_TempSum_heat_h)
-		.def_readonly("_TempSum_DHW_load_h", &ReportData::_TempSum_DHW_load_h);
+	pybind11::class_<ReportData, std::shared_ptr<ReportData>> reportData(m, "ReportData");
+	// Each timeseries is a read-only numpy view of the ReportData's storage (rather than a copy)
+	// the view keeps its ReportData alive (and for report_data, the owning SimulationResult)
+	for (size_t i = 0; i < NUM_REPORT_COLUMNS; i++) {
+		const ReportColumn column = static_cast<ReportColumn>(i);
+		reportData.def_property_readonly(REPORT_COLUMN_NAMES[i],
+			[column](const ReportData& rd) { return rd.get(column); },
+			pybind11::return_value_policy::reference_internal);
+	}
+	reportData.def("to_array",
+		[](const ReportData& rd) {
+			std::vector<std::string> columns;
+			for (ReportColumn column : rd.populatedColumns()) {
+				columns.emplace_back(REPORT_COLUMN_NAMES[static_cast<size_t>(column)]);
+			}
+			return std::make_pair(rd.populated(), std::move(columns));
+		},
+		pybind11::return_value_policy::reference_internal,
+		"Return a read-only (timesteps x columns) view of the populated timeseries and the list of column names");
+	// a ReportData is an Arrow record batch of its populated columns, which views its storage (and keeps it alive)
+	defArrowExport(reportData, [](pybind11::handle self) {
+		return ArrowReportExport(self.cast<const ReportData&>(), nullptr, keepAlive(self));
+	});
+
+	pybind11::class_<ReportFrame> reportFrame(m, "ReportFrame");
+	reportFrame.def_readonly("report_data", &ReportFrame::reportData);
+	// as a ReportData, with a first column of the time at which each timestep starts
+	defArrowExport(reportFrame, [](pybind11::handle self) {
+		const ReportFrame& frame = self.cast<const ReportFrame&>();
+		return ArrowReportExport(frame.reportData.cast<const ReportData&>(), frame.timestamps, keepAlive(self));
+	});
 
 	pybind11::class_<FabricCostBreakdown>(m, "FabricCostBreakdown")
 		.def_readonly("name", &FabricCostBreakdown::name)
@@ -320,7 +709,348 @@ PYBIND11_MODULE(epoch_simulator, m) {
 		.def_readonly("total_capex", &CapexBreakdown::total_capex)
 		.def("__repr__", &capexBreakdownToString);
 
-	m.def("aggregate_site_results", &aggregateSiteResults,
+	// take the results by pointer so that they (and their report data) aren't copied out of the Python objects
+	m.def("aggregate_site_results", [](const std::vector<const SimulationResult*>& siteResults) {
+			pybind11::gil_scoped_release release;
+			return aggregateSiteResults(siteResults);
+		},
 		pybind11::arg("site_results"));
 
+	m.def("aggregate_portfolios", [](const std::vector<std::vector<const SimulationResult*>>& siteResults,
+			const Eigen::Ref<const Eigen::Matrix<int64_t, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>>& combinations) {
+			if (combinations.cols() != static_cast<Eigen::Index>(siteResults.size())) {
+				throw std::invalid_argument(std::format("combinations must have a column for each of the {} sites, not {}",
+					siteResults.size(), combinations.cols()));
+			}
+			pybind11::gil_scoped_release release;
+			return aggregatePortfolios(siteResults, std::span<const int64_t>(combinations.data(), static_cast<size_t>(combinations.size())));
+		},
+		pybind11::arg("site_results"), pybind11::arg("combinations"));
+
+	// take the results by pointer so that they aren't copied out of the Python objects
+	m.def("results_to_array", [](const std::vector<const SimulationResult*>& results, bool applyDirections) {
+			pybind11::gil_scoped_release release;
+			ResultTable table(static_cast<Eigen::Index>(results.size()), static_cast<Eigen::Index>(resultColumns().size()));
+			for (size_t i = 0; i < results.size(); i++) {
+				writeResultRow(*results[i], table.row(static_cast<Eigen::Index>(i)).data(), applyDirections);
+			}
+			return table;
+		},
+		pybind11::arg("results"), pybind11::arg("apply_directions") = false);
+
+	m.attr("RESULT_COLUMNS") = [] {
+		std::vector<std::string> names;
+		for (const auto& column : resultColumns()) {
+			names.emplace_back(column.name);
+		}
+		return names;
+	}();
+
+	m.attr("RESULT_DIRECTIONS") = [] {
+		std::vector<int> directions;
+		for (const auto& column : resultColumns()) {
+			directions.push_back(column.direction);
+		}
+		return directions;
+	}();
+
+	pybind11::native_enum<Objective>(m, "Objective", "enum.Enum", "The five objectives of the optimisation")
+		.value("CAPEX", Objective::CAPEX)
+		.value("AnnualisedCost", Objective::AnnualisedCost)
+		.value("PaybackHorizon", Objective::PaybackHorizon)
+		.value("CostBalance", Objective::CostBalance)
+		.value("CarbonBalance", Objective::CarbonBalance)
+		.finalize();
+
+	m.def("objective_costs", [](const std::vector<const SimulationResult*>& results, const std::vector<Objective>& objectives) {
+			ObjectiveCosts costs(static_cast<Eigen::Index>(results.size()), static_cast<Eigen::Index>(objectives.size()));
+			for (size_t i = 0; i < results.size(); i++) {
+				for (size_t j = 0; j < objectives.size(); j++) {
+					costs(static_cast<Eigen::Index>(i), static_cast<Eigen::Index>(j)) = objectiveCost(*results[i], objectives[j]);
+				}
+			}
+			return costs;
+		},
+		pybind11::arg("results"),
+		pybind11::arg("objectives") = std::vector<Objective>(ALL_OBJECTIVES.begin(), ALL_OBJECTIVES.end()));
+
+	m.def("non_dominated_sort", [](const Eigen::Ref<const ObjectiveCosts>& costs) {
+			pybind11::gil_scoped_release release;
+			return nonDominatedSort(costs);
+		},
+		pybind11::arg("costs"));
+
+	m.def("crowding_distance", [](const Eigen::Ref<const ObjectiveCosts>& costs, std::optional<std::vector<size_t>> front) {
+			if (!front) {
+				front.emplace(static_cast<size_t>(costs.rows()));
+				std::iota(front->begin(), front->end(), size_t{ 0 });
+			}
+			for (size_t i : *front) {
+				if (i >= static_cast<size_t>(costs.rows())) {
+					throw pybind11::index_error(std::format("Index {} is out of range for {} candidates", i, costs.rows()));
+				}
+			}
+			return crowdingDistance(costs, *front);
+		},
+		pybind11::arg("costs"), pybind11::arg("front") = pybind11::none());
+
+	// an archive is typically shared by the threads evaluating candidates, so every access holds its critical section
+	// (which is the GIL, unless python is free-threaded)
+	pybind11::class_<ParetoArchive>(m, "ParetoArchive")
+		.def(pybind11::init<size_t, bool>(), pybind11::arg("num_objectives"), pybind11::arg("distinct") = true)
+		.def("insert", [](pybind11::handle self, const Eigen::Ref<const ObjectiveCosts>& costs, size_t firstId) {
+			pybind11::scoped_critical_section lock(self);
+			return self.cast<ParetoArchive&>().insert(costs, firstId);
+		}, pybind11::arg("costs"), pybind11::arg("first_id"))
+		.def("excludes", [](pybind11::handle self, const Eigen::Ref<const Eigen::VectorXd>& bound) {
+			pybind11::scoped_critical_section lock(self);
+			return self.cast<const ParetoArchive&>().excludes(std::span<const double>(bound.data(), static_cast<size_t>(bound.size())));
+		}, pybind11::arg("bound"))
+		.def("clear", [](pybind11::handle self) {
+			pybind11::scoped_critical_section lock(self);
+			self.cast<ParetoArchive&>().clear();
+		})
+		.def("__len__", [](pybind11::handle self) {
+			pybind11::scoped_critical_section lock(self);
+			return self.cast<const ParetoArchive&>().size();
+		})
+		.def_property_readonly("num_objectives", &ParetoArchive::numObjectives)
+		.def_property_readonly("ids", [](pybind11::handle self) {
+			pybind11::scoped_critical_section lock(self);
+			return self.cast<const ParetoArchive&>().ids();
+		})
+		.def_property_readonly("costs", [](pybind11::handle self) {
+			pybind11::scoped_critical_section lock(self);
+			return self.cast<const ParetoArchive&>().costs();
+		});
+
+	pybind11::class_<MetricConstraint>(m, "MetricConstraint")
+		.def(pybind11::init([](Objective objective, std::optional<double> min, std::optional<double> max) {
+			return MetricConstraint{ objective, min, max };
+		}), pybind11::arg("objective"), pybind11::kw_only(), pybind11::arg("min") = pybind11::none(), pybind11::arg("max") = pybind11::none())
+		.def_readwrite("objective", &MetricConstraint::objective)
+		.def_readwrite("min", &MetricConstraint::min)
+		.def_readwrite("max", &MetricConstraint::max);
+
+	pybind11::class_<NSGA2Options>(m, "NSGA2Options")
+		.def(pybind11::init<>())
+		.def_readwrite("pop_size", &NSGA2Options::pop_size)
+		.def_readwrite("n_offsprings", &NSGA2Options::n_offsprings)
+		.def_readwrite("prob_crossover", &NSGA2Options::prob_crossover)
+		.def_readwrite("n_crossover", &NSGA2Options::n_crossover)
+		.def_readwrite("prob_mutation", &NSGA2Options::prob_mutation)
+		.def_readwrite("std_scaler", &NSGA2Options::std_scaler)
+		.def_readwrite("n_max_gen", &NSGA2Options::n_max_gen)
+		.def_readwrite("n_max_evals", &NSGA2Options::n_max_evals)
+		.def_readwrite("return_least_infeasible", &NSGA2Options::return_least_infeasible)
+		.def_readwrite("seed", &NSGA2Options::seed);
+
+	pybind11::class_<NSGA2Population>(m, "NSGA2Population")
+		.def_readonly("chromosomes", &NSGA2Population::chromosomes)
+		.def_readonly("costs", &NSGA2Population::costs)
+		.def_readonly("violation", &NSGA2Population::violation)
+		.def_readonly("results", &NSGA2Population::results);
+
+	pybind11::class_<NSGA2Generation>(m, "NSGA2Generation")
+		.def_readonly("generation", &NSGA2Generation::generation)
+		.def_readonly("n_evals", &NSGA2Generation::n_evals)
+		// a copy, as the population changes once the callback returns
+		.def_property_readonly("population", [](const NSGA2Generation& self) { return self.population; })
+		.def_readonly("front", &NSGA2Generation::front);
+
+	pybind11::class_<NSGA2Result>(m, "NSGA2Result")
+		.def_readonly("optimal", &NSGA2Result::optimal)
+		.def_readonly("generations", &NSGA2Result::generations)
+		.def_readonly("n_evals", &NSGA2Result::n_evals);
+
+	m.def("nsga2", [](const Simulator_py& simulator, const ScenarioCodec& codec, const std::vector<Objective>& objectives,
+			const std::vector<MetricConstraint>& constraints, const NSGA2Options& options, std::optional<Chromosomes> seeds,
+			std::optional<pybind11::function> callback) {
+			GenerationCallback onGeneration;
+			if (callback) {
+				// each generation is simulated without the GIL, which is taken back to call into python
+				onGeneration = [&callback](const NSGA2Generation& generation) {
+					pybind11::gil_scoped_acquire acquire;
+					pybind11::object keepGoing = (*callback)(generation);
+					return keepGoing.is_none() || static_cast<bool>(pybind11::bool_(keepGoing));
+				};
+			}
+			const std::shared_ptr<const Simulator> shared = simulator.acquire();
+			const NSGA2 nsga2(*shared, codec, objectives, constraints);
+			pybind11::gil_scoped_release release;
+			return nsga2.run(options, seeds ? *seeds : Chromosomes{}, onGeneration);
+		},
+		pybind11::arg("simulator"),
+		pybind11::arg("codec"),
+		pybind11::arg("objectives"),
+		pybind11::arg("constraints") = std::vector<MetricConstraint>{},
+		pybind11::arg("options") = NSGA2Options{},
+		pybind11::arg("seeds") = pybind11::none(),
+		pybind11::arg("callback") = pybind11::none());
+
+	pybind11::class_<PortfolioResult>(m, "PortfolioResult")
+		.def_readonly("portfolio", &PortfolioResult::portfolio)
+		.def_readonly("sites", &PortfolioResult::sites);
+
+	pybind11::class_<SiteBuildTiming>(m, "SiteBuildTiming")
+		.def_readonly("load", &SiteBuildTiming::load)
+		.def_readonly("construct", &SiteBuildTiming::construct);
+
+	pybind11::class_<PortfolioSimulator>(m, "PortfolioSimulator")
+		.def(pybind11::init([](const std::map<std::string, const Simulator_py*>& simulators) {
+			// share the Simulators rather than copying them
+			std::map<std::string, std::shared_ptr<const Simulator>> shared;
+			for (const auto& [name, simulator] : simulators) {
+				shared.emplace(name, simulator->simulator());
+			}
+			return PortfolioSimulator(std::move(shared));
+		}), pybind11::arg("simulators"))
+		.def_static("from_json", [](const std::map<std::string, std::pair<std::string, std::string>>& sites) {
+			// the config is small, so parse it here; the SiteData is parsed on the thread pool
+			std::vector<SiteSource> sources;
+			for (const auto& [name, jsonStrings] : sites) {
+				TaskConfig config = nlohmann::json::parse(jsonStrings.second).get<TaskConfig>();
+				sources.push_back(SiteSource{ name, jsonStrings.first, config });
+			}
+			pybind11::gil_scoped_release release;
+			return PortfolioSimulator::build(sources);
+		}, pybind11::arg("sites"))
+		.def("simulate_portfolio", [](const PortfolioSimulator& self, const PortfolioTaskData& portfolio, bool fullReporting,
+			const std::optional<std::vector<std::string>>& columns) {
+			const std::optional<ReportColumnMask> mask = columns ? std::optional(ReportColumnMask::fromNames(*columns)) : std::nullopt;
+			pybind11::gil_scoped_release release;
+			if (mask) {
+				return self.simulatePortfolio(portfolio, *mask);
+			}
+			return self.simulatePortfolio(portfolio, fullReporting ? SimulationType::FullReporting : SimulationType::ResultOnly);
+		}, pybind11::arg("portfolio"), pybind11::arg("fullReporting") = false, pybind11::arg("columns") = pybind11::none())
+		.def("simulate_portfolios", [](const PortfolioSimulator& self, const std::vector<PortfolioTaskData>& portfolios, bool fullReporting,
+			BatchControl* control, const std::optional<std::vector<std::string>>& columns) {
+			const std::optional<ReportColumnMask> mask = columns ? std::optional(ReportColumnMask::fromNames(*columns)) : std::nullopt;
+			pybind11::gil_scoped_release release;
+			if (mask) {
+				return control ? self.simulatePortfolios(portfolios, *mask, *control) : self.simulatePortfolios(portfolios, *mask);
+			}
+			const SimulationType simulationType = fullReporting ? SimulationType::FullReporting : SimulationType::ResultOnly;
+			return control ? self.simulatePortfolios(portfolios, simulationType, *control) : self.simulatePortfolios(portfolios, simulationType);
+		}, pybind11::arg("portfolios"), pybind11::arg("fullReporting") = false, pybind11::arg("control") = pybind11::none(),
+			pybind11::arg("columns") = pybind11::none())
+		.def_property_readonly("site_names", &PortfolioSimulator::siteNames)
+		.def_property_readonly("build_timings", &PortfolioSimulator::getBuildTimings)
+		.def(pybind11::pickle(
+			[](const PortfolioSimulator& self) { return snapshotPortfolio(self); },
+			[](const pybind11::dict& snapshots) { return restorePortfolio(snapshots); }
+		))
+		.def("__deepcopy__", [](const PortfolioSimulator& self, const pybind11::dict&) {
+			// each Simulator is copied through its snapshot, so the copy has its own caches
+			return restorePortfolio(snapshotPortfolio(self));
+		}, pybind11::arg("memo"));
+
+	m.def("cuda_supported", &cudaSupported);
+
+	m.def("convert_site_data", [](const std::filesystem::path& jsonPath, const std::filesystem::path& binaryPath) {
+			pybind11::gil_scoped_release release;
+			writeSiteDataBinary(readSiteData(jsonPath), binaryPath);
+		},
+		pybind11::arg("json_path"), pybind11::arg("binary_path"));
+
+	// a batch of fixed-size TaskData records (see TaskDataBinary.hpp), for simulate_task_batch and for storing scenarios
+	m.def("encode_task_batch", [](const std::vector<TaskData>& tasks) {
+			std::vector<std::byte> bytes;
+			{
+				pybind11::gil_scoped_release release;
+				bytes = encodeTaskDataBatch(tasks);
+			}
+			return pybind11::bytes(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+		},
+		pybind11::arg("tasks"));
+	m.def("decode_task_batch", [](const pybind11::bytes& batch) {
+			const std::string_view view = batch;
+			pybind11::gil_scoped_release release;
+			return decodeTaskDataBatch(std::as_bytes(std::span(view.data(), view.size())));
+		},
+		pybind11::arg("batch"));
+
+	// the client side of the worker protocol (see WorkerProtocol.hpp); each request is a frame to write to a worker
+	pybind11::native_enum<WorkerMessageType>(m, "WorkerMessageType", "enum.Enum", "The kinds of message in the worker protocol")
+		.value("LoadSimulator", WorkerMessageType::LoadSimulator)
+		.value("SimulateTasks", WorkerMessageType::SimulateTasks)
+		.value("SimulateChromosomes", WorkerMessageType::SimulateChromosomes)
+		.value("SimulateTaskRecords", WorkerMessageType::SimulateTaskRecords)
+		.value("Loaded", WorkerMessageType::Loaded)
+		.value("Results", WorkerMessageType::Results)
+		.value("Error", WorkerMessageType::Error)
+		.finalize();
+
+	pybind11::class_<WorkerResponse>(m, "WorkerResponse")
+		.def_readonly("type", &WorkerResponse::type)
+		.def_readonly("request_id", &WorkerResponse::request_id)
+		.def_readonly("results", &WorkerResponse::results)
+		.def_readonly("error", &WorkerResponse::error);
+
+	m.def("encode_worker_load", [](uint64_t requestId, const std::string& site, const pybind11::bytes& snapshot,
+			const std::optional<std::string>& siteRange) {
+			const std::string_view view = snapshot;
+			std::string frame;
+			{
+				pybind11::gil_scoped_release release;
+				frame = encodeLoadRequest(requestId, site, std::as_bytes(std::span(view.data(), view.size())), siteRange);
+			}
+			return pybind11::bytes(frame);
+		},
+		pybind11::arg("request_id"), pybind11::arg("site"), pybind11::arg("snapshot"),
+		pybind11::arg("site_range_json_str") = pybind11::none());
+	m.def("encode_worker_tasks", [](uint64_t requestId, const std::string& site, const std::vector<TaskData>& tasks,
+			bool fullReporting, std::string_view encoding) {
+			const TimeseriesEncoding timeseriesEncoding = timeseriesEncodingFromString(encoding);
+			std::string frame;
+			{
+				pybind11::gil_scoped_release release;
+				frame = encodeTasksRequest(requestId, site, tasks,
+					fullReporting ? SimulationType::FullReporting : SimulationType::ResultOnly, timeseriesEncoding);
+			}
+			return pybind11::bytes(frame);
+		},
+		pybind11::arg("request_id"), pybind11::arg("site"), pybind11::arg("tasks"),
+		pybind11::arg("fullReporting") = false, pybind11::arg("encoding") = "float32");
+	m.def("encode_worker_task_records", [](uint64_t requestId, const std::string& site, const std::vector<TaskData>& tasks,
+			bool fullReporting, std::string_view encoding) {
+			const TimeseriesEncoding timeseriesEncoding = timeseriesEncodingFromString(encoding);
+			std::string frame;
+			{
+				pybind11::gil_scoped_release release;
+				frame = encodeTaskRecordsRequest(requestId, site, tasks,
+					fullReporting ? SimulationType::FullReporting : SimulationType::ResultOnly, timeseriesEncoding);
+			}
+			return pybind11::bytes(frame);
+		},
+		pybind11::arg("request_id"), pybind11::arg("site"), pybind11::arg("tasks"),
+		pybind11::arg("fullReporting") = false, pybind11::arg("encoding") = "float32");
+	m.def("encode_worker_chromosomes", [](uint64_t requestId, const std::string& site, const Eigen::Ref<const Chromosomes>& chromosomes,
+			bool fullReporting, std::string_view encoding) {
+			const TimeseriesEncoding timeseriesEncoding = timeseriesEncodingFromString(encoding);
+			return pybind11::bytes(encodeChromosomesRequest(requestId, site, chromosomes,
+				fullReporting ? SimulationType::FullReporting : SimulationType::ResultOnly, timeseriesEncoding));
+		},
+		pybind11::arg("request_id"), pybind11::arg("site"), pybind11::arg("chromosomes"),
+		pybind11::arg("fullReporting") = false, pybind11::arg("encoding") = "float32");
+	// the payload of a reply, without its 4-byte length prefix
+	m.def("decode_worker_response", [](const pybind11::bytes& payload) {
+			const std::string_view view = payload;
+			pybind11::gil_scoped_release release;
+			return decodeResponse(std::as_bytes(std::span(view.data(), view.size())));
+		},
+		pybind11::arg("payload"));
+
+	m.def("start_trace", [](size_t eventsPerThread) { Tracer::start(eventsPerThread); },
+		pybind11::arg("events_per_thread") = DEFAULT_TRACE_EVENTS_PER_THREAD,
+		"Start tracing the simulation phases on every thread, discarding any earlier trace");
+	m.def("stop_trace", &Tracer::stop);
+	m.def("trace_json", &Tracer::chromeTrace, "The trace in the Chrome trace event format");
+	m.def("write_trace", [](const std::filesystem::path& path) {
+			pybind11::gil_scoped_release release;
+			Tracer::writeChromeTrace(path);
+		},
+		pybind11::arg("path"));
+
 }
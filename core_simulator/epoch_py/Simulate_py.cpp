@@ -1,9 +1,22 @@
 #include "Simulate_py.hpp"
 
+#include <algorithm>
+#include <exception>
+#include <format>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+
+#include <pybind11/stl.h>
+
 #include "../epoch_lib/io/EpochConfig.hpp"
 #include "../epoch_lib/io/FileHandling.hpp"
+#include "../epoch_lib/io/OnDemandJson.hpp"
+#include "../epoch_lib/io/SimulatorSnapshot.hpp"
+#include "../epoch_lib/io/SiteDataBinary.hpp"
 #include "../epoch_lib/io/SiteDataJson.hpp"
 #include "../epoch_lib/io/TaskConfigJson.hpp"
+#include "../epoch_lib/io/TaskDataBinary.hpp"
 
 /**
 * Factory method for a Simulator that accepts filepaths to a SiteData.json and epochConfig.json
@@ -14,7 +27,7 @@ Simulator_py Simulator_py::from_file(const std::filesystem::path& siteDataPath,
 
 	ConfigHandler configHandler(configPath);
 	
-	return Simulator_py(std::move(sd), configHandler.getConfig().taskConfig);
+	return Simulator_py(std::make_shared<const SiteData>(std::move(sd)), configHandler.getConfig().taskConfig);
 }
 
 /**
@@ -22,39 +35,603 @@ Simulator_py Simulator_py::from_file(const std::filesystem::path& siteDataPath,
 */
 Simulator_py Simulator_py::from_json(const std::string& site_data_json_str, const std::string& config_json_str)
 {
-	SiteData sd = nlohmann::json::parse(site_data_json_str).get<SiteData>();
+	SiteData sd = parseSiteDataJson(site_data_json_str);
 	TaskConfig config = nlohmann::json::parse(config_json_str).get<TaskConfig>();
-	return Simulator_py(std::move(sd), config);
+	return Simulator_py(std::make_shared<const SiteData>(std::move(sd)), config);
+}
+
+/**
+* Factory method for a Simulator that shares a mapping of a binary SiteData file with other processes
+*/
+Simulator_py Simulator_py::from_mapped_file(const std::filesystem::path& siteDataPath, const std::filesystem::path& configPath)
+{
+	SiteData sd = mapSiteDataBinary(siteDataPath);
+
+	ConfigHandler configHandler(configPath);
+
+	return Simulator_py(std::make_shared<const SiteData>(std::move(sd)), configHandler.getConfig().taskConfig);
+}
+
+/**
+* Factory method for a Simulator restored from the bytes of a snapshot
+*/
+Simulator_py Simulator_py::from_snapshot(const pybind11::bytes& snapshot)
+{
+	// the bytes object is immutable and kept alive by the caller, so can be read without the GIL
+	const std::string_view view = snapshot;
+	pybind11::gil_scoped_release release;
+	std::shared_ptr<Simulator> simulator = restoreSimulator(std::as_bytes(std::span(view.data(), view.size())));
+	TaskConfig config = simulator->getConfig();
+	return Simulator_py(std::move(simulator), std::move(config));
+}
+
+pybind11::bytes Simulator_py::snapshot() const
+{
+	std::vector<std::byte> bytes;
+	{
+		pybind11::gil_scoped_release release;
+		bytes = snapshotSimulator(*acquire());
+	}
+	return pybind11::bytes(reinterpret_cast<const char*>(bytes.data()), bytes.size());
 }
 
 
-Simulator_py::Simulator_py(SiteData&& siteData, TaskConfig taskConfig) :
+Simulator_py::Simulator_py(std::shared_ptr<const SiteData> siteData, TaskConfig taskConfig) :
 	config(taskConfig),
-	mSimulator{ std::move(siteData), config }
+	mShared(std::make_shared<Shared>(std::make_shared<Simulator>(std::move(siteData), config)))
 {
 }
 
-bool Simulator_py::isValid(const TaskData& taskData)
+Simulator_py::Simulator_py(std::shared_ptr<Simulator> simulator, TaskConfig taskConfig) :
+	config(taskConfig),
+	mShared(std::make_shared<Shared>(std::move(simulator)))
+{
+}
+
+std::shared_ptr<const Simulator> Simulator_py::simulator() const
+{
+	std::lock_guard lock(mShared->mutex);
+	return mShared->simulator;
+}
+
+std::shared_ptr<Simulator> Simulator_py::acquire() const
+{
+	std::shared_ptr<Simulator> simulator;
+	{
+		std::lock_guard lock(mShared->mutex);
+		simulator = mShared->simulator;
+		mShared->uses++;
+	}
+	// the use ends when the last copy is dropped, which may be on another thread (such as the pool thread of an async simulation)
+	// (if the pointer can't be made, the deleter is called straight away, so the use still ends)
+	return std::shared_ptr<Simulator>(simulator.get(), [shared = mShared, simulator](Simulator*) {
+		std::lock_guard lock(shared->mutex);
+		if (--shared->uses == 0) {
+			shared->released.notify_all();
+		}
+	});
+}
+
+template <typename Change>
+void Simulator_py::modify(Change change)
+{
+	// a simulation may need the GIL to finish (such as to resolve an async future), so we mustn't hold it while we wait
+	pybind11::gil_scoped_release release;
+	std::unique_lock lock(mShared->mutex);
+	mShared->released.wait(lock, [this] { return mShared->uses == 0; });
+	// new uses wait on the mutex until the change has been made
+	change(*mShared->simulator);
+}
+
+Simulator_py Simulator_py::atResolution(long long intervalSeconds) const
+{
+	// building a new resolution resamples every timeseries, which doesn't need the GIL
+	pybind11::gil_scoped_release release;
+	return Simulator_py(acquire()->atResolution(std::chrono::seconds{ intervalSeconds }), config);
+}
+
+Simulator_py Simulator_py::withConfig(const TaskConfig& taskConfig) const
+{
+	// constructing the Simulator derives its tariff and heatpump data, which doesn't need the GIL
+	pybind11::gil_scoped_release release;
+	return Simulator_py(acquire()->getSiteData(), taskConfig);
+}
+
+namespace {
+	// the columns of a matrix as the members of a SiteSeriesMatrix
+	SiteSeriesMatrix toSeriesMatrix(const Eigen::MatrixXf& columns) {
+		std::vector<SiteSeries> series;
+		series.reserve(static_cast<size_t>(columns.cols()));
+		for (Eigen::Index c = 0; c < columns.cols(); c++) {
+			series.emplace_back(columns.col(c));
+		}
+		return SiteSeriesMatrix(std::move(series));
+	}
+}
+
+Simulator_py Simulator_py::withEnsemble(const std::optional<Eigen::MatrixXf>& airTemperature, const std::optional<Eigen::MatrixXf>& buildingEload,
+	const std::optional<Eigen::MatrixXf>& buildingHload, const std::vector<Eigen::MatrixXf>& solarYields) const
+{
+	pybind11::gil_scoped_release release;
+
+	// the copy shares every timeseries with this Simulator's SiteData
+	SiteData siteData = *acquire()->getSiteData();
+	SiteEnsemble ensemble;
+	if (airTemperature) {
+		ensemble.air_temperature = toSeriesMatrix(*airTemperature);
+	}
+	if (buildingEload) {
+		ensemble.building_eload = toSeriesMatrix(*buildingEload);
+	}
+	if (buildingHload) {
+		ensemble.building_hload = toSeriesMatrix(*buildingHload);
+	}
+	for (const auto& member : solarYields) {
+		ensemble.solar_yields.push_back(toSeriesMatrix(member));
+	}
+	siteData.ensemble = std::move(ensemble);
+	return Simulator_py(std::make_shared<const SiteData>(std::move(siteData)), config);
+}
+
+void Simulator_py::update(const std::function<SiteUpdate(const Simulator&)>& makeUpdate)
+{
+	// deriving the tariff statistics of the new columns doesn't need the GIL
+	pybind11::gil_scoped_release release;
+	std::lock_guard updating(mShared->updating);
+
+	const std::shared_ptr<Simulator> current = acquire();
+	std::shared_ptr<Simulator> updated = current->withSiteUpdate(makeUpdate(*current));
+
+	std::lock_guard lock(mShared->mutex);
+	mShared->simulator = std::move(updated);
+}
+
+size_t Simulator_py::addImportTariff(const Eigen::VectorXf& tariff)
+{
+	size_t index = 0;
+	update([&](const Simulator& simulator) {
+		index = simulator.getSiteData()->import_tariffs.size();
+		return SiteUpdate{}.addImportTariff(tariff);
+	});
+	return index;
+}
+
+size_t Simulator_py::addSolarYield(const Eigen::VectorXf& yield)
+{
+	size_t index = 0;
+	update([&](const Simulator& simulator) {
+		index = simulator.getSiteData()->solar_yields.size();
+		return SiteUpdate{}.addSolarYield(yield);
+	});
+	return index;
+}
+
+void Simulator_py::replaceColumns(const std::map<std::string, Eigen::VectorXf>& columns)
+{
+	SiteUpdate siteUpdate;
+	for (const auto& [name, values] : columns) {
+		siteUpdate.replace(name, values);
+	}
+	update([&](const Simulator&) { return siteUpdate; });
+}
+
+EnsembleResult Simulator_py::simulateEnsemble(const TaskData& taskData, BatchControl* control)
+{
+	pybind11::gil_scoped_release release;
+
+	return control ? acquire()->simulateEnsemble(taskData, *control) : acquire()->simulateEnsemble(taskData);
+}
+
+pybind11::array Simulator_py::timestamps() const
+{
+	auto index = acquire()->getTimestamps();
+	// the array holds its own reference to the index, which outlives any later update of this Simulator
+	const int64_t* data = index->data();
+	const auto size = static_cast<pybind11::ssize_t>(index->size());
+	auto* owner = new std::shared_ptr<const TimestampIndex>(std::move(index));
+	pybind11::capsule base(owner, [](void* p) { delete static_cast<std::shared_ptr<const TimestampIndex>*>(p); });
+
+	pybind11::array_t<int64_t> array(size, data, base);
+	array.attr("setflags")(pybind11::arg("write") = false);
+	return array;
+}
+
+size_t Simulator_py::siteDataMemoryFootprint() const
+{
+	return acquire()->getSiteData()->memoryFootprint();
+}
+
+pybind11::dict Simulator_py::memoryFootprint() const
+{
+	pybind11::dict parts;
+	for (const auto& part : acquire()->memoryBreakdown().parts) {
+		parts[pybind11::str(part.name)] = part.bytes;
+	}
+	return parts;
+}
+
+void Simulator_py::enableBaselineCache(const std::filesystem::path& directory)
+{
+	modify([&](Simulator& simulator) { simulator.enableBaselineCache(directory); });
+}
+
+bool Simulator_py::hasBaseline() const
+{
+	return acquire()->hasBaseline();
+}
+
+void Simulator_py::enableResultCache(size_t maxBytes)
+{
+	modify([&](Simulator& simulator) { simulator.enableResultCache(maxBytes); });
+}
+
+std::optional<CacheStats> Simulator_py::resultCacheStats() const
+{
+	return acquire()->getResultCacheStats();
+}
+
+void Simulator_py::clearResultCache()
+{
+	acquire()->clearResultCache();
+}
+
+void Simulator_py::enablePreBalancingCache(size_t maxBytes)
+{
+	modify([&](Simulator& simulator) { simulator.enablePreBalancingCache(maxBytes); });
+}
+
+std::optional<CacheStats> Simulator_py::preBalancingCacheStats() const
+{
+	return acquire()->getPreBalancingCacheStats();
+}
+
+void Simulator_py::clearPreBalancingCache()
+{
+	acquire()->clearPreBalancingCache();
+}
+
+void Simulator_py::enableParallelESS()
+{
+	modify([&](Simulator& simulator) { simulator.enableParallelESS(); });
+}
+
+void Simulator_py::disableParallelESS()
+{
+	modify([&](Simulator& simulator) { simulator.disableParallelESS(); });
+}
+
+void Simulator_py::enableLowLatency()
+{
+	modify([&](Simulator& simulator) { simulator.enableLowLatency(); });
+}
+
+void Simulator_py::disableLowLatency()
 {
-	try {
-		mSimulator.validateScenario(taskData);
+	modify([&](Simulator& simulator) { simulator.disableLowLatency(); });
+}
+
+void Simulator_py::enableBatchBackend(const std::string& backend, int device)
+{
+	std::shared_ptr<BatchBackend> batchBackend;
+	if (backend == "cpu") {
+		batchBackend = makeCpuBatchBackend();
+	}
+	else if (backend == "cuda") {
+		batchBackend = makeCudaBatchBackend(device);
 	}
-	catch (const std::runtime_error&) {
-		return false;
+	else {
+		throw std::invalid_argument(std::format("Unknown batch backend {} (expected cpu or cuda)", backend));
+	}
+	modify([&](Simulator& simulator) { simulator.enableBatchBackend(std::move(batchBackend)); });
+}
+
+void Simulator_py::disableBatchBackend()
+{
+	modify([&](Simulator& simulator) { simulator.disableBatchBackend(); });
+}
+
+std::optional<std::string> Simulator_py::batchBackend() const
+{
+	if (const std::shared_ptr<BatchBackend> backend = acquire()->getBatchBackend()) {
+		return backend->name();
 	}
-	return true;
+	return std::nullopt;
 }
 
-SimulationResult Simulator_py::simulateScenario(const TaskData& taskData, bool fullReporting)
+void Simulator_py::enableRepresentativeDays(size_t numDays)
+{
+	// (choosing the days doesn't need the GIL, which modify releases)
+	modify([&](Simulator& simulator) { simulator.enableRepresentativeDays(numDays); });
+}
+
+std::optional<RepresentativeDays> Simulator_py::representativeDays() const
+{
+	return acquire()->getRepresentativeDays();
+}
+
+std::vector<SimulationResult> Simulator_py::simulateRepresentativeDays(const std::vector<TaskData>& taskData)
+{
+	pybind11::gil_scoped_release release;
+	return acquire()->simulateBatch(taskData, SimulationType::RepresentativeDays);
+}
+
+std::vector<RepresentativeDaysError> Simulator_py::representativeDaysError(const std::vector<TaskData>& sample)
+{
+	pybind11::gil_scoped_release release;
+	return acquire()->representativeDaysError(sample);
+}
+
+bool Simulator_py::isValid(const TaskData& taskData)
 {
+	return acquire()->checkScenario(taskData) == ScenarioError::None;
+}
+
+std::vector<uint32_t> Simulator_py::checkScenarios(const std::vector<TaskData>& taskData)
+{
+	std::vector<ScenarioError> errors(taskData.size());
+	{
+		pybind11::gil_scoped_release release;
+		acquire()->checkScenarios(taskData, errors);
+	}
+	std::vector<uint32_t> bits(errors.size());
+	std::transform(errors.begin(), errors.end(), bits.begin(), [](ScenarioError e) { return static_cast<uint32_t>(e); });
+	return bits;
+}
+
+SimulationResult Simulator_py::simulateScenario(const TaskData& taskData, bool fullReporting, const std::optional<ScenarioConstraints>& constraints,
+	const std::optional<std::vector<std::string>>& columns)
+{
+	if (columns) {
+		// an unknown column name is raised while we still hold the GIL
+		const ReportColumnMask mask = ReportColumnMask::fromNames(*columns);
+		pybind11::gil_scoped_release release;
+		return acquire()->simulateScenario(taskData, mask, constraints.value_or(ScenarioConstraints{}));
+	}
+
 	// release the GIL for each call to simulateScenario
 	pybind11::gil_scoped_release release;
 
 	SimulationType reportingType = fullReporting ? SimulationType::FullReporting : SimulationType::ResultOnly;
 
-	return mSimulator.simulateScenario(taskData, reportingType);
+	return acquire()->simulateScenario(taskData, reportingType, constraints.value_or(ScenarioConstraints{}));
+}
+
+std::vector<SimulationResult> Simulator_py::simulateBatch(const std::vector<TaskData>& taskData, bool fullReporting, const std::optional<ScenarioConstraints>& constraints,
+	BatchControl* control)
+{
+	// the TaskData have already been converted from python objects, so we can release the GIL for the whole batch
+	// (the BatchControl is only atomics, so another python thread can poll or cancel it meanwhile)
+	pybind11::gil_scoped_release release;
+
+	SimulationType reportingType = fullReporting ? SimulationType::FullReporting : SimulationType::ResultOnly;
+
+	if (control) {
+		return acquire()->simulateBatch(taskData, reportingType, constraints.value_or(ScenarioConstraints{}), *control);
+	}
+	return acquire()->simulateBatch(taskData, reportingType, constraints.value_or(ScenarioConstraints{}));
+}
+
+std::vector<SimulationResult> Simulator_py::simulateTaskBatch(const pybind11::bytes& batch, bool fullReporting,
+	const std::optional<ScenarioConstraints>& constraints, BatchControl* control)
+{
+	// (the bytes object is held by the caller, so its buffer stays valid without the GIL)
+	const std::string_view view = batch;
+	pybind11::gil_scoped_release release;
+
+	const std::vector<TaskData> taskData = decodeTaskDataBatch(std::as_bytes(std::span(view.data(), view.size())));
+	SimulationType reportingType = fullReporting ? SimulationType::FullReporting : SimulationType::ResultOnly;
+
+	if (control) {
+		return acquire()->simulateBatch(taskData, reportingType, constraints.value_or(ScenarioConstraints{}), *control);
+	}
+	return acquire()->simulateBatch(taskData, reportingType, constraints.value_or(ScenarioConstraints{}));
+}
+
+namespace {
+	/**
+	* The asyncio future of work running on the thread pool, and the event loop it belongs to
+	* These are python objects, so are only touched (and released) while holding the GIL
+	*/
+	struct PendingFuture {
+		pybind11::object loop;
+		pybind11::object future;
+		// any other python object that must outlive the work (such as its BatchControl)
+		pybind11::object keepAlive;
+
+		~PendingFuture() {
+			// the objects are taken when the work completes, so this only releases them if it never ran
+			if (!loop && !future && !keepAlive) {
+				return;
+			}
+			if (!Py_IsInitialized()) {
+				// the interpreter has already gone, so there is nothing left to release them to
+				loop.release();
+				future.release();
+				keepAlive.release();
+				return;
+			}
+			pybind11::gil_scoped_acquire acquire;
+			loop = pybind11::object();
+			future = pybind11::object();
+			keepAlive = pybind11::object();
+		}
+	};
+
+	// the python exception for a C++ exception, translated as pybind11 would when it is raised from a bound function
+	pybind11::object toPythonException(std::exception_ptr error) {
+		try {
+			pybind11::cpp_function([error]() { std::rethrow_exception(error); })();
+		}
+		catch (pybind11::error_already_set& raised) {
+			return raised.value();
+		}
+		return pybind11::none();
+	}
+
+	/**
+	* Run work on the shared thread pool without the GIL, returning a future on the running event loop of its result
+	* This must be called with the GIL held, from a coroutine (or a callback) of the event loop of the main interpreter
+	*/
+	template <typename Work>
+	pybind11::object submitAsync(Work work, pybind11::object keepAlive = pybind11::none()) {
+		// the pool threads take the GIL through PyGILState, which only knows of the main interpreter
+		if (PyInterpreterState_Get() != PyInterpreterState_Main()) {
+			throw std::runtime_error("Async simulations can only be run from the main interpreter");
+		}
+		auto pending = std::make_shared<PendingFuture>();
+		pending->loop = pybind11::module_::import("asyncio").attr("get_running_loop")();
+		pending->future = pending->loop.attr("create_future")();
+		pending->keepAlive = std::move(keepAlive);
+		pybind11::object future = pending->future;
+
+		ThreadPool::shared().submit([pending, work = std::move(work)]() mutable {
+			std::optional<decltype(work())> result;
+			std::exception_ptr error;
+			try {
+				result.emplace(work());
+			}
+			catch (...) {
+				error = std::current_exception();
+			}
+			// drop what the work holds (such as its use of the Simulator) before the future can be resolved
+			{
+				Work done = std::move(work);
+			}
+
+			if (!Py_IsInitialized()) {
+				return;
+			}
+			pybind11::gil_scoped_acquire acquire;
+			pybind11::object loop = std::move(pending->loop);
+			pybind11::object future = std::move(pending->future);
+			pending->keepAlive = pybind11::object();
+			try {
+				pybind11::object value = result ? pybind11::cast(std::move(*result)) : pybind11::none();
+				pybind11::object exception = error ? toPythonException(error) : pybind11::none();
+				// the future can only be resolved on its loop's thread, where it may have been cancelled meanwhile
+				pybind11::cpp_function resolve([](pybind11::object future, pybind11::object value, pybind11::object exception) {
+					if (future.attr("done")().cast<bool>()) {
+						return;
+					}
+					if (exception.is_none()) {
+						future.attr("set_result")(value);
+					}
+					else {
+						future.attr("set_exception")(exception);
+					}
+				});
+				loop.attr("call_soon_threadsafe")(resolve, future, value, exception);
+			}
+			catch (pybind11::error_already_set& e) {
+				// such as the loop having been closed; nothing is waiting for the result
+				e.discard_as_unraisable("EPOCH async simulation");
+			}
+		});
+		return future;
+	}
+}
+
+pybind11::object Simulator_py::simulateScenarioAsync(const TaskData& taskData, bool fullReporting,
+	const std::optional<ScenarioConstraints>& constraints, const std::optional<std::vector<std::string>>& columns)
+{
+	// an unknown column name is raised here rather than from the future
+	const std::optional<ReportColumnMask> mask = columns ? std::optional(ReportColumnMask::fromNames(*columns)) : std::nullopt;
+	const SimulationType reportingType = fullReporting ? SimulationType::FullReporting : SimulationType::ResultOnly;
+
+	return submitAsync([simulator = acquire(), taskData, reportingType, mask, constraints = constraints.value_or(ScenarioConstraints{})]() {
+		if (mask) {
+			return simulator->simulateScenario(taskData, *mask, constraints);
+		}
+		return simulator->simulateScenario(taskData, reportingType, constraints);
+	});
+}
+
+pybind11::object Simulator_py::simulateBatchAsync(std::vector<TaskData> taskData, bool fullReporting,
+	const std::optional<ScenarioConstraints>& constraints, pybind11::object control)
+{
+	BatchControl* batchControl = control.is_none() ? nullptr : control.cast<BatchControl*>();
+	const SimulationType reportingType = fullReporting ? SimulationType::FullReporting : SimulationType::ResultOnly;
+
+	// the future keeps the BatchControl alive until the batch has finished with it
+	return submitAsync([simulator = acquire(), taskData = std::move(taskData), reportingType, batchControl,
+		constraints = constraints.value_or(ScenarioConstraints{})]() {
+		if (batchControl) {
+			return simulator->simulateBatch(taskData, reportingType, constraints, *batchControl);
+		}
+		return simulator->simulateBatch(taskData, reportingType, constraints);
+	}, std::move(control));
+}
+
+std::vector<SimulationResult> Simulator_py::simulateAllTariffs(const TaskData& taskData)
+{
+	pybind11::gil_scoped_release release;
+
+	return acquire()->simulateAllTariffs(taskData);
+}
+
+DaysOfInterest Simulator_py::daysOfInterest(const TaskData& taskData)
+{
+	pybind11::gil_scoped_release release;
+
+	return acquire()->daysOfInterest(taskData);
+}
+
+std::vector<SimulationResult> Simulator_py::simulateConfigs(const TaskData& taskData, const std::vector<TaskConfig>& configs)
+{
+	pybind11::gil_scoped_release release;
+
+	return acquire()->simulateConfigs(taskData, configs);
+}
+
+ResultTable Simulator_py::sweepESS(const TaskData& taskData, const Eigen::Ref<const Eigen::Matrix<float, Eigen::Dynamic, 3, Eigen::RowMajor>>& sizes)
+{
+	std::vector<ESSSize> essSizes;
+	essSizes.reserve(static_cast<size_t>(sizes.rows()));
+	for (Eigen::Index i = 0; i < sizes.rows(); i++) {
+		essSizes.push_back({ sizes(i, 0), sizes(i, 1), sizes(i, 2) });
+	}
+
+	pybind11::gil_scoped_release release;
+
+	return resultsToTable(acquire()->sweepESS(taskData, essSizes));
+}
+
+std::vector<ObjectiveBounds> Simulator_py::boundObjectives(const std::vector<TaskData>& taskData)
+{
+	pybind11::gil_scoped_release release;
+
+	return acquire()->boundObjectives(taskData);
+}
+
+SensitivityResult Simulator_py::sensitivities(const TaskData& taskData, const std::vector<Perturbation>& perturbations, bool central)
+{
+	pybind11::gil_scoped_release release;
+
+	return acquire()->sensitivities(taskData, perturbations, central ? SensitivityScheme::Central : SensitivityScheme::Forward);
+}
+
+std::map<std::string, SimulationResult> Simulator_py::simulateUpgradeTree(const TaskData& start, const TaskData& end,
+	const std::optional<std::vector<std::string>>& components)
+{
+	pybind11::gil_scoped_release release;
+
+	const std::vector<std::string> names = components ? *components : differingComponents(start, end);
+	return acquire()->simulateUpgradeTree(start, componentUpgrades(end, names)).nodes;
+}
+
+std::vector<SimulationResult> Simulator_py::simulateChromosomes(const ScenarioCodec& codec, const Eigen::Ref<const Chromosomes>& chromosomes, bool fullReporting,
+	const std::optional<ScenarioConstraints>& constraints, BatchControl* control)
+{
+	pybind11::gil_scoped_release release;
+
+	SimulationType reportingType = fullReporting ? SimulationType::FullReporting : SimulationType::ResultOnly;
+
+	if (control) {
+		return acquire()->simulateBatch(codec.decode(chromosomes), reportingType, constraints.value_or(ScenarioConstraints{}), *control);
+	}
+	return acquire()->simulateBatch(codec.decode(chromosomes), reportingType, constraints.value_or(ScenarioConstraints{}));
 }
 
 CapexBreakdown Simulator_py::calculateCapexWithDiscounts(const TaskData& taskData) {
-	return mSimulator.calculateCapexWithDiscounts(taskData);
+	return acquire()->calculateCapexWithDiscounts(taskData);
 }
\ No newline at end of file
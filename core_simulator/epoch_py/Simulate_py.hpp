@@ -1,10 +1,21 @@
 #pragma once
 
+#include <condition_variable>
 #include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
 
 #include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
 
 #include "../epoch_lib/Simulation/Simulate.hpp"
+#include "../epoch_lib/io/ResultTable.hpp"
+#include "../epoch_lib/io/ScenarioCodec.hpp"
 
 
 
@@ -22,18 +33,259 @@ public:
 	static Simulator_py from_file(const std::filesystem::path& siteDataPath, const std::filesystem::path& configPath);
 	static Simulator_py from_json(const std::string& site_data_json_str, const std::string& config_json_str);
 
+	/**
+	* A Simulator whose timeseries view a read-only mapping of a binary SiteData file (see mapSiteDataBinary)
+	*/
+	static Simulator_py from_mapped_file(const std::filesystem::path& siteDataPath, const std::filesystem::path& configPath);
+
+	/**
+	* Restore a Simulator from a snapshot, without simulating its baseline again
+	*/
+	static Simulator_py from_snapshot(const pybind11::bytes& snapshot);
+
+	/**
+	* A binary snapshot of this Simulator (see snapshotSimulator), which is also its pickled state
+	*/
+	pybind11::bytes snapshot() const;
+
 	/**
 	* Check if a given TaskData would be valid to run a simulation with the loaded SiteData
 	*/
 	bool isValid(const TaskData& taskData);
-	SimulationResult simulateScenario(const TaskData& taskData, bool fullReporting = false);
+	// the ScenarioError bitmask of each scenario (0 where it is valid)
+	std::vector<uint32_t> checkScenarios(const std::vector<TaskData>& taskData);
+	/**
+	* Simulate a single scenario
+	* If columns is set, the scenario is FullReporting but only reports the ReportData columns with those names
+	*/
+	SimulationResult simulateScenario(const TaskData& taskData, bool fullReporting = false,
+		const std::optional<ScenarioConstraints>& constraints = std::nullopt,
+		const std::optional<std::vector<std::string>>& columns = std::nullopt);
+
+	/**
+	* Simulate a list of scenarios in parallel, releasing the GIL once for the whole batch
+	* Scenarios whose capex is outside the constraints are not simulated
+	* If control is set, the batch reports its progress to it and skips the remaining scenarios once it is stopped
+	*/
+	std::vector<SimulationResult> simulateBatch(const std::vector<TaskData>& taskData, bool fullReporting = false,
+		const std::optional<ScenarioConstraints>& constraints = std::nullopt, BatchControl* control = nullptr);
+
+	/**
+	* simulateBatch of a binary TaskData batch (see encodeTaskDataBatch), which is decoded without the GIL
+	* rather than converting a python TaskData for each scenario
+	*/
+	std::vector<SimulationResult> simulateTaskBatch(const pybind11::bytes& batch, bool fullReporting = false,
+		const std::optional<ScenarioConstraints>& constraints = std::nullopt, BatchControl* control = nullptr);
+
+	/**
+	* simulateScenario and simulateBatch on the shared thread pool, returning an asyncio future on the running event loop
+	* The simulation doesn't hold the GIL, and the future is resolved from the pool (through call_soon_threadsafe)
+	* with the result, or with the exception that simulating raised
+	*/
+	pybind11::object simulateScenarioAsync(const TaskData& taskData, bool fullReporting = false,
+		const std::optional<ScenarioConstraints>& constraints = std::nullopt,
+		const std::optional<std::vector<std::string>>& columns = std::nullopt);
+	pybind11::object simulateBatchAsync(std::vector<TaskData> taskData, bool fullReporting = false,
+		const std::optional<ScenarioConstraints>& constraints = std::nullopt, pybind11::object control = pybind11::none());
+
+	/**
+	* Simulate a scenario against every import tariff, returning one result per tariff_index
+	*/
+	std::vector<SimulationResult> simulateAllTariffs(const TaskData& taskData);
+
+	/**
+	* The days of interest of a scenario, without reporting its timeseries (see Simulator::daysOfInterest)
+	*/
+	DaysOfInterest daysOfInterest(const TaskData& taskData);
+
+	/**
+	* Simulate a scenario once and cost it with each config, returning one result per config (see Simulator::simulateConfigs)
+	*/
+	std::vector<SimulationResult> simulateConfigs(const TaskData& taskData, const std::vector<TaskConfig>& configs);
+
+	/**
+	* Simulate a scenario with each size of its ESS (a row of capacity, charge_power and discharge_power), returning a table
+	* with a row of metrics per size in RESULT_COLUMNS order (see Simulator::sweepESS)
+	*/
+	ResultTable sweepESS(const TaskData& taskData, const Eigen::Ref<const Eigen::Matrix<float, Eigen::Dynamic, 3, Eigen::RowMajor>>& sizes);
+
+	/**
+	* Optimistic bounds on the objectives of each scenario, without running the balancing loop (see Simulator::boundObjectives)
+	*/
+	std::vector<ObjectiveBounds> boundObjectives(const std::vector<TaskData>& taskData);
+
+	/**
+	* The derivative of each objective of a scenario with respect to each perturbation (see Simulator::sensitivities)
+	*/
+	SensitivityResult sensitivities(const TaskData& taskData, const std::vector<Perturbation>& perturbations, bool central = true);
+
+	/**
+	* Simulate every combination of replacing the components of start with those of end (see Simulator::simulateUpgradeTree)
+	* The components default to every component that differs, and the nodes are keyed by bitstrings in the order of the components
+	*/
+	std::map<std::string, SimulationResult> simulateUpgradeTree(const TaskData& start, const TaskData& end,
+		const std::optional<std::vector<std::string>>& components = std::nullopt);
+
+	/**
+	* Decode a 2D array of chromosomes and simulate them as a batch, without creating any python objects per scenario
+	*/
+	std::vector<SimulationResult> simulateChromosomes(const ScenarioCodec& codec, const Eigen::Ref<const Chromosomes>& chromosomes, bool fullReporting = false,
+		const std::optional<ScenarioConstraints>& constraints = std::nullopt, BatchControl* control = nullptr);
 	CapexBreakdown calculateCapexWithDiscounts(const TaskData& taskData);
+
+	/**
+	* Create a new Simulator with a different config that shares this Simulator's SiteData
+	*/
+	Simulator_py withConfig(const TaskConfig& taskConfig) const;
+
+	/**
+	* Create a new Simulator of this site with an ensemble of alternative weather and demand
+	* Each matrix has a column per member (and a row per timestep), and solarYields has one matrix per member
+	*/
+	Simulator_py withEnsemble(const std::optional<Eigen::MatrixXf>& airTemperature, const std::optional<Eigen::MatrixXf>& buildingEload,
+		const std::optional<Eigen::MatrixXf>& buildingHload, const std::vector<Eigen::MatrixXf>& solarYields) const;
+
+	/**
+	* Add an import tariff or a solar yield to the site, returning its index
+	* This Simulator is updated in place (see Simulator::withSiteUpdate), so only what depends on the new column is derived.
+	* Simulations already running (and Simulators shared through simulator()) keep the SiteData they started with.
+	*/
+	size_t addImportTariff(const Eigen::VectorXf& tariff);
+	size_t addSolarYield(const Eigen::VectorXf& yield);
+
+	/**
+	* Replace SiteData columns in place, by name (such as "grid_co2" or "import_tariffs[1]")
+	* The baseline is only simulated again if it reads one of the columns
+	*/
+	void replaceColumns(const std::map<std::string, Eigen::VectorXf>& columns);
+
+	/**
+	* Simulate a scenario against every member of the ensemble, returning the spread of its objectives
+	*/
+	EnsembleResult simulateEnsemble(const TaskData& taskData, BatchControl* control = nullptr);
+
+	/**
+	* A Simulator of the same site with a coarser timestep of intervalSeconds, which is built on first use and then shared
+	*/
+	Simulator_py atResolution(long long intervalSeconds) const;
+
+	/**
+	* The start of each timestep in nanoseconds since the unix epoch, as a read-only int64 array (see Simulator::getTimestamps)
+	* The array shares the Simulator's index rather than copying it
+	*/
+	pybind11::array timestamps() const;
+
+	/**
+	* The (estimated) memory in bytes held by the SiteData
+	*/
+	size_t siteDataMemoryFootprint() const;
+
+	/**
+	* The (estimated) memory in bytes held by each part of the Simulator, in the order of Simulator::memoryBreakdown
+	*/
+	pybind11::dict memoryFootprint() const;
+
+	/**
+	* Cache the baseline in a directory, keyed by the content of the SiteData and config
+	*/
+	void enableBaselineCache(const std::filesystem::path& directory);
+	// whether the baseline has been simulated yet (it is simulated for the first scenario)
+	bool hasBaseline() const;
+
+	/**
+	* Cache the results of scenarios within the Simulator, using at most maxBytes
+	*/
+	void enableResultCache(size_t maxBytes);
+	std::optional<CacheStats> resultCacheStats() const;
+	void clearResultCache();
+
+	/**
+	* Cache the state before the balancing loop, using at most maxBytes
+	*/
+	void enablePreBalancingCache(size_t maxBytes);
+	std::optional<CacheStats> preBalancingCacheStats() const;
+	void clearPreBalancingCache();
+
+	/**
+	* Step a CONSUME ESS in parallel blocks on the shared thread pool
+	*/
+	void enableParallelESS();
+	void disableParallelESS();
+
+	/**
+	* Overlap the independent stages of each FullReporting scenario on the shared thread pool
+	*/
+	void enableLowLatency();
+	void disableLowLatency();
+
+	/**
+	* Balance the lock-step scenarios of each batch with a backend: "cpu", or "cuda" on the given device
+	*/
+	void enableBatchBackend(const std::string& backend, int device);
+	void disableBatchBackend();
+	// the name of the batch backend, if one is enabled
+	std::optional<std::string> batchBackend() const;
+
+	/**
+	* Choose numDays representative days for screening scenarios with simulateRepresentativeDays
+	*/
+	void enableRepresentativeDays(size_t numDays);
+	std::optional<RepresentativeDays> representativeDays() const;
+
+	/**
+	* Simulate a list of scenarios on the representative days, in parallel
+	*/
+	std::vector<SimulationResult> simulateRepresentativeDays(const std::vector<TaskData>& taskData);
+
+	/**
+	* The largest error of the representative days against a full simulation of each scenario in the sample
+	*/
+	std::vector<RepresentativeDaysError> representativeDaysError(const std::vector<TaskData>& sample);
+
+	/**
+	* The underlying Simulator, so that it can be shared with a PortfolioSimulator
+	* This is not a use of the Simulator (see acquire()), so must not be simulated with while it may be changed in place
+	*/
+	std::shared_ptr<const Simulator> simulator() const;
+
+	/**
+	* The underlying Simulator, held as a use until the last copy of the pointer is dropped
+	* The methods that change the Simulator in place (such as enableResultCache) wait until no use of it is held.
+	*/
+	std::shared_ptr<Simulator> acquire() const;
+
 	const TaskConfig config;
 
 private:
-	explicit Simulator_py(SiteData&& siteData, TaskConfig config);
+	explicit Simulator_py(std::shared_ptr<const SiteData> siteData, TaskConfig config);
+	explicit Simulator_py(std::shared_ptr<Simulator> simulator, TaskConfig config);
+
+	// replace the Simulator with one with the columns of the update (made from the current Simulator) changed
+	void update(const std::function<SiteUpdate(const Simulator&)>& makeUpdate);
+
+	// change the Simulator in place, once no simulation is using it
+	template <typename Change>
+	void modify(Change change);
+
+	/**
+	* The Simulator and the simulations using it, shared by the copies of this Simulator_py
+	*
+	* Methods may be called from several threads at once (in a free-threaded build, or while another call has released the GIL),
+	* so simulations hold a use of the Simulator for as long as they run and the Simulator is only changed in place once there are none.
+	* Updating the SiteData replaces the Simulator instead, so simulations already running keep the one they started with.
+	*/
+	struct Shared {
+		explicit Shared(std::shared_ptr<Simulator> simulator) : simulator(std::move(simulator)) {}
+
+		std::mutex mutex;
+		std::condition_variable released;
+		std::shared_ptr<Simulator> simulator;
+		size_t uses = 0;
+		// held for the whole of an update, so that one made at the same time isn't lost
+		std::mutex updating;
+	};
 
-	Simulator mSimulator;
+	std::shared_ptr<Shared> mShared;
 };
 
 
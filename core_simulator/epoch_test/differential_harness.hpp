@@ -0,0 +1,376 @@
+#pragma once
+
+/**
+* A differential harness for the fast paths of the Simulator
+*
+* Each fast path (the batch, the lockstep balancing, the parallel ESS, the caches, the representative days...)
+* is run over the same randomised scenarios as the reference path, simulateScenario with full reporting
+* one scenario at a time, and every metric and ReportData column is compared within the path's tolerances.
+* Each path is also timed, so that a report carries both its correctness and its speed up over the reference.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+#include <optional>
+#include <random>
+#include <span>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <Eigen/Core>
+
+#include "../epoch_lib/Definitions.hpp"
+#include "../epoch_lib/Simulation/Simulate.hpp"
+#include "../epoch_lib/Simulation/ThreadPool.hpp"
+#include "../epoch_lib/io/ResultTable.hpp"
+
+namespace differential {
+
+	// a value matches if it is within absolute + relative * (the larger magnitude) of the reference
+	struct Tolerance {
+		float relative = 0.0f;
+		float absolute = 0.0f;
+
+		static Tolerance exact() { return {}; }
+		// the field isn't compared
+		static Tolerance ignore() { return { 0.0f, std::numeric_limits<float>::infinity() }; }
+
+		bool matches(double expected, double actual) const {
+			if (std::isnan(expected) || std::isnan(actual)) {
+				return std::isnan(expected) && std::isnan(actual);
+			}
+			if (std::isinf(absolute)) {
+				return true;
+			}
+			return std::abs(expected - actual) <= absolute + relative * std::max(std::abs(expected), std::abs(actual));
+		}
+	};
+
+	// the tolerance of each field: a metric (named as in resultColumns) or a ReportData column (as in REPORT_COLUMN_NAMES)
+	struct Tolerances {
+		Tolerance metrics;
+		Tolerance columns;
+		std::map<std::string, Tolerance, std::less<>> fields;
+
+		Tolerance of(std::string_view field, bool isColumn) const {
+			auto it = fields.find(field);
+			if (it != fields.end()) {
+				return it->second;
+			}
+			return isColumn ? columns : metrics;
+		}
+	};
+
+	struct FastPath {
+		std::string name;
+		// simulate every scenario on the site, in order
+		std::function<std::vector<SimulationResult>(std::shared_ptr<const SiteData>, std::span<const TaskData>)> simulate;
+		Tolerances tolerances;
+	};
+
+	struct Mismatch {
+		size_t scenario;
+		std::string field;
+		// the timestep of a ReportData column, or -1 for a metric
+		Eigen::Index timestep;
+		double expected;
+		double actual;
+	};
+
+	struct PathReport {
+		std::string name;
+		std::vector<Mismatch> mismatches;
+		// the ReportData columns that were compared, across every scenario
+		size_t columnsCompared = 0;
+		double seconds = 0.0;
+		double referenceSeconds = 0.0;
+
+		double speedUp() const { return seconds > 0.0 ? referenceSeconds / seconds : 0.0; }
+	};
+
+	/**
+	* A site with the lookup tables, baseline and fabric interventions of base, but random timeseries of the same length
+	* The loads vary through each day (and from day to day), and the solar yields are zero at night.
+	*/
+	inline SiteData randomSiteData(std::mt19937& rng, const SiteData& base) {
+		const Eigen::Index n = static_cast<Eigen::Index>(base.timesteps);
+		const double stepsPerDay = std::max(1.0, 86400.0 / static_cast<double>(base.timestep_interval_s.count()));
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+		// a daily shape scaled by a random level each day, plus noise
+		auto series = [&](float mean, float dailySwing, float noise) {
+			Eigen::VectorXf values(n);
+			float level = 1.0f;
+			for (Eigen::Index t = 0; t < n; t++) {
+				if (t % static_cast<Eigen::Index>(stepsPerDay) == 0) {
+					level = 0.5f + unit(rng);
+				}
+				const double phase = 2.0 * 3.14159265358979 * static_cast<double>(t) / stepsPerDay;
+				const float shape = 1.0f + dailySwing * static_cast<float>(std::sin(phase - 1.5));
+				values[t] = std::max(0.0f, mean * level * shape + noise * mean * (unit(rng) - 0.5f));
+			}
+			return values;
+		};
+		auto solar = [&]() {
+			Eigen::VectorXf values = series(0.3f, 1.0f, 0.2f);
+			for (Eigen::Index t = 0; t < n; t++) {
+				const double hour = std::fmod(static_cast<double>(t) * 24.0 / stepsPerDay, 24.0);
+				if (hour < 6.0 || hour >= 19.0) {
+					values[t] = 0.0f;
+				}
+			}
+			return values;
+		};
+
+		std::vector<SiteSeries> solarYields;
+		for (size_t i = 0; i < std::max<size_t>(base.solar_yields.size(), 1); i++) {
+			solarYields.emplace_back(solar());
+		}
+		std::vector<SiteSeries> importTariffs;
+		for (size_t i = 0; i < std::max<size_t>(base.import_tariffs.size(), 1); i++) {
+			importTariffs.emplace_back(Eigen::VectorXf(series(0.25f, 0.5f, 0.4f)));
+		}
+		std::vector<FabricIntervention> fabricInterventions = base.fabric_interventions;
+		const Eigen::VectorXf heatLoad = series(20.0f, 0.6f, 0.3f);
+		for (auto& intervention : fabricInterventions) {
+			intervention.reduced_hload = SiteSeries(Eigen::VectorXf(heatLoad * (0.5f + 0.4f * unit(rng))));
+			intervention.hload_delta.reset();
+		}
+
+		// (drawn in turn, so the site is the same whichever order the arguments are evaluated in)
+		Eigen::VectorXf electricalLoad = series(15.0f, 0.5f, 0.3f);
+		Eigen::VectorXf evLoad = series(5.0f, 0.8f, 0.5f);
+		Eigen::VectorXf hotWater = series(3.0f, 0.8f, 0.5f);
+		Eigen::VectorXf airTemperature = series(10.0f, 0.3f, 0.2f);
+		Eigen::VectorXf gridCarbon = series(200.0f, 0.3f, 0.2f);
+
+		return SiteData(
+			base.start_ts, base.end_ts, base.baseline,
+			std::move(electricalLoad),
+			heatLoad,
+			heatLoad.maxCoeff(),
+			std::move(evLoad),
+			std::move(hotWater),
+			std::move(airTemperature),
+			std::move(gridCarbon),
+			std::move(solarYields),
+			std::move(importTariffs),
+			std::move(fabricInterventions),
+			base.ashp_input_table,
+			base.ashp_output_table
+		);
+	}
+
+	/**
+	* A random scenario that the simulator accepts: each component is present with even odds, with random sizes
+	*/
+	inline TaskData randomTaskData(std::mt19937& rng, const Simulator& simulator) {
+		const SiteData& site = *simulator.getSiteData();
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+		auto coin = [&] { return unit(rng) < 0.5f; };
+		auto between = [&](float lo, float hi) { return lo + (hi - lo) * unit(rng); };
+		auto index = [&](size_t count) { return static_cast<size_t>(unit(rng) * static_cast<float>(count)) % std::max<size_t>(count, 1); };
+
+		for (;;) {
+			TaskData td;
+			td.building = Building{ between(0.5f, 2.0f), between(0.5f, 2.0f), index(site.fabric_interventions.size() + 1) };
+			td.grid = GridData{ between(20.0f, 200.0f), between(20.0f, 200.0f), between(0.0f, 0.5f), index(site.import_tariffs.size()) };
+			if (coin()) {
+				td.energy_storage_system = EnergyStorageSystem{ between(10.0f, 500.0f), between(5.0f, 200.0f), between(5.0f, 200.0f),
+					static_cast<BatteryMode>(index(4)), between(0.0f, 10.0f) };
+			}
+			if (coin()) {
+				td.electric_vehicles = ElectricVehicles{ coin() ? 0.0f : between(0.0f, 1.0f), index(4), index(6), index(3), index(2), between(0.5f, 3.0f) };
+			}
+			if (coin()) {
+				td.data_centre = DataCentreData{ between(10.0f, 100.0f) };
+			}
+			if (coin()) {
+				td.domestic_hot_water = DomesticHotWater{ between(50.0f, 1000.0f) };
+			}
+			if (coin()) {
+				td.heat_pump = HeatPumpData{ between(5.0f, 100.0f),
+					td.data_centre && coin() ? HeatSource::HOTROOM : HeatSource::AMBIENT_AIR, between(45.0f, 70.0f) };
+			}
+			if (!td.heat_pump || coin()) {
+				td.gas_heater = GasCHData{ between(20.0f, 200.0f) };
+			}
+			if (coin()) {
+				td.mop = MopData{ between(50.0f, 300.0f) };
+			}
+			const size_t panels = index(4);
+			for (size_t i = 0; i < panels; i++) {
+				td.solar_panels.push_back(SolarData{ between(1.0f, 100.0f), static_cast<int>(index(site.solar_yields.size())) });
+			}
+
+			if (simulator.checkScenario(td) == ScenarioError::None) {
+				return td;
+			}
+		}
+	}
+
+	// the reference: each scenario simulated on its own, with full reporting, on a Simulator without any caches
+	inline std::vector<SimulationResult> simulateReference(std::shared_ptr<const SiteData> site, std::span<const TaskData> tasks) {
+		const Simulator simulator(std::move(site), TaskConfig{});
+		std::vector<SimulationResult> results;
+		results.reserve(tasks.size());
+		for (const TaskData& task : tasks) {
+			results.push_back(simulator.simulateScenario(task, SimulationType::FullReporting));
+		}
+		return results;
+	}
+
+	/**
+	* Compare one path's results with the reference's
+	* Every metric is compared; the ReportData columns are compared if the path reported them
+	*/
+	inline void compare(const std::vector<SimulationResult>& reference, const std::vector<SimulationResult>& results,
+		const Tolerances& tolerances, PathReport& report)
+	{
+		for (size_t i = 0; i < std::min(reference.size(), results.size()); i++) {
+			for (const ResultColumn& column : resultColumns()) {
+				const double expected = column.value(reference[i]);
+				const double actual = column.value(results[i]);
+				if (!tolerances.of(column.name, false).matches(expected, actual)) {
+					report.mismatches.push_back({ i, std::string(column.name), -1, expected, actual });
+				}
+			}
+
+			if (!results[i].report_data || !reference[i].report_data) {
+				continue;
+			}
+			const ReportData& expectedReport = *reference[i].report_data;
+			const ReportData& actualReport = *results[i].report_data;
+			for (ReportColumn col : expectedReport.populatedColumns()) {
+				const std::string name = REPORT_COLUMN_NAMES[static_cast<size_t>(col)];
+				const auto expected = expectedReport.get(col);
+				const auto actual = actualReport.get(col);
+				if (actual.size() != expected.size()) {
+					report.mismatches.push_back({ i, name, -1, static_cast<double>(expected.size()), static_cast<double>(actual.size()) });
+					continue;
+				}
+				report.columnsCompared++;
+				const Tolerance tolerance = tolerances.of(name, true);
+				for (Eigen::Index t = 0; t < expected.size(); t++) {
+					if (!tolerance.matches(expected[t], actual[t])) {
+						// one mismatch per column is enough to find it
+						report.mismatches.push_back({ i, name, t, expected[t], actual[t] });
+						break;
+					}
+				}
+			}
+		}
+		if (results.size() != reference.size()) {
+			report.mismatches.push_back({ results.size(), "scenarios", -1,
+				static_cast<double>(reference.size()), static_cast<double>(results.size()) });
+		}
+	}
+
+	template <typename F>
+	double secondsOf(F&& f) {
+		const auto start = std::chrono::steady_clock::now();
+		f();
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	/**
+	* Run the reference and every path over the tasks, returning a report for each path
+	*/
+	inline std::vector<PathReport> runDifferential(std::shared_ptr<const SiteData> site, std::span<const TaskData> tasks,
+		std::span<const FastPath> paths)
+	{
+		std::vector<SimulationResult> reference;
+		const double referenceSeconds = secondsOf([&] { reference = simulateReference(site, tasks); });
+
+		std::vector<PathReport> reports;
+		for (const FastPath& path : paths) {
+			PathReport& report = reports.emplace_back();
+			report.name = path.name;
+			report.referenceSeconds = referenceSeconds;
+			std::vector<SimulationResult> results;
+			report.seconds = secondsOf([&] { results = path.simulate(site, tasks); });
+			compare(reference, results, path.tolerances, report);
+		}
+		return reports;
+	}
+
+	// a table of each path's mismatches and speed up, and the first few mismatches of each
+	inline std::string formatReports(std::span<const PathReport> reports, size_t mismatchesPerPath = 5) {
+		std::ostringstream out;
+		for (const PathReport& report : reports) {
+			out << report.name << ": " << report.mismatches.size() << " mismatches, "
+				<< report.columnsCompared << " columns compared, "
+				<< report.seconds << "s (" << report.speedUp() << "x the reference)\n";
+			for (size_t i = 0; i < std::min(report.mismatches.size(), mismatchesPerPath); i++) {
+				const Mismatch& m = report.mismatches[i];
+				out << "  scenario " << m.scenario << " " << m.field;
+				if (m.timestep >= 0) {
+					out << "[" << m.timestep << "]";
+				}
+				out << ": expected " << m.expected << ", got " << m.actual << "\n";
+			}
+		}
+		return out.str();
+	}
+
+	/**
+	* The fast paths of the Simulator, each with the tolerances it is documented to meet
+	*/
+	inline std::vector<FastPath> standardFastPaths(ThreadPool& pool) {
+		std::vector<FastPath> paths;
+
+		// the results of a batch are exactly those of simulating each scenario on its own
+		paths.push_back({ "batch", [&pool](std::shared_ptr<const SiteData> site, std::span<const TaskData> tasks) {
+			const Simulator simulator(std::move(site), TaskConfig{});
+			return simulator.simulateBatch(tasks, SimulationType::FullReporting, pool);
+		}, {} });
+
+		// result only batches balance the CONSUME and flexible EV scenarios in lockstep
+		paths.push_back({ "lockstep", [&pool](std::shared_ptr<const SiteData> site, std::span<const TaskData> tasks) {
+			const Simulator simulator(std::move(site), TaskConfig{});
+			return simulator.simulateBatch(tasks, SimulationType::ResultOnly, pool);
+		}, {} });
+
+		paths.push_back({ "parallel_ess", [&pool](std::shared_ptr<const SiteData> site, std::span<const TaskData> tasks) {
+			Simulator simulator(std::move(site), TaskConfig{});
+			simulator.enableParallelESS(pool);
+			std::vector<SimulationResult> results;
+			for (const TaskData& task : tasks) {
+				results.push_back(simulator.simulateScenario(task, SimulationType::FullReporting));
+			}
+			return results;
+		}, {} });
+
+		// the second simulation of each scenario starts from the state the first cached (which is only for ResultOnly)
+		paths.push_back({ "pre_balancing_cache", [](std::shared_ptr<const SiteData> site, std::span<const TaskData> tasks) {
+			Simulator simulator(std::move(site), TaskConfig{});
+			simulator.enablePreBalancingCache(size_t{ 256 } << 20);
+			std::vector<SimulationResult> results;
+			for (const TaskData& task : tasks) {
+				simulator.simulateScenario(task, SimulationType::ResultOnly);
+				results.push_back(simulator.simulateScenario(task, SimulationType::ResultOnly));
+			}
+			return results;
+		}, {} });
+
+		paths.push_back({ "result_cache", [](std::shared_ptr<const SiteData> site, std::span<const TaskData> tasks) {
+			Simulator simulator(std::move(site), TaskConfig{});
+			simulator.enableResultCache(size_t{ 64 } << 20);
+			std::vector<SimulationResult> results;
+			for (const TaskData& task : tasks) {
+				simulator.simulateScenario(task, SimulationType::ResultOnly);
+				results.push_back(simulator.simulateScenario(task, SimulationType::ResultOnly));
+			}
+			return results;
+		}, {} });
+
+		return paths;
+	}
+}
@@ -0,0 +1,126 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <limits>
+#include <vector>
+
+#include "../epoch_lib/Simulation/Simulate.hpp"
+#include "../epoch_lib/Simulation/TariffPricing.hpp"
+#include "../epoch_lib/io/FileHandling.hpp"
+
+namespace fs = std::filesystem;
+
+class AllTariffsTest : public ::testing::Test {
+protected:
+	Simulator simulator;
+	size_t numTariffs;
+
+	AllTariffsTest() :
+		simulator(readSiteData(fs::path{ "./test_files/siteData_MountHotel.json" }), TaskConfig{}),
+		numTariffs(simulator.getSiteData()->import_tariffs.size())
+	{}
+
+	// compare against simulating each tariff separately
+	void expectMatchesEachTariff(const TaskData& taskData) {
+		auto results = simulator.simulateAllTariffs(taskData);
+		ASSERT_EQ(results.size(), numTariffs);
+
+		for (size_t i = 0; i < numTariffs; i++) {
+			TaskData td = taskData;
+			td.grid->tariff_index = i;
+			auto expected = simulator.simulateScenario(td);
+
+			const auto& a = results[i];
+			// the costs are summed in a different order, so may differ in the last few bits
+			EXPECT_FLOAT_EQ(a.metrics.total_electricity_imported, expected.metrics.total_electricity_imported);
+			EXPECT_FLOAT_EQ(a.metrics.total_capex, expected.metrics.total_capex);
+			EXPECT_NEAR(a.metrics.total_electricity_import_cost, expected.metrics.total_electricity_import_cost,
+				1e-5f * std::abs(expected.metrics.total_electricity_import_cost));
+			EXPECT_NEAR(a.metrics.total_annualised_cost, expected.metrics.total_annualised_cost,
+				1e-5f * std::abs(expected.metrics.total_annualised_cost));
+			EXPECT_NEAR(a.comparison.cost_balance, expected.comparison.cost_balance,
+				1e-4f * std::abs(expected.metrics.total_annualised_cost));
+			EXPECT_FLOAT_EQ(a.comparison.carbon_balance_scope_2, expected.comparison.carbon_balance_scope_2);
+		}
+	}
+};
+
+TEST_F(AllTariffsTest, DetectsTariffDependentDispatch) {
+	TaskData common = readTaskData(fs::path{ "./test_files/taskData_common.json" });
+	// the hot water cylinder is heated at the cheaper times of the day
+	EXPECT_FALSE(Simulator::isTariffIndependent(common));
+
+	common.domestic_hot_water.reset();
+	EXPECT_TRUE(Simulator::isTariffIndependent(common));
+
+	common.energy_storage_system->battery_mode = BatteryMode::CONSUME_PLUS;
+	EXPECT_FALSE(Simulator::isTariffIndependent(common));
+}
+
+TEST_F(AllTariffsTest, TariffIndependentMatchesEachTariff) {
+	ASSERT_GT(numTariffs, 1);
+	TaskData task = readTaskData(fs::path{ "./test_files/taskData_common.json" });
+	task.domestic_hot_water.reset();
+	ASSERT_TRUE(Simulator::isTariffIndependent(task));
+	expectMatchesEachTariff(task);
+}
+
+TEST_F(AllTariffsTest, TariffsGiveDifferentCosts) {
+	TaskData task = readTaskData(fs::path{ "./test_files/taskData_empty.json" });
+	auto results = simulator.simulateAllTariffs(task);
+	ASSERT_EQ(results.size(), numTariffs);
+	EXPECT_NE(results[0].metrics.total_electricity_import_cost, results[1].metrics.total_electricity_import_cost);
+	// but the energy flows are the same
+	EXPECT_EQ(results[0].metrics.total_electricity_imported, results[1].metrics.total_electricity_imported);
+}
+
+TEST_F(AllTariffsTest, TariffDependentMatchesEachTariff) {
+	TaskData task = readTaskData(fs::path{ "./test_files/taskData_common.json" });
+	ASSERT_FALSE(Simulator::isTariffIndependent(task));
+	expectMatchesEachTariff(task);
+}
+
+TEST_F(AllTariffsTest, InvalidScenarioGivesInvalidResults) {
+	TaskData task = readTaskData(fs::path{ "./test_files/taskData_empty.json" });
+	task.building->fabric_intervention_index = 99;
+
+	auto results = simulator.simulateAllTariffs(task);
+	ASSERT_EQ(results.size(), numTariffs);
+	for (const auto& result : results) {
+		EXPECT_EQ(result.metrics.total_capex, std::numeric_limits<float>::max());
+	}
+}
+
+TEST_F(AllTariffsTest, PatternPricingMatchesTheDenseProduct) {
+	SiteData siteData = *simulator.getSiteData();
+	// a flat tariff, a day/night tariff and one that changes every timestep
+	Eigen::VectorXf varying = Eigen::VectorXf::LinSpaced(static_cast<Eigen::Index>(siteData.timesteps), 0.1f, 0.4f);
+	siteData.import_tariffs.push_back(varying);
+	ASSERT_TRUE(siteData.importTariffPattern(0).has_value());
+	ASSERT_TRUE(siteData.importTariffPattern(1).has_value());
+	ASSERT_FALSE(siteData.importTariffPattern(2).has_value());
+
+	const TariffPricing pricing(siteData);
+	ASSERT_EQ(pricing.size(), 3);
+	// less than the dense matrix of every tariff
+	EXPECT_LT(pricing.ownedBytes(), 2 * sizeof(float) * siteData.timesteps);
+
+	const Eigen::Index timesteps = static_cast<Eigen::Index>(siteData.timesteps);
+	const Eigen::VectorXf imp = Eigen::VectorXf::LinSpaced(timesteps, 0.0f, 5.0f);
+	TariffPricing::Sums sums = pricing.start();
+	// in uneven blocks, so that they don't line up with the days
+	for (Eigen::Index start = 0; start < timesteps; start += 100) {
+		const Eigen::Index n = std::min<Eigen::Index>(100, timesteps - start);
+		pricing.add(sums, start, imp.segment(start, n));
+	}
+	Eigen::VectorXf costs;
+	pricing.costs(sums, costs);
+
+	ASSERT_EQ(costs.size(), 3);
+	for (Eigen::Index i = 0; i < 3; i++) {
+		const double expected = imp.cast<double>().dot(siteData.import_tariffs[static_cast<size_t>(i)].cast<double>());
+		EXPECT_NEAR(costs[i], expected, 1e-5 * expected) << "tariff " << i;
+	}
+}
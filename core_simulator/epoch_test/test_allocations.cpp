@@ -0,0 +1,150 @@
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+#include "../epoch_lib/Simulation/Simulate.hpp"
+#include "../epoch_lib/Simulation/TimeseriesPool.hpp"
+#include "../epoch_lib/io/FileHandling.hpp"
+
+namespace fs = std::filesystem;
+
+#if defined(__GLIBC__)
+// count the allocations made by this thread (operator new and Eigen both allocate through malloc)
+namespace {
+	thread_local bool tCounting = false;
+	thread_local uint64_t tAllocations = 0;
+}
+
+extern "C" void* __libc_malloc(size_t size);
+
+extern "C" void* malloc(size_t size) {
+	if (tCounting) {
+		tAllocations++;
+	}
+	return __libc_malloc(size);
+}
+
+constexpr bool COUNTS_ALLOCATIONS = true;
+#else
+constexpr bool COUNTS_ALLOCATIONS = false;
+#endif
+
+namespace {
+	// the number of allocations made by f on this thread
+	template <typename F>
+	uint64_t allocationsOf(F&& f) {
+#if defined(__GLIBC__)
+		tAllocations = 0;
+		tCounting = true;
+		f();
+		tCounting = false;
+		return tAllocations;
+#else
+		f();
+		return 0;
+#endif
+	}
+}
+
+TEST(TimeseriesPool, ReusesReleasedBuffers) {
+	TimeseriesPool::clear();
+
+	const float* data = nullptr;
+	{
+		PooledTS first(100);
+		data = first.data();
+	}
+	EXPECT_EQ(TimeseriesPool::size(), 1u);
+
+	// a buffer of the same size is reused and zeroed
+	PooledTS second(100, 2.0f);
+	EXPECT_EQ(second.data(), data);
+	EXPECT_EQ(second, Eigen::VectorXf::Constant(100, 2.0f));
+	EXPECT_EQ(TimeseriesPool::size(), 0u);
+
+	// but not one of a different size
+	{
+		PooledTS other(50);
+		EXPECT_NE(other.data(), data);
+	}
+	EXPECT_EQ(TimeseriesPool::size(), 1u);
+	TimeseriesPool::clear();
+}
+
+TEST(TimeseriesPool, BehavesAsAVector) {
+	PooledTS a(4, 1.0f);
+	PooledTS b = a * 2.0f;
+	EXPECT_EQ(b, Eigen::VectorXf::Constant(4, 2.0f));
+
+	// a copy has its own buffer, a move takes the other's
+	PooledTS copy = b;
+	EXPECT_NE(copy.data(), b.data());
+	const float* data = b.data();
+	PooledTS moved = std::move(b);
+	EXPECT_EQ(moved.data(), data);
+
+	// assigning a different size replaces the buffer, even from an expression of itself
+	a = a.head(2) * 3.0f;
+	EXPECT_EQ(a, Eigen::VectorXf::Constant(2, 3.0f));
+
+	PooledTS empty;
+	empty = Eigen::VectorXf::Constant(3, 1.0f);
+	EXPECT_EQ(empty.size(), 3);
+}
+
+TEST(TimeseriesPool, HoldsABoundedNumberOfBuffers) {
+	TimeseriesPool::clear();
+	{
+		std::vector<PooledTS> many;
+		for (size_t i = 0; i < TimeseriesPool::MAX_BUFFERS + 10; i++) {
+			many.emplace_back(8);
+		}
+	}
+	EXPECT_EQ(TimeseriesPool::size(), TimeseriesPool::MAX_BUFFERS);
+	TimeseriesPool::clear();
+	EXPECT_EQ(TimeseriesPool::size(), 0u);
+}
+
+TEST(Allocations, RepeatedScenariosDoNotAllocate) {
+	if (!COUNTS_ALLOCATIONS) {
+		GTEST_SKIP() << "Allocations are only counted with glibc";
+	}
+
+	Simulator simulator(readSiteData(fs::path{ "./test_files/siteData_MountHotel.json" }), TaskConfig{});
+	const TaskData full = readTaskData(fs::path{ "./test_files/taskData_full.json" });
+	const TaskData common = readTaskData(fs::path{ "./test_files/taskData_common.json" });
+
+	// the first scenario on a thread fills its pool
+	TimeseriesPool::clear();
+	SimulationResult first;
+	EXPECT_GT(allocationsOf([&] { first = simulator.simulateScenario(full); }), 0u);
+
+	SimulationResult second;
+	EXPECT_EQ(allocationsOf([&] { second = simulator.simulateScenario(full); }), 0u);
+	EXPECT_EQ(second.metrics.total_annualised_cost, first.metrics.total_annualised_cost);
+	EXPECT_EQ(second.comparison.cost_balance, first.comparison.cost_balance);
+
+	// a scenario with fewer components reuses the same buffers
+	simulator.simulateScenario(common);
+	EXPECT_EQ(allocationsOf([&] { simulator.simulateScenario(common); }), 0u);
+	EXPECT_EQ(allocationsOf([&] { simulator.simulateScenario(full); }), 0u);
+}
+
+TEST(Allocations, TaskDataCopiesDoNotAllocate) {
+	if (!COUNTS_ALLOCATIONS) {
+		GTEST_SKIP() << "Allocations are only counted with glibc";
+	}
+
+	const TaskData full = readTaskData(fs::path{ "./test_files/taskData_full.json" });
+	ASSERT_FALSE(full.solar_panels.empty());
+	ASSERT_FALSE(full.solar_panels.onHeap());
+
+	TaskData copy;
+	EXPECT_EQ(allocationsOf([&] { copy = full; }), 0u);
+	EXPECT_EQ(allocationsOf([&] { TaskData another = copy; another.solar_panels.push_back(SolarData{}); }), 0u);
+	EXPECT_EQ(allocationsOf([&] { std::hash<TaskData>{}(copy); }), 0u);
+	EXPECT_EQ(copy, full);
+}
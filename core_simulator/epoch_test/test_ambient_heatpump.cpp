@@ -0,0 +1,148 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+
+#include "../epoch_lib/Simulation/ASHPLookup.hpp"
+#include "../epoch_lib/Simulation/HeatPumpController.hpp"
+#include "../epoch_lib/Simulation/TempSum.hpp"
+#include "../epoch_lib/io/FileHandling.hpp"
+
+namespace fs = std::filesystem;
+
+class AmbientHeatPumpTest : public ::testing::Test {
+protected:
+    SiteData siteData;
+    ASHPLookup reference;
+    HeatPumpProfile profile;
+
+    AmbientHeatPumpTest() :
+        siteData(readSiteData(fs::path{ "./test_files/siteData_MountHotel.json" })),
+        reference(siteData, 1.0f, FIXED_SEND_TEMP_VAL),
+        profile(makeAmbientHeatPumpProfile(siteData, reference))
+    {}
+
+    TempSum makeDemand() const {
+        // vary the demand so that some timesteps are met in full and others exceed the heatpump
+        TempSum tempSum(siteData);
+        for (Eigen::Index t = 0; t < tempSum.Heat_h.size(); t++) {
+            tempSum.DHW_load_h[t] = static_cast<float>(t % 7);
+            tempSum.Heat_h[t] = static_cast<float>(t % 13) * 2.5f;
+        }
+        return tempSum;
+    }
+};
+
+TEST_F(AmbientHeatPumpTest, ProfileMatchesLookup) {
+    HeatPumpData hp;
+    hp.heat_power = 15.0f;
+    ASHPLookup lookup(siteData, hp, FIXED_SEND_TEMP_VAL);
+    const float powerScalar = hp.heat_power * siteData.timestep_hours;
+
+    ASSERT_EQ(profile.heat_h.size(), static_cast<Eigen::Index>(siteData.timesteps));
+    for (Eigen::Index t = 0; t < profile.heat_h.size(); t++) {
+        HeatpumpValues expected = lookup.Lookup(siteData.air_temperature[t]);
+        EXPECT_EQ(profile.heat_h[t] * powerScalar, expected.Heat_h);
+        EXPECT_EQ(profile.load_e[t] * powerScalar, expected.Load_e);
+    }
+}
+
+TEST_F(AmbientHeatPumpTest, AllCalcsMatchesPerTimestepLookup) {
+    for (bool suppliesDHW : {true, false}) {
+        HeatPumpData hp;
+        hp.heat_power = 12.0f;
+
+        TempSum tempSum = makeDemand();
+        const TempSum demand = tempSum;
+        AmbientHeatPumpController controller(siteData, hp, suppliesDHW, profile);
+        controller.AllCalcs(tempSum);
+
+        // recalculate each timestep with a scalar lookup
+        ASHPLookup lookup(siteData, hp, FIXED_SEND_TEMP_VAL);
+        for (Eigen::Index t = 0; t < tempSum.Heat_h.size(); t++) {
+            HeatpumpValues perf = lookup.Lookup(siteData.air_temperature[t]);
+
+            float dhwOut = 0.0f, dhwLoad = 0.0f, residual = 1.0f;
+            if (suppliesDHW) {
+                if (perf.Heat_h <= 0) {
+                    residual = 0.0f;
+                }
+                else if (demand.DHW_load_h[t] <= perf.Heat_h) {
+                    dhwOut = demand.DHW_load_h[t];
+                    dhwLoad = perf.Load_e * dhwOut / perf.Heat_h;
+                    residual = 1 - dhwOut / perf.Heat_h;
+                }
+                else {
+                    dhwOut = perf.Heat_h;
+                    dhwLoad = perf.Load_e;
+                    residual = 0.0f;
+                }
+            }
+
+            float maxHeat = perf.Heat_h * residual;
+            float maxLoad = perf.Load_e * residual;
+            float chOut = 0.0f, chLoad = 0.0f;
+            if (maxHeat > 0) {
+                if (demand.Heat_h[t] <= maxHeat) {
+                    chOut = demand.Heat_h[t];
+                    chLoad = maxLoad * chOut / maxHeat;
+                }
+                else {
+                    chOut = maxHeat;
+                    chLoad = maxLoad;
+                }
+            }
+
+            EXPECT_EQ(tempSum.DHW_load_h[t], demand.DHW_load_h[t] - dhwOut);
+            EXPECT_EQ(tempSum.Heat_h[t], demand.Heat_h[t] - chOut);
+            EXPECT_EQ(tempSum.Elec_e[t], demand.Elec_e[t] + dhwLoad + chLoad);
+        }
+    }
+}
+
+TEST_F(AmbientHeatPumpTest, ReferenceTableScalesLazily) {
+    // a heatpump's table is the reference table scaled by its power per timestep
+    HeatPumpData hp;
+    hp.heat_power = 42.0f;
+    ASHPLookup lookup(siteData, hp, FIXED_SEND_TEMP_VAL);
+    const float powerScalar = hp.heat_power * siteData.timestep_hours;
+
+    for (float temp = -30.0f; temp <= 50.0f; temp += 0.25f) {
+        HeatpumpValues expected = lookup.Lookup(temp);
+        HeatpumpValues scaled = reference.Lookup(temp, powerScalar);
+        EXPECT_EQ(scaled.Heat_h, expected.Heat_h);
+        EXPECT_EQ(scaled.Load_e, expected.Load_e);
+    }
+}
+
+TEST_F(AmbientHeatPumpTest, HotRoomProfileMatchesLookup) {
+    const float powerScalar = 30.0f * siteData.timestep_hours;
+    const HotRoomProfile hotRoom = makeHotRoomProfile(reference, profile, powerScalar, 43.0f);
+
+    HeatpumpValues expected = reference.Lookup(43.0f, powerScalar);
+    EXPECT_EQ(hotRoom.hotRoom.Heat_h, expected.Heat_h);
+    EXPECT_EQ(hotRoom.hotRoom.Load_e, expected.Load_e);
+
+    ASSERT_EQ(hotRoom.ambient.load_e.size(), profile.load_e.size());
+    for (Eigen::Index t = 0; t < profile.load_e.size(); t++) {
+        EXPECT_EQ(hotRoom.ambient.heat_h[t], profile.heat_h[t] * powerScalar);
+        EXPECT_EQ(hotRoom.ambient.load_e[t], profile.load_e[t] * powerScalar);
+    }
+}
+
+TEST_F(AmbientHeatPumpTest, HotRoomProfilesAreShared) {
+    HotRoomProfileCache cache;
+    auto first = cache.get(reference, profile, 10.0f, 43.0f);
+    EXPECT_EQ(cache.get(reference, profile, 10.0f, 43.0f), first);
+    EXPECT_NE(cache.get(reference, profile, 20.0f, 43.0f), first);
+    EXPECT_NE(cache.get(reference, profile, 10.0f, 50.0f), first);
+    EXPECT_EQ(cache.size(), 3u);
+
+    // once full the cache is cleared, but the profiles that are held remain valid
+    for (size_t i = 0; cache.size() < HotRoomProfileCache::MAX_ENTRIES; i++) {
+        cache.get(reference, profile, 100.0f + static_cast<float>(i), 43.0f);
+    }
+    cache.get(reference, profile, 1.0f, 1.0f);
+    EXPECT_EQ(cache.size(), 1u);
+    EXPECT_EQ(first->ambient.load_e[0], profile.load_e[0] * 10.0f);
+    EXPECT_NE(cache.get(reference, profile, 10.0f, 43.0f), first);
+}
@@ -0,0 +1,143 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include <Eigen/Core>
+
+#include "test_helpers.hpp"
+
+#include "../epoch_lib/Simulation/Simulate.hpp"
+#include "../epoch_lib/Simulation/TimestampIndex.hpp"
+#include "../epoch_lib/io/ArrowExport.hpp"
+#include "../epoch_lib/io/FileHandling.hpp"
+
+namespace fs = std::filesystem;
+
+TEST(TimestampIndex, StartsEachTimestepAnIntervalAfterTheLast) {
+	const SiteData siteData = makeNHourSiteData(48);
+	const TimestampIndex index = makeTimestampIndex(siteData);
+	ASSERT_EQ(index.size(), 48);
+	// 2022-01-01T00:00:00Z
+	EXPECT_EQ(index[0], int64_t{ 1640995200 } * 1'000'000'000);
+	EXPECT_EQ(index[47] - index[46], int64_t{ 3600 } * 1'000'000'000);
+	EXPECT_EQ(index[47], index[0] + 47 * int64_t{ 3600 } * 1'000'000'000);
+}
+
+TEST(TimestampIndex, IsMadeOncePerSimulator) {
+	const Simulator simulator(readSiteData(fs::path{ "./test_files/siteData_MountHotel.json" }), TaskConfig{});
+	const auto timestamps = simulator.getTimestamps();
+	ASSERT_EQ(timestamps->size(), static_cast<Eigen::Index>(simulator.getSiteData()->timesteps));
+	EXPECT_EQ(simulator.getTimestamps(), timestamps);
+
+	// as are the Simulators with other configs
+	TaskConfig config;
+	config.general_grant_funding = 1000.0f;
+	EXPECT_EQ(simulator.withConfig(config)->getTimestamps(), timestamps);
+}
+
+class ArrowExportTest : public ::testing::Test {
+protected:
+	ArrowExportTest() {
+		reportData.set(ReportColumn::Grid_Import, Eigen::VectorXf::LinSpaced(24, 0.0f, 23.0f));
+		reportData.set(ReportColumn::Hotel_load, Eigen::VectorXf::Constant(24, 2.0f));
+		reportData.shrinkToPopulated();
+		timestamps = std::make_shared<const TimestampIndex>(makeTimestampIndex(makeNHourSiteData(24)));
+	}
+
+	ReportData reportData;
+	std::shared_ptr<const TimestampIndex> timestamps;
+};
+
+TEST_F(ArrowExportTest, ExportsEachColumnWithoutCopying) {
+	auto owner = std::make_shared<int>(0);
+	std::weak_ptr<int> alive = owner;
+	const ArrowReportExport source(reportData, timestamps, owner);
+	owner.reset();
+
+	ArrowSchema schema;
+	source.exportSchema(&schema);
+	EXPECT_STREQ(schema.format, "+s");
+	ASSERT_EQ(schema.n_children, 3);
+	EXPECT_STREQ(schema.children[0]->name, ARROW_TIMESTAMP_COLUMN);
+	EXPECT_STREQ(schema.children[0]->format, "tsn:UTC");
+	// the columns are in the ReportColumn order
+	EXPECT_STREQ(schema.children[1]->name, "Hotel_load");
+	EXPECT_STREQ(schema.children[1]->format, "f");
+	EXPECT_STREQ(schema.children[2]->name, "Grid_Import");
+	schema.release(&schema);
+	EXPECT_EQ(schema.release, nullptr);
+
+	ArrowArray array;
+	source.exportArray(&array);
+	EXPECT_EQ(array.length, 24);
+	ASSERT_EQ(array.n_children, 3);
+	EXPECT_EQ(array.children[0]->buffers[1], timestamps->data());
+	EXPECT_EQ(array.children[1]->buffers[1], reportData.get(ReportColumn::Hotel_load).data());
+	EXPECT_EQ(array.children[2]->buffers[1], reportData.get(ReportColumn::Grid_Import).data());
+	EXPECT_EQ(array.children[2]->null_count, 0);
+	EXPECT_EQ(array.children[2]->buffers[0], nullptr);
+
+	// a consumer can move a column out and keep it after releasing the batch
+	ArrowArray column;
+	std::memcpy(&column, array.children[2], sizeof(ArrowArray));
+	array.children[2]->release = nullptr;
+	array.release(&array);
+	EXPECT_FALSE(alive.expired());
+	EXPECT_EQ(static_cast<const float*>(column.buffers[1])[5], 5.0f);
+	column.release(&column);
+	// only the source still holds the owner
+	EXPECT_EQ(alive.use_count(), 1);
+}
+
+TEST_F(ArrowExportTest, StreamsOneBatch) {
+	ArrowArrayStream stream;
+	ArrowReportExport(reportData, nullptr, nullptr).exportStream(&stream);
+
+	ArrowSchema schema;
+	ASSERT_EQ(stream.get_schema(&stream, &schema), 0);
+	EXPECT_EQ(schema.n_children, 2);
+	schema.release(&schema);
+
+	ArrowArray array;
+	ASSERT_EQ(stream.get_next(&stream, &array), 0);
+	ASSERT_NE(array.release, nullptr);
+	EXPECT_EQ(array.length, 24);
+	array.release(&array);
+
+	ASSERT_EQ(stream.get_next(&stream, &array), 0);
+	EXPECT_EQ(array.release, nullptr);
+	EXPECT_EQ(stream.get_last_error(&stream), nullptr);
+	stream.release(&stream);
+	EXPECT_EQ(stream.release, nullptr);
+}
+
+TEST_F(ArrowExportTest, RejectsAnIndexOfTheWrongLength) {
+	auto shorter = std::make_shared<const TimestampIndex>(makeTimestampIndex(makeNHourSiteData(12)));
+	EXPECT_THROW(ArrowReportExport(reportData, shorter, nullptr), std::runtime_error);
+
+	// an empty ReportData is just the index
+	const ReportData empty;
+	ArrowArray array;
+	ArrowReportExport(empty, shorter, nullptr).exportArray(&array);
+	EXPECT_EQ(array.length, 12);
+	EXPECT_EQ(array.n_children, 1);
+	array.release(&array);
+}
+
+TEST(ArrowExport, ExportsAFullReport) {
+	const Simulator simulator(readSiteData(fs::path{ "./test_files/siteData_MountHotel.json" }), TaskConfig{});
+	const TaskData taskData = readTaskData(fs::path{ "./test_files/taskData_full.json" });
+	const auto result = std::make_shared<const SimulationResult>(simulator.simulateScenario(taskData, SimulationType::FullReporting));
+	ASSERT_TRUE(result->report_data.has_value());
+
+	ArrowArray array;
+	ArrowReportExport(*result->report_data, simulator.getTimestamps(), result).exportArray(&array);
+	EXPECT_EQ(array.length, static_cast<int64_t>(simulator.getSiteData()->timesteps));
+	EXPECT_EQ(array.n_children, result->report_data->numPopulated() + 1);
+	array.release(&array);
+}
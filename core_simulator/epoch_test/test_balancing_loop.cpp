@@ -0,0 +1,388 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <vector>
+
+#include <Eigen/Core>
+
+#include "../epoch_lib/Simulation/BalancingLoop.hpp"
+#include "../epoch_lib/Simulation/LockstepBalancing.hpp"
+#include "../epoch_lib/Simulation/DayTariffStats.hpp"
+#include "../epoch_lib/Simulation/Simulate.hpp"
+#include "../epoch_lib/Simulation/ThreadPool.hpp"
+#include "../epoch_lib/Simulation/Components/ESS/SoCScan.hpp"
+#include "../epoch_lib/io/FileHandling.hpp"
+
+namespace fs = std::filesystem;
+
+/**
+* The balancing loop kernels are specialised per scenario shape
+* These tests check that they step the components exactly as the generic StepCalc would
+*/
+class BalancingLoopTest : public ::testing::Test {
+protected:
+	SiteData siteData;
+	DayTariffStats tariffStats;
+
+	BalancingLoopTest() :
+		siteData(readSiteData(fs::path{ "./test_files/siteData_MountHotel.json" })),
+		tariffStats(siteData, 0)
+	{}
+
+	// An electrical balance that alternates between surplus demand and surplus generation
+	TempSum makeTempSum() const {
+		TempSum tempSum{ siteData };
+		tempSum.Elec_e = siteData.building_eload - 3.0f * siteData.solar_yields[0] * 50.0f;
+		return tempSum;
+	}
+};
+
+TEST_F(BalancingLoopTest, ESSKernelsMatchStepCalc) {
+	for (BatteryMode mode : { BatteryMode::CONSUME, BatteryMode::CONSUME_PLUS }) {
+		EnergyStorageSystem essData{};
+		essData.capacity = 200.0f;
+		essData.charge_power = 50.0f;
+		essData.discharge_power = 50.0f;
+		essData.battery_mode = mode;
+
+		TempSum expected = makeTempSum();
+		BasicESS genericESS{ siteData, essData, 0, tariffStats, ReportColumnMask::all() };
+		for (size_t t = 0; t < siteData.timesteps; t++) {
+			genericESS.StepCalc(expected, 100.0f, t);
+		}
+
+		TempSum actual = makeTempSum();
+		BasicESS kernelESS{ siteData, essData, 0, tariffStats, ReportColumnMask::all() };
+		runBalancingLoop(actual, siteData.timesteps, 100.0f, &kernelESS, nullptr, nullptr);
+
+		EXPECT_EQ(actual.Elec_e, expected.Elec_e);
+
+		ReportData expectedReport{};
+		ReportData actualReport{};
+		genericESS.Report(expectedReport);
+		kernelESS.Report(actualReport);
+		EXPECT_EQ(actualReport.get(ReportColumn::ESS_resulting_SoC), expectedReport.get(ReportColumn::ESS_resulting_SoC));
+	}
+}
+
+TEST_F(BalancingLoopTest, ConsumePlusMatchesTheBranchingStep) {
+	EnergyStorageSystem essData{};
+	essData.capacity = 200.0f;
+	essData.charge_power = 50.0f;
+	essData.discharge_power = 50.0f;
+	essData.battery_mode = BatteryMode::CONSUME_PLUS;
+
+	// the second tariff varies through the day (the first is a fixed price, so never tops up)
+	const DayTariffStats stats{ siteData, 1 };
+
+	// the branching step, comparing the tariff with its daily statistics at every timestep
+	TempSum expected = makeTempSum();
+	Battery battery{ siteData, essData, ReportColumnMask{} };
+	const auto& tariff = siteData.import_tariffs[1];
+	const float futureEnergy_e = 100.0f;
+	size_t topUps = 0;
+	for (size_t t = 0; t < siteData.timesteps; t++) {
+		const auto i = static_cast<Eigen::Index>(t);
+		if (tariff[i] < stats.getDayAverage(t) && tariff[i] <= stats.getDayPercentile(t)
+			&& battery.GetSoC() / battery.GetCapacity_e() < 0.75f) {
+			float charge = std::min(battery.GetCapacity_e() * 0.75f, battery.getAvailableCharge());
+			charge = std::min(charge, futureEnergy_e - expected.Elec_e[i]);
+			battery.doCharge(charge, t);
+			expected.Elec_e[i] += charge;
+			topUps++;
+		}
+		else if (expected.Elec_e[i] >= 0) {
+			const float discharge = std::min(expected.Elec_e[i], battery.getAvailableDischarge());
+			battery.doDischarge(discharge, t);
+			expected.Elec_e[i] -= discharge;
+		}
+		else {
+			const float charge = std::min(-expected.Elec_e[i], battery.getAvailableCharge());
+			battery.doCharge(charge, t);
+			expected.Elec_e[i] += charge;
+		}
+	}
+	ASSERT_GT(topUps, 0u);
+
+	TempSum actual = makeTempSum();
+	BasicESS ess{ siteData, essData, 1, stats, ReportColumnMask{} };
+	runBalancingLoop(actual, siteData.timesteps, futureEnergy_e, &ess, nullptr, nullptr);
+
+	EXPECT_EQ(actual.Elec_e, expected.Elec_e);
+	EXPECT_EQ(ess.getBattery().GetSoC(), battery.GetSoC());
+}
+
+TEST_F(BalancingLoopTest, LookaheadKernelsMatchStepCalc) {
+	// the second tariff varies through the day, and the grid carbon is given the same shape (it is flat in the test site)
+	SiteData varying = siteData;
+	varying.grid_co2 = SiteSeries(year_TS(siteData.import_tariffs[1]));
+	const DayTariffStats stats{ varying, 1 };
+
+	for (BatteryMode mode : { BatteryMode::PRICE_LOOKAHEAD, BatteryMode::CARBON_LOOKAHEAD }) {
+		EnergyStorageSystem essData{};
+		essData.capacity = 200.0f;
+		essData.charge_power = 50.0f;
+		essData.discharge_power = 50.0f;
+		essData.battery_mode = mode;
+		SCOPED_TRACE(static_cast<int>(mode));
+
+		TempSum expected = makeTempSum();
+		BasicESS genericESS{ varying, essData, 1, stats, ReportColumnMask::all() };
+		for (size_t t = 0; t < siteData.timesteps; t++) {
+			genericESS.StepCalc(expected, 100.0f, t);
+		}
+
+		const TempSum before = makeTempSum();
+		TempSum actual = makeTempSum();
+		BasicESS kernelESS{ varying, essData, 1, stats, ReportColumnMask::all() };
+		runBalancingLoop(actual, siteData.timesteps, 100.0f, &kernelESS, nullptr, nullptr);
+		EXPECT_EQ(actual.Elec_e, expected.Elec_e);
+
+		// at the lowest timesteps the battery charges from the grid, beyond any surplus generation
+		ReportData report{};
+		kernelESS.Report(report);
+		const auto charge = report.get(ReportColumn::ESS_charge);
+		size_t gridCharges = 0;
+		for (size_t t = 0; t < siteData.timesteps; t++) {
+			const auto i = static_cast<Eigen::Index>(t);
+			const bool lowest = mode == BatteryMode::PRICE_LOOKAHEAD ? stats.isLookaheadCheapest(t) : stats.isLookaheadLowCarbon(t);
+			if (charge[i] > std::max(-before.Elec_e[i], 0.0f)) {
+				EXPECT_TRUE(lowest) << "timestep " << t;
+				gridCharges++;
+			}
+		}
+		EXPECT_GT(gridCharges, 0u);
+	}
+}
+
+TEST_F(BalancingLoopTest, EVAndDataCentreMatchStepCalc) {
+	EnergyStorageSystem essData{};
+	ElectricVehicles evData{};
+	DataCentreData dcData{};
+
+	TempSum expected = makeTempSum();
+	{
+		BasicESS ess{ siteData, essData, 0, tariffStats, ReportColumnMask{} };
+		BasicElectricVehicle ev{ siteData, evData };
+		BasicDataCentre dc{ siteData, dcData };
+		for (size_t t = 0; t < siteData.timesteps; t++) {
+			float futureEnergy = 100.0f + ess.AvailDisch() - dc.getTargetLoad(t);
+			ev.StepCalc(expected, futureEnergy, t);
+			futureEnergy = 100.0f + ess.AvailDisch();
+			dc.StepCalc(expected, futureEnergy, t);
+			ess.StepCalc(expected, 100.0f, t);
+		}
+	}
+
+	TempSum actual = makeTempSum();
+	{
+		BasicESS ess{ siteData, essData, 0, tariffStats, ReportColumnMask{} };
+		BasicElectricVehicle ev{ siteData, evData };
+		BasicDataCentre dc{ siteData, dcData };
+		runBalancingLoop(actual, siteData.timesteps, 100.0f, &ess, &ev, &dc);
+	}
+
+	EXPECT_EQ(actual.Elec_e, expected.Elec_e);
+}
+
+TEST_F(BalancingLoopTest, WholeTimeseriesStepsMatchStepCalc) {
+	// without an ESS, the EV and data centre are calculated over every timestep at once
+	ElectricVehicles evData{};
+	evData.flexible_load_ratio = 0.4f;
+	evData.scalar_electrical_load = 30.0f;
+	DataCentreData dcData{};
+	dcData.maximum_load = 40.0f;
+
+	for (bool withEV : { true, false }) {
+		for (bool withDataCentre : { true, false }) {
+			if (!withEV && !withDataCentre) {
+				continue;
+			}
+			SCOPED_TRACE(withEV);
+			SCOPED_TRACE(withDataCentre);
+
+			TempSum expected = makeTempSum();
+			BasicElectricVehicle expectedEV{ siteData, evData };
+			BasicDataCentre expectedDC{ siteData, dcData };
+			for (size_t t = 0; t < siteData.timesteps; t++) {
+				if (withEV) {
+					expectedEV.StepCalc(expected, 60.0f - (withDataCentre ? expectedDC.getTargetLoad(t) : 0.0f), t);
+				}
+				if (withDataCentre) {
+					expectedDC.StepCalc(expected, 60.0f, t);
+				}
+			}
+
+			TempSum actual = makeTempSum();
+			BasicElectricVehicle actualEV{ siteData, evData };
+			BasicDataCentre actualDC{ siteData, dcData };
+			runBalancingLoop(actual, siteData.timesteps, 60.0f, nullptr,
+				withEV ? &actualEV : nullptr, withDataCentre ? &actualDC : nullptr);
+
+			EXPECT_EQ(actual.Elec_e, expected.Elec_e);
+			ReportData expectedReport{};
+			ReportData actualReport{};
+			expectedEV.Report(expectedReport);
+			expectedDC.Report(expectedReport);
+			actualEV.Report(actualReport);
+			actualDC.Report(actualReport);
+			EXPECT_EQ(actualReport.get(ReportColumn::EV_actualload), expectedReport.get(ReportColumn::EV_actualload));
+			EXPECT_EQ(actualReport.get(ReportColumn::Data_centre_actual_load), expectedReport.get(ReportColumn::Data_centre_actual_load));
+		}
+	}
+
+	// a data centre with no grid import to use is switched off
+	TempSum tempSum = makeTempSum();
+	const year_TS before = tempSum.Elec_e;
+	BasicDataCentre dc{ siteData, dcData };
+	runBalancingLoop(tempSum, siteData.timesteps, 0.0f, nullptr, nullptr, &dc);
+	EXPECT_EQ(tempSum.Elec_e, before);
+}
+
+TEST_F(BalancingLoopTest, LockstepMatchesBalancingLoop) {
+	// lanes with different ESS and EV parameters, some with initial charge
+	std::vector<EnergyStorageSystem> essData(5);
+	std::vector<ElectricVehicles> evData(5);
+	for (size_t l = 0; l < essData.size(); l++) {
+		essData[l].capacity = 50.0f + 100.0f * static_cast<float>(l);
+		essData[l].charge_power = 20.0f + 15.0f * static_cast<float>(l);
+		essData[l].discharge_power = 60.0f - 10.0f * static_cast<float>(l);
+		essData[l].initial_charge = l % 2 ? essData[l].capacity / 2 : 0.0f;
+		evData[l].flexible_load_ratio = 0.1f + 0.2f * static_cast<float>(l);
+		evData[l].scalar_electrical_load = 5.0f;
+	}
+
+	for (bool withESS : { true, false }) {
+		for (bool withEV : { true, false }) {
+			if (!withESS && !withEV) {
+				continue;
+			}
+
+			std::vector<TempSum> expected, actual;
+			std::vector<BasicESS> ess;
+			std::vector<BasicElectricVehicle> ev;
+			for (size_t l = 0; l < essData.size(); l++) {
+				expected.push_back(makeTempSum());
+				actual.push_back(makeTempSum());
+				ess.emplace_back(siteData, essData[l], 0, tariffStats, ReportColumnMask{});
+				ev.emplace_back(siteData, evData[l]);
+
+				BasicESS scalarESS{ siteData, essData[l], 0, tariffStats, ReportColumnMask{} };
+				BasicElectricVehicle scalarEV{ siteData, evData[l] };
+				runBalancingLoop(expected[l], siteData.timesteps, 100.0f + static_cast<float>(l),
+					withESS ? &scalarESS : nullptr, withEV ? &scalarEV : nullptr, nullptr);
+			}
+
+			std::vector<LockstepLane> lanes;
+			for (size_t l = 0; l < essData.size(); l++) {
+				lanes.push_back({ &actual[l], 100.0f + static_cast<float>(l), withESS ? &ess[l] : nullptr, withEV ? &ev[l] : nullptr });
+			}
+			runLockstepBalancingLoop(lanes, siteData.timesteps);
+
+			for (size_t l = 0; l < essData.size(); l++) {
+				EXPECT_EQ(actual[l].Elec_e, expected[l].Elec_e) << "lane " << l << " withESS " << withESS << " withEV " << withEV;
+			}
+		}
+	}
+}
+
+TEST_F(BalancingLoopTest, LockstepRejectsMixedLanes) {
+	EnergyStorageSystem essData{};
+	TempSum a = makeTempSum();
+	TempSum b = makeTempSum();
+	BasicESS ess{ siteData, essData, 0, tariffStats, ReportColumnMask{} };
+	std::vector<LockstepLane> lanes = { { &a, 100.0f, &ess, nullptr }, { &b, 100.0f, nullptr, nullptr } };
+	EXPECT_THROW(runLockstepBalancingLoop(lanes, siteData.timesteps), std::runtime_error);
+
+	essData.battery_mode = BatteryMode::CONSUME_PLUS;
+	BasicESS consumePlus{ siteData, essData, 0, tariffStats, ReportColumnMask{} };
+	lanes = { { &a, 100.0f, &consumePlus, nullptr } };
+	EXPECT_THROW(runLockstepBalancingLoop(lanes, siteData.timesteps), std::runtime_error);
+}
+
+TEST_F(BalancingLoopTest, ComposedSoCMapsMatchTheSteps) {
+	EnergyStorageSystem essData{};
+	essData.capacity = 200.0f;
+	essData.charge_power = 50.0f;
+	essData.discharge_power = 30.0f;
+	const Battery battery{ siteData, essData, ReportColumnMask{} };
+	const ConsumeParams params{ battery };
+	const TempSum tempSum = makeTempSum();
+
+	// from empty, full and part way, the composed map lands within rounding of stepping through
+	for (float initial : { 0.0f, 200.0f, 73.5f }) {
+		SoCMap map{};
+		float soc = initial;
+		for (size_t t = 0; t < siteData.timesteps; t++) {
+			map = map.then(params.map(tempSum.Elec_e[t]));
+			soc = params.step(tempSum.Elec_e[t], soc).soc;
+			ASSERT_NEAR(map(initial), soc, 1e-3f) << "timestep " << t;
+		}
+	}
+}
+
+TEST_F(BalancingLoopTest, ConsumeScanMatchesTheBalancingLoop) {
+	ThreadPool pool{ 4 };
+
+	// a battery that empties most days, and a large one (starting full) that never does
+	std::vector<EnergyStorageSystem> essData(2);
+	essData[0].capacity = 200.0f;
+	essData[0].charge_power = 50.0f;
+	essData[0].discharge_power = 50.0f;
+	essData[1].capacity = 1e6f;
+	essData[1].charge_power = 500.0f;
+	essData[1].discharge_power = 500.0f;
+	essData[1].initial_charge = 1e6f;
+
+	for (const auto& ess : essData) {
+		for (size_t minBlock : { size_t{ 1 }, size_t{ 64 }, siteData.timesteps }) {
+			SCOPED_TRACE(minBlock);
+			TempSum expected = makeTempSum();
+			BasicESS sequential{ siteData, ess, 0, tariffStats, ReportColumnMask::all() };
+			runBalancingLoop(expected, siteData.timesteps, 100.0f, &sequential, nullptr, nullptr);
+
+			TempSum actual = makeTempSum();
+			BasicESS scanned{ siteData, ess, 0, tariffStats, ReportColumnMask::all() };
+			runConsumeScan(scanned, actual, siteData.timesteps, pool, minBlock);
+
+			EXPECT_EQ(actual.Elec_e, expected.Elec_e);
+			EXPECT_EQ(scanned.getBattery().GetSoC(), sequential.getBattery().GetSoC());
+
+			ReportData expectedReport{};
+			ReportData actualReport{};
+			sequential.Report(expectedReport);
+			scanned.Report(actualReport);
+			for (ReportColumn column : { ReportColumn::ESS_charge, ReportColumn::ESS_discharge,
+				ReportColumn::ESS_resulting_SoC, ReportColumn::ESS_RTL }) {
+				EXPECT_EQ(actualReport.get(column), expectedReport.get(column));
+			}
+		}
+	}
+}
+
+TEST_F(BalancingLoopTest, ParallelESSGivesTheSameResult) {
+	const TaskData taskData = readTaskData(fs::path{ "./test_files/taskData_common.json" });
+	ASSERT_EQ(taskData.energy_storage_system->battery_mode, BatteryMode::CONSUME);
+
+	Simulator sequential{ siteData, TaskConfig{} };
+	Simulator parallel{ siteData, TaskConfig{} };
+	ThreadPool pool{ 4 };
+	parallel.enableParallelESS(pool);
+
+	const auto expected = sequential.simulateScenario(taskData, SimulationType::FullReporting);
+	const auto actual = parallel.simulateScenario(taskData, SimulationType::FullReporting);
+	EXPECT_EQ(actual.metrics.total_electricity_imported, expected.metrics.total_electricity_imported);
+	EXPECT_EQ(actual.metrics.total_electricity_exported, expected.metrics.total_electricity_exported);
+	EXPECT_EQ(actual.metrics.total_annualised_cost, expected.metrics.total_annualised_cost);
+	EXPECT_EQ(actual.report_data->get(ReportColumn::ESS_resulting_SoC), expected.report_data->get(ReportColumn::ESS_resulting_SoC));
+}
+
+TEST_F(BalancingLoopTest, NothingToBalanceLeavesTempSumUnchanged) {
+	TempSum tempSum = makeTempSum();
+	const year_TS before = tempSum.Elec_e;
+
+	runBalancingLoop(tempSum, siteData.timesteps, 100.0f, nullptr, nullptr, nullptr);
+
+	EXPECT_EQ(tempSum.Elec_e, before);
+}
@@ -0,0 +1,122 @@
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "../epoch_lib/Simulation/Simulate.hpp"
+#include "../epoch_lib/io/BaselineCache.hpp"
+#include "../epoch_lib/io/FileHandling.hpp"
+
+namespace fs = std::filesystem;
+
+class BaselineCacheTest : public ::testing::Test {
+protected:
+	std::shared_ptr<const SiteData> siteData = std::make_shared<const SiteData>(readSiteData(fs::path{ "./test_files/siteData_MountHotel.json" }));
+	TaskData taskData = readTaskData(fs::path{ "./test_files/taskData_full.json" });
+	TaskConfig config{};
+	fs::path dir;
+
+	void SetUp() override {
+		dir = fs::temp_directory_path() / ("epoch_baseline_cache_" + std::string(::testing::UnitTest::GetInstance()->current_test_info()->name()));
+		fs::remove_all(dir);
+	}
+
+	void TearDown() override {
+		fs::remove_all(dir);
+	}
+
+	size_t cachedFiles() const {
+		size_t count = 0;
+		if (fs::exists(dir)) {
+			for (const auto& entry : fs::directory_iterator(dir)) {
+				count += entry.path().extension() == ".baseline" ? 1 : 0;
+			}
+		}
+		return count;
+	}
+};
+
+TEST_F(BaselineCacheTest, BaselineIsSimulatedWhenFirstNeeded) {
+	Simulator simulator(siteData, config);
+	Simulator eager(siteData, config);
+	const SimulatorBaseline expected = eager.getBaseline();
+	EXPECT_TRUE(eager.hasBaseline());
+
+	// validating a scenario and calculating its capex don't need the baseline
+	EXPECT_EQ(simulator.checkScenario(taskData), ScenarioError::None);
+	simulator.calculateCapexWithDiscounts(taskData);
+	EXPECT_FALSE(simulator.hasBaseline());
+
+	auto result = simulator.simulateScenario(taskData);
+	EXPECT_TRUE(simulator.hasBaseline());
+	EXPECT_EQ(result.baseline_metrics.total_annualised_cost, expected.metrics.total_annualised_cost);
+	EXPECT_EQ(result.comparison.cost_balance, eager.simulateScenario(taskData).comparison.cost_balance);
+}
+
+TEST_F(BaselineCacheTest, CachedBaselineMatchesTheSimulatedOne) {
+	Simulator uncached(siteData, config);
+	const auto expected = uncached.simulateScenario(taskData, SimulationType::FullReporting);
+
+	Simulator first(siteData, config);
+	first.enableBaselineCache(dir);
+	first.getBaseline();
+	EXPECT_EQ(cachedFiles(), 1);
+
+	Simulator second(siteData, config);
+	second.enableBaselineCache(dir);
+	const auto result = second.simulateScenario(taskData, SimulationType::FullReporting);
+
+	EXPECT_EQ(result.baseline_metrics.total_annualised_cost, expected.baseline_metrics.total_annualised_cost);
+	EXPECT_EQ(result.baseline_metrics.total_operating_cost, expected.baseline_metrics.total_operating_cost);
+	EXPECT_EQ(result.comparison.cost_balance, expected.comparison.cost_balance);
+	EXPECT_EQ(result.comparison.combined_carbon_balance, expected.comparison.combined_carbon_balance);
+	ASSERT_TRUE(result.baseline_report_data && expected.baseline_report_data);
+	EXPECT_EQ(result.baseline_report_data->presentMask(), expected.baseline_report_data->presentMask());
+	EXPECT_TRUE(result.baseline_report_data->populated() == expected.baseline_report_data->populated());
+}
+
+TEST_F(BaselineCacheTest, CachedBaselineIsNotSimulatedAgain) {
+	// a cached baseline that has been altered is compared against, which a re-simulated baseline would not be
+	SimulatorBaseline altered = Simulator(siteData, config).getBaseline();
+	altered.usage.total_meter_cost += 1000.0f;
+	altered.metrics.total_annualised_cost += 1000.0f;
+	storeCachedBaseline(dir, baselineCacheKey(*siteData, config), altered);
+
+	Simulator simulator(siteData, config);
+	simulator.enableBaselineCache(dir);
+	EXPECT_EQ(simulator.getBaseline().usage.total_meter_cost, altered.usage.total_meter_cost);
+	EXPECT_EQ(simulator.simulateScenario(taskData).baseline_metrics.total_annualised_cost, altered.metrics.total_annualised_cost);
+}
+
+TEST_F(BaselineCacheTest, KeyDependsOnTheContent) {
+	const ScenarioKey key = baselineCacheKey(*siteData, config);
+	EXPECT_EQ(baselineCacheKey(SiteData(*siteData), config), key);
+
+	TaskConfig otherConfig = config;
+	otherConfig.npv_time_horizon += 1;
+	EXPECT_NE(baselineCacheKey(*siteData, otherConfig), key);
+
+	SiteData otherSite = *siteData;
+	Eigen::VectorXf load = otherSite.building_eload;
+	load[0] += 1.0f;
+	otherSite.building_eload = SiteSeries(load);
+	EXPECT_NE(baselineCacheKey(otherSite, config), key);
+}
+
+TEST_F(BaselineCacheTest, CorruptFilesAreReplaced) {
+	const ScenarioKey key = baselineCacheKey(*siteData, config);
+	fs::create_directories(dir);
+	std::ofstream(dir / (key.toHex() + ".baseline"), std::ios::binary) << "not a baseline";
+
+	Simulator simulator(siteData, config);
+	simulator.enableBaselineCache(dir);
+	EXPECT_EQ(simulator.getBaseline().metrics.total_annualised_cost,
+		Simulator(siteData, config).getBaseline().metrics.total_annualised_cost);
+
+	const auto reloaded = loadCachedBaseline(dir, key, siteData->timesteps);
+	ASSERT_TRUE(reloaded.has_value());
+	EXPECT_EQ(reloaded->metrics.total_annualised_cost, simulator.getBaseline().metrics.total_annualised_cost);
+	EXPECT_FALSE(loadCachedBaseline(dir, key, siteData->timesteps + 1).has_value());
+}
@@ -0,0 +1,471 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <chrono>
+#include <filesystem>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "../epoch_lib/Simulation/BatchBackend.hpp"
+#include "../epoch_lib/Simulation/BatchControl.hpp"
+#include "../epoch_lib/Simulation/BatchPlan.hpp"
+#include "../epoch_lib/Simulation/LockstepBalancing.hpp"
+#include "../epoch_lib/Simulation/ScenarioCostModel.hpp"
+#include "../epoch_lib/Simulation/Simulate.hpp"
+#include "../epoch_lib/Simulation/ThreadPool.hpp"
+#include "../epoch_lib/io/FileHandling.hpp"
+
+namespace fs = std::filesystem;
+
+/**
+* Build a spread of scenarios from the test files so that the batch exercises several code paths
+*/
+static std::vector<TaskData> makeScenarios() {
+	TaskData empty = readTaskData(fs::path{ "./test_files/taskData_empty.json" });
+	TaskData common = readTaskData(fs::path{ "./test_files/taskData_common.json" });
+	TaskData full = readTaskData(fs::path{ "./test_files/taskData_full.json" });
+
+	std::vector<TaskData> scenarios;
+	for (int i = 0; i < 4; i++) {
+		scenarios.push_back(empty);
+		scenarios.push_back(common);
+		scenarios.push_back(full);
+	}
+
+	// and an invalid scenario, which should produce an invalid result rather than break the batch
+	TaskData invalid = common;
+	invalid.grid->tariff_index = 99;
+	scenarios.push_back(invalid);
+
+	return scenarios;
+}
+
+static void expectSameResult(const SimulationResult& a, const SimulationResult& b) {
+	EXPECT_EQ(a.metrics.total_capex, b.metrics.total_capex);
+	EXPECT_EQ(a.metrics.total_annualised_cost, b.metrics.total_annualised_cost);
+	EXPECT_EQ(a.comparison.carbon_balance_scope_1, b.comparison.carbon_balance_scope_1);
+	EXPECT_EQ(a.comparison.carbon_balance_scope_2, b.comparison.carbon_balance_scope_2);
+	EXPECT_EQ(a.comparison.cost_balance, b.comparison.cost_balance);
+	EXPECT_EQ(a.comparison.payback_horizon_years, b.comparison.payback_horizon_years);
+}
+
+class BatchSimulationRun : public ::testing::Test {
+protected:
+	Simulator simulator;
+	std::vector<TaskData> scenarios;
+
+	BatchSimulationRun() :
+		simulator(readSiteData(fs::path{ "./test_files/siteData_MountHotel.json" }), TaskConfig{}),
+		scenarios(makeScenarios())
+	{}
+};
+
+TEST_F(BatchSimulationRun, MatchesSerialResults) {
+	ThreadPool pool{ 4 };
+	auto batchResults = simulator.simulateBatch(scenarios, SimulationType::ResultOnly, pool);
+
+	ASSERT_EQ(batchResults.size(), scenarios.size());
+	for (size_t i = 0; i < scenarios.size(); i++) {
+		auto serialResult = simulator.simulateScenario(scenarios[i]);
+		expectSameResult(batchResults[i], serialResult);
+	}
+}
+
+TEST_F(BatchSimulationRun, FullReportingReturnsReportData) {
+	auto batchResults = simulator.simulateBatch(scenarios, SimulationType::FullReporting);
+
+	ASSERT_EQ(batchResults.size(), scenarios.size());
+	// the final scenario is invalid, so has no report data
+	for (size_t i = 0; i + 1 < scenarios.size(); i++) {
+		EXPECT_TRUE(batchResults[i].report_data.has_value());
+		EXPECT_NE(batchResults[i].baseline_report_data, nullptr);
+	}
+}
+
+TEST_F(BatchSimulationRun, EmptyBatch) {
+	std::vector<TaskData> none{};
+	EXPECT_TRUE(simulator.simulateBatch(none).empty());
+}
+
+TEST_F(BatchSimulationRun, ConcurrentSimulateScenarioIsThreadSafe) {
+	// simulateScenario is const, so concurrent calls on one Simulator should match a serial run
+	std::vector<SimulationResult> expected;
+	for (const auto& scenario : scenarios) {
+		expected.push_back(simulator.simulateScenario(scenario));
+	}
+
+	constexpr int numThreads = 4;
+	std::vector<std::vector<SimulationResult>> actual(numThreads);
+	std::vector<std::thread> threads;
+
+	for (int t = 0; t < numThreads; t++) {
+		threads.emplace_back([&, t]() {
+			for (const auto& scenario : scenarios) {
+				actual[t].push_back(simulator.simulateScenario(scenario));
+			}
+		});
+	}
+	for (auto& thread : threads) {
+		thread.join();
+	}
+
+	for (int t = 0; t < numThreads; t++) {
+		ASSERT_EQ(actual[t].size(), expected.size());
+		for (size_t i = 0; i < expected.size(); i++) {
+			expectSameResult(actual[t][i], expected[i]);
+		}
+	}
+}
+
+TEST_F(BatchSimulationRun, ConcurrentBatchesOnSharedPool) {
+	auto expected = simulator.simulateBatch(scenarios);
+
+	std::vector<std::vector<SimulationResult>> actual(3);
+	std::vector<std::thread> threads;
+	for (size_t t = 0; t < actual.size(); t++) {
+		threads.emplace_back([&, t]() {
+			actual[t] = simulator.simulateBatch(scenarios);
+		});
+	}
+	for (auto& thread : threads) {
+		thread.join();
+	}
+
+	for (const auto& results : actual) {
+		ASSERT_EQ(results.size(), expected.size());
+		for (size_t i = 0; i < expected.size(); i++) {
+			expectSameResult(results[i], expected[i]);
+		}
+	}
+}
+
+TEST_F(BatchSimulationRun, ControlWithoutCancellationMatchesTheBatch) {
+	auto expected = simulator.simulateBatch(scenarios);
+
+	for (SimulationType type : { SimulationType::ResultOnly, SimulationType::FullReporting }) {
+		SCOPED_TRACE(static_cast<int>(type));
+		BatchControl control;
+		auto results = simulator.simulateBatch(scenarios, type, ScenarioConstraints{}, control);
+		ASSERT_EQ(results.size(), expected.size());
+		for (size_t i = 0; i < expected.size(); i++) {
+			expectSameResult(results[i], expected[i]);
+			EXPECT_FALSE(results[i].cancelled);
+		}
+		EXPECT_EQ(control.total(), scenarios.size());
+		EXPECT_EQ(control.completed(), scenarios.size());
+		EXPECT_EQ(control.skipped(), 0u);
+	}
+}
+
+TEST_F(BatchSimulationRun, CancelledBatchSkipsEveryScenario) {
+	BatchControl cancelled;
+	cancelled.cancel();
+	BatchControl expired;
+	expired.setDeadline(BatchControl::Clock::now() - std::chrono::seconds(1));
+
+	for (BatchControl* control : { &cancelled, &expired }) {
+		EXPECT_TRUE(control->stopRequested());
+		auto results = simulator.simulateBatch(scenarios, SimulationType::ResultOnly, ScenarioConstraints{}, *control);
+		ASSERT_EQ(results.size(), scenarios.size());
+		for (const auto& result : results) {
+			EXPECT_TRUE(result.cancelled);
+			EXPECT_EQ(result.comparison.cost_balance, std::numeric_limits<float>::lowest());
+		}
+		EXPECT_EQ(control->total(), scenarios.size());
+		EXPECT_EQ(control->completed(), 0u);
+		EXPECT_EQ(control->skipped(), scenarios.size());
+	}
+	EXPECT_TRUE(cancelled.cancelled());
+	EXPECT_FALSE(expired.cancelled());
+	EXPECT_TRUE(expired.deadlinePassed());
+}
+
+TEST_F(BatchSimulationRun, CancelFromAnotherThread) {
+	// enough scenarios that the batch is still running when it is cancelled
+	std::vector<TaskData> many;
+	for (int i = 0; i < 20; i++) {
+		many.insert(many.end(), scenarios.begin(), scenarios.end());
+	}
+
+	ThreadPool pool{ 2 };
+	BatchControl control;
+	std::thread canceller([&]() {
+		while (control.completed() == 0) {
+			std::this_thread::yield();
+		}
+		control.cancel();
+	});
+	auto results = simulator.simulateBatch(many, SimulationType::ResultOnly, ScenarioConstraints{}, control, pool);
+	canceller.join();
+
+	ASSERT_EQ(results.size(), many.size());
+	EXPECT_EQ(control.completed() + control.skipped(), many.size());
+	EXPECT_GT(control.completed(), 0u);
+
+	// the scenarios that finished are unaffected by the cancellation
+	for (size_t i = 0; i < many.size(); i++) {
+		if (!results[i].cancelled) {
+			expectSameResult(results[i], simulator.simulateScenario(many[i]));
+		}
+	}
+}
+
+TEST(ThreadPool, ParallelForVisitsEveryIndexOnce) {
+	ThreadPool pool{ 3 };
+	std::vector<std::atomic<int>> visits(1000);
+
+	pool.parallelFor(visits.size(), [&](size_t i) { visits[i]++; });
+
+	for (const auto& v : visits) {
+		EXPECT_EQ(v.load(), 1);
+	}
+}
+
+TEST(ThreadPool, NestedParallelFor) {
+	ThreadPool pool{ 2 };
+	std::atomic<int> total{ 0 };
+
+	pool.parallelFor(8, [&](size_t) {
+		pool.parallelFor(8, [&](size_t) { total++; });
+	});
+
+	EXPECT_EQ(total.load(), 64);
+}
+
+TEST(ThreadPool, ParallelForRethrows) {
+	ThreadPool pool{ 2 };
+	std::atomic<int> completed{ 0 };
+
+	EXPECT_THROW(
+		pool.parallelFor(16, [&](size_t i) {
+			if (i == 5) {
+				throw std::runtime_error("task failed");
+			}
+			completed++;
+		}),
+		std::runtime_error
+	);
+
+	// the remaining tasks should still have run
+	EXPECT_EQ(completed.load(), 15);
+}
+
+TEST(ThreadPool, ParallelForByCostVisitsEveryIndexOnce) {
+	ThreadPool pool{ 3 };
+	std::vector<std::atomic<int>> visits(1000);
+	std::vector<float> costs(visits.size());
+	std::vector<size_t> affinity(visits.size());
+	for (size_t i = 0; i < visits.size(); i++) {
+		costs[i] = static_cast<float>(i % 17);
+		affinity[i] = i % 5;
+	}
+
+	pool.parallelForByCost(costs, affinity, [&](size_t i) { visits[i]++; });
+	pool.parallelForByCost(costs, {}, [&](size_t i) { visits[i]++; });
+
+	for (const auto& v : visits) {
+		EXPECT_EQ(v.load(), 2);
+	}
+}
+
+TEST(ThreadPool, DealByCostIsLongestFirst) {
+	const std::vector<float> costs = { 1.0f, 8.0f, 2.0f, 9.0f, 3.0f };
+	const auto lanes = ThreadPool::dealByCost(costs, {}, 2);
+
+	// each job goes to the least loaded lane, longest first
+	ASSERT_EQ(lanes.size(), 2);
+	EXPECT_EQ(lanes[0], (std::deque<size_t>{ 3, 2, 0 }));
+	EXPECT_EQ(lanes[1], (std::deque<size_t>{ 1, 4 }));
+}
+
+TEST(ThreadPool, DealByCostKeepsAffinityUnlessItUnbalances) {
+	// two sites of four equal jobs each, on two lanes
+	const std::vector<float> costs(8, 1.0f);
+	const std::vector<size_t> affinity = { 0, 0, 0, 0, 1, 1, 1, 1 };
+	auto lanes = ThreadPool::dealByCost(costs, affinity, 2);
+	EXPECT_EQ(lanes[0], (std::deque<size_t>{ 0, 1, 2, 3 }));
+	EXPECT_EQ(lanes[1], (std::deque<size_t>{ 4, 5, 6, 7 }));
+
+	// one site on two lanes is still split between them
+	const std::vector<size_t> oneSite(8, 0);
+	lanes = ThreadPool::dealByCost(costs, oneSite, 2);
+	EXPECT_EQ(lanes[0].size(), 4);
+	EXPECT_EQ(lanes[1].size(), 4);
+}
+
+TEST(ThreadPool, DealByCostRunsEachAffinityTogether) {
+	const std::vector<float> costs = { 6.0f, 5.0f, 4.0f, 3.0f, 2.0f, 1.0f };
+	const std::vector<size_t> affinity = { 0, 1, 0, 1, 0, 1 };
+	const auto lanes = ThreadPool::dealByCost(costs, affinity, 1);
+
+	// the affinity of the longest job first, each longest first
+	EXPECT_EQ(lanes[0], (std::deque<size_t>{ 0, 2, 4, 1, 3, 5 }));
+}
+
+/**
+* A population in a random order: a scenario with a CONSUME ESS on each tariff, with and without solar, interleaved
+*/
+static std::vector<TaskData> makeMixedPopulation() {
+	const TaskData common = readTaskData(fs::path{ "./test_files/taskData_common.json" });
+	std::vector<TaskData> population;
+	for (size_t i = 0; i < 4 * LOCKSTEP_LANES; i++) {
+		TaskData scenario = common;
+		scenario.grid->tariff_index = i % 2;
+		if ((i / 2) % 2 == 1) {
+			scenario.solar_panels.clear();
+		}
+		scenario.energy_storage_system->capacity += static_cast<float>(i);
+		population.push_back(scenario);
+	}
+	return population;
+}
+
+TEST(BatchPlan, GroupsScenariosThatReadTheSameColumns) {
+	const std::vector<TaskData> population = makeMixedPopulation();
+
+	for (bool lockstep : { false, true }) {
+		const BatchPlan plan = planBatch(population, lockstep);
+		ASSERT_EQ(plan.affinity.size(), plan.jobs.size());
+
+		std::vector<int> seen(population.size(), 0);
+		for (size_t j = 0; j < plan.jobs.size(); j++) {
+			for (size_t i : plan.jobs[j]) {
+				seen[i]++;
+				// every scenario of a job reads the same columns as its first
+				EXPECT_EQ(batchLocality(population[i]).siteColumns(), plan.affinity[j]);
+			}
+		}
+		EXPECT_TRUE(std::all_of(seen.begin(), seen.end(), [](int count) { return count == 1; }));
+
+		// the jobs that read the same columns are next to each other
+		std::vector<size_t> runs;
+		for (size_t affinity : plan.affinity) {
+			if (runs.empty() || runs.back() != affinity) {
+				runs.push_back(affinity);
+			}
+		}
+		std::sort(runs.begin(), runs.end());
+		EXPECT_EQ(std::adjacent_find(runs.begin(), runs.end()), runs.end());
+	}
+
+	// the 4 combinations of tariff and solar, each balanced in lock-step
+	EXPECT_EQ(planBatch(population, true).jobs.size(), 4);
+}
+
+TEST_F(BatchSimulationRun, MixedPopulationMatchesSerialResults) {
+	const std::vector<TaskData> population = makeMixedPopulation();
+	const auto results = simulator.simulateBatch(population);
+	ASSERT_EQ(results.size(), population.size());
+	for (size_t i = 0; i < population.size(); i++) {
+		expectSameResult(results[i], simulator.simulateScenario(population[i]));
+	}
+}
+
+TEST(ThreadPool, ParallelForByCostRethrows) {
+	ThreadPool pool{ 2 };
+	std::atomic<int> completed{ 0 };
+	const std::vector<float> costs(16, 1.0f);
+
+	EXPECT_THROW(
+		pool.parallelForByCost(costs, {}, [&](size_t i) {
+			if (i == 5) {
+				throw std::runtime_error("task failed");
+			}
+			completed++;
+		}),
+		std::runtime_error
+	);
+	EXPECT_EQ(completed.load(), 15);
+
+	const std::vector<size_t> tooFew(3, 0);
+	EXPECT_THROW(pool.parallelForByCost(costs, tooFew, [](size_t) {}), std::invalid_argument);
+}
+
+TEST(ScenarioCostModel, LearnsEachMix) {
+	ScenarioCostModel model(17520);
+	const TaskData empty = readTaskData(fs::path{ "./test_files/taskData_empty.json" });
+	const TaskData full = readTaskData(fs::path{ "./test_files/taskData_full.json" });
+	ASSERT_NE(ScenarioCostModel::mixKey(empty), ScenarioCostModel::mixKey(full));
+
+	// before anything is observed, a scenario with more components is estimated to cost more
+	EXPECT_GT(model.estimate(full), model.estimate(empty));
+
+	model.observe(full, 0.01f);
+	EXPECT_FLOAT_EQ(model.estimate(full), 0.01f);
+	EXPECT_EQ(model.mixes(), 1);
+	// the estimate moves towards each new observation
+	model.observe(full, 0.02f);
+	EXPECT_GT(model.estimate(full), 0.01f);
+	EXPECT_LT(model.estimate(full), 0.02f);
+
+	// an unseen mix is scaled by what has been observed
+	EXPECT_GT(model.estimate(empty), 0.0f);
+	EXPECT_LT(model.estimate(empty), model.estimate(full));
+}
+
+TEST_F(BatchSimulationRun, BatchesTeachTheCostModel) {
+	const TaskData full = readTaskData(fs::path{ "./test_files/taskData_full.json" });
+	const float before = simulator.estimateRuntime(full);
+
+	ThreadPool pool{ 2 };
+	auto results = simulator.simulateBatch(scenarios, SimulationType::ResultOnly, pool);
+	ASSERT_EQ(results.size(), scenarios.size());
+
+	EXPECT_NE(simulator.estimateRuntime(full), before);
+	EXPECT_GT(simulator.estimateRuntime(full), 0.0f);
+}
+
+TEST_F(BatchSimulationRun, BatchBackendMatchesTheBatch) {
+	std::vector<TaskData> population = makeMixedPopulation();
+	// with a balancing EV as well, and scenarios that aren't balanced in lock-step
+	const TaskData common = readTaskData(fs::path{ "./test_files/taskData_common.json" });
+	for (size_t i = 0; i < LOCKSTEP_LANES + 3; i++) {
+		TaskData withEV = common;
+		withEV.electric_vehicles = ElectricVehicles{};
+		withEV.electric_vehicles->flexible_load_ratio = 0.5f;
+		withEV.energy_storage_system->capacity += static_cast<float>(i);
+		population.push_back(withEV);
+	}
+	population.insert(population.end(), scenarios.begin(), scenarios.end());
+
+	ThreadPool pool{ 4 };
+	const auto expected = simulator.simulateBatch(population, SimulationType::ResultOnly, pool);
+
+	// waves of a little over one group, so that both the waves and the backend's calls are split
+	simulator.enableBatchBackend(makeCpuBatchBackend(LOCKSTEP_LANES + 1));
+	ASSERT_NE(simulator.getBatchBackend(), nullptr);
+	EXPECT_EQ(simulator.getBatchBackend()->name(), "cpu");
+	BatchControl control;
+	const auto results = simulator.simulateBatch(population, SimulationType::ResultOnly, ScenarioConstraints{}, control, pool);
+	ASSERT_EQ(results.size(), population.size());
+	for (size_t i = 0; i < population.size(); i++) {
+		expectSameResult(results[i], expected[i]);
+	}
+	EXPECT_EQ(control.completed(), population.size());
+
+	simulator.disableBatchBackend();
+	EXPECT_EQ(simulator.getBatchBackend(), nullptr);
+}
+
+TEST_F(BatchSimulationRun, CancelledBatchBackendSkipsEveryScenario) {
+	simulator.enableBatchBackend(makeCpuBatchBackend());
+	const std::vector<TaskData> population = makeMixedPopulation();
+	BatchControl cancelled;
+	cancelled.cancel();
+	const auto results = simulator.simulateBatch(population, SimulationType::ResultOnly, ScenarioConstraints{}, cancelled);
+	for (const auto& result : results) {
+		EXPECT_TRUE(result.cancelled);
+	}
+	EXPECT_EQ(cancelled.skipped(), population.size());
+}
+
+TEST(BatchBackend, CudaNeedsTheBuildOption) {
+	EXPECT_THROW(makeCpuBatchBackend(0), std::invalid_argument);
+	if (!cudaSupported()) {
+		EXPECT_THROW(makeCudaBatchBackend(), std::runtime_error);
+	}
+}
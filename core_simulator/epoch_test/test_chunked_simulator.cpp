@@ -0,0 +1,190 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <Eigen/Core>
+
+#include "../epoch_lib/Simulation/BatchControl.hpp"
+#include "../epoch_lib/Simulation/ChunkedSimulator.hpp"
+#include "../epoch_lib/Simulation/Sensitivity.hpp"
+#include "../epoch_lib/Simulation/Simulate.hpp"
+#include "../epoch_lib/Simulation/RepresentativeDays.hpp"
+#include "../epoch_lib/io/CheckpointJson.hpp"
+#include "../epoch_lib/io/FileHandling.hpp"
+#include "../epoch_lib/io/SiteDataBinary.hpp"
+
+namespace fs = std::filesystem;
+
+class ChunkedSimulatorTest : public ::testing::Test {
+protected:
+	std::shared_ptr<const SiteData> siteData;
+	TaskData taskData;
+	Simulator simulator;
+
+	ChunkedSimulatorTest() :
+		siteData(std::make_shared<const SiteData>(readSiteData(fs::path{ "./test_files/siteData_MountHotel.json" }))),
+		taskData(readTaskData(fs::path{ "./test_files/taskData_full.json" })),
+		simulator(siteData, TaskConfig{})
+	{}
+
+	// the totals of each window are summed separately, so only agree with the full simulation to a relative tolerance
+	static void expectClose(const Eigen::VectorXf& actual, const Eigen::VectorXf& expected) {
+		ASSERT_EQ(actual.size(), expected.size());
+		for (Eigen::Index i = 0; i < expected.size(); i++) {
+			EXPECT_NEAR(actual[i], expected[i], 1e-4f * std::max(1.0f, std::abs(expected[i]))) << i;
+		}
+	}
+
+	Eigen::VectorXf objectives(const SimulationResult& result) const {
+		return objectiveFields(toObjectiveResult(result, taskData));
+	}
+};
+
+TEST_F(ChunkedSimulatorTest, MatchesTheFullSimulation) {
+	ChunkedSimulator chunked(siteData, TaskConfig{}, 30);
+	EXPECT_EQ(chunked.windowTimesteps(), 30 * 48);
+	EXPECT_EQ(chunked.numWindows(), (siteData->timesteps + 30 * 48 - 1) / (30 * 48));
+
+	const SimulationResult full = simulator.simulateScenario(taskData);
+	const SimulationResult result = chunked.simulateScenario(taskData);
+	expectClose(objectives(result), objectives(full));
+	EXPECT_NEAR(result.metrics.total_electricity_imported, full.metrics.total_electricity_imported,
+		1e-4f * full.metrics.total_electricity_imported);
+	EXPECT_NEAR(chunked.getBaselineMetrics().total_gas_used, full.baseline_metrics.total_gas_used,
+		1e-4f * full.baseline_metrics.total_gas_used);
+	EXPECT_FALSE(result.report_data.has_value());
+}
+
+TEST_F(ChunkedSimulatorTest, OneWindowIsTheFullSimulation) {
+	ChunkedSimulator chunked(siteData, TaskConfig{}, 400);
+	ASSERT_EQ(chunked.numWindows(), 1);
+	EXPECT_EQ(objectives(chunked.simulateScenario(taskData)), objectives(simulator.simulateScenario(taskData)));
+}
+
+TEST_F(ChunkedSimulatorTest, StateCarriesAcrossWindows) {
+	const SimulationResult full = simulator.simulateScenario(taskData, SimulationType::FullReporting);
+	const ReportData& expected = full.report_data.value();
+
+	// the windows of a mapped binary SiteData, reported as each one is simulated
+	const fs::path binaryPath = fs::temp_directory_path() / "epoch_chunked_simulator_test.bin";
+	writeSiteDataBinary(*siteData, binaryPath);
+	{
+		ChunkedSimulator chunked(std::make_shared<const SiteData>(mapSiteDataBinary(binaryPath)), TaskConfig{}, 7);
+
+		std::vector<size_t> starts;
+		Eigen::VectorXf essSoC(siteData->timesteps);
+		Eigen::VectorXf dhwSoC(siteData->timesteps);
+		chunked.simulateScenario(taskData, [&](size_t start, const ReportData& window) {
+			starts.push_back(start);
+			essSoC.segment(static_cast<Eigen::Index>(start), window.timesteps()) = window.get(ReportColumn::ESS_resulting_SoC);
+			dhwSoC.segment(static_cast<Eigen::Index>(start), window.timesteps()) = window.get(ReportColumn::DHW_SoC);
+		});
+
+		ASSERT_EQ(starts.size(), chunked.numWindows());
+		for (size_t w = 0; w < starts.size(); w++) {
+			EXPECT_EQ(starts[w], w * chunked.windowTimesteps());
+		}
+		// without the carried state, each window's ESS and cylinder would start from their initial charge
+		EXPECT_LE((essSoC - expected.get(ReportColumn::ESS_resulting_SoC)).cwiseAbs().maxCoeff(), 1e-2f);
+		EXPECT_LE((dhwSoC - expected.get(ReportColumn::DHW_SoC)).cwiseAbs().maxCoeff(), 1e-2f);
+	}
+	fs::remove(binaryPath);
+}
+
+TEST_F(ChunkedSimulatorTest, InvalidWindowsAndScenarios) {
+	EXPECT_THROW(ChunkedSimulator(siteData, TaskConfig{}, 0), std::runtime_error);
+	EXPECT_THROW(ChunkedSimulator(nullptr, TaskConfig{}, 1), std::runtime_error);
+
+	ChunkedSimulator chunked(siteData, TaskConfig{}, 30);
+	TaskData invalid = taskData;
+	invalid.grid->tariff_index = 99;
+	EXPECT_EQ(chunked.simulateScenario(invalid).metrics.total_capex, std::numeric_limits<float>::max());
+}
+
+TEST_F(ChunkedSimulatorTest, ResumesFromACheckpoint) {
+	// the first 200 days, then the whole SiteData resuming from where they ended
+	const size_t days = 200;
+	auto firstDays = std::make_shared<const SiteData>(sliceSiteData(*siteData, 0, days * 48));
+	ChunkedSimulator earlier(firstDays, TaskConfig{}, 20);
+
+	SimulationCheckpoint checkpoint;
+	earlier.resumeScenario(taskData, checkpoint);
+	EXPECT_EQ(checkpoint.timesteps, days * 48);
+	ASSERT_TRUE(checkpoint.carried.ess_charge.has_value());
+	ASSERT_TRUE(checkpoint.carried.cylinder_energy.has_value());
+
+	// the checkpoint is saved and restored between runs
+	checkpoint = json::parse(json(checkpoint).dump()).get<SimulationCheckpoint>();
+	SimulationCheckpoint baseline = json::parse(json(earlier.getBaselineCheckpoint()).dump()).get<SimulationCheckpoint>();
+
+	ChunkedSimulator later(siteData, TaskConfig{}, 20, baseline);
+	size_t reportedWindows = 0;
+	const SimulationResult resumed = later.resumeScenario(taskData, checkpoint, [&](size_t start, const ReportData&) {
+		EXPECT_GE(start, days * 48);
+		reportedWindows++;
+	});
+	EXPECT_EQ(checkpoint.timesteps, siteData->timesteps);
+	EXPECT_EQ(reportedWindows, later.numWindows() - days / 20);
+
+	// the windows and the order of the sums are those of an uninterrupted run, so the results are identical
+	ChunkedSimulator uninterrupted(siteData, TaskConfig{}, 20);
+	EXPECT_EQ(objectives(resumed), objectives(uninterrupted.simulateScenario(taskData)));
+	EXPECT_EQ(later.getBaselineMetrics().total_gas_used, uninterrupted.getBaselineMetrics().total_gas_used);
+	expectClose(objectives(resumed), objectives(simulator.simulateScenario(taskData)));
+
+	// a finished checkpoint has nothing left to simulate
+	EXPECT_EQ(objectives(later.resumeScenario(taskData, checkpoint)), objectives(resumed));
+}
+
+TEST_F(ChunkedSimulatorTest, CancelledWindowsLeaveTheCheckpointResumable) {
+	ChunkedSimulator chunked(siteData, TaskConfig{}, 20);
+
+	// cancelled before the first window, so the checkpoint hasn't moved
+	BatchControl before;
+	before.cancel();
+	SimulationCheckpoint checkpoint;
+	EXPECT_TRUE(chunked.resumeScenario(taskData, checkpoint, {}, &before).cancelled);
+	EXPECT_EQ(checkpoint.timesteps, 0u);
+	EXPECT_EQ(before.skipped(), chunked.numWindows());
+
+	// cancelled once the first window has been reported
+	BatchControl afterOne;
+	const SimulationResult cancelled = chunked.resumeScenario(taskData, checkpoint, [&](size_t, const ReportData&) {
+		afterOne.cancel();
+	}, &afterOne);
+	EXPECT_TRUE(cancelled.cancelled);
+	EXPECT_EQ(checkpoint.timesteps, chunked.windowTimesteps());
+	EXPECT_EQ(afterOne.completed(), 1u);
+	EXPECT_EQ(afterOne.skipped(), chunked.numWindows() - 1);
+
+	// and resuming finishes the run as if it was never cancelled
+	const SimulationResult resumed = chunked.resumeScenario(taskData, checkpoint);
+	EXPECT_FALSE(resumed.cancelled);
+	EXPECT_EQ(checkpoint.timesteps, siteData->timesteps);
+	EXPECT_EQ(objectives(resumed), objectives(chunked.simulateScenario(taskData)));
+}
+
+TEST_F(ChunkedSimulatorTest, InvalidCheckpoints) {
+	ChunkedSimulator chunked(siteData, TaskConfig{}, 30);
+
+	SimulationCheckpoint partWayThroughADay;
+	partWayThroughADay.timesteps = 47;
+	EXPECT_THROW(chunked.resumeScenario(taskData, partWayThroughADay), std::runtime_error);
+
+	SimulationCheckpoint pastTheEnd;
+	pastTheEnd.timesteps = siteData->timesteps + 48;
+	EXPECT_THROW(chunked.resumeScenario(taskData, pastTheEnd), std::runtime_error);
+	EXPECT_EQ(pastTheEnd.timesteps, siteData->timesteps + 48);
+
+	// an unset carried state is written as null
+	json j = SimulationCheckpoint{};
+	EXPECT_TRUE(j["carried"]["ess_charge"].is_null());
+	EXPECT_FALSE(j.get<SimulationCheckpoint>().carried.cylinder_energy.has_value());
+}
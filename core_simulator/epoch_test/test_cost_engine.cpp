@@ -0,0 +1,170 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+#include "test_helpers.hpp"
+
+#include "../epoch_lib/Simulation/TaskData.hpp"
+#include "../epoch_lib/Simulation/Costs/Capex.hpp"
+#include "../epoch_lib/Simulation/Costs/CostEngine.hpp"
+#include "../epoch_lib/Simulation/Costs/NetPresentValue.hpp"
+
+class CostEngineTest : public ::testing::Test {
+protected:
+	SiteData siteData = make24HourSiteData();
+	TaskConfig config = makeConfig();
+	TaskData scenario = makeScenario();
+
+	static TaskConfig makeConfig() {
+		TaskConfig config{};
+		config.use_boiler_upgrade_scheme = true;
+		config.general_grant_funding = 1000.0f;
+		return config;
+	}
+
+	static TaskData makeScenario() {
+		TaskData scenario{};
+		scenario.building = Building();
+		scenario.grid = GridData();
+		scenario.heat_pump = HeatPumpData();
+		scenario.heat_pump->heat_power = 30.0f;
+		scenario.energy_storage_system = EnergyStorageSystem();
+		scenario.domestic_hot_water = DomesticHotWater();
+		scenario.electric_vehicles = ElectricVehicles();
+
+		// an incumbent panel has no capex, but must still be replaced in the NPV
+		SolarData newPanel;
+		newPanel.yield_scalar = 200.0f;
+		SolarData incumbentPanel;
+		incumbentPanel.yield_scalar = 100.0f;
+		incumbentPanel.yield_index = 1;
+		incumbentPanel.incumbent = true;
+		scenario.solar_panels = { newPanel, incumbentPanel };
+		return scenario;
+	}
+};
+
+TEST_F(CostEngineTest, MatchesTheCostFunctions) {
+	CostEngine engine(siteData, config);
+	ScenarioCosts costs = engine.evaluate(scenario);
+
+	CapexBreakdown expected = calculate_capex_with_discounts(siteData, config, scenario);
+	EXPECT_EQ(costs.capex.total_capex, expected.total_capex);
+	EXPECT_EQ(costs.capex.heatpump_capex, expected.heatpump_capex);
+	EXPECT_EQ(costs.capex.ess_enclosure_capex, expected.ess_enclosure_capex);
+	EXPECT_EQ(costs.capex.pv_panel_capex, expected.pv_panel_capex);
+	EXPECT_EQ(costs.capex.boiler_upgrade_scheme_funding, expected.boiler_upgrade_scheme_funding);
+	EXPECT_EQ(costs.capex.general_grant_funding, expected.general_grant_funding);
+
+	UsageData usage{};
+	usage.elec_cost = 2000.0f;
+	usage.capex_breakdown = costs.capex;
+	ValueMetrics npv = calculate_npv(config, costs.components, usage);
+	ValueMetrics expectedNpv = calculate_npv(siteData, config, scenario, usage);
+	EXPECT_EQ(npv.net_present_value, expectedNpv.net_present_value);
+	EXPECT_EQ(npv.annualised_cost, expectedNpv.annualised_cost);
+}
+
+TEST_F(CostEngineTest, MemoisesComponentCosts) {
+	CostEngine engine(siteData, config);
+
+	ScenarioCosts first = engine.evaluate(scenario);
+	CacheStats afterFirst = engine.memoStats();
+	EXPECT_EQ(afterFirst.hits, 0u);
+	// the DHW, ESS, heatpump and the two solar panels
+	EXPECT_EQ(afterFirst.misses, 5u);
+
+	ScenarioCosts second = engine.evaluate(scenario);
+	CacheStats afterSecond = engine.memoStats();
+	EXPECT_EQ(afterSecond.hits, 5u);
+	EXPECT_EQ(afterSecond.misses, 5u);
+	EXPECT_EQ(second.capex.total_capex, first.capex.total_capex);
+
+	// only the resized ESS is costed again
+	TaskData resized = scenario;
+	resized.energy_storage_system->capacity *= 2;
+	ScenarioCosts third = engine.evaluate(resized);
+	CacheStats afterThird = engine.memoStats();
+	EXPECT_EQ(afterThird.misses, 6u);
+	EXPECT_EQ(afterThird.entries, 6u);
+	EXPECT_GT(third.capex.total_capex, first.capex.total_capex);
+}
+
+namespace {
+	// the year-by-year NPV of a single component, as a reference for the closed form
+	double referenceComponentCost(const ComponentView& comp, int horizon, float discount_factor) {
+		std::vector<double> costs(static_cast<size_t>(horizon), 0.0);
+		if (!comp.incumbent) {
+			costs[0] += comp.capex;
+		}
+		double next_replacement = std::max(comp.lifetime - comp.age, 0.0f);
+		while (next_replacement < horizon) {
+			costs[static_cast<size_t>(next_replacement)] += comp.capex;
+			next_replacement += comp.lifetime;
+		}
+		costs.back() -= comp.capex * ((next_replacement - horizon) / comp.lifetime);
+
+		double cost = 0.0;
+		for (int year = 0; year < horizon; year++) {
+			cost += costs[static_cast<size_t>(year)] / std::pow(1.0 + discount_factor, year);
+		}
+		return cost;
+	}
+}
+
+TEST(DiscountTable, MatchesYearByYearReplacements) {
+	for (int horizon : { 1, 10, 25, 40 }) {
+		for (float discount : { 0.0f, 0.035f, 0.1f }) {
+			DiscountTable table(horizon, discount);
+			for (float lifetime : { 1.0f, 7.0f, 15.0f, 12.5f, 60.0f }) {
+				for (float age : { 0.0f, 3.0f, 4.5f, 70.0f }) {
+					for (bool incumbent : { false, true }) {
+						ComponentView comp{ 1000.0f, age, lifetime, incumbent };
+						double expected = referenceComponentCost(comp, horizon, discount);
+						EXPECT_NEAR(table.componentCost(comp), expected, 1e-6 * 1000.0 * horizon)
+							<< "horizon " << horizon << " discount " << discount << " lifetime " << lifetime << " age " << age;
+					}
+				}
+			}
+		}
+	}
+}
+
+TEST(DiscountTable, RejectsInvalidHorizonsAndLifetimes) {
+	EXPECT_THROW(DiscountTable(0, 0.05f), std::runtime_error);
+
+	DiscountTable table(10, 0.05f);
+	EXPECT_THROW(table.componentCost(ComponentView{ 1000.0f, 0.0f, 0.0f, false }), std::runtime_error);
+}
+
+TEST_F(CostEngineTest, BatchedNPVMatchesEachScenario) {
+	CostEngine engine(siteData, config);
+
+	TaskData larger = scenario;
+	larger.heat_pump->heat_power = 60.0f;
+	larger.energy_storage_system->age = 8.0f;
+
+	std::vector<std::vector<ComponentView>> components;
+	std::vector<UsageData> usage;
+	for (const TaskData& task : { scenario, larger }) {
+		ScenarioCosts costs = engine.evaluate(task);
+		components.push_back(costs.components);
+		UsageData u{};
+		u.elec_cost = 1500.0f;
+		u.capex_breakdown = costs.capex;
+		usage.push_back(u);
+	}
+
+	std::vector<ValueMetrics> results(usage.size());
+	calculate_npv(engine.discounts(), components, usage, results);
+
+	for (size_t i = 0; i < usage.size(); i++) {
+		ValueMetrics single = calculate_npv(engine.discounts(), components[i], usage[i]);
+		EXPECT_EQ(results[i].net_present_value, single.net_present_value);
+		EXPECT_EQ(results[i].annualised_cost, single.annualised_cost);
+	}
+	EXPECT_NE(results[0].net_present_value, results[1].net_present_value);
+}
@@ -1,5 +1,10 @@
 #include <gtest/gtest.h>
 
+#include <stdexcept>
+#include <vector>
+
+#include <Eigen/Core>
+
 #include "../epoch_lib/Simulation/Costs/CostData.hpp"
 
 
@@ -85,3 +90,35 @@ TEST_F(PiecewiseCostTest, SingleSegment) {
 	EXPECT_FLOAT_EQ(calculate_piecewise_costs(model, 150.0f), 10.0f + (100.0f * 3.0f) + (50.0f * 2.0f));
 
 }
+
+
+TEST(PiecewiseCostTable, MatchesThePiecewiseModel) {
+	// the compiled tables should give exactly the same costs, either one at a time or as a column
+	CapexModel capex = make_default_capex_prices();
+	std::vector<PiecewiseCostModel> models = {
+		capex.dhw_prices, capex.heatpump_prices, capex.ess_enclosure_prices,
+		PiecewiseCostModel{ 120.0f, {}, 4.0f },
+		PiecewiseCostModel{ 10.0f, {{100.0f, 3.0f}}, 2.0f },
+		// repeated boundaries
+		PiecewiseCostModel{ 5.0f, {{50.0f, 3.0f}, {50.0f, 7.0f}, {80.0f, 2.0f}}, 1.0f }
+	};
+
+	Eigen::ArrayXf units = Eigen::ArrayXf::LinSpaced(2601, -100.0f, 2500.0f);
+
+	for (const auto& model : models) {
+		PiecewiseCostTable table(model);
+		Eigen::ArrayXf costs = table.costs(units);
+		ASSERT_EQ(costs.size(), units.size());
+
+		for (Eigen::Index i = 0; i < units.size(); i++) {
+			float expected = calculate_piecewise_costs(model, units[i]);
+			EXPECT_EQ(table.cost(units[i]), expected) << "at " << units[i];
+			EXPECT_EQ(costs[i], expected) << "at " << units[i];
+		}
+	}
+}
+
+TEST(PiecewiseCostTable, RejectsDecreasingSegments) {
+	PiecewiseCostModel model{ 0.0f, {{100.0f, 3.0f}, {50.0f, 2.0f}}, 1.0f };
+	EXPECT_THROW(PiecewiseCostTable{ model }, std::runtime_error);
+}
@@ -0,0 +1,90 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <filesystem>
+#include <optional>
+
+#include <Eigen/Core>
+
+#include "test_helpers.hpp"
+
+#include "../epoch_lib/Simulation/DaysOfInterest.hpp"
+#include "../epoch_lib/Simulation/Simulate.hpp"
+#include "../epoch_lib/io/FileHandling.hpp"
+
+namespace fs = std::filesystem;
+
+TEST(DaysOfInterest, FindsTheLargestDailyTotals) {
+	// three and a half days of hourly timesteps, so the last day is partial
+	const SiteData siteData = makeNHourSiteData(84);
+	const DayTariffStats days(siteData, 0);
+	Eigen::VectorXf tariff = Eigen::VectorXf::Ones(84);
+	tariff.segment(24, 24).setConstant(3.0f);
+
+	ReportData reportData(DAYS_OF_INTEREST_COLUMNS);
+	Eigen::VectorXf heatShortfall = Eigen::VectorXf::Zero(84);
+	heatShortfall[50] = 2.0f;
+	reportData.set(ReportColumn::Heat_shortfall, heatShortfall);
+	// the same import every day, which is most expensive on the day with the highest tariff
+	reportData.set(ReportColumn::Grid_Import, Eigen::VectorXf::Ones(84));
+	Eigen::VectorXf solar = Eigen::VectorXf::Ones(84);
+	solar[80] = 100.0f;
+	reportData.set(ReportColumn::PVacGen, solar);
+	// the same load on every whole day, so the first of them is chosen
+	reportData.set(ReportColumn::Hotel_load, Eigen::VectorXf::Ones(84));
+
+	const DaysOfInterest result = findDaysOfInterest(reportData, days, tariff);
+	EXPECT_EQ(result.day_starts, (std::vector<size_t>{ 0, 24, 48, 72, 84 }));
+	ASSERT_EQ(result.daily.cols(), 4);
+
+	EXPECT_EQ(result.days[static_cast<size_t>(DayOfInterest::MaxHeatShortfall)], 2u);
+	EXPECT_EQ(result.days[static_cast<size_t>(DayOfInterest::MaxImportCost)], 1u);
+	EXPECT_FLOAT_EQ(result.daily(static_cast<Eigen::Index>(DayOfInterest::MaxImportCost), 1), 72.0f);
+	EXPECT_EQ(result.days[static_cast<size_t>(DayOfInterest::MaxSolarGeneration)], 3u);
+	EXPECT_EQ(result.days[static_cast<size_t>(DayOfInterest::MaxElectricalLoad)], 0u);
+	// the columns that aren't populated have no day
+	EXPECT_FALSE(result.days[static_cast<size_t>(DayOfInterest::MaxESSThroughput)].has_value());
+	EXPECT_FALSE(result.days[static_cast<size_t>(DayOfInterest::MaxDHWDemand)].has_value());
+}
+
+TEST(DaysOfInterest, MatchesTheFullReport) {
+	const Simulator simulator(readSiteData(fs::path{ "./test_files/siteData_MountHotel.json" }), TaskConfig{});
+	const SiteData& siteData = *simulator.getSiteData();
+	TaskData taskData = readTaskData(fs::path{ "./test_files/taskData_full.json" });
+	taskData.grid->grid_import = 60.0f;
+
+	const DaysOfInterest result = simulator.daysOfInterest(taskData);
+	const SimulationResult full = simulator.simulateScenario(taskData, SimulationType::FullReporting);
+	ASSERT_TRUE(full.report_data.has_value());
+
+	const size_t tariffIndex = taskData.grid->tariff_index;
+	const DaysOfInterest fromReport = findDaysOfInterest(*full.report_data,
+		DayTariffStats(siteData, tariffIndex), siteData.import_tariffs[tariffIndex]);
+	EXPECT_EQ(result.day_starts, fromReport.day_starts);
+	EXPECT_EQ(result.days, fromReport.days);
+	EXPECT_TRUE(result.daily.isApprox(fromReport.daily));
+
+	const auto expectedDays = static_cast<size_t>(std::ceil(siteData.timesteps * siteData.timestep_hours / 24.0));
+	EXPECT_EQ(result.day_starts.size(), expectedDays + 1);
+	EXPECT_EQ(result.day_starts.back(), siteData.timesteps);
+
+	// the daily totals add up to the totals of the simulation
+	EXPECT_NEAR(result.daily.row(static_cast<Eigen::Index>(DayOfInterest::MaxElectricalShortfall)).sum(),
+		full.metrics.total_electrical_shortfall, 1e-3f * std::max(1.0f, full.metrics.total_electrical_shortfall));
+	for (size_t c = 0; c < NUM_DAYS_OF_INTEREST; c++) {
+		SCOPED_TRACE(DAY_OF_INTEREST_NAMES[c]);
+		if (result.days[c]) {
+			EXPECT_EQ(result.daily(static_cast<Eigen::Index>(c), static_cast<Eigen::Index>(*result.days[c])),
+				result.daily.row(static_cast<Eigen::Index>(c)).maxCoeff());
+		}
+	}
+	EXPECT_TRUE(result.days[static_cast<size_t>(DayOfInterest::MaxESSThroughput)].has_value());
+	EXPECT_TRUE(result.days[static_cast<size_t>(DayOfInterest::MaxImportCost)].has_value());
+}
+
+TEST(DaysOfInterest, RejectsInvalidScenarios) {
+	const Simulator simulator(readSiteData(fs::path{ "./test_files/siteData_MountHotel.json" }), TaskConfig{});
+	TaskData taskData = readTaskData(fs::path{ "./test_files/taskData_full.json" });
+	taskData.grid->tariff_index = 999;
+	EXPECT_THROW(simulator.daysOfInterest(taskData), std::runtime_error);
+}
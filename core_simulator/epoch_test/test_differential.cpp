@@ -0,0 +1,99 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <memory>
+#include <random>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "differential_harness.hpp"
+#include "../epoch_lib/io/FileHandling.hpp"
+
+namespace fs = std::filesystem;
+
+namespace {
+	// record the certificate of each path with the test's result (see --gtest_output), whether or not it passes
+	void recordCertificates(std::span<const differential::PathReport> reports) {
+		for (const differential::PathReport& report : reports) {
+			::testing::Test::RecordProperty(report.name + "_mismatches", std::to_string(report.mismatches.size()));
+			::testing::Test::RecordProperty(report.name + "_speed_up", std::to_string(report.speedUp()));
+		}
+	}
+}
+
+class DifferentialTest : public ::testing::Test {
+protected:
+	static void SetUpTestSuite() {
+		const SiteData base = readSiteData(fs::path{ "./test_files/siteData_MountHotel.json" });
+		std::mt19937 rng(2024);
+		site = std::make_shared<const SiteData>(differential::randomSiteData(rng, base));
+
+		const Simulator simulator(site, TaskConfig{});
+		for (int i = 0; i < 24; i++) {
+			tasks.push_back(differential::randomTaskData(rng, simulator));
+		}
+	}
+
+	static void TearDownTestSuite() {
+		site.reset();
+		tasks.clear();
+	}
+
+	static inline std::shared_ptr<const SiteData> site;
+	static inline std::vector<TaskData> tasks;
+};
+
+TEST_F(DifferentialTest, FastPathsMatchTheReference) {
+	ThreadPool pool(4);
+	const std::vector<differential::FastPath> paths = differential::standardFastPaths(pool);
+	const std::vector<differential::PathReport> reports = differential::runDifferential(site, tasks, paths);
+
+	// a failing path also shows its certificate
+	recordCertificates(reports);
+	for (const differential::PathReport& report : reports) {
+		EXPECT_TRUE(report.mismatches.empty()) << differential::formatReports({ &report, 1 });
+	}
+	// the paths with full reporting compare every column of every scenario
+	EXPECT_GT(reports[0].columnsCompared, tasks.size());
+}
+
+TEST_F(DifferentialTest, ReportsAMismatch) {
+	// a path that is deliberately wrong must be caught, in both a metric and a column
+	differential::FastPath wrong{ "wrong", [](std::shared_ptr<const SiteData> site, std::span<const TaskData> tasks) {
+		std::vector<SimulationResult> results = differential::simulateReference(std::move(site), tasks);
+		results[1].metrics.total_electricity_imported *= 1.01f;
+		results[2].report_data->column(ReportColumn::Grid_Import)[3] += 1.0f;
+		return results;
+	}, {} };
+
+	const auto reports = differential::runDifferential(site, std::span<const TaskData>(tasks).first(3), { &wrong, 1 });
+	ASSERT_EQ(reports.size(), 1u);
+	ASSERT_EQ(reports[0].mismatches.size(), 2u) << differential::formatReports(reports);
+	EXPECT_EQ(reports[0].mismatches[0].scenario, 1u);
+	EXPECT_EQ(reports[0].mismatches[0].field, "total_electricity_imported");
+	EXPECT_EQ(reports[0].mismatches[1].scenario, 2u);
+	EXPECT_EQ(reports[0].mismatches[1].timestep, 3);
+
+	// and forgiven within its tolerance
+	wrong.tolerances.metrics = differential::Tolerance{ 0.02f, 0.0f };
+	wrong.tolerances.fields["Grid_Import"] = differential::Tolerance::ignore();
+	EXPECT_TRUE(differential::runDifferential(site, std::span<const TaskData>(tasks).first(3), { &wrong, 1 })[0].mismatches.empty());
+}
+
+TEST_F(DifferentialTest, RepresentativeDaysAreWithinTheirTolerance) {
+	// a reduced-resolution path, certified on the annual totals it is used to screen
+	differential::FastPath representativeDays{ "representative_days", [](std::shared_ptr<const SiteData> site, std::span<const TaskData> tasks) {
+		Simulator simulator(std::move(site), TaskConfig{});
+		simulator.enableRepresentativeDays(24);
+		return simulator.simulateBatch(tasks, SimulationType::RepresentativeDays);
+	}, {} };
+	representativeDays.tolerances.metrics = differential::Tolerance::ignore();
+	for (const char* field : { "total_gas_used", "total_electricity_imported", "total_electricity_generated", "capex" }) {
+		representativeDays.tolerances.fields[field] = differential::Tolerance{ 0.25f, 1.0f };
+	}
+
+	const auto reports = differential::runDifferential(site, tasks, { &representativeDays, 1 });
+	recordCertificates(reports);
+	EXPECT_TRUE(reports[0].mismatches.empty()) << differential::formatReports(reports);
+}
@@ -0,0 +1,162 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <filesystem>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#include <Eigen/Core>
+
+#include "../epoch_lib/Simulation/BatchControl.hpp"
+#include "../epoch_lib/Simulation/Ensemble.hpp"
+#include "../epoch_lib/Simulation/Simulate.hpp"
+#include "../epoch_lib/io/FileHandling.hpp"
+#include "../epoch_lib/io/SiteDataBinary.hpp"
+
+namespace fs = std::filesystem;
+
+class EnsembleTest : public ::testing::Test {
+protected:
+	SiteData siteData;
+	TaskData taskData;
+
+	EnsembleTest() :
+		siteData(readSiteData(fs::path{ "./test_files/siteData_MountHotel.json" })),
+		taskData(readTaskData(fs::path{ "./test_files/taskData_full.json" }))
+	{}
+
+	// members with a colder and a warmer year, more electrical demand and less solar
+	SiteEnsemble makeEnsemble() const {
+		SiteEnsemble ensemble;
+		ensemble.air_temperature = {
+			siteData.air_temperature, year_TS(siteData.air_temperature.array() - 3.0f), year_TS(siteData.air_temperature.array() + 2.0f)
+		};
+		ensemble.building_eload = {
+			siteData.building_eload, year_TS(siteData.building_eload * 1.2f), siteData.building_eload
+		};
+		for (float scale : { 1.0f, 0.8f, 1.1f }) {
+			std::vector<SiteSeries> yields;
+			for (const auto& yield : siteData.solar_yields) {
+				yields.push_back(year_TS(yield * scale));
+			}
+			ensemble.solar_yields.emplace_back(yields);
+		}
+		return ensemble;
+	}
+};
+
+TEST_F(EnsembleTest, MembersMatchTheirOwnSimulator) {
+	const size_t nominalBytes = siteData.memoryFootprint();
+	siteData.ensemble = makeEnsemble();
+	EXPECT_GT(siteData.memoryFootprint(), nominalBytes);
+
+	Simulator simulator(siteData, TaskConfig{});
+	ASSERT_EQ(simulator.ensembleMembers(), 3);
+
+	EnsembleResult result = simulator.simulateEnsemble(taskData);
+	ASSERT_EQ(result.objectives.cols(), 3);
+
+	for (size_t m = 0; m < 3; m++) {
+		SCOPED_TRACE(m);
+		Simulator member(siteData.ensembleMember(m), TaskConfig{});
+		auto expected = objectiveFields(toObjectiveResult(member.simulateScenario(taskData), taskData));
+		EXPECT_EQ(Eigen::VectorXf(result.objectives.col(static_cast<Eigen::Index>(m))), expected);
+	}
+
+	// the first member is the nominal site
+	auto nominal = objectiveFields(toObjectiveResult(simulator.simulateScenario(taskData), taskData));
+	EXPECT_EQ(Eigen::VectorXf(result.objectives.col(0)), nominal);
+
+	// the capex doesn't depend on the weather
+	EXPECT_EQ(result.statistics[1].min, result.statistics[1].max);
+	for (const auto& stats : result.statistics) {
+		EXPECT_LE(stats.min, stats.p10);
+		EXPECT_LE(stats.p10, stats.p50);
+		EXPECT_LE(stats.p50, stats.p90);
+		EXPECT_LE(stats.p90, stats.max);
+	}
+	// but the operating cost does
+	EXPECT_LT(result.statistics[2].min, result.statistics[2].max);
+}
+
+TEST_F(EnsembleTest, MembersOfAConfigAreCostedWithIt) {
+	siteData.ensemble = makeEnsemble();
+	const Simulator simulator(siteData, TaskConfig{});
+	TaskConfig funded;
+	funded.general_grant_funding = 25000.0f;
+
+	const EnsembleResult result = simulator.withConfig(funded)->simulateEnsemble(taskData);
+	ASSERT_EQ(result.objectives.cols(), 3);
+	for (size_t m = 0; m < 3; m++) {
+		SCOPED_TRACE(m);
+		Simulator member(siteData.ensembleMember(m), funded);
+		auto expected = objectiveFields(toObjectiveResult(member.simulateScenario(taskData), taskData));
+		EXPECT_EQ(Eigen::VectorXf(result.objectives.col(static_cast<Eigen::Index>(m))), expected);
+	}
+}
+
+TEST_F(EnsembleTest, CancelledEnsemble) {
+	siteData.ensemble = makeEnsemble();
+	Simulator simulator(siteData, TaskConfig{});
+
+	BatchControl control;
+	EnsembleResult complete = simulator.simulateEnsemble(taskData, control);
+	EXPECT_EQ(complete.simulated_members, 3u);
+	EXPECT_EQ(control.completed(), 3u);
+
+	// no member is simulated, so there are no statistics either
+	control.cancel();
+	EnsembleResult result = simulator.simulateEnsemble(taskData, control);
+	EXPECT_EQ(result.simulated_members, 0u);
+	ASSERT_EQ(result.objectives.cols(), 3);
+	EXPECT_TRUE(result.objectives.array().isNaN().all());
+	for (const auto& stats : result.statistics) {
+		EXPECT_TRUE(std::isnan(stats.mean));
+		EXPECT_TRUE(std::isnan(stats.p50));
+	}
+	EXPECT_EQ(control.total(), 6u);
+	EXPECT_EQ(control.skipped(), 3u);
+}
+
+TEST_F(EnsembleTest, InvalidEnsembles) {
+	Simulator noEnsemble(siteData, TaskConfig{});
+	EXPECT_EQ(noEnsemble.ensembleMembers(), 0);
+	EXPECT_THROW(noEnsemble.simulateEnsemble(taskData), std::runtime_error);
+
+	// a different number of members for each series
+	SiteEnsemble ensemble = makeEnsemble();
+	ensemble.building_hload = { siteData.building_hload };
+	siteData.ensemble = ensemble;
+	EXPECT_THROW(Simulator(siteData, TaskConfig{}), std::runtime_error);
+
+	// a missing solar yield
+	ensemble = makeEnsemble();
+	ensemble.solar_yields[1] = { siteData.solar_yields[0] };
+	siteData.ensemble = ensemble;
+	EXPECT_THROW(Simulator(siteData, TaskConfig{}), std::runtime_error);
+
+	EXPECT_THROW(siteData.ensembleMember(3), std::out_of_range);
+
+	// the binary format would lose the ensemble
+	std::ostringstream out;
+	EXPECT_THROW(writeSiteDataBinary(siteData, out), std::runtime_error);
+}
+
+TEST(EnsembleStatistics, Percentiles) {
+	const std::vector<float> values = { 7, 1, 11, 4, 2, 9, 3, 6, 10, 5, 8 };
+	EnsembleStatistics stats = summariseEnsemble(values);
+	EXPECT_EQ(stats.min, 1.0f);
+	EXPECT_EQ(stats.max, 11.0f);
+	EXPECT_EQ(stats.mean, 6.0f);
+	EXPECT_FLOAT_EQ(stats.p10, 2.0f);
+	EXPECT_FLOAT_EQ(stats.p50, 6.0f);
+	EXPECT_FLOAT_EQ(stats.p90, 10.0f);
+
+	// interpolated between two members
+	stats = summariseEnsemble(std::vector<float>{ 0.0f, 10.0f });
+	EXPECT_FLOAT_EQ(stats.p10, 1.0f);
+	EXPECT_FLOAT_EQ(stats.p90, 9.0f);
+
+	EXPECT_THROW(summariseEnsemble(std::vector<float>{}), std::runtime_error);
+}
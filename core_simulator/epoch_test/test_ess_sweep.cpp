@@ -0,0 +1,97 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <stdexcept>
+#include <vector>
+
+#include "../epoch_lib/Simulation/BatchPlan.hpp"
+#include "../epoch_lib/Simulation/ESSSweep.hpp"
+#include "../epoch_lib/Simulation/Simulate.hpp"
+#include "../epoch_lib/io/FileHandling.hpp"
+
+namespace fs = std::filesystem;
+
+class ESSSweepTest : public ::testing::Test {
+protected:
+	Simulator simulator;
+	TaskData base;
+	std::vector<ESSSize> sizes;
+
+	ESSSweepTest() :
+		simulator(readSiteData(fs::path{ "./test_files/siteData_MountHotel.json" }), TaskConfig{}),
+		base(readTaskData(fs::path{ "./test_files/taskData_common.json" }))
+	{
+		// more than one lock-step group, with a partial group at the end
+		for (size_t i = 0; i < 2 * LOCKSTEP_LANES + 3; i++) {
+			const float step = static_cast<float>(i);
+			sizes.push_back({ 10.0f + 25.0f * step, 5.0f + 10.0f * step, 5.0f + 7.5f * step });
+		}
+	}
+
+	std::vector<TaskData> sizedScenarios(const TaskData& scenario) const {
+		std::vector<TaskData> scenarios;
+		for (const ESSSize& size : sizes) {
+			scenarios.push_back(withESSSize(scenario, size));
+		}
+		return scenarios;
+	}
+
+	static void expectSameResult(const SimulationResult& result, const SimulationResult& expected) {
+		EXPECT_EQ(result.metrics.total_capex, expected.metrics.total_capex);
+		EXPECT_EQ(result.metrics.total_electricity_imported, expected.metrics.total_electricity_imported);
+		EXPECT_EQ(result.metrics.total_electricity_exported, expected.metrics.total_electricity_exported);
+		EXPECT_EQ(result.metrics.total_electrical_shortfall, expected.metrics.total_electrical_shortfall);
+		EXPECT_EQ(result.comparison.cost_balance, expected.comparison.cost_balance);
+		EXPECT_EQ(result.comparison.combined_carbon_balance, expected.comparison.combined_carbon_balance);
+	}
+};
+
+TEST_F(ESSSweepTest, MatchesTheBatch) {
+	ASSERT_TRUE(lockstepGroup(base).has_value());
+	const auto scenarios = sizedScenarios(base);
+	const auto expected = simulator.simulateBatch(scenarios, SimulationType::ResultOnly);
+
+	const auto results = simulator.sweepESS(base, sizes);
+	ASSERT_EQ(results.size(), sizes.size());
+	for (size_t i = 0; i < sizes.size(); i++) {
+		SCOPED_TRACE(i);
+		expectSameResult(results[i], expected[i]);
+	}
+}
+
+TEST_F(ESSSweepTest, BalancesOtherModesOnePerThread) {
+	TaskData arbitrage = base;
+	arbitrage.energy_storage_system->battery_mode = BatteryMode::CONSUME_PLUS;
+	ASSERT_FALSE(lockstepGroup(arbitrage).has_value());
+
+	const auto scenarios = sizedScenarios(arbitrage);
+	const auto results = simulator.sweepESS(arbitrage, sizes);
+	ASSERT_EQ(results.size(), sizes.size());
+	for (size_t i = 0; i < sizes.size(); i += 7) {
+		SCOPED_TRACE(i);
+		expectSameResult(results[i], simulator.simulateScenario(scenarios[i]));
+	}
+}
+
+TEST_F(ESSSweepTest, MatchesTheBatchWithABackend) {
+	const auto expected = simulator.sweepESS(base, sizes);
+
+	simulator.enableBatchBackend(makeCpuBatchBackend(LOCKSTEP_LANES + 1));
+	const auto results = simulator.sweepESS(base, sizes);
+	ASSERT_EQ(results.size(), sizes.size());
+	for (size_t i = 0; i < sizes.size(); i++) {
+		SCOPED_TRACE(i);
+		expectSameResult(results[i], expected[i]);
+	}
+}
+
+TEST_F(ESSSweepTest, RejectsScenariosWithoutAnESSAndNegativeSizes) {
+	TaskData withoutESS = base;
+	withoutESS.energy_storage_system.reset();
+	EXPECT_THROW(simulator.sweepESS(withoutESS, sizes), std::runtime_error);
+
+	const std::vector<ESSSize> negative = { { 10.0f, -1.0f, 5.0f } };
+	EXPECT_THROW(simulator.sweepESS(base, negative), std::runtime_error);
+
+	EXPECT_TRUE(simulator.sweepESS(base, std::vector<ESSSize>{}).empty());
+}
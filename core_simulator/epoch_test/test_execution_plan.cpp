@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+
+#include "../epoch_lib/Simulation/ExecutionPlan.hpp"
+#include "../epoch_lib/Simulation/Simulate.hpp"
+#include "../epoch_lib/io/FileHandling.hpp"
+
+namespace fs = std::filesystem;
+
+TEST(ExecutionPlan, FollowsTheComponentsPresent) {
+	TaskData taskData{};
+	taskData.building = Building{};
+	taskData.domestic_hot_water = DomesticHotWater{};
+	taskData.heat_pump = HeatPumpData{};
+
+	// the heatpump heats the cylinder, so the instant water heater is deferred until after the balancing loop
+	ExecutionPlan plan = ExecutionPlan::build(taskData);
+	EXPECT_TRUE(plan.hotel);
+	EXPECT_FALSE(plan.pv);
+	EXPECT_TRUE(plan.hotWaterCylinder);
+	EXPECT_FALSE(plan.instantWaterHeater);
+	EXPECT_TRUE(plan.deferredWaterHeater);
+	EXPECT_TRUE(plan.ambientHeatPump);
+	EXPECT_EQ(plan.balancingLoop, nullptr);
+
+	// with a gas heater there is no water heater at all
+	taskData.gas_heater = GasCHData{};
+	plan = ExecutionPlan::build(taskData);
+	EXPECT_FALSE(plan.instantWaterHeater);
+	EXPECT_FALSE(plan.deferredWaterHeater);
+	EXPECT_TRUE(plan.gasHeater);
+
+	// a hotroom heatpump belongs to the data centre, and an ambient one runs beside it
+	taskData.data_centre = DataCentreData{};
+	taskData.heat_pump->heat_source = HeatSource::HOTROOM;
+	plan = ExecutionPlan::build(taskData);
+	EXPECT_EQ(plan.dataCentre, ExecutionPlan::DataCentreKind::WITH_ASHP);
+	EXPECT_FALSE(plan.ambientHeatPump);
+	EXPECT_NE(plan.balancingLoop, nullptr);
+
+	taskData.heat_pump->heat_source = HeatSource::AMBIENT_AIR;
+	plan = ExecutionPlan::build(taskData);
+	EXPECT_EQ(plan.dataCentre, ExecutionPlan::DataCentreKind::BASIC);
+	EXPECT_TRUE(plan.ambientHeatPump);
+}
+
+TEST(ExecutionPlan, ConsumeOnlyWithoutOtherBalancingComponents) {
+	TaskData taskData{};
+	taskData.energy_storage_system = EnergyStorageSystem{};
+	EXPECT_TRUE(ExecutionPlan::build(taskData).consumeOnly);
+
+	// an EV that doesn't flex only adds its load before the balancing loop
+	taskData.electric_vehicles = ElectricVehicles{};
+	taskData.electric_vehicles->flexible_load_ratio = 0.0f;
+	ExecutionPlan plan = ExecutionPlan::build(taskData);
+	EXPECT_TRUE(plan.fixedEV);
+	EXPECT_TRUE(plan.consumeOnly);
+
+	taskData.electric_vehicles->flexible_load_ratio = 0.5f;
+	plan = ExecutionPlan::build(taskData);
+	EXPECT_FALSE(plan.fixedEV);
+	EXPECT_FALSE(plan.consumeOnly);
+
+	taskData.electric_vehicles.reset();
+	taskData.energy_storage_system->battery_mode = BatteryMode::CONSUME_PLUS;
+	EXPECT_FALSE(ExecutionPlan::build(taskData).consumeOnly);
+}
+
+TEST(ExecutionPlan, SharedByScenariosOfTheSameShape) {
+	Simulator simulator{ readSiteData(fs::path{ "./test_files/siteData_MountHotel.json" }), TaskConfig{} };
+	const TaskData common = readTaskData(fs::path{ "./test_files/taskData_common.json" });
+	const TaskData full = readTaskData(fs::path{ "./test_files/taskData_full.json" });
+
+	// the sizes of the components don't change the plan
+	TaskData larger = common;
+	larger.energy_storage_system->capacity *= 2.0f;
+	EXPECT_EQ(&simulator.getExecutionPlan(common), &simulator.getExecutionPlan(larger));
+	EXPECT_NE(&simulator.getExecutionPlan(common), &simulator.getExecutionPlan(full));
+
+	// (the baseline is of another shape, so has a plan of its own)
+	simulator.getBaseline();
+	const size_t before = simulator.executionPlanCount();
+	simulator.simulateScenario(common);
+	simulator.simulateScenario(larger);
+	simulator.simulateScenario(full);
+	EXPECT_EQ(simulator.executionPlanCount(), before);
+}
@@ -15,7 +15,13 @@ protected:
 		siteData(make24HourSiteData())
 	{
 		// Construct a fabric intervention that halves the energy for �100
-		FabricIntervention reducedEnergy = { 100.0f, {}, 0.0f, Eigen::VectorXf::Constant(24, 0.5f) };
+		FabricIntervention reducedEnergy = {
+			.cost = 100.0f,
+			.cost_breakdown = {},
+			.peak_hload = 0.0f,
+			.reduced_hload = Eigen::VectorXf::Constant(24, 0.5f),
+			.hload_delta = std::nullopt
+		};
 		siteData.fabric_interventions[0] = reducedEnergy;
 
 	}
@@ -69,4 +75,85 @@ TEST_F(FabricInterventionTest, reduceHeat) {
 
 	// We expect our intervention to require less heat
 	EXPECT_LT(interventionTempSum.Heat_h.sum(), defaultTempSum.Heat_h.sum());
-}
\ No newline at end of file
+}
+TEST_F(FabricInterventionTest, scalarsApplyToTheIntervention) {
+	auto building = Building();
+	building.fabric_intervention_index = 1;
+	building.scalar_heat_load = 3.0f;
+	building.scalar_electrical_load = 0.5f;
+
+	TempSum tempSum{ siteData };
+	auto hotel = Hotel{ siteData, building };
+	hotel.AllCalcs(tempSum);
+
+	const year_TS expectedHeat = siteData.fabric_interventions[0].reduced_hload * 3.0f;
+	const year_TS expectedElec = siteData.building_eload * 0.5f;
+	EXPECT_EQ(tempSum.Heat_h, expectedHeat);
+	EXPECT_EQ(tempSum.Elec_e, expectedElec);
+
+	ReportData report;
+	hotel.Report(report);
+	EXPECT_EQ(year_TS(report.get(ReportColumn::CH_demand)), expectedHeat);
+	EXPECT_EQ(year_TS(report.get(ReportColumn::Hotel_load)), expectedElec);
+	EXPECT_EQ(year_TS(report.get(ReportColumn::Heatload)), year_TS(expectedHeat + siteData.dhw_demand));
+
+	SimulationTotals totals{};
+	hotel.ReportTotals(totals);
+	EXPECT_EQ(totals.ch_demand_h, expectedHeat.sum());
+}
+
+TEST(FabricHeatDelta, FitsAScaledBaseWithOverrides) {
+	const SiteSeries base = Eigen::VectorXf::LinSpaced(100, 1.0f, 50.0f);
+	year_TS reduced = base * 0.7f;
+	reduced[10] = 3.0f;
+	reduced[60] = 0.0f;
+
+	auto delta = FabricHeatDelta::fit(base, reduced, 5);
+	ASSERT_TRUE(delta.has_value());
+	EXPECT_EQ(delta->scale, 0.7f);
+	EXPECT_EQ(delta->index, (std::vector<uint32_t>{ 10, 60 }));
+	EXPECT_EQ(delta->expand(), reduced);
+
+	// too many overrides to be worth it
+	EXPECT_FALSE(FabricHeatDelta::fit(base, reduced, 1).has_value());
+}
+
+TEST_F(FabricInterventionTest, deltaMatchesTheDenseDemand) {
+	// a base demand that varies, and an intervention that is 80% of it but for a cold snap
+	siteData.building_hload = Eigen::VectorXf::LinSpaced(24, 2.0f, 9.0f);
+	year_TS reduced = siteData.building_hload * 0.8f;
+	reduced.segment(5, 2).setConstant(12.0f);
+	siteData.fabric_interventions[0].reduced_hload = reduced;
+	const SiteData dense = siteData;
+
+	ASSERT_EQ(siteData.compactFabricInterventions(0.1), 1);
+	ASSERT_TRUE(siteData.fabric_interventions[0].hload_delta.has_value());
+	EXPECT_EQ(siteData.fabric_interventions[0].reduced_hload.size(), 0);
+	EXPECT_LT(siteData.memoryFootprint(), dense.memoryFootprint());
+
+	auto building = Building();
+	building.fabric_intervention_index = 1;
+	building.scalar_heat_load = 1.5f;
+
+	TempSum denseSum{ dense };
+	Hotel denseHotel{ dense, building };
+	denseHotel.AllCalcs(denseSum);
+	TempSum deltaSum{ siteData };
+	Hotel deltaHotel{ siteData, building };
+	deltaHotel.AllCalcs(deltaSum);
+	EXPECT_EQ(deltaSum.Heat_h, denseSum.Heat_h);
+
+	ReportData denseReport;
+	denseHotel.Report(denseReport);
+	ReportData deltaReport;
+	deltaHotel.Report(deltaReport);
+	EXPECT_EQ(year_TS(deltaReport.get(ReportColumn::CH_demand)), year_TS(denseReport.get(ReportColumn::CH_demand)));
+	EXPECT_EQ(year_TS(deltaReport.get(ReportColumn::Heatload)), year_TS(denseReport.get(ReportColumn::Heatload)));
+
+	SimulationTotals denseTotals{};
+	denseHotel.ReportTotals(denseTotals);
+	SimulationTotals deltaTotals{};
+	deltaHotel.ReportTotals(deltaTotals);
+	// the overrides are summed separately
+	EXPECT_FLOAT_EQ(deltaTotals.ch_demand_h, denseTotals.ch_demand_h);
+}
@@ -0,0 +1,206 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <numeric>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../epoch_lib/Optimisation/GridSearch.hpp"
+#include "../epoch_lib/Optimisation/Pareto.hpp"
+#include "../epoch_lib/Simulation/Simulate.hpp"
+#include "../epoch_lib/io/FileHandling.hpp"
+
+namespace fs = std::filesystem;
+
+namespace {
+	// every component is mandatory, so every scenario in the grid is different (though some have the same objectives)
+	const std::string SITE_RANGE = R"({
+		"grid": {
+			"COMPONENT_IS_MANDATORY": true,
+			"grid_import": [60.0, 140.0],
+			"grid_export": [60.0],
+			"tariff_index": [0],
+			"incumbent": false,
+			"age": 0,
+			"lifetime": 25
+		},
+		"energy_storage_system": {
+			"COMPONENT_IS_MANDATORY": true,
+			"capacity": [100.0, 400.0, 1600.0],
+			"charge_power": [100.0],
+			"discharge_power": [100.0],
+			"battery_mode": ["CONSUME"],
+			"incumbent": false,
+			"age": 0,
+			"lifetime": 15
+		},
+		"solar_panels": [
+			{"COMPONENT_IS_MANDATORY": true, "yield_scalar": [0.0, 100.0, 300.0], "yield_index": [0], "incumbent": false, "age": 0, "lifetime": 25}
+		]
+	})";
+}
+
+class GridSearchTest : public ::testing::Test {
+protected:
+	Simulator simulator;
+	GridSearch grid;
+	// the cost of every scenario for each objective, from simulateScenario
+	ObjectiveCosts costs;
+
+	GridSearchTest() :
+		simulator(readSiteData(fs::path{ "./test_files/siteData_MountHotel.json" }), TaskConfig{}),
+		grid(simulator, SITE_RANGE)
+	{
+		std::vector<SimulationResult> results;
+		for (uint64_t i = 0; i < grid.numScenarios(); i++) {
+			results.push_back(simulator.simulateScenario(grid.scenario(i)));
+		}
+		costs = objectiveCosts(results);
+	}
+
+	// the indices of the grid in order of an objective, with ties in grid order
+	std::vector<uint64_t> ranking(size_t objective) const {
+		std::vector<uint64_t> order(grid.numScenarios());
+		std::iota(order.begin(), order.end(), uint64_t{ 0 });
+		std::stable_sort(order.begin(), order.end(), [&](uint64_t a, uint64_t b) {
+			return costs(static_cast<Eigen::Index>(a), static_cast<Eigen::Index>(objective))
+				< costs(static_cast<Eigen::Index>(b), static_cast<Eigen::Index>(objective));
+		});
+		return order;
+	}
+
+	static std::vector<uint64_t> indicesOf(const std::vector<GridSearchEntry>& entries) {
+		std::vector<uint64_t> indices;
+		for (const auto& entry : entries) {
+			indices.push_back(entry.scenario_index);
+		}
+		return indices;
+	}
+};
+
+TEST_F(GridSearchTest, EnumeratesTheCartesianProduct) {
+	ASSERT_EQ(grid.numScenarios(), 18u);
+
+	// the first gene varies slowest
+	EXPECT_EQ(grid.scenario(0).grid->grid_import, 60.0f);
+	EXPECT_EQ(grid.scenario(9).grid->grid_import, 140.0f);
+	EXPECT_EQ(grid.scenario(4).energy_storage_system->capacity, 400.0f);
+	EXPECT_EQ(grid.scenario(4).solar_panels[0].yield_scalar, 100.0f);
+	EXPECT_EQ(grid.scenario(17).energy_storage_system->capacity, 1600.0f);
+	EXPECT_EQ(grid.scenario(17).solar_panels[0].yield_scalar, 300.0f);
+
+	EXPECT_THROW(grid.scenario(18), std::runtime_error);
+}
+
+TEST_F(GridSearchTest, KeepsTheBestOfEachObjective) {
+	GridSearchOptions options;
+	options.top_k = 4;
+	// several batches, the last of them partly filled
+	options.batch_size = 5;
+	GridSearchResult result = grid.run(options);
+
+	EXPECT_EQ(result.num_scenarios, 18u);
+	EXPECT_EQ(result.simulated, 18u);
+	EXPECT_EQ(result.pruned, 0u);
+	ASSERT_EQ(result.best.size(), ALL_OBJECTIVES.size());
+
+	for (size_t j = 0; j < ALL_OBJECTIVES.size(); j++) {
+		SCOPED_TRACE(j);
+		std::vector<uint64_t> expected = ranking(j);
+		expected.resize(4);
+		EXPECT_EQ(indicesOf(result.best[j]), expected);
+	}
+
+	// the objectives are those of simulateScenario
+	const GridSearchEntry& cheapest = result.best[0].front();
+	auto expected = toObjectiveResult(simulator.simulateScenario(grid.scenario(cheapest.scenario_index)), cheapest.result.taskData);
+	EXPECT_EQ(cheapest.result.total_capex, expected.total_capex);
+	EXPECT_EQ(cheapest.result.scenario_cost_balance, expected.scenario_cost_balance);
+
+	// the Pareto set is the first front of the whole grid, keeping only the first of any identical scenarios
+	std::vector<size_t> front = nonDominatedSort(costs).front();
+	std::sort(front.begin(), front.end());
+	std::vector<uint64_t> distinct;
+	for (size_t i : front) {
+		const bool repeated = std::any_of(distinct.begin(), distinct.end(), [&](uint64_t d) {
+			return costs.row(static_cast<Eigen::Index>(d)) == costs.row(static_cast<Eigen::Index>(i));
+		});
+		if (!repeated) {
+			distinct.push_back(i);
+		}
+	}
+	EXPECT_EQ(indicesOf(result.pareto), distinct);
+	EXPECT_LT(distinct.size(), front.size());
+}
+
+TEST_F(GridSearchTest, PrunesScenariosAboveTheMaximumCapex) {
+	// half of the grid is above the limit
+	std::vector<float> capex;
+	for (uint64_t i = 0; i < grid.numScenarios(); i++) {
+		capex.push_back(simulator.calculateCapexWithDiscounts(grid.scenario(i)).total_capex);
+	}
+	std::vector<float> sorted = capex;
+	std::sort(sorted.begin(), sorted.end());
+	const float maxCapex = sorted[8];
+
+	GridSearchOptions options;
+	options.top_k = 18;
+	options.max_capex = maxCapex;
+	GridSearchResult result = grid.run(options);
+
+	std::set<uint64_t> expected;
+	for (uint64_t i = 0; i < grid.numScenarios(); i++) {
+		if (capex[i] <= maxCapex) {
+			expected.insert(i);
+		}
+	}
+	EXPECT_EQ(result.simulated, expected.size());
+	EXPECT_EQ(result.simulated + result.pruned, result.num_scenarios);
+
+	const auto byCapex = indicesOf(result.best[0]);
+	EXPECT_EQ(std::set<uint64_t>(byCapex.begin(), byCapex.end()), expected);
+
+	// no limit prunes nothing
+	options.max_capex = sorted.back();
+	EXPECT_EQ(grid.run(options).simulated, 18u);
+}
+
+TEST_F(GridSearchTest, WritesEveryResultToTheCSV) {
+	const fs::path csv = fs::temp_directory_path() / "epoch_grid_search_results.csv";
+
+	GridSearchOptions options;
+	options.results_csv = csv;
+	options.batch_size = 7;
+	grid.run(options);
+
+	std::ifstream in(csv);
+	std::vector<std::string> lines;
+	for (std::string line; std::getline(in, line);) {
+		lines.push_back(line);
+	}
+	in.close();
+	fs::remove(csv);
+
+	// a header and then a row for each scenario in the grid, each with the same number of columns
+	ASSERT_EQ(lines.size(), 19u);
+	const auto columns = std::count(lines[0].begin(), lines[0].end(), ',');
+	for (const auto& line : lines) {
+		EXPECT_EQ(std::count(line.begin(), line.end(), ','), columns);
+	}
+}
+
+TEST_F(GridSearchTest, InvalidOptions) {
+	GridSearchOptions options;
+	options.batch_size = 0;
+	EXPECT_THROW(grid.run(options), std::runtime_error);
+
+	// a site range with no genes is a single scenario
+	GridSearch single(simulator, R"({"grid": {"COMPONENT_IS_MANDATORY": true, "grid_import": [60.0], "incumbent": false, "age": 0, "lifetime": 25}})");
+	EXPECT_EQ(single.numScenarios(), 1u);
+	EXPECT_EQ(single.run(GridSearchOptions{}).simulated, 1u);
+}
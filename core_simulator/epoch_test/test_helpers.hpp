@@ -11,7 +11,7 @@
 * With a start_ts and end_ts 
 */
 inline SiteData makeNHourSiteData(int n, TaskData baseline) {
-    FabricIntervention fi;
+    FabricIntervention fi{};
     fi.cost = 999.0f;
     fi.reduced_hload = Eigen::VectorXf::Ones(n);
 
@@ -0,0 +1,163 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <tuple>
+
+#include <Eigen/Core>
+
+#include "test_helpers.hpp"
+
+#include "../epoch_lib/Simulation/Components/DHW/HotWaterCylinder.hpp"
+#include "../epoch_lib/Simulation/DayBlocks.hpp"
+#include "../epoch_lib/Simulation/DayTariffStats.hpp"
+#include "../epoch_lib/io/FileHandling.hpp"
+
+namespace fs = std::filesystem;
+
+namespace {
+	struct CylinderHistory {
+		year_TS charging;
+		year_TS standby_losses;
+		year_TS soc;
+		year_TS ave_temperature;
+		year_TS shortfall;
+		year_TS diverter_load;
+		year_TS heat_pump_load;
+	};
+
+	// The cylinder model as originally written, with the conversions to and from kJ made at every timestep
+	CylinderHistory referenceCylinder(const SiteData& siteData, const DomesticHotWater& dhw, const HeatPumpData& heatPump,
+		const DayTariffStats& tariffStats, const year_TS& elec_e) {
+		const float c_w = 4.18f, rho = 1.0f, T_cold = 10.0f, T_ambient = 20.0f, T_setpoint = 60.0f;
+		const float volume = dhw.cylinder_volume;
+		const float timestepSeconds = std::chrono::duration<float>(siteData.timestep_interval_s).count();
+		const float capacity = (rho * volume * c_w * (T_setpoint - T_cold)) / 3600.0f;
+		const float U = 1.70f * std::pow((volume / 250), (2.0f / 3.0f));
+		const auto& tariff = siteData.import_tariffs[0];
+
+		const auto n = static_cast<Eigen::Index>(siteData.timesteps);
+		CylinderHistory h{ year_TS::Zero(n), year_TS::Zero(n), year_TS::Zero(n), year_TS::Zero(n), year_TS::Zero(n), year_TS::Zero(n), year_TS::Zero(n) };
+		float energy = 0.0f;
+
+		auto step = [&](float charge, float draw, Eigen::Index t) {
+			float tAve = energy * 3600.0f / (rho * volume * c_w) + T_cold;
+			float lossKJ = U * (tAve - T_ambient) * timestepSeconds / 1000.0f;
+			energy += (charge * 3600.0f - draw * 3600.0f - lossKJ) / 3600.0f;
+			h.standby_losses[t] = lossKJ / 3600.0f;
+			h.ave_temperature[t] = tAve;
+			if (energy < 0) {
+				h.shortfall[t] = -energy;
+				energy = 0;
+			}
+			h.soc[t] = energy;
+		};
+
+		step(0, siteData.dhw_demand[0], 0);
+		for (Eigen::Index t = 1; t < n; t++) {
+			float maxCharge = capacity - energy;
+			float maxHeatPumpCharge = std::min(maxCharge, heatPump.heat_power * siteData.timestep_hours);
+			float renewable = elec_e[t] < 0 ? std::min(-elec_e[t], maxCharge) : 0.0f;
+			float lowTariff = 0;
+			size_t ts = static_cast<size_t>(t);
+			if (tariff[t] <= tariffStats.getDayAverage(ts) && tariff[t] <= tariffStats.getDayPercentile(ts)) {
+				lowTariff = maxHeatPumpCharge - renewable;
+			}
+			step(renewable + lowTariff, siteData.dhw_demand[t], t);
+			h.charging[t] = renewable + lowTariff;
+			h.diverter_load[t] = renewable;
+			h.heat_pump_load[t] = lowTariff;
+		}
+		return h;
+	}
+
+	void expectNear(const Eigen::Ref<const year_TS>& actual, const year_TS& expected, float tolerance, const char* name) {
+		ASSERT_EQ(actual.size(), expected.size()) << name;
+		EXPECT_LE((actual - expected).cwiseAbs().maxCoeff(), tolerance) << name;
+	}
+}
+
+TEST(HotWaterCylinder, MatchesTheKilojouleModel) {
+	const SiteData siteData = readSiteData(fs::path{ "./test_files/siteData_MountHotel.json" });
+	const DayTariffStats tariffStats{ siteData, 0 };
+	const HeatPumpData heatPump{};
+
+	for (float volume : { 100.0f, 450.0f, 2000.0f }) {
+		SCOPED_TRACE(volume);
+		DomesticHotWater dhw{};
+		dhw.cylinder_volume = volume;
+
+		// alternate between surplus demand and surplus generation so that both charging routes are exercised
+		TempSum tempSum{ siteData };
+		tempSum.Elec_e = siteData.building_eload - 3.0f * siteData.solar_yields[0] * 50.0f;
+		const CylinderHistory expected = referenceCylinder(siteData, dhw, heatPump, tariffStats, tempSum.Elec_e);
+
+		HotWaterCylinder cylinder{ siteData, dhw, heatPump, tariffStats, ReportColumnMask::all() };
+		cylinder.AllCalcs(tempSum);
+		ReportData report;
+		cylinder.Report(report);
+
+		// the folded constants round differently, so the results agree to a tolerance rather than bit-for-bit
+		const float tolerance = 1e-4f;
+		expectNear(report.get(ReportColumn::DHW_charging), expected.charging, tolerance, "charging");
+		expectNear(report.get(ReportColumn::DHW_Standby_loss), expected.standby_losses, tolerance, "standby losses");
+		expectNear(report.get(ReportColumn::DHW_SoC), expected.soc, tolerance, "SoC");
+		expectNear(report.get(ReportColumn::DHW_ave_temperature), expected.ave_temperature, tolerance, "temperature");
+		expectNear(report.get(ReportColumn::DHW_immersion_top_up), expected.shortfall, tolerance, "shortfall");
+		expectNear(report.get(ReportColumn::DHW_diverter_load), expected.diverter_load, tolerance, "diverter load");
+		expectNear(tempSum.DHW_load_h, expected.heat_pump_load, tolerance, "heat pump load");
+	}
+}
+
+TEST(HotWaterCylinder, EveryDayBlockKernelHasTheSameResult) {
+	// a half-hourly year, and hourly timesteps with a partial final day
+	for (const SiteData& siteData : { readSiteData(fs::path{ "./test_files/siteData_MountHotel.json" }), makeNHourSiteData(84) }) {
+		SCOPED_TRACE(siteData.timesteps);
+		const DayTariffStats tariffStats{ siteData, 0 };
+		DomesticHotWater dhw{};
+		dhw.cylinder_volume = 300.0f;
+		// with both surplus demand and surplus generation, so that both charging routes are exercised
+		const auto n = static_cast<Eigen::Index>(siteData.timesteps);
+		const Eigen::VectorXf elec = siteData.building_eload - 3.0f * siteData.solar_yields[0] * 50.0f
+			+ Eigen::VectorXf::LinSpaced(n, 0.0f, 300.0f);
+
+		// a fresh cylinder starts part way through its first day, and a continuing one on a day boundary
+		for (bool continuing : { false, true }) {
+			SCOPED_TRACE(continuing);
+			auto run = [&](size_t dayBlock) {
+				HotWaterCylinder cylinder{ siteData, dhw, HeatPumpData{}, tariffStats, ReportColumnMask::all() };
+				if (continuing) {
+					cylinder.continueFrom(5.0f);
+				}
+				TempSum tempSum{ siteData };
+				tempSum.Elec_e = elec;
+				cylinder.AllCalcs(tempSum, dayBlock);
+				ReportData report;
+				cylinder.Report(report);
+				return std::make_tuple(report, Eigen::VectorXf(tempSum.Elec_e), cylinder.getEnergy());
+			};
+
+			const auto [expected, expectedElec, expectedEnergy] = run(0);
+			for (size_t dayBlock : { HALF_HOURLY_DAY_BLOCK, HOURLY_DAY_BLOCK }) {
+				SCOPED_TRACE(dayBlock);
+				const auto [report, elecAfter, energy] = run(dayBlock);
+				EXPECT_EQ(energy, expectedEnergy);
+				EXPECT_TRUE(elecAfter == expectedElec);
+				for (ReportColumn column : expected.populatedColumns()) {
+					EXPECT_TRUE(report.get(column) == expected.get(column)) << REPORT_COLUMN_NAMES[static_cast<size_t>(column)];
+				}
+			}
+		}
+	}
+}
+
+TEST(DayBlocks, SpecialisesHalfHourlyAndHourlySites) {
+	EXPECT_EQ(dayBlockSize(readSiteData(fs::path{ "./test_files/siteData_MountHotel.json" })), HALF_HOURLY_DAY_BLOCK);
+	EXPECT_EQ(dayBlockSize(makeNHourSiteData(84)), HOURLY_DAY_BLOCK);
+
+	// a quarter-hourly site has the generic kernel
+	SiteData siteData = makeNHourSiteData(24);
+	siteData.timestep_interval_s = std::chrono::seconds{ 15 * 60 };
+	EXPECT_EQ(dayBlockSize(siteData), 0u);
+}
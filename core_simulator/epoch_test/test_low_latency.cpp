@@ -0,0 +1,101 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <stdexcept>
+#include <vector>
+
+#include <Eigen/Core>
+
+#include "../epoch_lib/Simulation/Simulate.hpp"
+#include "../epoch_lib/Simulation/ThreadPool.hpp"
+#include "../epoch_lib/io/FileHandling.hpp"
+
+namespace fs = std::filesystem;
+
+class LowLatencyTest : public ::testing::TestWithParam<const char*> {
+protected:
+	static void expectSameReport(const SimulationResult& result, const SimulationResult& expected) {
+		ASSERT_TRUE(result.report_data.has_value());
+		ASSERT_TRUE(expected.report_data.has_value());
+		ASSERT_EQ(result.report_data->populatedColumns(), expected.report_data->populatedColumns());
+		for (ReportColumn column : expected.report_data->populatedColumns()) {
+			SCOPED_TRACE(REPORT_COLUMN_NAMES[static_cast<size_t>(column)]);
+			EXPECT_TRUE(result.report_data->get(column) == expected.report_data->get(column));
+		}
+	}
+};
+
+TEST_P(LowLatencyTest, MatchesTheSequentialReport) {
+	Simulator simulator(readSiteData(fs::path{ "./test_files/siteData_MountHotel.json" }), TaskConfig{});
+	const TaskData taskData = readTaskData(fs::path{ GetParam() });
+	const SimulationResult expected = simulator.simulateScenario(taskData, SimulationType::FullReporting);
+
+	ThreadPool pool(4);
+	simulator.enableLowLatency(pool);
+	// more than once, as the stages may finish in a different order each time
+	for (int run = 0; run < 3; run++) {
+		SCOPED_TRACE(run);
+		const SimulationResult result = simulator.simulateScenario(taskData, SimulationType::FullReporting);
+		expectSameReport(result, expected);
+		EXPECT_EQ(result.metrics.total_electricity_imported, expected.metrics.total_electricity_imported);
+		EXPECT_EQ(result.metrics.total_gas_used, expected.metrics.total_gas_used);
+		EXPECT_EQ(result.metrics.total_heat_shortfall, expected.metrics.total_heat_shortfall);
+		EXPECT_EQ(result.metrics.total_electricity_generated, expected.metrics.total_electricity_generated);
+		EXPECT_EQ(result.metrics.total_operating_cost, expected.metrics.total_operating_cost);
+		EXPECT_EQ(result.comparison.cost_balance, expected.comparison.cost_balance);
+	}
+
+	// only some of the columns
+	const ReportColumnMask columns = { ReportColumn::Grid_Import, ReportColumn::Hotel_load, ReportColumn::ESS_charge };
+	simulator.disableLowLatency();
+	const SimulationResult expectedColumns = simulator.simulateScenario(taskData, columns);
+	simulator.enableLowLatency(pool);
+	expectSameReport(simulator.simulateScenario(taskData, columns), expectedColumns);
+}
+
+INSTANTIATE_TEST_SUITE_P(Scenarios, LowLatencyTest, ::testing::Values(
+	"./test_files/taskData_full.json",
+	"./test_files/taskData_common.json"
+));
+
+TEST(LowLatency, LeavesResultOnlyScenariosAlone) {
+	Simulator simulator(readSiteData(fs::path{ "./test_files/siteData_MountHotel.json" }), TaskConfig{});
+	const TaskData taskData = readTaskData(fs::path{ "./test_files/taskData_full.json" });
+	const SimulationResult expected = simulator.simulateScenario(taskData);
+
+	simulator.enableLowLatency();
+	const SimulationResult result = simulator.simulateScenario(taskData);
+	EXPECT_FALSE(result.report_data.has_value());
+	EXPECT_EQ(result.metrics.total_annualised_cost, expected.metrics.total_annualised_cost);
+	EXPECT_EQ(result.metrics.total_electricity_imported, expected.metrics.total_electricity_imported);
+}
+
+TEST(ReportDataSharedWrites, WritesEachColumnFromItsOwnThread) {
+	const std::vector<ReportColumn> columns = {
+		ReportColumn::Hotel_load, ReportColumn::PVacGen, ReportColumn::Grid_Import, ReportColumn::ESS_charge, ReportColumn::GasCH_load
+	};
+	ReportData reportData;
+	EXPECT_THROW(ReportData::SharedWrites{ reportData }, std::runtime_error);
+
+	reportData.reserve(100);
+	{
+		ReportData::SharedWrites shared(reportData);
+		ThreadPool pool(4);
+		pool.parallelFor(columns.size(), [&](size_t i) {
+			reportData.set(columns[i], Eigen::VectorXf::Constant(100, static_cast<float>(i)));
+		});
+	}
+	EXPECT_EQ(reportData.numPopulated(), static_cast<Eigen::Index>(columns.size()));
+
+	reportData.shrinkToPopulated();
+	const std::vector<ReportColumn> populated = reportData.populatedColumns();
+	for (size_t i = 0; i < columns.size(); i++) {
+		SCOPED_TRACE(i);
+		EXPECT_TRUE(reportData.has(columns[i]));
+		EXPECT_EQ(reportData.get(columns[i])[42], static_cast<float>(i));
+		// shrinking puts the columns in the ReportColumn order, whichever thread wrote them first
+		if (i > 0) {
+			EXPECT_LT(static_cast<size_t>(populated[i - 1]), static_cast<size_t>(populated[i]));
+		}
+	}
+}
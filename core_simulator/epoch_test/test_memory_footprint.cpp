@@ -0,0 +1,109 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <filesystem>
+#include <string>
+
+#include "../epoch_lib/Simulation/MemoryFootprint.hpp"
+#include "../epoch_lib/Simulation/Simulate.hpp"
+#include "../epoch_lib/io/FileHandling.hpp"
+
+namespace fs = std::filesystem;
+
+namespace {
+	size_t partBytes(const MemoryFootprint& footprint, const std::string& name) {
+		for (const auto& part : footprint.parts) {
+			if (part.name == name) {
+				return part.bytes;
+			}
+		}
+		ADD_FAILURE() << "No part named " << name;
+		return 0;
+	}
+
+	size_t prefixBytes(const MemoryFootprint& footprint, const std::string& prefix) {
+		size_t bytes = 0;
+		for (const auto& part : footprint.parts) {
+			if (part.name.starts_with(prefix)) {
+				bytes += part.bytes;
+			}
+		}
+		return bytes;
+	}
+}
+
+class MemoryFootprintTest : public ::testing::Test {
+protected:
+	SiteData siteData;
+	TaskData full;
+
+	MemoryFootprintTest() :
+		siteData(readSiteData(fs::path{ "./test_files/siteData_MountHotel.json" })),
+		full(readTaskData(fs::path{ "./test_files/taskData_full.json" }))
+	{}
+};
+
+TEST_F(MemoryFootprintTest, SiteDataBreakdownSumsToItsFootprint) {
+	const MemoryFootprint breakdown = siteData.memoryBreakdown();
+	EXPECT_EQ(breakdown.total(), siteData.memoryFootprint());
+
+	const size_t series = sizeof(float) * siteData.timesteps;
+	EXPECT_EQ(partBytes(breakdown, "building_eload"), series);
+	EXPECT_EQ(partBytes(breakdown, "import_tariffs[0]"), series);
+	EXPECT_EQ(prefixBytes(breakdown, "import_tariffs["), series * siteData.import_tariffs.size());
+	EXPECT_EQ(prefixBytes(breakdown, "fabric_interventions["), series * siteData.fabric_interventions.size());
+}
+
+TEST_F(MemoryFootprintTest, SharedStorageIsCountedOnce) {
+	MemorySeen seen;
+	EXPECT_EQ(siteData.memoryBreakdown(&seen).total(), siteData.memoryFootprint());
+	// every series has been seen, apart from the lookup tables and ensemble (which are never shared)
+	const MemoryFootprint again = siteData.memoryBreakdown(&seen);
+	EXPECT_EQ(partBytes(again, "building_eload"), 0);
+	EXPECT_EQ(partBytes(again, "solar_yields"), 0);
+}
+
+TEST_F(MemoryFootprintTest, SimulatorIncludesSiteDataBaselineAndCaches) {
+	Simulator simulator(siteData, TaskConfig{});
+	// the baseline isn't simulated until it is needed, and isn't simulated to count it
+	EXPECT_EQ(partBytes(simulator.memoryBreakdown(), "baseline_report_data"), 0);
+	EXPECT_FALSE(simulator.hasBaseline());
+
+	simulator.getBaseline();
+	const MemoryFootprint before = simulator.memoryBreakdown();
+	EXPECT_EQ(before.total(), simulator.memoryFootprint());
+	EXPECT_EQ(prefixBytes(before, "site_data."), simulator.getSiteData()->memoryFootprint());
+	EXPECT_GT(partBytes(before, "baseline_report_data"), 0);
+	EXPECT_GT(partBytes(before, "tariff_stats"), 0);
+	EXPECT_EQ(partBytes(before, "result_cache"), 0);
+
+	simulator.enableResultCache(1 << 20);
+	simulator.simulateScenario(full);
+	const MemoryFootprint after = simulator.memoryBreakdown();
+	EXPECT_EQ(partBytes(after, "result_cache"), simulator.getResultCacheStats()->bytes);
+	EXPECT_GT(partBytes(after, "result_cache"), 0);
+}
+
+TEST_F(MemoryFootprintTest, ResolutionSharingTheSiteDataAddsNoSiteData) {
+	Simulator simulator(siteData, TaskConfig{});
+	const size_t alone = simulator.memoryFootprint();
+
+	simulator.atResolution(simulator.getSiteData()->timestep_interval_s);
+	const MemoryFootprint breakdown = simulator.memoryBreakdown();
+	// the Simulator at the native resolution shares the SiteData but has its own baseline and derived data
+	EXPECT_GT(partBytes(breakdown, "resolutions"), 0);
+	EXPECT_LT(partBytes(breakdown, "resolutions"), alone);
+}
+
+TEST_F(MemoryFootprintTest, ResultWithAndWithoutReportData) {
+	Simulator simulator(siteData, TaskConfig{});
+
+	const SimulationResult compact = simulator.simulateScenario(full);
+	EXPECT_EQ(compact.memoryFootprint(), sizeof(SimulationResult));
+
+	const SimulationResult reported = simulator.simulateScenario(full, SimulationType::FullReporting);
+	ASSERT_TRUE(reported.report_data.has_value());
+	EXPECT_EQ(reported.memoryFootprint(false), sizeof(SimulationResult));
+	EXPECT_EQ(reported.memoryFootprint(), sizeof(SimulationResult) + reported.report_data->ownedBytes());
+	EXPECT_GE(reported.report_data->ownedBytes(), sizeof(float) * siteData.timesteps * reported.report_data->populatedColumns().size());
+}
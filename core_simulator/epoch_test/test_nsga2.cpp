@@ -0,0 +1,195 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../epoch_lib/Optimisation/GridSearch.hpp"
+#include "../epoch_lib/Optimisation/NSGA2.hpp"
+#include "../epoch_lib/Optimisation/Pareto.hpp"
+#include "../epoch_lib/Simulation/Simulate.hpp"
+#include "../epoch_lib/io/FileHandling.hpp"
+#include "../epoch_lib/io/ScenarioCodec.hpp"
+
+namespace fs = std::filesystem;
+
+namespace {
+	// the battery is optional, so a third of the grid repeats the scenarios without a battery
+	const std::string SITE_RANGE = R"({
+		"grid": {
+			"COMPONENT_IS_MANDATORY": true,
+			"grid_import": [60.0, 140.0],
+			"grid_export": [60.0],
+			"tariff_index": [0],
+			"incumbent": false,
+			"age": 0,
+			"lifetime": 25
+		},
+		"energy_storage_system": {
+			"COMPONENT_IS_MANDATORY": false,
+			"capacity": [100.0, 400.0, 1600.0],
+			"charge_power": [100.0],
+			"discharge_power": [100.0],
+			"battery_mode": ["CONSUME"],
+			"incumbent": false,
+			"age": 0,
+			"lifetime": 15
+		},
+		"solar_panels": [
+			{"COMPONENT_IS_MANDATORY": true, "yield_scalar": [0.0, 100.0, 300.0], "yield_index": [0], "incumbent": false, "age": 0, "lifetime": 25}
+		]
+	})";
+
+	// the distinct scenarios in the site range
+	constexpr uint64_t NUM_DISTINCT = 2 * (1 + 3) * 3;
+
+	const std::vector<Objective> OBJECTIVES = { Objective::CAPEX, Objective::CostBalance };
+
+	std::span<const double> rowOf(const ObjectiveCosts& costs, Eigen::Index row) {
+		return { costs.row(row).data(), static_cast<size_t>(costs.cols()) };
+	}
+}
+
+class NSGA2Test : public ::testing::Test {
+protected:
+	Simulator simulator;
+	ScenarioCodec codec;
+	NSGA2 nsga2;
+
+	NSGA2Test() :
+		simulator(readSiteData(fs::path{ "./test_files/siteData_MountHotel.json" }), TaskConfig{}),
+		codec(SITE_RANGE),
+		nsga2(simulator, codec, OBJECTIVES)
+	{
+	}
+
+	static NSGA2Options smallOptions() {
+		NSGA2Options options;
+		options.pop_size = 8;
+		options.n_offsprings = 4;
+		options.n_max_gen = 30;
+		options.seed = 7;
+		return options;
+	}
+
+	// the objective costs of every scenario in the site range
+	ObjectiveCosts gridCosts() const {
+		GridSearch grid(simulator, SITE_RANGE);
+		std::vector<SimulationResult> results;
+		for (uint64_t i = 0; i < grid.numScenarios(); i++) {
+			results.push_back(simulator.simulateScenario(grid.scenario(i)));
+		}
+		return objectiveCosts(results, OBJECTIVES);
+	}
+};
+
+TEST_F(NSGA2Test, FindsTheFirstFrontOfTheGrid) {
+	NSGA2Result result = nsga2.run(smallOptions());
+	ASSERT_GT(result.optimal.chromosomes.rows(), 0);
+
+	// no scenario is simulated twice
+	EXPECT_LE(result.n_evals, NUM_DISTINCT);
+
+	const ObjectiveCosts grid = gridCosts();
+	for (Eigen::Index i = 0; i < result.optimal.costs.rows(); i++) {
+		for (Eigen::Index j = 0; j < grid.rows(); j++) {
+			EXPECT_FALSE(dominates(rowOf(grid, j), rowOf(result.optimal.costs, i)));
+		}
+		EXPECT_EQ(result.optimal.violation[i], 0.0);
+	}
+
+	// the costs are those of the scenarios' own simulations
+	const TaskData first = codec.decode(std::span<const double>(result.optimal.chromosomes.row(0).data(), codec.numGenes()));
+	EXPECT_EQ(result.optimal.costs(0, 0), objectiveCost(simulator.simulateScenario(first), Objective::CAPEX));
+}
+
+TEST_F(NSGA2Test, KeepsToTheConstraints) {
+	// the capex of the scenario with only the cheapest grid connection and no solar
+	const double minCapex = objectiveCost(
+		simulator.simulateScenario(codec.decode(std::vector<double>(codec.numGenes(), 0.0))), Objective::CAPEX);
+	const double maxCapex = minCapex + 100000.0;
+
+	NSGA2 constrained(simulator, codec, OBJECTIVES, { MetricConstraint{ Objective::CAPEX, std::nullopt, maxCapex } });
+	NSGA2Result result = constrained.run(smallOptions());
+	ASSERT_GT(result.optimal.chromosomes.rows(), 0);
+	for (Eigen::Index i = 0; i < result.optimal.costs.rows(); i++) {
+		EXPECT_LE(result.optimal.costs(i, 0), maxCapex);
+		EXPECT_EQ(result.optimal.violation[i], 0.0);
+	}
+
+	// no scenario is feasible, so only the least infeasible is returned
+	NSGA2 infeasible(simulator, codec, OBJECTIVES, { MetricConstraint{ Objective::CAPEX, std::nullopt, minCapex - 1.0 } });
+	result = infeasible.run(smallOptions());
+	ASSERT_EQ(result.optimal.chromosomes.rows(), 1);
+	EXPECT_NEAR(result.optimal.violation[0], 1.0, 1e-3);
+
+	NSGA2Options options = smallOptions();
+	options.return_least_infeasible = false;
+	EXPECT_EQ(infeasible.run(options).optimal.chromosomes.rows(), 0);
+}
+
+TEST_F(NSGA2Test, StartsFromTheSeeds) {
+	Chromosomes seeds(2, codec.numGenes());
+	seeds << 1, 1, 2, 2,
+		0, 1, 1, 0;
+
+	std::vector<size_t> generations;
+	bool seeded = false;
+	auto callback = [&](const NSGA2Generation& generation) {
+		generations.push_back(generation.generation);
+		if (generation.generation == 1) {
+			EXPECT_EQ(generation.population.chromosomes.rows(), 8);
+			for (Eigen::Index s = 0; s < seeds.rows(); s++) {
+				bool found = false;
+				for (Eigen::Index i = 0; i < generation.population.chromosomes.rows(); i++) {
+					found = found || generation.population.chromosomes.row(i) == seeds.row(s);
+				}
+				EXPECT_TRUE(found);
+			}
+			seeded = true;
+		}
+		// stop after the third generation
+		return generation.generation < 3;
+	};
+
+	NSGA2Result result = nsga2.run(smallOptions(), seeds, callback);
+	EXPECT_TRUE(seeded);
+	EXPECT_EQ(generations, (std::vector<size_t>{ 1, 2, 3 }));
+	EXPECT_EQ(result.generations, 3u);
+	EXPECT_EQ(result.n_evals, 8u + 2 * 4u);
+}
+
+TEST_F(NSGA2Test, RepairsDegenerateGenes) {
+	Chromosomes chromosomes(3, codec.numGenes());
+	chromosomes << 0.6, 0.0, 2.0, 1.0,
+		1.0, 1.0, 2.0, 5.4,
+		-3.0, 1.4, 1.6, 0.2;
+	nsga2.repair(chromosomes);
+
+	Chromosomes expected(3, codec.numGenes());
+	// an absent battery has the first capacity
+	expected << 1.0, 0.0, 0.0, 1.0,
+		1.0, 1.0, 2.0, 2.0,
+		0.0, 1.0, 2.0, 0.0;
+	EXPECT_EQ(chromosomes, expected);
+}
+
+TEST_F(NSGA2Test, IsReproducibleWithASeed) {
+	NSGA2Result first = nsga2.run(smallOptions());
+	NSGA2Result second = nsga2.run(smallOptions());
+	EXPECT_EQ(first.n_evals, second.n_evals);
+	EXPECT_EQ(first.optimal.chromosomes, second.optimal.chromosomes);
+}
+
+TEST_F(NSGA2Test, InvalidInputs) {
+	EXPECT_THROW(NSGA2(simulator, codec, {}), std::runtime_error);
+
+	NSGA2Options options = smallOptions();
+	options.pop_size = 0;
+	EXPECT_THROW(nsga2.run(options), std::runtime_error);
+
+	Chromosomes seeds = Chromosomes::Zero(1, 3);
+	EXPECT_THROW(nsga2.run(smallOptions(), seeds), std::runtime_error);
+}
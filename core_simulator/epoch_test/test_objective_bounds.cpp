@@ -0,0 +1,101 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <vector>
+
+#include "../epoch_lib/Optimisation/Pareto.hpp"
+#include "../epoch_lib/Simulation/Simulate.hpp"
+#include "../epoch_lib/io/FileHandling.hpp"
+
+namespace fs = std::filesystem;
+
+class ObjectiveBoundsTest : public ::testing::Test {
+protected:
+	Simulator simulator;
+	std::vector<TaskData> candidates;
+
+	ObjectiveBoundsTest() :
+		simulator(readSiteData(fs::path{ "./test_files/siteData_MountHotel.json" }), TaskConfig{})
+	{
+		const TaskData empty = readTaskData(fs::path{ "./test_files/taskData_empty.json" });
+		const TaskData common = readTaskData(fs::path{ "./test_files/taskData_common.json" });
+		const TaskData full = readTaskData(fs::path{ "./test_files/taskData_full.json" });
+		candidates = { empty, common, full };
+
+		TaskData withoutESS = common;
+		withoutESS.energy_storage_system.reset();
+		candidates.push_back(withoutESS);
+
+		TaskData largeESS = common;
+		largeESS.energy_storage_system->capacity *= 4.0f;
+		largeESS.energy_storage_system->charge_power *= 4.0f;
+		largeESS.energy_storage_system->discharge_power *= 4.0f;
+		candidates.push_back(largeESS);
+
+		TaskData constrained = common;
+		constrained.grid->grid_import = 20.0f;
+		candidates.push_back(constrained);
+
+		TaskData arbitrage = full;
+		arbitrage.energy_storage_system->battery_mode = BatteryMode::CONSUME_PLUS;
+		candidates.push_back(arbitrage);
+
+		// a data centre whose heatpump meets heat in the balancing loop
+		TaskData hotroom = full;
+		hotroom.heat_pump->heat_source = HeatSource::HOTROOM;
+		hotroom.gas_heater.reset();
+		candidates.push_back(hotroom);
+	}
+};
+
+TEST_F(ObjectiveBoundsTest, BoundEverySimulation) {
+	for (size_t i = 0; i < candidates.size(); i++) {
+		SCOPED_TRACE(i);
+		const ObjectiveBounds bounds = simulator.boundObjectives(candidates[i]);
+		const SimulationResult result = simulator.simulateScenario(candidates[i]);
+		EXPECT_FALSE(bounds.invalid);
+
+		EXPECT_EQ(bounds.total_capex, result.metrics.total_capex);
+		EXPECT_EQ(bounds.total_annualised_cost, result.metrics.total_annualised_cost);
+		EXPECT_GE(bounds.cost_balance, result.comparison.cost_balance);
+		EXPECT_GE(bounds.operating_balance, result.comparison.operating_balance);
+		EXPECT_GE(bounds.combined_carbon_balance, result.comparison.combined_carbon_balance);
+		if (result.comparison.payback_horizon_years > 0.0f) {
+			EXPECT_LE(bounds.payback_horizon_years, result.comparison.payback_horizon_years);
+		}
+
+		for (Objective objective : ALL_OBJECTIVES) {
+			EXPECT_LE(objectiveCostBound(bounds, objective), objectiveCost(result, objective));
+		}
+	}
+}
+
+TEST_F(ObjectiveBoundsTest, BatchMatchesEachCandidate) {
+	// repeat the candidates, so that those sharing a state before the balancing loop are bounded from one snapshot
+	std::vector<TaskData> batch = candidates;
+	batch.insert(batch.end(), candidates.begin(), candidates.end());
+
+	const auto bounds = simulator.boundObjectives(batch);
+	ASSERT_EQ(bounds.size(), batch.size());
+	for (size_t i = 0; i < batch.size(); i++) {
+		SCOPED_TRACE(i);
+		const ObjectiveBounds single = simulator.boundObjectives(batch[i]);
+		EXPECT_EQ(bounds[i].total_capex, single.total_capex);
+		EXPECT_EQ(bounds[i].cost_balance, single.cost_balance);
+		EXPECT_EQ(bounds[i].operating_balance, single.operating_balance);
+		EXPECT_EQ(bounds[i].combined_carbon_balance, single.combined_carbon_balance);
+		EXPECT_EQ(bounds[i].payback_horizon_years, single.payback_horizon_years);
+	}
+}
+
+TEST_F(ObjectiveBoundsTest, InvalidCandidatesHaveTheirResult) {
+	TaskData invalid = candidates[1];
+	invalid.grid->tariff_index = 999;
+
+	const ObjectiveBounds bounds = simulator.boundObjectives(invalid);
+	const SimulationResult result = simulator.simulateScenario(invalid);
+	EXPECT_TRUE(bounds.invalid);
+	for (Objective objective : ALL_OBJECTIVES) {
+		EXPECT_EQ(objectiveCostBound(bounds, objective), objectiveCost(result, objective));
+	}
+}
@@ -0,0 +1,156 @@
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include <gtest/gtest.h>
+#include <nlohmann/json.hpp>
+
+#include "../epoch_lib/io/OnDemandJson.hpp"
+#include "../epoch_lib/io/SiteDataJson.hpp"
+#include "../epoch_lib/io/TaskDataJson.hpp"
+
+namespace fs = std::filesystem;
+
+namespace {
+	std::string readText(const fs::path& path) {
+		std::ifstream f(path, std::ios::binary);
+		std::ostringstream contents;
+		contents << f.rdbuf();
+		return contents.str();
+	}
+
+	void expectSameSiteData(const SiteData& actual, const SiteData& expected) {
+		EXPECT_EQ(actual.start_ts, expected.start_ts);
+		EXPECT_EQ(actual.end_ts, expected.end_ts);
+		EXPECT_EQ(actual.baseline, expected.baseline);
+		EXPECT_EQ(actual.peak_hload, expected.peak_hload);
+		EXPECT_TRUE(actual.building_eload == expected.building_eload);
+		EXPECT_TRUE(actual.building_hload == expected.building_hload);
+		EXPECT_TRUE(actual.ev_eload == expected.ev_eload);
+		EXPECT_TRUE(actual.dhw_demand == expected.dhw_demand);
+		EXPECT_TRUE(actual.air_temperature == expected.air_temperature);
+		EXPECT_TRUE(actual.grid_co2 == expected.grid_co2);
+
+		ASSERT_EQ(actual.solar_yields.size(), expected.solar_yields.size());
+		for (size_t i = 0; i < expected.solar_yields.size(); i++) {
+			EXPECT_TRUE(actual.solar_yields[i] == expected.solar_yields[i]);
+		}
+		ASSERT_EQ(actual.import_tariffs.size(), expected.import_tariffs.size());
+		for (size_t i = 0; i < expected.import_tariffs.size(); i++) {
+			EXPECT_TRUE(actual.import_tariffs[i] == expected.import_tariffs[i]);
+		}
+
+		ASSERT_EQ(actual.fabric_interventions.size(), expected.fabric_interventions.size());
+		for (size_t i = 0; i < expected.fabric_interventions.size(); i++) {
+			const auto& fi = actual.fabric_interventions[i];
+			const auto& expectedFi = expected.fabric_interventions[i];
+			EXPECT_EQ(fi.cost, expectedFi.cost);
+			EXPECT_EQ(fi.peak_hload, expectedFi.peak_hload);
+			EXPECT_TRUE(fi.reduced_hload == expectedFi.reduced_hload);
+			EXPECT_EQ(fi.hload_delta.has_value(), expectedFi.hload_delta.has_value());
+			EXPECT_TRUE(fi.heatLoad() == expectedFi.heatLoad());
+			ASSERT_EQ(fi.cost_breakdown.size(), expectedFi.cost_breakdown.size());
+			for (size_t j = 0; j < expectedFi.cost_breakdown.size(); j++) {
+				EXPECT_EQ(fi.cost_breakdown[j].name, expectedFi.cost_breakdown[j].name);
+				EXPECT_EQ(fi.cost_breakdown[j].area, expectedFi.cost_breakdown[j].area);
+				EXPECT_EQ(fi.cost_breakdown[j].cost, expectedFi.cost_breakdown[j].cost);
+			}
+		}
+
+		EXPECT_TRUE(actual.ashp_input_table == expected.ashp_input_table);
+		EXPECT_TRUE(actual.ashp_output_table == expected.ashp_output_table);
+	}
+}
+
+TEST(OnDemandJson, SiteDataMatchesNlohmann) {
+	for (const char* name : { "siteData_MountHotel.json", "siteData_1234.json" }) {
+		SCOPED_TRACE(name);
+		const std::string text = readText(fs::path{ "./test_files" } / name);
+		expectSameSiteData(parseSiteDataOnDemand(text), nlohmann::json::parse(text).get<SiteData>());
+	}
+}
+
+TEST(OnDemandJson, TariffPatternMatchesNlohmann) {
+	nlohmann::json siteData = nlohmann::json::parse(readText(fs::path{ "./test_files/siteData_MountHotel.json" }));
+	siteData["import_tariffs"][1] = {
+		{"bands", {{{"hours", 7}, {"price", 0.1}}, {{"hours", 17}, {"price", 0.3}}}}
+	};
+	const std::string text = siteData.dump();
+	expectSameSiteData(parseSiteDataOnDemand(text), nlohmann::json::parse(text).get<SiteData>());
+}
+
+TEST(OnDemandJson, FabricDeltaMatchesNlohmann) {
+	nlohmann::json siteData = nlohmann::json::parse(readText(fs::path{ "./test_files/siteData_1234.json" }));
+	siteData["fabric_interventions"][1].erase("reduced_hload");
+	siteData["fabric_interventions"][1]["hload_delta"] = { {"scale", 0.5}, {"index", {2}}, {"value", {0.25}} };
+	const std::string text = siteData.dump();
+	expectSameSiteData(parseSiteDataOnDemand(text), nlohmann::json::parse(text).get<SiteData>());
+}
+
+TEST(OnDemandJson, TaskDataMatchesNlohmann) {
+	for (const char* name : { "taskData_empty.json", "taskData_common.json", "taskData_full.json" }) {
+		SCOPED_TRACE(name);
+		const std::string text = readText(fs::path{ "./test_files" } / name);
+		EXPECT_EQ(parseTaskDataOnDemand(text), nlohmann::json::parse(text).get<TaskData>());
+	}
+}
+
+TEST(OnDemandJson, ReadsAnyOrderNullsAndUnknownMembers) {
+	// members out of order, integers written as floats, nulls for optional members and members that aren't ours
+	const std::string text = R"({
+		"comment": { "escaped \"quotes\" and é": [1, 2.5e-3, true, null, "😀"] },
+		"building": null,
+		"solar_panels": [
+			{ "lifetime": 25, "age": 1.5, "incumbent": true, "yield_index": 1.0, "yield_scalar": 12.25 }
+		],
+		"grid": {
+			"tariff_index": 2, "grid_export": 60, "grid_import": 70, "import_headroom": 0.3,
+			"export_tariff": 0.04, "incumbent": false, "age": 0, "lifetime": 25
+		},
+		"energy_storage_system": {
+			"capacity": 100, "charge_power": 50, "discharge_power": 50, "battery_mode": "CONSUME_PLUS",
+			"initial_charge": 0, "incumbent": false, "age": 0, "lifetime": 15
+		}
+	})";
+
+	TaskData taskData = parseTaskDataOnDemand(text);
+	EXPECT_EQ(taskData, nlohmann::json::parse(text).get<TaskData>());
+	EXPECT_FALSE(taskData.building.has_value());
+	ASSERT_EQ(taskData.solar_panels.size(), 1u);
+	EXPECT_EQ(taskData.solar_panels[0].yield_index, 1);
+	EXPECT_EQ(taskData.grid->tariff_index, 2u);
+	EXPECT_EQ(taskData.energy_storage_system->battery_mode, BatteryMode::CONSUME_PLUS);
+
+	// parseTaskDataJson gives the same result with either parser
+	EXPECT_EQ(parseTaskDataJson(text), taskData);
+}
+
+TEST(OnDemandJson, RejectsMalformedJson) {
+	const std::string mop = R"({"mop": {"maximum_load": 300, "incumbent": false, "age": 0, "lifetime": 10}})";
+	EXPECT_NO_THROW(parseTaskDataOnDemand(mop));
+
+	// truncated, trailing characters, a missing member and a value of the wrong type
+	EXPECT_THROW(parseTaskDataOnDemand(mop.substr(0, mop.size() - 1)), std::runtime_error);
+	EXPECT_THROW(parseTaskDataOnDemand(mop + " {}"), std::runtime_error);
+	EXPECT_THROW(parseTaskDataOnDemand(R"({"mop": {"maximum_load": 300, "incumbent": false, "age": 0}})"), std::runtime_error);
+	EXPECT_THROW(parseTaskDataOnDemand(R"({"mop": {"maximum_load": "300", "incumbent": false, "age": 0, "lifetime": 10}})"), std::runtime_error);
+	EXPECT_THROW(parseTaskDataOnDemand(R"({"mop": {"maximum_load": 300, "incumbent": 0, "age": 0, "lifetime": 10}})"), std::runtime_error);
+
+	// inf and nan aren't json numbers, with or without a sign
+	for (const char* number : { "-inf", "-nan", "-infinity", "inf", "nan", "-", "-.5" }) {
+		SCOPED_TRACE(number);
+		const std::string text = std::string(R"({"mop": {"maximum_load": )") + number + R"(, "incumbent": false, "age": 0, "lifetime": 10}})";
+		EXPECT_THROW(parseTaskDataOnDemand(text), std::runtime_error);
+		EXPECT_ANY_THROW(nlohmann::json::parse(text));
+	}
+	EXPECT_NO_THROW(parseTaskDataOnDemand(R"({"mop": {"maximum_load": -0.5e1, "incumbent": false, "age": 0, "lifetime": 10}})"));
+
+	// a SiteData timeseries must be an array of numbers
+	nlohmann::json siteData = nlohmann::json::parse(readText(fs::path{ "./test_files/siteData_MountHotel.json" }));
+	siteData["grid_co2"][3] = "high";
+	EXPECT_THROW(parseSiteDataOnDemand(siteData.dump()), std::runtime_error);
+	siteData.erase("grid_co2");
+	EXPECT_THROW(parseSiteDataOnDemand(siteData.dump()), std::runtime_error);
+}
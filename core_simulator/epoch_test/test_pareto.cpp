@@ -0,0 +1,182 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <limits>
+#include <random>
+#include <set>
+
+#include "../epoch_lib/Optimisation/Pareto.hpp"
+
+namespace {
+	// the fronts found by comparing every pair of candidates
+	std::vector<std::vector<size_t>> bruteForceFronts(const ObjectiveCosts& costs) {
+		const auto n = static_cast<size_t>(costs.rows());
+		std::vector<bool> assigned(n, false);
+		std::vector<std::vector<size_t>> fronts;
+		size_t remaining = n;
+
+		while (remaining > 0) {
+			std::vector<size_t> front;
+			for (size_t i = 0; i < n; i++) {
+				if (assigned[i]) {
+					continue;
+				}
+				bool dominated = false;
+				for (size_t j = 0; j < n && !dominated; j++) {
+					dominated = !assigned[j] && dominates(
+						{ costs.row(static_cast<Eigen::Index>(j)).data(), static_cast<size_t>(costs.cols()) },
+						{ costs.row(static_cast<Eigen::Index>(i)).data(), static_cast<size_t>(costs.cols()) });
+				}
+				if (!dominated) {
+					front.push_back(i);
+				}
+			}
+			for (size_t i : front) {
+				assigned[i] = true;
+			}
+			remaining -= front.size();
+			fronts.push_back(std::move(front));
+		}
+		return fronts;
+	}
+
+	ObjectiveCosts randomCosts(Eigen::Index rows, Eigen::Index cols, unsigned seed) {
+		std::mt19937 rng(seed);
+		// use a coarse grid of values so that there are ties and duplicates
+		std::uniform_int_distribution<int> value(0, 9);
+		ObjectiveCosts costs(rows, cols);
+		for (Eigen::Index i = 0; i < rows; i++) {
+			for (Eigen::Index j = 0; j < cols; j++) {
+				costs(i, j) = value(rng);
+			}
+		}
+		return costs;
+	}
+}
+
+TEST(Pareto, Dominates) {
+	std::vector<double> a = { 1.0, 2.0 };
+	std::vector<double> b = { 1.0, 3.0 };
+	std::vector<double> c = { 0.0, 4.0 };
+
+	EXPECT_TRUE(dominates(a, b));
+	EXPECT_FALSE(dominates(b, a));
+	EXPECT_FALSE(dominates(a, a));
+	EXPECT_FALSE(dominates(a, c));
+	EXPECT_FALSE(dominates(c, a));
+}
+
+TEST(Pareto, SortMatchesBruteForce) {
+	for (Eigen::Index objectives : {2, 3, 5}) {
+		for (unsigned seed = 0; seed < 5; seed++) {
+			ObjectiveCosts costs = randomCosts(200, objectives, seed);
+			EXPECT_EQ(nonDominatedSort(costs), bruteForceFronts(costs)) << objectives << " objectives, seed " << seed;
+		}
+	}
+}
+
+TEST(Pareto, CrowdingDistance) {
+	ObjectiveCosts costs(4, 2);
+	costs << 0.0, 3.0,
+		1.0, 2.0,
+		2.0, 1.0,
+		3.0, 0.0;
+	std::vector<size_t> front = { 0, 1, 2, 3 };
+
+	auto distance = crowdingDistance(costs, front);
+	EXPECT_TRUE(std::isinf(distance[0]));
+	EXPECT_TRUE(std::isinf(distance[3]));
+	EXPECT_DOUBLE_EQ(distance[1], 4.0 / 3.0);
+	EXPECT_DOUBLE_EQ(distance[2], 4.0 / 3.0);
+}
+
+TEST(Pareto, ArchiveKeepsTheFirstFront) {
+	ObjectiveCosts costs = randomCosts(300, 3, 42);
+
+	ParetoArchive archive(3);
+	archive.insert(costs, 0);
+
+	// the archive holds one of each distinct point in the first front
+	auto fronts = nonDominatedSort(costs);
+	std::set<std::vector<double>> expected;
+	for (size_t i : fronts.front()) {
+		expected.insert({ costs(static_cast<Eigen::Index>(i), 0), costs(static_cast<Eigen::Index>(i), 1), costs(static_cast<Eigen::Index>(i), 2) });
+	}
+
+	ObjectiveCosts kept = archive.costs();
+	std::set<std::vector<double>> actual;
+	for (Eigen::Index i = 0; i < kept.rows(); i++) {
+		actual.insert({ kept(i, 0), kept(i, 1), kept(i, 2) });
+	}
+
+	EXPECT_EQ(archive.size(), expected.size());
+	EXPECT_EQ(actual, expected);
+	for (size_t i = 0; i < archive.size(); i++) {
+		EXPECT_EQ(costs.row(static_cast<Eigen::Index>(archive.ids()[i])), kept.row(static_cast<Eigen::Index>(i)));
+	}
+}
+
+TEST(Pareto, ArchiveRemovesDominatedMembers) {
+	ParetoArchive archive(2);
+	EXPECT_TRUE(archive.insert(std::vector<double>{ 2.0, 2.0 }, 0));
+	EXPECT_TRUE(archive.insert(std::vector<double>{ 1.0, 3.0 }, 1));
+	EXPECT_FALSE(archive.insert(std::vector<double>{ 2.0, 2.0 }, 2));
+	EXPECT_FALSE(archive.insert(std::vector<double>{ 3.0, 3.0 }, 3));
+	EXPECT_TRUE(archive.insert(std::vector<double>{ 1.0, 1.0 }, 4));
+
+	EXPECT_EQ(archive.ids(), std::vector<size_t>{ 4 });
+	EXPECT_THROW(archive.insert(std::vector<double>{ 1.0 }, 5), std::runtime_error);
+
+	ParetoArchive duplicates(2, false);
+	EXPECT_TRUE(duplicates.insert(std::vector<double>{ 2.0, 2.0 }, 0));
+	EXPECT_TRUE(duplicates.insert(std::vector<double>{ 2.0, 2.0 }, 1));
+	EXPECT_EQ(duplicates.size(), 2u);
+}
+
+TEST(Pareto, ObjectiveCostsMaximiseTheBalances) {
+	SimulationResult result{};
+	result.metrics.total_capex = 100.0f;
+	result.comparison.cost_balance = 50.0f;
+	result.comparison.combined_carbon_balance = 10.0f;
+
+	std::vector<SimulationResult> results = { result };
+	ObjectiveCosts costs = objectiveCosts(results);
+	ASSERT_EQ(costs.cols(), 5);
+	EXPECT_EQ(costs(0, 0), 100.0);
+	EXPECT_EQ(costs(0, 3), -50.0);
+	EXPECT_EQ(costs(0, 4), -10.0);
+}
+
+TEST(Pareto, ArchiveExcludesDominatedBounds) {
+	ParetoArchive archive(2);
+	archive.insert(std::vector<double>{ 1.0, 3.0 }, 0);
+	archive.insert(std::vector<double>{ 2.0, 2.0 }, 1);
+
+	EXPECT_TRUE(archive.excludes(std::vector<double>{ 2.0, 3.0 }));
+	// an identical candidate would be rejected, so a bound equal to a member excludes too
+	EXPECT_TRUE(archive.excludes(std::vector<double>{ 2.0, 2.0 }));
+	EXPECT_FALSE(archive.excludes(std::vector<double>{ 1.5, 2.5 }));
+	EXPECT_FALSE(archive.excludes(std::vector<double>{ 0.0, 10.0 }));
+	EXPECT_THROW(archive.excludes(std::vector<double>{ 1.0 }), std::runtime_error);
+
+	ParetoArchive duplicates(2, false);
+	duplicates.insert(std::vector<double>{ 2.0, 2.0 }, 0);
+	EXPECT_FALSE(duplicates.excludes(std::vector<double>{ 2.0, 2.0 }));
+}
+
+TEST(Pareto, ObjectiveCostBoundsAllowForNegativePaybacks) {
+	ObjectiveBounds bounds{ 100.0f, 20.0f, 50.0f, 25.0f, 10.0f, 4.0f };
+	EXPECT_EQ(objectiveCostBound(bounds, Objective::CAPEX), 100.0);
+	EXPECT_EQ(objectiveCostBound(bounds, Objective::AnnualisedCost), 20.0);
+	EXPECT_EQ(objectiveCostBound(bounds, Objective::CostBalance), -50.0);
+	EXPECT_EQ(objectiveCostBound(bounds, Objective::CarbonBalance), -10.0);
+	// the scenario might never pay back, with a payback horizon as negative as any
+	EXPECT_EQ(objectiveCostBound(bounds, Objective::PaybackHorizon), -std::numeric_limits<double>::infinity());
+
+	bounds.operating_balance = -25.0f;
+	EXPECT_EQ(objectiveCostBound(bounds, Objective::PaybackHorizon), -4.0);
+
+	bounds.total_capex = 0.0f;
+	bounds.payback_horizon_years = 0.0f;
+	EXPECT_EQ(objectiveCostBound(bounds, Objective::PaybackHorizon), 0.0);
+}
@@ -0,0 +1,186 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+
+#include "../epoch_lib/Portfolio/Portfolio.hpp"
+#include "../epoch_lib/Portfolio/PortfolioSimulator.hpp"
+#include "../epoch_lib/io/FileHandling.hpp"
+
+namespace fs = std::filesystem;
+
+class PortfolioSimulatorTest : public ::testing::Test {
+protected:
+    std::shared_ptr<const Simulator> hotel;
+    std::shared_ptr<const Simulator> annex;
+    TaskData common;
+    TaskData full;
+
+    PortfolioSimulatorTest() :
+        common(readTaskData(fs::path{ "./test_files/taskData_common.json" })),
+        full(readTaskData(fs::path{ "./test_files/taskData_full.json" }))
+    {
+        auto siteData = std::make_shared<const SiteData>(readSiteData(fs::path{ "./test_files/siteData_MountHotel.json" }));
+        hotel = std::make_shared<const Simulator>(siteData, TaskConfig{});
+        annex = std::make_shared<const Simulator>(siteData, TaskConfig{});
+    }
+
+    PortfolioSimulator makePortfolioSimulator() const {
+        return PortfolioSimulator({ {"hotel", hotel}, {"annex", annex} });
+    }
+};
+
+TEST_F(PortfolioSimulatorTest, MatchesSerialAggregation) {
+    PortfolioSimulator portfolioSimulator = makePortfolioSimulator();
+    ThreadPool pool(4);
+
+    auto result = portfolioSimulator.simulatePortfolio({ {"hotel", full}, {"annex", common} }, SimulationType::ResultOnly, pool);
+
+    // the sites are aggregated in name order
+    auto annexResult = annex->simulateScenario(common);
+    auto hotelResult = hotel->simulateScenario(full);
+    auto expected = aggregateSiteResults({ annexResult, hotelResult });
+
+    ASSERT_EQ(result.sites.size(), 2);
+    EXPECT_EQ(result.sites.at("hotel").metrics.total_annualised_cost, hotelResult.metrics.total_annualised_cost);
+    EXPECT_EQ(result.sites.at("annex").metrics.total_annualised_cost, annexResult.metrics.total_annualised_cost);
+
+    EXPECT_EQ(result.portfolio.metrics.total_capex, expected.metrics.total_capex);
+    EXPECT_EQ(result.portfolio.metrics.total_annualised_cost, expected.metrics.total_annualised_cost);
+    EXPECT_EQ(result.portfolio.comparison.cost_balance, expected.comparison.cost_balance);
+    EXPECT_EQ(result.portfolio.comparison.carbon_balance_scope_1, expected.comparison.carbon_balance_scope_1);
+    EXPECT_EQ(result.portfolio.comparison.payback_horizon_years, expected.comparison.payback_horizon_years);
+}
+
+TEST_F(PortfolioSimulatorTest, BatchMatchesIndividualPortfolios) {
+    PortfolioSimulator portfolioSimulator = makePortfolioSimulator();
+    ThreadPool pool(4);
+
+    std::vector<PortfolioTaskData> candidates = {
+        { {"hotel", full}, {"annex", common} },
+        { {"hotel", common} },
+        {},
+        { {"hotel", common}, {"annex", full} }
+    };
+
+    auto results = portfolioSimulator.simulatePortfolios(candidates, SimulationType::ResultOnly, pool);
+    ASSERT_EQ(results.size(), candidates.size());
+
+    for (size_t i = 0; i < candidates.size(); i++) {
+        auto expected = portfolioSimulator.simulatePortfolio(candidates[i], SimulationType::ResultOnly, pool);
+        EXPECT_EQ(results[i].sites.size(), candidates[i].size());
+        EXPECT_EQ(results[i].portfolio.metrics.total_annualised_cost, expected.portfolio.metrics.total_annualised_cost);
+        EXPECT_EQ(results[i].portfolio.comparison.cost_balance, expected.portfolio.comparison.cost_balance);
+    }
+
+    // an empty portfolio aggregates to nothing
+    EXPECT_EQ(results[2].portfolio.metrics.total_capex, 0.0f);
+}
+
+TEST_F(PortfolioSimulatorTest, RejectsUnknownSites) {
+    PortfolioSimulator portfolioSimulator = makePortfolioSimulator();
+
+    EXPECT_THROW(portfolioSimulator.simulatePortfolio({ {"hotel", full}, {"office", common} }), std::runtime_error);
+    EXPECT_THROW(portfolioSimulator.getSimulator("office"), std::runtime_error);
+    EXPECT_THROW(PortfolioSimulator({ {"hotel", nullptr} }), std::runtime_error);
+
+    EXPECT_EQ(portfolioSimulator.siteNames(), (std::vector<std::string>{ "annex", "hotel" }));
+}
+
+TEST(PortfolioSimulatorBuild, BuildsEverySiteConcurrently) {
+    const fs::path jsonPath{ "./test_files/siteData_MountHotel.json" };
+    std::ifstream file(jsonPath);
+    std::string json((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    std::vector<SiteSource> sources = {
+        SiteSource{ "from_file", jsonPath, TaskConfig{} },
+        SiteSource{ "from_json", json, TaskConfig{} }
+    };
+
+    ThreadPool pool(2);
+    PortfolioSimulator portfolioSimulator = PortfolioSimulator::build(sources, pool);
+
+    EXPECT_EQ(portfolioSimulator.siteNames(), (std::vector<std::string>{ "from_file", "from_json" }));
+    ASSERT_EQ(portfolioSimulator.getBuildTimings().size(), 2);
+    for (const auto& [name, timing] : portfolioSimulator.getBuildTimings()) {
+        EXPECT_GT(timing.load, 0.0f);
+        EXPECT_GT(timing.construct, 0.0f);
+    }
+
+    // both sources hold the same SiteData, so give the same results
+    TaskData task = readTaskData(fs::path{ "./test_files/taskData_common.json" });
+    auto result = portfolioSimulator.simulatePortfolio({ {"from_file", task}, {"from_json", task} }, SimulationType::ResultOnly, pool);
+    EXPECT_EQ(result.sites.at("from_file").metrics.total_annualised_cost, result.sites.at("from_json").metrics.total_annualised_cost);
+}
+
+TEST(PortfolioSimulatorBuild, ReportsTheFailingSite) {
+    std::vector<SiteSource> sources = {
+        SiteSource{ "hotel", fs::path{ "./test_files/siteData_MountHotel.json" }, TaskConfig{} },
+        SiteSource{ "missing", fs::path{ "./test_files/does_not_exist.json" }, TaskConfig{} }
+    };
+
+    try {
+        PortfolioSimulator::build(sources);
+        FAIL() << "Expected the missing site to fail";
+    }
+    catch (const std::runtime_error& e) {
+        EXPECT_NE(std::string(e.what()).find("missing"), std::string::npos);
+    }
+
+    std::vector<SiteSource> duplicates = {
+        SiteSource{ "hotel", fs::path{ "./test_files/siteData_MountHotel.json" }, TaskConfig{} },
+        SiteSource{ "hotel", fs::path{ "./test_files/siteData_MountHotel.json" }, TaskConfig{} }
+    };
+    EXPECT_THROW(PortfolioSimulator::build(duplicates), std::runtime_error);
+}
+
+TEST_F(PortfolioSimulatorTest, AggregatePortfoliosChoosesEachSitesResult) {
+    const std::vector<SimulationResult> hotelResults = { hotel->simulateScenario(common), hotel->simulateScenario(full) };
+    const SimulationResult annexResult = annex->simulateScenario(common);
+    const std::vector<std::vector<const SimulationResult*>> candidates = {
+        { &hotelResults[0], &hotelResults[1] },
+        { &annexResult }
+    };
+    ThreadPool pool(4);
+
+    // (portfolios x sites), choosing each of the hotel's results with the annex's only one
+    const std::vector<int64_t> combinations = { 0, 0, 1, 0 };
+    auto portfolios = aggregatePortfolios(candidates, combinations, pool);
+
+    ASSERT_EQ(portfolios.size(), 2);
+    for (size_t p = 0; p < portfolios.size(); p++) {
+        auto expected = aggregateSiteResults({ hotelResults[p], annexResult });
+        EXPECT_EQ(portfolios[p].metrics.total_annualised_cost, expected.metrics.total_annualised_cost);
+        EXPECT_EQ(portfolios[p].comparison.payback_horizon_years, expected.comparison.payback_horizon_years);
+        EXPECT_FALSE(portfolios[p].report_data.has_value());
+    }
+
+    const std::vector<int64_t> outOfRange = { 2, 0 };
+    EXPECT_THROW(aggregatePortfolios(candidates, outOfRange, pool), std::out_of_range);
+    const std::vector<int64_t> partRow = { 0, 0, 1 };
+    EXPECT_THROW(aggregatePortfolios(candidates, partRow, pool), std::out_of_range);
+}
+
+TEST_F(PortfolioSimulatorTest, SumsTheColumnsOfEverySite) {
+    PortfolioSimulator portfolioSimulator = makePortfolioSimulator();
+    ThreadPool pool(4);
+    const ReportColumnMask columns = { ReportColumn::Grid_Import, ReportColumn::Heat_shortfall };
+
+    auto result = portfolioSimulator.simulatePortfolio({ {"hotel", full}, {"annex", common} }, columns, pool);
+
+    auto hotelResult = hotel->simulateScenario(full, columns);
+    auto annexResult = annex->simulateScenario(common, columns);
+    ASSERT_TRUE(result.portfolio.report_data.has_value());
+    for (ReportColumn col : { ReportColumn::Grid_Import, ReportColumn::Heat_shortfall }) {
+        ASSERT_TRUE(result.portfolio.report_data->has(col));
+        const Eigen::VectorXf expected = hotelResult.report_data->get(col) + annexResult.report_data->get(col);
+        EXPECT_TRUE(result.portfolio.report_data->get(col).isApprox(expected)) << REPORT_COLUMN_NAMES[static_cast<size_t>(col)];
+    }
+    EXPECT_FALSE(result.portfolio.report_data->has(ReportColumn::Grid_Export));
+
+    // only the portfolio holds the columns
+    EXPECT_FALSE(result.sites.at("hotel").report_data.has_value());
+    EXPECT_EQ(result.portfolio.metrics.total_annualised_cost, aggregateSiteResults({ hotelResult, annexResult }).metrics.total_annualised_cost);
+}
@@ -0,0 +1,205 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <vector>
+
+#include "../epoch_lib/Simulation/PreBalancingCache.hpp"
+#include "../epoch_lib/Simulation/Simulate.hpp"
+#include "../epoch_lib/io/FileHandling.hpp"
+
+namespace fs = std::filesystem;
+
+namespace {
+	void expectSameResult(const SimulationResult& cached, const SimulationResult& uncached) {
+		EXPECT_EQ(cached.metrics.total_gas_used, uncached.metrics.total_gas_used);
+		EXPECT_EQ(cached.metrics.total_electricity_imported, uncached.metrics.total_electricity_imported);
+		EXPECT_EQ(cached.metrics.total_electricity_generated, uncached.metrics.total_electricity_generated);
+		EXPECT_EQ(cached.metrics.total_electricity_exported, uncached.metrics.total_electricity_exported);
+		EXPECT_EQ(cached.metrics.total_electricity_curtailed, uncached.metrics.total_electricity_curtailed);
+		EXPECT_EQ(cached.metrics.total_heat_load, uncached.metrics.total_heat_load);
+		EXPECT_EQ(cached.metrics.total_heat_shortfall, uncached.metrics.total_heat_shortfall);
+		EXPECT_EQ(cached.metrics.total_annualised_cost, uncached.metrics.total_annualised_cost);
+		EXPECT_EQ(cached.metrics.total_capex, uncached.metrics.total_capex);
+		EXPECT_EQ(cached.metrics.total_scope_2_emissions, uncached.metrics.total_scope_2_emissions);
+		EXPECT_EQ(cached.comparison.cost_balance, uncached.comparison.cost_balance);
+		EXPECT_EQ(cached.comparison.combined_carbon_balance, uncached.comparison.combined_carbon_balance);
+	}
+}
+
+class PreBalancingCacheRun : public ::testing::Test {
+protected:
+	Simulator simulator;
+	TaskData common;
+	TaskData full;
+
+	PreBalancingCacheRun() :
+		simulator(readSiteData(fs::path{ "./test_files/siteData_MountHotel.json" }), TaskConfig{}),
+		common(readTaskData(fs::path{ "./test_files/taskData_common.json" })),
+		full(readTaskData(fs::path{ "./test_files/taskData_full.json" }))
+	{}
+
+	// vary only the components that run in or after the balancing loop
+	std::vector<TaskData> sweep(const TaskData& base) const {
+		std::vector<TaskData> scenarios;
+		for (float capacity : { 100.0f, 400.0f, 1600.0f }) {
+			for (float gridImport : { 100.0f, 250.0f }) {
+				TaskData td = base;
+				if (td.energy_storage_system) {
+					td.energy_storage_system->capacity = capacity;
+				}
+				if (td.grid) {
+					td.grid->grid_import = gridImport;
+				}
+				if (td.mop) {
+					td.mop->maximum_load = capacity / 4.0f;
+				}
+				scenarios.push_back(td);
+			}
+		}
+		return scenarios;
+	}
+};
+
+TEST_F(PreBalancingCacheRun, DisabledByDefault) {
+	EXPECT_FALSE(simulator.getPreBalancingCacheStats().has_value());
+}
+
+TEST_F(PreBalancingCacheRun, SweepMatchesUncached) {
+	for (const TaskData& base : { common, full }) {
+		const auto scenarios = sweep(base);
+
+		std::vector<SimulationResult> uncached;
+		for (const TaskData& td : scenarios) {
+			uncached.push_back(simulator.simulateScenario(td));
+		}
+
+		simulator.enablePreBalancingCache(64 << 20);
+		for (size_t i = 0; i < scenarios.size(); i++) {
+			expectSameResult(simulator.simulateScenario(scenarios[i]), uncached[i]);
+		}
+
+		// every scenario in the sweep shares the first scenario's snapshot
+		auto stats = simulator.getPreBalancingCacheStats().value();
+		EXPECT_EQ(stats.misses, 1);
+		EXPECT_EQ(stats.hits, scenarios.size() - 1);
+		EXPECT_EQ(stats.entries, 1);
+		EXPECT_GT(stats.bytes, 0);
+	}
+}
+
+TEST_F(PreBalancingCacheRun, BatchMatchesUncached) {
+	const auto scenarios = sweep(full);
+	auto uncached = simulator.simulateBatch(scenarios);
+
+	simulator.enablePreBalancingCache(64 << 20);
+	auto cached = simulator.simulateBatch(scenarios);
+
+	ASSERT_EQ(cached.size(), uncached.size());
+	for (size_t i = 0; i < cached.size(); i++) {
+		expectSameResult(cached[i], uncached[i]);
+	}
+	auto stats = simulator.getPreBalancingCacheStats().value();
+	EXPECT_EQ(stats.hits + stats.misses, scenarios.size());
+	EXPECT_EQ(stats.entries, 1);
+}
+
+TEST_F(PreBalancingCacheRun, DifferentBuildingMisses) {
+	simulator.enablePreBalancingCache(64 << 20);
+
+	TaskData insulated = common;
+	insulated.building->scalar_heat_load *= 0.5f;
+
+	auto uncached = Simulator(readSiteData(fs::path{ "./test_files/siteData_MountHotel.json" }), TaskConfig{}).simulateScenario(insulated);
+
+	simulator.simulateScenario(common);
+	auto cached = simulator.simulateScenario(insulated);
+	expectSameResult(cached, uncached);
+
+	auto stats = simulator.getPreBalancingCacheStats().value();
+	EXPECT_EQ(stats.misses, 2);
+	EXPECT_EQ(stats.hits, 0);
+	EXPECT_EQ(stats.entries, 2);
+}
+
+TEST_F(PreBalancingCacheRun, FullReportingBypassesCache) {
+	simulator.enablePreBalancingCache(64 << 20);
+	auto result = simulator.simulateScenario(full, SimulationType::FullReporting);
+	EXPECT_TRUE(result.report_data.has_value());
+
+	auto stats = simulator.getPreBalancingCacheStats().value();
+	EXPECT_EQ(stats.hits + stats.misses, 0);
+}
+
+TEST(PreBalancingKey, IgnoresBalancingComponents) {
+	TaskData full = readTaskData(fs::path{ "./test_files/taskData_full.json" });
+	TaskData other = full;
+	other.energy_storage_system->capacity *= 2;
+	other.mop->maximum_load *= 2;
+	other.data_centre->maximum_load *= 2;
+	// a balancing EV runs in the loop
+	other.electric_vehicles->scalar_electrical_load *= 2;
+
+	EXPECT_EQ(PreBalancingKey{ full }, PreBalancingKey{ other });
+	EXPECT_EQ(std::hash<PreBalancingKey>{}(PreBalancingKey{ full }), std::hash<PreBalancingKey>{}(PreBalancingKey{ other }));
+}
+
+TEST(PreBalancingKey, TariffOnlyMattersForTheCylinder) {
+	TaskData full = readTaskData(fs::path{ "./test_files/taskData_full.json" });
+	TaskData otherTariff = full;
+	otherTariff.grid->tariff_index = 1;
+	EXPECT_FALSE(PreBalancingKey{ full } == PreBalancingKey{ otherTariff });
+
+	full.domestic_hot_water.reset();
+	otherTariff.domestic_hot_water.reset();
+	EXPECT_EQ(PreBalancingKey{ full }, PreBalancingKey{ otherTariff });
+}
+
+TEST(PreBalancingKey, NonBalancingEVIsPartOfTheKey) {
+	TaskData full = readTaskData(fs::path{ "./test_files/taskData_full.json" });
+	full.electric_vehicles->flexible_load_ratio = 0.0f;
+	TaskData moreEVs = full;
+	moreEVs.electric_vehicles->scalar_electrical_load *= 2;
+	EXPECT_FALSE(PreBalancingKey{ full } == PreBalancingKey{ moreEVs });
+}
+
+TEST(PreBalancingKey, HashOfTheTaskDataMatchesTheKey) {
+	TaskData full = readTaskData(fs::path{ "./test_files/taskData_full.json" });
+	TaskData nonBalancingEV = full;
+	nonBalancingEV.electric_vehicles->flexible_load_ratio = 0.0f;
+	TaskData empty = readTaskData(fs::path{ "./test_files/taskData_empty.json" });
+
+	for (const TaskData& taskData : { full, nonBalancingEV, empty }) {
+		EXPECT_EQ(preBalancingHash(taskData), std::hash<PreBalancingKey>{}(PreBalancingKey{ taskData }));
+	}
+}
+
+TEST(PreBalancingCache, EvictsWhenOverBudget) {
+	SiteData siteData = readSiteData(fs::path{ "./test_files/siteData_MountHotel.json" });
+	TaskData td = readTaskData(fs::path{ "./test_files/taskData_common.json" });
+
+	auto snapshot = std::make_shared<const PreBalancingSnapshot>(PreBalancingSnapshot{ TempSum(siteData), SimulationTotals{} });
+	const size_t timeseriesBytes = 5 * siteData.timesteps * sizeof(float);
+
+	// room for at most two snapshots
+	PreBalancingCache cache(timeseriesBytes * 2 + timeseriesBytes / 2);
+
+	for (float scalar : { 1.0f, 2.0f, 3.0f }) {
+		td.building->scalar_heat_load = scalar;
+		cache.insert(PreBalancingKey{ td }, snapshot);
+	}
+
+	auto stats = cache.stats();
+	EXPECT_EQ(stats.entries, 2);
+	EXPECT_EQ(stats.evictions, 1);
+	EXPECT_LE(stats.bytes, stats.byte_budget);
+
+	// the first insertion was the least recently used
+	td.building->scalar_heat_load = 1.0f;
+	EXPECT_EQ(cache.lookup(PreBalancingKey{ td }), nullptr);
+	td.building->scalar_heat_load = 3.0f;
+	EXPECT_EQ(cache.lookup(PreBalancingKey{ td }), snapshot);
+
+	cache.clear();
+	EXPECT_EQ(cache.stats().entries, 0);
+	EXPECT_EQ(cache.stats().bytes, 0);
+}
@@ -69,19 +69,21 @@ TEST_F(BasicPVTest, Report) {
     pv.Report(report_data);
 
     // Check that PV generation is reported correctly
-    ASSERT_EQ(report_data.PVdcGen.size(), 24);
-    ASSERT_EQ(report_data.PVacGen.size(), 24);
+    ASSERT_EQ(report_data.get(ReportColumn::PVdcGen).size(), 24);
+    ASSERT_EQ(report_data.get(ReportColumn::PVacGen).size(), 24);
     for (int i = 0; i < 24; ++i) {
-        EXPECT_FLOAT_EQ(report_data.PVdcGen[i], 10.0f);
-        EXPECT_FLOAT_EQ(report_data.PVacGen[i], 10.0f);
+        EXPECT_FLOAT_EQ(report_data.get(ReportColumn::PVdcGen)[i], 10.0f);
+        EXPECT_FLOAT_EQ(report_data.get(ReportColumn::PVacGen)[i], 10.0f);
     }
 }
 
 TEST_F(BasicPVTest, ZeroGeneration) {
     // Set all solar yields to zero
-    for (size_t i = 0; i < siteData.solar_yields.size(); i++) {
-        siteData.solar_yields[i].setZero();
+    std::vector<SiteSeries> zeros;
+    for (const auto& yield : siteData.solar_yields) {
+        zeros.push_back(Eigen::VectorXf::Zero(yield.size()));
     }
+    siteData.solar_yields = zeros;
     
     BasicPV pv(siteData, panels);
     
@@ -117,3 +119,31 @@ TEST_F(BasicPVTest, NoScalars) {
 
     EXPECT_EQ(pvOutput.sum(), 0.0f);
 }
+
+TEST_F(BasicPVTest, YieldMatrix) {
+    const auto yields = siteData.solar_yields.matrix();
+    ASSERT_EQ(yields.rows(), 24);
+    ASSERT_EQ(yields.cols(), 4);
+    for (size_t i = 0; i < siteData.solar_yields.size(); i++) {
+        EXPECT_EQ(yields.col(static_cast<Eigen::Index>(i)), year_TS(siteData.solar_yields[i]));
+        // each column is padded so the yields stay aligned
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(siteData.solar_yields[i].data()) % EIGEN_MAX_ALIGN_BYTES, 0);
+    }
+
+    // a copy of the columns is used in place rather than packed again
+    SiteSeriesMatrix copy = siteData.solar_yields.columns();
+    EXPECT_EQ(copy.matrix().data(), yields.data());
+}
+
+TEST_F(BasicPVTest, PanelsSharingAYield) {
+    // two arrays on the same yield (such as panels on the same roof) combine their scalars
+    panels = { panels[1], panels[1], panels[3] };
+    panels[0].yield_scalar = 2.0f;
+
+    BasicPV pv(siteData, panels);
+    pv.AllCalcs(tempsum);
+    auto pvOutput = pv.get_PV_AC_out();
+    for (int i = 0; i < 24; ++i) {
+        EXPECT_FLOAT_EQ(pvOutput[i], 10.0f); // 2*2 + 1*2 + 1*4 = 10
+    }
+}
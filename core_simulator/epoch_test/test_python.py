@@ -1,3 +1,15 @@
+import asyncio
+import concurrent.futures
+import copy
+import gc
+import json
+import pathlib
+import pickle
+import struct
+
+import numpy as np
+import pytest
+
 import epoch_simulator as es
 
 class TestTaskData:
@@ -18,3 +30,575 @@ class TestTaskData:
         td2.building.scalar_heat_load = 2.0
         assert td1 != td2
         assert hash(td1) != hash(td2)
+
+    def test_scenario_key(self) -> None:
+        # the same in every process, so it can be compared against a fixed value
+        assert es.TaskData().scenario_key() == "7a36f2c9c1360eb6329498723efab97b"
+        assert len(es.TaskData().canonical_bytes()) == 18
+
+        td1 = es.TaskData()
+        td1.building = es.Building()
+        td2 = es.TaskData()
+        td2.building = es.Building()
+        td2.building.scalar_heat_load = 1.0001
+        assert td1.scenario_key() != td2.scenario_key()
+        assert td1.scenario_key(mantissa_bits=10) == td2.scenario_key(mantissa_bits=10)
+
+    def test_records_round_trip(self) -> None:
+        task = es.TaskData()
+        task.building = es.Building()
+        task.solar_panels = [es.SolarPanel(), es.SolarPanel()]
+        assert len(task.solar_panels) == 2
+        assert es.TaskData.from_record(task.to_record()) == task
+        assert es.decode_task_batch(es.encode_task_batch([task, es.TaskData()])) == [task, es.TaskData()]
+
+        task.solar_panels = [es.SolarPanel()] * 5
+        with pytest.raises(ValueError):
+            task.to_record()
+        with pytest.raises(ValueError):
+            es.TaskData.from_record(b"too short")
+
+
+class TestReportData:
+    @staticmethod
+    def full_reporting_simulator() -> tuple[es.Simulator, es.TaskData]:
+        test_files = pathlib.Path(__file__).parent / "test_files"
+        config = json.dumps({
+            "use_boiler_upgrade_scheme": False,
+            "general_grant_funding": 0.0,
+            "npv_time_horizon": 10,
+            "npv_discount_factor": 0.0,
+        })
+        sim = es.Simulator.from_json((test_files / "siteData_MountHotel.json").read_text(), config)
+        task = es.TaskData.from_json((test_files / "taskData_full.json").read_text())
+        return sim, task
+
+    @classmethod
+    def full_reporting_result(cls) -> es.SimulationResult:
+        sim, task = cls.full_reporting_simulator()
+        return sim.simulate_scenario(task, fullReporting=True)
+
+    def test_fields_are_read_only_views(self) -> None:
+        report_data = self.full_reporting_result().report_data
+        assert report_data is not None
+
+        first = report_data.Grid_Import
+        second = report_data.Grid_Import
+        assert np.shares_memory(first, second)
+        assert not first.flags.writeable
+
+    def test_views_keep_the_result_alive(self) -> None:
+        grid_import = self.full_reporting_result().report_data.Grid_Import
+        gc.collect()
+        assert grid_import.sum() > 0
+
+    def test_to_array(self) -> None:
+        report_data = self.full_reporting_result().report_data
+        values, columns = report_data.to_array()
+
+        assert values.shape == (len(report_data.Grid_Import), len(columns))
+        # each column is contiguous and the array borrows the ReportData's storage
+        assert values.strides[0] == values.itemsize
+        assert not values.flags.writeable
+        assert np.shares_memory(values, report_data.Grid_Import)
+        assert "Grid_Import" in columns
+        np.testing.assert_array_equal(values[:, columns.index("Grid_Import")], report_data.Grid_Import)
+
+    def test_timestamps(self) -> None:
+        sim, task = self.full_reporting_simulator()
+        timestamps = sim.timestamps
+        report_data = sim.simulate_scenario(task, fullReporting=True).report_data
+
+        assert timestamps.dtype == np.int64
+        assert not timestamps.flags.writeable
+        assert len(timestamps) == len(report_data.Grid_Import)
+        assert np.all(np.diff(timestamps) == 30 * 60 * 1_000_000_000)
+        # made once and shared
+        assert np.shares_memory(timestamps, sim.timestamps)
+
+    def test_arrow_export(self) -> None:
+        pa = pytest.importorskip("pyarrow")
+        sim, task = self.full_reporting_simulator()
+        report_data = sim.simulate_scenario(task, fullReporting=True).report_data
+        _, columns = report_data.to_array()
+
+        batch = pa.record_batch(report_data)
+        assert batch.schema.names == columns
+        assert np.shares_memory(batch.column("Grid_Import").to_numpy(), report_data.Grid_Import)
+
+        frame = pa.table(sim.report_frame(report_data))
+        assert frame.schema.names == ["timestamp", *columns]
+        assert frame.schema.field("timestamp").type == pa.timestamp("ns", tz="UTC")
+        np.testing.assert_array_equal(frame.column("timestamp").cast(pa.int64()).to_numpy(), sim.timestamps)
+        np.testing.assert_array_equal(frame.column("Grid_Import").to_numpy(), report_data.Grid_Import)
+
+    def test_baseline_is_shared(self) -> None:
+        sim, task = self.full_reporting_simulator()
+        first = sim.simulate_scenario(task, fullReporting=True).baseline_report_data
+        second = sim.simulate_scenario(task, fullReporting=True).baseline_report_data
+
+        assert first is not None and second is not None
+        assert np.shares_memory(first.Grid_Import, second.Grid_Import)
+
+    def test_low_latency_matches(self) -> None:
+        sim, task = self.full_reporting_simulator()
+        expected = sim.simulate_scenario(task, fullReporting=True)
+
+        sim.enable_low_latency()
+        result = sim.simulate_scenario(task, fullReporting=True)
+        sim.disable_low_latency()
+
+        expected_values, expected_columns = expected.report_data.to_array()
+        values, columns = result.report_data.to_array()
+        assert columns == expected_columns
+        np.testing.assert_array_equal(values, expected_values)
+        assert result.metrics.total_annualised_cost == expected.metrics.total_annualised_cost
+
+
+class TestPortfolioSimulator:
+    def test_matches_aggregate_site_results(self) -> None:
+        sim, task = TestReportData.full_reporting_simulator()
+        portfolio_sim = es.PortfolioSimulator({"hotel": sim, "annex": sim.with_config(sim.config)})
+
+        result = portfolio_sim.simulate_portfolio({"hotel": task, "annex": task})
+        expected = es.aggregate_site_results([sim.simulate_scenario(task), sim.simulate_scenario(task)])
+
+        assert set(result.sites) == {"hotel", "annex"}
+        assert result.portfolio.metrics.total_annualised_cost == expected.metrics.total_annualised_cost
+
+        batch = portfolio_sim.simulate_portfolios([{"hotel": task}, {"hotel": task, "annex": task}])
+        assert len(batch) == 2
+        assert batch[1].portfolio.metrics.total_capex == result.portfolio.metrics.total_capex
+
+    def test_portfolio_columns(self) -> None:
+        sim, task = TestReportData.full_reporting_simulator()
+        portfolio_sim = es.PortfolioSimulator({"hotel": sim, "annex": sim.with_config(sim.config)})
+
+        result = portfolio_sim.simulate_portfolio({"hotel": task, "annex": task}, columns=["Grid_Import"])
+        site = sim.simulate_scenario(task, columns=["Grid_Import"])
+
+        assert result.sites["hotel"].report_data is None
+        np.testing.assert_allclose(result.portfolio.report_data.Grid_Import, 2 * site.report_data.Grid_Import, rtol=1e-6)
+
+    def test_aggregate_portfolios(self) -> None:
+        sim, task = TestReportData.full_reporting_simulator()
+        hotel = sim.simulate_batch([task, task])
+        annex = sim.simulate_batch([task])
+
+        combinations = np.array([[0, 0], [1, 0]], dtype=np.int64)
+        portfolios = es.aggregate_portfolios([hotel, annex], combinations)
+        expected = es.aggregate_site_results([hotel[1], annex[0]])
+
+        assert len(portfolios) == 2
+        assert portfolios[1].metrics.total_annualised_cost == expected.metrics.total_annualised_cost
+        assert portfolios[1].report_data is None
+
+        with pytest.raises(IndexError):
+            es.aggregate_portfolios([hotel, annex], np.array([[0, 1]], dtype=np.int64))
+
+    def test_from_json(self) -> None:
+        test_files = pathlib.Path(__file__).parent / "test_files"
+        site_json = (test_files / "siteData_MountHotel.json").read_text()
+        config = json.dumps({
+            "use_boiler_upgrade_scheme": False,
+            "general_grant_funding": 0.0,
+            "npv_time_horizon": 10,
+            "npv_discount_factor": 0.0,
+        })
+        portfolio_sim = es.PortfolioSimulator.from_json({"hotel": (site_json, config), "annex": (site_json, config)})
+
+        assert portfolio_sim.site_names == ["annex", "hotel"]
+        assert set(portfolio_sim.build_timings) == {"annex", "hotel"}
+        assert all(timing.construct > 0 for timing in portfolio_sim.build_timings.values())
+
+
+class TestScenarioCodec:
+    def test_simulate_chromosomes(self) -> None:
+        sim, task = TestReportData.full_reporting_simulator()
+        codec = es.ScenarioCodec(json.dumps({
+            "grid": {"COMPONENT_IS_MANDATORY": True, "grid_import": [60.0, 120.0], "grid_export": [60.0]},
+            "building": {"COMPONENT_IS_MANDATORY": True, "scalar_heat_load": [1.0], "incumbent": True},
+            "energy_storage_system": {"COMPONENT_IS_MANDATORY": False, "capacity": [100.0, 200.0]},
+        }))
+        assert codec.gene_sizes == [2, 2, 2]
+
+        chromosomes = np.array([[0, 0, 0], [1, 1, 1]], dtype=np.float64)
+        decoded = codec.decode(chromosomes)
+        assert decoded[0].energy_storage_system is None
+        assert decoded[1].energy_storage_system.capacity == 200.0
+
+        results = sim.simulate_chromosomes(codec, chromosomes)
+        expected = sim.simulate_batch(decoded)
+        assert [r.metrics.total_annualised_cost for r in results] == [r.metrics.total_annualised_cost for r in expected]
+
+
+class TestUpgradeTree:
+    def test_simulate_upgrade_tree(self) -> None:
+        sim, end = TestReportData.full_reporting_simulator()
+        start = es.TaskData.from_json(end.to_json())
+        start.energy_storage_system = None
+        start.heat_pump = None
+
+        nodes = sim.simulate_upgrade_tree(start, end)
+        assert sorted(nodes) == ["00", "01", "10", "11"]
+        assert nodes["11"].metrics.total_capex == sim.simulate_scenario(end).metrics.total_capex
+        assert nodes["00"].metrics.total_capex == sim.simulate_scenario(start).metrics.total_capex
+
+        only_ess = sim.simulate_upgrade_tree(start, end, components=["energy_storage_system"])
+        assert sorted(only_ess) == ["0", "1"]
+
+
+class TestResultsToArray:
+    def test_results_to_array(self) -> None:
+        sim, task = TestReportData.full_reporting_simulator()
+        results = sim.simulate_batch([task, task])
+
+        table = es.results_to_array(results)
+        assert table.shape == (2, len(es.RESULT_COLUMNS))
+        assert len(es.RESULT_DIRECTIONS) == len(es.RESULT_COLUMNS)
+
+        capex = es.RESULT_COLUMNS.index("capex")
+        assert table[0, capex] == np.float32(results[0].metrics.total_capex)
+
+        minimised = es.results_to_array(results, apply_directions=True)
+        np.testing.assert_array_equal(minimised, table * np.array(es.RESULT_DIRECTIONS))
+
+
+class TestPareto:
+    def test_non_dominated_sort(self) -> None:
+        costs = np.array([[1.0, 4.0], [2.0, 2.0], [3.0, 3.0], [4.0, 1.0], [5.0, 5.0]])
+        assert es.non_dominated_sort(costs) == [[0, 1, 3], [2], [4]]
+
+        distance = es.crowding_distance(costs, [0, 1, 3])
+        assert np.isinf(distance[0]) and np.isinf(distance[2])
+
+    def test_archive(self) -> None:
+        archive = es.ParetoArchive(2)
+        assert archive.insert(np.array([[2.0, 2.0], [3.0, 3.0], [1.0, 1.0]]), 0) == [True, False, True]
+        assert archive.ids == [2]
+        np.testing.assert_array_equal(archive.costs, [[1.0, 1.0]])
+        assert archive.excludes(np.array([1.0, 2.0]))
+        assert not archive.excludes(np.array([0.5, 2.0]))
+
+
+class TestScenarioConstraints:
+    def test_capex_constraints(self) -> None:
+        sim, task = TestReportData.full_reporting_simulator()
+        capex = sim.simulate_scenario(task).metrics.total_capex
+
+        within, violating = sim.simulate_batch(
+            [task, task], constraints=es.ScenarioConstraints(max_capex=capex + 1.0)
+        ), sim.simulate_scenario(task, constraints=es.ScenarioConstraints(max_capex=capex - 1.0))
+        assert not any(result.violates_constraints for result in within)
+        assert violating.violates_constraints
+        assert violating.metrics.total_capex == capex
+
+    def test_shortfall_constraints(self) -> None:
+        sim, task = TestReportData.full_reporting_simulator()
+        task.grid.grid_import = 1.0
+        shortfall = sim.simulate_scenario(task).metrics.total_electrical_shortfall
+        assert shortfall > 0.0
+
+        stopped = sim.simulate_scenario(task, constraints=es.ScenarioConstraints(max_electrical_shortfall=shortfall / 2))
+        assert stopped.violates_constraints and stopped.terminated_early
+        assert stopped.metrics.total_electrical_shortfall > shortfall / 2
+
+        within = sim.simulate_scenario(task, constraints=es.ScenarioConstraints(max_electrical_shortfall=shortfall * 2))
+        assert not within.terminated_early
+        assert within.metrics.total_electrical_shortfall == shortfall
+
+    def test_bound_objectives(self) -> None:
+        sim, task = TestReportData.full_reporting_simulator()
+        expected = sim.simulate_scenario(task)
+
+        bounds = sim.bound_objectives([task, task])
+        assert len(bounds) == 2 and not bounds[0].invalid
+        assert bounds[0].total_capex == expected.metrics.total_capex
+        assert bounds[0].cost_balance >= expected.comparison.cost_balance
+        assert bounds[0].combined_carbon_balance >= expected.comparison.combined_carbon_balance
+        assert bounds[1].cost_balance == bounds[0].cost_balance
+
+    def test_days_of_interest(self) -> None:
+        sim, task = TestReportData.full_reporting_simulator()
+        interest = sim.days_of_interest(task)
+
+        assert set(interest.days) == set(interest.categories)
+        assert interest.daily.shape == (len(interest.categories), len(interest.day_starts) - 1)
+        for row, category in enumerate(interest.categories):
+            day = interest.days[category]
+            if day is not None:
+                assert interest.daily[row, day] == interest.daily[row].max()
+
+    def test_simulate_configs(self) -> None:
+        sim, task = TestReportData.full_reporting_simulator()
+        funded = es.Config()
+        funded.general_grant_funding = 10000.0
+        discounted = es.Config()
+        discounted.npv_discount_factor = 0.05
+
+        results = sim.simulate_configs(task, [funded, discounted])
+        assert len(results) == 2
+        for config, result in zip([funded, discounted], results):
+            expected = sim.with_config(config).simulate_scenario(task)
+            assert result.metrics.total_capex == expected.metrics.total_capex
+            assert result.comparison.cost_balance == expected.comparison.cost_balance
+
+    def test_sweep_ess(self) -> None:
+        sim, task = TestReportData.full_reporting_simulator()
+        sizes = np.array([[10.0, 5.0, 5.0], [40.0, 20.0, 15.0], [80.0, 40.0, 40.0]], dtype=np.float32)
+
+        table = sim.sweep_ess(task, sizes)
+        assert table.shape == (3, len(es.RESULT_COLUMNS))
+
+        task.energy_storage_system.capacity = 40.0
+        task.energy_storage_system.charge_power = 20.0
+        task.energy_storage_system.discharge_power = 15.0
+        np.testing.assert_array_equal(table[1], es.results_to_array([sim.simulate_scenario(task)])[0])
+
+
+class TestAsync:
+    def test_simulate_scenario_async(self) -> None:
+        sim, task = TestReportData.full_reporting_simulator()
+        expected = sim.simulate_scenario(task)
+
+        async def simulate():
+            single, batch = await asyncio.gather(
+                sim.simulate_scenario_async(task),
+                sim.simulate_batch_async([task, task], control=es.BatchControl()),
+            )
+            return single, batch
+
+        single, batch = asyncio.run(simulate())
+        assert single.metrics.total_annualised_cost == expected.metrics.total_annualised_cost
+        assert [r.metrics.total_annualised_cost for r in batch] == [expected.metrics.total_annualised_cost] * 2
+
+    def test_async_errors(self) -> None:
+        sim, task = TestReportData.full_reporting_simulator()
+
+        # an unknown column is raised straight away, and there must be a running event loop
+        async def unknown_column():
+            return await sim.simulate_scenario_async(task, columns=["not_a_column"])
+
+        with pytest.raises(RuntimeError, match="not a ReportData column"):
+            asyncio.run(unknown_column())
+        with pytest.raises(RuntimeError, match="no running event loop"):
+            sim.simulate_scenario_async(task)
+
+
+class TestThreads:
+    def test_shared_simulator(self) -> None:
+        sim, task = TestReportData.full_reporting_simulator()
+        expected = sim.simulate_scenario(task, fullReporting=True)
+        timesteps = len(expected.report_data.Grid_Import)
+
+        def simulate(_: int) -> float:
+            return sim.simulate_scenario(task).metrics.total_annualised_cost
+
+        def configure(i: int) -> None:
+            # changing the Simulator in place waits for the simulations using it
+            if i % 2:
+                sim.enable_result_cache(1 << 20)
+            else:
+                sim.enable_parallel_ess()
+
+        def add_tariff(i: int) -> int:
+            return sim.add_import_tariff(np.full(timesteps, float(i), dtype=np.float32))
+
+        with concurrent.futures.ThreadPoolExecutor(max_workers=8) as pool:
+            costs = list(pool.map(simulate, range(16)))
+            list(pool.map(configure, range(4)))
+            indices = sorted(pool.map(add_tariff, range(4)))
+
+        assert costs == [expected.metrics.total_annualised_cost] * 16
+        # no update is lost to another made at the same time
+        assert indices == list(range(indices[0], indices[0] + 4))
+        assert sim.simulate_scenario(task).metrics.total_annualised_cost == expected.metrics.total_annualised_cost
+
+    def test_shared_archive(self) -> None:
+        archive = es.ParetoArchive(2)
+
+        def insert(i: int) -> None:
+            archive.insert(np.array([[float(i), float(100 - i)]]), i)
+
+        with concurrent.futures.ThreadPoolExecutor(max_workers=8) as pool:
+            list(pool.map(insert, range(100)))
+        assert len(archive) == 100
+        assert sorted(archive.ids) == list(range(100))
+
+
+class TestRepresentativeDays:
+    def test_simulate_representative_days(self) -> None:
+        sim, task = TestReportData.full_reporting_simulator()
+        sim.enable_representative_days(20)
+        assert 1 < len(sim.representative_days.days) <= 20
+
+        [screened] = sim.simulate_representative_days([task])
+        assert screened.metrics.total_capex == sim.simulate_scenario(task).metrics.total_capex
+
+        errors = {error.metric: error for error in sim.representative_days_error([task])}
+        assert set(errors) == set(es.RESULT_COLUMNS)
+        assert errors["capex"].max_absolute_error == 0.0
+
+
+class TestResolution:
+    def test_at_resolution(self) -> None:
+        sim, task = TestReportData.full_reporting_simulator()
+        hourly = sim.at_resolution(3600)
+        assert hourly.site_data_bytes < sim.site_data_bytes
+
+        result = hourly.simulate_scenario(task)
+        assert result.metrics.total_capex == sim.simulate_scenario(task).metrics.total_capex
+
+
+class TestSiteUpdate:
+    def test_add_and_replace_columns(self) -> None:
+        sim, task = TestReportData.full_reporting_simulator()
+        before = sim.simulate_scenario(task, fullReporting=True)
+        timesteps = len(before.report_data.Grid_Import)
+        assert sim.has_baseline
+
+        index = sim.add_import_tariff(np.full(timesteps, 10.0, dtype=np.float32))
+        # the baseline doesn't use the new tariff
+        assert sim.has_baseline
+        on_new_tariff = es.TaskData.from_json(task.to_json())
+        on_new_tariff.grid.tariff_index = index
+        assert sim.is_valid(on_new_tariff)
+        result = sim.simulate_scenario(on_new_tariff)
+        assert result.metrics.total_electricity_import_cost > before.metrics.total_electricity_import_cost
+
+        sim.replace_columns({"grid_co2": np.zeros(timesteps, dtype=np.float32)})
+        assert not sim.has_baseline
+        assert sim.simulate_scenario(task).metrics.total_scope_2_emissions == 0.0
+
+        with pytest.raises(ValueError):
+            sim.replace_columns({"wind_speed": np.zeros(timesteps, dtype=np.float32)})
+        with pytest.raises(RuntimeError):
+            sim.add_solar_yield(np.zeros(3, dtype=np.float32))
+
+
+class TestBatchBackend:
+    def test_cpu_backend_matches_the_batch(self) -> None:
+        sim, task = TestReportData.full_reporting_simulator()
+        tasks = []
+        for i in range(20):
+            scenario = es.TaskData.from_json(task.to_json())
+            scenario.energy_storage_system.capacity += i
+            tasks.append(scenario)
+        expected = sim.simulate_batch(tasks)
+
+        assert sim.batch_backend is None
+        sim.enable_batch_backend("cpu")
+        assert sim.batch_backend == "cpu"
+        results = sim.simulate_batch(tasks)
+        assert [r.metrics.total_annualised_cost for r in results] == [r.metrics.total_annualised_cost for r in expected]
+        sim.disable_batch_backend()
+        assert sim.batch_backend is None
+
+        with pytest.raises(ValueError):
+            sim.enable_batch_backend("tpu")
+        if not es.cuda_supported():
+            with pytest.raises(RuntimeError, match="without CUDA support"):
+                sim.enable_batch_backend("cuda")
+
+
+class TestValidation:
+    def test_check_scenarios(self) -> None:
+        sim, task = TestReportData.full_reporting_simulator()
+        invalid = es.TaskData.from_json(task.to_json())
+        invalid.grid.tariff_index = 99
+
+        assert sim.is_valid(task)
+        assert not sim.is_valid(invalid)
+        assert sim.check_scenarios([task, invalid]) == [0, es.ScenarioError.TariffIndex]
+
+
+class TestBaselineCache:
+    def test_baseline_is_cached(self, tmp_path: pathlib.Path) -> None:
+        sim, task = TestReportData.full_reporting_simulator()
+        sim.enable_baseline_cache(tmp_path)
+        assert sim.is_valid(task)
+        assert not sim.has_baseline
+
+        expected = sim.simulate_scenario(task)
+        assert sim.has_baseline
+        assert len(list(tmp_path.glob("*.baseline"))) == 1
+
+        cached, _ = TestReportData.full_reporting_simulator()
+        cached.enable_baseline_cache(tmp_path)
+        result = cached.simulate_scenario(task)
+        assert result.baseline_metrics.total_annualised_cost == expected.baseline_metrics.total_annualised_cost
+        assert result.comparison.cost_balance == expected.comparison.cost_balance
+
+
+class TestMemoryFootprint:
+    def test_memory_footprint(self) -> None:
+        sim, task = TestReportData.full_reporting_simulator()
+        parts = sim.memory_footprint()
+        assert parts["site_data.building_eload"] > 0
+        assert sum(v for k, v in parts.items() if k.startswith("site_data.")) == sim.site_data_bytes
+
+        result = sim.simulate_scenario(task, fullReporting=True)
+        assert result.memory_footprint(include_report_data=False) < result.memory_footprint()
+
+
+class TestWorkerProtocol:
+    def test_requests_are_framed(self) -> None:
+        sim, task = TestReportData.full_reporting_simulator()
+        for frame in (es.encode_worker_load(0, "hotel", sim.snapshot()),
+                      es.encode_worker_tasks(1, "hotel", [task, task], fullReporting=True, encoding="delta")):
+            (length,) = struct.unpack("<I", frame[:4])
+            assert length == len(frame) - 4
+
+        frame = es.encode_worker_task_records(3, "hotel", [task, task])
+        (length,) = struct.unpack("<I", frame[:4])
+        assert length == len(frame) - 4
+
+        # a request is not a reply
+        with pytest.raises(RuntimeError):
+            es.decode_worker_response(es.encode_worker_tasks(2, "hotel", [task])[4:])
+
+
+class TestSnapshot:
+    def test_pickle_round_trip(self) -> None:
+        sim, task = TestReportData.full_reporting_simulator()
+        restored = pickle.loads(pickle.dumps(sim))
+
+        expected = sim.simulate_scenario(task, fullReporting=True)
+        result = restored.simulate_scenario(task, fullReporting=True)
+        assert result.metrics.total_annualised_cost == expected.metrics.total_annualised_cost
+        assert result.comparison.cost_balance == expected.comparison.cost_balance
+        np.testing.assert_array_equal(result.baseline_report_data.Grid_Import, expected.baseline_report_data.Grid_Import)
+
+        assert es.Simulator.from_snapshot(sim.snapshot()).simulate_scenario(task).metrics.total_capex == expected.metrics.total_capex
+
+    def test_result_bytes_round_trip(self) -> None:
+        sim, task = TestReportData.full_reporting_simulator()
+        result = sim.simulate_scenario(task, fullReporting=True)
+
+        exact = es.SimulationResult.from_bytes(result.to_bytes("delta", include_baseline=True))
+        assert exact.metrics.total_annualised_cost == result.metrics.total_annualised_cost
+        np.testing.assert_array_equal(exact.report_data.Grid_Import, result.report_data.Grid_Import)
+        np.testing.assert_array_equal(exact.baseline_report_data.Grid_Import, result.baseline_report_data.Grid_Import)
+
+        half = es.SimulationResult.from_bytes(result.to_bytes("float16"))
+        assert half.baseline_report_data is None
+        np.testing.assert_allclose(half.report_data.Grid_Import, result.report_data.Grid_Import, rtol=1e-3, atol=1e-6)
+
+    def test_trace(self) -> None:
+        sim, task = TestReportData.full_reporting_simulator()
+        es.start_trace()
+        sim.simulate_scenario(task)
+        es.stop_trace()
+
+        names = {event["name"] for event in json.loads(es.trace_json())["traceEvents"]}
+        assert {"simulateScenario", "balancing_loop", "costs"} <= names
+
+    def test_portfolio_deepcopy(self) -> None:
+        sim, task = TestReportData.full_reporting_simulator()
+        portfolio_sim = es.PortfolioSimulator({"hotel": sim})
+        copied = copy.deepcopy(portfolio_sim)
+
+        assert copied.site_names == ["hotel"]
+        result = copied.simulate_portfolio({"hotel": task})
+        assert result.portfolio.metrics.total_annualised_cost == portfolio_sim.simulate_portfolio({"hotel": task}).portfolio.metrics.total_annualised_cost
+        assert pickle.loads(pickle.dumps(portfolio_sim)).site_names == ["hotel"]
@@ -0,0 +1,181 @@
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include <Eigen/Core>
+#include <gtest/gtest.h>
+
+#include "../epoch_lib/Definitions.hpp"
+#include "../epoch_lib/Simulation/Simulate.hpp"
+#include "../epoch_lib/io/FileHandling.hpp"
+
+namespace fs = std::filesystem;
+
+TEST(ReportData, EmptyByDefault) {
+	ReportData report;
+	EXPECT_EQ(report.timesteps(), 0);
+	EXPECT_EQ(report.numPopulated(), 0);
+	EXPECT_EQ(report.presentMask(), 0);
+	EXPECT_EQ(report.get(ReportColumn::Grid_Import).size(), 0);
+	EXPECT_THROW(report.column(ReportColumn::Grid_Import), std::runtime_error);
+}
+
+TEST(ReportData, SetAndGetColumns) {
+	ReportData report;
+	report.set(ReportColumn::Grid_Import, Eigen::VectorXf::Constant(5, 2.0f));
+	report.set(ReportColumn::Hotel_load, Eigen::VectorXf::LinSpaced(5, 0.0f, 4.0f));
+
+	EXPECT_EQ(report.timesteps(), 5);
+	EXPECT_EQ(report.numPopulated(), 2);
+	EXPECT_TRUE(report.has(ReportColumn::Grid_Import));
+	EXPECT_TRUE(report.has(ReportColumn::Hotel_load));
+	EXPECT_FALSE(report.has(ReportColumn::Grid_Export));
+	EXPECT_EQ(report.presentMask(),
+		(uint64_t{ 1 } << static_cast<size_t>(ReportColumn::Grid_Import)) | (uint64_t{ 1 } << static_cast<size_t>(ReportColumn::Hotel_load)));
+
+	EXPECT_EQ(report.get(ReportColumn::Grid_Import).sum(), 10.0f);
+	EXPECT_EQ(report.get(ReportColumn::Hotel_load)[4], 4.0f);
+	EXPECT_EQ(report.get(ReportColumn::Grid_Export).size(), 0);
+
+	// every column has the same length
+	EXPECT_THROW(report.set(ReportColumn::Grid_Export, Eigen::VectorXf::Zero(6)), std::runtime_error);
+}
+
+TEST(ReportData, ColumnsAreAligned) {
+	ReportData report;
+	// deliberately not a multiple of the row alignment
+	report.set(ReportColumn::ESS_charge, Eigen::VectorXf::Ones(37));
+	report.set(ReportColumn::ESS_discharge, Eigen::VectorXf::Ones(37));
+	report.shrinkToPopulated();
+
+	const auto first = reinterpret_cast<uintptr_t>(report.get(ReportColumn::ESS_charge).data());
+	const auto second = reinterpret_cast<uintptr_t>(report.get(ReportColumn::ESS_discharge).data());
+	EXPECT_EQ((second - first) % 64, 0);
+	EXPECT_EQ(first % EIGEN_MAX_ALIGN_BYTES, 0);
+}
+
+TEST(ReportData, ShrinkKeepsValuesInColumnOrder) {
+	ReportData report;
+	// written out of order
+	report.set(ReportColumn::Grid_Export, Eigen::VectorXf::Constant(3, 3.0f));
+	report.set(ReportColumn::Actual_import_shortfall, Eigen::VectorXf::Constant(3, 1.0f));
+	report.set(ReportColumn::PVacGen, Eigen::VectorXf::Constant(3, 2.0f));
+	report.shrinkToPopulated();
+
+	auto columns = report.populatedColumns();
+	ASSERT_EQ(columns.size(), 3);
+	EXPECT_EQ(columns[0], ReportColumn::Actual_import_shortfall);
+	EXPECT_EQ(columns[1], ReportColumn::PVacGen);
+	EXPECT_EQ(columns[2], ReportColumn::Grid_Export);
+
+	auto populated = report.populated();
+	EXPECT_EQ(populated.rows(), 3);
+	EXPECT_EQ(populated.cols(), 3);
+	EXPECT_EQ(populated(0, 0), 1.0f);
+	EXPECT_EQ(populated(1, 1), 2.0f);
+	EXPECT_EQ(populated(2, 2), 3.0f);
+
+	// and a column can still be added afterwards
+	report.set(ReportColumn::MOP_load, Eigen::VectorXf::Constant(3, 4.0f));
+	EXPECT_EQ(report.get(ReportColumn::MOP_load).sum(), 12.0f);
+	EXPECT_EQ(report.get(ReportColumn::Grid_Export).sum(), 9.0f);
+}
+
+TEST(ReportData, CopiesAreIndependent) {
+	ReportData report;
+	report.set(ReportColumn::Heat_shortfall, Eigen::VectorXf::Zero(4));
+
+	ReportData copy = report;
+	report.column(ReportColumn::Heat_shortfall)[0] = 1.0f;
+
+	EXPECT_EQ(copy.get(ReportColumn::Heat_shortfall)[0], 0.0f);
+	EXPECT_EQ(report.get(ReportColumn::Heat_shortfall)[0], 1.0f);
+}
+
+TEST(ReportData, OnlyWritesRequestedColumns) {
+	ReportData report{ ReportColumnMask{ ReportColumn::Grid_Import, ReportColumn::Grid_Export } };
+	EXPECT_TRUE(report.wants(ReportColumn::Grid_Import));
+	EXPECT_FALSE(report.wants(ReportColumn::Hotel_load));
+
+	// an unrequested column is ignored, whatever its length
+	report.set(ReportColumn::Hotel_load, Eigen::VectorXf::Zero(0));
+	EXPECT_EQ(report.timesteps(), 0);
+
+	report.reserve(4);
+	report.set(ReportColumn::Grid_Import, Eigen::VectorXf::Constant(4, 1.0f));
+	report.set(ReportColumn::Hotel_load, Eigen::VectorXf::Constant(4, 2.0f));
+	report.column(ReportColumn::Grid_Export).setConstant(3.0f);
+	EXPECT_THROW(report.column(ReportColumn::PVacGen), std::runtime_error);
+
+	EXPECT_EQ(report.numPopulated(), 2);
+	EXPECT_FALSE(report.has(ReportColumn::Hotel_load));
+	EXPECT_EQ(report.get(ReportColumn::Grid_Export).sum(), 12.0f);
+	EXPECT_EQ(report.requested(), ReportColumnMask({ ReportColumn::Grid_Export, ReportColumn::Grid_Import }));
+}
+
+TEST(ReportData, ColumnMaskFromNames) {
+	const ReportColumnMask mask = ReportColumnMask::fromNames({ "Grid_Import", "ESS_RTL" });
+	EXPECT_EQ(mask, ReportColumnMask({ ReportColumn::Grid_Import, ReportColumn::ESS_RTL }));
+	EXPECT_EQ(mask.count(), 2u);
+	EXPECT_EQ(ReportColumnMask::all().count(), NUM_REPORT_COLUMNS);
+	EXPECT_EQ(ReportColumnMask::fromNames({}), ReportColumnMask{});
+	EXPECT_THROW(ReportColumnMask::fromNames({ "Grid_Import", "not_a_column" }), std::runtime_error);
+}
+
+TEST(ReportData, SimulatesOnlyRequestedColumns) {
+	const Simulator simulator(readSiteData(fs::path{ "./test_files/siteData_MountHotel.json" }), TaskConfig{});
+	const TaskData taskData = readTaskData(fs::path{ "./test_files/taskData_full.json" });
+
+	const ReportColumnMask columns{
+		ReportColumn::Grid_Import, ReportColumn::ESS_resulting_SoC, ReportColumn::DHW_ave_temperature, ReportColumn::Hotel_load
+	};
+	const SimulationResult full = simulator.simulateScenario(taskData, SimulationType::FullReporting);
+	const SimulationResult selected = simulator.simulateScenario(taskData, columns);
+
+	// the result doesn't depend on what is reported
+	EXPECT_EQ(selected.metrics.total_annualised_cost, full.metrics.total_annualised_cost);
+	EXPECT_EQ(selected.comparison.cost_balance, full.comparison.cost_balance);
+
+	ASSERT_TRUE(selected.report_data.has_value());
+	EXPECT_EQ(selected.report_data->numPopulated(), 4);
+	for (size_t i = 0; i < NUM_REPORT_COLUMNS; i++) {
+		const ReportColumn column = static_cast<ReportColumn>(i);
+		SCOPED_TRACE(REPORT_COLUMN_NAMES[i]);
+		if (columns.has(column)) {
+			ASSERT_TRUE(selected.report_data->has(column));
+			EXPECT_EQ(selected.report_data->get(column), full.report_data->get(column));
+		}
+		else {
+			EXPECT_FALSE(selected.report_data->has(column));
+		}
+	}
+
+	// the baseline is restricted to the requested columns that it reports
+	ASSERT_TRUE(selected.baseline_report_data);
+	EXPECT_TRUE(selected.baseline_report_data->has(ReportColumn::Grid_Import));
+	EXPECT_EQ(selected.baseline_report_data->presentMask() & ~columns.bits(), 0u);
+	EXPECT_EQ(selected.baseline_report_data->get(ReportColumn::Grid_Import), full.baseline_report_data->get(ReportColumn::Grid_Import));
+	EXPECT_EQ(simulator.simulateScenario(taskData, ReportColumnMask::all()).baseline_report_data, full.baseline_report_data);
+}
+
+TEST(ReportData, CSVHasAHeaderForEveryValue) {
+	ReportData report;
+	report.set(ReportColumn::Actual_import_shortfall, Eigen::VectorXf::Constant(2, 1.5f));
+	report.set(ReportColumn::Grid_Import, Eigen::VectorXf::Constant(2, 2.5f));
+
+	const fs::path csv = fs::temp_directory_path() / "epoch_report_data_test.csv";
+	writeTimeSeriesToCSV(csv, report);
+
+	std::ifstream in(csv);
+	std::string header, row;
+	std::getline(in, header);
+	std::getline(in, row);
+	fs::remove(csv);
+
+	auto count = [](const std::string& line) { return std::count(line.begin(), line.end(), ','); };
+	EXPECT_EQ(count(header), count(row));
+	EXPECT_EQ(header.rfind("Actual_import_shortfall,", 0), 0);
+	EXPECT_EQ(row.rfind("1.500000,", 0), 0);
+}
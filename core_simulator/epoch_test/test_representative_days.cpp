@@ -0,0 +1,96 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <numeric>
+#include <set>
+
+#include "../epoch_lib/Simulation/RepresentativeDays.hpp"
+#include "../epoch_lib/Simulation/Simulate.hpp"
+#include "../epoch_lib/io/FileHandling.hpp"
+#include "../epoch_lib/io/ResultTable.hpp"
+
+namespace fs = std::filesystem;
+
+class RepresentativeDaysTest : public ::testing::Test {
+protected:
+	std::shared_ptr<const SiteData> siteData;
+
+	RepresentativeDaysTest() :
+		siteData(std::make_shared<const SiteData>(readSiteData(fs::path{ "./test_files/siteData_MountHotel.json" })))
+	{}
+};
+
+TEST_F(RepresentativeDaysTest, WeightsCoverTheTimeseries) {
+	RepresentativeDays representative = selectRepresentativeDays(*siteData, 12);
+
+	ASSERT_EQ(representative.days.size(), representative.weights.size());
+	EXPECT_LE(representative.days.size(), 12u);
+	EXPECT_GT(representative.days.size(), 1u);
+
+	const float totalDays = static_cast<float>(siteData->timesteps) / static_cast<float>(representative.timestepsPerDay);
+	float weights = std::accumulate(representative.weights.begin(), representative.weights.end(), 0.0f);
+	EXPECT_NEAR(weights, totalDays, 1e-3f);
+
+	// the days are distinct whole days
+	std::set<size_t> days(representative.days.begin(), representative.days.end());
+	EXPECT_EQ(days.size(), representative.days.size());
+	for (size_t day : representative.days) {
+		EXPECT_LE((day + 1) * representative.timestepsPerDay, siteData->timesteps);
+	}
+
+	// the selection is deterministic
+	RepresentativeDays again = selectRepresentativeDays(*siteData, 12);
+	EXPECT_EQ(again.days, representative.days);
+	EXPECT_THROW(selectRepresentativeDays(*siteData, 0), std::runtime_error);
+}
+
+TEST_F(RepresentativeDaysTest, SliceSiteData) {
+	SiteData day = sliceSiteData(*siteData, 48, 48);
+	EXPECT_EQ(day.timesteps, 48u);
+	EXPECT_EQ(day.timestep_interval_s, siteData->timestep_interval_s);
+	EXPECT_EQ(day.building_eload[0], siteData->building_eload[48]);
+	EXPECT_EQ(day.import_tariffs.size(), siteData->import_tariffs.size());
+	EXPECT_THROW(sliceSiteData(*siteData, siteData->timesteps - 1, 2), std::runtime_error);
+}
+
+TEST_F(RepresentativeDaysTest, EveryDayMatchesTheFullSimulation) {
+	// with every day representing itself, only the state carried between days differs from a full simulation
+	Simulator simulator(siteData, TaskConfig{});
+	EXPECT_THROW(simulator.simulateScenario(TaskData{}, SimulationType::RepresentativeDays), std::runtime_error);
+
+	simulator.enableRepresentativeDays(siteData->timesteps);
+	// (the capex doesn't depend on the timeseries)
+	TaskData task = readTaskData(fs::path{ "./test_files/taskData_empty.json" });
+	auto full = simulator.simulateScenario(task);
+	auto screened = simulator.simulateScenario(task, SimulationType::RepresentativeDays);
+
+	EXPECT_EQ(screened.metrics.total_capex, full.metrics.total_capex);
+	EXPECT_NEAR(screened.metrics.total_gas_used, full.metrics.total_gas_used, 1e-3f * full.metrics.total_gas_used);
+	EXPECT_NEAR(screened.metrics.total_electricity_imported, full.metrics.total_electricity_imported,
+		1e-3f * full.metrics.total_electricity_imported);
+	EXPECT_NEAR(screened.metrics.total_annualised_cost, full.metrics.total_annualised_cost,
+		1e-3f * full.metrics.total_annualised_cost);
+}
+
+TEST_F(RepresentativeDaysTest, ErrorReport) {
+	Simulator simulator(siteData, TaskConfig{});
+	simulator.enableRepresentativeDays(30);
+
+	std::vector<TaskData> sample = {
+		readTaskData(fs::path{ "./test_files/taskData_common.json" }),
+		readTaskData(fs::path{ "./test_files/taskData_full.json" })
+	};
+	auto errors = simulator.representativeDaysError(sample);
+	ASSERT_EQ(errors.size(), resultColumns().size());
+
+	for (const auto& error : errors) {
+		EXPECT_GE(error.max_absolute_error, 0.0) << error.metric;
+		if (error.metric == "capex") {
+			EXPECT_EQ(error.max_absolute_error, 0.0);
+		}
+		if (error.metric == "total_gas_used" || error.metric == "total_electricity_imported") {
+			// a month of days can't reproduce the year exactly, but should be close
+			EXPECT_LT(error.max_relative_error, 0.25) << error.metric;
+		}
+	}
+}
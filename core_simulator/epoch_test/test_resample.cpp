@@ -0,0 +1,60 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <filesystem>
+
+#include "../epoch_lib/Simulation/Resample.hpp"
+#include "../epoch_lib/Simulation/Simulate.hpp"
+#include "../epoch_lib/io/FileHandling.hpp"
+
+namespace fs = std::filesystem;
+
+class ResampleTest : public ::testing::Test {
+protected:
+	std::shared_ptr<const SiteData> siteData;
+
+	ResampleTest() :
+		siteData(std::make_shared<const SiteData>(readSiteData(fs::path{ "./test_files/siteData_MountHotel.json" })))
+	{}
+};
+
+TEST_F(ResampleTest, EnergyIsConserved) {
+	SiteData coarse = resampleSiteData(*siteData, 2);
+
+	EXPECT_EQ(coarse.timesteps, siteData->timesteps / 2);
+	EXPECT_EQ(coarse.timestep_interval_s, siteData->timestep_interval_s * 2);
+	EXPECT_FLOAT_EQ(coarse.timestep_hours, siteData->timestep_hours * 2);
+
+	EXPECT_NEAR(coarse.building_eload.sum(), siteData->building_eload.sum(), 1e-4f * siteData->building_eload.sum());
+	EXPECT_NEAR(coarse.building_hload.sum(), siteData->building_hload.sum(), 1e-4f * siteData->building_hload.sum());
+	EXPECT_FLOAT_EQ(coarse.building_eload[3], siteData->building_eload[6] + siteData->building_eload[7]);
+
+	// the intensive timeseries are averaged rather than summed
+	EXPECT_FLOAT_EQ(coarse.air_temperature[3], (siteData->air_temperature[6] + siteData->air_temperature[7]) / 2.0f);
+	EXPECT_FLOAT_EQ(coarse.import_tariffs[0][3], (siteData->import_tariffs[0][6] + siteData->import_tariffs[0][7]) / 2.0f);
+
+	EXPECT_THROW(resampleSiteData(*siteData, 0), std::runtime_error);
+	EXPECT_THROW(resampleSiteData(*siteData, siteData->timesteps + 1), std::runtime_error);
+}
+
+TEST_F(ResampleTest, SimulatorsAtResolution) {
+	Simulator simulator(siteData, TaskConfig{});
+	const auto native = siteData->timestep_interval_s;
+
+	auto hourly = simulator.atResolution(native * 2);
+	EXPECT_EQ(hourly, simulator.atResolution(native * 2));
+	EXPECT_EQ(hourly->getSiteData()->timesteps, siteData->timesteps / 2);
+	EXPECT_EQ(simulator.atResolution(native)->getSiteData(), siteData);
+
+	EXPECT_THROW(simulator.atResolution(native / 2), std::runtime_error);
+	EXPECT_THROW(simulator.atResolution(native + std::chrono::seconds{ 1 }), std::runtime_error);
+
+	// a gas boiler large enough for every timestep burns the same gas at either resolution
+	TaskData task = readTaskData(fs::path{ "./test_files/taskData_empty.json" });
+	auto full = simulator.simulateScenario(task);
+	auto coarse = hourly->simulateScenario(task);
+	EXPECT_EQ(coarse.metrics.total_capex, full.metrics.total_capex);
+	EXPECT_NEAR(coarse.metrics.total_gas_used, full.metrics.total_gas_used, 1e-3f * full.metrics.total_gas_used);
+	EXPECT_NEAR(coarse.metrics.total_electricity_imported, full.metrics.total_electricity_imported,
+		1e-3f * full.metrics.total_electricity_imported);
+}
@@ -0,0 +1,153 @@
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../epoch_lib/Simulation/Simulate.hpp"
+#include "../epoch_lib/io/FileHandling.hpp"
+#include "../epoch_lib/io/ResultBinary.hpp"
+
+namespace fs = std::filesystem;
+
+class ResultBinaryTest : public ::testing::Test {
+protected:
+	static void SetUpTestSuite() {
+		simulator = std::make_unique<Simulator>(readSiteData(fs::path{ "./test_files/siteData_MountHotel.json" }), TaskConfig{});
+		result = simulator->simulateScenario(readTaskData(fs::path{ "./test_files/taskData_full.json" }), SimulationType::FullReporting);
+	}
+
+	static void TearDownTestSuite() {
+		simulator.reset();
+	}
+
+	static void expectSameReport(const ReportData& actual, const ReportData& expected) {
+		ASSERT_EQ(actual.presentMask(), expected.presentMask());
+		ASSERT_EQ(actual.timesteps(), expected.timesteps());
+		for (ReportColumn col : expected.populatedColumns()) {
+			EXPECT_TRUE(actual.get(col) == expected.get(col)) << REPORT_COLUMN_NAMES[static_cast<size_t>(col)];
+		}
+	}
+
+	static inline std::unique_ptr<Simulator> simulator;
+	static inline SimulationResult result;
+};
+
+TEST_F(ResultBinaryTest, RoundTripsExactly) {
+	for (TimeseriesEncoding encoding : { TimeseriesEncoding::Float32, TimeseriesEncoding::Delta }) {
+		SimulationResult decoded = decodeResult(encodeResult(result, encoding));
+
+		EXPECT_EQ(decoded.runtime, result.runtime);
+		EXPECT_EQ(decoded.timings.has_value(), result.timings.has_value());
+		EXPECT_EQ(decoded.metrics.total_annualised_cost, result.metrics.total_annualised_cost);
+		EXPECT_EQ(decoded.metrics.total_net_present_value, result.metrics.total_net_present_value);
+		EXPECT_EQ(decoded.baseline_metrics.total_operating_cost, result.baseline_metrics.total_operating_cost);
+		EXPECT_EQ(decoded.comparison.cost_balance, result.comparison.cost_balance);
+		EXPECT_EQ(decoded.comparison.payback_horizon_years, result.comparison.payback_horizon_years);
+		EXPECT_EQ(decoded.comparison.return_on_investment, result.comparison.return_on_investment);
+		EXPECT_EQ(decoded.scenario_capex_breakdown.total_capex, result.scenario_capex_breakdown.total_capex);
+		EXPECT_EQ(decoded.violates_constraints, result.violates_constraints);
+
+		ASSERT_TRUE(decoded.report_data.has_value());
+		expectSameReport(*decoded.report_data, *result.report_data);
+		// the baseline is only written when asked for
+		EXPECT_FALSE(decoded.baseline_report_data);
+	}
+}
+
+TEST_F(ResultBinaryTest, IncludesTheBaselineWhenAsked) {
+	SimulationResult decoded = decodeResult(encodeResult(result, TimeseriesEncoding::Delta, true));
+	ASSERT_TRUE(decoded.baseline_report_data && result.baseline_report_data);
+	expectSameReport(*decoded.baseline_report_data, *result.baseline_report_data);
+}
+
+TEST_F(ResultBinaryTest, EncodingsAreSmallerThanFloat32) {
+	const size_t float32 = encodeResult(result, TimeseriesEncoding::Float32).size();
+	EXPECT_LT(encodeResult(result, TimeseriesEncoding::Float16).size(), float32 * 6 / 10);
+	EXPECT_LT(encodeResult(result, TimeseriesEncoding::Delta).size(), float32);
+}
+
+TEST_F(ResultBinaryTest, Float16IsCloseToTheOriginal) {
+	SimulationResult decoded = decodeResult(encodeResult(result, TimeseriesEncoding::Float16));
+	ASSERT_TRUE(decoded.report_data.has_value());
+	ASSERT_EQ(decoded.report_data->presentMask(), result.report_data->presentMask());
+
+	// the metrics are never truncated
+	EXPECT_EQ(decoded.metrics.total_annualised_cost, result.metrics.total_annualised_cost);
+
+	for (ReportColumn col : result.report_data->populatedColumns()) {
+		const auto expected = result.report_data->get(col);
+		const auto actual = decoded.report_data->get(col);
+		for (Eigen::Index t = 0; t < expected.size(); t++) {
+			if (std::abs(expected[t]) < 65504.0f) {
+				ASSERT_NEAR(actual[t], expected[t], std::abs(expected[t]) / 1024.0f + 1e-7f);
+			}
+		}
+	}
+}
+
+TEST(ResultBinary, Float16HandlesSpecialValues) {
+	SimulationResult result{};
+	ReportData reportData;
+	Eigen::VectorXf values(8);
+	values << 0.0f, -0.0f, 1.0f / 3.0f, 70000.0f, -std::numeric_limits<float>::infinity(),
+		std::numeric_limits<float>::quiet_NaN(), 1e-6f, 65504.0f;
+	reportData.set(ReportColumn::Actual_import_shortfall, values);
+	result.report_data = reportData;
+
+	SimulationResult decoded = decodeResult(encodeResult(result, TimeseriesEncoding::Float16));
+	const auto actual = decoded.report_data->get(ReportColumn::Actual_import_shortfall);
+	EXPECT_EQ(actual[0], 0.0f);
+	EXPECT_TRUE(std::signbit(actual[1]));
+	EXPECT_NEAR(actual[2], 1.0f / 3.0f, 1e-4f);
+	EXPECT_EQ(actual[3], std::numeric_limits<float>::infinity());
+	EXPECT_EQ(actual[4], -std::numeric_limits<float>::infinity());
+	EXPECT_TRUE(std::isnan(actual[5]));
+	EXPECT_NEAR(actual[6], 1e-6f, 6e-8f);
+	EXPECT_EQ(actual[7], 65504.0f);
+}
+
+TEST_F(ResultBinaryTest, RejectsCorruptBytes) {
+	const std::vector<std::byte> bytes = encodeResult(result, TimeseriesEncoding::Delta);
+
+	std::vector<std::byte> badMagic = bytes;
+	badMagic[0] = std::byte{ 'X' };
+	EXPECT_THROW(decodeResult(badMagic), std::runtime_error);
+
+	std::vector<std::byte> badVersion = bytes;
+	uint32_t version = RESULT_BINARY_VERSION + 1;
+	std::memcpy(badVersion.data() + offsetof(ResultBinaryHeader, version), &version, sizeof(version));
+	EXPECT_THROW(decodeResult(badVersion), std::runtime_error);
+
+	EXPECT_THROW(decodeResult(std::span(bytes).first(bytes.size() - 1)), std::runtime_error);
+	EXPECT_THROW(decodeResult(std::span(bytes).first(10)), std::runtime_error);
+
+	// the last byte of a delta column ends a varint, so setting its continuation bit runs the column past its end
+	std::vector<std::byte> badReport = bytes;
+	badReport.back() |= std::byte{ 0x80 };
+	EXPECT_THROW(decodeResult(badReport), std::runtime_error);
+}
+
+TEST(ResultBinary, ParsesEncodingNames) {
+	EXPECT_EQ(timeseriesEncodingFromString("float32"), TimeseriesEncoding::Float32);
+	EXPECT_EQ(timeseriesEncodingFromString("float16"), TimeseriesEncoding::Float16);
+	EXPECT_EQ(timeseriesEncodingFromString("delta"), TimeseriesEncoding::Delta);
+	EXPECT_THROW(timeseriesEncodingFromString("zstd"), std::runtime_error);
+}
+
+TEST_F(ResultBinaryTest, WritesAndReadsFiles) {
+	const fs::path path = fs::temp_directory_path() / "epoch_result_binary_test.bin";
+	writeResultBinary(path, result, TimeseriesEncoding::Delta);
+	SimulationResult decoded = readResultBinary(path);
+	fs::remove(path);
+
+	EXPECT_EQ(decoded.metrics.total_annualised_cost, result.metrics.total_annualised_cost);
+	ASSERT_TRUE(decoded.report_data.has_value());
+	expectSameReport(*decoded.report_data, *result.report_data);
+}
@@ -0,0 +1,150 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <vector>
+
+#include "../epoch_lib/Simulation/ResultCache.hpp"
+#include "../epoch_lib/Simulation/Simulate.hpp"
+#include "../epoch_lib/io/FileHandling.hpp"
+
+namespace fs = std::filesystem;
+
+class ResultCacheRun : public ::testing::Test {
+protected:
+	Simulator simulator;
+	TaskData common;
+	TaskData full;
+
+	ResultCacheRun() :
+		simulator(readSiteData(fs::path{ "./test_files/siteData_MountHotel.json" }), TaskConfig{}),
+		common(readTaskData(fs::path{ "./test_files/taskData_common.json" })),
+		full(readTaskData(fs::path{ "./test_files/taskData_full.json" }))
+	{}
+};
+
+TEST_F(ResultCacheRun, DisabledByDefault) {
+	EXPECT_FALSE(simulator.getResultCacheStats().has_value());
+}
+
+TEST_F(ResultCacheRun, CachedResultMatchesSimulation) {
+	auto uncached = simulator.simulateScenario(common);
+
+	simulator.enableResultCache(1 << 20);
+	auto first = simulator.simulateScenario(common);
+	auto second = simulator.simulateScenario(common);
+
+	auto stats = simulator.getResultCacheStats().value();
+	EXPECT_EQ(stats.misses, 1);
+	EXPECT_EQ(stats.hits, 1);
+	EXPECT_EQ(stats.entries, 1);
+	EXPECT_GT(stats.bytes, 0);
+
+	for (const auto& result : { first, second }) {
+		EXPECT_EQ(result.metrics.total_annualised_cost, uncached.metrics.total_annualised_cost);
+		EXPECT_EQ(result.metrics.total_capex, uncached.metrics.total_capex);
+		EXPECT_EQ(result.comparison.cost_balance, uncached.comparison.cost_balance);
+		EXPECT_EQ(result.comparison.carbon_balance_scope_2, uncached.comparison.carbon_balance_scope_2);
+		EXPECT_EQ(result.baseline_metrics.total_annualised_cost, uncached.baseline_metrics.total_annualised_cost);
+		EXPECT_EQ(result.scenario_capex_breakdown.total_capex, uncached.scenario_capex_breakdown.total_capex);
+	}
+}
+
+TEST_F(ResultCacheRun, DifferentScenariosDoNotCollide) {
+	simulator.enableResultCache(1 << 20);
+
+	TaskData bigger = common;
+	bigger.energy_storage_system->capacity *= 2;
+
+	auto a = simulator.simulateScenario(common);
+	auto b = simulator.simulateScenario(bigger);
+	auto aAgain = simulator.simulateScenario(common);
+	auto bAgain = simulator.simulateScenario(bigger);
+
+	EXPECT_NE(a.metrics.total_capex, b.metrics.total_capex);
+	EXPECT_EQ(a.metrics.total_capex, aAgain.metrics.total_capex);
+	EXPECT_EQ(b.metrics.total_capex, bAgain.metrics.total_capex);
+	EXPECT_EQ(simulator.getResultCacheStats()->hits, 2);
+}
+
+TEST_F(ResultCacheRun, FullReportingBypassesLookup) {
+	simulator.enableResultCache(1 << 20);
+	simulator.simulateScenario(common);
+
+	auto result = simulator.simulateScenario(common, SimulationType::FullReporting);
+	EXPECT_TRUE(result.report_data.has_value());
+	EXPECT_EQ(simulator.getResultCacheStats()->hits, 0);
+}
+
+TEST_F(ResultCacheRun, InvalidScenariosAreNotCached) {
+	simulator.enableResultCache(1 << 20);
+
+	TaskData invalid = common;
+	invalid.grid->tariff_index = 99;
+	simulator.simulateScenario(invalid);
+	simulator.simulateScenario(invalid);
+
+	EXPECT_EQ(simulator.getResultCacheStats()->entries, 0);
+}
+
+TEST_F(ResultCacheRun, BatchSharesTheCache) {
+	simulator.enableResultCache(1 << 20);
+
+	std::vector<TaskData> batch(32, full);
+	auto results = simulator.simulateBatch(batch);
+
+	auto stats = simulator.getResultCacheStats().value();
+	EXPECT_EQ(stats.hits + stats.misses, batch.size());
+	EXPECT_EQ(stats.entries, 1);
+	for (const auto& result : results) {
+		EXPECT_EQ(result.metrics.total_annualised_cost, results[0].metrics.total_annualised_cost);
+	}
+
+	auto again = simulator.simulateBatch(batch);
+	EXPECT_EQ(simulator.getResultCacheStats()->hits, stats.hits + batch.size());
+}
+
+TEST(ResultCache, StaysWithinBudget) {
+	// a small budget, so most of these should be evicted
+	ResultCache cache{ 256 * 1024 };
+
+	SimulationResult result{};
+	for (int i = 0; i < 1000; i++) {
+		TaskData taskData{};
+		taskData.grid = GridData{};
+		taskData.grid->grid_import = static_cast<float>(i);
+		cache.insert(taskData, result);
+	}
+
+	auto stats = cache.stats();
+	EXPECT_LE(stats.bytes, stats.byte_budget);
+	EXPECT_GT(stats.evictions, 0);
+	EXPECT_EQ(stats.entries + stats.evictions, 1000);
+
+	cache.clear();
+	EXPECT_EQ(cache.stats().entries, 0);
+	EXPECT_EQ(cache.stats().bytes, 0);
+}
+
+TEST(ResultCache, EvictsLeastRecentlyUsed) {
+	ResultCache cache{ 256 * 1024 };
+
+	TaskData kept{};
+	kept.grid = GridData{};
+	kept.grid->grid_import = -1.0f;
+
+	SimulationResult result{};
+	result.metrics.total_capex = 42.0f;
+	cache.insert(kept, result);
+
+	SimulationResult found{};
+	for (int i = 0; i < 1000; i++) {
+		TaskData taskData{};
+		taskData.grid = GridData{};
+		taskData.grid->grid_import = static_cast<float>(i);
+		cache.insert(taskData, SimulationResult{});
+
+		// keep using this entry so that it is never the least recently used in its shard
+		ASSERT_TRUE(cache.lookup(kept, found));
+	}
+	EXPECT_EQ(found.metrics.total_capex, 42.0f);
+}
@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <set>
+#include <string>
+
+#include "../epoch_lib/io/ResultTable.hpp"
+
+namespace {
+	SimulationResult makeResult(float offset) {
+		SimulationResult result{};
+		result.comparison.meter_balance = 1.0f + offset;
+		result.comparison.operating_balance = 2.0f + offset;
+		result.comparison.payback_horizon_years = 3.0f + offset;
+		result.comparison.combined_carbon_balance = 4.0f + offset;
+		result.metrics.total_capex = 5.0f + offset;
+		result.metrics.total_annualised_cost = 6.0f + offset;
+		result.metrics.total_heat_load = 7.0f + offset;
+		return result;
+	}
+
+	Eigen::Index columnIndex(std::string_view name) {
+		const auto& columns = resultColumns();
+		for (size_t c = 0; c < columns.size(); c++) {
+			if (columns[c].name == name) {
+				return static_cast<Eigen::Index>(c);
+			}
+		}
+		return -1;
+	}
+}
+
+TEST(ResultTable, ColumnsAreUnique) {
+	std::set<std::string_view> names;
+	for (const auto& column : resultColumns()) {
+		EXPECT_TRUE(names.insert(column.name).second) << column.name;
+		EXPECT_TRUE(column.direction == -1 || column.direction == 0 || column.direction == 1);
+	}
+}
+
+TEST(ResultTable, OneRowPerResult) {
+	std::vector<SimulationResult> results = { makeResult(0.0f), makeResult(10.0f) };
+	results[1].comparison.return_on_investment = 0.5f;
+	results[1].metrics.environmental_impact_score = 80;
+
+	ResultTable table = resultsToTable(results);
+	ASSERT_EQ(table.rows(), 2);
+	ASSERT_EQ(table.cols(), static_cast<Eigen::Index>(resultColumns().size()));
+
+	EXPECT_EQ(table(0, columnIndex("capex")), 5.0);
+	EXPECT_EQ(table(1, columnIndex("capex")), 15.0);
+	EXPECT_EQ(table(1, columnIndex("payback_horizon")), 13.0);
+	EXPECT_EQ(table(1, columnIndex("carbon_balance_total")), 14.0);
+	EXPECT_EQ(table(1, columnIndex("annualised_cost")), 16.0);
+
+	// an undefined return on investment falls back to the operating balance
+	EXPECT_EQ(table(0, columnIndex("return_on_investment")), 2.0);
+	EXPECT_EQ(table(1, columnIndex("return_on_investment")), 0.5);
+
+	EXPECT_TRUE(std::isnan(table(0, columnIndex("environmental_impact_score"))));
+	EXPECT_EQ(table(1, columnIndex("environmental_impact_score")), 80.0);
+}
+
+TEST(ResultTable, DirectionsMakeEveryObjectiveMinimised) {
+	std::vector<SimulationResult> results = { makeResult(0.0f) };
+	ResultTable table = resultsToTable(results, true);
+
+	EXPECT_EQ(table(0, columnIndex("capex")), 5.0);
+	EXPECT_EQ(table(0, columnIndex("meter_balance")), -1.0);
+	EXPECT_EQ(table(0, columnIndex("total_heat_load")), 0.0);
+}
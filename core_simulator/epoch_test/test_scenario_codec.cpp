@@ -0,0 +1,133 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "../epoch_lib/io/ScenarioCodec.hpp"
+
+namespace {
+    // the components are deliberately not in alphabetical order, as the genes must follow the site range
+    const std::string SITE_RANGE = R"({
+        "grid": {
+            "COMPONENT_IS_MANDATORY": true,
+            "grid_import": [10.0, 20.0, 30.0],
+            "grid_export": [15.0],
+            "tariff_index": [0, 1],
+            "incumbent": true,
+            "age": 0,
+            "lifetime": 25
+        },
+        "energy_storage_system": {
+            "COMPONENT_IS_MANDATORY": false,
+            "capacity": [100.0, 200.0],
+            "battery_mode": ["CONSUME", "CONSUME_PLUS"],
+            "incumbent": false,
+            "age": 0,
+            "lifetime": 15
+        },
+        "building": {
+            "COMPONENT_IS_MANDATORY": true,
+            "scalar_heat_load": [1.0],
+            "fabric_intervention_index": [0, 1, 2],
+            "floor_area": 120.0,
+            "incumbent": true,
+            "age": 0,
+            "lifetime": 30
+        },
+        "solar_panels": [
+            {"COMPONENT_IS_MANDATORY": true, "yield_scalar": [50.0, 100.0], "yield_index": [0], "incumbent": false, "age": 0, "lifetime": 25},
+            {"COMPONENT_IS_MANDATORY": false, "yield_scalar": [10.0, 20.0], "yield_index": [1], "incumbent": false, "age": 0, "lifetime": 25}
+        ]
+    })";
+}
+
+TEST(ScenarioCodec, GenesFollowTheSiteRange) {
+    ScenarioCodec codec(SITE_RANGE);
+
+    EXPECT_EQ(codec.numGenes(), 9);
+    EXPECT_EQ(codec.geneNames(), (std::vector<std::string>{
+        "grid.grid_import", "grid.tariff_index",
+        "energy_storage_system.COMPONENT_IS_MANDATORY", "energy_storage_system.capacity", "energy_storage_system.battery_mode",
+        "building.fabric_intervention_index",
+        "solar_panels[0].yield_scalar",
+        "solar_panels[1].COMPONENT_IS_MANDATORY", "solar_panels[1].yield_scalar"
+    }));
+    EXPECT_EQ(codec.geneSizes(), (std::vector<size_t>{ 3, 2, 2, 2, 2, 3, 2, 2, 2 }));
+}
+
+TEST(ScenarioCodec, DecodesEveryGene) {
+    ScenarioCodec codec(SITE_RANGE);
+
+    std::vector<double> chromosome = { 2, 1, 1, 0, 1, 2, 1, 1, 1 };
+    TaskData taskData = codec.decode(chromosome);
+
+    ASSERT_TRUE(taskData.grid.has_value());
+    EXPECT_EQ(taskData.grid->grid_import, 30.0f);
+    EXPECT_EQ(taskData.grid->grid_export, 15.0f);
+    EXPECT_EQ(taskData.grid->tariff_index, 1);
+    EXPECT_TRUE(taskData.grid->incumbent);
+
+    ASSERT_TRUE(taskData.energy_storage_system.has_value());
+    EXPECT_EQ(taskData.energy_storage_system->capacity, 100.0f);
+    EXPECT_EQ(taskData.energy_storage_system->battery_mode, BatteryMode::CONSUME_PLUS);
+    // attributes missing from the site range keep their defaults
+    EXPECT_EQ(taskData.energy_storage_system->charge_power, EnergyStorageSystem{}.charge_power);
+
+    ASSERT_TRUE(taskData.building.has_value());
+    EXPECT_EQ(taskData.building->fabric_intervention_index, 2);
+    EXPECT_EQ(taskData.building->floor_area, 120.0f);
+    EXPECT_EQ(taskData.building->lifetime, 30.0f);
+
+    ASSERT_EQ(taskData.solar_panels.size(), 2);
+    EXPECT_EQ(taskData.solar_panels[0].yield_scalar, 100.0f);
+    EXPECT_EQ(taskData.solar_panels[1].yield_scalar, 20.0f);
+    EXPECT_EQ(taskData.solar_panels[1].yield_index, 1);
+
+    EXPECT_FALSE(taskData.heat_pump.has_value());
+}
+
+TEST(ScenarioCodec, PresenceGenesRemoveComponents) {
+    ScenarioCodec codec(SITE_RANGE);
+
+    // no ESS and no second solar panel
+    TaskData taskData = codec.decode(std::vector<double>{ 0, 0, 0, 1, 1, 0, 0, 0, 1 });
+
+    EXPECT_FALSE(taskData.energy_storage_system.has_value());
+    ASSERT_EQ(taskData.solar_panels.size(), 1);
+    EXPECT_EQ(taskData.solar_panels[0].yield_scalar, 50.0f);
+}
+
+TEST(ScenarioCodec, BatchMatchesSingleDecode) {
+    ScenarioCodec codec(SITE_RANGE);
+
+    Chromosomes chromosomes(3, 9);
+    chromosomes <<
+        2, 1, 1, 0, 1, 2, 1, 1, 1,
+        0, 0, 0, 1, 1, 0, 0, 0, 1,
+        // optimisers may give integer genes as (nearly) whole floating point values
+        1.0000001, 0.9999999, 1, 1, 0, 1, 0, 1, 0;
+
+    auto batch = codec.decode(chromosomes);
+    ASSERT_EQ(batch.size(), 3);
+    for (Eigen::Index row = 0; row < chromosomes.rows(); row++) {
+        std::vector<double> chromosome(chromosomes.row(row).begin(), chromosomes.row(row).end());
+        EXPECT_EQ(batch[row], codec.decode(chromosome));
+    }
+    EXPECT_EQ(batch[2].grid->grid_import, 20.0f);
+    EXPECT_EQ(batch[2].grid->tariff_index, 1);
+}
+
+TEST(ScenarioCodec, RejectsInvalidChromosomes) {
+    ScenarioCodec codec(SITE_RANGE);
+
+    EXPECT_THROW(codec.decode(std::vector<double>{ 0, 0, 0 }), std::runtime_error);
+    EXPECT_THROW(codec.decode(std::vector<double>{ 3, 0, 0, 0, 0, 0, 0, 0, 0 }), std::runtime_error);
+    EXPECT_THROW(codec.decode(std::vector<double>{ -1, 0, 0, 0, 0, 0, 0, 0, 0 }), std::runtime_error);
+}
+
+TEST(ScenarioCodec, RejectsInvalidSiteRanges) {
+    EXPECT_THROW(ScenarioCodec(R"({"spaceship": {"COMPONENT_IS_MANDATORY": true}})"), std::runtime_error);
+    EXPECT_THROW(ScenarioCodec(R"({"grid": {"COMPONENT_IS_MANDATORY": true, "warp_speed": [1, 2]}})"), std::runtime_error);
+    EXPECT_THROW(ScenarioCodec(R"({"grid": {"COMPONENT_IS_MANDATORY": true, "grid_import": []}})"), std::runtime_error);
+    EXPECT_THROW(ScenarioCodec(R"({"energy_storage_system": {"COMPONENT_IS_MANDATORY": true, "battery_mode": ["CONSUME", "OVERDRIVE"]}})"), std::runtime_error);
+}
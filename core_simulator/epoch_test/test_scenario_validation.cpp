@@ -1,3 +1,8 @@
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
 #include <gtest/gtest.h>
 
 #include "../epoch_lib/Simulation/SiteData.hpp"
@@ -80,3 +85,50 @@ TEST_F(SimulatorTest, ValidateScenario_FabricIndexEqualsOne_Succeeds) {
     EXPECT_NO_THROW(simulator.validateScenario(taskData));
 }
 
+
+// every error is reported at once, as a bitmask
+TEST_F(SimulatorTest, CheckScenario_ReportsEveryError) {
+    TaskData taskData = makeValidTaskData();
+    EXPECT_EQ(simulator.checkScenario(taskData), ScenarioError::None);
+
+    taskData.building->fabric_intervention_index = 2;
+    taskData.solar_panels[0].yield_index = -1;
+    const ScenarioError errors = simulator.checkScenario(taskData);
+    EXPECT_EQ(errors, ScenarioError::FabricInterventionIndex | ScenarioError::YieldIndex);
+    EXPECT_FALSE(hasError(errors, ScenarioError::TariffIndex));
+
+    const std::string message = simulator.describeScenarioError(taskData, errors);
+    EXPECT_NE(message.find("fabric_intervention_index of 2"), std::string::npos);
+    EXPECT_NE(message.find("yield_index of -1"), std::string::npos);
+    EXPECT_THROW(simulator.validateScenario(taskData), std::runtime_error);
+}
+
+// a whole population is checked in one call
+TEST_F(SimulatorTest, CheckScenarios_ChecksEachScenario) {
+    std::vector<TaskData> population(3, makeValidTaskData());
+    population[1].grid->tariff_index = 2;
+    population[2].building->fabric_intervention_index = 5;
+
+    std::vector<ScenarioError> errors(population.size());
+    simulator.checkScenarios(population, errors);
+    EXPECT_EQ(errors[0], ScenarioError::None);
+    EXPECT_EQ(errors[1], ScenarioError::TariffIndex);
+    EXPECT_EQ(errors[2], ScenarioError::FabricInterventionIndex);
+
+    std::vector<ScenarioError> tooFew(2);
+    EXPECT_THROW(simulator.checkScenarios(population, tooFew), std::invalid_argument);
+}
+
+// an invalid scenario is still given the invalid result, whether simulated alone or in a batch
+TEST_F(SimulatorTest, InvalidScenarios_GiveTheInvalidResult) {
+    std::vector<TaskData> population(20, makeValidTaskData());
+    for (auto& taskData : population) {
+        taskData.grid->tariff_index = 7;
+    }
+
+    const SimulationResult single = simulator.simulateScenario(population[0]);
+    EXPECT_EQ(single.metrics.total_capex, std::numeric_limits<float>::max());
+    for (const SimulationResult& result : simulator.simulateBatch(population, SimulationType::ResultOnly)) {
+        EXPECT_EQ(result.metrics.total_capex, std::numeric_limits<float>::max());
+    }
+}
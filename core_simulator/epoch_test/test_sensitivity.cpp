@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <filesystem>
+#include <stdexcept>
+#include <vector>
+
+#include <Eigen/Core>
+
+#include "../epoch_lib/Simulation/Simulate.hpp"
+#include "../epoch_lib/Simulation/Sensitivity.hpp"
+#include "../epoch_lib/io/FileHandling.hpp"
+
+namespace fs = std::filesystem;
+
+class SensitivityTest : public ::testing::Test {
+protected:
+	Simulator simulator;
+	TaskData taskData;
+
+	SensitivityTest() :
+		simulator(readSiteData(fs::path{ "./test_files/siteData_MountHotel.json" }), TaskConfig{}),
+		taskData(readTaskData(fs::path{ "./test_files/taskData_full.json" }))
+	{}
+
+	Eigen::VectorXf objectivesWith(const Perturbation& perturbation, float value) const {
+		TaskData perturbed = taskData;
+		setParameter(perturbed, perturbation, value);
+		return objectiveFields(toObjectiveResult(simulator.simulateScenario(perturbed), perturbed));
+	}
+};
+
+TEST_F(SensitivityTest, MatchesFiniteDifferencesOfSimulateScenario) {
+	const std::vector<Perturbation> perturbations = {
+		{ SensitivityParameter::ESSCapacity, 10.0f },
+		{ SensitivityParameter::ESSDischargePower, 5.0f },
+		{ SensitivityParameter::GridImport, 5.0f },
+		{ SensitivityParameter::HeatPower, 2.0f },
+		{ SensitivityParameter::YieldScalar, 10.0f, 1 }
+	};
+
+	SensitivityResult result = simulator.sensitivities(taskData, perturbations);
+	ASSERT_EQ(result.jacobian.rows(), static_cast<Eigen::Index>(NUM_OBJECTIVE_FIELDS));
+	ASSERT_EQ(result.jacobian.cols(), static_cast<Eigen::Index>(perturbations.size()));
+
+	auto base = toObjectiveResult(simulator.simulateScenario(taskData), taskData);
+	EXPECT_EQ(objectiveFields(result.base), objectiveFields(base));
+
+	for (size_t p = 0; p < perturbations.size(); p++) {
+		SCOPED_TRACE(p);
+		const Perturbation& perturbation = perturbations[p];
+		const float value = getParameter(taskData, perturbation);
+		Eigen::VectorXf expected = (objectivesWith(perturbation, value + perturbation.step)
+			- objectivesWith(perturbation, value - perturbation.step)) / (2.0f * perturbation.step);
+		EXPECT_EQ(Eigen::VectorXf(result.jacobian.col(static_cast<Eigen::Index>(p))), expected);
+	}
+
+	// a larger ESS costs more up front
+	EXPECT_GT(result.jacobian(1, 0), 0.0f);
+
+	// only the ESS and grid perturbations start from the base scenario's state before the balancing loop
+	EXPECT_EQ(result.reused_pre_balancing, 6);
+}
+
+TEST_F(SensitivityTest, ForwardDifferences) {
+	// a step larger than the value can't be taken backwards, so falls back to a forward difference
+	taskData.energy_storage_system->capacity = 5.0f;
+	const std::vector<Perturbation> perturbations = { { SensitivityParameter::ESSCapacity, 10.0f } };
+
+	for (SensitivityScheme scheme : { SensitivityScheme::Forward, SensitivityScheme::Central }) {
+		SensitivityResult result = simulator.sensitivities(taskData, perturbations, scheme);
+		Eigen::VectorXf expected = (objectivesWith(perturbations[0], 15.0f) - objectivesWith(perturbations[0], 5.0f)) / 10.0f;
+		EXPECT_EQ(Eigen::VectorXf(result.jacobian.col(0)), expected);
+		EXPECT_EQ(result.reused_pre_balancing, 1);
+	}
+}
+
+TEST_F(SensitivityTest, InvalidPerturbations) {
+	// a missing component, a missing panel and a step that isn't positive
+	TaskData noESS = taskData;
+	noESS.energy_storage_system.reset();
+	const std::vector<Perturbation> ess = { { SensitivityParameter::ESSCapacity, 1.0f } };
+	EXPECT_THROW(simulator.sensitivities(noESS, ess), std::runtime_error);
+
+	const std::vector<Perturbation> panel = { { SensitivityParameter::YieldScalar, 1.0f, 99 } };
+	EXPECT_THROW(simulator.sensitivities(taskData, panel), std::runtime_error);
+
+	const std::vector<Perturbation> zeroStep = { { SensitivityParameter::GridImport, 0.0f } };
+	EXPECT_THROW(simulator.sensitivities(taskData, zeroStep), std::runtime_error);
+
+	// no perturbations is just the base scenario
+	SensitivityResult result = simulator.sensitivities(taskData, {});
+	EXPECT_EQ(result.jacobian.cols(), 0);
+	EXPECT_EQ(result.base.total_capex, simulator.simulateScenario(taskData).metrics.total_capex);
+}
@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "../epoch_lib/Portfolio/PortfolioSimulator.hpp"
+#include "../epoch_lib/Simulation/DerivedCache.hpp"
+#include "../epoch_lib/Simulation/SeriesStore.hpp"
+#include "../epoch_lib/Simulation/Simulate.hpp"
+#include "../epoch_lib/io/FileHandling.hpp"
+
+namespace fs = std::filesystem;
+
+namespace {
+	const fs::path SITE_DATA{ "./test_files/siteData_MountHotel.json" };
+}
+
+TEST(SeriesStore, StoresIdenticalColumnsOnce) {
+	SeriesStore store;
+	SiteData first = store.intern(readSiteData(SITE_DATA));
+	const size_t columns = store.size();
+
+	SiteData other = readSiteData(SITE_DATA);
+	// a column with different values is stored separately
+	other.grid_co2 = SiteSeries(other.grid_co2 * 1.5f);
+	SiteData second = store.intern(std::move(other));
+
+	EXPECT_EQ(second.air_temperature.data(), first.air_temperature.data());
+	EXPECT_EQ(second.building_eload.data(), first.building_eload.data());
+	ASSERT_EQ(second.import_tariffs.size(), first.import_tariffs.size());
+	for (size_t i = 0; i < first.import_tariffs.size(); i++) {
+		EXPECT_EQ(second.import_tariffs[i].data(), first.import_tariffs[i].data());
+	}
+
+	EXPECT_NE(second.grid_co2.data(), first.grid_co2.data());
+	EXPECT_EQ(second.grid_co2[0], first.grid_co2[0] * 1.5f);
+	EXPECT_EQ(store.size(), columns + 1);
+}
+
+TEST(SeriesStore, PrunesUnusedColumns) {
+	SeriesStore store;
+	{
+		SiteData siteData = store.intern(readSiteData(SITE_DATA));
+		EXPECT_GT(store.storedBytes(), 0u);
+		EXPECT_EQ(store.prune(), 0u);
+	}
+	EXPECT_GT(store.prune(), 0u);
+	EXPECT_EQ(store.size(), 0u);
+	EXPECT_EQ(store.storedBytes(), 0u);
+}
+
+TEST(SeriesIdentity, ComparesStorageRatherThanValues) {
+	const SiteSeries series(Eigen::VectorXf::Constant(16, 1.0f));
+	const SiteSeries copy = series;
+	const SiteSeries sameValues(Eigen::VectorXf::Constant(16, 1.0f));
+
+	EXPECT_EQ(SeriesIdentity(copy), SeriesIdentity(series));
+	EXPECT_FALSE(SeriesIdentity(sameValues) == SeriesIdentity(series));
+	EXPECT_FALSE(SeriesIdentity(series).expired());
+	EXPECT_FALSE(SeriesIdentity(SiteSeries{}).expired());
+
+	std::optional<SiteSeries> freed = SiteSeries(Eigen::VectorXf::Zero(4));
+	const SeriesIdentity identity(*freed);
+	freed.reset();
+	EXPECT_TRUE(identity.expired());
+}
+
+TEST(DerivedCache, SharesValuesWhileTheyAreUsed) {
+	DerivedCache<SeriesIdentity, int> cache;
+	const SiteSeries series(Eigen::VectorXf::Zero(4));
+	int made = 0;
+	auto make = [&] { return ++made; };
+
+	auto first = cache.get(SeriesIdentity(series), make);
+	auto second = cache.get(SeriesIdentity(series), make);
+	EXPECT_EQ(first, second);
+	EXPECT_EQ(made, 1);
+
+	// once nothing uses the value it is made again
+	first.reset();
+	second.reset();
+	EXPECT_EQ(*cache.get(SeriesIdentity(series), make), 2);
+	EXPECT_EQ(cache.size(), 1u);
+}
+
+TEST(SeriesStore, SimulatorsShareDerivedData) {
+	SeriesStore store;
+	Simulator first(store.intern(readSiteData(SITE_DATA)), TaskConfig{});
+	Simulator second(store.intern(readSiteData(SITE_DATA)), TaskConfig{});
+	Simulator separate(readSiteData(SITE_DATA), TaskConfig{});
+
+	EXPECT_EQ(&first.getTariffStats(0), &second.getTariffStats(0));
+	EXPECT_EQ(&first.getAmbientHeatPumpProfile(), &second.getAmbientHeatPumpProfile());
+	EXPECT_NE(&first.getTariffStats(0), &separate.getTariffStats(0));
+	EXPECT_NE(&first.getAmbientHeatPumpProfile(), &separate.getAmbientHeatPumpProfile());
+
+	// sharing changes nothing about the results
+	const TaskData full = readTaskData(fs::path{ "./test_files/taskData_full.json" });
+	const auto shared = second.simulateScenario(full);
+	const auto expected = separate.simulateScenario(full);
+	EXPECT_EQ(shared.metrics.total_annualised_cost, expected.metrics.total_annualised_cost);
+	EXPECT_EQ(shared.metrics.total_electricity_imported, expected.metrics.total_electricity_imported);
+	EXPECT_EQ(shared.comparison.cost_balance, expected.comparison.cost_balance);
+}
+
+TEST(SeriesStore, PortfolioSitesShareColumns) {
+	const std::vector<SiteSource> sites = {
+		SiteSource{ "hotel", SITE_DATA, TaskConfig{} },
+		SiteSource{ "annex", SITE_DATA, TaskConfig{} },
+	};
+	PortfolioSimulator portfolio = PortfolioSimulator::build(sites);
+
+	const auto& hotel = portfolio.getSimulator("hotel");
+	const auto& annex = portfolio.getSimulator("annex");
+	EXPECT_EQ(hotel.getSiteData()->air_temperature.data(), annex.getSiteData()->air_temperature.data());
+	EXPECT_EQ(&hotel.getTariffStats(0), &annex.getTariffStats(0));
+}
@@ -0,0 +1,139 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <limits>
+#include <vector>
+
+#include "../epoch_lib/Simulation/Simulate.hpp"
+#include "../epoch_lib/io/FileHandling.hpp"
+
+namespace fs = std::filesystem;
+
+class SimulateConfigsTest : public ::testing::Test {
+protected:
+	SiteData siteData;
+	Simulator simulator;
+	TaskData taskData;
+	std::vector<TaskConfig> configs;
+
+	SimulateConfigsTest() :
+		siteData(readSiteData(fs::path{ "./test_files/siteData_MountHotel.json" })),
+		simulator(siteData, TaskConfig{}),
+		taskData(readTaskData(fs::path{ "./test_files/taskData_full.json" }))
+	{
+		configs.push_back(TaskConfig{});
+
+		TaskConfig funded;
+		funded.use_boiler_upgrade_scheme = true;
+		funded.general_grant_funding = 25000.0f;
+		configs.push_back(funded);
+
+		TaskConfig discounted;
+		discounted.npv_time_horizon = 20;
+		discounted.npv_discount_factor = 0.035f;
+		configs.push_back(discounted);
+
+		TaskConfig pricier;
+		pricier.capex_model.heatpump_prices.final_rate *= 1.5f;
+		pricier.capex_model.ess_enclosure_prices.fixed_cost += 5000.0f;
+		configs.push_back(pricier);
+	}
+};
+
+TEST_F(SimulateConfigsTest, MatchesASimulatorPerConfig) {
+	const auto results = simulator.simulateConfigs(taskData, configs);
+	ASSERT_EQ(results.size(), configs.size());
+
+	for (size_t i = 0; i < configs.size(); i++) {
+		SCOPED_TRACE(i);
+		const Simulator own(siteData, configs[i]);
+		const SimulationResult expected = own.simulateScenario(taskData);
+
+		EXPECT_EQ(results[i].metrics.total_capex, expected.metrics.total_capex);
+		EXPECT_EQ(results[i].metrics.total_annualised_cost, expected.metrics.total_annualised_cost);
+		EXPECT_EQ(results[i].metrics.total_net_present_value, expected.metrics.total_net_present_value);
+		EXPECT_EQ(results[i].metrics.total_operating_cost, expected.metrics.total_operating_cost);
+		EXPECT_EQ(results[i].baseline_metrics.total_annualised_cost, expected.baseline_metrics.total_annualised_cost);
+		EXPECT_EQ(results[i].comparison.cost_balance, expected.comparison.cost_balance);
+		EXPECT_EQ(results[i].comparison.payback_horizon_years, expected.comparison.payback_horizon_years);
+		EXPECT_EQ(results[i].comparison.combined_carbon_balance, expected.comparison.combined_carbon_balance);
+	}
+
+	// the funding and capex model change the costs, but never the dispatch
+	EXPECT_NE(results[1].metrics.total_capex, results[0].metrics.total_capex);
+	EXPECT_NE(results[3].metrics.total_capex, results[0].metrics.total_capex);
+	EXPECT_EQ(results[1].metrics.total_electricity_imported, results[0].metrics.total_electricity_imported);
+}
+
+TEST_F(SimulateConfigsTest, SharesEachConfig) {
+	const auto first = simulator.withConfig(configs[1]);
+	EXPECT_EQ(simulator.withConfig(configs[1]), first);
+	EXPECT_NE(simulator.withConfig(configs[2]), first);
+
+	EXPECT_EQ(first->getConfig(), configs[1]);
+	EXPECT_EQ(first->getSiteData(), simulator.getSiteData());
+	// the baseline is costed from the totals, so is ready without simulating it
+	EXPECT_TRUE(first->hasBaseline());
+}
+
+TEST_F(SimulateConfigsTest, KeepsTheMostRecentlyUsedConfigs) {
+	const auto first = simulator.withConfig(configs[1]);
+	auto fundedBy = [](float funding) {
+		TaskConfig config;
+		config.general_grant_funding = funding;
+		return config;
+	};
+
+	// fill the cache, using the first config again before another is added
+	for (int i = 1; i < 256; i++) {
+		simulator.withConfig(fundedBy(static_cast<float>(i)));
+	}
+	EXPECT_EQ(simulator.withConfig(configs[1]), first);
+	const auto leastRecent = simulator.withConfig(fundedBy(1.0f));
+	for (int i = 2; i < 256; i++) {
+		simulator.withConfig(fundedBy(static_cast<float>(i)));
+	}
+	simulator.withConfig(configs[1]);
+
+	// only the least recently used config is dropped to make room
+	simulator.withConfig(fundedBy(256.0f));
+	EXPECT_EQ(simulator.withConfig(configs[1]), first);
+	EXPECT_NE(simulator.withConfig(fundedBy(1.0f)), leastRecent);
+}
+
+TEST_F(SimulateConfigsTest, ReportsTheBaselineOfEachConfig) {
+	const auto funded = simulator.withConfig(configs[1]);
+	const SimulationResult expected = simulator.simulateScenario(taskData, SimulationType::FullReporting);
+
+	const SimulationResult full = funded->simulateScenario(taskData, SimulationType::FullReporting);
+	ASSERT_TRUE(full.baseline_report_data);
+	EXPECT_EQ(full.baseline_report_data->get(ReportColumn::Grid_Import), expected.baseline_report_data->get(ReportColumn::Grid_Import));
+
+	const ReportColumnMask columns{ ReportColumn::Grid_Import, ReportColumn::Grid_Export };
+	const SimulationResult selected = funded->simulateScenario(taskData, columns);
+	ASSERT_TRUE(selected.baseline_report_data);
+	EXPECT_EQ(selected.baseline_report_data->presentMask() & ~columns.bits(), 0u);
+	EXPECT_EQ(selected.baseline_report_data->get(ReportColumn::Grid_Import), expected.baseline_report_data->get(ReportColumn::Grid_Import));
+}
+
+TEST_F(SimulateConfigsTest, SharesASimulatedBaseline) {
+	const SimulationResult expected = simulator.simulateScenario(taskData, SimulationType::FullReporting);
+	ASSERT_TRUE(simulator.hasBaseline());
+
+	// the baseline has already been simulated, so every config is costed from it without simulating it again
+	const SimulationResult funded = simulator.withConfig(configs[1])->simulateScenario(taskData, SimulationType::FullReporting);
+	EXPECT_EQ(funded.baseline_report_data, expected.baseline_report_data);
+	const Simulator own(siteData, configs[1]);
+	EXPECT_EQ(funded.baseline_metrics.total_annualised_cost, own.simulateScenario(taskData).baseline_metrics.total_annualised_cost);
+}
+
+TEST_F(SimulateConfigsTest, InvalidScenariosHaveEachConfigsInvalidResult) {
+	TaskData invalid = taskData;
+	invalid.grid->tariff_index = 999;
+
+	const auto results = simulator.simulateConfigs(invalid, configs);
+	ASSERT_EQ(results.size(), configs.size());
+	for (const auto& result : results) {
+		EXPECT_EQ(result.metrics.total_annualised_cost, std::numeric_limits<float>::max());
+	}
+}
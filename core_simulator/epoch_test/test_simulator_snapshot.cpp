@@ -0,0 +1,116 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../epoch_lib/Simulation/Simulate.hpp"
+#include "../epoch_lib/io/FileHandling.hpp"
+#include "../epoch_lib/io/SimulatorSnapshot.hpp"
+
+namespace fs = std::filesystem;
+
+class SimulatorSnapshotTest : public ::testing::Test {
+protected:
+	std::shared_ptr<const SiteData> siteData = std::make_shared<const SiteData>(readSiteData(fs::path{ "./test_files/siteData_MountHotel.json" }));
+	TaskData taskData = readTaskData(fs::path{ "./test_files/taskData_full.json" });
+	TaskConfig config = makeConfig();
+
+	static TaskConfig makeConfig() {
+		TaskConfig config{};
+		config.use_boiler_upgrade_scheme = true;
+		config.general_grant_funding = 2500.0f;
+		config.npv_time_horizon = 15;
+		config.npv_discount_factor = 0.035f;
+		config.capex_model.ev_prices.fast_cost = 3100.0f;
+		config.capex_model.heatpump_prices.segments.push_back({ 250.0f, 1750.0f });
+		config.opex_model.pv_prices.fixed_cost = 125.0f;
+		return config;
+	}
+};
+
+TEST_F(SimulatorSnapshotTest, RestoredSimulatorMatchesTheOriginal) {
+	Simulator original(siteData, config);
+	std::shared_ptr<Simulator> restored = restoreSimulator(snapshotSimulator(original));
+
+	const TaskConfig& restoredConfig = restored->getConfig();
+	EXPECT_EQ(restoredConfig.npv_time_horizon, config.npv_time_horizon);
+	EXPECT_EQ(restoredConfig.npv_discount_factor, config.npv_discount_factor);
+	EXPECT_EQ(restoredConfig.general_grant_funding, config.general_grant_funding);
+	EXPECT_EQ(restoredConfig.capex_model.ev_prices.fast_cost, config.capex_model.ev_prices.fast_cost);
+	ASSERT_EQ(restoredConfig.capex_model.heatpump_prices.segments.size(), config.capex_model.heatpump_prices.segments.size());
+	EXPECT_EQ(restoredConfig.capex_model.heatpump_prices.segments.back().upper, 250.0f);
+	EXPECT_EQ(restoredConfig.capex_model.heatpump_prices.segments.back().rate, 1750.0f);
+	EXPECT_EQ(restoredConfig.opex_model.pv_prices.fixed_cost, config.opex_model.pv_prices.fixed_cost);
+	EXPECT_EQ(restored->getSiteData()->timesteps, siteData->timesteps);
+	EXPECT_EQ(restored->getSiteData()->import_tariffs.back(), siteData->import_tariffs.back());
+
+	auto expected = original.simulateScenario(taskData, SimulationType::FullReporting);
+	auto result = restored->simulateScenario(taskData, SimulationType::FullReporting);
+
+	EXPECT_EQ(result.metrics.total_annualised_cost, expected.metrics.total_annualised_cost);
+	EXPECT_EQ(result.metrics.total_net_present_value, expected.metrics.total_net_present_value);
+	EXPECT_EQ(result.metrics.total_electricity_imported, expected.metrics.total_electricity_imported);
+	EXPECT_EQ(result.baseline_metrics.total_operating_cost, expected.baseline_metrics.total_operating_cost);
+	EXPECT_EQ(result.comparison.cost_balance, expected.comparison.cost_balance);
+	EXPECT_EQ(result.comparison.combined_carbon_balance, expected.comparison.combined_carbon_balance);
+	EXPECT_EQ(result.comparison.payback_horizon_years, expected.comparison.payback_horizon_years);
+
+	ASSERT_TRUE(result.baseline_report_data && expected.baseline_report_data);
+	EXPECT_EQ(result.baseline_report_data->presentMask(), expected.baseline_report_data->presentMask());
+	EXPECT_TRUE(result.baseline_report_data->populated() == expected.baseline_report_data->populated());
+}
+
+TEST_F(SimulatorSnapshotTest, RestoringDoesNotSimulateTheBaseline) {
+	Simulator original(siteData, config);
+
+	// a Simulator given an altered baseline compares against it, which a re-simulated baseline would not
+	SimulatorBaseline baseline = original.getBaseline();
+	baseline.usage.total_meter_cost += 1000.0f;
+	baseline.metrics.total_annualised_cost += 1000.0f;
+	Simulator altered(siteData, config, baseline);
+
+	std::shared_ptr<Simulator> restored = restoreSimulator(snapshotSimulator(altered));
+	EXPECT_EQ(restored->getBaseline().usage.total_meter_cost, baseline.usage.total_meter_cost);
+	EXPECT_EQ(restored->getBaseline().metrics.total_annualised_cost, baseline.metrics.total_annualised_cost);
+
+	auto expected = original.simulateScenario(taskData);
+	auto result = restored->simulateScenario(taskData);
+	EXPECT_EQ(result.metrics.total_annualised_cost, expected.metrics.total_annualised_cost);
+	EXPECT_NE(result.comparison.meter_balance, expected.comparison.meter_balance);
+	EXPECT_NE(result.comparison.cost_balance, expected.comparison.cost_balance);
+}
+
+TEST_F(SimulatorSnapshotTest, RestoresFromUnalignedBytes) {
+	Simulator original(siteData, config);
+	std::vector<std::byte> snapshot = snapshotSimulator(original);
+
+	// a snapshot held by python (or read from a socket) may start anywhere
+	std::vector<std::byte> shifted(snapshot.size() + 1);
+	std::memcpy(shifted.data() + 1, snapshot.data(), snapshot.size());
+	std::shared_ptr<Simulator> restored = restoreSimulator(std::span<const std::byte>(shifted).subspan(1));
+
+	EXPECT_EQ(restored->simulateScenario(taskData).metrics.total_annualised_cost,
+		original.simulateScenario(taskData).metrics.total_annualised_cost);
+}
+
+TEST_F(SimulatorSnapshotTest, RejectsCorruptSnapshots) {
+	std::vector<std::byte> snapshot = snapshotSimulator(Simulator(siteData, config));
+
+	std::vector<std::byte> truncated(snapshot.begin(), snapshot.end() - 4);
+	EXPECT_THROW(restoreSimulator(truncated), std::runtime_error);
+
+	std::vector<std::byte> wrongVersion = snapshot;
+	uint32_t version = SIMULATOR_SNAPSHOT_VERSION + 1;
+	std::memcpy(wrongVersion.data() + SIMULATOR_SNAPSHOT_MAGIC.size(), &version, sizeof(version));
+	EXPECT_THROW(restoreSimulator(wrongVersion), std::runtime_error);
+
+	std::vector<std::byte> notASnapshot = snapshot;
+	notASnapshot[0] = std::byte{ 'X' };
+	EXPECT_THROW(restoreSimulator(notASnapshot), std::runtime_error);
+}
@@ -62,7 +62,7 @@ TEST(SiteDataValidationTest, MismatchedVectorSizes) {
 TEST(SiteDataValidationTest, MismatchedSolarYields) {
     // check we also can't pass in mismatched solar yields
     auto sdBase = make24HourSiteData();
-    auto badSolar = sdBase.solar_yields;
+    std::vector<SiteSeries> badSolar = sdBase.solar_yields.columns();
     badSolar[0] = Eigen::VectorXf::Ones(23);
 
     EXPECT_THROW({
@@ -89,7 +89,7 @@ TEST(SiteDataValidationTest, MismatchedSolarYields) {
 TEST(SiteDataValidationTest, EmptyImportTariffs) {
     // Check that we can't provide 0 import tariffs
     auto sdBase = make24HourSiteData();
-    std::vector<year_TS> noTariffs{};
+    std::vector<SiteSeries> noTariffs{};
 
     EXPECT_THROW({
         SiteData broken(
@@ -0,0 +1,159 @@
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include <Eigen/Core>
+#include <gtest/gtest.h>
+
+#include "../epoch_lib/Simulation/Simulate.hpp"
+#include "../epoch_lib/io/FileHandling.hpp"
+#include "../epoch_lib/io/SiteDataBinary.hpp"
+
+namespace fs = std::filesystem;
+
+class SiteDataBinaryTest : public ::testing::Test {
+protected:
+	fs::path dir;
+	fs::path binaryPath;
+
+	void SetUp() override {
+		dir = fs::temp_directory_path() / ("epoch_site_data_binary_" + std::string(::testing::UnitTest::GetInstance()->current_test_info()->name()));
+		fs::create_directories(dir);
+		binaryPath = dir / "siteData.bin";
+	}
+
+	void TearDown() override {
+		fs::remove_all(dir);
+	}
+};
+
+TEST_F(SiteDataBinaryTest, RoundTripIsExact) {
+	SiteData json = readSiteData(fs::path{ "./test_files/siteData_MountHotel.json" });
+	writeSiteDataBinary(json, binaryPath);
+
+	EXPECT_TRUE(isSiteDataBinary(binaryPath));
+	EXPECT_FALSE(isSiteDataBinary(fs::path{ "./test_files/siteData_MountHotel.json" }));
+
+	// readSiteData detects the format
+	SiteData binary = readSiteData(binaryPath);
+
+	EXPECT_EQ(binary.start_ts, json.start_ts);
+	EXPECT_EQ(binary.end_ts, json.end_ts);
+	EXPECT_EQ(binary.timesteps, json.timesteps);
+	EXPECT_EQ(binary.timestep_hours, json.timestep_hours);
+	EXPECT_EQ(binary.peak_hload, json.peak_hload);
+	EXPECT_EQ(binary.baseline, json.baseline);
+
+	EXPECT_EQ(binary.building_eload, json.building_eload);
+	EXPECT_EQ(binary.building_hload, json.building_hload);
+	EXPECT_EQ(binary.ev_eload, json.ev_eload);
+	EXPECT_EQ(binary.dhw_demand, json.dhw_demand);
+	EXPECT_EQ(binary.air_temperature, json.air_temperature);
+	EXPECT_EQ(binary.grid_co2, json.grid_co2);
+
+	ASSERT_EQ(binary.solar_yields.size(), json.solar_yields.size());
+	for (size_t i = 0; i < json.solar_yields.size(); i++) {
+		EXPECT_EQ(binary.solar_yields[i], json.solar_yields[i]);
+	}
+	ASSERT_EQ(binary.import_tariffs.size(), json.import_tariffs.size());
+	for (size_t i = 0; i < json.import_tariffs.size(); i++) {
+		EXPECT_EQ(binary.import_tariffs[i], json.import_tariffs[i]);
+	}
+	ASSERT_EQ(binary.fabric_interventions.size(), json.fabric_interventions.size());
+	for (size_t i = 0; i < json.fabric_interventions.size(); i++) {
+		EXPECT_EQ(binary.fabric_interventions[i].cost, json.fabric_interventions[i].cost);
+		EXPECT_EQ(binary.fabric_interventions[i].peak_hload, json.fabric_interventions[i].peak_hload);
+		EXPECT_EQ(binary.fabric_interventions[i].cost_breakdown.size(), json.fabric_interventions[i].cost_breakdown.size());
+		EXPECT_EQ(binary.fabric_interventions[i].reduced_hload, json.fabric_interventions[i].reduced_hload);
+	}
+
+	EXPECT_EQ(binary.ashp_input_table, json.ashp_input_table);
+	EXPECT_EQ(binary.ashp_output_table, json.ashp_output_table);
+}
+
+TEST_F(SiteDataBinaryTest, SimulatesIdentically) {
+	SiteData json = readSiteData(fs::path{ "./test_files/siteData_MountHotel.json" });
+	writeSiteDataBinary(json, binaryPath);
+	TaskData taskData = readTaskData(fs::path{ "./test_files/taskData_full.json" });
+
+	auto fromJson = Simulator(json, TaskConfig{}).simulateScenario(taskData);
+	auto fromBinary = Simulator(readSiteData(binaryPath), TaskConfig{}).simulateScenario(taskData);
+
+	EXPECT_EQ(fromBinary.metrics.total_annualised_cost, fromJson.metrics.total_annualised_cost);
+	EXPECT_EQ(fromBinary.metrics.total_electricity_imported, fromJson.metrics.total_electricity_imported);
+	EXPECT_EQ(fromBinary.comparison.cost_balance, fromJson.comparison.cost_balance);
+	EXPECT_EQ(fromBinary.comparison.combined_carbon_balance, fromJson.comparison.combined_carbon_balance);
+}
+
+TEST_F(SiteDataBinaryTest, MappedSiteDataSharesTheMapping) {
+	SiteData json = readSiteData(fs::path{ "./test_files/siteData_MountHotel.json" });
+	writeSiteDataBinary(json, binaryPath);
+	TaskData taskData = readTaskData(fs::path{ "./test_files/taskData_full.json" });
+
+	// the SiteData keeps the mapping alive after its SiteDataView is gone
+	SiteData mapped = mapSiteDataBinary(binaryPath);
+
+	EXPECT_TRUE(mapped.building_eload.isView());
+	EXPECT_TRUE(mapped.import_tariffs.back().isView());
+	for (const auto& fi : mapped.fabric_interventions) {
+		EXPECT_TRUE(fi.reduced_hload.isView());
+	}
+	EXPECT_EQ(reinterpret_cast<uintptr_t>(mapped.grid_co2.data()) % SITE_DATA_BINARY_ALIGNMENT, 0);
+	// the solar yield columns are contiguous in the file, so the yield matrix is used in place too
+	EXPECT_EQ(mapped.solar_yields.matrix().data(), mapped.solar_yields.front().data());
+	EXPECT_EQ(mapped.solar_yields.ownedBytes(), 0);
+	EXPECT_TRUE(mapped.grid_co2 == json.grid_co2);
+	EXPECT_LT(mapped.memoryFootprint(), json.memoryFootprint());
+
+	// copies view the same values
+	SiteData copy = mapped;
+	EXPECT_EQ(copy.solar_yields.front().data(), mapped.solar_yields.front().data());
+
+	auto fromJson = Simulator(json, TaskConfig{}).simulateScenario(taskData);
+	auto fromMapping = Simulator(std::move(copy), TaskConfig{}).simulateScenario(taskData);
+	EXPECT_EQ(fromMapping.metrics.total_annualised_cost, fromJson.metrics.total_annualised_cost);
+	EXPECT_EQ(fromMapping.comparison.cost_balance, fromJson.comparison.cost_balance);
+
+	EXPECT_THROW(mapSiteDataBinary(dir / "missing.epochsd"), std::exception);
+}
+
+TEST_F(SiteDataBinaryTest, ViewsPointIntoTheMapping) {
+	SiteData json = readSiteData(fs::path{ "./test_files/siteData_MountHotel.json" });
+	writeSiteDataBinary(json, binaryPath);
+
+	SiteDataView view(binaryPath);
+	EXPECT_EQ(view.timesteps(), json.timesteps);
+	EXPECT_EQ(view.header().num_import_tariffs, json.import_tariffs.size());
+
+	auto grid_co2 = view.grid_co2();
+	EXPECT_EQ(reinterpret_cast<uintptr_t>(grid_co2.data()) % SITE_DATA_BINARY_ALIGNMENT, 0);
+	EXPECT_TRUE(grid_co2 == json.grid_co2);
+
+	auto tariff = view.import_tariff(json.import_tariffs.size() - 1);
+	EXPECT_EQ(reinterpret_cast<uintptr_t>(tariff.data()) % SITE_DATA_BINARY_ALIGNMENT, 0);
+	EXPECT_TRUE(tariff == json.import_tariffs.back());
+
+	EXPECT_TRUE(view.ashp_output_table() == json.ashp_output_table);
+	EXPECT_THROW(view.solar_yield(json.solar_yields.size()), std::out_of_range);
+}
+
+TEST_F(SiteDataBinaryTest, RejectsUnsupportedVersion) {
+	writeSiteDataBinary(readSiteData(fs::path{ "./test_files/siteData_MountHotel.json" }), binaryPath);
+
+	// overwrite the version, which immediately follows the magic bytes
+	{
+		std::fstream f(binaryPath, std::ios::in | std::ios::out | std::ios::binary);
+		f.seekp(SITE_DATA_BINARY_MAGIC.size());
+		uint32_t version = SITE_DATA_BINARY_VERSION + 1;
+		f.write(reinterpret_cast<const char*>(&version), sizeof(version));
+	}
+	EXPECT_THROW(readSiteData(binaryPath), std::runtime_error);
+}
+
+TEST_F(SiteDataBinaryTest, RejectsTruncatedFile) {
+	writeSiteDataBinary(readSiteData(fs::path{ "./test_files/siteData_MountHotel.json" }), binaryPath);
+	fs::resize_file(binaryPath, fs::file_size(binaryPath) - SITE_DATA_BINARY_ALIGNMENT);
+
+	EXPECT_THROW(readSiteData(binaryPath), std::runtime_error);
+}
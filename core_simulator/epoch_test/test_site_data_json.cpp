@@ -141,3 +141,66 @@ TEST(SiteDataJSONTest, FromFile)
     EXPECT_EQ(sd.ashp_input_table.rows(), 2);
     EXPECT_EQ(sd.ashp_input_table(1,1), 6.0f);
 }
+
+TEST(SiteDataJSONTest, TariffPatternIsExpanded)
+{
+    // 48 hourly timesteps, with the second tariff written as night and day bands
+    json j = makeNHourSiteData(48);
+    j["import_tariffs"][1] = {
+        {"period_hours", 24},
+        {"bands", {{{"hours", 7}, {"price", 0.1}}, {{"hours", 17}, {"price", 0.3}}}}
+    };
+
+    SiteData sd = j.get<SiteData>();
+    ASSERT_EQ(sd.import_tariffs.size(), 2);
+    expectEigenVectorsEqual(sd.import_tariffs[0], Eigen::VectorXf::Ones(48));
+    ASSERT_EQ(sd.import_tariffs[1].size(), 48);
+    EXPECT_FLOAT_EQ(sd.import_tariffs[1][0], 0.1f);
+    EXPECT_FLOAT_EQ(sd.import_tariffs[1][7], 0.3f);
+    EXPECT_FLOAT_EQ(sd.import_tariffs[1][24 + 6], 0.1f);
+    EXPECT_FLOAT_EQ(sd.import_tariffs[1][47], 0.3f);
+
+    // and it is found again from the dense tariff
+    auto pattern = sd.importTariffPattern(1);
+    ASSERT_TRUE(pattern.has_value());
+    EXPECT_EQ(pattern->bands().size(), 2);
+    EXPECT_EQ(pattern->bands()[0].length, 7);
+}
+
+TEST(SiteDataJSONTest, TariffPatternMustBeWholeTimesteps)
+{
+    json j = makeNHourSiteData(48);
+    j["import_tariffs"][0] = {
+        {"bands", {{{"hours", 6.5}, {"price", 0.1}}, {{"hours", 17.5}, {"price", 0.3}}}}
+    };
+    EXPECT_THROW(j.get<SiteData>(), std::runtime_error);
+
+    // nor can the bands fall short of the period
+    j["import_tariffs"][0] = {
+        {"bands", {{{"hours", 7}, {"price", 0.1}}, {{"hours", 16}, {"price", 0.3}}}}
+    };
+    EXPECT_THROW(j.get<SiteData>(), std::runtime_error);
+}
+
+TEST(SiteDataJSONTest, FabricDeltaIsRelativeToBuildingHload)
+{
+    json j = makeNHourSiteData(4);
+    j["building_hload"] = { 2.0f, 4.0f, 6.0f, 8.0f };
+    j["fabric_interventions"][0].erase("reduced_hload");
+    j["fabric_interventions"][0]["hload_delta"] = { {"scale", 0.5}, {"index", {3}}, {"value", {1.0}} };
+
+    SiteData sd = j.get<SiteData>();
+    const FabricIntervention& fi = sd.fabric_interventions[0];
+    ASSERT_TRUE(fi.hload_delta.has_value());
+    EXPECT_EQ(fi.reduced_hload.size(), 0);
+    expectEigenVectorsEqual(fi.heatLoad(), toEigen(std::vector<float>{1.0f, 2.0f, 3.0f, 1.0f}));
+
+    // and it is written back as a delta
+    json written = sd;
+    EXPECT_FALSE(written["fabric_interventions"][0].contains("reduced_hload"));
+    EXPECT_EQ(written["fabric_interventions"][0]["hload_delta"]["index"], json({3}));
+
+    // an override beyond the timeseries is rejected
+    j["fabric_interventions"][0]["hload_delta"]["index"] = { 4 };
+    EXPECT_THROW(j.get<SiteData>(), std::runtime_error);
+}
@@ -0,0 +1,122 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <memory>
+#include <stdexcept>
+
+#include <Eigen/Core>
+
+#include "../epoch_lib/Simulation/Simulate.hpp"
+#include "../epoch_lib/Simulation/SiteUpdate.hpp"
+#include "../epoch_lib/io/FileHandling.hpp"
+
+namespace fs = std::filesystem;
+
+class SiteUpdateTest : public ::testing::Test {
+protected:
+	std::shared_ptr<const SiteData> siteData;
+	TaskData taskData;
+
+	SiteUpdateTest() :
+		siteData(std::make_shared<const SiteData>(readSiteData(fs::path{ "./test_files/siteData_MountHotel.json" }))),
+		taskData(readTaskData(fs::path{ "./test_files/taskData_full.json" }))
+	{}
+
+	// the result of a Simulator built from scratch with the updated SiteData
+	SimulationResult fromScratch(const Simulator& updated, const TaskData& scenario) const {
+		return Simulator(updated.getSiteData(), TaskConfig{}).simulateScenario(scenario);
+	}
+};
+
+TEST_F(SiteUpdateTest, AddedTariffMatchesANewSimulator) {
+	Simulator simulator(siteData, TaskConfig{});
+	simulator.enableResultCache(size_t{ 1 } << 20);
+	const SimulatorBaseline baseline = simulator.getBaseline();
+
+	const size_t added = siteData->import_tariffs.size();
+	auto updated = simulator.withSiteUpdate(SiteUpdate{}.addImportTariff(year_TS(siteData->import_tariffs[0] * 1.5f)));
+	ASSERT_EQ(updated->getSiteData()->import_tariffs.size(), added + 1);
+
+	// the baseline doesn't use the new tariff, so is shared
+	EXPECT_TRUE(updated->hasBaseline());
+	EXPECT_EQ(updated->getBaseline().reportData, baseline.reportData);
+	// as are the statistics of the existing tariffs
+	EXPECT_EQ(&updated->getTariffStats(0), &simulator.getTariffStats(0));
+	EXPECT_EQ(&updated->getAmbientHeatPumpProfile(), &simulator.getAmbientHeatPumpProfile());
+
+	TaskData onNewTariff = taskData;
+	onNewTariff.grid->tariff_index = added;
+	const SimulationResult result = updated->simulateScenario(onNewTariff);
+	const SimulationResult expected = fromScratch(*updated, onNewTariff);
+	EXPECT_EQ(result.metrics.total_electricity_import_cost, expected.metrics.total_electricity_import_cost);
+	EXPECT_EQ(result.comparison.cost_balance, expected.comparison.cost_balance);
+	EXPECT_GT(result.metrics.total_electricity_import_cost, simulator.simulateScenario(taskData).metrics.total_electricity_import_cost);
+
+	// the cache is enabled again, but empty
+	ASSERT_TRUE(updated->getResultCacheStats().has_value());
+	EXPECT_EQ(updated->getResultCacheStats()->hits, 0u);
+
+	// and the original Simulator is unchanged
+	EXPECT_EQ(simulator.getSiteData(), siteData);
+}
+
+TEST_F(SiteUpdateTest, ReplacingAColumnTheBaselineReadsSimulatesItAgain) {
+	Simulator simulator(siteData, TaskConfig{});
+	simulator.getBaseline();
+
+	const size_t baselineTariff = siteData->baseline.grid ? siteData->baseline.grid->tariff_index : 0;
+	SiteUpdate update;
+	update.replace(SiteColumn::ImportTariff, year_TS(siteData->import_tariffs[baselineTariff] * 2.0f), baselineTariff);
+	ASSERT_TRUE(update.affects(siteData->baseline));
+
+	auto updated = simulator.withSiteUpdate(update);
+	EXPECT_FALSE(updated->hasBaseline());
+	EXPECT_NE(&updated->getTariffStats(baselineTariff), &simulator.getTariffStats(baselineTariff));
+
+	const SimulationResult result = updated->simulateScenario(taskData);
+	const SimulationResult expected = fromScratch(*updated, taskData);
+	EXPECT_EQ(result.baseline_metrics.total_electricity_import_cost, expected.baseline_metrics.total_electricity_import_cost);
+	EXPECT_EQ(result.comparison.cost_balance, expected.comparison.cost_balance);
+	EXPECT_GT(result.baseline_metrics.total_electricity_import_cost, simulator.simulateScenario(taskData).baseline_metrics.total_electricity_import_cost);
+
+	// a replaced demand is read by every scenario
+	const SiteUpdate byName = SiteUpdate{}.replace("building_eload", year_TS(siteData->building_eload * 1.1f));
+	EXPECT_TRUE(byName.affects(TaskData{}));
+	auto refreshed = updated->withSiteUpdate(byName);
+	EXPECT_FALSE(refreshed->hasBaseline());
+	EXPECT_EQ(refreshed->simulateScenario(taskData).metrics.total_electricity_imported,
+		fromScratch(*refreshed, taskData).metrics.total_electricity_imported);
+}
+
+TEST_F(SiteUpdateTest, OnlyScenariosReadingAColumnAreAffected) {
+	TaskData withoutEV = taskData;
+	withoutEV.electric_vehicles.reset();
+	const SiteUpdate evUpdate = SiteUpdate{}.replace(SiteColumn::EvEload, siteData->ev_eload);
+	EXPECT_TRUE(evUpdate.affects(taskData));
+	EXPECT_FALSE(evUpdate.affects(withoutEV));
+
+	ASSERT_FALSE(taskData.solar_panels.empty());
+	const auto yieldIndex = static_cast<size_t>(taskData.solar_panels[0].yield_index);
+	const SiteUpdate solarUpdate = SiteUpdate{}.replace(SiteColumn::SolarYield, siteData->solar_yields[yieldIndex], yieldIndex);
+	EXPECT_TRUE(solarUpdate.affects(taskData));
+	EXPECT_FALSE(solarUpdate.affects(TaskData{}));
+
+	EXPECT_FALSE(SiteUpdate{}.addSolarYield(siteData->solar_yields[0]).affects(taskData));
+}
+
+TEST_F(SiteUpdateTest, RejectsAnInvalidUpdate) {
+	Simulator simulator(siteData, TaskConfig{});
+	SiteUpdate update;
+	EXPECT_THROW(update.replace("import_tariffs", siteData->import_tariffs[0]), std::invalid_argument);
+	EXPECT_THROW(update.replace("grid_co2[0]", siteData->grid_co2), std::invalid_argument);
+	EXPECT_THROW(update.replace("wind_speed", siteData->grid_co2), std::invalid_argument);
+
+	const SiteUpdate outOfRange = SiteUpdate{}.replace(SiteColumn::ImportTariff, siteData->import_tariffs[0], siteData->import_tariffs.size());
+	EXPECT_THROW(simulator.withSiteUpdate(outOfRange), std::invalid_argument);
+
+	const SiteUpdate tooShort = SiteUpdate{}.addImportTariff(Eigen::VectorXf::Ones(3));
+	EXPECT_THROW(simulator.withSiteUpdate(tooShort), std::runtime_error);
+
+	EXPECT_EQ(siteColumnName(SiteColumn::SolarYield, 2), "solar_yields[2]");
+	EXPECT_EQ(siteColumnName(SiteColumn::GridCo2), "grid_co2");
+}
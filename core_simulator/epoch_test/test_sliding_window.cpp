@@ -0,0 +1,54 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <random>
+#include <stdexcept>
+
+#include <Eigen/Core>
+
+#include "../epoch_lib/Simulation/SlidingWindow.hpp"
+
+namespace {
+	// the minimum or maximum of each window, by scanning it
+	Eigen::VectorXf naive(const Eigen::VectorXf& values, size_t window, bool minimum) {
+		Eigen::VectorXf result(values.size());
+		for (Eigen::Index t = 0; t < values.size(); t++) {
+			const Eigen::Index length = std::min(static_cast<Eigen::Index>(window), values.size() - t);
+			result[t] = minimum ? values.segment(t, length).minCoeff() : values.segment(t, length).maxCoeff();
+		}
+		return result;
+	}
+}
+
+TEST(SlidingWindow, MatchesAScanOfEachWindow) {
+	std::mt19937 rng(3);
+	// few distinct values, so there are many ties
+	std::uniform_int_distribution<int> dist(0, 5);
+	Eigen::VectorXf values(200);
+	for (Eigen::Index i = 0; i < values.size(); i++) {
+		values[i] = static_cast<float>(dist(rng));
+	}
+
+	for (size_t window : { 1, 2, 7, 48, 200, 500 }) {
+		SCOPED_TRACE(window);
+		EXPECT_EQ(slidingWindowMin(values, window), naive(values, window, true));
+		EXPECT_EQ(slidingWindowMax(values, window), naive(values, window, false));
+	}
+}
+
+TEST(SlidingWindow, WindowIsTheTimestepsAhead) {
+	Eigen::VectorXf values(5);
+	values << 3.0f, 1.0f, 4.0f, 1.5f, 5.0f;
+
+	Eigen::VectorXf expectedMin(5);
+	expectedMin << 1.0f, 1.0f, 1.5f, 1.5f, 5.0f;
+	EXPECT_EQ(slidingWindowMin(values, 2), expectedMin);
+
+	Eigen::VectorXf expectedMax(5);
+	expectedMax << 4.0f, 4.0f, 5.0f, 5.0f, 5.0f;
+	EXPECT_EQ(slidingWindowMax(values, 3), expectedMax);
+
+	EXPECT_EQ(slidingWindowMin(Eigen::VectorXf{}, 4).size(), 0);
+	EXPECT_THROW(slidingWindowMin(values, 0), std::runtime_error);
+}
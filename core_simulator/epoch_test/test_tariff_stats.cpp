@@ -3,6 +3,7 @@
 
 #include "test_helpers.hpp"
 #include "../epoch_lib/Simulation/DayTariffStats.hpp"
+#include "../epoch_lib/Simulation/TariffPattern.hpp"
 
 TEST(TariffStats, FixedPrice) {
 	// Contains a tariff of Eigen::Ones
@@ -22,12 +23,14 @@ TEST(TariffStats, DynamicPrice) {
 	// but it makes for a simple test construction
 
 	// add some higher prices for the second tariff
-	sd.import_tariffs[1][9] = 3;
-	sd.import_tariffs[1][10] = 3;
-	sd.import_tariffs[1][11] = 3;
-	sd.import_tariffs[1][12] = 3;
-	sd.import_tariffs[1][13] = 3;
-	sd.import_tariffs[1][14] = 3;
+	year_TS tariff = sd.import_tariffs[1];
+	tariff[9] = 3;
+	tariff[10] = 3;
+	tariff[11] = 3;
+	tariff[12] = 3;
+	tariff[13] = 3;
+	tariff[14] = 3;
+	sd.import_tariffs[1] = tariff;
 
 	size_t tariff_index = 1;
 	DayTariffStats tariffStats{ sd, tariff_index };
@@ -49,7 +52,9 @@ TEST(TariffStats, Test25Hours) {
 	auto sd25 = makeNHourSiteData(25);
 	// we'll use the tariff at index 1 and make some modifications
 	size_t tariff_index = 1;
-	sd25.import_tariffs[tariff_index][24] = 100;
+	year_TS tariff = sd25.import_tariffs[tariff_index];
+	tariff[24] = 100;
+	sd25.import_tariffs[tariff_index] = tariff;
 
 	DayTariffStats tariffStats{ sd25, tariff_index };
 
@@ -105,7 +110,9 @@ TEST(TariffStats, TimestepsNonHourly) {
 	// the first 21 timesteps belong to the first day
 
 	// make a modification to day 2
-	sd.import_tariffs[0][22] = 100;
+	year_TS tariff = sd.import_tariffs[0];
+	tariff[22] = 100;
+	sd.import_tariffs[0] = tariff;
 
 	DayTariffStats tariffStats{ sd, 0 };
 
@@ -122,4 +129,167 @@ TEST(TariffStats, TimestepsNonHourly) {
 	EXPECT_EQ(tariffStats.getDayAverage(47), 1.0f);
 	EXPECT_EQ(tariffStats.getDayPercentile(47), 1.0f);
 
-}
\ No newline at end of file
+}
+TEST(TariffStats, HalfHourlyDayBoundaries) {
+	// 96 half-hourly timesteps span exactly two days
+	auto sdBase = makeNHourSiteData(96);
+	SiteData sd(
+		sdBase.start_ts,
+		sdBase.start_ts + std::chrono::hours(48),
+		TaskData{},
+		sdBase.building_eload,
+		sdBase.building_hload,
+		sdBase.peak_hload,
+		sdBase.ev_eload,
+		sdBase.dhw_demand,
+		sdBase.air_temperature,
+		sdBase.grid_co2,
+		sdBase.solar_yields,
+		sdBase.import_tariffs,
+		sdBase.fabric_interventions,
+		sdBase.ashp_input_table,
+		sdBase.ashp_output_table
+	);
+
+	// make the whole of the second day more expensive
+	year_TS tariff = sd.import_tariffs[0];
+	tariff.tail(48).setConstant(2.0f);
+	sd.import_tariffs[0] = tariff;
+
+	DayTariffStats tariffStats{ sd, 0 };
+
+	EXPECT_EQ(tariffStats.getDayAverage(0), 1.0f);
+	EXPECT_EQ(tariffStats.getDayAverage(47), 1.0f);
+	EXPECT_EQ(tariffStats.getDayAverage(48), 2.0f);
+	EXPECT_EQ(tariffStats.getDayPercentile(95), 2.0f);
+}
+
+TEST(TariffStats, LowPriceMask) {
+	auto sd = makeNHourSiteData(48);
+
+	// make the evening of the first day expensive
+	year_TS tariff = sd.import_tariffs[0];
+	tariff.segment(16, 8).setConstant(3.0f);
+	sd.import_tariffs[0] = tariff;
+
+	DayTariffStats tariffStats{ sd, 0 };
+
+	for (size_t t = 0; t < sd.timesteps; t++) {
+		bool expected = tariff[t] <= tariffStats.getDayAverage(t) && tariff[t] <= tariffStats.getDayPercentile(t);
+		EXPECT_EQ(tariffStats.isLowPrice(t), expected) << "timestep " << t;
+	}
+	EXPECT_TRUE(tariffStats.isLowPrice(0));
+	EXPECT_FALSE(tariffStats.isLowPrice(20));
+	// a fixed price day is low at every timestep
+	EXPECT_TRUE(tariffStats.isLowPrice(30));
+}
+
+TEST(TariffStats, TopUpMask) {
+	auto sd = makeNHourSiteData(48);
+
+	// make the evening of the first day expensive
+	year_TS tariff = sd.import_tariffs[0];
+	tariff.segment(16, 8).setConstant(3.0f);
+	sd.import_tariffs[0] = tariff;
+
+	DayTariffStats tariffStats{ sd, 0 };
+
+	for (size_t t = 0; t < sd.timesteps; t++) {
+		bool expected = tariff[t] < tariffStats.getDayAverage(t) && tariff[t] <= tariffStats.getDayPercentile(t);
+		EXPECT_EQ(tariffStats.isTopUpEligible(t), expected) << "timestep " << t;
+	}
+	EXPECT_TRUE(tariffStats.isTopUpEligible(0));
+	EXPECT_FALSE(tariffStats.isTopUpEligible(20));
+	// a fixed price day is never below its average
+	EXPECT_FALSE(tariffStats.isTopUpEligible(30));
+}
+
+TEST(TariffStats, LookaheadMasks) {
+	auto sd = makeNHourSiteData(48);
+
+	// a dip at 03:00 and a peak at 06:00 on the second day, against a flat price
+	year_TS tariff = year_TS::Constant(48, 2.0f);
+	tariff[3] = 1.0f;
+	tariff[30] = 3.0f;
+	sd.import_tariffs[0] = tariff;
+
+	DayTariffStats tariffStats{ sd, 0 };
+
+	for (size_t t = 0; t < sd.timesteps; t++) {
+		// the 24 hours from t are [t, t + 24)
+		bool expected = t == 3 || (t >= 7 && t < 30);
+		EXPECT_EQ(tariffStats.isLookaheadCheapest(t), expected) << "timestep " << t;
+		// the grid carbon is flat, so no timestep is lower than the rest
+		EXPECT_FALSE(tariffStats.isLookaheadLowCarbon(t));
+	}
+}
+
+TEST(TariffPattern, DetectsDailyBands) {
+	// night, day and evening prices, repeated for three days
+	year_TS tariff = year_TS::Constant(72, 0.2f);
+	for (int day = 0; day < 3; day++) {
+		tariff.segment(day * 24, 7).setConstant(0.1f);
+		tariff.segment(day * 24 + 16, 3).setConstant(0.4f);
+	}
+
+	auto pattern = TariffPattern::detect(tariff, 24);
+	ASSERT_TRUE(pattern.has_value());
+	EXPECT_EQ(pattern->period(), 24);
+	ASSERT_EQ(pattern->bands().size(), 4);
+	EXPECT_EQ(pattern->bands()[0].length, 7);
+	EXPECT_EQ(pattern->bands()[0].price, 0.1f);
+	EXPECT_EQ(pattern->bands()[2].price, 0.4f);
+	EXPECT_EQ(pattern->expand(72), tariff);
+
+	// a day that differs isn't a pattern, and neither is one with too many bands
+	year_TS changed = tariff;
+	changed[50] = 0.3f;
+	EXPECT_FALSE(TariffPattern::detect(changed, 24).has_value());
+	EXPECT_FALSE(TariffPattern::detect(tariff, 24, 3).has_value());
+	// nor is a tariff shorter than the period
+	EXPECT_FALSE(TariffPattern::detect(tariff.head(23), 24).has_value());
+}
+
+TEST(TariffPattern, PricesEachBandOnItsImport) {
+	const TariffPattern pattern({ { 2, 0.1f }, { 1, 0.5f } });
+	Eigen::VectorXd phaseImport(3);
+	phaseImport << 1.0, 2.0, 4.0;
+	EXPECT_NEAR(pattern.price(phaseImport), 0.1 * 3.0 + 0.5 * 4.0, 1e-6);
+
+	EXPECT_THROW(TariffPattern({ { 0, 0.1f } }), std::invalid_argument);
+}
+
+TEST(TariffStats, DailyPatternMatchesEachDay) {
+	auto sd = makeNHourSiteData(72);
+	year_TS tariff = year_TS::Ones(72);
+	for (int day = 0; day < 3; day++) {
+		tariff.segment(day * 24 + 16, 8).setConstant(3.0f);
+	}
+	sd.import_tariffs[0] = tariff;
+	ASSERT_TRUE(sd.importTariffPattern(0).has_value());
+
+	DayTariffStats tariffStats{ sd, 0 };
+	for (size_t t = 0; t < sd.timesteps; t++) {
+		EXPECT_FLOAT_EQ(tariffStats.getDayAverage(t), (16.0f + 24.0f) / 24.0f) << "timestep " << t;
+		EXPECT_EQ(tariffStats.getDayPercentile(t), 1.0f);
+		bool low = tariff[t] <= tariffStats.getDayAverage(t) && tariff[t] <= tariffStats.getDayPercentile(t);
+		bool topUp = tariff[t] < tariffStats.getDayAverage(t) && tariff[t] <= tariffStats.getDayPercentile(t);
+		EXPECT_EQ(tariffStats.isLowPrice(t), low) << "timestep " << t;
+		EXPECT_EQ(tariffStats.isTopUpEligible(t), topUp) << "timestep " << t;
+	}
+}
+
+TEST(TariffStats, DailyPatternWithPartialDay) {
+	auto sd = makeNHourSiteData(30);
+	year_TS tariff = year_TS::Ones(30);
+	tariff.segment(16, 8).setConstant(3.0f);
+	sd.import_tariffs[0] = tariff;
+	ASSERT_TRUE(sd.importTariffPattern(0).has_value());
+
+	DayTariffStats tariffStats{ sd, 0 };
+	EXPECT_FLOAT_EQ(tariffStats.getDayAverage(0), 40.0f / 24.0f);
+	// the six hours of the second day are all at the cheaper price
+	EXPECT_EQ(tariffStats.getDayAverage(29), 1.0f);
+	EXPECT_TRUE(tariffStats.isLowPrice(29));
+	EXPECT_FALSE(tariffStats.isTopUpEligible(29));
+}
@@ -1,8 +1,11 @@
 #include <cmath>
+#include <functional>
+#include <stdexcept>
 
 #include <gtest/gtest.h>
 
 #include "test_helpers.hpp"
+#include "../epoch_lib/Simulation/ScenarioKey.hpp"
 #include "../epoch_lib/Simulation/TaskData.hpp"
 #include "../epoch_lib/Simulation/Costs/Capex.hpp"
 
@@ -38,4 +41,82 @@ TEST_F(TaskDataTest, CalculateNonEmptiesEqualHash) {
     EXPECT_NE(hasher(td1), hasher(td2));
 
     EXPECT_NE(td1, td2);
-}
\ No newline at end of file
+}
+
+TEST_F(TaskDataTest, ScenarioKeyIsStable) {
+    // the key must never change between builds, processes or platforms, as it can key a cache shared between them
+    TaskData td = {};
+    EXPECT_EQ(canonicalEncoding(td).size(), 1 + 9 + 8);
+    EXPECT_EQ(scenarioKey(td).toHex(), "7a36f2c9c1360eb6329498723efab97b");
+
+    td.building = Building{};
+    td.energy_storage_system = EnergyStorageSystem{};
+    td.solar_panels.push_back(SolarData{});
+    EXPECT_EQ(scenarioKey(td).toHex(), "b4c39170fef5018f1790bb9f1331728a");
+}
+
+TEST_F(TaskDataTest, ScenarioKeyMatchesEquality) {
+    TaskData td1 = {};
+    TaskData td2 = {};
+    td1.grid = GridData{};
+    td2.grid = GridData{};
+    td1.grid->export_tariff = 0.0f;
+    td2.grid->export_tariff = -0.0f;
+    ASSERT_EQ(td1, td2);
+    EXPECT_EQ(scenarioKey(td1), scenarioKey(td2));
+    EXPECT_EQ(std::hash<TaskData>{}(td1), std::hash<TaskData>{}(td2));
+
+    // the order of the solar panels matters
+    SolarData first{};
+    SolarData second{};
+    second.yield_index = 1;
+    td1.solar_panels = { first, second };
+    td2.solar_panels = { second, first };
+    EXPECT_NE(scenarioKey(td1), scenarioKey(td2));
+
+    // as does whether a component is present at all, even with the same values
+    TaskData empty = {};
+    TaskData withMop = {};
+    withMop.mop = MopData{};
+    EXPECT_NE(scenarioKey(empty), scenarioKey(withMop));
+}
+
+TEST_F(TaskDataTest, ScenarioKeyQuantisesFloats) {
+    TaskData td1 = {};
+    TaskData td2 = {};
+    td1.energy_storage_system = EnergyStorageSystem{};
+    td2.energy_storage_system = EnergyStorageSystem{};
+    td2.energy_storage_system->capacity = std::nextafter(td1.energy_storage_system->capacity, 100.0f);
+
+    EXPECT_NE(scenarioKey(td1), scenarioKey(td2));
+    EXPECT_EQ(scenarioKey(td1, KeyQuantisation{ 16 }), scenarioKey(td2, KeyQuantisation{ 16 }));
+    EXPECT_NE(canonicalEncoding(td1), canonicalEncoding(td2));
+    EXPECT_EQ(canonicalEncoding(td1, KeyQuantisation{ 16 }), canonicalEncoding(td2, KeyQuantisation{ 16 }));
+
+    // a real difference survives the quantisation
+    td2.energy_storage_system->capacity = 21.0f;
+    EXPECT_NE(scenarioKey(td1, KeyQuantisation{ 16 }), scenarioKey(td2, KeyQuantisation{ 16 }));
+
+    EXPECT_THROW(scenarioKey(td1, KeyQuantisation{ 24 }), std::invalid_argument);
+}
+
+TEST_F(TaskDataTest, ScenarioKeyHashesTheCanonicalEncoding) {
+    TaskData td = {};
+    td.building = Building{};
+    td.data_centre = DataCentreData{};
+    td.domestic_hot_water = DomesticHotWater{};
+    td.electric_vehicles = ElectricVehicles{};
+    td.energy_storage_system = EnergyStorageSystem{};
+    td.gas_heater = GasCHData{};
+    td.grid = GridData{};
+    td.heat_pump = HeatPumpData{};
+    td.mop = MopData{};
+
+    // (many panels, to go beyond the stack buffer the key is found in)
+    for (size_t panels : { 0, 3, 40 }) {
+        td.solar_panels.resize(panels);
+        const auto bytes = canonicalEncoding(td);
+        EXPECT_EQ(bytes.size(), 248 + 17 * panels);
+        EXPECT_EQ(scenarioKey(td), murmurHash128(bytes.data(), bytes.size()));
+    }
+}
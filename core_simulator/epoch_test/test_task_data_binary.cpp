@@ -0,0 +1,105 @@
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <nlohmann/json.hpp>
+
+#include "../epoch_lib/io/FileHandling.hpp"
+#include "../epoch_lib/io/TaskDataBinary.hpp"
+#include "../epoch_lib/io/TaskDataJson.hpp"
+
+namespace fs = std::filesystem;
+
+namespace {
+	TaskData roundTrip(const TaskData& taskData) {
+		std::vector<std::byte> record(TASK_DATA_RECORD_SIZE);
+		encodeTaskDataRecord(taskData, std::span<std::byte, TASK_DATA_RECORD_SIZE>(record.data(), TASK_DATA_RECORD_SIZE));
+		return decodeTaskDataRecord(std::span<const std::byte, TASK_DATA_RECORD_SIZE>(record.data(), TASK_DATA_RECORD_SIZE));
+	}
+}
+
+TEST(SolarPanels, SpillsOntoTheHeapOnlyWhenFull) {
+	SolarPanels panels;
+	for (int i = 0; i < static_cast<int>(SolarPanels::inline_capacity); i++) {
+		panels.push_back(SolarData{ 1.0f, i });
+	}
+	EXPECT_FALSE(panels.onHeap());
+	EXPECT_EQ(panels.heapBytes(), 0u);
+
+	panels.push_back(SolarData{ 2.0f, 9 });
+	EXPECT_TRUE(panels.onHeap());
+	ASSERT_EQ(panels.size(), SolarPanels::inline_capacity + 1);
+	EXPECT_EQ(panels[0].yield_index, 0);
+	EXPECT_EQ(panels.back().yield_index, 9);
+
+	// erasing moves the values back inline, in order
+	panels.erase(panels.begin() + 1);
+	EXPECT_FALSE(panels.onHeap());
+	ASSERT_EQ(panels.size(), SolarPanels::inline_capacity);
+	EXPECT_EQ(panels[1].yield_index, 2);
+	EXPECT_EQ(panels.back().yield_index, 9);
+
+	const SolarPanels copy = panels;
+	EXPECT_EQ(copy, panels);
+	panels.resize(1);
+	EXPECT_NE(copy, panels);
+	EXPECT_EQ(std::span<const SolarData>(panels).size(), 1u);
+}
+
+TEST(TaskDataBinary, RecordsRoundTrip) {
+	for (const char* name : { "taskData_empty.json", "taskData_common.json", "taskData_full.json" }) {
+		SCOPED_TRACE(name);
+		const TaskData taskData = readTaskData(fs::path{ "./test_files" } / name);
+		EXPECT_EQ(roundTrip(taskData), taskData);
+	}
+
+	// every optional field, with values that aren't the defaults
+	TaskData taskData;
+	taskData.building = Building{ 2.0f, 0.5f, 3, 120.0f, true, 4.0f, 30.0f };
+	taskData.energy_storage_system = EnergyStorageSystem{ 50.0f, 20.0f, 25.0f, BatteryMode::CARBON_LOOKAHEAD, 10.0f };
+	taskData.gas_heater = GasCHData{ 30.0f, 0.8f, GasType::LIQUID_PETROLEUM_GAS };
+	taskData.heat_pump = HeatPumpData{ 15.0f, HeatSource::HOTROOM };
+	taskData.solar_panels = { SolarData{ 5.0f, -1 }, SolarData{ 7.5f, 2, true } };
+	EXPECT_EQ(roundTrip(taskData), taskData);
+}
+
+TEST(TaskDataBinary, BatchesRoundTrip) {
+	std::vector<TaskData> tasks;
+	for (const char* name : { "taskData_empty.json", "taskData_common.json", "taskData_full.json" }) {
+		tasks.push_back(readTaskData(fs::path{ "./test_files" } / name));
+	}
+
+	const std::vector<std::byte> bytes = encodeTaskDataBatch(tasks);
+	EXPECT_EQ(bytes.size(), sizeof(TaskDataBatchHeader) + tasks.size() * TASK_DATA_RECORD_SIZE);
+	EXPECT_EQ(decodeTaskDataBatch(bytes), tasks);
+	EXPECT_TRUE(decodeTaskDataBatch(encodeTaskDataBatch({})).empty());
+}
+
+TEST(TaskDataBinary, RejectsWhatItCannotHold) {
+	TaskData taskData;
+	taskData.solar_panels.resize(TASK_DATA_RECORD_SOLAR_PANELS + 1);
+	EXPECT_FALSE(hasTaskDataRecord(taskData));
+	EXPECT_THROW(encodeTaskDataBatch({ &taskData, 1 }), std::invalid_argument);
+
+	const std::vector<std::byte> bytes = encodeTaskDataBatch(std::vector<TaskData>(2));
+	EXPECT_THROW(decodeTaskDataBatch(std::span(bytes).first(bytes.size() - 1)), std::runtime_error);
+
+	// the first component's presence byte must be 0 or 1
+	std::vector<std::byte> corrupt = bytes;
+	corrupt[sizeof(TaskDataBatchHeader)] = std::byte{ 2 };
+	EXPECT_THROW(decodeTaskDataBatch(corrupt), std::runtime_error);
+
+	corrupt = bytes;
+	corrupt[0] = std::byte{ 'X' };
+	EXPECT_THROW(decodeTaskDataBatch(corrupt), std::runtime_error);
+}
+
+TEST(TaskDataBinary, JsonRoundTripsThroughSolarPanels) {
+	const TaskData taskData = readTaskData(fs::path{ "./test_files/taskData_full.json" });
+	ASSERT_FALSE(taskData.solar_panels.empty());
+	EXPECT_EQ(nlohmann::json(taskData).get<TaskData>(), taskData);
+}
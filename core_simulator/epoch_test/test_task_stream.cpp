@@ -0,0 +1,144 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "../epoch_lib/Simulation/Simulate.hpp"
+#include "../epoch_lib/Simulation/ThreadPool.hpp"
+#include "../epoch_lib/io/FileHandling.hpp"
+#include "../epoch_lib/io/TaskDataJson.hpp"
+#include "../epoch_lib/io/TaskStream.hpp"
+
+namespace fs = std::filesystem;
+using json = nlohmann::json;
+
+static std::string readCompact(const fs::path& path) {
+	std::ifstream in(path);
+	return json::parse(in).dump();
+}
+
+static std::vector<std::string> splitLines(const std::string& text) {
+	std::vector<std::string> lines;
+	std::istringstream in(text);
+	std::string line;
+	while (std::getline(in, line)) {
+		lines.push_back(line);
+	}
+	return lines;
+}
+
+static std::string lengthPrefixed(const std::string& message) {
+	const auto length = static_cast<uint32_t>(message.size());
+	std::string framed;
+	for (int shift = 0; shift < 32; shift += 8) {
+		framed.push_back(static_cast<char>((length >> shift) & 0xFF));
+	}
+	return framed + message;
+}
+
+class TaskStreamTest : public ::testing::Test {
+protected:
+	Simulator simulator;
+	ThreadPool pool{ 4 };
+	std::vector<std::string> tasks;
+
+	TaskStreamTest() :
+		simulator(readSiteData(fs::path{ "./test_files/siteData_MountHotel.json" }), TaskConfig{})
+	{
+		// enough tasks that several are in flight at once
+		for (int i = 0; i < 3; i++) {
+			tasks.push_back(readCompact("./test_files/taskData_empty.json"));
+			tasks.push_back(readCompact("./test_files/taskData_common.json"));
+			tasks.push_back(readCompact("./test_files/taskData_full.json"));
+		}
+	}
+
+	// the annualised cost differs between the three tasks, so identifies which task a result is for
+	float expectedCost(size_t i) const {
+		TaskData taskData = json::parse(tasks[i]).get<TaskData>();
+		return simulator.simulateScenario(taskData).metrics.total_annualised_cost;
+	}
+};
+
+TEST_F(TaskStreamTest, WritesResultsInOrder) {
+	std::string input;
+	for (const auto& task : tasks) {
+		input += task + "\n";
+	}
+
+	std::istringstream in(input);
+	std::ostringstream out;
+	serveTaskStream(simulator, in, out, pool, TaskStreamOptions{ StreamFraming::Lines, 2 });
+
+	auto lines = splitLines(out.str());
+	ASSERT_EQ(lines.size(), tasks.size());
+	for (size_t i = 0; i < lines.size(); i++) {
+		json result = json::parse(lines[i]);
+		EXPECT_EQ(result["metrics"]["total_annualised_cost"].get<float>(), expectedCost(i));
+	}
+}
+
+TEST_F(TaskStreamTest, ReportsInvalidTasksInPlace) {
+	std::istringstream in(tasks[0] + "\n\nnot json\n" + tasks[1] + "\n");
+	std::ostringstream out;
+	serveTaskStream(simulator, in, out, pool);
+
+	// the blank line is skipped
+	auto lines = splitLines(out.str());
+	ASSERT_EQ(lines.size(), 3);
+	EXPECT_FALSE(json::parse(lines[0]).contains("error"));
+	EXPECT_TRUE(json::parse(lines[1]).contains("error"));
+	EXPECT_EQ(json::parse(lines[2])["metrics"]["total_annualised_cost"].get<float>(), expectedCost(1));
+}
+
+TEST_F(TaskStreamTest, LengthPrefixedFraming) {
+	std::string input;
+	for (const auto& task : tasks) {
+		input += lengthPrefixed(task);
+	}
+
+	std::istringstream in(input);
+	std::ostringstream out;
+	serveTaskStream(simulator, in, out, pool, TaskStreamOptions{ StreamFraming::LengthPrefixed, 0 });
+
+	const std::string output = out.str();
+	size_t offset = 0;
+	for (size_t i = 0; i < tasks.size(); i++) {
+		ASSERT_LE(offset + 4, output.size());
+		uint32_t length = 0;
+		for (int b = 0; b < 4; b++) {
+			length |= static_cast<uint32_t>(static_cast<unsigned char>(output[offset + b])) << (8 * b);
+		}
+		offset += 4;
+		ASSERT_LE(offset + length, output.size());
+		json result = json::parse(output.substr(offset, length));
+		offset += length;
+		EXPECT_EQ(result["metrics"]["total_annualised_cost"].get<float>(), expectedCost(i));
+	}
+	EXPECT_EQ(offset, output.size());
+}
+
+TEST_F(TaskStreamTest, TruncatedFrameThrowsAfterEarlierResults) {
+	std::string input = lengthPrefixed(tasks[0]) + lengthPrefixed(tasks[1]);
+	input.resize(input.size() - 10);
+
+	std::istringstream in(input);
+	std::ostringstream out;
+	EXPECT_THROW(serveTaskStream(simulator, in, out, pool, TaskStreamOptions{ StreamFraming::LengthPrefixed, 0 }), std::runtime_error);
+
+	// the complete first task still has its result
+	EXPECT_GT(out.str().size(), 4);
+}
+
+TEST_F(TaskStreamTest, EmptyInputWritesNothing) {
+	std::istringstream in("");
+	std::ostringstream out;
+	serveTaskStream(simulator, in, out, pool);
+	EXPECT_TRUE(out.str().empty());
+}
@@ -0,0 +1,133 @@
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <Eigen/Core>
+#include <gtest/gtest.h>
+
+#include "../epoch_lib/Definitions.hpp"
+#include "../epoch_lib/io/TimeSeriesWriter.hpp"
+
+namespace fs = std::filesystem;
+
+namespace {
+	std::vector<std::string> readLines(const fs::path& path) {
+		std::ifstream in(path);
+		std::vector<std::string> lines;
+		std::string line;
+		while (std::getline(in, line)) {
+			lines.push_back(line);
+		}
+		return lines;
+	}
+
+	std::string firstCell(const std::string& row) {
+		return row.substr(0, row.find(','));
+	}
+}
+
+class TimeSeriesWriterTest : public ::testing::Test {
+protected:
+	void TearDown() override {
+		fs::remove(csv);
+	}
+
+	const fs::path csv = fs::temp_directory_path() / "epoch_timeseries_writer_test.csv";
+};
+
+TEST_F(TimeSeriesWriterTest, WritesAHeaderAndARowPerTimestep) {
+	ReportData report;
+	report.set(ReportColumn::Actual_import_shortfall, Eigen::VectorXf::LinSpaced(10, 0.0f, 9.0f));
+	writeTimeSeriesToCSV(csv, report);
+
+	auto lines = readLines(csv);
+	ASSERT_EQ(lines.size(), 11);
+	EXPECT_EQ(firstCell(lines[0]), "Actual_import_shortfall");
+	EXPECT_EQ(firstCell(lines[10]), "9.000000");
+}
+
+TEST_F(TimeSeriesWriterTest, FormatsValuesLikeToString) {
+	// the CSV has always been written with std::to_string
+	const std::vector<float> values = { 0.0f, -0.0f, 1.0f / 3.0f, -2.5f, 123456.789f, 1e-7f, 3.0e38f };
+	ReportData report;
+	report.set(ReportColumn::Actual_import_shortfall, Eigen::Map<const Eigen::VectorXf>(values.data(), values.size()));
+	writeTimeSeriesToCSV(csv, report);
+
+	auto lines = readLines(csv);
+	ASSERT_EQ(lines.size(), values.size() + 1);
+	for (size_t i = 0; i < values.size(); i++) {
+		EXPECT_EQ(firstCell(lines[i + 1]), std::to_string(values[i]));
+	}
+}
+
+TEST_F(TimeSeriesWriterTest, LeavesAbsentColumnsEmpty) {
+	ReportData report;
+	report.set(ReportColumn::Grid_Import, Eigen::VectorXf::Constant(2, 1.0f));
+	writeTimeSeriesToCSV(csv, report);
+
+	auto lines = readLines(csv);
+	ASSERT_EQ(lines.size(), 3);
+
+	// only the Grid_Import cell has a value
+	std::string expected;
+	for (size_t c = 0; c < TIMESERIES_COLUMNS.size(); c++) {
+		if (TIMESERIES_COLUMNS[c] == ReportColumn::Grid_Import) {
+			expected += "1.000000";
+		}
+		if (c + 1 < TIMESERIES_COLUMNS.size()) {
+			expected += ",";
+		}
+	}
+	EXPECT_EQ(lines[1], expected);
+	EXPECT_EQ(lines[2], expected);
+}
+
+TEST_F(TimeSeriesWriterTest, WritesMoreThanOneBuffer) {
+	// enough rows to flush the buffer many times over
+	const Eigen::Index timesteps = 200'000;
+	ReportData report;
+	report.set(ReportColumn::Grid_Import, Eigen::VectorXf::LinSpaced(timesteps, 0.0f, static_cast<float>(timesteps - 1)));
+	report.set(ReportColumn::Grid_Export, Eigen::VectorXf::Constant(timesteps, 2.0f));
+	writeTimeSeriesToCSV(csv, report);
+
+	auto lines = readLines(csv);
+	ASSERT_EQ(lines.size(), timesteps + 1);
+	for (Eigen::Index i : { Eigen::Index{ 0 }, Eigen::Index{ 54'321 }, timesteps - 1 }) {
+		EXPECT_EQ(firstCell(lines[i + 1]), "");
+		EXPECT_NE(lines[i + 1].find(std::to_string(static_cast<float>(i))), std::string::npos);
+	}
+}
+
+TEST_F(TimeSeriesWriterTest, ThrowsForAnUnwritablePath) {
+	ReportData report;
+	EXPECT_THROW(writeTimeSeriesToCSV(fs::path("no_such_directory") / "out.csv", report), std::runtime_error);
+}
+
+TEST_F(TimeSeriesWriterTest, ParquetNeedsArrow) {
+	if (parquetSupported()) {
+		GTEST_SKIP() << "Built with Parquet support";
+	}
+	ReportData report;
+	EXPECT_THROW(writeTimeSeries(fs::temp_directory_path() / "out.parquet", report, TimeSeriesFormat::Parquet), std::runtime_error);
+}
+
+TEST_F(TimeSeriesWriterTest, StreamAppendsBlocksAfterOneHeader) {
+	ReportData first;
+	first.set(ReportColumn::Grid_Import, Eigen::VectorXf::LinSpaced(4, 0.0f, 3.0f));
+	ReportData second;
+	second.set(ReportColumn::Grid_Import, Eigen::VectorXf::LinSpaced(3, 4.0f, 6.0f));
+
+	TimeSeriesCSVStream stream(csv);
+	stream.append(first);
+	stream.append(second);
+	stream.close();
+	auto streamed = readLines(csv);
+
+	ReportData whole;
+	whole.set(ReportColumn::Grid_Import, Eigen::VectorXf::LinSpaced(7, 0.0f, 6.0f));
+	writeTimeSeriesToCSV(csv, whole);
+	EXPECT_EQ(streamed, readLines(csv));
+	EXPECT_EQ(streamed.size(), 8);
+}
@@ -1,8 +1,12 @@
 #include <gtest/gtest.h>
 
+#include <cmath>
 #include <filesystem>
+#include <limits>
 #include <memory>
 
+#include "../epoch_lib/Simulation/PhaseTimer.hpp"
+#include "../epoch_lib/Simulation/Reductions.hpp"
 #include "../epoch_lib/Simulation/Simulate.hpp"
 #include "../epoch_lib/io/FileHandling.hpp"
 
@@ -77,3 +81,288 @@ TEST_F(EpochSimulationRun, FullTaskData) {
 	EXPECT_FLOAT_EQ(result.comparison.payback_horizon_years, 5.2370772f);
 	EXPECT_FLOAT_EQ(result.metrics.total_annualised_cost, 78988.258f);
 }
+
+TEST_F(EpochSimulationRun, ResultOnlyMatchesFullReporting) {
+	/**
+	* ResultOnly simulations accumulate their totals without building a ReportData
+	* They should produce exactly the same metrics as a FullReporting simulation
+	*/
+	TaskData task = readTaskData(fs::path{ "./test_files/taskData_full.json" });
+	auto resultOnly = simulator.simulateScenario(task, SimulationType::ResultOnly);
+	auto fullReporting = simulator.simulateScenario(task, SimulationType::FullReporting);
+
+	EXPECT_FALSE(resultOnly.report_data.has_value());
+	EXPECT_EQ(resultOnly.baseline_report_data, nullptr);
+	ASSERT_TRUE(fullReporting.report_data.has_value());
+	ASSERT_NE(fullReporting.baseline_report_data, nullptr);
+
+	// the baseline is shared rather than copied into each result
+	auto again = simulator.simulateScenario(task, SimulationType::FullReporting);
+	EXPECT_EQ(fullReporting.baseline_report_data, again.baseline_report_data);
+
+	const auto& a = resultOnly.metrics;
+	const auto& b = fullReporting.metrics;
+	EXPECT_EQ(a.total_gas_used, b.total_gas_used);
+	EXPECT_EQ(a.total_electricity_imported, b.total_electricity_imported);
+	EXPECT_EQ(a.total_electricity_generated, b.total_electricity_generated);
+	EXPECT_EQ(a.total_electricity_exported, b.total_electricity_exported);
+	EXPECT_EQ(a.total_electricity_curtailed, b.total_electricity_curtailed);
+	EXPECT_EQ(a.total_electrical_shortfall, b.total_electrical_shortfall);
+	EXPECT_EQ(a.total_heat_shortfall, b.total_heat_shortfall);
+	EXPECT_EQ(a.total_heat_load, b.total_heat_load);
+	EXPECT_EQ(a.total_meter_cost, b.total_meter_cost);
+	EXPECT_EQ(a.total_annualised_cost, b.total_annualised_cost);
+	EXPECT_EQ(a.total_scope_1_emissions, b.total_scope_1_emissions);
+	EXPECT_EQ(a.total_scope_2_emissions, b.total_scope_2_emissions);
+
+	// and the totals should agree with the reported timeseries (when summed in the same order)
+	const auto& report = fullReporting.report_data.value();
+	EXPECT_EQ(b.total_gas_used, seriesTotal(report.get(ReportColumn::GasCH_load)));
+	EXPECT_EQ(b.total_electricity_imported, blockSum(report.get(ReportColumn::Grid_Import)));
+	EXPECT_EQ(b.total_electricity_exported, blockSum(report.get(ReportColumn::Grid_Export)));
+	EXPECT_EQ(b.total_electricity_curtailed, blockSum(report.get(ReportColumn::Actual_curtailed_export)));
+	EXPECT_EQ(b.total_electrical_shortfall, blockSum(report.get(ReportColumn::Actual_import_shortfall)));
+	EXPECT_EQ(b.total_heat_shortfall, blockSum(report.get(ReportColumn::Heat_shortfall)));
+}
+
+TEST(Accumulation, WiderPoliciesReduceTheError) {
+	// a 5-minute year of small values, where a float running total loses precision
+	Eigen::VectorXf ts = Eigen::VectorXf::LinSpaced(105120, 0.01f, 3.0f);
+	ts.head(10).setConstant(1e5f);
+
+	double exact = 0.0;
+	for (float value : ts) {
+		exact += value;
+	}
+	auto error = [&](float total) { return std::abs(static_cast<double>(total) - exact); };
+
+	const float single = blockSum<Accumulation::Single>(ts);
+	const float wide = blockSum<Accumulation::Double>(ts);
+	const float compensated = blockSum<Accumulation::Compensated>(ts);
+
+	// double loses nothing but the final rounding to float
+	EXPECT_EQ(wide, static_cast<float>(exact));
+	EXPECT_LE(error(compensated), error(single));
+	EXPECT_LE(error(wide), error(compensated));
+
+	// and every policy agrees on a series total, whether of a vector or an expression
+	EXPECT_EQ(seriesTotal<Accumulation::Single>(ts), ts.sum());
+	EXPECT_EQ(seriesTotal<Accumulation::Double>(ts * 2.0f), blockSum<Accumulation::Double>(ts * 2.0f));
+	EXPECT_EQ(seriesTotal<Accumulation::Compensated>(ts), compensated);
+
+	Accumulator<Accumulation::Double> dot;
+	dot.addDot(ts, Eigen::VectorXf::Constant(ts.size(), 0.5f));
+	EXPECT_EQ(dot.value(), static_cast<float>(exact * 0.5));
+}
+
+TEST(SharedSiteData, SimulatorsShareOneSiteData) {
+	/**
+	* Several Simulators can be constructed from one SiteData without copying it
+	* and should produce the same results as a Simulator that owns its SiteData
+	*/
+	auto siteData = std::make_shared<const SiteData>(readSiteData(fs::path{ "./test_files/siteData_MountHotel.json" }));
+
+	Simulator first{ siteData, TaskConfig{} };
+	Simulator second{ first.getSiteData(), TaskConfig{} };
+	Simulator owning{ readSiteData(fs::path{ "./test_files/siteData_MountHotel.json" }), TaskConfig{} };
+
+	EXPECT_EQ(first.getSiteData().get(), siteData.get());
+	EXPECT_EQ(second.getSiteData().get(), siteData.get());
+	EXPECT_EQ(siteData.use_count(), 3);
+	EXPECT_GE(siteData->memoryFootprint(), siteData->timesteps * sizeof(float) * 6);
+
+	TaskData task = readTaskData(fs::path{ "./test_files/taskData_common.json" });
+	auto a = first.simulateScenario(task);
+	auto b = second.simulateScenario(task);
+	auto c = owning.simulateScenario(task);
+
+	EXPECT_EQ(a.metrics.total_annualised_cost, c.metrics.total_annualised_cost);
+	EXPECT_EQ(b.metrics.total_annualised_cost, c.metrics.total_annualised_cost);
+	EXPECT_EQ(a.comparison.cost_balance, c.comparison.cost_balance);
+	EXPECT_EQ(b.comparison.carbon_balance_scope_2, c.comparison.carbon_balance_scope_2);
+}
+
+TEST(SharedSiteData, RejectsNullSiteData) {
+	EXPECT_THROW(Simulator(std::shared_ptr<const SiteData>{}, TaskConfig{}), std::runtime_error);
+}
+
+TEST_F(EpochSimulationRun, PhaseTimings) {
+	TaskData task = readTaskData(fs::path{ "./test_files/taskData_full.json" });
+	auto result = simulator.simulateScenario(task);
+
+	if (!PHASE_TIMING_ENABLED) {
+		EXPECT_FALSE(result.timings.has_value());
+		return;
+	}
+
+	ASSERT_TRUE(result.timings.has_value());
+	const auto& t = result.timings.value();
+
+	// every component in the full TaskData should have recorded some time
+	EXPECT_GT(t.hotel, 0.0f);
+	EXPECT_GT(t.pv, 0.0f);
+	EXPECT_GT(t.balancing_loop, 0.0f);
+	EXPECT_GT(t.post_balancing, 0.0f);
+	EXPECT_GT(t.gas_ch, 0.0f);
+	EXPECT_GT(t.usage, 0.0f);
+	EXPECT_GE(t.metrics, t.npv);
+
+	float phases = t.validation + t.hotel + t.pv + t.ev + t.hot_water_cylinder + t.instant_water_heater
+		+ t.heat_pump + t.data_centre + t.ess + t.balancing_loop + t.gas_ch + t.post_balancing + t.totals
+		+ t.usage + t.metrics + t.comparison + t.capex;
+	EXPECT_LE(phases, result.runtime);
+}
+
+TEST_F(EpochSimulationRun, LockstepBatchMatchesSingleScenarios) {
+	/**
+	* simulateBatch balances scenarios with the same ESS/EV mix in lock-step
+	* Their results should be exactly those of simulating each scenario on its own
+	*/
+	TaskData full = readTaskData(fs::path{ "./test_files/taskData_full.json" });
+	TaskData base = full;
+	base.data_centre.reset();
+
+	std::vector<TaskData> batch;
+	for (float capacity : { 100.0f, 400.0f, 800.0f }) {
+		for (float flex : { 0.25f, 0.75f }) {
+			TaskData task = base;
+			task.energy_storage_system->capacity = capacity;
+			task.electric_vehicles->flexible_load_ratio = flex;
+			batch.push_back(task);
+
+			TaskData essOnly = task;
+			essOnly.electric_vehicles.reset();
+			batch.push_back(essOnly);
+
+			TaskData evOnly = task;
+			evOnly.energy_storage_system.reset();
+			batch.push_back(evOnly);
+		}
+	}
+	// and some that can't be balanced in lock-step
+	batch.push_back(full);
+	TaskData consumePlus = base;
+	consumePlus.energy_storage_system->battery_mode = BatteryMode::CONSUME_PLUS;
+	batch.push_back(consumePlus);
+
+	auto results = simulator.simulateBatch(batch);
+	ASSERT_EQ(results.size(), batch.size());
+
+	for (size_t i = 0; i < batch.size(); i++) {
+		auto single = simulator.simulateScenario(batch[i]);
+		const auto& a = results[i].metrics;
+		const auto& b = single.metrics;
+		EXPECT_EQ(a.total_electricity_imported, b.total_electricity_imported) << "scenario " << i;
+		EXPECT_EQ(a.total_electricity_exported, b.total_electricity_exported) << "scenario " << i;
+		EXPECT_EQ(a.total_electricity_curtailed, b.total_electricity_curtailed) << "scenario " << i;
+		EXPECT_EQ(a.total_electrical_shortfall, b.total_electrical_shortfall) << "scenario " << i;
+		EXPECT_EQ(a.total_gas_used, b.total_gas_used) << "scenario " << i;
+		EXPECT_EQ(a.total_annualised_cost, b.total_annualised_cost) << "scenario " << i;
+		EXPECT_EQ(results[i].comparison.cost_balance, single.comparison.cost_balance) << "scenario " << i;
+		EXPECT_EQ(results[i].comparison.carbon_balance_scope_2, single.comparison.carbon_balance_scope_2) << "scenario " << i;
+	}
+}
+
+TEST_F(EpochSimulationRun, CapexConstraintsSkipSimulation) {
+	TaskData task = readTaskData(fs::path{ "./test_files/taskData_full.json" });
+	auto full = simulator.simulateScenario(task);
+	const float capex = full.metrics.total_capex;
+	EXPECT_FALSE(full.violates_constraints);
+
+	// within the constraints, the scenario is simulated as normal
+	auto within = simulator.simulateScenario(task, SimulationType::ResultOnly, ScenarioConstraints{ .min_capex = capex - 1.0f, .max_capex = capex + 1.0f });
+	EXPECT_FALSE(within.violates_constraints);
+	EXPECT_EQ(within.metrics.total_annualised_cost, full.metrics.total_annualised_cost);
+	EXPECT_EQ(within.comparison.cost_balance, full.comparison.cost_balance);
+
+	// outside them, only the capex is calculated and every other objective is as bad as possible
+	for (ScenarioConstraints constraints : { ScenarioConstraints{ .max_capex = capex - 1.0f }, ScenarioConstraints{ .min_capex = capex + 1.0f } }) {
+		auto violating = simulator.simulateScenario(task, SimulationType::FullReporting, constraints);
+		EXPECT_TRUE(violating.violates_constraints);
+		EXPECT_EQ(violating.metrics.total_capex, capex);
+		EXPECT_EQ(violating.scenario_capex_breakdown.total_capex, capex);
+		EXPECT_EQ(violating.metrics.total_annualised_cost, std::numeric_limits<float>::max());
+		EXPECT_EQ(violating.comparison.cost_balance, std::numeric_limits<float>::lowest());
+		EXPECT_FALSE(violating.report_data.has_value());
+	}
+
+	std::vector<TaskData> batch = { task, readTaskData(fs::path{ "./test_files/taskData_empty.json" }) };
+	auto results = simulator.simulateBatch(batch, SimulationType::ResultOnly, ScenarioConstraints{ .max_capex = capex - 1.0f });
+	ASSERT_EQ(results.size(), 2u);
+	EXPECT_TRUE(results[0].violates_constraints);
+	EXPECT_FALSE(results[1].violates_constraints);
+}
+
+TEST_F(EpochSimulationRun, ShortfallConstraintsStopEarly) {
+	TaskData task = readTaskData(fs::path{ "./test_files/taskData_common.json" });
+	ASSERT_TRUE(task.energy_storage_system.has_value());
+	// a grid connection too small for the site, and nothing to meet the heat demand
+	task.grid->grid_import = 20.0f;
+	task.gas_heater.reset();
+	task.heat_pump.reset();
+
+	const auto full = simulator.simulateScenario(task);
+	const float importShortfall = full.metrics.total_electrical_shortfall;
+	const float heatShortfall = full.metrics.total_heat_shortfall;
+	ASSERT_GT(importShortfall, 0.0f);
+	ASSERT_GT(heatShortfall, 0.0f);
+
+	// within the limits, the scenario is simulated in full with the same result
+	ScenarioConstraints within;
+	within.max_electrical_shortfall = importShortfall * 1.01f;
+	within.max_heat_shortfall = heatShortfall * 1.01f;
+	const auto simulated = simulator.simulateScenario(task, SimulationType::ResultOnly, within);
+	EXPECT_FALSE(simulated.violates_constraints);
+	EXPECT_FALSE(simulated.terminated_early);
+	EXPECT_EQ(simulated.metrics.total_electrical_shortfall, importShortfall);
+	EXPECT_EQ(simulated.metrics.total_annualised_cost, full.metrics.total_annualised_cost);
+	EXPECT_EQ(simulated.comparison.cost_balance, full.comparison.cost_balance);
+
+	// part way through the balancing loop, the import shortfall so far is over the limit
+	ScenarioConstraints importLimit;
+	importLimit.max_electrical_shortfall = importShortfall * 0.5f;
+	const auto stopped = simulator.simulateScenario(task, SimulationType::ResultOnly, importLimit);
+	EXPECT_TRUE(stopped.violates_constraints);
+	EXPECT_TRUE(stopped.terminated_early);
+	EXPECT_GT(stopped.metrics.total_electrical_shortfall, *importLimit.max_electrical_shortfall);
+	EXPECT_LE(stopped.metrics.total_electrical_shortfall, importShortfall * 1.0001f);
+	EXPECT_EQ(stopped.metrics.total_capex, full.metrics.total_capex);
+	EXPECT_EQ(stopped.metrics.total_annualised_cost, std::numeric_limits<float>::max());
+
+	// nothing else meets the heat demand, so the heat shortfall is known before the balancing loop
+	ScenarioConstraints heatLimit;
+	heatLimit.max_heat_shortfall = heatShortfall * 0.99f;
+	const auto rejected = simulator.simulateScenario(task, SimulationType::ResultOnly, heatLimit);
+	EXPECT_TRUE(rejected.terminated_early);
+	EXPECT_NEAR(rejected.metrics.total_heat_shortfall, heatShortfall, heatShortfall * 1e-4f);
+
+	// in a batch, only the scenarios over the limit are stopped
+	TaskData connected = task;
+	connected.grid->grid_import = 10000.0f;
+	const std::vector<TaskData> batch = { task, connected };
+	const auto results = simulator.simulateBatch(batch, SimulationType::ResultOnly, importLimit);
+	ASSERT_EQ(results.size(), 2u);
+	EXPECT_TRUE(results[0].terminated_early);
+	EXPECT_FALSE(results[1].terminated_early);
+	EXPECT_EQ(results[1].metrics.total_annualised_cost, simulator.simulateScenario(connected).metrics.total_annualised_cost);
+}
+
+TEST_F(EpochSimulationRun, ShortfallBoundAllowsForAHotroomHeatpump) {
+	// the data centre's heatpump meets hot water in the balancing loop that would otherwise be met from the grid
+	TaskData task = readTaskData(fs::path{ "./test_files/taskData_full.json" });
+	ASSERT_TRUE(task.data_centre.has_value());
+	ASSERT_TRUE(task.domestic_hot_water.has_value());
+	task.heat_pump->heat_source = HeatSource::HOTROOM;
+	task.gas_heater.reset();
+	task.grid->grid_import = 20.0f;
+
+	const auto full = simulator.simulateScenario(task);
+	const float importShortfall = full.metrics.total_electrical_shortfall;
+	ASSERT_GT(importShortfall, 0.0f);
+
+	ScenarioConstraints limit;
+	limit.max_electrical_shortfall = importShortfall * 1.001f;
+	const auto simulated = simulator.simulateScenario(task, SimulationType::ResultOnly, limit);
+	EXPECT_FALSE(simulated.terminated_early);
+	EXPECT_EQ(simulated.metrics.total_electrical_shortfall, importShortfall);
+}
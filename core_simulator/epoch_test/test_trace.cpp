@@ -0,0 +1,149 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "../epoch_lib/Simulation/Simulate.hpp"
+#include "../epoch_lib/Simulation/Trace.hpp"
+#include "../epoch_lib/io/FileHandling.hpp"
+
+namespace fs = std::filesystem;
+
+namespace {
+	size_t countEvents(const std::vector<TraceThread>& threads) {
+		size_t count = 0;
+		for (const auto& thread : threads) {
+			count += thread.events.size();
+		}
+		return count;
+	}
+}
+
+class TraceTest : public ::testing::Test {
+protected:
+	void SetUp() override {
+		if constexpr (!TRACING_ENABLED) {
+			GTEST_SKIP() << "EPOCH_TRACING is off";
+		}
+	}
+
+	void TearDown() override {
+		Tracer::stop();
+	}
+};
+
+TEST_F(TraceTest, RecordsNothingWhileStopped) {
+	Tracer::start();
+	Tracer::stop();
+	{
+		TraceScope trace{ "ignored", "test" };
+	}
+	EXPECT_EQ(countEvents(Tracer::collect()), 0u);
+}
+
+TEST_F(TraceTest, RecordsEachThreadSeparately) {
+	Tracer::start();
+	std::vector<std::thread> threads;
+	for (int i = 0; i < 3; i++) {
+		threads.emplace_back([] {
+			TraceScope outer{ "outer", "test" };
+			TraceScope inner{ "inner", "test" };
+		});
+	}
+	for (auto& thread : threads) {
+		thread.join();
+	}
+	Tracer::stop();
+
+	// the events of a thread are kept after it has finished
+	const auto recorded = Tracer::collect();
+	ASSERT_EQ(recorded.size(), 3u);
+	std::set<uint32_t> ids;
+	for (const auto& thread : recorded) {
+		ids.insert(thread.thread_id);
+		ASSERT_EQ(thread.events.size(), 2u);
+		// the inner scope finishes (and so is recorded) first
+		EXPECT_STREQ(thread.events[0].name, "inner");
+		EXPECT_STREQ(thread.events[1].name, "outer");
+		EXPECT_GE(thread.events[0].start_ns, thread.events[1].start_ns);
+		EXPECT_LE(thread.events[0].duration_ns, thread.events[1].duration_ns);
+	}
+	EXPECT_EQ(ids.size(), 3u);
+}
+
+TEST_F(TraceTest, KeepsTheMostRecentEventsWhenFull) {
+	Tracer::start(4);
+	for (int i = 0; i < 10; i++) {
+		const std::string detail = std::to_string(i);
+		TraceScope trace{ "event", "test", detail };
+	}
+	Tracer::stop();
+
+	const auto recorded = Tracer::collect();
+	ASSERT_EQ(recorded.size(), 1u);
+	EXPECT_EQ(recorded[0].dropped, 6u);
+	ASSERT_EQ(recorded[0].events.size(), 4u);
+	for (size_t i = 0; i < 4; i++) {
+		EXPECT_EQ(std::string(recorded[0].events[i].detail.data()), std::to_string(i + 6));
+	}
+}
+
+TEST_F(TraceTest, StartingAgainDiscardsTheEarlierEvents) {
+	Tracer::start();
+	{
+		TraceScope trace{ "first", "test" };
+	}
+	Tracer::start();
+	{
+		TraceScope trace{ "second", "test" };
+	}
+	Tracer::stop();
+
+	const auto recorded = Tracer::collect();
+	ASSERT_EQ(countEvents(recorded), 1u);
+	EXPECT_STREQ(recorded[0].events[0].name, "second");
+}
+
+TEST_F(TraceTest, TruncatesLongDetails) {
+	Tracer::start();
+	const std::string detail(100, 'x');
+	{
+		TraceScope trace{ "event", "test", detail };
+	}
+	Tracer::stop();
+
+	const auto recorded = Tracer::collect();
+	ASSERT_EQ(countEvents(recorded), 1u);
+	EXPECT_EQ(std::string(recorded[0].events[0].detail.data()), detail.substr(0, recorded[0].events[0].detail.size() - 1));
+}
+
+TEST_F(TraceTest, WritesTheSimulationPhasesAsAChromeTrace) {
+	Simulator simulator(readSiteData(fs::path{ "./test_files/siteData_MountHotel.json" }), TaskConfig{});
+	const TaskData taskData = readTaskData(fs::path{ "./test_files/taskData_full.json" });
+	simulator.getBaseline();
+
+	Tracer::start();
+	simulator.simulateScenario(taskData);
+	Tracer::stop();
+
+	const auto trace = nlohmann::json::parse(Tracer::chromeTrace());
+	std::set<std::string> names;
+	for (const auto& event : trace.at("traceEvents")) {
+		if (event.at("ph") == "X") {
+			names.insert(event.at("name").get<std::string>());
+			EXPECT_GE(event.at("dur").get<double>(), 0.0);
+			EXPECT_TRUE(event.contains("tid"));
+		}
+	}
+	for (const char* phase : { "simulateScenario", "prepare_balancing", "balancing_loop", "finish_timesteps", "costs" }) {
+		EXPECT_TRUE(names.contains(phase)) << phase;
+	}
+	// the baseline was simulated before tracing started
+	EXPECT_FALSE(names.contains("simulateBaseline"));
+	EXPECT_EQ(trace.at("otherData").at("dropped_events"), 0);
+}
@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../epoch_lib/Simulation/Simulate.hpp"
+#include "../epoch_lib/Simulation/UpgradeTree.hpp"
+#include "../epoch_lib/io/FileHandling.hpp"
+
+namespace fs = std::filesystem;
+
+class UpgradeTreeTest : public ::testing::Test {
+protected:
+	Simulator simulator;
+	TaskData end;
+	TaskData start;
+
+	UpgradeTreeTest() :
+		simulator(readSiteData(fs::path{ "./test_files/siteData_MountHotel.json" }), TaskConfig{}),
+		end(readTaskData(fs::path{ "./test_files/taskData_full.json" }))
+	{
+		start = end;
+		start.energy_storage_system.reset();
+		start.heat_pump.reset();
+		start.solar_panels.clear();
+	}
+};
+
+TEST_F(UpgradeTreeTest, FindsTheDifferingComponents) {
+	EXPECT_EQ(differingComponents(start, end), (std::vector<std::string>{ "energy_storage_system", "heat_pump", "solar_panels" }));
+	EXPECT_TRUE(differingComponents(end, end).empty());
+
+	// removing the gas heater is part of installing the heat pump
+	TaskData electrified = end;
+	electrified.gas_heater.reset();
+	EXPECT_EQ(differingComponents(start, electrified), differingComponents(start, end));
+
+	TaskData noGas = start;
+	noGas.gas_heater.reset();
+	EXPECT_EQ(differingComponents(start, noGas), (std::vector<std::string>{ "gas_heater" }));
+}
+
+TEST_F(UpgradeTreeTest, SimulatesEveryCombination) {
+	const auto components = differingComponents(start, end);
+	const auto upgrades = componentUpgrades(end, components);
+	UpgradeTreeResult tree = simulator.simulateUpgradeTree(start, upgrades);
+
+	EXPECT_EQ(tree.upgrades, components);
+	ASSERT_EQ(tree.nodes.size(), 8u);
+	EXPECT_TRUE(tree.nodes.contains("000"));
+	EXPECT_TRUE(tree.nodes.contains("111"));
+
+	for (size_t mask = 0; mask < 8; mask++) {
+		const std::string name = upgradeNodeName(mask, 3);
+		SCOPED_TRACE(name);
+		TaskData scenario = start;
+		for (size_t i = 0; i < 3; i++) {
+			if (name[i] == '1') {
+				upgrades[i].apply(scenario);
+			}
+		}
+		const SimulationResult expected = simulator.simulateScenario(scenario);
+		const SimulationResult& node = tree.nodes.at(name);
+		EXPECT_EQ(node.metrics.total_capex, expected.metrics.total_capex);
+		EXPECT_EQ(node.metrics.total_annualised_cost, expected.metrics.total_annualised_cost);
+		EXPECT_EQ(node.comparison.cost_balance, expected.comparison.cost_balance);
+		EXPECT_EQ(node.comparison.combined_carbon_balance, expected.comparison.combined_carbon_balance);
+	}
+
+	EXPECT_EQ(upgradeNodeName(1, 3), "100");
+	// each node that adds the ESS starts from the state of its parent without it
+	EXPECT_EQ(tree.reused_pre_balancing, 4u);
+}
+
+TEST_F(UpgradeTreeTest, InstallingAHeatPumpRemovesTheGasHeater) {
+	TaskData electrified = end;
+	electrified.gas_heater.reset();
+	const std::vector<std::string> heatPump = { "heat_pump" };
+	const auto upgrades = componentUpgrades(electrified, heatPump);
+
+	TaskData scenario = start;
+	upgrades[0].apply(scenario);
+	EXPECT_TRUE(scenario.heat_pump.has_value());
+	EXPECT_FALSE(scenario.gas_heater.has_value());
+
+	// the gas heater is kept when the end has one
+	scenario = start;
+	componentUpgrades(end, heatPump)[0].apply(scenario);
+	EXPECT_TRUE(scenario.gas_heater.has_value());
+}
+
+TEST_F(UpgradeTreeTest, InvalidUpgrades) {
+	const std::vector<std::string> unknown = { "wind_turbine" };
+	EXPECT_THROW(componentUpgrades(end, unknown), std::runtime_error);
+
+	std::vector<Upgrade> tooMany(MAX_UPGRADES + 1, Upgrade{ "nothing", [](TaskData&) {} });
+	EXPECT_THROW(simulator.simulateUpgradeTree(start, tooMany), std::runtime_error);
+
+	// a tree without upgrades is just the base
+	EXPECT_EQ(simulator.simulateUpgradeTree(start, {}).nodes.size(), 1u);
+}
@@ -0,0 +1,174 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../epoch_lib/Simulation/Simulate.hpp"
+#include "../epoch_lib/Simulation/ThreadPool.hpp"
+#include "../epoch_lib/io/FileHandling.hpp"
+#include "../epoch_lib/io/SimulatorSnapshot.hpp"
+#include "../epoch_lib/io/TaskStream.hpp"
+#include "../epoch_lib/io/WorkerProtocol.hpp"
+
+namespace fs = std::filesystem;
+
+namespace {
+	const std::string SITE_RANGE = R"({
+		"grid": {
+			"COMPONENT_IS_MANDATORY": true,
+			"grid_import": [60.0, 100.0],
+			"grid_export": [100.0],
+			"tariff_index": [0],
+			"incumbent": true,
+			"age": 0,
+			"lifetime": 25
+		},
+		"building": {
+			"COMPONENT_IS_MANDATORY": true,
+			"scalar_heat_load": [1.0],
+			"fabric_intervention_index": [0],
+			"incumbent": true,
+			"age": 0,
+			"lifetime": 30
+		},
+		"energy_storage_system": {
+			"COMPONENT_IS_MANDATORY": false,
+			"capacity": [100.0, 200.0],
+			"battery_mode": ["CONSUME"],
+			"incumbent": false,
+			"age": 0,
+			"lifetime": 15
+		}
+	})";
+
+	std::map<uint64_t, WorkerResponse> readReplies(const std::string& output) {
+		std::istringstream in(output);
+		std::map<uint64_t, WorkerResponse> replies;
+		while (auto frame = readFrame(in)) {
+			WorkerResponse response = decodeResponse(std::as_bytes(std::span<const char>(frame->data(), frame->size())));
+			replies.emplace(response.request_id, std::move(response));
+		}
+		return replies;
+	}
+}
+
+class WorkerProtocolTest : public ::testing::Test {
+protected:
+	std::shared_ptr<const Simulator> simulator;
+	ThreadPool pool{ 3 };
+	std::vector<TaskData> tasks;
+
+	WorkerProtocolTest() :
+		simulator(std::make_shared<const Simulator>(readSiteData(fs::path{ "./test_files/siteData_MountHotel.json" }), TaskConfig{}))
+	{
+		for (int i = 0; i < 2; i++) {
+			tasks.push_back(readTaskData(fs::path{ "./test_files/taskData_empty.json" }));
+			tasks.push_back(readTaskData(fs::path{ "./test_files/taskData_common.json" }));
+			tasks.push_back(readTaskData(fs::path{ "./test_files/taskData_full.json" }));
+		}
+	}
+
+	std::string serve(const std::string& input, std::map<std::string, std::shared_ptr<const Simulator>> simulators = {},
+		WorkerOptions options = {}) {
+		std::istringstream in(input);
+		std::ostringstream out;
+		serveWorker(std::move(simulators), in, out, pool, options);
+		return std::move(out).str();
+	}
+};
+
+TEST_F(WorkerProtocolTest, PipelinedBatchesMatchTheSimulator) {
+	const std::string input = encodeTasksRequest(1, "hotel", tasks)
+		+ encodeTasksRequest(2, "hotel", std::span<const TaskData>(tasks).subspan(2))
+		+ encodeTasksRequest(3, "hotel", tasks);
+
+	// one batch in flight at a time still serves every request
+	for (size_t maxInFlight : { 1, 0 }) {
+		const auto replies = readReplies(serve(input, { {"hotel", simulator} }, WorkerOptions{ maxInFlight }));
+		ASSERT_EQ(replies.size(), 3);
+
+		const WorkerResponse& second = replies.at(2);
+		EXPECT_EQ(second.type, WorkerMessageType::Results);
+		ASSERT_EQ(second.results.size(), tasks.size() - 2);
+		for (size_t i = 0; i < second.results.size(); i++) {
+			const SimulationResult expected = simulator->simulateScenario(tasks[i + 2]);
+			EXPECT_EQ(second.results[i].metrics.total_annualised_cost, expected.metrics.total_annualised_cost);
+			EXPECT_EQ(second.results[i].comparison.cost_balance, expected.comparison.cost_balance);
+		}
+		EXPECT_EQ(replies.at(3).results.size(), tasks.size());
+	}
+}
+
+TEST_F(WorkerProtocolTest, LoadsASnapshotAndDecodesChromosomes) {
+	const std::vector<std::byte> snapshot = snapshotSimulator(*simulator);
+
+	Chromosomes chromosomes(3, 3);
+	chromosomes << 0, 0, 0,
+		1, 1, 0,
+		1, 1, 1;
+	const std::string input = encodeLoadRequest(7, "hotel", snapshot, SITE_RANGE)
+		+ encodeChromosomesRequest(8, "hotel", chromosomes, SimulationType::FullReporting);
+
+	const auto replies = readReplies(serve(input));
+	ASSERT_EQ(replies.size(), 2);
+	EXPECT_EQ(replies.at(7).type, WorkerMessageType::Loaded);
+
+	const WorkerResponse& results = replies.at(8);
+	ASSERT_EQ(results.type, WorkerMessageType::Results) << results.error;
+	ASSERT_EQ(results.results.size(), 3);
+
+	const std::vector<TaskData> decoded = ScenarioCodec(SITE_RANGE).decode(chromosomes);
+	for (size_t i = 0; i < decoded.size(); i++) {
+		const SimulationResult expected = simulator->simulateScenario(decoded[i], SimulationType::FullReporting);
+		EXPECT_EQ(results.results[i].metrics.total_capex, expected.metrics.total_capex);
+		EXPECT_EQ(results.results[i].comparison.cost_balance, expected.comparison.cost_balance);
+		ASSERT_TRUE(results.results[i].report_data.has_value());
+		EXPECT_EQ(results.results[i].report_data->populatedColumns(), expected.report_data->populatedColumns());
+	}
+}
+
+TEST_F(WorkerProtocolTest, TaskRecordsMatchJsonTasks) {
+	const std::string input = encodeTasksRequest(1, "hotel", tasks) + encodeTaskRecordsRequest(2, "hotel", tasks);
+
+	const auto replies = readReplies(serve(input, { {"hotel", simulator} }));
+	ASSERT_EQ(replies.size(), 2);
+	const WorkerResponse& fromJson = replies.at(1);
+	const WorkerResponse& fromRecords = replies.at(2);
+	ASSERT_EQ(fromRecords.type, WorkerMessageType::Results) << fromRecords.error;
+	ASSERT_EQ(fromRecords.results.size(), tasks.size());
+	for (size_t i = 0; i < tasks.size(); i++) {
+		EXPECT_EQ(fromRecords.results[i].metrics.total_annualised_cost, fromJson.results[i].metrics.total_annualised_cost);
+		EXPECT_EQ(fromRecords.results[i].comparison.cost_balance, fromJson.results[i].comparison.cost_balance);
+	}
+}
+
+TEST_F(WorkerProtocolTest, BadRequestsReplyWithAnErrorAndCarryOn) {
+	Chromosomes chromosomes = Chromosomes::Zero(1, 3);
+	const std::string input = encodeTasksRequest(1, "unknown", tasks)
+		+ encodeChromosomesRequest(2, "hotel", chromosomes)
+		+ encodeTasksRequest(3, "hotel", std::span<const TaskData>(tasks).first(1));
+
+	const auto replies = readReplies(serve(input, { {"hotel", simulator} }));
+	ASSERT_EQ(replies.size(), 3);
+	EXPECT_EQ(replies.at(1).type, WorkerMessageType::Error);
+	EXPECT_NE(replies.at(1).error.find("unknown"), std::string::npos);
+	// the site was not loaded with a site range
+	EXPECT_EQ(replies.at(2).type, WorkerMessageType::Error);
+	EXPECT_EQ(replies.at(3).type, WorkerMessageType::Results);
+	EXPECT_EQ(replies.at(3).results.size(), 1);
+}
+
+TEST_F(WorkerProtocolTest, TruncatedInputIsReportedAfterTheReplies) {
+	std::string input = encodeTasksRequest(1, "hotel", tasks);
+	input += encodeTasksRequest(2, "hotel", tasks).substr(0, 10);
+
+	std::istringstream in(input);
+	std::ostringstream out;
+	EXPECT_THROW(serveWorker({ {"hotel", simulator} }, in, out, pool), std::runtime_error);
+	EXPECT_EQ(readReplies(out.str()).at(1).results.size(), tasks.size());
+}
@@ -160,6 +160,8 @@ class ElectricVehicles(BaseModel):
 class BatteryMode(str, Enum):
     CONSUME = 'CONSUME'
     CONSUME_PLUS = 'CONSUME_PLUS'
+    PRICE_LOOKAHEAD = 'PRICE_LOOKAHEAD'
+    CARBON_LOOKAHEAD = 'CARBON_LOOKAHEAD'
 
 
 class EnergyStorageSystem(BaseModel):
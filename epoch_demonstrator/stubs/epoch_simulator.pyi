@@ -6,6 +6,7 @@ to identify the types involve, so we write them out manually here.
 You can't import this file, but it's useful for static analysis.
 """
 
+import asyncio
 from enum import Enum
 
 import numpy as np
@@ -113,6 +114,7 @@ class ReportData:
     _TempSum_elec_e: npt.NDArray[np.floating]
     _TempSum_heat_h: npt.NDArray[np.floating]
     _TempSum_DHW_load_h: npt.NDArray[np.floating]
+    def to_array(self) -> tuple[npt.NDArray[np.floating], list[str]]: ...
 
 class SimulationResult:
     comparison: ScenarioComparison
@@ -164,6 +166,8 @@ class ElectricVehicles:
 class BatteryMode(Enum):
     CONSUME = "CONSUME"
     CONSUME_PLUS = "CONSUME_PLUS"
+    PRICE_LOOKAHEAD = "PRICE_LOOKAHEAD"
+    CARBON_LOOKAHEAD = "CARBON_LOOKAHEAD"
 
 class EnergyStorageSystem:
     capacity: float
@@ -264,12 +268,53 @@ class CapexBreakdown:
     general_grant_funding: float
     total_capex: float
 
+class ScenarioConstraints:
+    min_capex: float | None
+    max_capex: float | None
+    max_electrical_shortfall: float | None
+    max_heat_shortfall: float | None
+    def __init__(
+        self,
+        *,
+        min_capex: float | None = None,
+        max_capex: float | None = None,
+        max_electrical_shortfall: float | None = None,
+        max_heat_shortfall: float | None = None,
+    ) -> None: ...
+
+class BatchControl:
+    cancelled: bool
+    stop_requested: bool
+    total: int
+    completed: int
+    skipped: int
+    def __init__(self) -> None: ...
+    def cancel(self) -> None: ...
+    def set_timeout(self, seconds: float) -> None: ...
+
 class Simulator:
     @staticmethod
     def from_json(site_data_json_str: str, config_json_str: str) -> Simulator: ...
     @staticmethod
     def from_file(site_data_filepath: str, config_filepath: str) -> Simulator: ...
     def simulate_scenario(self, taskData: TaskData, fullReporting: bool = False) -> SimulationResult: ...
+    def simulate_upgrade_tree(
+        self, start: TaskData, end: TaskData, components: list[str] | None = None
+    ) -> dict[str, SimulationResult]: ...
+    def simulate_scenario_async(
+        self,
+        taskData: TaskData,
+        fullReporting: bool = False,
+        constraints: ScenarioConstraints | None = None,
+        columns: list[str] | None = None,
+    ) -> asyncio.Future[SimulationResult]: ...
+    def simulate_batch_async(
+        self,
+        taskData: list[TaskData],
+        fullReporting: bool = False,
+        constraints: ScenarioConstraints | None = None,
+        control: BatchControl | None = None,
+    ) -> asyncio.Future[list[SimulationResult]]: ...
     def is_valid(self, taskData: TaskData) -> bool: ...
     def calculate_capex(self, taskData: TaskData) -> CapexBreakdown: ...
 
@@ -4,7 +4,6 @@ Generate all possible combinations of assets to create an upgrade tree.
 This includes functions to check for what the combinations should be.
 """
 
-import itertools
 import logging
 
 import epoch_simulator as eps
@@ -122,19 +121,11 @@ def generate_upgrade_tree(
     if num_differences > 8:
         logger.warning(f"Many differences in this site: expecting {2**num_differences} combinations, which will be slow.")
 
-    all_results = {}
-    for combination in itertools.product([False, True], repeat=num_differences):
-        included = [key for key, c in zip(keys, combination, strict=False) if c]
-        curr_td = start.model_copy(deep=True)
-        for key in included:
-            curr_td.__setattr__(key, getattr(end, key))
-            # If we're installing a heat pump and know there's no gas heater at the end,
-            # remove it during this step.
-            if key == "heat_pump" and end.gas_heater is None:
-                curr_td.gas_heater = None
-        # Use these pithy names as they're easier to scan over when looking at the dict
-        # and can be nicely re-labelled
-        node_name = "".join(str(int(c)) for c in combination)
-        res = sim.simulate_scenario(taskData=EpochTaskData.from_json(curr_td.model_dump_json()))
-        all_results[node_name] = res
-    return all_results
+    # The simulator builds each combination of the upgrades in `keys` (installing a heat pump also removes the gas heater
+    # if there's none at the end), and names the nodes with pithy bitstrings that are easy to scan over and re-label.
+    # Siblings are simulated in parallel, reusing their parent's state where an upgrade doesn't change it.
+    return sim.simulate_upgrade_tree(
+        start=EpochTaskData.from_json(start.model_dump_json()),
+        end=EpochTaskData.from_json(end.model_dump_json()),
+        components=keys,
+    )
@@ -13,6 +13,8 @@ from ..epl_typing import Jsonable
 class BatteryModeEnum(str, Enum):
     CONSUME = 'CONSUME'
     CONSUME_PLUS = 'CONSUME_PLUS'
+    PRICE_LOOKAHEAD = 'PRICE_LOOKAHEAD'
+    CARBON_LOOKAHEAD = 'CARBON_LOOKAHEAD'
 
 
 class GasTypeEnum(str, Enum):
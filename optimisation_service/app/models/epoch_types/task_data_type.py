@@ -159,6 +159,8 @@ class ElectricVehicles(BaseModel):
 class BatteryMode(str, Enum):
     CONSUME = 'CONSUME'
     CONSUME_PLUS = 'CONSUME_PLUS'
+    PRICE_LOOKAHEAD = 'PRICE_LOOKAHEAD'
+    CARBON_LOOKAHEAD = 'CARBON_LOOKAHEAD'
 
 
 class EnergyStorageSystem(BaseModel):